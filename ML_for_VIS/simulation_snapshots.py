@@ -0,0 +1,27 @@
+# load the snapshots recorded by the simulation (SnapshotWriter in scivis_toolkit_framework) as memory-mapped arrays
+# each chunk holds frames of shape (3, DIMY, DIMX): rho, vx and vy
+
+import glob
+import os
+import sys
+import numpy as np
+
+def loadSnapshots(dirName):
+    # Returns a list of (fields, steps) per chunk. Chunks differ in shape when the grid size changed while recording,
+    # so they are not concatenated; np.concatenate copies them into memory when they do not.
+    chunks = list()
+    for fileName in sorted(glob.glob(os.path.join(dirName, 'snapshots_[0-9][0-9][0-9][0-9][0-9][0-9].npy'))):
+        fields = np.load(fileName, mmap_mode='r')
+        steps = np.load(fileName[:-len('.npy')] + '_steps.npy', mmap_mode='r')
+        chunks.append((fields, steps))
+
+    return chunks
+
+def main():
+    dirName = sys.argv[1] if len(sys.argv) > 1 else '.'
+    for fields, steps in loadSnapshots(dirName):
+        if len(steps) > 0:
+            print(fields.shape, fields.dtype, 'steps', steps[0], 'to', steps[-1])
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,243 @@
+#include "advection.h"
+
+#include <array>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Faster than std::floor, and exact for the magnitudes that occur on the grid.
+    inline int floorToInt(float const value)
+    {
+        auto const truncated = static_cast<int>(value);
+        return value < static_cast<float>(truncated) ? truncated - 1 : truncated;
+    }
+
+    // Wraps an index that may lie outside [0, n) back into the grid (n is the width or the height).
+    inline int wrap(int const idx, int const n)
+    {
+        int const wrapped = idx % n;
+        return wrapped < 0 ? wrapped + n : wrapped;
+    }
+
+    template <size_t numberOfFields>
+    using Sources = std::array<float const *, numberOfFields>;
+
+    template <size_t numberOfFields>
+    using Destinations = std::array<float *, numberOfFields>;
+
+    // Scalar version for one cell.
+    template <size_t numberOfFields>
+    inline void advectCell(int const width, int const height, float const dt, float const *u, float const *v,
+                           Sources<numberOfFields> const &sources, Destinations<numberOfFields> const &destinations,
+                           int const i, int const j)
+    {
+        float const x = (0.5F / width) + i * (1.0F / width);
+        float const y = (0.5F / width) + j * (1.0F / width);
+        int const idx = i + width * j;
+
+        float const x0 = width * (x - dt * u[idx]) - 0.5F;
+        float const y0 = width * (y - dt * v[idx]) - 0.5F;
+
+        int i0 = floorToInt(x0);
+        int j0 = floorToInt(y0);
+        float const s = x0 - static_cast<float>(i0);
+        float const t = y0 - static_cast<float>(j0);
+
+        int i1 = i0 + 1;
+        int j1 = j0 + 1;
+
+        // Boundary path: the stencil crosses the edge of the periodic grid.
+        if (i0 < 0 || i1 >= width || j0 < 0 || j1 >= height)
+        {
+            i0 = wrap(i0, width);
+            j0 = wrap(j0, height);
+            i1 = i0 + 1 == width ? 0 : i0 + 1;
+            j1 = j0 + 1 == height ? 0 : j0 + 1;
+        }
+
+        int const idx00 = i0 + width * j0;
+        int const idx01 = i0 + width * j1;
+        int const idx10 = i1 + width * j0;
+        int const idx11 = i1 + width * j1;
+
+        for (size_t field = 0U; field < numberOfFields; ++field)
+        {
+            float const * const source = sources[field];
+            destinations[field][idx] = (1 - s) * ((1 - t) * source[idx00] + t * source[idx01])
+                                     + s * ((1 - t) * source[idx10] + t * source[idx11]);
+        }
+    }
+
+#if defined(__AVX2__)
+    constexpr int s_vectorWidth = 8;
+
+    // Advects the 8 cells starting at (i, j). Returns false, without writing anything,
+    // if any of the stencils crosses the grid edge; those cells have to take the scalar path.
+    template <size_t numberOfFields>
+    inline bool advectVector(int const width, int const height, float const dt, float const *u, float const *v,
+                             Sources<numberOfFields> const &sources, Destinations<numberOfFields> const &destinations,
+                             int const i, int const j)
+    {
+        int const idx = i + width * j;
+        __m256 const nf = _mm256_set1_ps(static_cast<float>(width));
+        __m256 const dtv = _mm256_set1_ps(dt);
+        __m256 const half = _mm256_set1_ps(0.5F);
+        __m256 const one = _mm256_set1_ps(1.0F);
+
+        __m256 const columns = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i),
+                                                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        __m256 const x = _mm256_add_ps(_mm256_set1_ps(0.5F / width), _mm256_mul_ps(columns, _mm256_set1_ps(1.0F / width)));
+        __m256 const y = _mm256_set1_ps((0.5F / width) + j * (1.0F / width));
+
+        __m256 const x0 = _mm256_sub_ps(_mm256_mul_ps(nf, _mm256_sub_ps(x, _mm256_mul_ps(dtv, _mm256_loadu_ps(u + idx)))), half);
+        __m256 const y0 = _mm256_sub_ps(_mm256_mul_ps(nf, _mm256_sub_ps(y, _mm256_mul_ps(dtv, _mm256_loadu_ps(v + idx)))), half);
+
+        __m256 const floorX0 = _mm256_floor_ps(x0);
+        __m256 const floorY0 = _mm256_floor_ps(y0);
+
+        // Interior test in floating point, which also rejects values too large for an int.
+        __m256 const lowest = _mm256_setzero_ps();
+        __m256 const highestX = _mm256_set1_ps(static_cast<float>(width - 2));
+        __m256 const highestY = _mm256_set1_ps(static_cast<float>(height - 2));
+        __m256 const inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(floorX0, lowest, _CMP_GE_OQ), _mm256_cmp_ps(floorX0, highestX, _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(floorY0, lowest, _CMP_GE_OQ), _mm256_cmp_ps(floorY0, highestY, _CMP_LE_OQ)));
+        if (_mm256_movemask_ps(inside) != 0xFF)
+            return false;
+
+        __m256 const s = _mm256_sub_ps(x0, floorX0);
+        __m256 const t = _mm256_sub_ps(y0, floorY0);
+        __m256 const oneMinusS = _mm256_sub_ps(one, s);
+        __m256 const oneMinusT = _mm256_sub_ps(one, t);
+
+        __m256i const idx00 = _mm256_add_epi32(_mm256_cvttps_epi32(floorX0),
+                                               _mm256_mullo_epi32(_mm256_cvttps_epi32(floorY0), _mm256_set1_epi32(width)));
+        __m256i const idx01 = _mm256_add_epi32(idx00, _mm256_set1_epi32(width));
+        __m256i const idx10 = _mm256_add_epi32(idx00, _mm256_set1_epi32(1));
+        __m256i const idx11 = _mm256_add_epi32(idx01, _mm256_set1_epi32(1));
+
+        for (size_t field = 0U; field < numberOfFields; ++field)
+        {
+            float const * const source = sources[field];
+            __m256 const a = _mm256_i32gather_ps(source, idx00, 4);
+            __m256 const b = _mm256_i32gather_ps(source, idx01, 4);
+            __m256 const c = _mm256_i32gather_ps(source, idx10, 4);
+            __m256 const d = _mm256_i32gather_ps(source, idx11, 4);
+
+            __m256 const left = _mm256_add_ps(_mm256_mul_ps(oneMinusT, a), _mm256_mul_ps(t, b));
+            __m256 const right = _mm256_add_ps(_mm256_mul_ps(oneMinusT, c), _mm256_mul_ps(t, d));
+            _mm256_storeu_ps(destinations[field] + idx, _mm256_add_ps(_mm256_mul_ps(oneMinusS, left), _mm256_mul_ps(s, right)));
+        }
+
+        return true;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    constexpr int s_vectorWidth = 4;
+
+    // Advects the 4 cells starting at (i, j). NEON has no gather instruction, so the corner samples are loaded one by one.
+    // Returns false, without writing anything, if any of the stencils crosses the grid edge.
+    template <size_t numberOfFields>
+    inline bool advectVector(int const width, int const height, float const dt, float const *u, float const *v,
+                             Sources<numberOfFields> const &sources, Destinations<numberOfFields> const &destinations,
+                             int const i, int const j)
+    {
+        int const idx = i + width * j;
+        float32x4_t const nf = vdupq_n_f32(static_cast<float>(width));
+        float32x4_t const dtv = vdupq_n_f32(dt);
+        float32x4_t const half = vdupq_n_f32(0.5F);
+        float32x4_t const one = vdupq_n_f32(1.0F);
+
+        float const columnOffsets[4] = {0.0F, 1.0F, 2.0F, 3.0F};
+        float32x4_t const columns = vaddq_f32(vdupq_n_f32(static_cast<float>(i)), vld1q_f32(columnOffsets));
+        float32x4_t const x = vaddq_f32(vdupq_n_f32(0.5F / width), vmulq_f32(columns, vdupq_n_f32(1.0F / width)));
+        float32x4_t const y = vdupq_n_f32((0.5F / width) + j * (1.0F / width));
+
+        float32x4_t const x0 = vsubq_f32(vmulq_f32(nf, vsubq_f32(x, vmulq_f32(dtv, vld1q_f32(u + idx)))), half);
+        float32x4_t const y0 = vsubq_f32(vmulq_f32(nf, vsubq_f32(y, vmulq_f32(dtv, vld1q_f32(v + idx)))), half);
+
+        float32x4_t const floorX0 = vrndmq_f32(x0);
+        float32x4_t const floorY0 = vrndmq_f32(y0);
+
+        float32x4_t const lowest = vdupq_n_f32(0.0F);
+        float32x4_t const highestX = vdupq_n_f32(static_cast<float>(width - 2));
+        float32x4_t const highestY = vdupq_n_f32(static_cast<float>(height - 2));
+        uint32x4_t const inside = vandq_u32(vandq_u32(vcgeq_f32(floorX0, lowest), vcleq_f32(floorX0, highestX)),
+                                            vandq_u32(vcgeq_f32(floorY0, lowest), vcleq_f32(floorY0, highestY)));
+        if (vminvq_u32(inside) == 0U)
+            return false;
+
+        float32x4_t const s = vsubq_f32(x0, floorX0);
+        float32x4_t const t = vsubq_f32(y0, floorY0);
+        float32x4_t const oneMinusS = vsubq_f32(one, s);
+        float32x4_t const oneMinusT = vsubq_f32(one, t);
+
+        int32_t corner[4];
+        vst1q_s32(corner, vmlaq_s32(vcvtq_s32_f32(floorX0), vcvtq_s32_f32(floorY0), vdupq_n_s32(width)));
+
+        for (size_t field = 0U; field < numberOfFields; ++field)
+        {
+            float const * const source = sources[field];
+            float a[4], b[4], c[4], d[4];
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                a[lane] = source[corner[lane]];
+                b[lane] = source[corner[lane] + width];
+                c[lane] = source[corner[lane] + 1];
+                d[lane] = source[corner[lane] + width + 1];
+            }
+
+            float32x4_t const left = vmlaq_f32(vmulq_f32(oneMinusT, vld1q_f32(a)), t, vld1q_f32(b));
+            float32x4_t const right = vmlaq_f32(vmulq_f32(oneMinusT, vld1q_f32(c)), t, vld1q_f32(d));
+            vst1q_f32(destinations[field] + idx, vmlaq_f32(vmulq_f32(oneMinusS, left), s, right));
+        }
+
+        return true;
+    }
+#endif
+
+    template <size_t numberOfFields>
+    void advectRowsImpl(int const width, int const height, float const dt, float const *u, float const *v,
+                        Sources<numberOfFields> const &sources, Destinations<numberOfFields> const &destinations,
+                        int const rowBegin, int const rowEnd)
+    {
+        for (int j = rowBegin; j < rowEnd; ++j)
+        {
+            int i = 0;
+
+#if defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+            for (; i + s_vectorWidth <= width; i += s_vectorWidth)
+            {
+                if (!advectVector<numberOfFields>(width, height, dt, u, v, sources, destinations, i, j))
+                {
+                    for (int k = i; k < i + s_vectorWidth; ++k)
+                        advectCell<numberOfFields>(width, height, dt, u, v, sources, destinations, k, j);
+                }
+            }
+#endif
+
+            // Scalar fallback, and the remainder of the vectorized loop.
+            for (; i < width; ++i)
+                advectCell<numberOfFields>(width, height, dt, u, v, sources, destinations, i, j);
+        }
+    }
+}
+
+void advection::advectRows(int const width, int const height, float const dt, float const *u, float const *v,
+                           float const *source0, float *destination0,
+                           float const *source1, float *destination1,
+                           int const rowBegin, int const rowEnd)
+{
+    advectRowsImpl<2U>(width, height, dt, u, v, {source0, source1}, {destination0, destination1}, rowBegin, rowEnd);
+}
+
+void advection::advectRows(int const width, int const height, float const dt, float const *u, float const *v,
+                           float const *source, float *destination,
+                           int const rowBegin, int const rowEnd)
+{
+    advectRowsImpl<1U>(width, height, dt, u, v, {source}, {destination}, rowBegin, rowEnd);
+}
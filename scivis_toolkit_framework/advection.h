@@ -0,0 +1,26 @@
+#ifndef ADVECTION_H
+#define ADVECTION_H
+
+#include <cstddef>
+
+// Semi-Lagrangian advection on the periodic width x height simulation grid. All fields are row-major: element (i, j) is
+// at i + width * j. The cells are square, with a side of 1 / width in the units of the velocity.
+// Every cell is traced back along the velocity (u, v) over the time step dt, and the source fields are bilinearly
+// interpolated at that position. Only the rows [rowBegin, rowEnd) of the destinations are written, so several threads can
+// each process their own band of rows.
+// Samples whose interpolation stencil lies inside the grid are read directly; only the others wrap around the boundary.
+namespace advection
+{
+    // Advects two fields (e.g. both velocity components) along the same backtraced positions.
+    void advectRows(int const width, int const height, float const dt, float const *u, float const *v,
+                    float const *source0, float *destination0,
+                    float const *source1, float *destination1,
+                    int const rowBegin, int const rowEnd);
+
+    // Advects a single field (e.g. the density).
+    void advectRows(int const width, int const height, float const dt, float const *u, float const *v,
+                    float const *source, float *destination,
+                    int const rowBegin, int const rowEnd);
+}
+
+#endif // ADVECTION_H
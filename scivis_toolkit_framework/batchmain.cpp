@@ -0,0 +1,337 @@
+// Usage: scivis_batch [options]
+//        Runs the simulation headless, as fast as it goes, with the mouse input taken from a force script.
+//        Every --fields-every steps the density and velocity fields are written as raw float32 files, described by one
+//        datraw .dat file per field, so the volume rendering can load a run as a time series. Every --render-every steps
+//        the density is rendered offscreen, with the shaders of the visualization, into a PNG file. Every
+//        --snapshots-every steps the fields are recorded into .npy chunks, see snapshotwriter.h.
+//        Run with --help for the options.
+//--------------------------------------------------------------------------------------------------
+
+#include "batchrenderer.h"
+#include "forcescript.h"
+#include "simulation.h"
+#include "snapshotwriter.h"
+#include "texture.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QGuiApplication>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        size_t DIM = 64U;
+        size_t steps = 1000U;
+        size_t threadCount = 0U; // 0 is one thread per hardware thread.
+        float dt = 0.4F;
+        float viscosity = 0.001F;
+        float rhoInjected = 10.0F;
+        QString scriptFileName;
+
+        QString outputDirectory = QStringLiteral(".");
+        size_t fieldsEvery = 0U; // 0 writes no fields.
+        size_t renderEvery = 0U; // 0 renders nothing.
+        size_t snapshotsEvery = 0U; // 0 records nothing.
+        bool halfPrecisionSnapshots = false;
+        int imageSize = 512;
+        QString colorMap = QStringLiteral("grayscale");
+    };
+
+    // Parses the options before the application exists, since rendering decides which application to create.
+    bool parseOptions(QStringList const &arguments, Options &options)
+    {
+        QCommandLineParser parser;
+        parser.setApplicationDescription(QStringLiteral("Runs the fluid simulation without a window."));
+        parser.addHelpOption();
+
+        QCommandLineOption const dimOption{QStringLiteral("dim"), QStringLiteral("Grid size (default 64)."),
+                                           QStringLiteral("n")};
+        QCommandLineOption const stepsOption{QStringLiteral("steps"), QStringLiteral("Number of steps (default 1000)."),
+                                             QStringLiteral("n")};
+        QCommandLineOption const threadsOption{QStringLiteral("threads"),
+                                               QStringLiteral("Simulation threads, 0 for all (default 0)."),
+                                               QStringLiteral("n")};
+        QCommandLineOption const dtOption{QStringLiteral("dt"), QStringLiteral("Time step (default 0.4)."),
+                                          QStringLiteral("dt")};
+        QCommandLineOption const viscosityOption{QStringLiteral("viscosity"),
+                                                 QStringLiteral("Viscosity (default 0.001)."),
+                                                 QStringLiteral("viscosity")};
+        QCommandLineOption const rhoOption{QStringLiteral("rho"),
+                                           QStringLiteral("Density injected when stirring (default 10)."),
+                                           QStringLiteral("rho")};
+        QCommandLineOption const scriptOption{QStringLiteral("script"),
+                                              QStringLiteral("Force script, see forcescript.h (default: stir)."),
+                                              QStringLiteral("file")};
+        QCommandLineOption const outputOption{QStringLiteral("output"),
+                                              QStringLiteral("Output directory (default .)."),
+                                              QStringLiteral("directory")};
+        QCommandLineOption const fieldsEveryOption{QStringLiteral("fields-every"),
+                                                   QStringLiteral("Write the fields every n steps (default never)."),
+                                                   QStringLiteral("n")};
+        QCommandLineOption const renderEveryOption{QStringLiteral("render-every"),
+                                                   QStringLiteral("Render the density every n steps (default never)."),
+                                                   QStringLiteral("n")};
+        QCommandLineOption const snapshotsEveryOption{QStringLiteral("snapshots-every"),
+                                                      QStringLiteral("Record .npy snapshots every n steps (default "
+                                                                     "never)."),
+                                                      QStringLiteral("n")};
+        QCommandLineOption const halfSnapshotsOption{QStringLiteral("half-snapshots"),
+                                                     QStringLiteral("Record the snapshots as float16.")};
+        QCommandLineOption const imageSizeOption{QStringLiteral("image-size"),
+                                                 QStringLiteral("Width and height of the images (default 512)."),
+                                                 QStringLiteral("pixels")};
+        QCommandLineOption const colorMapOption{QStringLiteral("color-map"),
+                                                QStringLiteral("grayscale, turbo, heat or blueyellow (default "
+                                                               "grayscale)."),
+                                                QStringLiteral("name")};
+        parser.addOptions({dimOption, stepsOption, threadsOption, dtOption, viscosityOption, rhoOption, scriptOption,
+                           outputOption, fieldsEveryOption, renderEveryOption, snapshotsEveryOption,
+                           halfSnapshotsOption, imageSizeOption, colorMapOption});
+
+        // process exits for --help and unknown options.
+        parser.process(arguments);
+
+        bool valid = true;
+        auto const readSize = [&parser, &valid](QCommandLineOption const &option, size_t &value)
+        {
+            if (!parser.isSet(option))
+                return;
+            bool ok = false;
+            value = parser.value(option).toULongLong(&ok);
+            if (!ok)
+            {
+                qCritical().noquote() << "Option" << option.names().constFirst() << "is not a size:"
+                                      << parser.value(option);
+                valid = false;
+            }
+        };
+        auto const readFloat = [&parser, &valid](QCommandLineOption const &option, float &value)
+        {
+            if (!parser.isSet(option))
+                return;
+            bool ok = false;
+            value = parser.value(option).toFloat(&ok);
+            if (!ok)
+            {
+                qCritical().noquote() << "Option" << option.names().constFirst() << "is not a number:"
+                                      << parser.value(option);
+                valid = false;
+            }
+        };
+
+        readSize(dimOption, options.DIM);
+        readSize(stepsOption, options.steps);
+        readSize(threadsOption, options.threadCount);
+        readFloat(dtOption, options.dt);
+        readFloat(viscosityOption, options.viscosity);
+        readFloat(rhoOption, options.rhoInjected);
+        readSize(fieldsEveryOption, options.fieldsEvery);
+        readSize(renderEveryOption, options.renderEvery);
+        readSize(snapshotsEveryOption, options.snapshotsEvery);
+        options.halfPrecisionSnapshots = parser.isSet(halfSnapshotsOption);
+
+        size_t imageSize = static_cast<size_t>(options.imageSize);
+        readSize(imageSizeOption, imageSize);
+        options.imageSize = static_cast<int>(imageSize);
+
+        if (parser.isSet(scriptOption))
+            options.scriptFileName = parser.value(scriptOption);
+        if (parser.isSet(outputOption))
+            options.outputDirectory = parser.value(outputOption);
+        if (parser.isSet(colorMapOption))
+            options.colorMap = parser.value(colorMapOption);
+
+        if (options.DIM < 2U)
+        {
+            qCritical() << "The grid size has to be at least 2";
+            valid = false;
+        }
+        if (options.imageSize < 1)
+        {
+            qCritical() << "The image size has to be at least 1";
+            valid = false;
+        }
+        QStringList const colorMaps{QStringLiteral("grayscale"), QStringLiteral("turbo"), QStringLiteral("heat"),
+                                    QStringLiteral("blueyellow")};
+        if (!colorMaps.contains(options.colorMap))
+        {
+            qCritical().noquote() << "Unknown color map:" << options.colorMap;
+            valid = false;
+        }
+
+        return valid;
+    }
+
+    std::vector<Color> createColorMap(QString const &name)
+    {
+        size_t constexpr numberOfColors = 256U;
+
+        if (name == QStringLiteral("turbo"))
+            return Texture::createTurboTexture(numberOfColors);
+        if (name == QStringLiteral("heat"))
+            return Texture::createHeatTexture(numberOfColors);
+        if (name == QStringLiteral("blueyellow"))
+            return Texture::createBlueYellowTexture(numberOfColors);
+        return Texture::createGrayscaleTexture(numberOfColors);
+    }
+
+    // The name of the output file of a step, e.g. density_000100.raw.
+    QString stepFileName(QString const &field, size_t const step, QString const &extension)
+    {
+        return QStringLiteral("%1_%2.%3").arg(field).arg(step, 6, 10, QLatin1Char('0')).arg(extension);
+    }
+
+    bool writeRaw(QDir const &directory, QString const &fileName, std::vector<float> const &values)
+    {
+        std::ofstream file{directory.filePath(fileName).toStdString(), std::ios::binary};
+        file.write(reinterpret_cast<char const*>(values.data()),
+                   static_cast<std::streamsize>(values.size() * sizeof(float)));
+        if (!file)
+        {
+            qCritical() << "Cannot write" << directory.filePath(fileName);
+            return false;
+        }
+        return true;
+    }
+
+    // Describes the raw files of a field as a time series. Files are written after the steps every, 2 * every, ...,
+    // which is the ObjectFileName pattern %06+<every>*<every>d.
+    bool writeDat(QDir const &directory, QString const &field, Options const &options, size_t const numberOfFiles)
+    {
+        QString const fileName = directory.filePath(field + QStringLiteral(".dat"));
+        std::ofstream file{fileName.toStdString()};
+        file << "ObjectFileName: " << field.toStdString() << "_%06+" << options.fieldsEvery << '*'
+             << options.fieldsEvery << "d.raw\n"
+             << "Dimensions: 2\n"
+             << "Resolution: " << options.DIM << ' ' << options.DIM << '\n'
+             << "Format: FLOAT\n"
+             << "TimeSteps: " << numberOfFiles << '\n';
+        if (!file)
+        {
+            qCritical() << "Cannot write" << fileName;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i)
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+
+    Options options;
+    if (!parseOptions(arguments, options))
+        return 1;
+
+    // Offscreen surfaces need a QGuiApplication; without rendering the batch runner also works without a display.
+    std::unique_ptr<QCoreApplication> const application = options.renderEvery > 0U
+        ? std::make_unique<QGuiApplication>(argc, argv)
+        : std::make_unique<QCoreApplication>(argc, argv);
+
+    ForceScript script;
+    if (!options.scriptFileName.isEmpty() && !script.load(options.scriptFileName))
+        return 1;
+
+    QDir const outputDirectory{options.outputDirectory};
+    if ((options.fieldsEvery > 0U || options.renderEvery > 0U) && !QDir{}.mkpath(options.outputDirectory))
+    {
+        qCritical() << "Cannot create the output directory" << options.outputDirectory;
+        return 1;
+    }
+
+    BatchRenderer renderer;
+    if (options.renderEvery > 0U &&
+        !renderer.create(options.imageSize, options.imageSize, createColorMap(options.colorMap)))
+        return 1;
+
+    // Waits for the disk when it falls behind, so a recording has every snapshot.
+    SnapshotWriter snapshotWriter;
+    if (options.snapshotsEvery > 0U &&
+        !snapshotWriter.open(options.outputDirectory,
+                             options.halfPrecisionSnapshots ? FieldPrecision::Float16 : FieldPrecision::Float32))
+        return 1;
+
+    Simulation simulation{options.DIM};
+    if (options.threadCount > 0U)
+        simulation.setThreadCount(options.threadCount);
+    simulation.setDt(options.dt);
+    simulation.setViscosity(options.viscosity);
+    simulation.setRhoInjected(options.rhoInjected);
+
+    qInfo().noquote() << "Simulating" << options.steps << "steps on a" << options.DIM << "x" << options.DIM << "grid"
+                      << "with" << simulation.threadCount() << "threads,"
+                      << (options.scriptFileName.isEmpty() ? QStringLiteral("stirring")
+                                                           : QStringLiteral("%1 scripted events")
+                                                                 .arg(script.numberOfEvents()));
+
+    // Only the steps are timed, not the output.
+    std::chrono::steady_clock::duration simulationTime{0};
+    size_t numberOfFieldFiles = 0U;
+    for (size_t step = 0U; step < options.steps; ++step)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        script.apply(step, simulation);
+        simulation.doOneSimulationStep();
+        simulationTime += std::chrono::steady_clock::now() - start;
+
+        size_t const completedSteps = step + 1U;
+        if (options.fieldsEvery > 0U && completedSteps % options.fieldsEvery == 0U)
+        {
+            if (!writeRaw(outputDirectory, stepFileName(QStringLiteral("density"), completedSteps, QStringLiteral("raw")),
+                          simulation.density()) ||
+                !writeRaw(outputDirectory, stepFileName(QStringLiteral("velocity_x"), completedSteps,
+                                                        QStringLiteral("raw")), simulation.velocityX()) ||
+                !writeRaw(outputDirectory, stepFileName(QStringLiteral("velocity_y"), completedSteps,
+                                                        QStringLiteral("raw")), simulation.velocityY()))
+                return 1;
+            ++numberOfFieldFiles;
+        }
+
+        if (options.snapshotsEvery > 0U && completedSteps % options.snapshotsEvery == 0U)
+            snapshotWriter.append(simulation, completedSteps);
+
+        if (options.renderEvery > 0U && completedSteps % options.renderEvery == 0U)
+        {
+            std::vector<float> const &density = simulation.density();
+            auto const [minimum, maximum] = std::minmax_element(density.cbegin(), density.cend());
+            QImage const image = renderer.render(density, simulation.DIMX(), simulation.DIMY(),
+                                                 QVector2D{*minimum, *maximum});
+
+            QString const fileName = outputDirectory.filePath(stepFileName(QStringLiteral("density"), completedSteps,
+                                                                           QStringLiteral("png")));
+            if (!image.save(fileName))
+            {
+                qCritical() << "Cannot write" << fileName;
+                return 1;
+            }
+        }
+    }
+
+    if (numberOfFieldFiles > 0U)
+    {
+        for (QString const &field : {QStringLiteral("density"), QStringLiteral("velocity_x"),
+                                     QStringLiteral("velocity_y")})
+            if (!writeDat(outputDirectory, field, options, numberOfFieldFiles))
+                return 1;
+    }
+
+    double const seconds = std::chrono::duration<double>(simulationTime).count();
+    if (options.steps > 0U && seconds > 0.0)
+        qInfo().noquote() << QStringLiteral("%1 steps/s, %2 ms/step")
+                                 .arg(static_cast<double>(options.steps) / seconds, 0, 'f', 1)
+                                 .arg(1000.0 * seconds / static_cast<double>(options.steps), 0, 'f', 3);
+
+    return 0;
+}
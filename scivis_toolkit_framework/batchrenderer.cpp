@@ -0,0 +1,144 @@
+#include "batchrenderer.h"
+
+#include <QDebug>
+#include <QSurfaceFormat>
+
+#include <array>
+
+BatchRenderer::~BatchRenderer()
+{
+    if (!m_context.isValid() || !m_context.makeCurrent(&m_surface))
+        return;
+
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteTextures(1, &m_scalarFieldTexture);
+    glDeleteTextures(1, &m_colorMapTexture);
+    m_framebuffer.reset();
+    m_shaderProgram.removeAllShaders();
+
+    m_context.doneCurrent();
+}
+
+bool BatchRenderer::create(int const imageWidth, int const imageHeight, std::vector<Color> const &colorMap)
+{
+    QSurfaceFormat format;
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setVersion(3, 3);
+
+    m_surface.setFormat(format);
+    m_surface.create();
+    m_context.setFormat(format);
+    if (!m_surface.isValid() || !m_context.create() || !m_context.makeCurrent(&m_surface))
+    {
+        qCritical() << "Cannot create an offscreen OpenGL 3.3 core context";
+        return false;
+    }
+
+    if (!initializeOpenGLFunctions())
+    {
+        qCritical() << "The offscreen context does not provide OpenGL 3.3 core";
+        return false;
+    }
+
+    m_framebuffer = std::make_unique<QOpenGLFramebufferObject>(imageWidth, imageHeight);
+    if (!m_framebuffer->isValid())
+    {
+        qCritical() << "Cannot create a" << imageWidth << "x" << imageHeight << "framebuffer object";
+        return false;
+    }
+
+    if (!m_shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/scalarData_field.vert") ||
+        !m_shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_field.frag") ||
+        !m_shaderProgram.link())
+    {
+        qCritical() << "Cannot build the scalar field shader program:" << m_shaderProgram.log();
+        return false;
+    }
+
+    m_uniformLocation_scalarField = m_shaderProgram.uniformLocation("scalarField");
+    m_uniformLocation_textureSampler = m_shaderProgram.uniformLocation("textureSampler");
+    m_uniformLocation_rangeMin = m_shaderProgram.uniformLocation("rangeMin");
+    m_uniformLocation_rangeMax = m_shaderProgram.uniformLocation("rangeMax");
+    m_uniformLocation_transferK = m_shaderProgram.uniformLocation("transferK");
+    m_uniformLocation_useCustomColorMap = m_shaderProgram.uniformLocation("useCustomColorMap");
+
+    // A quad that fills the framebuffer: per vertex the position and the texture coordinates.
+    std::array<float, 16U> const quad{-1.0F, -1.0F, 0.0F, 0.0F,
+                                       1.0F, -1.0F, 1.0F, 0.0F,
+                                      -1.0F,  1.0F, 0.0F, 1.0F,
+                                       1.0F,  1.0F, 1.0F, 1.0F};
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(quad)), quad.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<GLvoid*>(2U * sizeof(float)));
+
+    glGenTextures(1, &m_colorMapTexture);
+    glBindTexture(GL_TEXTURE_1D, m_colorMapTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB32F, static_cast<GLint>(colorMap.size()), 0, GL_RGB, GL_FLOAT,
+                 colorMap.data());
+
+    // The texture is allocated in render, once the size of the field is known.
+    glGenTextures(1, &m_scalarFieldTexture);
+    glBindTexture(GL_TEXTURE_2D, m_scalarFieldTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return true;
+}
+
+QImage BatchRenderer::render(std::vector<float> const &scalarField, size_t const width, size_t const height,
+                             QVector2D const range)
+{
+    m_context.makeCurrent(&m_surface);
+
+    // The rows of an R32F field are always 4-byte aligned.
+    glBindTexture(GL_TEXTURE_2D, m_scalarFieldTexture);
+    if (width != m_scalarFieldWidth || height != m_scalarFieldHeight)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RED,
+                     GL_FLOAT, scalarField.data());
+        m_scalarFieldWidth = width;
+        m_scalarFieldHeight = height;
+    }
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RED,
+                        GL_FLOAT, scalarField.data());
+
+    m_framebuffer->bind();
+    glViewport(0, 0, m_framebuffer->width(), m_framebuffer->height());
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_shaderProgram.bind();
+    glUniform1i(m_uniformLocation_textureSampler, 0);
+    glUniform1i(m_uniformLocation_scalarField, 1);
+    glUniform1f(m_uniformLocation_rangeMin, range.x());
+    glUniform1f(m_uniformLocation_rangeMax, range.y());
+    glUniform1f(m_uniformLocation_transferK, 1.0F);
+    glUniform1i(m_uniformLocation_useCustomColorMap, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_1D, m_colorMapTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_scalarFieldTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // toImage waits for the draw, and flips the rows so that y points up like in the visualization.
+    QImage image = m_framebuffer->toImage();
+    m_framebuffer->release();
+    return image;
+}
@@ -0,0 +1,58 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include "color.h"
+
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Renders scalar fields into images without a window, for batch runs. An OpenGL 3.3 core context draws into a
+// framebuffer object on an offscreen surface, with the scalarData_field shaders of the visualization: the field is an
+// R32F texture on a quad that fills the image, mapped through the color map per fragment.
+// Requires a QGuiApplication.
+class BatchRenderer : protected QOpenGLFunctions_3_3_Core
+{
+    QOffscreenSurface m_surface;
+    QOpenGLContext m_context;
+    std::unique_ptr<QOpenGLFramebufferObject> m_framebuffer;
+    QOpenGLShaderProgram m_shaderProgram;
+
+    GLuint m_vao = 0U;
+    GLuint m_vbo = 0U;
+    GLuint m_scalarFieldTexture = 0U;
+    GLuint m_colorMapTexture = 0U;
+    size_t m_scalarFieldWidth = 0U;
+    size_t m_scalarFieldHeight = 0U;
+
+    GLint m_uniformLocation_scalarField = -1;
+    GLint m_uniformLocation_textureSampler = -1;
+    GLint m_uniformLocation_rangeMin = -1;
+    GLint m_uniformLocation_rangeMax = -1;
+    GLint m_uniformLocation_transferK = -1;
+    GLint m_uniformLocation_useCustomColorMap = -1;
+
+public:
+    BatchRenderer() = default;
+    BatchRenderer(BatchRenderer const&) = delete;
+    BatchRenderer& operator=(BatchRenderer const&) = delete;
+    ~BatchRenderer();
+
+    // Returns false, after logging why, if no context, framebuffer or shader program could be created.
+    bool create(int const imageWidth, int const imageHeight, std::vector<Color> const &colorMap);
+
+    // Maps the values of a width x height field in range to the color map. A range of zero width maps everything to
+    // the first color.
+    [[nodiscard]] QImage render(std::vector<float> const &scalarField, size_t const width, size_t const height,
+                                QVector2D const range);
+};
+
+#endif // BATCHRENDERER_H
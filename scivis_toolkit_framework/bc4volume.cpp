@@ -0,0 +1,150 @@
+#include "bc4volume.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    // The value of a voxel in [0, 255], 16-bit values keep their fraction for the choice of the indices.
+    float voxelLevel(void const * const data, size_t const dataSize, size_t const voxelIdx, size_t const scalarSize)
+    {
+        if ((voxelIdx + 1U) * scalarSize > dataSize)
+            return 0.0F;
+
+        if (scalarSize == 1U)
+            return static_cast<float>(static_cast<std::uint8_t const*>(data)[voxelIdx]);
+
+        // The data offset of a raw file need not keep 16-bit values aligned.
+        std::uint16_t value;
+        std::memcpy(&value, static_cast<std::uint8_t const*>(data) + voxelIdx * scalarSize, sizeof(value));
+        return static_cast<float>(value) / 257.0F;
+    }
+
+    // Encodes 16 values in [0, 255], row by row, into one BC4 block.
+    void compressBlock(std::array<float, 16U> const &levels, std::uint8_t * const block)
+    {
+        auto const [minimum, maximum] = std::minmax_element(levels.begin(), levels.end());
+        auto const red0 = static_cast<int>(std::min(std::ceil(*maximum), 255.0F));
+        auto const red1 = static_cast<int>(std::max(std::floor(*minimum), 0.0F));
+
+        std::uint64_t indices = 0U;
+        if (red0 > red1)
+        {
+            // With red0 > red1, index 0 is red0, 1 is red1 and 2 to 7 lie evenly in between.
+            std::array<float, 8U> palette{static_cast<float>(red0), static_cast<float>(red1)};
+            for (size_t code = 2U; code < palette.size(); ++code)
+                palette[code] = (static_cast<float>(8U - code) * palette[0] + static_cast<float>(code - 1U) * palette[1]) / 7.0F;
+
+            for (size_t voxel = 0U; voxel < levels.size(); ++voxel)
+            {
+                std::uint64_t bestCode = 0U;
+                for (size_t code = 1U; code < palette.size(); ++code)
+                    if (std::abs(palette[code] - levels[voxel]) < std::abs(palette[bestCode] - levels[voxel]))
+                        bestCode = code;
+
+                indices |= bestCode << (3U * voxel);
+            }
+        }
+
+        // A uniform block keeps all indices at 0, i.e. red0.
+        block[0] = static_cast<std::uint8_t>(red0);
+        block[1] = static_cast<std::uint8_t>(red1);
+        for (size_t byte = 0U; byte < 6U; ++byte)
+            block[2U + byte] = static_cast<std::uint8_t>(indices >> (8U * byte));
+    }
+}
+
+size_t Bc4Volume::sliceSize(std::array<size_t, 3U> const &resolution)
+{
+    size_t const blocksX = (resolution[0] + s_blockWidth - 1U) / s_blockWidth;
+    size_t const blocksY = (resolution[1] + s_blockWidth - 1U) / s_blockWidth;
+    return blocksX * blocksY * s_bytesPerBlock;
+}
+
+size_t Bc4Volume::volumeSize(std::array<size_t, 3U> const &resolution)
+{
+    return sliceSize(resolution) * resolution[2];
+}
+
+void Bc4Volume::compress(void const * const data,
+                         size_t const dataSize,
+                         std::array<size_t, 3U> const &resolution,
+                         size_t const scalarSize,
+                         std::uint8_t * const destination,
+                         ThreadPool &threadPool)
+{
+    size_t const blocksX = (resolution[0] + s_blockWidth - 1U) / s_blockWidth;
+    size_t const blocksY = (resolution[1] + s_blockWidth - 1U) / s_blockWidth;
+
+    // Every slice is independent of the others.
+    threadPool.parallelFor(0U, resolution[2], [&](size_t const begin, size_t const end, size_t const) {
+        std::array<float, 16U> levels{};
+        for (size_t z = begin; z < end; ++z)
+        {
+            std::uint8_t *block = destination + z * sliceSize(resolution);
+            for (size_t blockY = 0U; blockY < blocksY; ++blockY)
+                for (size_t blockX = 0U; blockX < blocksX; ++blockX, block += s_bytesPerBlock)
+                {
+                    // Blocks sticking out of the slice repeat its last voxels, which keeps their range tight.
+                    for (size_t y = 0U; y < s_blockWidth; ++y)
+                        for (size_t x = 0U; x < s_blockWidth; ++x)
+                        {
+                            size_t const voxelX = std::min(blockX * s_blockWidth + x, resolution[0] - 1U);
+                            size_t const voxelY = std::min(blockY * s_blockWidth + y, resolution[1] - 1U);
+                            size_t const voxelIdx = (z * resolution[1] + voxelY) * resolution[0] + voxelX;
+                            levels[y * s_blockWidth + x] = voxelLevel(data, dataSize, voxelIdx, scalarSize);
+                        }
+
+                    compressBlock(levels, block);
+                }
+        }
+    });
+}
+
+datraw::memory_mapped_file Bc4Volume::mapCompressed(std::string const &rawPath,
+                                                    datraw::memory_mapped_file const &raw,
+                                                    std::array<size_t, 3U> const &resolution,
+                                                    size_t const scalarSize,
+                                                    ThreadPool &threadPool)
+{
+    std::string const compressedPath = rawPath + ".bc4";
+    size_t const compressedSize = volumeSize(resolution);
+
+    // A conversion of a previous load can be reused as long as the raw file has not changed since.
+    std::error_code error;
+    auto const rawTime = std::filesystem::last_write_time(rawPath, error);
+    bool isCurrent = !error && std::filesystem::file_size(compressedPath, error) == compressedSize && !error;
+    isCurrent = isCurrent && std::filesystem::last_write_time(compressedPath, error) >= rawTime && !error;
+
+    if (!isCurrent)
+    {
+        std::vector<std::uint8_t> compressed(compressedSize);
+        compress(raw.data(), raw.size(), resolution, scalarSize, compressed.data(), threadPool);
+
+        std::ofstream stream{compressedPath, std::ios::binary | std::ios::trunc};
+        stream.write(reinterpret_cast<char const*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+        if (!stream)
+        {
+            qWarning() << "Could not write the compressed volume" << compressedPath.c_str();
+            return {};
+        }
+        qDebug() << "Compressed" << rawPath.c_str() << "into" << compressedPath.c_str();
+    }
+
+    try
+    {
+        return datraw::memory_mapped_file::open(compressedPath, 0U, datraw::memory_mapped_file::access::read_only);
+    }
+    catch (std::exception const &exception)
+    {
+        qWarning() << "Could not map the compressed volume" << compressedPath.c_str() << ":" << exception.what();
+        return {};
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef BC4VOLUME_H
+#define BC4VOLUME_H
+
+#include "datraw.h"
+#include "threadpool.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Compression of volumes into BC4 (RGTC1) blocks, one image per z slice of a GL_TEXTURE_2D_ARRAY (RGTC cannot be used
+// for 3D textures). Every block of 4 x 4 voxels of a slice takes 8 bytes: two 8-bit end points and a 3-bit index per
+// voxel into the 8 values between them. That is half the size of 8-bit data and a quarter of 16-bit data, which are
+// reduced to the precision of the end points and their interpolation.
+// The slices are converted once per raw file and kept next to it, so later loads map the compressed file directly.
+class Bc4Volume
+{
+public:
+    static constexpr size_t s_blockWidth = 4U;
+    static constexpr size_t s_bytesPerBlock = 8U;
+
+    // The number of bytes of one compressed slice and of the whole compressed volume.
+    [[nodiscard]] static size_t sliceSize(std::array<size_t, 3U> const &resolution);
+    [[nodiscard]] static size_t volumeSize(std::array<size_t, 3U> const &resolution);
+
+    // data holds dataSize bytes of resolution voxels of scalarSize (1 or 2) bytes each, x fastest. Missing voxels of a
+    // truncated volume count as 0. destination receives volumeSize(resolution) bytes, slice after slice.
+    static void compress(void const * const data,
+                         size_t const dataSize,
+                         std::array<size_t, 3U> const &resolution,
+                         size_t const scalarSize,
+                         std::uint8_t * const destination,
+                         ThreadPool &threadPool);
+
+    // Maps the compressed version of the raw file at rawPath, whose voxels are mapped in raw. It is (re)written to
+    // rawPath + ".bc4" first if it is missing or older than the raw file. Returns a closed mapping if this fails.
+    [[nodiscard]] static datraw::memory_mapped_file mapCompressed(std::string const &rawPath,
+                                                                  datraw::memory_mapped_file const &raw,
+                                                                  std::array<size_t, 3U> const &resolution,
+                                                                  size_t const scalarSize,
+                                                                  ThreadPool &threadPool);
+};
+
+#endif // BC4VOLUME_H
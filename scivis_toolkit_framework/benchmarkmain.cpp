@@ -0,0 +1,498 @@
+// Usage: scivis_benchmark [--filter=<text>] [--dims=<n,n,...>] [--threads=<n,n,...>] [--min-time=<seconds>]
+//        Times the simulation and visualization kernels that run without an OpenGL context, for every grid size and
+//        thread count, and prints the time per call, per cell and the effective bandwidth.
+//        Only benchmarks whose name contains the filter text are run. By default the grid sizes are 64 to 2048 and
+//        the thread counts 1 and the number of hardware threads.
+//        The bandwidth counts every input and output field once, so it is a lower bound for the memory traffic.
+//        The .dat benchmarks time page cache hits after the first iteration, not the disk.
+//--------------------------------------------------------------------------------------------------
+
+#include "datarawloader.h"
+#include "derivedfieldcache.h"
+#include "forcescript.h"
+#include "interpolation.h"
+#include "marchingcubes.h"
+#include "movingrange.h"
+#include "preprocessingpipeline.h"
+#include "resampler.h"
+#include "simulation.h"
+#include "simulationframe.h"
+#include "streamlinetracer.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::string filter;
+        std::vector<size_t> DIMs{64U, 128U, 256U, 512U, 1024U, 2048U};
+        std::vector<size_t> threadCounts{1U, ThreadPool::hardwareThreadCount()};
+        double minTime = 0.5; // Seconds per benchmark.
+    };
+
+    std::vector<size_t> parseList(std::string const &text)
+    {
+        std::vector<size_t> values;
+        size_t begin = 0U;
+        while (begin < text.size())
+        {
+            size_t const end = std::min(text.find(',', begin), text.size());
+            values.push_back(std::stoul(text.substr(begin, end - begin)));
+            begin = end + 1U;
+        }
+        return values;
+    }
+
+    bool parseOptions(int const argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string const argument = argv[i];
+            auto const value = [&argument](std::string const &option) { return argument.substr(option.size()); };
+
+            try
+            {
+                if (argument.rfind("--filter=", 0U) == 0U)
+                    options.filter = value("--filter=");
+                else if (argument.rfind("--dims=", 0U) == 0U)
+                    options.DIMs = parseList(value("--dims="));
+                else if (argument.rfind("--threads=", 0U) == 0U)
+                    options.threadCounts = parseList(value("--threads="));
+                else if (argument.rfind("--min-time=", 0U) == 0U)
+                    options.minTime = std::stod(value("--min-time="));
+                else
+                {
+                    std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+                    return false;
+                }
+            }
+            catch (std::exception const &)
+            {
+                std::fprintf(stderr, "Invalid value in %s\n", argument.c_str());
+                return false;
+            }
+        }
+
+        // Every thread count only once, since 1 may also be the number of hardware threads.
+        std::sort(options.threadCounts.begin(), options.threadCounts.end());
+        options.threadCounts.erase(std::unique(options.threadCounts.begin(), options.threadCounts.end()),
+                                   options.threadCounts.end());
+        options.threadCounts.erase(std::remove(options.threadCounts.begin(), options.threadCounts.end(), 0U),
+                                   options.threadCounts.end());
+        return true;
+    }
+
+    class Runner
+    {
+        Options const &m_options;
+
+    public:
+        explicit Runner(Options const &options)
+            :
+              m_options(options)
+        {
+            std::printf("%-56s %10s %14s %10s %8s\n", "benchmark", "iterations", "ns/iteration", "ns/cell", "GB/s");
+        }
+
+        [[nodiscard]] bool selected(std::string const &name) const
+        {
+            return name.find(m_options.filter) != std::string::npos;
+        }
+
+        // Calls body once to warm up, then as often as fits in the minimum time, doubling the iterations each round.
+        // cells and bytes are the number of cells and bytes one call processes.
+        void run(std::string const &name, size_t const cells, size_t const bytes, std::function<void()> const &body) const
+        {
+            body();
+
+            size_t iterations = 1U;
+            double seconds = 0.0;
+            while (true)
+            {
+                auto const start = std::chrono::steady_clock::now();
+                for (size_t iteration = 0U; iteration < iterations; ++iteration)
+                    body();
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                if (seconds >= m_options.minTime || iterations >= (size_t{1U} << 30U))
+                    break;
+
+                // Aim a little beyond the minimum time, so the last round usually suffices.
+                double const estimate = seconds > 0.0 ? 1.2 * m_options.minTime / seconds : 1e9;
+                iterations = static_cast<size_t>(static_cast<double>(iterations) * std::clamp(estimate, 2.0, 100.0));
+            }
+
+            double const nanoseconds = 1e9 * seconds / static_cast<double>(iterations);
+            std::printf("%-56s %10zu %14.0f %10.3f %8.2f\n", name.c_str(), iterations, nanoseconds,
+                        nanoseconds / static_cast<double>(cells), static_cast<double>(bytes) / nanoseconds);
+            std::fflush(stdout);
+        }
+    };
+
+    std::string suffix(size_t const DIM, size_t const threadCount)
+    {
+        return "/DIM:" + std::to_string(DIM) + "/threads:" + std::to_string(threadCount);
+    }
+
+    char const *precisionName(FieldPrecision const precision)
+    {
+        return precision == FieldPrecision::Float16 ? "float16" : "float32";
+    }
+
+    // A simulation that has been stirred for a while, so the fields are not trivially zero.
+    Simulation stirredSimulation(size_t const DIM, size_t const threadCount)
+    {
+        Simulation simulation{DIM};
+        simulation.setThreadCount(threadCount);
+
+        ForceScript const script;
+        for (size_t step = 0U; step < 50U; ++step)
+        {
+            script.apply(step, simulation);
+            simulation.doOneSimulationStep();
+        }
+        return simulation;
+    }
+
+    void benchmarkSimulation(Runner const &runner, size_t const DIM, size_t const threadCount)
+    {
+        size_t const cells = DIM * DIM;
+        size_t const fieldBytes = cells * sizeof(float);
+
+        // The eight fields of the solver, each read and written once.
+        std::string const stepName = "simulation/step" + suffix(DIM, threadCount);
+        if (runner.selected(stepName))
+        {
+            Simulation simulation = stirredSimulation(DIM, threadCount);
+            ForceScript const script;
+            size_t step = 0U;
+            runner.run(stepName, cells, 2U * 8U * fieldBytes, [&]
+            {
+                script.apply(step++, simulation);
+                simulation.doOneSimulationStep();
+            });
+        }
+
+        // The same step with every spectral field selected, which adds four inverse transforms, against simulation/step.
+        std::string const spectralStepName = "simulation/stepWithSpectralFields" + suffix(DIM, threadCount);
+        if (runner.selected(spectralStepName))
+        {
+            Simulation simulation = stirredSimulation(DIM, threadCount);
+            simulation.setSpectralFields(SpectralDerivatives::s_vorticity | SpectralDerivatives::s_divergence |
+                                         SpectralDerivatives::s_qCriterion);
+            ForceScript const script;
+            size_t step = 0U;
+            runner.run(spectralStepName, cells, 2U * 8U * fieldBytes + 6U * fieldBytes, [&]
+            {
+                script.apply(step++, simulation);
+                simulation.doOneSimulationStep();
+            });
+        }
+
+        // Publishing copies rho, vx, vy, fx and fy; in float16 three of them are written at half the size.
+        for (FieldPrecision const precision : {FieldPrecision::Float32, FieldPrecision::Float16})
+        {
+            std::string const name = std::string{"simulation/publishFrame/"} + precisionName(precision) +
+                                     suffix(DIM, threadCount);
+            if (threadCount != 1U || !runner.selected(name))
+                continue;
+
+            Simulation const simulation = stirredSimulation(DIM, 1U);
+            SimulationFrame frame;
+            size_t frameNumber = 0U;
+            size_t const writtenBytes = precision == FieldPrecision::Float16 ? 2U * fieldBytes + 3U * cells * 2U
+                                                                             : 5U * fieldBytes;
+            runner.run(name, cells, 5U * fieldBytes + writtenBytes,
+                       [&] { frame.copyFrom(simulation, 0U, ++frameNumber, precision); });
+        }
+    }
+
+    void benchmarkDerivedFields(Runner const &runner, size_t const DIM, size_t const threadCount)
+    {
+        if (threadCount != 1U)
+            return;
+
+        size_t const cells = DIM * DIM;
+        size_t const fieldBytes = cells * sizeof(float);
+
+        for (FieldPrecision const precision : {FieldPrecision::Float32, FieldPrecision::Float16})
+        {
+            std::string const name = std::string{"derived/velocityDivergence/"} + precisionName(precision) +
+                                     suffix(DIM, threadCount);
+            if (!runner.selected(name))
+                continue;
+
+            Simulation const simulation = stirredSimulation(DIM, 1U);
+            SimulationFrame frame;
+            frame.copyFrom(simulation, 0U, 1U, precision);
+            DerivedFieldCache cache;
+            cache.setCellSize(1.0F, 1.0F);
+
+            float sink = 0.0F;
+            runner.run(name, cells, 3U * fieldBytes, [&]
+            {
+                cache.invalidate();
+                sink += cache.scalarField(ScalarDataType::VelocityDivergence, frame)[0];
+            });
+        }
+
+        // Resampling to twice the grid size, as when the grid is drawn at a higher resolution.
+        size_t const outputSide = 2U * DIM;
+        size_t const resampleBytes = fieldBytes + outputSide * outputSide * sizeof(float);
+        std::vector<float> const values = stirredSimulation(DIM, 1U).density();
+        std::vector<float> result;
+
+        std::string const resamplerName = "interpolation/resampler" + suffix(DIM, threadCount);
+        if (runner.selected(resamplerName))
+        {
+            Resampler resampler;
+            resampler.setShape(DIM, outputSide, outputSide);
+            runner.run(resamplerName, cells, resampleBytes, [&] { resampler.resample(values.data(), result); });
+        }
+
+        // Builds the tables on every call.
+        std::string const interpolateName = "interpolation/interpolateSquareVector" + suffix(DIM, threadCount);
+        if (runner.selected(interpolateName))
+            runner.run(interpolateName, cells, resampleBytes, [&]
+            {
+                result = interpolation::interpolateSquareVector(values, DIM, outputSide, outputSide);
+            });
+    }
+
+    void benchmarkPreprocessing(Runner const &runner, size_t const DIM, size_t const threadCount)
+    {
+        struct Filters
+        {
+            char const *name;
+            PreprocessingPipeline::Settings settings;
+        };
+
+        PreprocessingPipeline::Settings quantization;
+        quantization.quantization = true;
+        PreprocessingPipeline::Settings blur;
+        blur.gaussianBlur = true;
+        PreprocessingPipeline::Settings gradients;
+        gradients.gradients = true;
+        PreprocessingPipeline::Settings all{true, 8U, true, true};
+
+        size_t const cells = DIM * DIM;
+        std::vector<float> const values = stirredSimulation(DIM, 1U).density();
+        for (Filters const &filters : {Filters{"quantization", quantization}, Filters{"gaussianBlur", blur},
+                                       Filters{"gradients", gradients}, Filters{"all", all}})
+        {
+            std::string const name = std::string{"preprocessing/"} + filters.name + suffix(DIM, threadCount);
+            if (!runner.selected(name))
+                continue;
+
+            ThreadPool threadPool{threadCount};
+            PreprocessingPipeline pipeline;
+            std::vector<float> field;
+            runner.run(name, cells, 2U * cells * sizeof(float), [&]
+            {
+                field = values;
+                pipeline.apply(field, DIM, DIM, filters.settings, threadPool);
+            });
+        }
+    }
+
+    // 64 x 64 seeds of 64 vertices, whatever the grid size. A cell is one vertex, the bytes are the written vertices.
+    void benchmarkStreamlines(Runner const &runner, size_t const DIM, size_t const threadCount)
+    {
+        size_t constexpr seedsPerRow = 64U;
+        size_t constexpr numberOfVertices = 64U;
+
+        std::string const streamlinesName = "streamlines/trace" + suffix(DIM, threadCount);
+        std::string const pathlinesName = "pathlines/trace" + suffix(DIM, threadCount);
+        if (!runner.selected(streamlinesName) && !runner.selected(pathlinesName))
+            return;
+
+        std::vector<StreamlineTracer::Seed> seeds;
+        float const spacing = static_cast<float>(DIM - 1U) / static_cast<float>(seedsPerRow);
+        for (size_t j = 0U; j < seedsPerRow; ++j)
+            for (size_t i = 0U; i < seedsPerRow; ++i)
+                seeds.push_back({(static_cast<float>(i) + 0.5F) * spacing, (static_cast<float>(j) + 0.5F) * spacing});
+
+        size_t const vertices = seeds.size() * numberOfVertices;
+        std::vector<StreamlineTracer::Vertex> result(vertices);
+        ThreadPool threadPool{threadCount};
+        StreamlineTracer tracer;
+
+        Simulation simulation = stirredSimulation(DIM, 1U);
+        if (runner.selected(streamlinesName))
+            runner.run(streamlinesName, vertices, vertices * sizeof(StreamlineTracer::Vertex), [&]
+            {
+                tracer.traceStreamlines(simulation.velocityX(), simulation.velocityY(), DIM, DIM, seeds,
+                                        numberOfVertices, 0.5F, threadPool, result.data());
+            });
+
+        if (runner.selected(pathlinesName))
+        {
+            ForceScript const script;
+            for (size_t step = 0U; step < numberOfVertices; ++step)
+            {
+                script.apply(step, simulation);
+                simulation.doOneSimulationStep();
+                tracer.recordFrame(simulation.velocityX(), simulation.velocityY(), DIM, DIM, numberOfVertices, step);
+            }
+
+            runner.run(pathlinesName, vertices, vertices * sizeof(StreamlineTracer::Vertex), [&]
+            {
+                tracer.tracePathlines(seeds, simulation.dt(), threadPool, result.data());
+            });
+        }
+    }
+
+    void benchmarkMovingRange(Runner const &runner)
+    {
+        size_t constexpr updates = 4096U;
+        for (size_t const windowSize : {16U, 256U, 4096U})
+        {
+            std::string const name = "movingRange/update/window:" + std::to_string(windowSize);
+            if (!runner.selected(name))
+                continue;
+
+            MovingRange range{windowSize, QVector2D{0.0F, 0.0F}};
+            std::vector<QVector2D> values(updates);
+            for (size_t idx = 0U; idx < updates; ++idx)
+            {
+                auto const value = static_cast<float>((idx * 2654435761U) % 1000U);
+                values[idx] = QVector2D{value, value + 1.0F};
+            }
+
+            float sink = 0.0F;
+            runner.run(name, updates, updates * sizeof(QVector2D), [&]
+            {
+                for (QVector2D const &value : values)
+                    range.update(value);
+                sink += range.range().x();
+            });
+        }
+    }
+
+    // Writes a .dat file of numberOfTimeSteps cubes of side voxels and returns its path.
+    std::filesystem::path writeVolume(std::filesystem::path const &directory, size_t const side, size_t const scalarSize,
+                                      size_t const numberOfTimeSteps)
+    {
+        std::string const type = scalarSize == 1U ? "uint8" : "uint16";
+        std::string const baseName = "volume_" + type + "_" + std::to_string(side);
+
+        std::vector<char> voxels(side * side * side * scalarSize);
+        for (size_t idx = 0U; idx < voxels.size(); ++idx)
+            voxels[idx] = static_cast<char>((idx * 7U) ^ (idx >> 11U));
+
+        for (size_t timeStep = 0U; timeStep < numberOfTimeSteps; ++timeStep)
+        {
+            char rawName[64];
+            std::snprintf(rawName, sizeof(rawName), "_%02zu.raw", timeStep);
+            std::ofstream raw{directory / (baseName + rawName), std::ios::binary};
+            raw.write(voxels.data(), static_cast<std::streamsize>(voxels.size()));
+        }
+
+        std::filesystem::path const datPath = directory / (baseName + ".dat");
+        std::ofstream dat{datPath};
+        dat << "ObjectFileName: " << baseName << "_%02+0*1d.raw\n"
+            << "Resolution: " << side << ' ' << side << ' ' << side << '\n'
+            << "Format: " << (scalarSize == 1U ? "UCHAR" : "USHORT") << '\n'
+            << "TimeSteps: " << numberOfTimeSteps << '\n';
+        return datPath;
+    }
+
+    // The triangles of the noise volume take up to sixty bytes per voxel.
+    constexpr size_t s_maxMarchingCubesDIM = 128U;
+
+    // The grid size is the side of the volume, up to 256, and up to s_maxMarchingCubesDIM for marching cubes.
+    void benchmarkDataRaw(Runner const &runner, std::filesystem::path const &directory, size_t const DIM,
+                          size_t const threadCount)
+    {
+        size_t constexpr numberOfTimeSteps = 4U;
+        if (DIM > 256U)
+            return;
+
+        std::array<size_t, 3U> const resolution{DIM, DIM, DIM};
+        size_t const cells = numberOfTimeSteps * DIM * DIM * DIM;
+        for (size_t const scalarSize : {size_t{1U}, size_t{2U}})
+        {
+            std::string const type = scalarSize == 1U ? "/uint8" : "/uint16";
+            std::string const mapName = "datraw/mapTimeSteps" + type + suffix(DIM, threadCount);
+            std::string const occupancyName = "datraw/buildOccupancies" + type + suffix(DIM, threadCount);
+            std::string const marchingCubesName = "datraw/marchingCubes" + type + suffix(DIM, threadCount);
+            bool const runMarchingCubes = DIM <= s_maxMarchingCubesDIM && runner.selected(marchingCubesName);
+            if (!runner.selected(mapName) && !runner.selected(occupancyName) && !runMarchingCubes)
+                continue;
+
+            std::filesystem::path const datPath = writeVolume(directory, DIM, scalarSize, numberOfTimeSteps);
+            auto const reader = DataRawLoader::Reader::open(datPath.string());
+            std::vector<datraw::memory_mapped_file> timeSteps;
+
+            if (runner.selected(mapName))
+                runner.run(mapName, cells, cells * scalarSize, [&]
+                {
+                    timeSteps = DataRawLoader::mapTimeSteps(reader, threadCount, [](std::uint64_t, std::uint64_t) {});
+                });
+
+            if (runner.selected(occupancyName))
+            {
+                timeSteps = DataRawLoader::mapTimeSteps(reader, threadCount, [](std::uint64_t, std::uint64_t) {});
+                ThreadPool threadPool{threadCount};
+                runner.run(occupancyName, cells, cells * scalarSize, [&]
+                {
+                    std::vector<VolumeOccupancy> const occupancies = DataRawLoader::buildOccupancies(
+                                timeSteps, resolution, scalarSize, threadPool);
+                });
+            }
+
+            // One time step, extracted from scratch every call. The noise of the volume leaves no brick to skip.
+            if (runMarchingCubes)
+            {
+                timeSteps = DataRawLoader::mapTimeSteps(reader, threadCount, [](std::uint64_t, std::uint64_t) {});
+                ThreadPool threadPool{threadCount};
+                std::vector<VolumeOccupancy> const occupancies = DataRawLoader::buildOccupancies(
+                            timeSteps, resolution, scalarSize, threadPool);
+                MarchingCubes marchingCubes;
+                size_t const voxels = DIM * DIM * DIM;
+                runner.run(marchingCubesName, voxels, voxels * scalarSize, [&]
+                {
+                    marchingCubes.setVolume(timeSteps[0].data(), timeSteps[0].size(), resolution, scalarSize,
+                                            occupancies[0]);
+                    marchingCubes.extract(0.5F, threadPool);
+                });
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    std::filesystem::path const directory = std::filesystem::temp_directory_path() / "scivis_benchmark";
+    std::filesystem::create_directories(directory);
+
+    Runner const runner{options};
+    benchmarkMovingRange(runner);
+    for (size_t const DIM : options.DIMs)
+    {
+        for (size_t const threadCount : options.threadCounts)
+        {
+            benchmarkSimulation(runner, DIM, threadCount);
+            benchmarkDerivedFields(runner, DIM, threadCount);
+            benchmarkPreprocessing(runner, DIM, threadCount);
+            benchmarkStreamlines(runner, DIM, threadCount);
+            benchmarkDataRaw(runner, directory, DIM, threadCount);
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "bricklayout.h"
+
+#include <algorithm>
+
+BrickLayout::BrickLayout(std::array<size_t, 3U> const &resolution, size_t const maxTextureSize)
+    :
+      m_resolution(resolution)
+{
+    if (maxTextureSize < 3U || std::find(resolution.begin(), resolution.end(), 0U) != resolution.end())
+        return;
+
+    std::array<size_t, 3U> cellSize{};
+    for (size_t axis = 0U; axis < 3U; ++axis)
+    {
+        if (resolution[axis] <= maxTextureSize)
+        {
+            m_brickCount[axis] = 1U;
+            m_coreSize[axis] = resolution[axis];
+            m_ghostSize[axis] = 0U;
+        }
+        else
+        {
+            size_t const maxCoreSize = maxTextureSize - 2U;
+            m_brickCount[axis] = (resolution[axis] + maxCoreSize - 1U) / maxCoreSize;
+            m_coreSize[axis] = (resolution[axis] + m_brickCount[axis] - 1U) / m_brickCount[axis];
+            m_ghostSize[axis] = 1U;
+        }
+        cellSize[axis] = m_coreSize[axis] + 2U * m_ghostSize[axis];
+    }
+
+    // Fill the atlas x first, then y, then z, but never use more cells along an axis than there are bricks.
+    size_t const numberOfBricks = m_brickCount[0] * m_brickCount[1] * m_brickCount[2];
+    m_atlasCellCount[0] = std::min(maxTextureSize / cellSize[0], numberOfBricks);
+    m_atlasCellCount[1] = std::min(maxTextureSize / cellSize[1],
+                                   (numberOfBricks + m_atlasCellCount[0] - 1U) / m_atlasCellCount[0]);
+    m_atlasCellCount[2] = (numberOfBricks + m_atlasCellCount[0] * m_atlasCellCount[1] - 1U) /
+                          (m_atlasCellCount[0] * m_atlasCellCount[1]);
+
+    for (size_t axis = 0U; axis < 3U; ++axis)
+        m_atlasSize[axis] = m_atlasCellCount[axis] * cellSize[axis];
+
+    m_isValid = m_atlasSize[2] <= maxTextureSize;
+}
+
+// Getters
+bool BrickLayout::isValid() const
+{
+    return m_isValid;
+}
+
+bool BrickLayout::isBricked() const
+{
+    return numberOfBricks() > 1U;
+}
+
+size_t BrickLayout::numberOfBricks() const
+{
+    return m_brickCount[0] * m_brickCount[1] * m_brickCount[2];
+}
+
+std::array<size_t, 3U> const &BrickLayout::atlasSize() const
+{
+    return m_atlasSize;
+}
+
+BrickLayout::Brick BrickLayout::brick(size_t const brickIdx) const
+{
+    std::array<size_t, 3U> const brickCoordinate{brickIdx % m_brickCount[0],
+                                                 brickIdx / m_brickCount[0] % m_brickCount[1],
+                                                 brickIdx / (m_brickCount[0] * m_brickCount[1])};
+    std::array<size_t, 3U> const cellCoordinate{brickIdx % m_atlasCellCount[0],
+                                                brickIdx / m_atlasCellCount[0] % m_atlasCellCount[1],
+                                                brickIdx / (m_atlasCellCount[0] * m_atlasCellCount[1])};
+
+    Brick result{};
+    for (size_t axis = 0U; axis < 3U; ++axis)
+    {
+        size_t const coreBegin = brickCoordinate[axis] * m_coreSize[axis];
+        size_t const begin = coreBegin >= m_ghostSize[axis] ? coreBegin - m_ghostSize[axis] : 0U;
+        size_t const end = std::min(coreBegin + m_coreSize[axis] + m_ghostSize[axis], m_resolution[axis]);
+
+        result.sourceOffset[axis] = begin;
+        result.size[axis] = end - begin;
+        result.atlasOffset[axis] = cellCoordinate[axis] * (m_coreSize[axis] + 2U * m_ghostSize[axis]) +
+                                   (begin + m_ghostSize[axis] - coreBegin);
+    }
+    return result;
+}
+
+QVector3D BrickLayout::brickCount() const
+{
+    return toVector(m_brickCount);
+}
+
+QVector3D BrickLayout::brickScale() const
+{
+    return toVector(m_resolution) / toVector(m_coreSize);
+}
+
+QVector3D BrickLayout::atlasCellCount() const
+{
+    return toVector(m_atlasCellCount);
+}
+
+QVector3D BrickLayout::atlasCellExtent() const
+{
+    return (toVector(m_coreSize) + 2.0F * toVector(m_ghostSize)) / toVector(m_atlasSize);
+}
+
+QVector3D BrickLayout::atlasGhostOffset() const
+{
+    return toVector(m_ghostSize) / toVector(m_atlasSize);
+}
+
+QVector3D BrickLayout::atlasCoreExtent() const
+{
+    return toVector(m_coreSize) / toVector(m_atlasSize);
+}
+
+QVector3D BrickLayout::toVector(std::array<size_t, 3U> const &values)
+{
+    return {static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2])};
+}
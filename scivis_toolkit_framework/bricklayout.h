@@ -0,0 +1,60 @@
+#ifndef BRICKLAYOUT_H
+#define BRICKLAYOUT_H
+
+#include <QVector3D>
+
+#include <array>
+#include <cstddef>
+
+// Packs a volume of any resolution into a 3D texture of at most maxTextureSize voxels per axis.
+// A volume that fits is stored as is. Otherwise, every axis that is too large is split into bricks of equal (core)
+// size, each with a ghost layer of one voxel on every side so that linear filtering is seamless across bricks. The
+// bricks are then arranged in an atlas of cells, filling x first, then y, then z, which lets e.g. a volume that is too
+// long in x fold its bricks into y and z.
+// The shaders map a normalized volume coordinate to an atlas coordinate with the vectors returned by the getters.
+class BrickLayout
+{
+public:
+    // The part of the volume that goes into one brick, and where it goes in the atlas. All in voxels.
+    struct Brick
+    {
+        std::array<size_t, 3U> sourceOffset;
+        std::array<size_t, 3U> size;
+        std::array<size_t, 3U> atlasOffset;
+    };
+
+private:
+    std::array<size_t, 3U> m_resolution{};
+    std::array<size_t, 3U> m_brickCount{1U, 1U, 1U};
+    std::array<size_t, 3U> m_coreSize{};
+    std::array<size_t, 3U> m_ghostSize{};
+    std::array<size_t, 3U> m_atlasCellCount{1U, 1U, 1U};
+    std::array<size_t, 3U> m_atlasSize{};
+    bool m_isValid = false;
+
+    [[nodiscard]] static QVector3D toVector(std::array<size_t, 3U> const &values);
+
+public:
+    BrickLayout() = default;
+    // A layout that fails to fit the volume, even when bricked, is not valid.
+    BrickLayout(std::array<size_t, 3U> const &resolution, size_t const maxTextureSize);
+
+    // Getters
+    [[nodiscard]] bool isValid() const;
+    [[nodiscard]] bool isBricked() const;
+    [[nodiscard]] size_t numberOfBricks() const;
+    [[nodiscard]] std::array<size_t, 3U> const &atlasSize() const;
+
+    // The source region of brick brickIdx includes its ghost voxels inside the volume; those outside stay empty.
+    [[nodiscard]] Brick brick(size_t const brickIdx) const;
+
+    // Shader parameters, see sampleVolume() in the volume rendering fragment shaders.
+    [[nodiscard]] QVector3D brickCount() const;
+    [[nodiscard]] QVector3D brickScale() const;        // Volume coordinate to brick coordinate.
+    [[nodiscard]] QVector3D atlasCellCount() const;
+    [[nodiscard]] QVector3D atlasCellExtent() const;   // Size of one cell, in atlas coordinates.
+    [[nodiscard]] QVector3D atlasGhostOffset() const;  // Offset of a core within its cell, in atlas coordinates.
+    [[nodiscard]] QVector3D atlasCoreExtent() const;   // Size of one core, in atlas coordinates.
+};
+
+#endif // BRICKLAYOUT_H
@@ -0,0 +1,139 @@
+#include "colormapcache.h"
+
+#include "texture.h"
+
+#include <algorithm>
+
+bool ColorMapCache::Key::operator==(Key const &other) const
+{
+    auto const sameColor = [](Color const lhs, Color const rhs)
+    {
+        return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+    };
+
+    return colorMap == other.colorMap && numberOfColors == other.numberOfColors &&
+           std::equal(customColors.cbegin(), customColors.cend(), other.customColors.cbegin(), sameColor);
+}
+
+ColorMapCache::Key ColorMapCache::makeKey(ColorMap const colorMap, size_t const numberOfColors,
+                                          std::array<Color, 3U> const &customColors)
+{
+    Key key{colorMap, numberOfColors, {}};
+    if (colorMap == ColorMap::Custom3Color)
+        key.customColors = customColors;
+
+    return key;
+}
+
+std::vector<Color> ColorMapCache::createColors(ColorMap const colorMap, size_t const numberOfColors,
+                                               std::array<Color, 3U> const &customColors)
+{
+    switch (colorMap)
+    {
+        case ColorMap::Grayscale: return Texture::createGrayscaleTexture(numberOfColors);
+        case ColorMap::Turbo: return Texture::createTurboTexture(numberOfColors);
+        case ColorMap::HeatMap: return Texture::createHeatTexture(numberOfColors);
+        case ColorMap::BlueYellow: return Texture::createBlueYellowTexture(numberOfColors);
+        case ColorMap::Custom3Color:
+            return Texture::createThreeColorTexture(customColors[0], customColors[1], customColors[2], numberOfColors);
+    }
+
+    return {};
+}
+
+ColorMapCache::Entry &ColorMapCache::entry(Key const &key)
+{
+    auto const it = std::find_if(m_entries.begin(), m_entries.end(), [&key](std::unique_ptr<Entry> const &entry)
+    {
+        return entry->key == key;
+    });
+
+    Entry *found = nullptr;
+    if (it != m_entries.end())
+        found = it->get();
+    else
+    {
+        m_entries.push_back(std::make_unique<Entry>());
+        found = m_entries.back().get();
+        found->key = key;
+        found->colors = createColors(key.colorMap, key.numberOfColors, key.customColors);
+    }
+
+    found->lastUse = ++m_uses;
+    dropUnusedEntries();
+    return *found;
+}
+
+// The entry that was just used has the latest use, so it is never the one dropped.
+void ColorMapCache::dropUnusedEntries()
+{
+    while (m_entries.size() > s_maximumEntries)
+    {
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            bool const isSelected = std::find(m_slots.cbegin(), m_slots.cend(), it->get()) != m_slots.cend();
+            if (!isSelected && (oldest == m_entries.end() || (*it)->lastUse < (*oldest)->lastUse))
+                oldest = it;
+        }
+
+        if (oldest == m_entries.end())
+            return;
+
+        if ((*oldest)->texture != 0U)
+            m_texturesToDelete.push_back((*oldest)->texture);
+        m_entries.erase(oldest);
+    }
+}
+
+std::vector<Color> const &ColorMapCache::colors(ColorMap const colorMap, size_t const numberOfColors,
+                                                std::array<Color, 3U> const &customColors)
+{
+    return entry(makeKey(colorMap, numberOfColors, customColors)).colors;
+}
+
+GLuint ColorMapCache::select(QOpenGLFunctions_3_3_Core &gl, Slot const slot, ColorMap const colorMap,
+                             size_t const numberOfColors, std::array<Color, 3U> const &customColors)
+{
+    Entry &selected = entry(makeKey(colorMap, numberOfColors, customColors));
+    m_slots[static_cast<size_t>(slot)] = &selected;
+
+    if (!m_texturesToDelete.empty())
+    {
+        gl.glDeleteTextures(static_cast<GLsizei>(m_texturesToDelete.size()), m_texturesToDelete.data());
+        m_texturesToDelete.clear();
+    }
+
+    if (selected.texture == 0U)
+    {
+        gl.glGenTextures(1, &selected.texture);
+        gl.glBindTexture(GL_TEXTURE_1D, selected.texture);
+        gl.glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl.glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl.glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl.glTexImage1D(GL_TEXTURE_1D,
+                        0,
+                        GL_RGB32F,
+                        static_cast<GLint>(selected.colors.size()),
+                        0,
+                        GL_RGB,
+                        GL_FLOAT,
+                        selected.colors.data());
+    }
+
+    return selected.texture;
+}
+
+void ColorMapCache::destroy(QOpenGLFunctions_3_3_Core &gl)
+{
+    for (std::unique_ptr<Entry> const &entry : m_entries)
+        if (entry->texture != 0U)
+            m_texturesToDelete.push_back(entry->texture);
+
+    if (!m_texturesToDelete.empty())
+        gl.glDeleteTextures(static_cast<GLsizei>(m_texturesToDelete.size()), m_texturesToDelete.data());
+
+    m_texturesToDelete.clear();
+    m_entries.clear();
+    m_slots.fill(nullptr);
+}
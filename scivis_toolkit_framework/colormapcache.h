@@ -0,0 +1,80 @@
+#ifndef COLORMAPCACHE_H
+#define COLORMAPCACHE_H
+
+#include "color.h"
+#include "colormap.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// The color tables of the color maps and their 1D textures, built once per color map, number of colors and (for
+// ColorMap::Custom3Color) custom colors. The QOpenGLWidgets of a window share their contexts, so Visualization and the
+// legends all bind the same texture.
+// Every slot keeps the entry it selected last. The other entries are dropped, least recently used first, once there
+// are more than s_maximumEntries.
+class ColorMapCache
+{
+public:
+    enum class Slot
+    {
+        ScalarData,
+        VectorData
+    };
+
+    static constexpr size_t s_numberOfSlots = 2U;
+    static constexpr size_t s_maximumEntries = 16U;
+
+private:
+    struct Key
+    {
+        ColorMap colorMap;
+        size_t numberOfColors;
+        std::array<Color, 3U> customColors; // Zero unless colorMap is ColorMap::Custom3Color.
+
+        [[nodiscard]] bool operator==(Key const &other) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::vector<Color> colors;
+        GLuint texture = 0U; // Uploaded by the first select.
+        size_t lastUse = 0U;
+    };
+
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::array<Entry const*, s_numberOfSlots> m_slots{};
+    size_t m_uses = 0U;
+    std::vector<GLuint> m_texturesToDelete; // Of dropped entries, deleted once a context is current.
+
+    [[nodiscard]] static Key makeKey(ColorMap const colorMap, size_t const numberOfColors,
+                                     std::array<Color, 3U> const &customColors);
+    [[nodiscard]] Entry &entry(Key const &key);
+    void dropUnusedEntries();
+
+public:
+    ColorMapCache() = default;
+    ColorMapCache(ColorMapCache const&) = delete;
+    ColorMapCache& operator=(ColorMapCache const&) = delete;
+
+    [[nodiscard]] static std::vector<Color> createColors(ColorMap const colorMap, size_t const numberOfColors,
+                                                         std::array<Color, 3U> const &customColors);
+
+    // The table of a color map. The reference stays valid until the next call.
+    [[nodiscard]] std::vector<Color> const &colors(ColorMap const colorMap, size_t const numberOfColors,
+                                                   std::array<Color, 3U> const &customColors);
+
+    // Makes a color map the one of slot and returns its texture, which stays valid until the slot selects another one.
+    // Has to be called with a context of the window current.
+    [[nodiscard]] GLuint select(QOpenGLFunctions_3_3_Core &gl, Slot const slot, ColorMap const colorMap,
+                                size_t const numberOfColors, std::array<Color, 3U> const &customColors);
+
+    // Deletes all textures. Has to be called with a context of the window current.
+    void destroy(QOpenGLFunctions_3_3_Core &gl);
+};
+
+#endif // COLORMAPCACHE_H
@@ -0,0 +1,45 @@
+#include "datarawloader.h"
+
+std::vector<datraw::memory_mapped_file> DataRawLoader::mapTimeSteps(Reader const &reader, size_t const threadCount,
+                                                                   Progress const &progress)
+{
+    std::vector<datraw::memory_mapped_file> timeSteps(reader.info().time_steps());
+    reader.for_each_parallel(
+        threadCount,
+        [&timeSteps](Reader const &timeStepReader, std::uint64_t const timeStep) {
+            datraw::memory_mapped_file &mapping = timeSteps[timeStep];
+            mapping = timeStepReader.map_current();
+
+            std::uint8_t volatile touched = 0U;
+            for (size_t byte = 0U; byte < mapping.size(); byte += 4096U)
+                touched = touched ^ mapping.data()[byte];
+        },
+        progress);
+
+    return timeSteps;
+}
+
+std::vector<datraw::memory_mapped_file> DataRawLoader::mapTimeStepsLazily(Reader const &reader)
+{
+    std::vector<datraw::memory_mapped_file> timeSteps(reader.info().time_steps());
+    reader.for_each_parallel(
+        1U,
+        [&timeSteps](Reader const &timeStepReader, std::uint64_t const timeStep) {
+            timeSteps[timeStep] = timeStepReader.map_current();
+        },
+        [](std::uint64_t, std::uint64_t) {});
+
+    return timeSteps;
+}
+
+std::vector<VolumeOccupancy> DataRawLoader::buildOccupancies(std::vector<datraw::memory_mapped_file> const &timeSteps,
+                                                             std::array<size_t, 3U> const &resolution,
+                                                             size_t const scalarSize, ThreadPool &threadPool)
+{
+    std::vector<VolumeOccupancy> occupancies(timeSteps.size());
+    for (size_t timeStep = 0U; timeStep < timeSteps.size(); ++timeStep)
+        occupancies[timeStep].build(timeSteps[timeStep].data(), timeSteps[timeStep].size(), resolution, scalarSize,
+                                    threadPool);
+
+    return occupancies;
+}
@@ -0,0 +1,39 @@
+#ifndef DATARAWLOADER_H
+#define DATARAWLOADER_H
+
+#include "datraw.h"
+#include "threadpool.h"
+#include "volumeoccupancy.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// The CPU side of loading the time steps of a .dat file for the volume rendering, without any OpenGL, so it can also
+// run in the benchmarks.
+class DataRawLoader
+{
+public:
+    using Reader = datraw::raw_reader<char>;
+    using Progress = std::function<void(std::uint64_t const completedTimeSteps, std::uint64_t const numberOfTimeSteps)>;
+
+    // Maps every time step instead of reading it. The pages are loaded once for the occupancy ranges and again when
+    // the streamer prefetches the time step; the operating system can drop them in between.
+    // The first load touches one byte per page on threadCount threads at once, which keeps several raw files in flight
+    // instead of faulting them in one after the other.
+    [[nodiscard]] static std::vector<datraw::memory_mapped_file> mapTimeSteps(Reader const &reader,
+                                                                             size_t const threadCount,
+                                                                             Progress const &progress);
+
+    // Maps every time step without touching its pages, for readers that only visit parts of the volume.
+    [[nodiscard]] static std::vector<datraw::memory_mapped_file> mapTimeStepsLazily(Reader const &reader);
+
+    // The value ranges per cell of every time step.
+    [[nodiscard]] static std::vector<VolumeOccupancy> buildOccupancies(
+            std::vector<datraw::memory_mapped_file> const &timeSteps, std::array<size_t, 3U> const &resolution,
+            size_t const scalarSize, ThreadPool &threadPool);
+};
+
+#endif // DATARAWLOADER_H
@@ -7,7 +7,11 @@ enum class ScalarDataType
     VelocityMagnitude,
     ForceFieldMagnitude,
     VelocityDivergence,
-    ForceFieldDivergence
+    ForceFieldDivergence,
+    // Computed by the simulation from the velocity spectrum, see SpectralDerivatives, and only while selected.
+    Vorticity,
+    UnprojectedVelocityDivergence,
+    QCriterion
 };
 
 enum class VectorDataType
@@ -16,4 +20,11 @@ enum class VectorDataType
     ForceField
 };
 
+// Storage of the density and force fields of the published simulation frames. The solver always computes in float.
+enum class FieldPrecision
+{
+    Float32,
+    Float16
+};
+
 #endif // DATATYPE_H
@@ -9,6 +9,7 @@
 #include <cassert>
 #include <cinttypes>
 #include <cstddef>
+#include <cstring>
 #include <limits>
 
 
@@ -60,6 +61,50 @@ namespace datraw {
         convert<typename O::value_type>(begin, end, dst);
     }
 
+namespace detail {
+
+    /// <summary>
+    /// Reverse the order of the bytes of <paramref name="value" />.
+    /// </summary>
+    /// <param name="value">The number to be converted.</param>
+    /// <returns>The number with its bytes in reverse order.</returns>
+    inline std::uint16_t reverse_bytes(const std::uint16_t value);
+
+    /// <summary>
+    /// Reverse the order of the bytes of <paramref name="value" />.
+    /// </summary>
+    /// <param name="value">The number to be converted.</param>
+    /// <returns>The number with its bytes in reverse order.</returns>
+    inline std::uint32_t reverse_bytes(const std::uint32_t value);
+
+    /// <summary>
+    /// Reverse the order of the bytes of <paramref name="value" />.
+    /// </summary>
+    /// <param name="value">The number to be converted.</param>
+    /// <returns>The number with its bytes in reverse order.</returns>
+    inline std::uint64_t reverse_bytes(const std::uint64_t value);
+
+    /// <summary>
+    /// Reverse the byte order of <paramref name="cnt" /> numbers of type
+    /// <tparamref name="T" /> in place.
+    /// </summary>
+    /// <remarks>
+    /// <para>The numbers are copied in and out of the buffer, so
+    /// <paramref name="data" /> need not be aligned for
+    /// <tparamref name="T" />, eg after a data offset. The loop has no
+    /// dependencies between its iterations, which allows the compiler to
+    /// vectorise it into byte shuffles.</para>
+    /// </remarks>
+    /// <tparam name="T">An unsigned integral type of 2, 4 or 8 bytes.
+    /// </tparam>
+    /// <param name="data">A pointer to the data to be converted.</param>
+    /// <param name="cnt">The number of numbers designated by
+    /// <paramref name="data" />.</param>
+    template<class T>
+    inline void reverse_bytes(void *data, const size_t cnt);
+
+} /* end namespace detail */
+
     /// <summary>
     /// Convert the byte order of <paramref name="cnt" /> numbers with a width
     /// of <tparamref name="T" /> bytes.
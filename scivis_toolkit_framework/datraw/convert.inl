@@ -74,23 +74,65 @@ void datraw::convert(I begin, I end , O dst) {
 }
 
 
+/*
+ * datraw::detail::reverse_bytes
+ */
+std::uint16_t datraw::detail::reverse_bytes(const std::uint16_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap16(value);
+#else /* defined(__GNUC__) || defined(__clang__) */
+    return static_cast<std::uint16_t>((value >> 0x08) | (value << 0x08));
+#endif /* defined(__GNUC__) || defined(__clang__) */
+}
+
+
+/*
+ * datraw::detail::reverse_bytes
+ */
+std::uint32_t datraw::detail::reverse_bytes(const std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(value);
+#else /* defined(__GNUC__) || defined(__clang__) */
+    return ((value & 0x000000FF) << 0x18) | ((value & 0x0000FF00) << 0x08)
+        | ((value & 0x00FF0000) >> 0x08) | ((value & 0xFF000000) >> 0x18);
+#endif /* defined(__GNUC__) || defined(__clang__) */
+}
+
+
+/*
+ * datraw::detail::reverse_bytes
+ */
+std::uint64_t datraw::detail::reverse_bytes(const std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#else /* defined(__GNUC__) || defined(__clang__) */
+    return (static_cast<std::uint64_t>(reverse_bytes(
+        static_cast<std::uint32_t>(value))) << 0x20)
+        | reverse_bytes(static_cast<std::uint32_t>(value >> 0x20));
+#endif /* defined(__GNUC__) || defined(__clang__) */
+}
+
+
+/*
+ * datraw::detail::reverse_bytes
+ */
+template<class T>
+void datraw::detail::reverse_bytes(void *data, const size_t cnt) {
+    auto bytes = static_cast<std::uint8_t *>(data);
+    for (size_t i = 0; i < cnt; ++i, bytes += sizeof(T)) {
+        T v;
+        std::memcpy(&v, bytes, sizeof(T));
+        v = reverse_bytes(v);
+        std::memcpy(bytes, &v, sizeof(T));
+    }
+}
+
+
 /*
  * datraw::swap_byte_order
  */
 template<> void datraw::swap_byte_order<8>(void *data, const size_t cnt) {
-    auto idata = static_cast<std::uint64_t *>(data);
-    for (size_t i = 0; i < cnt; i++) {
-        auto v = idata[i];
-        auto sv = (v & 0x00000000000000FFULL);
-        sv = ((v & 0x000000000000FF00ULL) >> 0x08) | (sv << 0x08);
-        sv = ((v & 0x0000000000FF0000ULL) >> 0x10) | (sv << 0x08);
-        sv = ((v & 0x00000000FF000000ULL) >> 0x18) | (sv << 0x08);
-        sv = ((v & 0x000000FF00000000ULL) >> 0x20) | (sv << 0x08);
-        sv = ((v & 0x0000FF0000000000ULL) >> 0x28) | (sv << 0x08);
-        sv = ((v & 0x00FF000000000000ULL) >> 0x30) | (sv << 0x08);
-        sv = ((v & 0xFF00000000000000ULL) >> 0x38) | (sv << 0x08);
-        idata[i] = sv;
-    }
+    detail::reverse_bytes<std::uint64_t>(data, cnt);
 }
 
 
@@ -98,16 +140,7 @@ template<> void datraw::swap_byte_order<8>(void *data, const size_t cnt) {
  * datraw::swap_byte_order
  */
 template<> void datraw::swap_byte_order<4>(void *data, const size_t cnt) {
-    auto idata = static_cast<std::uint32_t *>(data);
-    for (size_t i = 0; i < cnt; i++) {
-        auto v = idata[i];
-        auto sv = (v & 0x000000FF);
-        sv = ((v & 0x0000FF00) >> 0x08) | (sv << 0x08);
-        sv = ((v & 0x00FF0000) >> 0x10) | (sv << 0x08);
-        sv = ((v & 0xFF000000) >> 0x18) | (sv << 0x08);
-        idata[i] = sv;
-        idata[i] = sv;
-    }
+    detail::reverse_bytes<std::uint32_t>(data, cnt);
 }
 
 
@@ -115,13 +148,7 @@ template<> void datraw::swap_byte_order<4>(void *data, const size_t cnt) {
  * datraw::swap_byte_order
  */
 template<> void datraw::swap_byte_order<2>(void *data, const size_t cnt) {
-    auto idata = static_cast<std::uint16_t *>(data);
-    for (size_t i = 0; i < cnt; i++) {
-        auto v = idata[i];
-        auto sv = (v & 0x00FF);
-        sv = ((v & 0xFF00) >> 0x08) | (sv << 0x08);
-        idata[i] = sv;
-    }
+    detail::reverse_bytes<std::uint16_t>(data, cnt);
 }
 
 
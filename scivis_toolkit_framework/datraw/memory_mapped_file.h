@@ -0,0 +1,186 @@
+/// <summary>
+/// Memory mapping of raw files.
+/// </summary>
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif /* NOMINMAX */
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif /* WIN32_LEAN_AND_MEAN */
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "datraw/string.h"
+#include "datraw/types.h"
+
+
+namespace datraw {
+
+    /// <summary>
+    /// A file mapped into memory as a whole, of which the bytes from a given
+    /// offset onwards are exposed.
+    /// </summary>
+    /// <remarks>
+    /// <para>Nothing is read when the file is mapped. The operating system
+    /// loads the pages on first access and may drop them again under memory
+    /// pressure, so the data never need to be resident as a whole.</para>
+    /// <para>A read-only mapping shares the pages with the file cache. A
+    /// copy-on-write mapping can be modified, and every modified page becomes
+    /// a private copy; the file itself is never changed.</para>
+    /// </remarks>
+    class memory_mapped_file {
+
+    public:
+
+        /// <summary>
+        /// The type to express file sizes.
+        /// </summary>
+        typedef std::size_t size_type;
+
+        /// <summary>
+        /// The possible ways of accessing the mapped memory.
+        /// </summary>
+        enum class access {
+            read_only,
+            copy_on_write
+        };
+
+        /// <summary>
+        /// Map the file at <paramref name="path" /> into memory.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <param name="offset">The offset in bytes of the first byte that
+        /// is exposed by <see cref="data" />.</param>
+        /// <param name="mode">The access to the mapped memory.</param>
+        /// <returns>The mapping of the file.</returns>
+        /// <exception cref="std::invalid_argument">If the file could not be
+        /// opened, or if <paramref name="offset" /> is not smaller than the
+        /// size of the file.</exception>
+        /// <exception cref="std::runtime_error">If the file could not be
+        /// mapped into memory.</exception>
+        template<class C>
+        static memory_mapped_file open(const std::basic_string<C>& path,
+            const size_type offset, const access mode);
+
+        /// <summary>
+        /// Initialises a new instance that does not map any file.
+        /// </summary>
+        inline memory_mapped_file(void) noexcept
+            : base(nullptr), mappedSize(0), offset(0) { }
+
+        memory_mapped_file(const memory_mapped_file&) = delete;
+
+        /// <summary>
+        /// Move the mapping of <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline memory_mapped_file(memory_mapped_file&& rhs) noexcept
+                : base(rhs.base), mappedSize(rhs.mappedSize),
+                offset(rhs.offset) {
+            rhs.base = nullptr;
+            rhs.mappedSize = 0;
+            rhs.offset = 0;
+        }
+
+        /// <summary>
+        /// Unmaps the file.
+        /// </summary>
+        inline ~memory_mapped_file(void) {
+            this->close();
+        }
+
+        memory_mapped_file& operator =(const memory_mapped_file&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        /// <returns><c>*this</c></returns>
+        memory_mapped_file& operator =(memory_mapped_file&& rhs) noexcept;
+
+        /// <summary>
+        /// Unmaps the file, if any.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer the first exposed byte.
+        /// </summary>
+        /// <returns>A pointer to <see cref="size" /> bytes, or <c>nullptr</c>
+        /// if no file is mapped.</returns>
+        inline const datraw::uint8 *data(void) const {
+            return (this->base != nullptr)
+                ? static_cast<const datraw::uint8 *>(this->base) + this->offset
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Answer the first exposed byte.
+        /// </summary>
+        /// <remarks>
+        /// The memory must only be written if the file has been mapped with
+        /// <see cref="access::copy_on_write" />.
+        /// </remarks>
+        /// <returns>A pointer to <see cref="size" /> bytes, or <c>nullptr</c>
+        /// if no file is mapped.</returns>
+        inline datraw::uint8 *data(void) {
+            return (this->base != nullptr)
+                ? static_cast<datraw::uint8 *>(this->base) + this->offset
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Answer the number of exposed bytes, ie the size of the file minus
+        /// the offset.
+        /// </summary>
+        /// <returns>The number of bytes from <see cref="data" /> onwards.
+        /// </returns>
+        inline size_type size(void) const {
+            return this->mappedSize - this->offset;
+        }
+
+        /// <summary>
+        /// Answer whether a file is mapped.
+        /// </summary>
+        /// <returns><c>true</c> if a file is mapped, <c>false</c> otherwise.
+        /// </returns>
+        inline operator bool(void) const {
+            return (this->base != nullptr);
+        }
+
+    private:
+
+        /// <summary>
+        /// The start of the mapping, which is the start of the file.
+        /// </summary>
+        void *base;
+
+        /// <summary>
+        /// The size of the mapping in bytes, which is the size of the file.
+        /// </summary>
+        size_type mappedSize;
+
+        /// <summary>
+        /// The offset of the first exposed byte.
+        /// </summary>
+        size_type offset;
+    };
+
+} /* end namespace datraw */
+
+#include "datraw/memory_mapped_file.inl"
@@ -0,0 +1,149 @@
+/// <summary>
+/// Memory mapping of raw files.
+/// </summary>
+
+
+/*
+ * datraw::memory_mapped_file::open
+ */
+template<class C>
+datraw::memory_mapped_file datraw::memory_mapped_file::open(
+        const std::basic_string<C>& path, const size_type offset,
+        const access mode) {
+    memory_mapped_file retval;
+
+#if defined(_WIN32)
+    auto hFile = ::CreateFileW(detail::widen_string(path).c_str(),
+        GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be opened." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(hFile, &fileSize)) {
+        ::CloseHandle(hFile);
+        std::stringstream msg;
+        msg << "The size of the raw file \"" << detail::narrow_string(path)
+            << "\" could not be determined." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+    auto size = static_cast<size_type>(fileSize.QuadPart);
+
+#else /* defined(_WIN32) */
+    auto hFile = ::open(detail::narrow_string(path).c_str(), O_RDONLY);
+    if (hFile == -1) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be opened." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+
+    struct stat fileStat;
+    if (::fstat(hFile, &fileStat) != 0) {
+        ::close(hFile);
+        std::stringstream msg;
+        msg << "The size of the raw file \"" << detail::narrow_string(path)
+            << "\" could not be determined." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+    auto size = static_cast<size_type>(fileStat.st_size);
+#endif /* defined(_WIN32) */
+
+    // Check the data offset before mapping anything.
+    if (offset >= size) {
+#if defined(_WIN32)
+        ::CloseHandle(hFile);
+#else /* defined(_WIN32) */
+        ::close(hFile);
+#endif /* defined(_WIN32) */
+        std::stringstream msg;
+        msg << "The data offset " << offset << " is larger than the total "
+            << size << " byte(s) in \"" << detail::narrow_string(path)
+            << "\"." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+
+    // Map the whole file. The mapping keeps the file open, so the handles
+    // are not needed any more afterwards.
+#if defined(_WIN32)
+    auto hMapping = ::CreateFileMappingW(hFile, nullptr,
+        (mode == access::copy_on_write) ? PAGE_WRITECOPY : PAGE_READONLY,
+        0, 0, nullptr);
+    ::CloseHandle(hFile);
+    if (hMapping == nullptr) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be mapped into memory (error "
+            << ::GetLastError() << ")." << std::ends;
+        throw std::runtime_error(msg.str());
+    }
+
+    retval.base = ::MapViewOfFile(hMapping,
+        (mode == access::copy_on_write) ? FILE_MAP_COPY : FILE_MAP_READ,
+        0, 0, 0);
+    ::CloseHandle(hMapping);
+    if (retval.base == nullptr) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be mapped into memory (error "
+            << ::GetLastError() << ")." << std::ends;
+        throw std::runtime_error(msg.str());
+    }
+
+#else /* defined(_WIN32) */
+    auto base = (mode == access::copy_on_write)
+        ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, hFile, 0)
+        : ::mmap(nullptr, size, PROT_READ, MAP_SHARED, hFile, 0);
+    ::close(hFile);
+    if (base == MAP_FAILED) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be mapped into memory." << std::ends;
+        throw std::runtime_error(msg.str());
+    }
+    retval.base = base;
+#endif /* defined(_WIN32) */
+
+    retval.mappedSize = size;
+    retval.offset = offset;
+    return retval;
+}
+
+
+/*
+ * datraw::memory_mapped_file::operator =
+ */
+inline datraw::memory_mapped_file& datraw::memory_mapped_file::operator =(
+        memory_mapped_file&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->close();
+        this->base = rhs.base;
+        this->mappedSize = rhs.mappedSize;
+        this->offset = rhs.offset;
+        rhs.base = nullptr;
+        rhs.mappedSize = 0;
+        rhs.offset = 0;
+    }
+    return *this;
+}
+
+
+/*
+ * datraw::memory_mapped_file::close
+ */
+inline void datraw::memory_mapped_file::close(void) noexcept {
+    if (this->base != nullptr) {
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->base);
+#else /* defined(_WIN32) */
+        ::munmap(this->base, this->mappedSize);
+#endif /* defined(_WIN32) */
+        this->base = nullptr;
+        this->mappedSize = 0;
+        this->offset = 0;
+    }
+}
@@ -5,11 +5,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "datraw/convert.h"
 #include "datraw/info.h"
+#include "datraw/memory_mapped_file.h"
 
 
 namespace datraw {
@@ -141,6 +149,22 @@ namespace datraw {
             return static_cast<bool>(*this);
         }
 
+        /// <summary>
+        /// Answer the size of the current time step in bytes.
+        /// </summary>
+        /// <remarks>
+        /// <para>For Cartesian grids of a known format, the size follows from
+        /// the dat file and no raw file is opened. Otherwise, it is the size
+        /// of the raw file without the data offset.</para>
+        /// </remarks>
+        /// <returns>The size of the time step in bytes.</returns>
+        /// <exception cref="std::range_error">If the time series has been
+        /// completely read, ie the current time step is invalid.</exception>
+        /// <exception cref="std::invalid_argument">If the size has to be
+        /// determined from the raw file, but it could not be opened.
+        /// </exception>
+        size_type size_current(void) const;
+
         /// <summary>
         /// Read the content of the current time step and store it to
         /// <paramref name="dst" /> provided the buffer size
@@ -150,6 +174,14 @@ namespace datraw {
         /// <para>The method will swap the byte order as necessary, ie it is
         /// guaranteed that the data returned match the byte order of the
         /// system.</para>
+        /// <para>The raw file is opened once and read unbuffered with a
+        /// single read straight into <paramref name="dst" />, which may
+        /// therefore also be a mapped buffer object of the GPU. The byte
+        /// order is swapped in place afterwards.</para>
+        /// <para>If the size of the time step is known from the dat file (see
+        /// <see cref="size_current" />), asking for it by passing
+        /// <c>nullptr</c> does not open the raw file at all, and a raw file
+        /// that is too small for it is an error.</para>
         /// </remarks>
         /// <param name="dst">Pointer to <paramref name="cntDst" /> bytes of
         /// memory where the raw data can be stored. Nothing will be written if
@@ -183,11 +215,85 @@ namespace datraw {
         /// </exception>
         inline std::vector<datraw::uint8> read_current(void) const {
             std::vector<datraw::uint8> retval;
-            retval.resize(this->read_current(nullptr, 0));
+            retval.resize(this->size_current());
             this->read_current(retval.data(), retval.size());
             return retval;
         }
 
+        /// <summary>
+        /// Map the raw file of the current time step into memory instead of
+        /// reading it.
+        /// </summary>
+        /// <remarks>
+        /// <para>The returned mapping exposes the data from the data offset
+        /// onwards. Nothing is read until the memory is accessed, and the
+        /// pages are shared with the file cache of the operating system, ie
+        /// the data are not copied.</para>
+        /// <para>If the byte order of the file does not match the one of the
+        /// system, the file is mapped copy-on-write and swapped in place. The
+        /// data returned therefore always match the byte order of the system,
+        /// but in this case, all pages are touched and copied.</para>
+        /// </remarks>
+        /// <returns>The mapping of the current time step.</returns>
+        /// <exception cref="std::range_error">If the time series has been
+        /// completely read, ie the current time step is invalid.</exception>
+        /// <exception cref="std::invalid_argument">If the path of the current
+        /// time step was invalid, ie the raw file could not be opened.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the raw file could not be
+        /// mapped into memory.</exception>
+        memory_mapped_file map_current(void) const;
+
+        /// <summary>
+        /// Invoke <paramref name="func" /> for every time step, running up to
+        /// <paramref name="cntThreads" /> of them concurrently.
+        /// </summary>
+        /// <remarks>
+        /// <para>Every thread works on its own copy of the reader, which is
+        /// moved to the time step before it is passed to
+        /// <paramref name="func" />. The time steps are handed out in
+        /// ascending order, so the threads keep several raw files in flight
+        /// at a time, which a single sequential stream cannot do.</para>
+        /// <para><paramref name="progress" /> is invoked on the calling thread
+        /// whenever time steps have been completed, so it may update a user
+        /// interface. The current time step of this reader is not changed.
+        /// </para>
+        /// </remarks>
+        /// <param name="cntThreads">The maximum number of threads, which is
+        /// limited to the number of time steps. At least one is used.</param>
+        /// <param name="func">A callable taking a <c>const raw_reader&</c>
+        /// positioned at the time step and the time step itself.</param>
+        /// <param name="progress">A callable taking the number of completed
+        /// and the total number of time steps.</param>
+        /// <exception cref="std::exception">The first exception thrown by
+        /// <paramref name="func" /> is rethrown once all threads finished.
+        /// The remaining time steps are skipped in this case.</exception>
+        template<class F, class P>
+        void for_each_parallel(const std::size_t cntThreads, F&& func,
+            P&& progress) const;
+
+        /// <summary>
+        /// Read all time steps concurrently, time step <c>i</c> into the slice
+        /// of <paramref name="cntSlice" /> bytes at
+        /// <c>dst + i * cntSlice</c>.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is <see cref="read_current" /> on every time step, see
+        /// <see cref="for_each_parallel" /> for the threads and
+        /// <paramref name="progress" />.</para>
+        /// </remarks>
+        /// <param name="dst">Pointer to <c>info().time_steps()</c> slices of
+        /// <paramref name="cntSlice" /> bytes each.</param>
+        /// <param name="cntSlice">The size of a slice in bytes.</param>
+        /// <param name="cntThreads">The maximum number of threads.</param>
+        /// <param name="progress">A callable taking the number of completed
+        /// and the total number of time steps.</param>
+        /// <exception cref="std::invalid_argument">If a time step does not
+        /// fit into its slice or its raw file could not be read.</exception>
+        template<class P>
+        void read_parallel(void *dst, const size_type cntSlice,
+            const std::size_t cntThreads, P&& progress) const;
+
         /// <summary>
         /// Advance to the next time step and store the raw file in a new
         /// <see cref="std::vector" />.
@@ -223,6 +329,27 @@ namespace datraw {
 
     private:
 
+        /// <summary>
+        /// Answer the size of a time step in bytes according to the dat file.
+        /// </summary>
+        /// <returns>The size of a time step, or 0 if it cannot be derived from
+        /// the dat file, eg for grids other than Cartesian ones.</returns>
+        size_type expected_size(void) const;
+
+        /// <summary>
+        /// Open the raw file of the current time step.
+        /// </summary>
+        /// <param name="path">Receives the path of the raw file.</param>
+        /// <param name="stream">The stream to open, which is unbuffered and
+        /// positioned at the end of the file afterwards.</param>
+        /// <returns>The size of the time step in the file, ie the size of the
+        /// file without the data offset.</returns>
+        /// <exception cref="std::range_error">If the time series has been
+        /// completely read, ie the current time step is invalid.</exception>
+        /// <exception cref="std::invalid_argument">If the raw file could not
+        /// be opened or is not larger than the data offset.</exception>
+        size_type open_current(string_type& path, ifstream_type& stream) const;
+
         /// <summary>
         /// Stores the current time step.
         /// </summary>
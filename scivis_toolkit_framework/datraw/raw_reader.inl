@@ -4,6 +4,27 @@
 /// <author>Christoph Muller</author>
 
 
+/*
+ * datraw::raw_reader<C>::size_current
+ */
+template<class C>
+typename datraw::raw_reader<C>::size_type datraw::raw_reader<C>::size_current(
+        void) const {
+    if (this->curTimeStep >= this->datInfo.time_steps()) {
+        throw std::range_error("All time steps have been consumed already.");
+    }
+
+    auto retval = this->expected_size();
+    if (retval == 0) {
+        string_type path;
+        ifstream_type stream;
+        retval = this->open_current(path, stream);
+    }
+
+    return retval;
+}
+
+
 /*
  * datraw::raw_reader<C>::read_current
  */
@@ -14,40 +35,40 @@ typename datraw::raw_reader<C>::size_type datraw::raw_reader<C>::read_current(
         throw std::range_error("All time steps have been consumed already.");
     }
 
-    // Compute the path to the current time step.
-    auto path = this->datInfo.multi_file_name(this->curTimeStep);
-    path = this->datInfo.evaluate_path(path);
+    // Answer the size from the dat file without touching the raw file if
+    // nothing can be read anyway.
+    auto retval = this->expected_size();
+    if ((retval != 0) && ((dst == nullptr) || (cntDst < retval))) {
+        return retval;
+    }
 
-    // Get the required buffer size.
-    ifstream_type stream(path, ifstream_type::ate | ifstream_type::binary);
-    if (!stream.good()) {
+    string_type path;
+    ifstream_type stream;
+    auto fileSize = this->open_current(path, stream);
+    if (retval == 0) {
+        retval = fileSize;
+
+    } else if (fileSize < retval) {
         std::stringstream msg;
         msg << "The raw file \"" << detail::narrow_string(path)
-            << "\" could not be opened." << std::ends;
+            << "\" contains " << fileSize << " byte(s) after the data offset, "
+            << "but the dat file describes " << retval << " byte(s)."
+            << std::ends;
         throw std::invalid_argument(msg.str());
     }
-    auto retval = static_cast<size_t>(stream.tellg());
-
-    // Check and account for the data offset.
-    auto offset = this->datInfo.data_offset();
-    if (offset >= retval) {
-        std::stringstream msg;
-        msg << "The data offset " << offset << " is larger than the total "
-            << retval << " byte(s) in \"" << detail::narrow_string(path)
-            << "\"." << std::ends;
-        throw std::invalid_argument(msg.str());
-
-    } else {
-        retval -= static_cast<std::size_t>(offset);
-    }
-
-    // TODO: for cartesian and rectilinear grids, we could check the expected
-    // size of the data here.
 
     // Read the data if possible.
     if ((dst != nullptr) && (cntDst >= retval)) {
+        auto offset = this->datInfo.data_offset();
         stream.seekg(offset, ifstream_type::beg);
-        stream.read(static_cast<char *>(dst), cntDst);
+        stream.read(static_cast<char *>(dst),
+            static_cast<std::streamsize>(retval));
+        if (static_cast<size_type>(stream.gcount()) != retval) {
+            std::stringstream msg;
+            msg << "Reading " << retval << " byte(s) from the raw file \""
+                << detail::narrow_string(path) << "\" failed." << std::ends;
+            throw std::invalid_argument(msg.str());
+        }
 
         if (this->datInfo.requires_byte_swap()) {
             assert(this->datInfo.format() != scalar_type::raw);
@@ -70,6 +91,140 @@ typename datraw::raw_reader<C>::size_type datraw::raw_reader<C>::read_current(
 }
 
 
+/*
+ * datraw::raw_reader<C>::map_current
+ */
+template<class C>
+datraw::memory_mapped_file datraw::raw_reader<C>::map_current(void) const {
+    if (this->curTimeStep >= this->datInfo.time_steps()) {
+        throw std::range_error("All time steps have been consumed already.");
+    }
+
+    // Compute the path to the current time step.
+    auto path = this->datInfo.multi_file_name(this->curTimeStep);
+    path = this->datInfo.evaluate_path(path);
+
+    auto offset = static_cast<size_type>(this->datInfo.data_offset());
+
+    if (this->datInfo.requires_byte_swap()) {
+        assert(this->datInfo.format() != scalar_type::raw);
+        auto retval = memory_mapped_file::open(path, offset,
+            memory_mapped_file::access::copy_on_write);
+        auto ss = this->datInfo.scalar_size();
+        if ((retval.size() % ss) != 0) {
+            std::stringstream msg;
+            msg << "The raw file \"" << detail::narrow_string(path)
+                << "\" contains " << retval.size() << " bytes, which is not "
+                << "divisible by the size of a scalar (" << ss << ")."
+                << std::ends;
+            throw std::invalid_argument(msg.str());
+        }
+
+        datraw::swap_byte_order(ss, retval.data(), retval.size() / ss);
+        return retval;
+
+    } else {
+        return memory_mapped_file::open(path, offset,
+            memory_mapped_file::access::read_only);
+    }
+}
+
+/*
+ * datraw::raw_reader<C>::for_each_parallel
+ */
+template<class C>
+template<class F, class P>
+void datraw::raw_reader<C>::for_each_parallel(const std::size_t cntThreads,
+        F&& func, P&& progress) const {
+    const auto cntTimeSteps = this->datInfo.time_steps();
+    std::atomic<time_step_type> next(0);
+    std::mutex lock;
+    std::condition_variable completed;
+    time_step_type cntCompleted = 0;
+    std::exception_ptr error;
+
+    auto worker = [&, this](void) {
+        raw_reader reader(*this);
+        for (auto t = next++; t < cntTimeSteps; t = next++) {
+            try {
+                reader.move_to(t);
+                func(static_cast<const raw_reader&>(reader), t);
+            } catch (...) {
+                std::lock_guard<std::mutex> l(lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = cntTimeSteps;    // Skip whatever has not started yet.
+            }
+
+            {
+                std::lock_guard<std::mutex> l(lock);
+                ++cntCompleted;
+            }
+            completed.notify_one();
+        }
+    };
+
+    const auto cnt = static_cast<std::size_t>(std::min<time_step_type>(
+        std::max<std::size_t>(cntThreads, 1), std::max<time_step_type>(
+        cntTimeSteps, 1)));
+    std::vector<std::thread> threads;
+    threads.reserve(cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    // Report on this thread until every time step has been completed or
+    // skipped, ie until every worker has run out of time steps.
+    {
+        std::unique_lock<std::mutex> l(lock);
+        time_step_type cntReported = 0;
+        while (!error && (cntReported < cntTimeSteps)) {
+            completed.wait(l, [&](void) {
+                return (error || (cntCompleted > cntReported));
+            });
+            if (!error) {
+                cntReported = cntCompleted;
+                l.unlock();
+                progress(cntReported, cntTimeSteps);
+                l.lock();
+            }
+        }
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+/*
+ * datraw::raw_reader<C>::read_parallel
+ */
+template<class C>
+template<class P>
+void datraw::raw_reader<C>::read_parallel(void *dst, const size_type cntSlice,
+        const std::size_t cntThreads, P&& progress) const {
+    auto slices = static_cast<datraw::uint8 *>(dst);
+    this->for_each_parallel(cntThreads, [slices, cntSlice](
+            const raw_reader& reader, const time_step_type timeStep) {
+        auto slice = slices + static_cast<size_type>(timeStep) * cntSlice;
+        auto size = reader.read_current(slice, cntSlice);
+        if (size > cntSlice) {
+            std::stringstream msg;
+            msg << "Time step " << timeStep << " holds " << size
+                << " byte(s), which do not fit into a slice of " << cntSlice
+                << " byte(s)." << std::ends;
+            throw std::invalid_argument(msg.str());
+        }
+    }, std::forward<P>(progress));
+}
+
+
 /*
  * datraw::raw_reader<C>::read_next
  */
@@ -82,3 +237,68 @@ std::vector<datraw::uint8> datraw::raw_reader<C>::read_next(void) const {
         return EMPTY;
     }
 }
+
+
+/*
+ * datraw::raw_reader<C>::expected_size
+ */
+template<class C>
+typename datraw::raw_reader<C>::size_type
+datraw::raw_reader<C>::expected_size(void) const {
+    try {
+        if (this->datInfo.grid_type() != grid_type::cartesian) {
+            return 0;
+        }
+
+        size_type retval = this->datInfo.scalar_size()
+            * this->datInfo.components();
+        for (auto r : this->datInfo.resolution()) {
+            retval *= r;
+        }
+        return retval;
+
+    } catch (...) {
+        // Any missing property makes the size unknown.
+        return 0;
+    }
+}
+
+
+/*
+ * datraw::raw_reader<C>::open_current
+ */
+template<class C>
+typename datraw::raw_reader<C>::size_type datraw::raw_reader<C>::open_current(
+        string_type& path, ifstream_type& stream) const {
+    if (this->curTimeStep >= this->datInfo.time_steps()) {
+        throw std::range_error("All time steps have been consumed already.");
+    }
+
+    // Compute the path to the current time step.
+    path = this->datInfo.multi_file_name(this->curTimeStep);
+    path = this->datInfo.evaluate_path(path);
+
+    // The data are read in one go into the caller's buffer, so a buffer of
+    // the stream would only add a copy. This must precede opening the file.
+    stream.rdbuf()->pubsetbuf(nullptr, 0);
+    stream.open(path, ifstream_type::ate | ifstream_type::binary);
+    if (!stream.good()) {
+        std::stringstream msg;
+        msg << "The raw file \"" << detail::narrow_string(path)
+            << "\" could not be opened." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+    auto retval = static_cast<size_type>(stream.tellg());
+
+    // Check and account for the data offset.
+    auto offset = this->datInfo.data_offset();
+    if (offset >= retval) {
+        std::stringstream msg;
+        msg << "The data offset " << offset << " is larger than the total "
+            << retval << " byte(s) in \"" << detail::narrow_string(path)
+            << "\"." << std::ends;
+        throw std::invalid_argument(msg.str());
+    }
+
+    return retval - static_cast<size_type>(offset);
+}
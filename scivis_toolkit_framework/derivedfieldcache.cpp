@@ -0,0 +1,190 @@
+#include "derivedfieldcache.h"
+
+#include "simulationframe.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<float> const &DerivedFieldCache::scalarField(ScalarDataType const type, SimulationFrame const &frame)
+{
+    // The density is stored in the frame itself.
+    if (type == ScalarDataType::Density)
+        return decoded(frame.density(), frame.densityHalf(), frame, m_density);
+
+    Entry &entry = m_scalarFields[type];
+    if (entry.frameNumber == frame.frameNumber())
+        return entry.values;
+
+    switch (type)
+    {
+        case ScalarDataType::Density:
+        break;
+
+        case ScalarDataType::VelocityMagnitude:
+            computeMagnitude(frame.velocityX(), frame.velocityY(), entry.values);
+        break;
+
+        case ScalarDataType::ForceFieldMagnitude:
+            computeMagnitude(vectorX(VectorDataType::ForceField, frame), vectorY(VectorDataType::ForceField, frame),
+                             entry.values);
+        break;
+
+        case ScalarDataType::VelocityDivergence:
+            computeDivergence(frame.velocityX(), frame.velocityY(), frame.DIMX(), frame.DIMY(), entry.values);
+        break;
+
+        case ScalarDataType::ForceFieldDivergence:
+            computeDivergence(vectorX(VectorDataType::ForceField, frame), vectorY(VectorDataType::ForceField, frame),
+                              frame.DIMX(), frame.DIMY(), entry.values);
+        break;
+
+        case ScalarDataType::Vorticity:
+            scaleSpectralField(frame.vorticity(), 1.0F, frame, entry.values);
+        break;
+
+        case ScalarDataType::UnprojectedVelocityDivergence:
+            scaleSpectralField(frame.unprojectedDivergence(), 1.0F, frame, entry.values);
+        break;
+
+        case ScalarDataType::QCriterion:
+            scaleSpectralField(frame.qCriterion(), 2.0F, frame, entry.values);
+        break;
+    }
+
+    entry.frameNumber = frame.frameNumber();
+    return entry.values;
+}
+
+std::vector<float> const &DerivedFieldCache::vectorMagnitude(VectorDataType const type, SimulationFrame const &frame)
+{
+    switch (type)
+    {
+        case VectorDataType::Velocity:
+            return scalarField(ScalarDataType::VelocityMagnitude, frame);
+
+        case VectorDataType::ForceField:
+            return scalarField(ScalarDataType::ForceFieldMagnitude, frame);
+    }
+
+    return scalarField(ScalarDataType::VelocityMagnitude, frame);
+}
+
+std::vector<float> const &DerivedFieldCache::vectorX(VectorDataType const type, SimulationFrame const &frame)
+{
+    switch (type)
+    {
+        case VectorDataType::Velocity:
+            return frame.velocityX();
+
+        case VectorDataType::ForceField:
+            return decoded(frame.forceFieldX(), frame.forceFieldXHalf(), frame, m_forceFieldX);
+    }
+
+    return frame.velocityX();
+}
+
+std::vector<float> const &DerivedFieldCache::vectorY(VectorDataType const type, SimulationFrame const &frame)
+{
+    switch (type)
+    {
+        case VectorDataType::Velocity:
+            return frame.velocityY();
+
+        case VectorDataType::ForceField:
+            return decoded(frame.forceFieldY(), frame.forceFieldYHalf(), frame, m_forceFieldY);
+    }
+
+    return frame.velocityY();
+}
+
+// Returns the float field of the frame, or its halves decoded into the entry.
+std::vector<float> const &DerivedFieldCache::decoded(std::vector<float> const &values,
+                                                     std::vector<HalfFloat::Bits> const &halves,
+                                                     SimulationFrame const &frame, Entry &entry)
+{
+    if (frame.precision() == FieldPrecision::Float32)
+        return values;
+
+    if (entry.frameNumber != frame.frameNumber())
+    {
+        HalfFloat::toFloats(halves, entry.values);
+        entry.frameNumber = frame.frameNumber();
+    }
+    return entry.values;
+}
+
+void DerivedFieldCache::computeMagnitude(std::vector<float> const &x, std::vector<float> const &y, std::vector<float> &magnitude)
+{
+    size_t const size = x.size();
+    magnitude.resize(size);
+
+    float const * const xPtr = x.data();
+    float const * const yPtr = y.data();
+    float * const magnitudePtr = magnitude.data();
+    for (size_t idx = 0U; idx < size; ++idx)
+        magnitudePtr[idx] = std::sqrt(xPtr[idx] * xPtr[idx] + yPtr[idx] * yPtr[idx]);
+}
+
+// Backward finite differences on the periodic grid: the predecessor of the first column (row) is the last column (row).
+// As in the original stencil, the last row takes its difference in y against the first row instead of the row before.
+void DerivedFieldCache::computeDivergence(std::vector<float> const &x, std::vector<float> const &y, size_t const DIMX,
+                                          size_t const DIMY, std::vector<float> &divergence) const
+{
+    divergence.resize(DIMX * DIMY);
+
+    float const inverseCellWidth = 1.0F / m_cellWidth;
+    float const inverseCellHeight = 1.0F / m_cellHeight;
+
+    for (size_t j = 0U; j < DIMY; ++j)
+    {
+        size_t const previousJ = j == 0U ? DIMY - 1U : (j == DIMY - 1U ? 0U : j - 1U);
+        float const * const xRow = x.data() + j * DIMX;
+        float const * const yRow = y.data() + j * DIMX;
+        float const * const yPreviousRow = y.data() + previousJ * DIMX;
+        float * const divergenceRow = divergence.data() + j * DIMX;
+
+        divergenceRow[0] = (xRow[0] - xRow[DIMX - 1U]) * inverseCellWidth + (yRow[0] - yPreviousRow[0]) * inverseCellHeight;
+
+        // No wrapping in the rest of the row, so this loop vectorizes.
+        for (size_t i = 1U; i < DIMX; ++i)
+            divergenceRow[i] = (xRow[i] - xRow[i - 1U]) * inverseCellWidth + (yRow[i] - yPreviousRow[i]) * inverseCellHeight;
+    }
+}
+
+// The spectral fields are derivatives per grid cell, of the given power. A field that the simulation did not compute for
+// the frame, as it was selected after the step, reads as zero until the next one.
+void DerivedFieldCache::scaleSpectralField(std::vector<float> const &values, float const power,
+                                           SimulationFrame const &frame, std::vector<float> &scaled) const
+{
+    scaled.resize(frame.DIMX() * frame.DIMY());
+    if (values.size() != scaled.size())
+    {
+        std::fill(scaled.begin(), scaled.end(), 0.0F);
+        return;
+    }
+
+    // The cells are square, see SpectralFilter.
+    float const factor = std::pow(1.0F / m_cellWidth, power);
+    for (size_t idx = 0U; idx < scaled.size(); ++idx)
+        scaled[idx] = factor * values[idx];
+}
+
+void DerivedFieldCache::setCellSize(float const cellWidth, float const cellHeight)
+{
+    if (cellWidth == m_cellWidth && cellHeight == m_cellHeight)
+        return;
+
+    m_cellWidth = cellWidth;
+    m_cellHeight = cellHeight;
+    invalidate();
+}
+
+void DerivedFieldCache::invalidate()
+{
+    for (auto &[type, entry] : m_scalarFields)
+        entry.frameNumber = std::numeric_limits<size_t>::max();
+
+    m_density.frameNumber = std::numeric_limits<size_t>::max();
+    m_forceFieldX.frameNumber = std::numeric_limits<size_t>::max();
+    m_forceFieldY.frameNumber = std::numeric_limits<size_t>::max();
+}
@@ -0,0 +1,56 @@
+#ifndef DERIVEDFIELDCACHE_H
+#define DERIVEDFIELDCACHE_H
+
+#include "datatype.h"
+#include "halffloat.h"
+
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <vector>
+
+class SimulationFrame;
+
+// Fields derived from a simulation frame (magnitudes, divergences), computed on first use and then shared by every
+// draw path until a new frame is published. Entries are keyed by the data type and the sequence number of the frame.
+// The returned references stay valid until the same field is requested for a newer frame.
+// The density and force fields of a FieldPrecision::Float16 frame are decoded here as well, once per frame.
+class DerivedFieldCache
+{
+    struct Entry
+    {
+        size_t frameNumber = std::numeric_limits<size_t>::max();
+        std::vector<float> values;
+    };
+
+    std::map<ScalarDataType, Entry> m_scalarFields;
+    Entry m_density;
+    Entry m_forceFieldX;
+    Entry m_forceFieldY;
+
+    // The divergence is computed with finite differences in visualization coordinates, to which the spectral fields of
+    // the frame are scaled as well.
+    float m_cellWidth = 1.0F;
+    float m_cellHeight = 1.0F;
+
+    static void computeMagnitude(std::vector<float> const &x, std::vector<float> const &y, std::vector<float> &magnitude);
+    void computeDivergence(std::vector<float> const &x, std::vector<float> const &y, size_t const DIMX,
+                           size_t const DIMY, std::vector<float> &divergence) const;
+    void scaleSpectralField(std::vector<float> const &values, float const power, SimulationFrame const &frame,
+                            std::vector<float> &scaled) const;
+    static std::vector<float> const &decoded(std::vector<float> const &values, std::vector<HalfFloat::Bits> const &halves,
+                                             SimulationFrame const &frame, Entry &entry);
+
+public:
+    [[nodiscard]] std::vector<float> const &scalarField(ScalarDataType const type, SimulationFrame const &frame);
+    [[nodiscard]] std::vector<float> const &vectorMagnitude(VectorDataType const type, SimulationFrame const &frame);
+
+    // The components of a vector field, in float whatever the precision of the frame.
+    [[nodiscard]] std::vector<float> const &vectorX(VectorDataType const type, SimulationFrame const &frame);
+    [[nodiscard]] std::vector<float> const &vectorY(VectorDataType const type, SimulationFrame const &frame);
+
+    void setCellSize(float const cellWidth, float const cellHeight);
+    void invalidate();
+};
+
+#endif // DERIVEDFIELDCACHE_H
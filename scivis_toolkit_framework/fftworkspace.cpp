@@ -0,0 +1,174 @@
+#include "fftworkspace.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+namespace
+{
+    // pocketfft::detail::cmplx has the same layout as std::complex (real part followed by the imaginary part).
+    pocketfft::detail::cmplx<float> *asPocketfftComplex(std::complex<float> *values)
+    {
+        return reinterpret_cast<pocketfft::detail::cmplx<float> *>(values);
+    }
+
+    bool isFastSize(size_t size)
+    {
+        for (size_t const factor : {2U, 3U, 5U})
+        {
+            while (size % factor == 0U)
+                size /= factor;
+        }
+        return size == 1U;
+    }
+}
+
+FftWorkspace::FftWorkspace(size_t const width, size_t const height, size_t const threadCount)
+{
+    resize(width, height, threadCount);
+}
+
+void FftWorkspace::resize(size_t const width, size_t const height, size_t const threadCount)
+{
+    if (width == m_width && height == m_height && threadCount == m_threadCount)
+        return;
+
+    if (width != m_width || height != m_height)
+    {
+        m_width = width;
+        m_height = height;
+        m_spectrumColumns = m_width / 2U + 1U;
+
+        m_rowPlan = std::make_shared<pocketfft::detail::pocketfft_r<float>>(m_width);
+        m_columnPlan = std::make_shared<pocketfft::detail::pocketfft_c<float>>(m_height);
+
+        m_spectrumX.assign(m_height * m_spectrumColumns, std::complex<float>{});
+        m_spectrumY.assign(m_height * m_spectrumColumns, std::complex<float>{});
+    }
+
+    m_threadCount = threadCount;
+    m_rowScratch.resize(m_threadCount * m_width);
+    m_columnScratch.resize(m_threadCount * m_height);
+}
+
+void FftWorkspace::forward(float const *field, std::complex<float> *spectrum, ThreadPool &threadPool)
+{
+    transformRows(field, spectrum, threadPool);
+    transformColumns(spectrum, true, threadPool);
+}
+
+void FftWorkspace::backward(std::complex<float> *spectrum, float *field, float const normalizationFactor,
+                            ThreadPool &threadPool)
+{
+    transformColumns(spectrum, false, threadPool);
+    inverseTransformRows(spectrum, field, normalizationFactor, threadPool);
+}
+
+// Real-to-complex transform of every row.
+// pocketfft_r returns the halfcomplex (fftpack) order r0, r1, i1, r2, i2, ..., which is unpacked into complex values here.
+void FftWorkspace::transformRows(float const *field, std::complex<float> *spectrum, ThreadPool &threadPool)
+{
+    Q_ASSERT(threadPool.threadCount() <= m_threadCount);
+
+    threadPool.parallelFor(0U, m_height, [=](size_t const begin, size_t const end, size_t const thread)
+    {
+        float * const row = m_rowScratch.data() + thread * m_width;
+        for (size_t j = begin; j < end; ++j)
+        {
+            std::copy_n(field + j * m_width, m_width, row);
+            m_rowPlan->exec(row, 1.0F, true);
+
+            std::complex<float> * const out = spectrum + j * m_spectrumColumns;
+            out[0] = {row[0], 0.0F};
+            for (size_t k = 1U; 2U * k < m_width; ++k)
+                out[k] = {row[2U * k - 1U], row[2U * k]};
+            if (m_width % 2U == 0U)
+                out[m_width / 2U] = {row[m_width - 1U], 0.0F};
+        }
+    });
+}
+
+// Complex-to-real transform of every row, packing the complex values back into halfcomplex order first.
+void FftWorkspace::inverseTransformRows(std::complex<float> const *spectrum, float *field, float const normalizationFactor,
+                                        ThreadPool &threadPool)
+{
+    threadPool.parallelFor(0U, m_height, [=](size_t const begin, size_t const end, size_t)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            std::complex<float> const * const in = spectrum + j * m_spectrumColumns;
+            float * const row = field + j * m_width;
+
+            row[0] = in[0].real();
+            for (size_t k = 1U; 2U * k < m_width; ++k)
+            {
+                row[2U * k - 1U] = in[k].real();
+                row[2U * k] = in[k].imag();
+            }
+            if (m_width % 2U == 0U)
+                row[m_width - 1U] = in[m_width / 2U].real();
+
+            m_rowPlan->exec(row, normalizationFactor, false);
+        }
+    });
+}
+
+// Complex-to-complex transform of every column of the spectrum.
+void FftWorkspace::transformColumns(std::complex<float> *spectrum, bool const forward, ThreadPool &threadPool)
+{
+    Q_ASSERT(threadPool.threadCount() <= m_threadCount);
+
+    threadPool.parallelFor(0U, m_spectrumColumns, [=](size_t const begin, size_t const end, size_t const thread)
+    {
+        std::complex<float> * const column = m_columnScratch.data() + thread * m_height;
+        for (size_t i = begin; i < end; ++i)
+        {
+            for (size_t j = 0U; j < m_height; ++j)
+                column[j] = spectrum[i + j * m_spectrumColumns];
+
+            m_columnPlan->exec(asPocketfftComplex(column), 1.0F, forward);
+
+            for (size_t j = 0U; j < m_height; ++j)
+                spectrum[i + j * m_spectrumColumns] = column[j];
+        }
+    });
+}
+
+size_t FftWorkspace::spectrumColumns() const
+{
+    return m_spectrumColumns;
+}
+
+size_t FftWorkspace::nearestFastSize(size_t const size, size_t const multiple)
+{
+    size_t const next = nextFastSize(size, multiple);
+    size_t const previous = previousFastSize(size, multiple);
+    return size - previous <= next - size ? previous : next;
+}
+
+// The fast lengths are dense enough (the gap is at most a few percent above 100) that walking is cheap.
+size_t FftWorkspace::nextFastSize(size_t const size, size_t const multiple)
+{
+    size_t quotient = (std::max(size, multiple) + multiple - 1U) / multiple;
+    while (!isFastSize(quotient))
+        ++quotient;
+    return quotient * multiple;
+}
+
+size_t FftWorkspace::previousFastSize(size_t const size, size_t const multiple)
+{
+    size_t quotient = std::max(size / multiple, size_t{1U});
+    while (!isFastSize(quotient))
+        --quotient;
+    return quotient * multiple;
+}
+
+std::vector<std::complex<float>> &FftWorkspace::spectrumX()
+{
+    return m_spectrumX;
+}
+
+std::vector<std::complex<float>> &FftWorkspace::spectrumY()
+{
+    return m_spectrumY;
+}
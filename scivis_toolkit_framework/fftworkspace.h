@@ -0,0 +1,68 @@
+#ifndef FFTWORKSPACE_H
+#define FFTWORKSPACE_H
+
+#include "pocketfft_hdronly.h"
+#include "threadpool.h"
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Persistent state for the 2D real-to-complex transforms of the velocity field.
+// The pocketfft plans, the spectra and the row and column copies are created once per grid size, so a simulation step
+// does not plan and does not allocate the spectra. pocketfft's exec still allocates its own scratch of one row or column
+// per call (more for a length that falls back to Bluestein's algorithm, see nearestFastSize), which is small next to a
+// spectrum.
+// The spectrum of a width x height field is stored row-major with height rows of (width / 2 + 1) complex values,
+// which is the same layout pocketfft::r2c produces for axes {0, 1}.
+// Rows and columns are transformed in parallel on a ThreadPool; every pool thread has its own scratch space.
+class FftWorkspace
+{
+    size_t m_width = 0U;
+    size_t m_height = 0U;
+    size_t m_spectrumColumns = 0U; // width / 2 + 1
+    size_t m_threadCount = 0U;
+
+    std::shared_ptr<pocketfft::detail::pocketfft_r<float>> m_rowPlan;
+    std::shared_ptr<pocketfft::detail::pocketfft_c<float>> m_columnPlan;
+
+    std::vector<std::complex<float>> m_spectrumX, m_spectrumY;
+
+    // Scratch space for a single row (real) and a single column (complex) of a transform, per thread.
+    std::vector<float> m_rowScratch;
+    std::vector<std::complex<float>> m_columnScratch;
+
+    void transformRows(float const *field, std::complex<float> *spectrum, ThreadPool &threadPool);
+    void inverseTransformRows(std::complex<float> const *spectrum, float *field, float const normalizationFactor,
+                              ThreadPool &threadPool);
+    void transformColumns(std::complex<float> *spectrum, bool const forward, ThreadPool &threadPool);
+
+public:
+    FftWorkspace() = default;
+    FftWorkspace(size_t const width, size_t const height, size_t const threadCount);
+
+    // threadCount must be at least the thread count of the pools passed to forward() and backward().
+    void resize(size_t const width, size_t const height, size_t const threadCount);
+
+    // Transforms a real width x height field into the given spectrum buffer.
+    void forward(float const *field, std::complex<float> *spectrum, ThreadPool &threadPool);
+    // Transforms a spectrum back into a real width x height field; the result is multiplied by normalizationFactor.
+    // The spectrum is overwritten.
+    void backward(std::complex<float> *spectrum, float *field, float const normalizationFactor, ThreadPool &threadPool);
+
+    [[nodiscard]] size_t spectrumColumns() const;
+
+    // pocketfft is fastest on lengths whose only prime factors are 2, 3 and 5; a large prime factor falls back to
+    // Bluestein's algorithm, several times slower. Returns the length closest to size of the form
+    // multiple * 2^a * 3^b * 5^c, the smaller one on a tie.
+    [[nodiscard]] static size_t nearestFastSize(size_t const size, size_t const multiple = 1U);
+    // The smallest such length of at least size, and the largest of at most size (but at least multiple).
+    [[nodiscard]] static size_t nextFastSize(size_t const size, size_t const multiple = 1U);
+    [[nodiscard]] static size_t previousFastSize(size_t const size, size_t const multiple = 1U);
+
+    [[nodiscard]] std::vector<std::complex<float>> &spectrumX();
+    [[nodiscard]] std::vector<std::complex<float>> &spectrumY();
+};
+
+#endif // FFTWORKSPACE_H
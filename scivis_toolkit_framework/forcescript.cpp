@@ -0,0 +1,139 @@
+#include "forcescript.h"
+
+#include "constants.h"
+#include "simulation.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    // The grid index of a position in [0, 1] x [0, 1].
+    size_t gridIndex(Simulation const &simulation, float const x, float const y)
+    {
+        auto const toCell = [](float const position, size_t const size)
+        {
+            auto const cell = static_cast<long>(std::floor(position * static_cast<float>(size)));
+            return static_cast<size_t>(std::clamp(cell, 0L, static_cast<long>(size) - 1L));
+        };
+
+        return toCell(x, simulation.DIMX()) + simulation.DIMX() * toCell(y, simulation.DIMY());
+    }
+}
+
+bool ForceScript::load(QString const &fileName)
+{
+    QFile file{fileName};
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qCritical() << "Cannot open force script" << fileName;
+        return false;
+    }
+
+    std::vector<Event> events;
+    QTextStream stream{&file};
+    for (size_t lineNumber = 1U; !stream.atEnd(); ++lineNumber)
+    {
+        QString const line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        QStringList const fields = line.split(QRegularExpression{QStringLiteral("\\s+")}, Qt::SkipEmptyParts);
+        QStringList const steps = fields.value(0).split('-');
+
+        bool valid = (fields.size() == 5 || fields.size() == 6) && steps.size() <= 2;
+        auto const readStep = [&valid](QString const &text)
+        {
+            bool ok = false;
+            size_t const value = text.toULongLong(&ok);
+            valid = valid && ok;
+            return value;
+        };
+        auto const readFloat = [&valid](QString const &text)
+        {
+            bool ok = false;
+            float const value = text.toFloat(&ok);
+            valid = valid && ok;
+            return value;
+        };
+
+        Event event;
+        event.firstStep = readStep(steps.value(0));
+        event.lastStep = steps.size() == 2 ? readStep(steps.value(1)) : event.firstStep;
+        event.x = readFloat(fields.value(1));
+        event.y = readFloat(fields.value(2));
+        event.fx = readFloat(fields.value(3));
+        event.fy = readFloat(fields.value(4));
+        event.injectsDensity = fields.size() == 6;
+        if (event.injectsDensity)
+            event.density = readFloat(fields.value(5));
+
+        if (!valid || event.lastStep < event.firstStep)
+        {
+            qCritical().noquote() << "Force script" << fileName << "line" << lineNumber << "is not"
+                                  << "\"<first step>[-<last step>] <x> <y> <fx> <fy> [<density>]\":" << line;
+            return false;
+        }
+
+        events.push_back(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](Event const &a, Event const &b) { return a.firstStep < b.firstStep; });
+    m_events = std::move(events);
+    m_stir = false;
+    return true;
+}
+
+void ForceScript::apply(size_t const step, Simulation &simulation) const
+{
+    if (m_stir)
+    {
+        float const angle = 2.0F * constants::pi * static_cast<float>(step % s_stirPeriod)
+                          / static_cast<float>(s_stirPeriod);
+        float const x = 0.5F + s_stirRadius * std::cos(angle);
+        float const y = 0.5F + s_stirRadius * std::sin(angle);
+
+        // Drag along the circle.
+        addForce(simulation, x, y, -s_stirForce * std::sin(angle), s_stirForce * std::cos(angle));
+        injectDensity(simulation, x, y, simulation.rhoInjected());
+        return;
+    }
+
+    for (Event const &event : m_events)
+    {
+        if (event.firstStep > step)
+            break;
+
+        if (step > event.lastStep)
+            continue;
+
+        addForce(simulation, event.x, event.y, event.fx, event.fy);
+        if (event.injectsDensity)
+            injectDensity(simulation, event.x, event.y, event.density);
+    }
+}
+
+void ForceScript::addForce(Simulation &simulation, float const x, float const y, float const fx, float const fy)
+{
+    size_t const idx = gridIndex(simulation, x, y);
+    simulation.setFx(idx, simulation.fx(idx) + fx);
+    simulation.setFy(idx, simulation.fy(idx) + fy);
+}
+
+void ForceScript::injectDensity(Simulation &simulation, float const x, float const y, float const density)
+{
+    simulation.setRho(gridIndex(simulation, x, y), density);
+}
+
+size_t ForceScript::numberOfEvents() const
+{
+    return m_events.size();
+}
@@ -0,0 +1,54 @@
+#ifndef FORCESCRIPT_H
+#define FORCESCRIPT_H
+
+#include <QString>
+
+#include <cstddef>
+#include <vector>
+
+class Simulation;
+
+// Scripted mouse input for batch runs. Every line of a script is one event:
+//     <first step>[-<last step>] <x> <y> <fx> <fy> [<density>]
+// x and y are in [0, 1] across the grid, y up like in the visualization, so a script works at every grid size.
+// Before each of the steps first to last the force (fx, fy) is added at (x, y), and the density injected there if it
+// is given. Steps count from 0. Empty lines and lines starting with '#' are skipped.
+// Without a script the input is a point circling the center of the grid, stirring and injecting smoke like a mouse
+// drag does.
+class ForceScript
+{
+    struct Event
+    {
+        size_t firstStep = 0U;
+        size_t lastStep = 0U;
+        float x = 0.0F;
+        float y = 0.0F;
+        float fx = 0.0F;
+        float fy = 0.0F;
+        float density = 0.0F;
+        bool injectsDensity = false;
+    };
+
+    std::vector<Event> m_events; // Sorted on the first step.
+    bool m_stir = true;
+
+    static constexpr size_t s_stirPeriod = 240U;    // Steps per revolution of the stirring point.
+    static constexpr float s_stirRadius = 0.25F;
+    static constexpr float s_stirForce = 0.1F;      // The force of one mouse drag event, see Visualization::input_drag.
+
+    static void addForce(Simulation &simulation, float const x, float const y, float const fx, float const fy);
+    static void injectDensity(Simulation &simulation, float const x, float const y, float const density);
+
+public:
+    // Replaces the stirring by the events of the file. Returns false, after logging the offending line, if the file
+    // cannot be read or parsed.
+    bool load(QString const &fileName);
+
+    // Applies the input of this step to the simulation. Stirring injects the injection density of the simulation.
+    void apply(size_t const step, Simulation &simulation) const;
+
+    // Getters
+    [[nodiscard]] size_t numberOfEvents() const;
+};
+
+#endif // FORCESCRIPT_H
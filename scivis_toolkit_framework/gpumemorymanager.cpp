@@ -0,0 +1,542 @@
+#include "gpumemorymanager.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    // GL_NVX_gpu_memory_info and GL_ATI_meminfo, both in kilobytes.
+    constexpr GLenum s_gpuMemoryInfoTotalAvailableMemoryNvx = 0x9048;
+    constexpr GLenum s_gpuMemoryInfoCurrentAvailableVidmemNvx = 0x9049;
+    constexpr GLenum s_textureFreeMemoryAti = 0x87FC;
+
+    // The format and type a texture of an uncompressed internal format is read back and uploaded again with, without
+    // losing precision.
+    struct PixelTransfer
+    {
+        GLenum format = GL_RED;
+        GLenum type = GL_UNSIGNED_BYTE;
+        size_t bytesPerTexel = 0U;
+    };
+
+    bool pixelTransfer(GLint const internalFormat, PixelTransfer &transfer)
+    {
+        switch (internalFormat)
+        {
+            case GL_RED:
+            case GL_R8:      transfer = {GL_RED, GL_UNSIGNED_BYTE, 1U}; return true;
+            case GL_R16:     transfer = {GL_RED, GL_UNSIGNED_SHORT, 2U}; return true;
+            case GL_R16F:    transfer = {GL_RED, GL_HALF_FLOAT, 2U}; return true;
+            case GL_R32F:    transfer = {GL_RED, GL_FLOAT, 4U}; return true;
+            case GL_RG8:     transfer = {GL_RG, GL_UNSIGNED_BYTE, 2U}; return true;
+            case GL_RG16F:   transfer = {GL_RG, GL_HALF_FLOAT, 4U}; return true;
+            case GL_RG32F:   transfer = {GL_RG, GL_FLOAT, 8U}; return true;
+            case GL_RGB:
+            case GL_RGB8:    transfer = {GL_RGB, GL_UNSIGNED_BYTE, 3U}; return true;
+            case GL_RGB16F:  transfer = {GL_RGB, GL_HALF_FLOAT, 6U}; return true;
+            case GL_RGB32F:  transfer = {GL_RGB, GL_FLOAT, 12U}; return true;
+            case GL_RGBA:
+            case GL_RGBA8:   transfer = {GL_RGBA, GL_UNSIGNED_BYTE, 4U}; return true;
+            case GL_RGB10_A2: transfer = {GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4U}; return true;
+            case GL_RGBA16F: transfer = {GL_RGBA, GL_HALF_FLOAT, 8U}; return true;
+            case GL_RGBA32F: transfer = {GL_RGBA, GL_FLOAT, 16U}; return true;
+            default:         return false;
+        }
+    }
+
+    char const *groupName(GpuMemoryManager::Group const group)
+    {
+        switch (group)
+        {
+            case GpuMemoryManager::Group::Shared:          return "shared";
+            case GpuMemoryManager::Group::HeightPlot:      return "height plot";
+            case GpuMemoryManager::Group::Lic:             return "LIC";
+            case GpuMemoryManager::Group::VolumeRendering: return "volume rendering";
+            case GpuMemoryManager::Group::Particles:       return "particles";
+            case GpuMemoryManager::Group::GpuSimulation:   return "GPU simulation";
+        }
+
+        return "";
+    }
+
+    double mebibytes(size_t const bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+void GpuMemoryManager::create(QOpenGLFunctions_3_3_Core * const gl)
+{
+    m_gl = gl;
+    m_memoryInfo = MemoryInfo::None;
+
+    GLint numberOfExtensions = 0;
+    m_gl->glGetIntegerv(GL_NUM_EXTENSIONS, &numberOfExtensions);
+    for (GLint idx = 0; idx < numberOfExtensions; ++idx)
+    {
+        auto const extension = reinterpret_cast<char const*>(m_gl->glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(idx)));
+        if (std::strcmp(extension, "GL_NVX_gpu_memory_info") == 0)
+            m_memoryInfo = MemoryInfo::Nvx;
+        else if (std::strcmp(extension, "GL_ATI_meminfo") == 0 && m_memoryInfo == MemoryInfo::None)
+            m_memoryInfo = MemoryInfo::Ati;
+    }
+
+    m_framesUntilMeasurement = 0U;
+}
+
+void GpuMemoryManager::destroy()
+{
+    m_resources.clear();
+    m_residentBytes = 0U;
+    m_evictedBytes = 0U;
+    m_gl = nullptr;
+}
+
+void GpuMemoryManager::add(Kind const kind, GLenum const target, GLuint const name, Group const group,
+                           char const * const label, bool const keepContents)
+{
+    Resource resource;
+    resource.kind = kind;
+    resource.target = target;
+    resource.name = name;
+    resource.group = group;
+    resource.label = label;
+    resource.keepContents = keepContents;
+    m_resources.push_back(std::move(resource));
+    m_framesUntilMeasurement = 0U;
+}
+
+void GpuMemoryManager::addTexture(GLenum const target, GLuint const texture, Group const group,
+                                  char const * const label, bool const keepContents)
+{
+    add(Kind::Texture, target, texture, group, label, keepContents);
+}
+
+void GpuMemoryManager::addBuffer(GLuint const buffer, Group const group, char const * const label,
+                                 bool const keepContents)
+{
+    add(Kind::Buffer, 0U, buffer, group, label, keepContents);
+}
+
+// Every level down to the first empty one. A texture of an unknown format is counted at four bytes per texel.
+size_t GpuMemoryManager::measureTexture(Resource const &resource) const
+{
+    m_gl->glBindTexture(resource.target, resource.name);
+
+    size_t bytes = 0U;
+    for (GLint level = 0; level < s_maxLevels; ++level)
+    {
+        GLint width = 0;
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_WIDTH, &width);
+        if (width == 0)
+            break;
+
+        GLint height = 0;
+        GLint depth = 0;
+        GLint isCompressed = GL_FALSE;
+        GLint internalFormat = 0;
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_HEIGHT, &height);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_DEPTH, &depth);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_COMPRESSED, &isCompressed);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+
+        if (isCompressed == GL_TRUE)
+        {
+            GLint imageSize = 0;
+            m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &imageSize);
+            bytes += static_cast<size_t>(imageSize);
+            continue;
+        }
+
+        PixelTransfer transfer;
+        size_t const bytesPerTexel = pixelTransfer(internalFormat, transfer) ? transfer.bytesPerTexel : 4U;
+        bytes += static_cast<size_t>(width) * static_cast<size_t>(std::max(height, 1)) *
+                 static_cast<size_t>(std::max(depth, 1)) * bytesPerTexel;
+    }
+
+    m_gl->glBindTexture(resource.target, 0U);
+    return bytes;
+}
+
+size_t GpuMemoryManager::measureBuffer(Resource const &resource) const
+{
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, resource.name);
+    GLint size = 0;
+    m_gl->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, 0U);
+    return static_cast<size_t>(size);
+}
+
+// An evicted resource that has storage again was reallocated by its owner, the copy of its old contents is stale.
+void GpuMemoryManager::measure()
+{
+    size_t residentBytes = 0U;
+    size_t evictedBytes = 0U;
+    for (Resource &resource : m_resources)
+    {
+        size_t const bytes = resource.kind == Kind::Texture ? measureTexture(resource) : measureBuffer(resource);
+        if (resource.isEvicted && bytes > 0U)
+        {
+            resource.isEvicted = false;
+            resource.levels.clear();
+            resource.data.clear();
+        }
+
+        if (resource.isEvicted)
+            evictedBytes += resource.bytes;
+        else
+        {
+            resource.bytes = bytes;
+            residentBytes += bytes;
+        }
+    }
+
+    m_changed = m_changed || residentBytes != m_residentBytes || evictedBytes != m_evictedBytes;
+    m_residentBytes = residentBytes;
+    m_evictedBytes = evictedBytes;
+}
+
+void GpuMemoryManager::queryDriverMemory()
+{
+    long long totalKilobytes = -1;
+    long long availableKilobytes = -1;
+
+    if (m_memoryInfo == MemoryInfo::Nvx)
+    {
+        GLint total = 0;
+        GLint available = 0;
+        m_gl->glGetIntegerv(s_gpuMemoryInfoTotalAvailableMemoryNvx, &total);
+        m_gl->glGetIntegerv(s_gpuMemoryInfoCurrentAvailableVidmemNvx, &available);
+        totalKilobytes = total;
+        availableKilobytes = available;
+    }
+    else if (m_memoryInfo == MemoryInfo::Ati)
+    {
+        // The free memory of the texture pool, the largest free block, and the same two for auxiliary memory.
+        std::array<GLint, 4U> info{};
+        m_gl->glGetIntegerv(s_textureFreeMemoryAti, info.data());
+        availableKilobytes = info[0];
+    }
+
+    m_changed = m_changed || totalKilobytes != m_driverTotalKilobytes || availableKilobytes != m_driverAvailableKilobytes;
+    m_driverTotalKilobytes = totalKilobytes;
+    m_driverAvailableKilobytes = availableKilobytes;
+}
+
+// The levels are released by respecifying them as empty, which keeps the texture object, its parameters and the
+// framebuffers it is attached to.
+void GpuMemoryManager::evictTexture(Resource &resource) const
+{
+    m_gl->glBindTexture(resource.target, resource.name);
+
+    std::vector<Level> levels;
+    for (GLint level = 0; level < s_maxLevels; ++level)
+    {
+        Level stored;
+        GLint isCompressed = GL_FALSE;
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_WIDTH, &stored.width);
+        if (stored.width == 0)
+            break;
+
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_HEIGHT, &stored.height);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_DEPTH, &stored.depth);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_COMPRESSED, &isCompressed);
+        m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_INTERNAL_FORMAT, &stored.internalFormat);
+        stored.isCompressed = isCompressed == GL_TRUE;
+
+        if (stored.isCompressed)
+        {
+            GLint imageSize = 0;
+            m_gl->glGetTexLevelParameteriv(resource.target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &imageSize);
+            stored.data.resize(static_cast<size_t>(imageSize));
+            if (resource.keepContents)
+                m_gl->glGetCompressedTexImage(resource.target, level, stored.data.data());
+        }
+        else
+        {
+            PixelTransfer transfer;
+            if (!pixelTransfer(stored.internalFormat, transfer))
+            {
+                m_gl->glBindTexture(resource.target, 0U);
+                return;
+            }
+
+            if (resource.keepContents)
+            {
+                stored.data.resize(static_cast<size_t>(stored.width) * static_cast<size_t>(stored.height) *
+                                   static_cast<size_t>(stored.depth) * transfer.bytesPerTexel);
+                m_gl->glGetTexImage(resource.target, level, transfer.format, transfer.type, stored.data.data());
+            }
+        }
+
+        levels.push_back(std::move(stored));
+    }
+
+    for (GLint level = 0; level < static_cast<GLint>(levels.size()); ++level)
+    {
+        if (resource.target == GL_TEXTURE_1D)
+            m_gl->glTexImage1D(resource.target, level, GL_R8, 0, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        else if (resource.target == GL_TEXTURE_3D || resource.target == GL_TEXTURE_2D_ARRAY)
+            m_gl->glTexImage3D(resource.target, level, GL_R8, 0, 0, 0, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        else
+            m_gl->glTexImage2D(resource.target, level, GL_R8, 0, 0, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    m_gl->glBindTexture(resource.target, 0U);
+    resource.levels = std::move(levels);
+    resource.isEvicted = !resource.levels.empty();
+}
+
+void GpuMemoryManager::restoreTexture(Resource &resource) const
+{
+    m_gl->glBindTexture(resource.target, resource.name);
+
+    GLint width = 0;
+    m_gl->glGetTexLevelParameteriv(resource.target, 0, GL_TEXTURE_WIDTH, &width);
+    for (GLint level = 0; width == 0 && level < static_cast<GLint>(resource.levels.size()); ++level)
+    {
+        Level const &stored = resource.levels[static_cast<size_t>(level)];
+        void const * const data = stored.data.empty() || !resource.keepContents ? nullptr : stored.data.data();
+        auto const imageSize = static_cast<GLsizei>(stored.data.size());
+        bool const is3D = resource.target == GL_TEXTURE_3D || resource.target == GL_TEXTURE_2D_ARRAY;
+
+        if (stored.isCompressed && resource.target == GL_TEXTURE_1D)
+            m_gl->glCompressedTexImage1D(resource.target, level, static_cast<GLenum>(stored.internalFormat),
+                                         stored.width, 0, imageSize, data);
+        else if (stored.isCompressed && is3D)
+            m_gl->glCompressedTexImage3D(resource.target, level, static_cast<GLenum>(stored.internalFormat),
+                                         stored.width, stored.height, stored.depth, 0, imageSize, data);
+        else if (stored.isCompressed)
+            m_gl->glCompressedTexImage2D(resource.target, level, static_cast<GLenum>(stored.internalFormat),
+                                         stored.width, stored.height, 0, imageSize, data);
+        else
+        {
+            PixelTransfer transfer;
+            static_cast<void>(pixelTransfer(stored.internalFormat, transfer));
+            if (resource.target == GL_TEXTURE_1D)
+                m_gl->glTexImage1D(resource.target, level, stored.internalFormat, stored.width, 0,
+                                   transfer.format, transfer.type, data);
+            else if (is3D)
+                m_gl->glTexImage3D(resource.target, level, stored.internalFormat, stored.width, stored.height,
+                                   stored.depth, 0, transfer.format, transfer.type, data);
+            else
+                m_gl->glTexImage2D(resource.target, level, stored.internalFormat, stored.width, stored.height, 0,
+                                   transfer.format, transfer.type, data);
+        }
+    }
+
+    m_gl->glBindTexture(resource.target, 0U);
+    resource.levels.clear();
+    resource.isEvicted = false;
+}
+
+// Mapped buffers, like the pixel buffers the volume streamer fills, stay resident.
+void GpuMemoryManager::evictBuffer(Resource &resource) const
+{
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, resource.name);
+
+    GLint isMapped = GL_FALSE;
+    GLint size = 0;
+    m_gl->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_MAPPED, &isMapped);
+    m_gl->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    m_gl->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &resource.usage);
+    if (isMapped == GL_FALSE && size > 0)
+    {
+        resource.data.resize(static_cast<size_t>(size));
+        if (resource.keepContents)
+            m_gl->glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, resource.data.data());
+
+        m_gl->glBufferData(GL_COPY_READ_BUFFER, 0, nullptr, static_cast<GLenum>(resource.usage));
+        resource.isEvicted = true;
+    }
+
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, 0U);
+}
+
+void GpuMemoryManager::restoreBuffer(Resource &resource) const
+{
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, resource.name);
+
+    GLint size = 0;
+    m_gl->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    if (size == 0)
+        m_gl->glBufferData(GL_COPY_READ_BUFFER,
+                           static_cast<GLsizeiptr>(resource.data.size()),
+                           resource.keepContents ? resource.data.data() : nullptr,
+                           static_cast<GLenum>(resource.usage));
+
+    m_gl->glBindBuffer(GL_COPY_READ_BUFFER, 0U);
+    resource.data.clear();
+    resource.isEvicted = false;
+}
+
+void GpuMemoryManager::evict(Resource &resource)
+{
+    if (resource.kind == Kind::Texture)
+        evictTexture(resource);
+    else
+        evictBuffer(resource);
+
+    if (!resource.isEvicted)
+        return;
+
+    m_residentBytes -= resource.bytes;
+    m_evictedBytes += resource.bytes;
+    m_changed = true;
+}
+
+void GpuMemoryManager::restore(Resource &resource)
+{
+    if (resource.kind == Kind::Texture)
+        restoreTexture(resource);
+    else
+        restoreBuffer(resource);
+
+    m_residentBytes += resource.bytes;
+    m_evictedBytes -= resource.bytes;
+    m_changed = true;
+}
+
+// The largest resources of the inactive groups go first, so as few as possible have to be restored later.
+void GpuMemoryManager::enforceBudget(Groups const &activeGroups)
+{
+    if (m_budget == 0U || m_residentBytes <= m_budget)
+        return;
+
+    std::vector<size_t> candidates;
+    for (size_t idx = 0U; idx < m_resources.size(); ++idx)
+    {
+        Resource const &resource = m_resources[idx];
+        if (resource.group != Group::Shared && !activeGroups[static_cast<size_t>(resource.group)] &&
+            !resource.isEvicted && resource.bytes > 0U)
+            candidates.push_back(idx);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](size_t const lhs, size_t const rhs)
+    {
+        return m_resources[lhs].bytes > m_resources[rhs].bytes;
+    });
+
+    for (size_t const idx : candidates)
+    {
+        if (m_residentBytes <= m_budget)
+            break;
+
+        evict(m_resources[idx]);
+    }
+
+    if (m_residentBytes > m_budget)
+        qDebug() << "Warning: the visualizations in use hold" << mebibytes(m_residentBytes) << "MiB of GPU memory,"
+                 << "more than the budget of" << mebibytes(m_budget) << "MiB.";
+}
+
+void GpuMemoryManager::update(Groups const &activeGroups)
+{
+    GLint packAlignment = 4;
+    GLint unpackAlignment = 4;
+    m_gl->glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    m_gl->glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    m_gl->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+    m_gl->glActiveTexture(GL_TEXTURE0);
+
+    for (Resource &resource : m_resources)
+        if (resource.isEvicted && activeGroups[static_cast<size_t>(resource.group)])
+            restore(resource);
+
+    if (m_framesUntilMeasurement == 0U)
+    {
+        measure();
+        queryDriverMemory();
+        enforceBudget(activeGroups);
+        m_framesUntilMeasurement = s_measurementInterval;
+    }
+    else
+        --m_framesUntilMeasurement;
+
+    m_gl->glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+}
+
+void GpuMemoryManager::logReport() const
+{
+    std::vector<size_t> order(m_resources.size());
+    std::iota(order.begin(), order.end(), size_t{0U});
+    std::sort(order.begin(), order.end(), [this](size_t const lhs, size_t const rhs)
+    {
+        return m_resources[lhs].bytes > m_resources[rhs].bytes;
+    });
+
+    qDebug() << ":: GPU memory of the visualization";
+    for (size_t const idx : order)
+    {
+        Resource const &resource = m_resources[idx];
+        qDebug() << "   " << resource.label << "(" << groupName(resource.group) << "):" << mebibytes(resource.bytes)
+                 << "MiB" << (resource.isEvicted ? "evicted" : "");
+    }
+
+    for (size_t group = 0U; group < s_numberOfGroups; ++group)
+        qDebug() << "    Total" << groupName(static_cast<Group>(group)) << ":"
+                 << mebibytes(groupBytes(static_cast<Group>(group))) << "MiB";
+
+    qDebug() << "    Resident:" << mebibytes(m_residentBytes) << "MiB, evicted:" << mebibytes(m_evictedBytes)
+             << "MiB, budget:" << (m_budget == 0U ? -1.0 : mebibytes(m_budget)) << "MiB";
+    if (m_driverAvailableKilobytes >= 0)
+        qDebug() << "    Driver: available" << static_cast<double>(m_driverAvailableKilobytes) / 1024.0 << "MiB of"
+                 << static_cast<double>(m_driverTotalKilobytes) / 1024.0 << "MiB";
+}
+
+// Getters
+size_t GpuMemoryManager::budget() const
+{
+    return m_budget;
+}
+
+size_t GpuMemoryManager::residentBytes() const
+{
+    return m_residentBytes;
+}
+
+size_t GpuMemoryManager::evictedBytes() const
+{
+    return m_evictedBytes;
+}
+
+// Resident resources only.
+size_t GpuMemoryManager::groupBytes(Group const group) const
+{
+    size_t bytes = 0U;
+    for (Resource const &resource : m_resources)
+        if (resource.group == group && !resource.isEvicted)
+            bytes += resource.bytes;
+
+    return bytes;
+}
+
+long long GpuMemoryManager::driverTotalKilobytes() const
+{
+    return m_driverTotalKilobytes;
+}
+
+long long GpuMemoryManager::driverAvailableKilobytes() const
+{
+    return m_driverAvailableKilobytes;
+}
+
+bool GpuMemoryManager::takeChanged()
+{
+    bool const changed = m_changed;
+    m_changed = false;
+    return changed;
+}
+
+// Setters
+void GpuMemoryManager::setBudget(size_t const budget)
+{
+    m_budget = budget;
+    m_framesUntilMeasurement = 0U;
+}
@@ -0,0 +1,149 @@
+#ifndef GPUMEMORYMANAGER_H
+#define GPUMEMORYMANAGER_H
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Keeps track of the GPU memory held by the buffers and textures of the visualization, and keeps it within a budget.
+// Every resource is registered once, with the group of visualizations that uses it. Its size is not passed in but
+// measured from the storage OpenGL reports, every s_measurementInterval frames, so reallocations anywhere in the code
+// are followed without further bookkeeping.
+// When the resident resources exceed the budget, those of groups the frame does not draw are evicted, the largest
+// first: their contents are read back into host memory and their storage is released. The first frame that draws the
+// group again uploads them back before anything uses them. A resource that was reallocated in the meantime, for
+// example by a resize, is resident again and its copy is dropped.
+// Where the driver reports its free memory, with GL_NVX_gpu_memory_info or GL_ATI_meminfo, it is shown next to the
+// tracked total.
+//
+// Every function that takes or touches GL state has to be called with the context current. update() leaves texture
+// unit 0 active and unbinds the textures and buffers it used.
+class GpuMemoryManager
+{
+public:
+    enum class Group
+    {
+        Shared,           // Used by every frame, or too small to be worth evicting. Never evicted.
+        HeightPlot,
+        Lic,              // Also holds the velocity texture the particles read.
+        VolumeRendering,
+        Particles,
+        GpuSimulation
+    };
+    static constexpr size_t s_numberOfGroups = 6U;
+    using Groups = std::array<bool, s_numberOfGroups>;
+
+private:
+    enum class Kind
+    {
+        Buffer,
+        Texture
+    };
+
+    // A level of an evicted texture, as it is uploaded again.
+    struct Level
+    {
+        GLint internalFormat = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLsizei depth = 0;
+        bool isCompressed = false;
+        std::vector<char> data;
+    };
+
+    struct Resource
+    {
+        Kind kind = Kind::Buffer;
+        GLenum target = 0U;         // Of a texture.
+        GLuint name = 0U;
+        Group group = Group::Shared;
+        char const *label = "";
+        bool keepContents = true;   // Otherwise the contents are rewritten before every use, and not read back.
+
+        size_t bytes = 0U;          // As last measured, or before the eviction.
+        bool isEvicted = false;
+        std::vector<Level> levels;  // Of an evicted texture.
+        std::vector<char> data;     // Of an evicted buffer.
+        GLint usage = GL_STATIC_DRAW;
+    };
+
+    enum class MemoryInfo
+    {
+        None,
+        Nvx,
+        Ati
+    };
+
+    static constexpr size_t s_measurementInterval = 120U; // Frames, about two seconds at 60 frames per second.
+    static constexpr GLint s_maxLevels = 16;
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    std::vector<Resource> m_resources;
+    MemoryInfo m_memoryInfo = MemoryInfo::None;
+
+    size_t m_budget = 0U;       // In bytes, 0 for no budget.
+    size_t m_framesUntilMeasurement = 0U;
+    size_t m_residentBytes = 0U;
+    size_t m_evictedBytes = 0U;
+    long long m_driverTotalKilobytes = -1;
+    long long m_driverAvailableKilobytes = -1;
+    bool m_changed = false;
+
+    void add(Kind const kind, GLenum const target, GLuint const name, Group const group, char const * const label,
+             bool const keepContents);
+
+    [[nodiscard]] size_t measureTexture(Resource const &resource) const;
+    [[nodiscard]] size_t measureBuffer(Resource const &resource) const;
+    void measure();
+    void queryDriverMemory();
+
+    void evictTexture(Resource &resource) const;
+    void restoreTexture(Resource &resource) const;
+    void evictBuffer(Resource &resource) const;
+    void restoreBuffer(Resource &resource) const;
+    void evict(Resource &resource);
+    void restore(Resource &resource);
+
+    void enforceBudget(Groups const &activeGroups);
+
+public:
+    GpuMemoryManager() = default;
+    GpuMemoryManager(GpuMemoryManager const&) = delete;
+    GpuMemoryManager& operator=(GpuMemoryManager const&) = delete;
+
+    // Finds out which memory information the driver offers.
+    void create(QOpenGLFunctions_3_3_Core * const gl);
+    // Forgets all resources, which stay owned, and deleted, by whoever created them.
+    void destroy();
+
+    // Registers a texture of target or a buffer. It has to stay alive until destroy().
+    void addTexture(GLenum const target, GLuint const texture, Group const group, char const * const label,
+                    bool const keepContents = true);
+    void addBuffer(GLuint const buffer, Group const group, char const * const label, bool const keepContents = true);
+
+    // Called at the start of every frame with the groups it draws: restores their evicted resources, measures the
+    // resources when it is time to, and evicts inactive ones while over the budget.
+    void update(Groups const &activeGroups);
+
+    // Logs every resource with its size, largest first, and the totals.
+    void logReport() const;
+
+    // Getters
+    [[nodiscard]] size_t budget() const;
+    [[nodiscard]] size_t residentBytes() const;
+    [[nodiscard]] size_t evictedBytes() const;
+    [[nodiscard]] size_t groupBytes(Group const group) const;
+    // -1 if the driver does not report them.
+    [[nodiscard]] long long driverTotalKilobytes() const;
+    [[nodiscard]] long long driverAvailableKilobytes() const;
+    // Whether the totals changed since the last call, which clears it.
+    [[nodiscard]] bool takeChanged();
+
+    // Setters
+    // In bytes, 0 for no budget. Applied by the next update.
+    void setBudget(size_t const budget);
+};
+
+#endif // GPUMEMORYMANAGER_H
@@ -0,0 +1,364 @@
+#include "gpusimulation.h"
+
+#include "constants.h"
+#include "shaderprogram.h"
+
+#include <utility>
+
+using shaderprogram::uniformLocationWithCheck;
+
+namespace
+{
+    void createShaderProgram(QOpenGLShaderProgram &shaderProgram, char const * const vertexShader,
+                             char const * const fragmentShader)
+    {
+        shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vertexShader);
+        shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, fragmentShader);
+        shaderProgram.link();
+    }
+}
+
+GLuint GpuSimulation::PingPong::front() const
+{
+    return textures[current];
+}
+
+GLuint GpuSimulation::PingPong::back() const
+{
+    return textures[1U - current];
+}
+
+void GpuSimulation::PingPong::swap()
+{
+    current = 1U - current;
+}
+
+void GpuSimulation::create(QOpenGLFunctions_3_3_Core * const gl, size_t const DIM)
+{
+    m_gl = gl;
+
+    // Full-screen passes use the vertex shader of the preprocessing passes, which needs no vertex data.
+    createShaderProgram(m_shaderProgramSplat, ":/shaders/gpusimulation_splat.vert", ":/shaders/gpusimulation_splat.frag");
+    createShaderProgram(m_shaderProgramForces, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_forces.frag");
+    createShaderProgram(m_shaderProgramAdvect, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_advect.frag");
+    createShaderProgram(m_shaderProgramDiffuse, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_diffuse.frag");
+    createShaderProgram(m_shaderProgramDivergence, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_divergence.frag");
+    createShaderProgram(m_shaderProgramPressure, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_pressure.frag");
+    createShaderProgram(m_shaderProgramProject, ":/shaders/preprocessing.vert", ":/shaders/gpusimulation_project.frag");
+
+    m_uniformLocationSplat_DIM = uniformLocationWithCheck(m_shaderProgramSplat, "DIM");
+    m_uniformLocationForces_force = uniformLocationWithCheck(m_shaderProgramForces, "force");
+    m_uniformLocationForces_velocity = uniformLocationWithCheck(m_shaderProgramForces, "velocity");
+    m_uniformLocationForces_density = uniformLocationWithCheck(m_shaderProgramForces, "density");
+    m_uniformLocationForces_texelSize = uniformLocationWithCheck(m_shaderProgramForces, "texelSize");
+    m_uniformLocationForces_dt = uniformLocationWithCheck(m_shaderProgramForces, "dt");
+    m_uniformLocationAdvect_field = uniformLocationWithCheck(m_shaderProgramAdvect, "field");
+    m_uniformLocationAdvect_velocity = uniformLocationWithCheck(m_shaderProgramAdvect, "velocity");
+    m_uniformLocationAdvect_texelSize = uniformLocationWithCheck(m_shaderProgramAdvect, "texelSize");
+    m_uniformLocationAdvect_dt = uniformLocationWithCheck(m_shaderProgramAdvect, "dt");
+    m_uniformLocationDiffuse_velocity = uniformLocationWithCheck(m_shaderProgramDiffuse, "velocity");
+    m_uniformLocationDiffuse_rightHandSide = uniformLocationWithCheck(m_shaderProgramDiffuse, "rightHandSide");
+    m_uniformLocationDiffuse_texelSize = uniformLocationWithCheck(m_shaderProgramDiffuse, "texelSize");
+    m_uniformLocationDiffuse_alpha = uniformLocationWithCheck(m_shaderProgramDiffuse, "alpha");
+    m_uniformLocationDivergence_velocity = uniformLocationWithCheck(m_shaderProgramDivergence, "velocity");
+    m_uniformLocationDivergence_texelSize = uniformLocationWithCheck(m_shaderProgramDivergence, "texelSize");
+    m_uniformLocationPressure_pressure = uniformLocationWithCheck(m_shaderProgramPressure, "pressure");
+    m_uniformLocationPressure_divergence = uniformLocationWithCheck(m_shaderProgramPressure, "divergence");
+    m_uniformLocationPressure_texelSize = uniformLocationWithCheck(m_shaderProgramPressure, "texelSize");
+    m_uniformLocationProject_velocity = uniformLocationWithCheck(m_shaderProgramProject, "velocity");
+    m_uniformLocationProject_pressure = uniformLocationWithCheck(m_shaderProgramProject, "pressure");
+    m_uniformLocationProject_texelSize = uniformLocationWithCheck(m_shaderProgramProject, "texelSize");
+
+    m_gl->glGenTextures(3, m_velocity.textures.data());
+    m_gl->glGenTextures(2, m_force.textures.data());
+    m_gl->glGenTextures(2, m_density.textures.data());
+    m_gl->glGenTextures(2, m_pressure.textures.data());
+    m_gl->glGenTextures(1, &m_divergence);
+    m_gl->glGenFramebuffers(1, &m_framebuffer);
+
+    // Attribute 0 is the texel of a splat, attribute 1 its value.
+    m_gl->glGenVertexArrays(1, &m_vao);
+    m_gl->glGenBuffers(1, &m_vboSplats);
+    m_gl->glBindVertexArray(m_vao);
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_vboSplats);
+    m_gl->glEnableVertexAttribArray(0U);
+    m_gl->glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, sizeof(Splat), reinterpret_cast<GLvoid*>(0));
+    m_gl->glEnableVertexAttribArray(1U);
+    m_gl->glVertexAttribPointer(1U, 2, GL_FLOAT, GL_FALSE, sizeof(Splat), reinterpret_cast<GLvoid*>(2U * sizeof(float)));
+    m_gl->glBindVertexArray(0U);
+
+    setDIM(DIM);
+}
+
+void GpuSimulation::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    m_gl->glDeleteTextures(3, m_velocity.textures.data());
+    m_gl->glDeleteTextures(2, m_force.textures.data());
+    m_gl->glDeleteTextures(2, m_density.textures.data());
+    m_gl->glDeleteTextures(2, m_pressure.textures.data());
+    m_gl->glDeleteTextures(1, &m_divergence);
+    m_gl->glDeleteFramebuffers(1, &m_framebuffer);
+    m_gl->glDeleteVertexArrays(1, &m_vao);
+    m_gl->glDeleteBuffers(1, &m_vboSplats);
+    m_gl = nullptr;
+}
+
+void GpuSimulation::setDIM(size_t const DIM)
+{
+    m_DIM = DIM;
+    for (GLuint const texture : m_velocity.textures)
+        allocateTexture(texture, GL_RG32F, GL_RG);
+    for (size_t idx = 0U; idx < 2U; ++idx)
+    {
+        allocateTexture(m_force.textures[idx], GL_RG32F, GL_RG);
+        allocateTexture(m_density.textures[idx], GL_R32F, GL_RED);
+        allocateTexture(m_pressure.textures[idx], GL_R32F, GL_RED);
+    }
+    allocateTexture(m_divergence, GL_R32F, GL_RED);
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0U);
+
+    reset();
+}
+
+void GpuSimulation::reset()
+{
+    m_forceSplats.clear();
+    m_densitySplats.clear();
+
+    GLint framebuffer = 0;
+    m_gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+    std::array<GLfloat, 4U> const zero{0.0F, 0.0F, 0.0F, 0.0F};
+    m_gl->glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    m_gl->glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    for (PingPong const *field : {&m_velocity, &m_force, &m_density, &m_pressure})
+        for (GLuint const texture : field->textures)
+            if (texture != 0U)
+            {
+                m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+                m_gl->glClearBufferfv(GL_COLOR, 0, zero.data());
+            }
+
+    m_gl->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+}
+
+// Allocates a DIM x DIM float texture. Periodic wrapping makes the stencils and the back tracing of the advection
+// wrap around the grid, and linear filtering interpolates the advected fields.
+void GpuSimulation::allocateTexture(GLuint const texture, GLint const internalFormat, GLenum const format) const
+{
+    m_gl->glBindTexture(GL_TEXTURE_2D, texture);
+    m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl->glTexImage2D(GL_TEXTURE_2D,
+                       0,
+                       internalFormat,
+                       static_cast<GLsizei>(m_DIM),
+                       static_cast<GLsizei>(m_DIM),
+                       0,
+                       format,
+                       GL_FLOAT,
+                       static_cast<GLvoid*>(nullptr));
+}
+
+void GpuSimulation::bindTexture(GLuint const unit, GLuint const texture) const
+{
+    m_gl->glActiveTexture(GL_TEXTURE0 + unit);
+    m_gl->glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+// Runs the bound full-screen pass into texture.
+void GpuSimulation::drawInto(GLuint const texture) const
+{
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    m_gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+// Draws the splats as points into texture and clears them. The caller sets the blending.
+void GpuSimulation::drawSplats(std::vector<Splat> &splats, GLuint const texture)
+{
+    if (splats.empty())
+        return;
+
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_vboSplats);
+    m_gl->glBufferData(GL_ARRAY_BUFFER,
+                       static_cast<GLsizeiptr>(splats.size() * sizeof(Splat)),
+                       splats.data(),
+                       GL_STREAM_DRAW);
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    m_gl->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(splats.size()));
+    splats.clear();
+}
+
+void GpuSimulation::addForce(size_t const idx, float const fx, float const fy)
+{
+    m_forceSplats.push_back({static_cast<float>(idx % m_DIM), static_cast<float>(idx / m_DIM), fx, fy});
+}
+
+void GpuSimulation::injectDensity(size_t const idx, float const rhoInjected)
+{
+    m_densitySplats.push_back({static_cast<float>(idx % m_DIM), static_cast<float>(idx / m_DIM), rhoInjected, 0.0F});
+}
+
+void GpuSimulation::doOneSimulationStep(float const dt, float const viscosity)
+{
+    std::array<GLint, 4U> viewport{};
+    m_gl->glGetIntegerv(GL_VIEWPORT, viewport.data());
+    GLint framebuffer = 0;
+    m_gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+    auto const DIM = static_cast<GLsizei>(m_DIM);
+    float const texelSize = 1.0F / static_cast<float>(m_DIM);
+    m_gl->glViewport(0, 0, DIM, DIM);
+    m_gl->glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    m_gl->glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    m_gl->glBindVertexArray(m_vao);
+
+    // Input: forces are added to the existing ones, while injected density replaces the value.
+    m_shaderProgramSplat.bind();
+    m_gl->glUniform1f(m_uniformLocationSplat_DIM, static_cast<float>(m_DIM));
+    m_gl->glEnable(GL_BLEND);
+    m_gl->glBlendFunc(GL_ONE, GL_ONE);
+    drawSplats(m_forceSplats, m_force.front());
+    m_gl->glDisable(GL_BLEND);
+    drawSplats(m_densitySplats, m_density.front());
+
+    // Decay the forces and the density and apply the forces, in one pass into three targets.
+    m_shaderProgramForces.bind();
+    m_gl->glUniform1i(m_uniformLocationForces_force, 0);
+    m_gl->glUniform1i(m_uniformLocationForces_velocity, 1);
+    m_gl->glUniform1i(m_uniformLocationForces_density, 2);
+    m_gl->glUniform1f(m_uniformLocationForces_texelSize, texelSize);
+    m_gl->glUniform1f(m_uniformLocationForces_dt, dt);
+    bindTexture(0U, m_force.front());
+    bindTexture(1U, m_velocity.front());
+    bindTexture(2U, m_density.front());
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_force.back(), 0);
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_velocity.back(), 0);
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_density.back(), 0);
+    std::array<GLenum, 3U> const drawBuffers{GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    m_gl->glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+    m_gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 0U, 0);
+    m_gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 0U, 0);
+    m_gl->glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    m_force.swap();
+    m_velocity.swap();
+    m_density.swap(); // Now holds rho0 of Simulation.
+
+    // Advect the velocity along itself.
+    m_shaderProgramAdvect.bind();
+    m_gl->glUniform1i(m_uniformLocationAdvect_field, 0);
+    m_gl->glUniform1i(m_uniformLocationAdvect_velocity, 1);
+    m_gl->glUniform1f(m_uniformLocationAdvect_texelSize, texelSize);
+    m_gl->glUniform1f(m_uniformLocationAdvect_dt, dt);
+    bindTexture(0U, m_velocity.front());
+    bindTexture(1U, m_velocity.front());
+    drawInto(m_velocity.back());
+    m_velocity.swap();
+
+    // Implicit diffusion, (1 - alpha * laplacian) v = v_advected. The wave numbers of the FFT solver correspond to a
+    // periodic domain of length 2 pi.
+    if (viscosity > 0.0F)
+    {
+        float const cellSize = 2.0F * constants::pi / static_cast<float>(m_DIM);
+
+        // The advected velocity is the right-hand side of every iteration and the first guess. It moves into the
+        // third texture, so the iterations can ping-pong between the other two.
+        std::swap(m_velocity.textures[m_velocity.current], m_velocity.textures[2U]);
+        GLuint const rightHandSide = m_velocity.textures[2U];
+
+        m_shaderProgramDiffuse.bind();
+        m_gl->glUniform1i(m_uniformLocationDiffuse_velocity, 0);
+        m_gl->glUniform1i(m_uniformLocationDiffuse_rightHandSide, 1);
+        m_gl->glUniform1f(m_uniformLocationDiffuse_texelSize, texelSize);
+        m_gl->glUniform1f(m_uniformLocationDiffuse_alpha, viscosity * dt / (cellSize * cellSize));
+        bindTexture(1U, rightHandSide);
+
+        GLuint guess = rightHandSide;
+        for (int iteration = 0; iteration < s_diffusionIterations; ++iteration)
+        {
+            bindTexture(0U, guess);
+            drawInto(m_velocity.back());
+            m_velocity.swap();
+            guess = m_velocity.front();
+        }
+    }
+
+    // Projection: solve laplacian p = div v and subtract grad p. The cell size cancels out.
+    m_shaderProgramDivergence.bind();
+    m_gl->glUniform1i(m_uniformLocationDivergence_velocity, 0);
+    m_gl->glUniform1f(m_uniformLocationDivergence_texelSize, texelSize);
+    bindTexture(0U, m_velocity.front());
+    drawInto(m_divergence);
+
+    m_shaderProgramPressure.bind();
+    m_gl->glUniform1i(m_uniformLocationPressure_pressure, 0);
+    m_gl->glUniform1i(m_uniformLocationPressure_divergence, 1);
+    m_gl->glUniform1f(m_uniformLocationPressure_texelSize, texelSize);
+    bindTexture(1U, m_divergence);
+    for (int iteration = 0; iteration < s_pressureIterations; ++iteration)
+    {
+        bindTexture(0U, m_pressure.front());
+        drawInto(m_pressure.back());
+        m_pressure.swap();
+    }
+
+    m_shaderProgramProject.bind();
+    m_gl->glUniform1i(m_uniformLocationProject_velocity, 0);
+    m_gl->glUniform1i(m_uniformLocationProject_pressure, 1);
+    m_gl->glUniform1f(m_uniformLocationProject_texelSize, texelSize);
+    bindTexture(0U, m_velocity.front());
+    bindTexture(1U, m_pressure.front());
+    drawInto(m_velocity.back());
+    m_velocity.swap();
+
+    // Advect the density along the new velocity.
+    m_shaderProgramAdvect.bind();
+    bindTexture(0U, m_density.front());
+    bindTexture(1U, m_velocity.front());
+    drawInto(m_density.back());
+    m_density.swap();
+
+    m_gl->glActiveTexture(GL_TEXTURE0);
+    m_gl->glBindVertexArray(0U);
+    m_gl->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    m_gl->glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// Getters
+size_t GpuSimulation::DIM() const
+{
+    return m_DIM;
+}
+
+GLuint GpuSimulation::densityTexture() const
+{
+    return m_density.front();
+}
+
+GLuint GpuSimulation::velocityTexture() const
+{
+    return m_velocity.front();
+}
+
+// The unused third textures of the fields other than the velocity are left out.
+std::vector<GLuint> GpuSimulation::textures() const
+{
+    std::vector<GLuint> textures{m_divergence};
+    for (PingPong const *field : {&m_velocity, &m_force, &m_density, &m_pressure})
+        for (GLuint const texture : field->textures)
+            if (texture != 0U)
+                textures.push_back(texture);
+
+    return textures;
+}
+
+GLuint GpuSimulation::splatBuffer() const
+{
+    return m_vboSplats;
+}
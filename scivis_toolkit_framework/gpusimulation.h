@@ -0,0 +1,127 @@
+#ifndef GPUSIMULATION_H
+#define GPUSIMULATION_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// The stable fluids solver of Simulation, run as fragment shader passes on DIM x DIM float textures. Velocity, forces
+// and density never leave the GPU, the visualization samples densityTexture() directly.
+// A step follows Simulation::doOneSimulationStep: decay and apply the forces, advect the velocity along itself, diffuse
+// and project it, then advect the density along the result. OpenGL 3.3 has no compute shaders, so instead of the FFT
+// the viscosity is an implicit diffusion and the projection a pressure solve, both with Jacobi iterations. The
+// pressure is kept between steps as the initial guess of the next solve. The grid is periodic, like the FFT one.
+//
+// Every function has to be called with the context current, and restores the framebuffer and viewport it found.
+class GpuSimulation
+{
+    // Two textures per field, read from one and written into the other. The velocity has a third one that holds the
+    // right-hand side of the diffusion.
+    struct PingPong
+    {
+        std::array<GLuint, 3U> textures{};
+        size_t current = 0U;
+
+        [[nodiscard]] GLuint front() const;
+        [[nodiscard]] GLuint back() const;
+        void swap();
+    };
+
+    // One point written into a field by the mouse input: a texel and the value written or added there.
+    struct Splat
+    {
+        float x;
+        float y;
+        float value0;
+        float value1;
+    };
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    size_t m_DIM = 0U;
+
+    PingPong m_velocity;
+    PingPong m_force;
+    PingPong m_density;
+    PingPong m_pressure;
+    GLuint m_divergence = 0U;
+
+    GLuint m_framebuffer = 0U;
+    GLuint m_vao = 0U;
+    GLuint m_vboSplats = 0U;
+
+    std::vector<Splat> m_forceSplats;
+    std::vector<Splat> m_densitySplats;
+
+    QOpenGLShaderProgram m_shaderProgramSplat;
+    QOpenGLShaderProgram m_shaderProgramForces;
+    QOpenGLShaderProgram m_shaderProgramAdvect;
+    QOpenGLShaderProgram m_shaderProgramDiffuse;
+    QOpenGLShaderProgram m_shaderProgramDivergence;
+    QOpenGLShaderProgram m_shaderProgramPressure;
+    QOpenGLShaderProgram m_shaderProgramProject;
+
+    GLint m_uniformLocationSplat_DIM;
+    GLint m_uniformLocationForces_force;
+    GLint m_uniformLocationForces_velocity;
+    GLint m_uniformLocationForces_density;
+    GLint m_uniformLocationForces_texelSize;
+    GLint m_uniformLocationForces_dt;
+    GLint m_uniformLocationAdvect_field;
+    GLint m_uniformLocationAdvect_velocity;
+    GLint m_uniformLocationAdvect_texelSize;
+    GLint m_uniformLocationAdvect_dt;
+    GLint m_uniformLocationDiffuse_velocity;
+    GLint m_uniformLocationDiffuse_rightHandSide;
+    GLint m_uniformLocationDiffuse_texelSize;
+    GLint m_uniformLocationDiffuse_alpha;
+    GLint m_uniformLocationDivergence_velocity;
+    GLint m_uniformLocationDivergence_texelSize;
+    GLint m_uniformLocationPressure_pressure;
+    GLint m_uniformLocationPressure_divergence;
+    GLint m_uniformLocationPressure_texelSize;
+    GLint m_uniformLocationProject_velocity;
+    GLint m_uniformLocationProject_pressure;
+    GLint m_uniformLocationProject_texelSize;
+
+    static constexpr int s_diffusionIterations = 8;
+    static constexpr int s_pressureIterations = 40;
+
+    void allocateTexture(GLuint const texture, GLint const internalFormat, GLenum const format) const;
+    void bindTexture(GLuint const unit, GLuint const texture) const;
+    void drawInto(GLuint const texture) const;
+    void drawSplats(std::vector<Splat> &splats, GLuint const texture);
+
+public:
+    GpuSimulation() = default;
+    GpuSimulation(GpuSimulation const&) = delete;
+    GpuSimulation& operator=(GpuSimulation const&) = delete;
+
+    // Compiles the shader programs and creates the textures of a DIM x DIM grid.
+    void create(QOpenGLFunctions_3_3_Core * const gl, size_t const DIM);
+    void destroy();
+
+    // Reallocates the textures for another grid size, which clears all fields.
+    void setDIM(size_t const DIM);
+    void reset();
+
+    // Input, applied at the start of the next step. Mirrors SimulationWorker::addForce and injectDensity.
+    void addForce(size_t const idx, float const fx, float const fy);
+    void injectDensity(size_t const idx, float const rhoInjected);
+
+    void doOneSimulationStep(float const dt, float const viscosity);
+
+    // Getters
+    [[nodiscard]] size_t DIM() const;
+
+    // R32F texture of the density and RG32F texture of the velocity after the last step, with GL_REPEAT wrapping.
+    [[nodiscard]] GLuint densityTexture() const;
+    [[nodiscard]] GLuint velocityTexture() const;
+    // Every texture and buffer it allocates, for the GPU memory bookkeeping.
+    [[nodiscard]] std::vector<GLuint> textures() const;
+    [[nodiscard]] GLuint splatBuffer() const;
+};
+
+#endif // GPUSIMULATION_H
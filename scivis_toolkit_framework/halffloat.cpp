@@ -0,0 +1,93 @@
+#include "halffloat.h"
+
+#include <cstring>
+
+HalfFloat::Bits HalfFloat::fromFloat(float const value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    auto const sign = static_cast<Bits>((bits >> 16U) & 0x8000U);
+    std::uint32_t const magnitude = bits & 0x7FFFFFFFU;
+
+    // Infinity stays infinity, NaN stays a (quiet) NaN.
+    if (magnitude >= 0x7F800000U)
+        return static_cast<Bits>(sign | 0x7C00U | (magnitude > 0x7F800000U ? 0x0200U : 0x0000U));
+
+    // From halfway between 65504 and the next (not representable) half upwards, the value rounds to infinity.
+    if (magnitude >= 0x477FF000U)
+        return static_cast<Bits>(sign | 0x7C00U);
+
+    // Below the smallest normal half (2^-14): a subnormal, or zero from halfway to the smallest subnormal (2^-24) down.
+    if (magnitude < 0x38800000U)
+    {
+        if (magnitude <= 0x33000000U)
+            return sign;
+
+        std::uint32_t const exponent = magnitude >> 23U;
+        std::uint32_t const mantissa = (magnitude & 0x007FFFFFU) | 0x00800000U;
+        std::uint32_t const shift = 126U - exponent;
+
+        std::uint32_t result = mantissa >> shift;
+        std::uint32_t const remainder = mantissa & ((1U << shift) - 1U);
+        std::uint32_t const halfway = 1U << (shift - 1U);
+        if (remainder > halfway || (remainder == halfway && (result & 1U) != 0U))
+            ++result; // Can carry into the exponent, which gives the smallest normal half.
+
+        return static_cast<Bits>(sign | result);
+    }
+
+    // Normal: rebias the exponent from 127 to 15 and round the mantissa from 23 to 10 bits. A carry out of the mantissa
+    // correctly increments the exponent.
+    std::uint32_t const rebiased = magnitude - 0x38000000U;
+    std::uint32_t result = rebiased >> 13U;
+    std::uint32_t const remainder = rebiased & 0x1FFFU;
+    if (remainder > 0x1000U || (remainder == 0x1000U && (result & 1U) != 0U))
+        ++result;
+
+    return static_cast<Bits>(sign | result);
+}
+
+float HalfFloat::toFloat(Bits const bits)
+{
+    std::uint32_t const sign = static_cast<std::uint32_t>(bits & 0x8000U) << 16U;
+    std::uint32_t exponent = (bits >> 10U) & 0x1FU;
+    std::uint32_t mantissa = bits & 0x03FFU;
+
+    std::uint32_t result;
+    if (exponent == 0x1FU)
+        result = sign | 0x7F800000U | (mantissa << 13U);
+    else if (exponent != 0U)
+        result = sign | ((exponent + 112U) << 23U) | (mantissa << 13U);
+    else if (mantissa == 0U)
+        result = sign;
+    else
+    {
+        // Subnormal: shift the mantissa up until its leading bit is the implicit one of a normal float.
+        exponent = 113U;
+        while ((mantissa & 0x0400U) == 0U)
+        {
+            mantissa <<= 1U;
+            --exponent;
+        }
+        result = sign | (exponent << 23U) | ((mantissa & 0x03FFU) << 13U);
+    }
+
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+void HalfFloat::fromFloats(std::vector<float> const &values, std::vector<Bits> &halves)
+{
+    halves.resize(values.size());
+    for (size_t idx = 0U; idx < values.size(); ++idx)
+        halves[idx] = fromFloat(values[idx]);
+}
+
+void HalfFloat::toFloats(std::vector<Bits> const &halves, std::vector<float> &values)
+{
+    values.resize(halves.size());
+    for (size_t idx = 0U; idx < halves.size(); ++idx)
+        values[idx] = toFloat(halves[idx]);
+}
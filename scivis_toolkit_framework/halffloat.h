@@ -0,0 +1,25 @@
+#ifndef HALFFLOAT_H
+#define HALFFLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Conversion between float and the IEEE 754 half precision (binary16) format, as read by OpenGL with GL_HALF_FLOAT.
+// A half has 11 significant bits (about 3 decimal digits) and a range of 6.1e-5 to 65504, with subnormals down to
+// 6e-8. Conversion to half rounds to the nearest value, ties to even; values beyond the range become infinity.
+// Halves are only a storage format: all arithmetic is done on the floats they are converted back into.
+class HalfFloat
+{
+public:
+    using Bits = std::uint16_t;
+
+    [[nodiscard]] static Bits fromFloat(float const value);
+    [[nodiscard]] static float toFloat(Bits const bits);
+
+    // Convert whole fields, resizing the destination to the size of the source.
+    static void fromFloats(std::vector<float> const &values, std::vector<Bits> &halves);
+    static void toFloats(std::vector<Bits> const &halves, std::vector<float> &values);
+};
+
+#endif // HALFFLOAT_H
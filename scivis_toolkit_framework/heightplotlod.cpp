@@ -0,0 +1,198 @@
+#include "heightplotlod.h"
+
+#include <QVector3D>
+
+#include <algorithm>
+#include <cmath>
+
+bool HeightplotLod::setShape(size_t const DIMX, size_t const DIMY, unsigned int const restartIndex)
+{
+    if (DIMX == m_DIMX && DIMY == m_DIMY && !m_indices.empty())
+        return false;
+
+    m_DIMX = DIMX;
+    m_DIMY = DIMY;
+    size_t const numberOfCellsX = DIMX > 1U ? DIMX - 1U : 0U;
+    size_t const numberOfCellsY = DIMY > 1U ? DIMY - 1U : 0U;
+
+    // Keep the number of patches (and thus draw calls) along the longer side around 16, but never exceed the grid.
+    m_patchSize = 16U;
+    while (std::max(numberOfCellsX, numberOfCellsY) / m_patchSize > 16U)
+        m_patchSize *= 2U;
+    while (m_patchSize > 1U && m_patchSize > std::min(numberOfCellsX, numberOfCellsY))
+        m_patchSize /= 2U;
+
+    m_numberOfFullPatchesX = numberOfCellsX / m_patchSize;
+    m_numberOfFullPatchesY = numberOfCellsY / m_patchSize;
+    m_remainderX = numberOfCellsX % m_patchSize;
+    m_remainderY = numberOfCellsY % m_patchSize;
+
+    m_indices.clear();
+    m_fullPatterns.clear();
+    for (size_t step = 1U; step <= m_patchSize; step *= 2U)
+        m_fullPatterns.push_back(addPattern(m_patchSize, m_patchSize, step, restartIndex));
+
+    if (m_remainderX > 0U)
+        m_rightPattern = addPattern(m_remainderX, m_patchSize, 1U, restartIndex);
+    if (m_remainderY > 0U)
+        m_topPattern = addPattern(m_patchSize, m_remainderY, 1U, restartIndex);
+    if (m_remainderX > 0U && m_remainderY > 0U)
+        m_cornerPattern = addPattern(m_remainderX, m_remainderY, 1U, restartIndex);
+
+    return true;
+}
+
+// Triangle strips over width x height cells with the given vertex step, one strip per row of cells, like the strips of
+// the full grid in Visualization::opengl_setupScalarData.
+HeightplotLod::Pattern HeightplotLod::addPattern(size_t const width, size_t const height, size_t const step,
+                                                 unsigned int const restartIndex)
+{
+    Pattern pattern;
+    pattern.firstIndex = m_indices.size();
+
+    for (size_t j = 0U; j < height; j += step)
+    {
+        if (j != 0U)
+            m_indices.push_back(restartIndex);
+
+        for (size_t i = 0U; i <= width; i += step)
+        {
+            m_indices.push_back(static_cast<unsigned int>(j * m_DIMX + i));
+            m_indices.push_back(static_cast<unsigned int>((j + step) * m_DIMX + i));
+        }
+    }
+
+    pattern.indexCount = m_indices.size() - pattern.firstIndex;
+    return pattern;
+}
+
+size_t HeightplotLod::numberOfPatchesX() const
+{
+    return m_numberOfFullPatchesX + (m_remainderX > 0U ? 1U : 0U);
+}
+
+size_t HeightplotLod::numberOfPatchesY() const
+{
+    return m_numberOfFullPatchesY + (m_remainderY > 0U ? 1U : 0U);
+}
+
+std::vector<HeightplotLod::Patch> const &HeightplotLod::selectPatches(std::vector<float> const &heights,
+                                                                      float const heightScale,
+                                                                      QMatrix4x4 const &view,
+                                                                      float const cellWidth,
+                                                                      float const cellHeight,
+                                                                      float const pixelsPerUnit)
+{
+    size_t const numberOfPatchesX = this->numberOfPatchesX();
+    size_t const numberOfPatchesY = this->numberOfPatchesY();
+    m_patches.resize(numberOfPatchesX * numberOfPatchesY);
+
+    for (size_t py = 0U; py < numberOfPatchesY; ++py)
+    {
+        for (size_t px = 0U; px < numberOfPatchesX; ++px)
+        {
+            Patch &patch = m_patches[py * numberOfPatchesX + px];
+            bool const isFullX = px < m_numberOfFullPatchesX;
+            bool const isFullY = py < m_numberOfFullPatchesY;
+
+            patch.origin = {static_cast<int>(px * m_patchSize), static_cast<int>(py * m_patchSize)};
+            patch.size = {static_cast<int>(isFullX ? m_patchSize : m_remainderX),
+                          static_cast<int>(isFullY ? m_patchSize : m_remainderY)};
+            patch.baseVertex = static_cast<size_t>(patch.origin[1]) * m_DIMX + static_cast<size_t>(patch.origin[0]);
+            patch.neighbourSteps = {0, 0, 0, 0};
+
+            Pattern pattern = isFullX ? m_topPattern : m_cornerPattern;
+            if (isFullY)
+                pattern = isFullX ? m_fullPatterns.front() : m_rightPattern;
+
+            patch.step = 1;
+            if (isFullX && isFullY)
+            {
+                // The steepest height difference between neighbouring grid points, and the height range.
+                float maxDifference = 0.0F;
+                float minHeight = heights[patch.baseVertex];
+                float maxHeight = minHeight;
+                for (size_t j = 0U; j <= m_patchSize; ++j)
+                {
+                    for (size_t i = 0U; i <= m_patchSize; ++i)
+                    {
+                        size_t const idx = patch.baseVertex + j * m_DIMX + i;
+                        float const height = heights[idx];
+                        minHeight = std::min(minHeight, height);
+                        maxHeight = std::max(maxHeight, height);
+                        if (i < m_patchSize)
+                            maxDifference = std::max(maxDifference, std::abs(heights[idx + 1U] - height));
+                        if (j < m_patchSize)
+                            maxDifference = std::max(maxDifference, std::abs(heights[idx + m_DIMX] - height));
+                    }
+                }
+                maxDifference *= heightScale;
+
+                // Distance from the eye to the nearest point of the bounding sphere of the patch.
+                float const halfWidth = 0.5F * cellWidth * static_cast<float>(m_patchSize);
+                float const halfHeight = 0.5F * cellHeight * static_cast<float>(m_patchSize);
+                QVector3D const center{cellWidth * (static_cast<float>(patch.origin[0]) + 1.0F) - 1.0F + halfWidth,
+                                       cellHeight * (static_cast<float>(patch.origin[1]) + 1.0F) - 1.0F + halfHeight,
+                                       0.5F * heightScale * (minHeight + maxHeight)};
+                float const radius = std::sqrt(halfWidth * halfWidth + halfHeight * halfHeight) +
+                                     0.5F * heightScale * (maxHeight - minHeight);
+                float const distance = std::max(-view.map(center).z() - radius, 0.2F);
+
+                // Linear interpolation over `step` cells deviates at most step / 2 * maxDifference from the grid.
+                for (size_t level = m_fullPatterns.size() - 1U; level > 0U; --level)
+                {
+                    float const step = static_cast<float>(1U << level);
+                    float const screenError = 0.5F * step * maxDifference * pixelsPerUnit / distance;
+                    if (screenError <= s_maxScreenError)
+                    {
+                        patch.step = static_cast<int>(step);
+                        pattern = m_fullPatterns[level];
+                        break;
+                    }
+                }
+            }
+
+            patch.firstIndex = pattern.firstIndex;
+            patch.indexCount = pattern.indexCount;
+        }
+    }
+
+    // The vertices on an edge shared with a coarser patch are moved onto that patch's edge in the vertex shader.
+    auto const neighbourStep = [&](Patch const &patch, long const px, long const py)
+    {
+        auto const nx = static_cast<long>(numberOfPatchesX);
+        auto const ny = static_cast<long>(numberOfPatchesY);
+        if (px < 0 || py < 0 || px >= nx || py >= ny)
+            return 0;
+
+        int const step = m_patches[static_cast<size_t>(py * nx + px)].step;
+        return step > patch.step ? step : 0;
+    };
+
+    for (size_t py = 0U; py < numberOfPatchesY; ++py)
+    {
+        for (size_t px = 0U; px < numberOfPatchesX; ++px)
+        {
+            Patch &patch = m_patches[py * numberOfPatchesX + px];
+            auto const x = static_cast<long>(px);
+            auto const y = static_cast<long>(py);
+            patch.neighbourSteps = {neighbourStep(patch, x - 1, y),
+                                    neighbourStep(patch, x + 1, y),
+                                    neighbourStep(patch, x, y - 1),
+                                    neighbourStep(patch, x, y + 1)};
+        }
+    }
+
+    return m_patches;
+}
+
+// Getters
+std::vector<unsigned int> const &HeightplotLod::indices() const
+{
+    return m_indices;
+}
+
+size_t HeightplotLod::patchSize() const
+{
+    return m_patchSize;
+}
@@ -0,0 +1,79 @@
+#ifndef HEIGHTPLOTLOD_H
+#define HEIGHTPLOTLOD_H
+
+#include <QMatrix4x4>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Chunked level of detail for the height plot.
+// The grid is split into square patches of patchSize() cells (plus narrower patches at the right and top border).
+// A patch is drawn with a vertex step of 1, 2, 4, ... grid points. The index pattern of each step is relative to the
+// first vertex of a patch, so one small set of patterns serves all patches through glDrawElementsBaseVertex.
+// The step of a patch is the largest one whose screen-space error stays below maxScreenError pixels. The error of a step is
+// bounded by the steepest height difference between two neighbouring grid points in the patch, so flat and distant
+// patches become coarse. The border patches always use step 1.
+class HeightplotLod
+{
+public:
+    struct Patch
+    {
+        size_t baseVertex;                 // Grid index of the bottom-left vertex.
+        size_t firstIndex;                 // First index of the pattern in indices().
+        size_t indexCount;
+        std::array<int, 2U> origin;        // Grid coordinates of the bottom-left vertex.
+        std::array<int, 2U> size;          // In cells.
+        int step;
+        std::array<int, 4U> neighbourSteps; // Left, right, bottom, top. Only set for coarser neighbours, 0 otherwise.
+    };
+
+private:
+    struct Pattern
+    {
+        size_t firstIndex = 0U;
+        size_t indexCount = 0U;
+    };
+
+    size_t m_DIMX = 0U;
+    size_t m_DIMY = 0U;
+    size_t m_patchSize = 1U;
+    size_t m_numberOfFullPatchesX = 0U;
+    size_t m_numberOfFullPatchesY = 0U;
+    size_t m_remainderX = 0U;          // Width of the border patches at the right, in cells.
+    size_t m_remainderY = 0U;          // Height of the border patches at the top, in cells.
+
+    std::vector<unsigned int> m_indices;
+    std::vector<Pattern> m_fullPatterns; // One per step 1, 2, 4, ..., patchSize.
+    Pattern m_rightPattern;              // remainderX x patchSize cells, step 1.
+    Pattern m_topPattern;                // patchSize x remainderY cells, step 1.
+    Pattern m_cornerPattern;             // remainderX x remainderY cells, step 1.
+
+    std::vector<Patch> m_patches;
+
+    Pattern addPattern(size_t const width, size_t const height, size_t const step, unsigned int const restartIndex);
+    [[nodiscard]] size_t numberOfPatchesX() const;
+    [[nodiscard]] size_t numberOfPatchesY() const;
+
+public:
+    static constexpr float s_maxScreenError = 1.0F; // In pixels.
+
+    // Rebuilds the index patterns for a DIMX * DIMY grid. Returns whether the shape changed.
+    bool setShape(size_t const DIMX, size_t const DIMY, unsigned int const restartIndex);
+
+    // Chooses the step of every patch for the given (scaled) heights and view.
+    // The grid points lie at (cellWidth * (i + 1) - 1, cellHeight * (j + 1) - 1); pixelsPerUnit converts a size at
+    // distance 1 from the eye to pixels.
+    std::vector<Patch> const &selectPatches(std::vector<float> const &heights,
+                                            float const heightScale,
+                                            QMatrix4x4 const &view,
+                                            float const cellWidth,
+                                            float const cellHeight,
+                                            float const pixelsPerUnit);
+
+    // Getters
+    [[nodiscard]] std::vector<unsigned int> const &indices() const;
+    [[nodiscard]] size_t patchSize() const;
+};
+
+#endif // HEIGHTPLOTLOD_H
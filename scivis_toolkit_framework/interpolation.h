@@ -1,6 +1,8 @@
 #ifndef INTERPOLATION_H
 #define INTERPOLATION_H
 
+#include "resampler.h"
+
 #include <cmath>
 #include <vector>
 
@@ -10,17 +12,45 @@ namespace interpolation
 {
     /* Input
      * values: You may assume this is of the type std::vector<float>. This contains the values (e.g. densities) to be interpolated.
-     * sideSize: The input size of the square matrix "values". This is equal to m_DIM in the Simulation and Visualization classes.
+     * sideSize: The input size of the square matrix "values". This is equal to m_DIMX and m_DIMY of a square grid in the Simulation and Visualization classes.
      * xMax, yMax: The desired dimensions of the output vector. xMax is the horizontal size (number of columns), yMax is the vertical size (number of rows).
      *
      * Output
      * interpolatedValues: A 1D row-major container of std::vector<float> type containing the interpolated values.
+     *
+     * This builds the resampling tables for a single use. Code that resamples every frame should keep a Resampler.
      */
     template <typename inVector>
     std::vector<float> interpolateSquareVector(inVector const &values, size_t const sideSize, size_t const xMax, size_t const yMax)
     {
         std::vector<float> interpolatedValues;
+        if (values.size() < sideSize * sideSize)
+        {
+            qDebug() << "interpolateSquareVector: input has" << values.size() << "values, expected" << sideSize * sideSize;
+            return interpolatedValues;
+        }
+
+        Resampler resampler;
+        resampler.setShape(sideSize, xMax, yMax);
+        resampler.resample(values.data(), interpolatedValues);
+        return interpolatedValues;
+    }
+
+    // The same for a rectangular grid of width * height values, as the simulation uses with DIMX != DIMY.
+    template <typename inVector>
+    std::vector<float> interpolateGridVector(inVector const &values, size_t const width, size_t const height,
+                                             size_t const xMax, size_t const yMax)
+    {
+        std::vector<float> interpolatedValues;
+        if (values.size() < width * height)
+        {
+            qDebug() << "interpolateGridVector: input has" << values.size() << "values, expected" << width * height;
+            return interpolatedValues;
+        }
 
+        Resampler resampler;
+        resampler.setShape(width, height, xMax, yMax);
+        resampler.resample(values.data(), interpolatedValues);
         return interpolatedValues;
     }
 }
@@ -0,0 +1,170 @@
+#include "isosurfacemesh.h"
+
+#include "shaderprogram.h"
+
+#include <algorithm>
+
+using shaderprogram::uniformLocationWithCheck;
+
+void IsosurfaceMesh::create(QOpenGLFunctions_3_3_Core * const gl)
+{
+    m_gl = gl;
+
+    m_shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/isosurface.vert");
+    m_shaderProgram.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/isosurface.frag");
+    m_shaderProgram.link();
+
+    m_uniformLocation_viewProjection = uniformLocationWithCheck(m_shaderProgram, "viewProjection");
+    m_uniformLocation_eye = uniformLocationWithCheck(m_shaderProgram, "eye");
+    m_uniformLocation_color = uniformLocationWithCheck(m_shaderProgram, "color");
+
+    // Attribute 0 is the position, 1 the normal, see MarchingCubes::Vertex.
+    m_gl->glGenVertexArrays(1, &m_vao);
+    m_gl->glGenBuffers(1, &m_vbo);
+    m_gl->glGenBuffers(1, &m_ebo);
+    m_gl->glBindVertexArray(m_vao);
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    m_gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    m_gl->glEnableVertexAttribArray(0U);
+    m_gl->glVertexAttribPointer(0U, 3, GL_FLOAT, GL_FALSE, sizeof(MarchingCubes::Vertex),
+                                reinterpret_cast<GLvoid*>(offsetof(MarchingCubes::Vertex, x)));
+    m_gl->glEnableVertexAttribArray(1U);
+    m_gl->glVertexAttribPointer(1U, 3, GL_FLOAT, GL_FALSE, sizeof(MarchingCubes::Vertex),
+                                reinterpret_cast<GLvoid*>(offsetof(MarchingCubes::Vertex, nx)));
+    m_gl->glBindVertexArray(0U);
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, 0U);
+}
+
+void IsosurfaceMesh::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    m_gl->glDeleteVertexArrays(1, &m_vao);
+    m_gl->glDeleteBuffers(1, &m_vbo);
+    m_gl->glDeleteBuffers(1, &m_ebo);
+    m_ranges.clear();
+    updateDraws();
+    m_gl = nullptr;
+}
+
+// Expects the buffers to be bound.
+void IsosurfaceMesh::uploadBrick(MarchingCubes::Brick const &brick, Range const &range) const
+{
+    if (brick.indices.empty())
+        return;
+
+    m_gl->glBufferSubData(GL_ARRAY_BUFFER,
+                          static_cast<GLintptr>(range.firstVertex * sizeof(MarchingCubes::Vertex)),
+                          static_cast<GLsizeiptr>(brick.vertices.size() * sizeof(MarchingCubes::Vertex)),
+                          brick.vertices.data());
+    m_gl->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                          static_cast<GLintptr>(range.firstIndex * sizeof(std::uint32_t)),
+                          static_cast<GLsizeiptr>(brick.indices.size() * sizeof(std::uint32_t)),
+                          brick.indices.data());
+}
+
+// Expects the buffers to be bound. Empty bricks get no range until they hold triangles.
+void IsosurfaceMesh::relayout(std::vector<MarchingCubes::Brick> const &bricks)
+{
+    m_ranges.assign(bricks.size(), Range{});
+    size_t numberOfVertices = 0U;
+    size_t numberOfIndices = 0U;
+    for (size_t brickIdx = 0U; brickIdx < bricks.size(); ++brickIdx)
+    {
+        MarchingCubes::Brick const &brick = bricks[brickIdx];
+        if (brick.indices.empty())
+            continue;
+
+        Range &range = m_ranges[brickIdx];
+        range.firstVertex = numberOfVertices;
+        range.vertexCapacity = std::max(brick.vertices.size() + brick.vertices.size() / s_growthDivisor,
+                                        s_minVertexCapacity);
+        range.firstIndex = numberOfIndices;
+        range.indexCapacity = std::max(brick.indices.size() + brick.indices.size() / s_growthDivisor,
+                                       s_minIndexCapacity);
+        range.numberOfIndices = brick.indices.size();
+        numberOfVertices += range.vertexCapacity;
+        numberOfIndices += range.indexCapacity;
+    }
+
+    m_gl->glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(numberOfVertices * sizeof(MarchingCubes::Vertex)),
+                       nullptr, GL_DYNAMIC_DRAW);
+    m_gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(numberOfIndices * sizeof(std::uint32_t)),
+                       nullptr, GL_DYNAMIC_DRAW);
+    for (size_t brickIdx = 0U; brickIdx < bricks.size(); ++brickIdx)
+        uploadBrick(bricks[brickIdx], m_ranges[brickIdx]);
+}
+
+void IsosurfaceMesh::updateDraws()
+{
+    m_counts.clear();
+    m_indexOffsets.clear();
+    m_baseVertices.clear();
+    for (Range const &range : m_ranges)
+    {
+        if (range.numberOfIndices == 0U)
+            continue;
+
+        m_counts.push_back(static_cast<GLsizei>(range.numberOfIndices));
+        m_indexOffsets.push_back(reinterpret_cast<void const*>(range.firstIndex * sizeof(std::uint32_t)));
+        m_baseVertices.push_back(static_cast<GLint>(range.firstVertex));
+    }
+}
+
+void IsosurfaceMesh::update(MarchingCubes const &marchingCubes)
+{
+    std::vector<MarchingCubes::Brick> const &bricks = marchingCubes.bricks();
+    std::vector<size_t> const &changedBricks = marchingCubes.changedBricks();
+    if (changedBricks.empty() && bricks.size() == m_ranges.size())
+        return;
+
+    // The element array buffer binding belongs to the vertex array.
+    m_gl->glBindVertexArray(m_vao);
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+    bool const fits = bricks.size() == m_ranges.size() &&
+                      std::all_of(changedBricks.begin(), changedBricks.end(), [&](size_t const brickIdx)
+                      {
+                          return bricks[brickIdx].vertices.size() <= m_ranges[brickIdx].vertexCapacity &&
+                                 bricks[brickIdx].indices.size() <= m_ranges[brickIdx].indexCapacity;
+                      });
+    if (fits)
+        for (size_t const brickIdx : changedBricks)
+        {
+            m_ranges[brickIdx].numberOfIndices = bricks[brickIdx].indices.size();
+            uploadBrick(bricks[brickIdx], m_ranges[brickIdx]);
+        }
+    else
+        relayout(bricks);
+
+    m_gl->glBindVertexArray(0U);
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, 0U);
+
+    updateDraws();
+}
+
+void IsosurfaceMesh::draw(QMatrix4x4 const &viewProjection, QVector3D const &eye, QVector3D const &color)
+{
+    if (m_counts.empty())
+        return;
+
+    m_shaderProgram.bind();
+    m_gl->glUniformMatrix4fv(m_uniformLocation_viewProjection, 1, GL_FALSE, viewProjection.data());
+    m_gl->glUniform3f(m_uniformLocation_eye, eye.x(), eye.y(), eye.z());
+    m_gl->glUniform3f(m_uniformLocation_color, color.x(), color.y(), color.z());
+
+    m_gl->glEnable(GL_DEPTH_TEST);
+    m_gl->glBindVertexArray(m_vao);
+    m_gl->glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_counts.data(), GL_UNSIGNED_INT,
+                                        m_indexOffsets.data(),
+                                        static_cast<GLsizei>(m_counts.size()), m_baseVertices.data());
+    m_gl->glBindVertexArray(0U);
+    m_gl->glDisable(GL_DEPTH_TEST);
+}
+
+// Getters
+std::array<GLuint, 2U> IsosurfaceMesh::buffers() const
+{
+    return {m_vbo, m_ebo};
+}
@@ -0,0 +1,79 @@
+#ifndef ISOSURFACEMESH_H
+#define ISOSURFACEMESH_H
+
+#include "marchingcubes.h"
+
+#include <QMatrix4x4>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QVector3D>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// The GPU copy of the bricks of a MarchingCubes, drawn lit in the volume rendering view.
+// All bricks share one vertex and one index buffer, in which every brick owns a range with some room to grow. The
+// indices of a brick stay relative to its first vertex and are drawn with glMultiDrawElementsBaseVertex, so a brick
+// that changes is uploaded on its own as long as it fits its range. Only when one outgrows it are the ranges laid out
+// anew and everything is uploaded again.
+//
+// Every function has to be called with the context current.
+class IsosurfaceMesh
+{
+    // Of vertices and indices, in elements.
+    struct Range
+    {
+        size_t firstVertex = 0U;
+        size_t vertexCapacity = 0U;
+        size_t firstIndex = 0U;
+        size_t indexCapacity = 0U;
+        size_t numberOfIndices = 0U;
+    };
+
+    // The room a range leaves for growth, and its least capacity, so that small bricks can grow as well.
+    static constexpr size_t s_growthDivisor = 2U;
+    static constexpr size_t s_minVertexCapacity = 64U;
+    static constexpr size_t s_minIndexCapacity = 384U;
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    GLuint m_vao = 0U;
+    GLuint m_vbo = 0U;
+    GLuint m_ebo = 0U;
+    std::vector<Range> m_ranges; // One per brick.
+
+    // The draw of every brick that holds triangles.
+    std::vector<GLsizei> m_counts;
+    std::vector<void const*> m_indexOffsets;
+    std::vector<GLint> m_baseVertices;
+
+    QOpenGLShaderProgram m_shaderProgram;
+    GLint m_uniformLocation_viewProjection;
+    GLint m_uniformLocation_eye;
+    GLint m_uniformLocation_color;
+
+    void uploadBrick(MarchingCubes::Brick const &brick, Range const &range) const;
+    void relayout(std::vector<MarchingCubes::Brick> const &bricks);
+    void updateDraws();
+
+public:
+    IsosurfaceMesh() = default;
+    IsosurfaceMesh(IsosurfaceMesh const&) = delete;
+    IsosurfaceMesh& operator=(IsosurfaceMesh const&) = delete;
+
+    void create(QOpenGLFunctions_3_3_Core * const gl);
+    void destroy();
+
+    // Uploads the bricks marchingCubes changed in its last extract.
+    void update(MarchingCubes const &marchingCubes);
+
+    // Draws the surface of the unit volume centered at the origin, as the volume renderer places it, with the depth test
+    // enabled during the draw only.
+    void draw(QMatrix4x4 const &viewProjection, QVector3D const &eye, QVector3D const &color);
+
+    // Getters
+    // The vertex and index buffer, for the GPU memory bookkeeping.
+    [[nodiscard]] std::array<GLuint, 2U> buffers() const;
+};
+
+#endif // ISOSURFACEMESH_H
@@ -94,8 +94,8 @@ void Legend::initializeGL() {
 
 void Legend::createShaderProgram()
 {
-    m_shaderProgramColorMap.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/passthrough2d.vert");
-    m_shaderProgramColorMap.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
+    m_shaderProgramColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/passthrough2d.vert");
+    m_shaderProgramColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
     m_shaderProgramColorMap.link();
 
     m_uniformLocationTexture = m_shaderProgramColorMap.uniformLocation("textureSampler");
@@ -126,18 +126,9 @@ void Legend::loadInitialColorMap()
                  defaultColorMap.data());
 }
 
-void Legend::updateColorMap(std::vector<Color> const &colorMap)
+void Legend::setColorMapTexture(GLuint const texture)
 {
-    glBindTexture(GL_TEXTURE_1D, m_textureLocation);
-    glTexImage1D(GL_TEXTURE_1D,
-                 0,
-                 GL_RGB32F,
-                 static_cast<GLint>(colorMap.size()),
-                 0,
-                 GL_RGB,
-                 GL_FLOAT,
-                 colorMap.data());
-
+    m_colorMapTexture = texture;
     update();
 }
 
@@ -147,7 +138,7 @@ void Legend::paintGL()
 
     glUniform1i(m_uniformLocationTexture, 0);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_1D, m_textureLocation);
+    glBindTexture(GL_TEXTURE_1D, m_colorMapTexture != 0U ? m_colorMapTexture : m_textureLocation);
     glBindVertexArray(m_vao);
 
     glDrawElements(GL_TRIANGLES,
@@ -19,7 +19,8 @@ class Legend : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     GLuint m_vao;
     GLuint m_vbo;
     GLuint m_ebo;
-    GLuint m_textureLocation;
+    GLuint m_textureLocation;        // The default color map, until the first setColorMapTexture.
+    GLuint m_colorMapTexture = 0U;   // Drawn texture, owned by the ColorMapCache of the Visualization once set.
     GLint m_uniformLocationTexture;
 
     QOpenGLShaderProgram m_shaderProgramColorMap;
@@ -44,7 +45,8 @@ public:
     Legend& operator=(Legend&&) = delete;
     ~Legend() override;
 
-    void updateColorMap(std::vector<Color> const &colorMap);
+    // The texture has to be from a context that shares with this one, as all QOpenGLWidgets of a window do.
+    void setColorMapTexture(GLuint const texture);
 };
 
 #endif // LEGEND_H
@@ -30,6 +30,28 @@ private slots:
     // Simulation, show minimum/maximum values of scalar and vector data.
     void on_simulationShowMinMaxDataCheckBox_toggled(bool checked);
 
+    // Simulation, run the solver on the GPU.
+    void on_simulationGpuCheckBox_toggled(bool checked);
+
+    // Simulation, store the density and forces of the frames in half precision.
+    void on_simulationHalfPrecisionCheckBox_toggled(bool checked);
+
+    // Simulation, record the fields of every step into .npy files.
+    void on_simulationRecordSnapshotsCheckBox_toggled(bool checked);
+
+    // Simulation, record the session and replay a recorded one from any step.
+    void on_simulationRecordSessionCheckBox_toggled(bool checked);
+    void on_simulationReplaySessionPushButton_clicked();
+    void on_simulationReplaySeekPushButton_clicked();
+
+    // Simulation, graph the stage times and record them as a Chrome trace.
+    void on_simulationProfilingCheckBox_toggled(bool checked);
+    void on_simulationProfilingTracePushButton_clicked();
+
+    // Simulation, keep the GPU memory of the visualizations within a budget.
+    void on_simulationGpuMemoryBudgetSpinBox_valueChanged(int value);
+    void on_simulationGpuMemoryReportPushButton_clicked();
+
     // Simulation, density injected fluid.
     void on_densitySlider_valueChanged(int value);
     void on_densitySpinBox_valueChanged(double value);
@@ -41,9 +63,11 @@ private slots:
     // Simulation, timestep.
     void on_timestepSlider_valueChanged(int value);
     void on_timestepSpinBox_valueChanged(double value);
+    void on_simulationAdaptiveTimestepCheckBox_toggled(bool checked);
 
-    // Simulation, number of gridpoints.
+    // Simulation, number of gridpoints in x and y.
     void on_gridpointsSpinBox_valueChanged(int value);
+    void on_gridpointsYSpinBox_valueChanged(int value);
 
     // Simulation, run simulation.
     void on_simulationPausePlayPushButton_clicked();
@@ -53,9 +77,11 @@ private slots:
     void on_quantizationBitsComboBox_currentIndexChanged(int index);
     void on_gaussianBlurCheckBox_toggled(bool checked);
     void on_gradientsCheckBox_toggled(bool checked);
+    void on_preprocessingBackendComboBox_currentIndexChanged(int index);
 
     // Scalar data, draw true/false.
     void on_scalarDataDrawScalarDataCheckBox_toggled(bool checked);
+    void on_scalarDataDrawAsTextureCheckBox_toggled(bool checked);
 
     // Scalar data, data type.
     void on_scalarDataComboBox_currentIndexChanged(int index);
@@ -94,6 +120,7 @@ private slots:
 
     // Vector data, draw on/off.
     void on_vectorDataDrawGlyphsCheckBox_toggled(bool checked);
+    void on_vectorDataGpuTransformsCheckBox_toggled(bool checked);
 
     // Vector data, number of glyphs.
     void on_vectorDataNumberOfGlyphsHorizontalSpinBox_valueChanged(int arg1);
@@ -113,6 +140,16 @@ private slots:
     void on_vectorDataColorMapComboBox_currentIndexChanged(int index);
     void on_vectorDataNumberOfColorsSpinBox_valueChanged(int value);
 
+    // Vector data, streamlines.
+    void on_vectorDataDrawStreamlinesCheckBox_toggled(bool checked);
+    void on_vectorDataPathlinesCheckBox_toggled(bool checked);
+    void on_vectorDataStreamlineSeedsSpinBox_valueChanged(int arg1);
+    void on_vectorDataStreamlineLengthSpinBox_valueChanged(int arg1);
+
+    // Vector data, particles.
+    void on_vectorDataDrawParticlesCheckBox_toggled(bool checked);
+    void on_vectorDataNumberOfParticlesSpinBox_valueChanged(int arg1);
+
 
     // Isolines, draw on/off.
     void on_isolinesDrawIsolinesCheckBox_toggled(bool checked);
@@ -120,6 +157,9 @@ private slots:
     // Isolines, color picker.
     void on_isolinesColorPickerButton_clicked();
 
+    // Isolines, extract with marching squares on the CPU instead of in the geometry shader.
+    void on_isolinesExtractOnCpuCheckBox_toggled(bool checked);
+
     // Isolines, use same data as current scalar data or manually choose data.
     void on_isolinesUseCurrentScalarDataCheckBox_toggled(bool checked);
 
@@ -147,6 +187,12 @@ private slots:
     // Height plot, draw on/off.
     void on_showHeightPlotCheckBox_toggled(bool checked);
 
+    // Height plot, compute the heights and normals from a height field texture in the vertex shader.
+    void on_heightplotComputeNormalsOnGpuCheckBox_toggled(bool checked);
+
+    // Height plot, draw coarser patches where the detail is not visible.
+    void on_heightplotLevelOfDetailCheckBox_toggled(bool checked);
+
     // Height plot, scalar data type used for height.
     void on_heightplotDataTypeComboBox_currentIndexChanged(int index);
 
@@ -175,6 +221,7 @@ private slots:
 
     // LIC, draw on/off.
     void on_drawLicCheckBox_toggled(bool checked);
+    void on_LICReuseConvolutionCheckBox_toggled(bool checked);
     void on_LICNoiseTextureGenerateNewPushButton_clicked();
     void on_LICStreamlineLengthSpinBox_valueChanged(int arg1);
     void on_LICStepSizeFactorDoubleSpinBox_valueChanged(double arg1);
@@ -191,6 +238,16 @@ private slots:
     void on_volumeRenderingFragmentShaderSelectionVolumeRenderingPreIntegrationRadioButton_clicked();
     void on_volumeRenderingFragmentShaderSelectionVolumeRenderingOverlayRenderingRadioButton_clicked();
     void on_volumeRenderingPausePlayPushButton_clicked();
+    void on_volumeRenderingStepScaleDoubleSpinBox_valueChanged(double arg1);
+    void on_volumeRenderingMaxAdaptiveStepScaleDoubleSpinBox_valueChanged(double arg1);
+    void on_volumeRenderingAdaptiveStepThresholdDoubleSpinBox_valueChanged(double arg1);
+    void on_volumeRenderingTerminationOpacityDoubleSpinBox_valueChanged(double arg1);
+    void on_volumeRenderingInteractiveDownsamplingSpinBox_valueChanged(int arg1);
+    void on_volumeRenderingPrecomputedGradientsCheckBox_toggled(bool checked);
+    void on_volumeRenderingCompressDataRawCheckBox_toggled(bool checked);
+    void on_volumeRenderingIsosurfaceCheckBox_toggled(bool checked);
+    void on_volumeRenderingIsovalueDoubleSpinBox_valueChanged(double arg1);
+    void on_visualizationOpenGLWidget_dataRawLoadProgress(int completedTimeSteps, int timeSteps);
 
     void on_screenshotPushButton_clicked();
 
@@ -199,6 +256,10 @@ private slots:
     void setScalarDataMax(float const max);
     void setVectorDataMin(float const min);
     void setVectorDataMax(float const max);
+    // In bytes, the available memory in kilobytes as the driver reports it, or -1.
+    void setGpuMemoryUsage(size_t const residentBytes, size_t const evictedBytes, long long const availableKilobytes);
+    // The bricks the last isovalue change extracted again, of all bricks.
+    void setIsosurfaceInfo(size_t const numberOfTriangles, size_t const changedBricks, size_t const numberOfBricks);
 
 private:
     Ui::MainWindow *ui;
@@ -209,11 +270,10 @@ private:
 
     ColorMap m_vectorDataColorMap = ColorMap::Grayscale;
     size_t m_numberOfColorsVectorData = 256U;
-    std::vector<Color> m_defaultVectorDataColorMap = Texture::createGrayscaleTexture(m_numberOfColorsScalarData);
 
-    [[nodiscard]] std::vector<Color> enumToColorMap(ColorMap const colorMap, size_t numberOfColors) const;
     void updateScalarDataColorMapGlobally() const;
     void updateVectorDataColorMapGlobally() const;
+    void setGridSize(size_t const DIMX, size_t const DIMY);
 
     template <class T> T findChildSafe(QString const &widgetName) const;
 };
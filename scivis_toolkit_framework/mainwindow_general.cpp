@@ -1,7 +1,12 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <QAbstractButton>
+#include <QAbstractSlider>
+#include <QComboBox>
+#include <QDoubleSpinBox>
 #include <QLCDNumber>
+#include <QSpinBox>
 #include <QString>
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -9,31 +14,31 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-}
 
-MainWindow::~MainWindow()
-{
-    delete ui;
-}
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    ui->simulationProfilerGraph->setProfiler(&visualizationPtr->m_profiler);
 
-std::vector<Color> MainWindow::enumToColorMap(ColorMap const colorMap, size_t numberOfColors) const
-{
-    std::vector<Color> ret;
-
-    switch (colorMap)
+    // The visualization only repaints when something changed, so every edit in the GUI asks for a new frame.
+    // setupUi connected the on_ slots already, so they have applied the change by the time the request is made.
+    auto const requestRender = [visualizationPtr] { visualizationPtr->requestRender(); };
+    for (QAbstractButton *const button : findChildren<QAbstractButton*>())
     {
-        case ColorMap::Grayscale: ret = Texture::createGrayscaleTexture(numberOfColors); break;
-        case ColorMap::Turbo: ret = Texture::createTurboTexture(numberOfColors); break;
-        case ColorMap::HeatMap: ret = Texture::createHeatTexture(numberOfColors); break;
-        case ColorMap::BlueYellow: ret = Texture::createBlueYellowTexture(numberOfColors); break;
-        case ColorMap::Custom3Color:
-        {
-            auto const &customColors = findChildSafe<Visualization*>("visualizationOpenGLWidget")->m_customColors;
-            ret = Texture::createThreeColorTexture(customColors[0], customColors[1], customColors[2], numberOfColors);
-        }
+        connect(button, &QAbstractButton::clicked, this, requestRender);
+        connect(button, &QAbstractButton::toggled, this, requestRender);
     }
+    for (QAbstractSlider *const slider : findChildren<QAbstractSlider*>())
+        connect(slider, &QAbstractSlider::valueChanged, this, requestRender);
+    for (QSpinBox *const spinBox : findChildren<QSpinBox*>())
+        connect(spinBox, &QSpinBox::valueChanged, this, requestRender);
+    for (QDoubleSpinBox *const spinBox : findChildren<QDoubleSpinBox*>())
+        connect(spinBox, &QDoubleSpinBox::valueChanged, this, requestRender);
+    for (QComboBox *const comboBox : findChildren<QComboBox*>())
+        connect(comboBox, &QComboBox::currentIndexChanged, this, requestRender);
+}
 
-    return ret;
+MainWindow::~MainWindow()
+{
+    delete ui;
 }
 
 void MainWindow::setScalarDataMin(float const min)
@@ -55,6 +60,27 @@ void MainWindow::setVectorDataMax(float const max)
 {
     ui->vectorDataMaxLcdNumber->display(static_cast<double>(max));
 }
+
+void MainWindow::setGpuMemoryUsage(size_t const residentBytes, size_t const evictedBytes,
+                                   long long const availableKilobytes)
+{
+    double const megabyte = 1024.0 * 1024.0;
+    QString usage = tr("%1 MB in use, %2 MB evicted").arg(static_cast<double>(residentBytes) / megabyte, 0, 'f', 1)
+                                                      .arg(static_cast<double>(evictedBytes) / megabyte, 0, 'f', 1);
+    if (availableKilobytes >= 0)
+        usage += tr(", %1 MB free").arg(static_cast<double>(availableKilobytes) / 1024.0, 0, 'f', 0);
+
+    ui->simulationGpuMemoryLabel->setText(usage);
+}
+
+void MainWindow::setIsosurfaceInfo(size_t const numberOfTriangles, size_t const changedBricks,
+                                   size_t const numberOfBricks)
+{
+    ui->volumeRenderingIsosurfaceInfoLabel->setText(tr("%1 triangles, %2 of %3 bricks extracted")
+                                                        .arg(numberOfTriangles)
+                                                        .arg(changedBricks)
+                                                        .arg(numberOfBricks));
+}
 void MainWindow::on_screenshotPushButton_clicked()
 {
     static unsigned int cnt = 0U;
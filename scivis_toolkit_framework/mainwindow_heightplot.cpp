@@ -15,6 +15,18 @@ void MainWindow::on_showHeightPlotCheckBox_toggled(bool checked)
         visualizationPtr->glDisable(GL_DEPTH_TEST);
 }
 
+void MainWindow::on_heightplotComputeNormalsOnGpuCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_computeHeightplotNormalsOnGpu = checked;
+}
+
+void MainWindow::on_heightplotLevelOfDetailCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_drawHeightplotLod = checked;
+}
+
 void MainWindow::on_heightplotDataTypeComboBox_currentIndexChanged(int index)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
@@ -26,6 +38,9 @@ void MainWindow::on_heightplotDataTypeComboBox_currentIndexChanged(int index)
         case 2: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::ForceFieldMagnitude; break;
         case 3: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::VelocityDivergence; break;
         case 4: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::ForceFieldDivergence; break;
+        case 5: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::Vorticity; break;
+        case 6: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::UnprojectedVelocityDivergence; break;
+        case 7: visualizationPtr->m_currentHeightplotDataType = ScalarDataType::QCriterion; break;
     }
 }
 
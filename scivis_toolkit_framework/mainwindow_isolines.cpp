@@ -18,11 +18,18 @@ void MainWindow::on_isolinesColorPickerButton_clicked()
         visualizationPtr->m_isolineColor = {static_cast<float>(colorFromUI.redF()),
                                             static_cast<float>(colorFromUI.greenF()),
                                             static_cast<float>(colorFromUI.blueF())};
+        visualizationPtr->m_isolineLevelsChanged = true;
     }
     else
         qDebug() << "Color dialog did not return a valid color.";
 }
 
+void MainWindow::on_isolinesExtractOnCpuCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_extractIsolinesOnCpu = checked;
+}
+
 void MainWindow::on_isolinesUseCurrentScalarDataCheckBox_toggled(bool checked)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
@@ -40,6 +47,9 @@ void MainWindow::on_isolinesDataComboBox_currentIndexChanged(int index)
         case 2: visualizationPtr->m_currentIsolineDataType = ScalarDataType::ForceFieldMagnitude; break;
         case 3: visualizationPtr->m_currentIsolineDataType = ScalarDataType::VelocityDivergence; break;
         case 4: visualizationPtr->m_currentIsolineDataType = ScalarDataType::ForceFieldDivergence; break;
+        case 5: visualizationPtr->m_currentIsolineDataType = ScalarDataType::Vorticity; break;
+        case 6: visualizationPtr->m_currentIsolineDataType = ScalarDataType::UnprojectedVelocityDivergence; break;
+        case 7: visualizationPtr->m_currentIsolineDataType = ScalarDataType::QCriterion; break;
     }
 }
 
@@ -47,12 +57,14 @@ void MainWindow::on_isolinesNumberOfIsolinesSpinBox_valueChanged(int value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
     visualizationPtr->m_numberOfIsolines = static_cast<size_t>(value);
+    visualizationPtr->m_isolineLevelsChanged = true;
 }
 
 void MainWindow::on_isolinesRangeRhoMinSpinBox_valueChanged(double value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
     visualizationPtr->m_isolineMinValue = static_cast<float>(value);
+    visualizationPtr->m_isolineLevelsChanged = true;
 
     ui->isolinesRangeRhoMinSlider->setValue(static_cast<int>(value * 10.0));
 }
@@ -61,6 +73,7 @@ void MainWindow::on_isolinesRangeRhoMaxSpinBox_valueChanged(double value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
     visualizationPtr->m_isolineMaxValue = static_cast<float>(value);
+    visualizationPtr->m_isolineLevelsChanged = true;
 
     ui->isolinesRangeRhoMaxSlider->setValue(static_cast<int>(value * 10.0));
 }
@@ -7,6 +7,13 @@ void MainWindow::on_drawLicCheckBox_toggled(bool checked)
     visualizationPtr->m_drawLIC = checked;
 }
 
+void MainWindow::on_LICReuseConvolutionCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_licReuseConvolution = checked;
+    visualizationPtr->m_licConvolutionIsValid = false;
+}
+
 void MainWindow::on_LICNoiseTextureGenerateNewPushButton_clicked()
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
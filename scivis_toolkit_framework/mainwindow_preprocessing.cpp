@@ -40,6 +40,18 @@ void MainWindow::on_gradientsCheckBox_toggled(bool checked)
     openGLWidgetPtr->m_useGradients = checked;
 }
 
+void MainWindow::on_preprocessingBackendComboBox_currentIndexChanged(int index)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+
+    switch (index)
+    {
+        case 0: openGLWidgetPtr->m_preprocessingBackend = Visualization::PreprocessingBackend::Reference; break;
+        case 1: openGLWidgetPtr->m_preprocessingBackend = Visualization::PreprocessingBackend::FusedCpu; break;
+        case 2: openGLWidgetPtr->m_preprocessingBackend = Visualization::PreprocessingBackend::Gpu; break;
+    }
+}
+
 void MainWindow::on_scalarDataslicingEnableCheckBox_toggled(bool checked)
 {
     auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
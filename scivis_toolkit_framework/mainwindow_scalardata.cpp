@@ -5,16 +5,16 @@
 
 void MainWindow::updateScalarDataColorMapGlobally() const
 {
-    std::vector<Color> const colorMapToUse = enumToColorMap(m_scalarDataColorMap, m_numberOfColorsScalarData);
-
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-    visualizationPtr->opengl_loadScalarDataTexture(colorMapToUse);
+    visualizationPtr->makeCurrent();
+    GLuint const texture = visualizationPtr->opengl_loadScalarDataTexture(m_scalarDataColorMap, m_numberOfColorsScalarData);
+    visualizationPtr->doneCurrent();
 
     // The visualization class needs to load different shader programs based on this boolean
     visualizationPtr->m_useCustomColorMap = m_scalarDataColorMap == ColorMap::Custom3Color;
 
     auto const scalarDataLegendPtr = findChildSafe<Legend*>("legendScalarDataOpenGLWidget");
-    scalarDataLegendPtr->updateColorMap(colorMapToUse);
+    scalarDataLegendPtr->setColorMapTexture(texture);
 }
 
 
@@ -24,6 +24,12 @@ void MainWindow::on_scalarDataDrawScalarDataCheckBox_toggled(bool checked)
     openGLWidgetPtr->m_drawScalarData = checked;
 }
 
+void MainWindow::on_scalarDataDrawAsTextureCheckBox_toggled(bool checked)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_drawScalarDataAsTexture = checked;
+}
+
 void MainWindow::on_scalarDataComboBox_currentIndexChanged(int index)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
@@ -35,6 +41,9 @@ void MainWindow::on_scalarDataComboBox_currentIndexChanged(int index)
         case 2: visualizationPtr->m_currentScalarDataType = ScalarDataType::ForceFieldMagnitude; break;
         case 3: visualizationPtr->m_currentScalarDataType = ScalarDataType::VelocityDivergence; break;
         case 4: visualizationPtr->m_currentScalarDataType = ScalarDataType::ForceFieldDivergence; break;
+        case 5: visualizationPtr->m_currentScalarDataType = ScalarDataType::Vorticity; break;
+        case 6: visualizationPtr->m_currentScalarDataType = ScalarDataType::UnprojectedVelocityDivergence; break;
+        case 7: visualizationPtr->m_currentScalarDataType = ScalarDataType::QCriterion; break;
     }
 }
 
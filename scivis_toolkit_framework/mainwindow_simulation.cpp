@@ -1,14 +1,189 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include "fftworkspace.h"
+
+#include <QDebug>
+#include <QFileDialog>
+
+#include <algorithm>
 #include <cmath>
 
+namespace
+{
+    // Only even sizes of the form 2 * 2^a * 3^b * 5^c are used, as those are the fastest FFT lengths. A single step of
+    // a spin box moves on to the next such size in that direction, any other value is rounded to the nearest one.
+    size_t fastGridSize(size_t const size, size_t const currentSize, size_t const step)
+    {
+        if (size > currentSize && size <= currentSize + step)
+            return FftWorkspace::nextFastSize(size, 2U);
+        if (size < currentSize && size + step >= currentSize)
+            return FftWorkspace::previousFastSize(size, 2U);
+
+        return FftWorkspace::nearestFastSize(size, 2U);
+    }
+}
+
 void MainWindow::on_simulationShowMinMaxDataCheckBox_toggled(bool checked)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
     visualizationPtr->m_sendMinMaxToUI = checked;
 }
 
+void MainWindow::on_simulationGpuCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_simulateOnGpu = checked;
+    if (checked && visualizationPtr->m_DIMX != visualizationPtr->m_DIMY)
+        qDebug() << "Warning: the GPU simulation needs a square grid, the" << visualizationPtr->m_DIMX << "x"
+                 << visualizationPtr->m_DIMY << "grid stays on the CPU simulation.";
+}
+
+void MainWindow::on_simulationHalfPrecisionCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_simulationWorker.setFieldPrecision(checked ? FieldPrecision::Float16 : FieldPrecision::Float32);
+}
+
+// Records in the precision of the frames at the start of the recording.
+void MainWindow::on_simulationRecordSnapshotsCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+
+    if (!checked)
+    {
+        visualizationPtr->m_simulationWorker.setSnapshotWriter(nullptr);
+        visualizationPtr->m_snapshotWriter.close();
+        return;
+    }
+
+    QString const directory = QFileDialog::getExistingDirectory(this, tr("Record snapshots into"), "");
+    if (directory.isEmpty() ||
+        !visualizationPtr->m_snapshotWriter.open(directory, visualizationPtr->m_simulationWorker.fieldPrecision()))
+    {
+        ui->simulationRecordSnapshotsCheckBox->setChecked(false);
+        return;
+    }
+
+    visualizationPtr->m_simulationWorker.setSnapshotWriter(&visualizationPtr->m_snapshotWriter);
+}
+
+void MainWindow::on_simulationRecordSessionCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+
+    if (!checked)
+    {
+        visualizationPtr->m_simulationWorker.setSessionRecorder(nullptr);
+        visualizationPtr->m_sessionRecorder.close();
+        return;
+    }
+
+    QString const fileName = QFileDialog::getSaveFileName(this, tr("Record session into"), "",
+                                                          tr("Session (*.session)"));
+    if (fileName.isEmpty() || !visualizationPtr->m_sessionRecorder.open(fileName))
+    {
+        ui->simulationRecordSessionCheckBox->setChecked(false);
+        return;
+    }
+
+    visualizationPtr->m_simulationWorker.setSessionRecorder(&visualizationPtr->m_sessionRecorder);
+}
+
+// A replay cannot be recorded, so loading one ends the recording.
+void MainWindow::on_simulationReplaySessionPushButton_clicked()
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+
+    QString const fileName = QFileDialog::getOpenFileName(this, tr("Replay session"), "", tr("Session (*.session)"));
+    if (fileName.isEmpty())
+        return;
+
+    ui->simulationRecordSessionCheckBox->setChecked(false);
+    visualizationPtr->m_simulationWorker.stopReplay();
+
+    SessionPlayer &player = visualizationPtr->m_sessionPlayer;
+    bool const loaded = player.load(fileName);
+    ui->simulationReplayStepSpinBox->setEnabled(loaded);
+    ui->simulationReplaySeekPushButton->setEnabled(loaded);
+    if (!loaded)
+        return;
+
+    ui->simulationReplayStepSpinBox->setRange(static_cast<int>(player.firstStep()),
+                                              static_cast<int>(player.lastStep()));
+    ui->simulationReplayStepSpinBox->setValue(static_cast<int>(player.firstStep()));
+    on_simulationReplaySeekPushButton_clicked();
+}
+
+// The grid is resized to the one of the step first, as the visualization follows the number of gridpoints. The spin
+// boxes round to the fast FFT sizes, so a recorded grid of another size cannot be shown.
+void MainWindow::on_simulationReplaySeekPushButton_clicked()
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    SessionPlayer const &player = visualizationPtr->m_sessionPlayer;
+    if (!player.isLoaded())
+        return;
+
+    ui->simulationRecordSessionCheckBox->setChecked(false);
+
+    auto step = static_cast<size_t>(ui->simulationReplayStepSpinBox->value());
+    auto const [DIMX, DIMY] = player.DIMAt(step);
+    if (DIMX != visualizationPtr->m_DIMX)
+        ui->gridpointsSpinBox->setValue(static_cast<int>(DIMX));
+    if (DIMY != visualizationPtr->m_DIMY)
+        ui->gridpointsYSpinBox->setValue(static_cast<int>(DIMY));
+
+    if (DIMX != visualizationPtr->m_DIMX || DIMY != visualizationPtr->m_DIMY)
+    {
+        qDebug() << "Warning: the" << DIMX << "x" << DIMY << "grid of step" << step
+                 << "of the session cannot be shown.";
+        return;
+    }
+
+    if (visualizationPtr->m_simulationWorker.seek(player, step))
+        ui->simulationReplayStepSpinBox->setValue(static_cast<int>(step));
+}
+
+void MainWindow::on_simulationProfilingCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_profiler.setEnabled(checked);
+    ui->simulationProfilerGraph->update();
+}
+
+void MainWindow::on_simulationProfilingTracePushButton_clicked()
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+
+    if (!visualizationPtr->m_profiler.isTracing())
+    {
+        visualizationPtr->m_profiler.startTrace();
+        ui->simulationProfilingTracePushButton->setText(tr("Stop and save trace"));
+        return;
+    }
+
+    // Stop collecting before the dialog opens, so the trace does not cover the time spent in it.
+    visualizationPtr->m_profiler.stopTrace();
+    ui->simulationProfilingTracePushButton->setText(tr("Start trace"));
+
+    QString const fileName = QFileDialog::getSaveFileName(this, tr("Save trace"), "", tr("Chrome trace (*.json)"));
+    if (!fileName.isEmpty())
+        visualizationPtr->m_profiler.saveTrace(fileName);
+}
+
+// 0 for no budget.
+void MainWindow::on_simulationGpuMemoryBudgetSpinBox_valueChanged(int value)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_gpuMemory.setBudget(static_cast<size_t>(value) * 1024U * 1024U);
+}
+
+void MainWindow::on_simulationGpuMemoryReportPushButton_clicked()
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_gpuMemory.logReport();
+}
+
 void MainWindow::on_densitySlider_valueChanged(int value)
 {
     ui->densitySpinBox->setValue(static_cast<float>(value) / 10.0F);
@@ -17,7 +192,7 @@ void MainWindow::on_densitySlider_valueChanged(int value)
 void MainWindow::on_densitySpinBox_valueChanged(double value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-    visualizationPtr->m_simulation.setRhoInjected(static_cast<float>(value));
+    visualizationPtr->m_simulationWorker.setRhoInjected(static_cast<float>(value));
 
     ui->densitySlider->setValue(static_cast<int>(value * 10.0F));
 }
@@ -30,7 +205,7 @@ void MainWindow::on_viscositySlider_valueChanged(int value)
 void MainWindow::on_viscositySpinBox_valueChanged(double value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-    visualizationPtr->m_simulation.setViscosity(static_cast<float>(value) / 1000.0F);
+    visualizationPtr->m_simulationWorker.setViscosity(static_cast<float>(value) / 1000.0F);
 
     ui->viscositySlider->setValue(static_cast<int>(value * 10.0F));
 }
@@ -43,11 +218,17 @@ void MainWindow::on_timestepSlider_valueChanged(int value)
 void MainWindow::on_timestepSpinBox_valueChanged(double value)
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-    visualizationPtr ->m_simulation.setDt(static_cast<float>(value));
+    visualizationPtr->m_simulationWorker.setDt(static_cast<float>(value));
 
     ui->timestepSlider->setValue(static_cast<int>(value * 10.0F));
 }
 
+void MainWindow::on_simulationAdaptiveTimestepCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_simulationWorker.setAdaptiveDt(checked);
+}
+
 void MainWindow::on_simulationPausePlayPushButton_clicked()
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
@@ -56,14 +237,45 @@ void MainWindow::on_simulationPausePlayPushButton_clicked()
 
 void MainWindow::on_gridpointsSpinBox_valueChanged(int value)
 {
-    if (value % 2 == 0)
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    auto const size = static_cast<size_t>(value);
+    size_t const currentSize = visualizationPtr->m_DIMX;
+
+    size_t const fastSize = fastGridSize(size, currentSize, static_cast<size_t>(ui->gridpointsSpinBox->singleStep()));
+    if (fastSize != size)
     {
-        auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-        visualizationPtr->setDIM(static_cast<size_t>(value));
+        ui->gridpointsSpinBox->setValue(static_cast<int>(fastSize));
+        return;
+    }
 
-        ui->scalarDataSlicingSliceIndexHorizontalSlider->setMaximum(value - 1);
-        ui->scalarDataSlicingSliceIndexSpinBox->setMaximum(value - 1);
+    if (size != currentSize)
+        setGridSize(size, visualizationPtr->m_DIMY);
+}
+
+void MainWindow::on_gridpointsYSpinBox_valueChanged(int value)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    auto const size = static_cast<size_t>(value);
+    size_t const currentSize = visualizationPtr->m_DIMY;
+
+    size_t const fastSize = fastGridSize(size, currentSize, static_cast<size_t>(ui->gridpointsYSpinBox->singleStep()));
+    if (fastSize != size)
+    {
+        ui->gridpointsYSpinBox->setValue(static_cast<int>(fastSize));
+        return;
     }
-    else
-        qDebug() << "Size must be a multiple of 2";
+
+    if (size != currentSize)
+        setGridSize(visualizationPtr->m_DIMX, size);
+}
+
+// A slice index selects a column, a row or a frame of the window, which is as long as the longer side of the grid.
+void MainWindow::setGridSize(size_t const DIMX, size_t const DIMY)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->setDIM(DIMX, DIMY);
+
+    auto const maxSliceIdx = static_cast<int>(std::max(DIMX, DIMY)) - 1;
+    ui->scalarDataSlicingSliceIndexHorizontalSlider->setMaximum(maxSliceIdx);
+    ui->scalarDataSlicingSliceIndexSpinBox->setMaximum(maxSliceIdx);
 }
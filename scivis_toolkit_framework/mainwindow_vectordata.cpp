@@ -3,13 +3,13 @@
 
 void MainWindow::updateVectorDataColorMapGlobally() const
 {
-    std::vector<Color> const colorMapToUse = enumToColorMap(m_vectorDataColorMap, m_numberOfColorsVectorData);
-
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
-    visualizationPtr->opengl_loadVectorDataTexture(colorMapToUse);
+    visualizationPtr->makeCurrent();
+    GLuint const texture = visualizationPtr->opengl_loadVectorDataTexture(m_vectorDataColorMap, m_numberOfColorsVectorData);
+    visualizationPtr->doneCurrent();
 
     auto const vectorDataLegendPtr = findChildSafe<Legend*>("legendVectorDataOpenGLWidget");
-    vectorDataLegendPtr->updateColorMap(colorMapToUse);
+    vectorDataLegendPtr->setColorMapTexture(texture);
 }
 
 void MainWindow::on_vectorDataDrawGlyphsCheckBox_toggled(bool checked)
@@ -18,6 +18,12 @@ void MainWindow::on_vectorDataDrawGlyphsCheckBox_toggled(bool checked)
     openGLWidgetPtr->m_drawVectorData = checked;
 }
 
+void MainWindow::on_vectorDataGpuTransformsCheckBox_toggled(bool checked)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_computeGlyphTransformsOnGpu = checked;
+}
+
 void MainWindow::on_vectorDataNumberOfGlyphsHorizontalSpinBox_valueChanged(int arg1)
 {
     auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
@@ -88,3 +94,39 @@ void MainWindow::on_vectorDataNumberOfColorsSpinBox_valueChanged(int value)
     m_numberOfColorsVectorData = static_cast<size_t>(value);
     updateVectorDataColorMapGlobally();
 }
+
+void MainWindow::on_vectorDataDrawStreamlinesCheckBox_toggled(bool checked)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_drawStreamlines = checked;
+}
+
+void MainWindow::on_vectorDataPathlinesCheckBox_toggled(bool checked)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_drawPathlines = checked;
+}
+
+void MainWindow::on_vectorDataStreamlineSeedsSpinBox_valueChanged(int arg1)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_streamlineSeedsPerRow = static_cast<size_t>(arg1);
+}
+
+void MainWindow::on_vectorDataStreamlineLengthSpinBox_valueChanged(int arg1)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_streamlineLength = static_cast<size_t>(arg1);
+}
+
+void MainWindow::on_vectorDataDrawParticlesCheckBox_toggled(bool checked)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_drawParticles = checked;
+}
+
+void MainWindow::on_vectorDataNumberOfParticlesSpinBox_valueChanged(int arg1)
+{
+    auto const openGLWidgetPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    openGLWidgetPtr->m_numberOfParticles = 1000U * static_cast<size_t>(arg1);
+}
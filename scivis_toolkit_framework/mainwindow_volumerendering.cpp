@@ -89,8 +89,74 @@ void MainWindow::on_volumeRenderingSelectDatFilePushButton_clicked()
     }
 }
 
+// The .dat file is loaded on the GUI thread, so the label is repainted right away instead of by the event loop.
+void MainWindow::on_visualizationOpenGLWidget_dataRawLoadProgress(int completedTimeSteps, int timeSteps)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    ui->volumeRenderingDataRawInfoLabel->setText(QString("Loading %1 (%2 / %3 time steps)")
+                                                     .arg(QString::fromStdString(visualizationPtr->m_datFilePath))
+                                                     .arg(completedTimeSteps)
+                                                     .arg(timeSteps));
+    ui->volumeRenderingDataRawInfoLabel->repaint();
+}
+
 void MainWindow::on_volumeRenderingPausePlayPushButton_clicked()
 {
     auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
     visualizationPtr->m_volumeRenderingTimeIsPaused = !visualizationPtr->m_volumeRenderingTimeIsPaused;
 }
+
+void MainWindow::on_volumeRenderingStepScaleDoubleSpinBox_valueChanged(double arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingStepScale = static_cast<float>(arg1);
+}
+
+void MainWindow::on_volumeRenderingMaxAdaptiveStepScaleDoubleSpinBox_valueChanged(double arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingMaxAdaptiveStepScale = static_cast<float>(arg1);
+}
+
+void MainWindow::on_volumeRenderingAdaptiveStepThresholdDoubleSpinBox_valueChanged(double arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingAdaptiveStepThreshold = static_cast<float>(arg1);
+}
+
+void MainWindow::on_volumeRenderingTerminationOpacityDoubleSpinBox_valueChanged(double arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingTerminationOpacity = static_cast<float>(arg1);
+}
+
+void MainWindow::on_volumeRenderingInteractiveDownsamplingSpinBox_valueChanged(int arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingInteractiveDownsampling = arg1;
+}
+
+void MainWindow::on_volumeRenderingPrecomputedGradientsCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingUsePrecomputedGradients = checked;
+}
+
+void MainWindow::on_volumeRenderingCompressDataRawCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeRenderingCompressDataRaw = checked;
+}
+
+// Only .dat volumes are extracted, the synthetic ones are still ray cast.
+void MainWindow::on_volumeRenderingIsosurfaceCheckBox_toggled(bool checked)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_drawVolumeIsosurface = checked;
+}
+
+void MainWindow::on_volumeRenderingIsovalueDoubleSpinBox_valueChanged(double arg1)
+{
+    auto const visualizationPtr = findChildSafe<Visualization*>("visualizationOpenGLWidget");
+    visualizationPtr->m_volumeIsovalue = static_cast<float>(arg1);
+}
@@ -0,0 +1,366 @@
+#include "marchingcubes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+// Corner c of a cube lies at (c & 1, (c >> 1) & 1, (c >> 2) & 1). Edge e runs along axis e / 4, from the corner
+// edgeCorners[e][0] to edgeCorners[e][1].
+constexpr std::array<std::array<unsigned int, 2U>, 12U> edgeCorners{{
+    {{0U, 1U}}, {{2U, 3U}}, {{4U, 5U}}, {{6U, 7U}},
+    {{0U, 2U}}, {{1U, 3U}}, {{4U, 6U}}, {{5U, 7U}},
+    {{0U, 4U}}, {{1U, 5U}}, {{2U, 6U}}, {{3U, 7U}}
+}};
+
+// The corners of every face, counterclockwise as seen from outside the cube.
+constexpr std::array<std::array<unsigned int, 4U>, 6U> faceCorners{{
+    {{0U, 4U, 6U, 2U}}, {{1U, 3U, 7U, 5U}},  // x = 0, x = 1
+    {{0U, 1U, 5U, 4U}}, {{2U, 6U, 7U, 3U}},  // y = 0, y = 1
+    {{0U, 2U, 3U, 1U}}, {{4U, 5U, 7U, 6U}}   // z = 0, z = 1
+}};
+
+constexpr unsigned int edgeBetween(unsigned int const cornerA, unsigned int const cornerB)
+{
+    unsigned int const lower = std::min(cornerA, cornerB);
+    switch (cornerA ^ cornerB)
+    {
+        case 1U:  return lower / 2U;
+        case 2U:  return 4U + (lower & 1U) + ((lower >> 2U) << 1U);
+        default:  return 8U + lower;
+    }
+}
+
+// The faces edge lies on, one bit per face.
+unsigned int edgeFaces(unsigned int const edge)
+{
+    unsigned int faces = 0U;
+    for (size_t face = 0U; face < faceCorners.size(); ++face)
+        for (size_t k = 0U; k < 4U; ++k)
+            if (edgeBetween(faceCorners[face][k], faceCorners[face][(k + 1U) % 4U]) == edge)
+                faces |= 1U << face;
+
+    return faces;
+}
+
+// Twelve crossed edges in at least one loop of three or more.
+constexpr size_t s_maxTrianglesPerCube = 10U;
+
+struct CaseTable
+{
+    std::array<std::array<std::uint8_t, 3U * s_maxTrianglesPerCube>, 256U> edges{};
+    std::array<std::uint8_t, 256U> numberOfTriangles{};
+};
+
+// Bit c of a case is set when corner c lies below the isovalue. On every face, the boundary is walked
+// counterclockwise, and every run of corners below the isovalue adds a segment from the edge where the walk enters the
+// run to the edge where it leaves it. A face with two diagonal corners below thus separates them. Every crossed edge
+// is shared by two faces that walk it in opposite directions, so the segments join into closed loops, each of which is
+// triangulated as a fan. The apex of the fan is chosen so that no diagonal lies on a face: the neighbouring cube would
+// have the same edge on its side of the face, and the two triangles on either side of it would overlap.
+CaseTable buildCaseTable()
+{
+    std::array<unsigned int, 12U> faces{};
+    for (unsigned int edge = 0U; edge < 12U; ++edge)
+        faces[edge] = edgeFaces(edge);
+
+    CaseTable table;
+    for (unsigned int cubeCase = 0U; cubeCase < 256U; ++cubeCase)
+    {
+        auto const isBelow = [cubeCase](unsigned int const corner) { return ((cubeCase >> corner) & 1U) != 0U; };
+
+        std::array<int, 12U> nextEdge{};
+        nextEdge.fill(-1);
+        for (std::array<unsigned int, 4U> const &face : faceCorners)
+        {
+            std::array<unsigned int, 4U> crossings{};
+            std::array<bool, 4U> isEntry{};
+            size_t numberOfCrossings = 0U;
+            for (size_t k = 0U; k < 4U; ++k)
+            {
+                unsigned int const cornerA = face[k];
+                unsigned int const cornerB = face[(k + 1U) % 4U];
+                if (isBelow(cornerA) == isBelow(cornerB))
+                    continue;
+
+                crossings[numberOfCrossings] = edgeBetween(cornerA, cornerB);
+                isEntry[numberOfCrossings] = isBelow(cornerB);
+                ++numberOfCrossings;
+            }
+
+            for (size_t k = 0U; k < numberOfCrossings; ++k)
+                if (isEntry[k])
+                    nextEdge[crossings[k]] = static_cast<int>(crossings[(k + 1U) % numberOfCrossings]);
+        }
+
+        std::array<bool, 12U> isVisited{};
+        size_t numberOfTriangles = 0U;
+        for (size_t start = 0U; start < 12U; ++start)
+        {
+            if (nextEdge[start] < 0 || isVisited[start])
+                continue;
+
+            std::array<std::uint8_t, 12U> loop{};
+            size_t length = 0U;
+            for (size_t edge = start; !isVisited[edge]; edge = static_cast<size_t>(nextEdge[edge]))
+            {
+                isVisited[edge] = true;
+                loop[length++] = static_cast<std::uint8_t>(edge);
+            }
+
+            // Such an apex exists for every loop of every case.
+            size_t apex = 0U;
+            auto const hasFaceDiagonal = [&](size_t const candidate)
+            {
+                for (size_t k = 2U; k + 1U < length; ++k)
+                    if ((faces[loop[candidate]] & faces[loop[(candidate + k) % length]]) != 0U)
+                        return true;
+
+                return false;
+            };
+            while (apex + 1U < length && hasFaceDiagonal(apex))
+                ++apex;
+
+            for (size_t k = 1U; k + 1U < length; ++k, ++numberOfTriangles)
+            {
+                table.edges[cubeCase][3U * numberOfTriangles] = loop[apex];
+                table.edges[cubeCase][3U * numberOfTriangles + 1U] = loop[(apex + k + 1U) % length];
+                table.edges[cubeCase][3U * numberOfTriangles + 2U] = loop[(apex + k) % length];
+            }
+        }
+        table.numberOfTriangles[cubeCase] = static_cast<std::uint8_t>(numberOfTriangles);
+    }
+
+    return table;
+}
+
+CaseTable const &caseTable()
+{
+    static CaseTable const table = buildCaseTable();
+    return table;
+}
+
+// The values of a brick are stored with one voxel around it, for the central differences at its corners.
+constexpr size_t s_valuesSize = VolumeOccupancy::s_cellSize + 3U;
+constexpr size_t s_cornersSize = VolumeOccupancy::s_cellSize + 1U;
+constexpr std::uint32_t s_noVertex = std::numeric_limits<std::uint32_t>::max();
+} // namespace
+
+float MarchingCubes::voxel(size_t const x, size_t const y, size_t const z) const
+{
+    size_t const voxelIdx = (z * m_resolution[1] + y) * m_resolution[0] + x;
+    if ((voxelIdx + 1U) * m_scalarSize > m_dataSize)
+        return 0.0F;
+
+    if (m_scalarSize == 1U)
+        return static_cast<float>(m_data[voxelIdx]);
+
+    // The data offset of a raw file need not keep 16-bit values aligned.
+    std::uint16_t value;
+    std::memcpy(&value, m_data + voxelIdx * m_scalarSize, sizeof(value));
+    return static_cast<float>(value);
+}
+
+// The occupancy ranges are in levels of 8 bits, and include the voxels around the brick.
+bool MarchingCubes::mayContain(size_t const brickIdx, float const isovalue) const
+{
+    float const level = m_scalarSize == 1U ? isovalue : isovalue / 256.0F;
+    return m_occupancy->mayContain(brickIdx, level);
+}
+
+void MarchingCubes::extractBrick(size_t const brickIdx, float const isovalue, Scratch &scratch, Brick &brick) const
+{
+    brick.vertices.clear();
+    brick.indices.clear();
+
+    std::array<size_t, 3U> const brickPosition{brickIdx % m_brickCount[0],
+                                               (brickIdx / m_brickCount[0]) % m_brickCount[1],
+                                               brickIdx / (m_brickCount[0] * m_brickCount[1])};
+    std::array<size_t, 3U> origin{};
+    std::array<size_t, 3U> numberOfCubes{};
+    for (size_t axis = 0U; axis < 3U; ++axis)
+    {
+        origin[axis] = brickPosition[axis] * s_brickSize;
+        if (origin[axis] + 1U >= m_resolution[axis])
+            return;
+
+        numberOfCubes[axis] = std::min(s_brickSize, m_resolution[axis] - 1U - origin[axis]);
+    }
+
+    // From one voxel before the first corner to one after the last, clamped to the volume.
+    scratch.values.resize(s_valuesSize * s_valuesSize * s_valuesSize);
+    auto const clampedVoxel = [this](size_t const axis, size_t const origin, size_t const local)
+    {
+        return std::min(origin + local > 0U ? origin + local - 1U : 0U, m_resolution[axis] - 1U);
+    };
+    for (size_t z = 0U; z < numberOfCubes[2] + 3U; ++z)
+        for (size_t y = 0U; y < numberOfCubes[1] + 3U; ++y)
+            for (size_t x = 0U; x < numberOfCubes[0] + 3U; ++x)
+                scratch.values[(z * s_valuesSize + y) * s_valuesSize + x] = voxel(clampedVoxel(0U, origin[0], x),
+                                                                                  clampedVoxel(1U, origin[1], y),
+                                                                                  clampedVoxel(2U, origin[2], z));
+
+    auto const value = [&scratch](size_t const x, size_t const y, size_t const z)
+    {
+        return scratch.values[((z + 1U) * s_valuesSize + y + 1U) * s_valuesSize + x + 1U];
+    };
+    // Towards higher values, per voxel.
+    auto const gradient = [&scratch](size_t const x, size_t const y, size_t const z)
+    {
+        size_t const idx = ((z + 1U) * s_valuesSize + y + 1U) * s_valuesSize + x + 1U;
+        return std::array<float, 3U>{
+            0.5F * (scratch.values[idx + 1U] - scratch.values[idx - 1U]),
+            0.5F * (scratch.values[idx + s_valuesSize] - scratch.values[idx - s_valuesSize]),
+            0.5F * (scratch.values[idx + s_valuesSize * s_valuesSize] - scratch.values[idx - s_valuesSize * s_valuesSize])};
+    };
+
+    // The vertex on the edge along axis from corner (x, y, z), created by the first cube that crosses it.
+    scratch.edgeVertices.assign(s_cornersSize * s_cornersSize * s_cornersSize * 3U, s_noVertex);
+    auto const edgeVertex = [&](std::array<size_t, 3U> const &corner, size_t const axis)
+    {
+        std::uint32_t &vertexIdx = scratch.edgeVertices[((corner[2] * s_cornersSize + corner[1]) * s_cornersSize +
+                                                         corner[0]) * 3U + axis];
+        if (vertexIdx != s_noVertex)
+            return vertexIdx;
+
+        std::array<size_t, 3U> end = corner;
+        ++end[axis];
+        float const valueA = value(corner[0], corner[1], corner[2]);
+        float const valueB = value(end[0], end[1], end[2]);
+        float const t = (isovalue - valueA) / (valueB - valueA);
+        std::array<float, 3U> const gradientA = gradient(corner[0], corner[1], corner[2]);
+        std::array<float, 3U> const gradientB = gradient(end[0], end[1], end[2]);
+
+        // The volume fills the unit cube whatever its resolution, so the gradient is scaled along with it.
+        std::array<float, 3U> position{};
+        std::array<float, 3U> normal{};
+        float length = 0.0F;
+        for (size_t k = 0U; k < 3U; ++k)
+        {
+            float const voxelPosition = static_cast<float>(origin[k] + corner[k]) + (k == axis ? t : 0.0F);
+            position[k] = (voxelPosition + 0.5F) / static_cast<float>(m_resolution[k]);
+            normal[k] = -(gradientA[k] + t * (gradientB[k] - gradientA[k])) * static_cast<float>(m_resolution[k]);
+            length += normal[k] * normal[k];
+        }
+
+        // A flat neighbourhood has no gradient, the edge itself tells which side is lower.
+        if (length > 0.0F)
+            for (float &component : normal)
+                component /= std::sqrt(length);
+        else
+            normal[axis] = valueA < valueB ? -1.0F : 1.0F;
+
+        vertexIdx = static_cast<std::uint32_t>(brick.vertices.size());
+        brick.vertices.push_back({position[0], position[1], position[2], normal[0], normal[1], normal[2]});
+        return vertexIdx;
+    };
+
+    CaseTable const &table = caseTable();
+    for (size_t z = 0U; z < numberOfCubes[2]; ++z)
+        for (size_t y = 0U; y < numberOfCubes[1]; ++y)
+            for (size_t x = 0U; x < numberOfCubes[0]; ++x)
+            {
+                unsigned int cubeCase = 0U;
+                for (unsigned int corner = 0U; corner < 8U; ++corner)
+                    if (value(x + (corner & 1U), y + ((corner >> 1U) & 1U), z + (corner >> 2U)) < isovalue)
+                        cubeCase |= 1U << corner;
+
+                for (size_t k = 0U; k < 3U * table.numberOfTriangles[cubeCase]; ++k)
+                {
+                    unsigned int const edge = table.edges[cubeCase][k];
+                    unsigned int const corner = edgeCorners[edge][0];
+                    brick.indices.push_back(edgeVertex({x + (corner & 1U), y + ((corner >> 1U) & 1U),
+                                                        z + (corner >> 2U)}, edge / 4U));
+                }
+            }
+}
+
+void MarchingCubes::setVolume(void const * const data,
+                              size_t const dataSize,
+                              std::array<size_t, 3U> const &resolution,
+                              size_t const scalarSize,
+                              VolumeOccupancy const &occupancy)
+{
+    m_data = static_cast<std::uint8_t const*>(data);
+    m_dataSize = dataSize;
+    m_resolution = resolution;
+    m_scalarSize = scalarSize;
+    m_occupancy = &occupancy;
+
+    m_brickCount = occupancy.cellCount();
+    m_bricks.resize(m_brickCount[0] * m_brickCount[1] * m_brickCount[2]);
+    m_isovalue = -1.0F;
+}
+
+void MarchingCubes::clear()
+{
+    m_data = nullptr;
+    m_dataSize = 0U;
+    m_occupancy = nullptr;
+    m_brickCount = {};
+    m_bricks.clear();
+    m_changedBricks.clear();
+    m_isovalue = -1.0F;
+}
+
+// Bricks that contain neither isovalue stay empty, all others are extracted again or cleared.
+bool MarchingCubes::extract(float const isovalue, ThreadPool &threadPool)
+{
+    m_changedBricks.clear();
+    if (m_occupancy == nullptr || isovalue == m_isovalue)
+        return false;
+
+    float const maxValue = m_scalarSize == 1U ? 255.0F : 65535.0F;
+    float const rawIsovalue = std::clamp(isovalue, 0.0F, 1.0F) * maxValue;
+    bool const isNewVolume = m_isovalue < 0.0F;
+
+    std::vector<size_t> bricksToExtract;
+    for (size_t brickIdx = 0U; brickIdx < m_bricks.size(); ++brickIdx)
+    {
+        Brick &brick = m_bricks[brickIdx];
+        if (mayContain(brickIdx, rawIsovalue))
+            bricksToExtract.push_back(brickIdx);
+        else if (isNewVolume || !brick.indices.empty())
+        {
+            brick.vertices.clear();
+            brick.indices.clear();
+        }
+        else
+            continue;
+
+        m_changedBricks.push_back(brickIdx);
+    }
+
+    // Keep the capacity of the per-thread vectors between calls.
+    m_threadScratch.resize(threadPool.threadCount());
+    threadPool.parallelFor(0U, bricksToExtract.size(), [&](size_t const begin, size_t const end, size_t const thread)
+    {
+        for (size_t idx = begin; idx < end; ++idx)
+            extractBrick(bricksToExtract[idx], rawIsovalue, m_threadScratch[thread], m_bricks[bricksToExtract[idx]]);
+    });
+
+    m_isovalue = isovalue;
+    return !m_changedBricks.empty();
+}
+
+// Getters
+std::vector<MarchingCubes::Brick> const &MarchingCubes::bricks() const
+{
+    return m_bricks;
+}
+
+std::vector<size_t> const &MarchingCubes::changedBricks() const
+{
+    return m_changedBricks;
+}
+
+size_t MarchingCubes::numberOfTriangles() const
+{
+    size_t numberOfIndices = 0U;
+    for (Brick const &brick : m_bricks)
+        numberOfIndices += brick.indices.size();
+
+    return numberOfIndices / 3U;
+}
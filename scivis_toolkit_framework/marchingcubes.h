@@ -0,0 +1,86 @@
+#ifndef MARCHINGCUBES_H
+#define MARCHINGCUBES_H
+
+#include "threadpool.h"
+#include "volumeoccupancy.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU marching cubes on a volume of 8 or 16-bit voxels, x fastest, as the time steps of a .dat file hold them.
+// The volume is extracted in bricks, the cells of its VolumeOccupancy: a brick whose value range does not contain the
+// isovalue is skipped without reading a voxel, and the others are distributed over the threads of a ThreadPool. Every
+// brick is an indexed triangle mesh of its own. When the isovalue changes, only the bricks that contain the old or the
+// new one are extracted again, and changedBricks() tells which, so the GPU copy can be updated brick by brick.
+// The triangulation of every case follows from the cube faces: on a face with two diagonal corners below the
+// isovalue, those corners are separated. As neighbouring cubes decide a shared face alike, the surface is closed.
+class MarchingCubes
+{
+public:
+    struct Vertex
+    {
+        float x;  // Normalized volume coordinates: the center of voxel i lies at (i + 0.5) / resolution.
+        float y;
+        float z;
+        float nx; // Unit normal in the same coordinates, pointing to lower values.
+        float ny;
+        float nz;
+    };
+
+    struct Brick
+    {
+        std::vector<Vertex> vertices;
+        std::vector<std::uint32_t> indices; // Three per triangle, into vertices of the same brick.
+    };
+
+private:
+    static constexpr size_t s_brickSize = VolumeOccupancy::s_cellSize; // Cubes per axis.
+
+    // The values of a brick and the voxels around it, for the gradients, and its vertices per cube edge.
+    struct Scratch
+    {
+        std::vector<float> values;
+        std::vector<std::uint32_t> edgeVertices;
+    };
+
+    std::uint8_t const *m_data = nullptr;
+    size_t m_dataSize = 0U;
+    std::array<size_t, 3U> m_resolution{};
+    size_t m_scalarSize = 1U;
+    VolumeOccupancy const *m_occupancy = nullptr;
+
+    std::array<size_t, 3U> m_brickCount{};
+    std::vector<Brick> m_bricks;
+    std::vector<size_t> m_changedBricks;
+    float m_isovalue = -1.0F; // Negative while the bricks are not extracted from the current volume.
+
+    std::vector<Scratch> m_threadScratch; // Per thread, so that the threads never share a vector.
+
+    [[nodiscard]] float voxel(size_t const x, size_t const y, size_t const z) const;
+    [[nodiscard]] bool mayContain(size_t const brickIdx, float const isovalue) const;
+    void extractBrick(size_t const brickIdx, float const isovalue, Scratch &scratch, Brick &brick) const;
+
+public:
+    // data holds dataSize bytes of resolution voxels of scalarSize (1 or 2) bytes each, and occupancy their ranges.
+    // Missing voxels of a truncated volume count as 0. Both have to stay alive until the next setVolume or clear.
+    void setVolume(void const * const data,
+                   size_t const dataSize,
+                   std::array<size_t, 3U> const &resolution,
+                   size_t const scalarSize,
+                   VolumeOccupancy const &occupancy);
+    void clear();
+
+    // The isovalue is normalized to the range of the scalar type, like the values the shaders sample. Returns whether
+    // any brick changed.
+    bool extract(float const isovalue, ThreadPool &threadPool);
+
+    // Getters
+    [[nodiscard]] std::vector<Brick> const &bricks() const;
+    // The bricks the last extract changed, in increasing order. After setVolume, that is every brick.
+    [[nodiscard]] std::vector<size_t> const &changedBricks() const;
+    [[nodiscard]] size_t numberOfTriangles() const;
+};
+
+#endif // MARCHINGCUBES_H
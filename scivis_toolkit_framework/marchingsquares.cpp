@@ -0,0 +1,180 @@
+#include "marchingsquares.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace
+{
+// The corners of a cell are numbered counterclockwise, starting at the bottom left: (i, j), (i + 1, j), (i + 1, j + 1)
+// and (i, j + 1). Edge e connects corner e and corner (e + 1) % 4.
+using EdgePair = std::pair<int, int>;
+
+constexpr EdgePair noSegment{-1, -1};
+
+// Bit k of the case is set when corner k lies above the isovalue.
+// Cases 5 and 10 are ambiguous, their segments are chosen in extractCell.
+constexpr std::array<std::array<EdgePair, 2U>, 16U> segmentTable{{
+    {{noSegment, noSegment}},  //  0
+    {{{3, 0}, noSegment}},     //  1
+    {{{0, 1}, noSegment}},     //  2
+    {{{3, 1}, noSegment}},     //  3
+    {{{1, 2}, noSegment}},     //  4
+    {{noSegment, noSegment}},  //  5, ambiguous
+    {{{0, 2}, noSegment}},     //  6
+    {{{3, 2}, noSegment}},     //  7
+    {{{2, 3}, noSegment}},     //  8
+    {{{0, 2}, noSegment}},     //  9
+    {{noSegment, noSegment}},  // 10, ambiguous
+    {{{1, 2}, noSegment}},     // 11
+    {{{3, 1}, noSegment}},     // 12
+    {{{0, 1}, noSegment}},     // 13
+    {{{3, 0}, noSegment}},     // 14
+    {{noSegment, noSegment}}   // 15
+}};
+
+// Segments that separate corners 0 and 2 from the rest, and segments that separate corners 1 and 3 from the rest.
+constexpr std::array<EdgePair, 2U> cutOffCorners02{{{3, 0}, {1, 2}}};
+constexpr std::array<EdgePair, 2U> cutOffCorners13{{{0, 1}, {2, 3}}};
+
+constexpr std::array<std::array<float, 2U>, 4U> cornerOffsets{{{0.0F, 0.0F}, {1.0F, 0.0F}, {1.0F, 1.0F}, {0.0F, 1.0F}}};
+} // namespace
+
+void MarchingSquares::extract(std::vector<float> const &values,
+                              size_t const DIMX,
+                              size_t const DIMY,
+                              std::vector<float> const &isovalues,
+                              bool const useInterpolation,
+                              bool const ambiguousCaseMidpoint,
+                              ThreadPool &threadPool,
+                              std::vector<Vertex> &result)
+{
+    result.clear();
+    if (DIMX < 2U || DIMY < 2U || isovalues.empty())
+        return;
+
+    Options const options{values, DIMX, DIMY, isovalues, useInterpolation, ambiguousCaseMidpoint};
+
+    size_t const numberOfTilesX = (DIMX - 1U + s_tileSize - 1U) / s_tileSize;
+    size_t const numberOfTilesY = (DIMY - 1U + s_tileSize - 1U) / s_tileSize;
+
+    // Keep the capacity of the per-thread vectors between calls.
+    m_threadVertices.resize(threadPool.threadCount());
+    for (std::vector<Vertex> &threadVertices : m_threadVertices)
+        threadVertices.clear();
+
+    threadPool.parallelFor(0U, numberOfTilesY, [&](size_t const begin, size_t const end, size_t const thread)
+    {
+        for (size_t tileY = begin; tileY < end; ++tileY)
+            for (size_t tileX = 0U; tileX < numberOfTilesX; ++tileX)
+                extractTile(options, tileX, tileY, m_threadVertices[thread]);
+    });
+
+    size_t numberOfVertices = 0U;
+    for (std::vector<Vertex> const &threadVertices : m_threadVertices)
+        numberOfVertices += threadVertices.size();
+
+    result.reserve(numberOfVertices);
+    for (std::vector<Vertex> const &threadVertices : m_threadVertices)
+        result.insert(result.end(), threadVertices.begin(), threadVertices.end());
+}
+
+void MarchingSquares::extractTile(Options const &options, size_t const tileX, size_t const tileY, std::vector<Vertex> &result)
+{
+    size_t const DIMX = options.DIMX;
+    size_t const iBegin = tileX * s_tileSize;
+    size_t const jBegin = tileY * s_tileSize;
+    size_t const iEnd = std::min(iBegin + s_tileSize, DIMX - 1U); // Exclusive, in cells.
+    size_t const jEnd = std::min(jBegin + s_tileSize, options.DIMY - 1U);
+
+    // The range of the corner values of all cells in the tile.
+    float tileMin = options.values[jBegin * DIMX + iBegin];
+    float tileMax = tileMin;
+    for (size_t j = jBegin; j <= jEnd; ++j)
+    {
+        for (size_t i = iBegin; i <= iEnd; ++i)
+        {
+            float const value = options.values[j * DIMX + i];
+            tileMin = std::min(tileMin, value);
+            tileMax = std::max(tileMax, value);
+        }
+    }
+
+    for (size_t level = 0U; level < options.isovalues.size(); ++level)
+    {
+        // A cell is crossed when it has corners on both sides, i.e. above and not above the isovalue.
+        float const rho = options.isovalues[level];
+        if (!(tileMin <= rho && tileMax > rho))
+            continue;
+
+        for (size_t j = jBegin; j < jEnd; ++j)
+            for (size_t i = iBegin; i < iEnd; ++i)
+                extractCell(options, i, j, level, result);
+    }
+}
+
+void MarchingSquares::extractCell(Options const &options, size_t const i, size_t const j, size_t const level,
+                                  std::vector<Vertex> &result)
+{
+    size_t const DIMX = options.DIMX;
+    float const rho = options.isovalues[level];
+    std::array<float, 4U> const corners{options.values[j * DIMX + i],
+                                        options.values[j * DIMX + i + 1U],
+                                        options.values[(j + 1U) * DIMX + i + 1U],
+                                        options.values[(j + 1U) * DIMX + i]};
+
+    unsigned int cellCase = 0U;
+    for (unsigned int corner = 0U; corner < 4U; ++corner)
+        if (corners[corner] > rho)
+            cellCase |= 1U << corner;
+
+    if (cellCase == 0U || cellCase == 15U)
+        return;
+
+    std::array<EdgePair, 2U> segments = segmentTable[cellCase];
+    if (cellCase == 5U || cellCase == 10U)
+    {
+        float const centerValue = [&]()
+        {
+            float const denominator = corners[0] + corners[2] - corners[1] - corners[3];
+            if (options.ambiguousCaseMidpoint || denominator == 0.0F)
+                return 0.25F * (corners[0] + corners[1] + corners[2] + corners[3]);
+
+            // The value at the saddle point of the bilinear interpolant.
+            return (corners[0] * corners[2] - corners[1] * corners[3]) / denominator;
+        }();
+
+        // Corners 0 and 2 are above the isovalue in case 5. If the center is above as well, they are connected and the
+        // isoline cuts off corners 1 and 3. Case 10 is the mirror image.
+        bool const centerAbove = centerValue > rho;
+        if (cellCase == 5U)
+            segments = centerAbove ? cutOffCorners13 : cutOffCorners02;
+        else
+            segments = centerAbove ? cutOffCorners02 : cutOffCorners13;
+    }
+
+    auto const edgeVertex = [&](int const edge)
+    {
+        int const corner0 = edge;
+        int const corner1 = (edge + 1) % 4;
+
+        float t = 0.5F;
+        if (options.useInterpolation && corners[corner1] != corners[corner0])
+            t = (rho - corners[corner0]) / (corners[corner1] - corners[corner0]);
+
+        auto const &offset0 = cornerOffsets[corner0];
+        auto const &offset1 = cornerOffsets[corner1];
+        return Vertex{static_cast<float>(i) + offset0[0] + t * (offset1[0] - offset0[0]),
+                      static_cast<float>(j) + offset0[1] + t * (offset1[1] - offset0[1]),
+                      static_cast<float>(level)};
+    };
+
+    for (EdgePair const &segment : segments)
+    {
+        if (segment.first < 0)
+            continue;
+
+        result.push_back(edgeVertex(segment.first));
+        result.push_back(edgeVertex(segment.second));
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef MARCHINGSQUARES_H
+#define MARCHINGSQUARES_H
+
+#include "threadpool.h"
+
+#include <cstddef>
+#include <vector>
+
+// CPU marching squares on a row-major grid of DIMX * DIMY values.
+// The result is a list of line segments (two vertices each) for all isovalues, ready to be drawn as GL_LINES.
+// The grid is split into tiles of s_tileSize * s_tileSize cells. Tiles whose value range does not contain an isovalue
+// are skipped as a whole, and rows of tiles are distributed over the threads of a ThreadPool.
+class MarchingSquares
+{
+public:
+    struct Vertex
+    {
+        float x;     // Grid coordinates: (i, j) is the position of value i + j * DIMX.
+        float y;
+        float level; // Index of the isovalue.
+    };
+
+private:
+    static constexpr size_t s_tileSize = 16U;
+
+    std::vector<std::vector<Vertex>> m_threadVertices; // Per thread, so that the threads never share a vector.
+
+    struct Options
+    {
+        std::vector<float> const &values;
+        size_t DIMX;
+        size_t DIMY;
+        std::vector<float> const &isovalues;
+        bool useInterpolation;
+        bool ambiguousCaseMidpoint;
+    };
+
+    static void extractTile(Options const &options, size_t const tileX, size_t const tileY, std::vector<Vertex> &result);
+    static void extractCell(Options const &options, size_t const i, size_t const j, size_t const level,
+                            std::vector<Vertex> &result);
+
+public:
+    // Without interpolation, the isoline crosses the edges of a cell halfway. The ambiguous (saddle) cases are decided
+    // by the average of the four corners (midpoint decider) or by the value at the saddle point (asymptotic decider).
+    void extract(std::vector<float> const &values,
+                 size_t const DIMX,
+                 size_t const DIMY,
+                 std::vector<float> const &isovalues,
+                 bool const useInterpolation,
+                 bool const ambiguousCaseMidpoint,
+                 ThreadPool &threadPool,
+                 std::vector<Vertex> &result);
+};
+
+#endif // MARCHINGSQUARES_H
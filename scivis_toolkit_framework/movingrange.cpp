@@ -1,7 +1,5 @@
 #include "movingrange.h"
 
-#include <algorithm>
-
 MovingRange::MovingRange(size_t const windowSize, QVector2D const initialValue)
 :
     m_windowSize(windowSize),
@@ -18,39 +16,52 @@ void MovingRange::setWindowSize(size_t const windowSize)
     m_windowSize = windowSize;
     m_range = m_initialValue;
 
-    // Empty the queue.
-    while (!m_window.empty())
-        m_window.pop();
-
     fillWindow();
 }
 
 // Fills the moving range window with initial values.
+// Equal values never become candidates, so only the last initial value is a candidate.
 void MovingRange::fillWindow()
 {
-    for (size_t n = 0U; n < m_windowSize; ++n)
-        m_window.emplace(m_initialValue);
+    m_window.assign(m_windowSize, m_initialValue);
+    m_nextSequenceNumber = m_windowSize;
+
+    m_minCandidates.reset(m_windowSize);
+    m_maxCandidates.reset(m_windowSize);
+    m_minCandidates.pushBack(m_windowSize - 1U);
+    m_maxCandidates.pushBack(m_windowSize - 1U);
+}
+
+QVector2D const &MovingRange::value(size_t const sequenceNumber) const
+{
+    return m_window[sequenceNumber % m_windowSize];
 }
 
 void MovingRange::update(QVector2D const newValue)
 {
-    // Update queue.
-    m_window.pop();
-    m_window.push(newValue);
-
-    float min = newValue.x();
-    float max = newValue.y();
-
-    std::queue<QVector2D> tempQueue{m_window};
-    while (!tempQueue.empty())
-    {
-        QVector2D const val =  tempQueue.front();
-        min = std::min(min, val.x());
-        max = std::max(max, val.y());
-        tempQueue.pop();
-    }
-
-    m_range = QVector2D{min, max};
+    size_t const sequenceNumber = m_nextSequenceNumber++;
+    size_t const oldestInWindow = sequenceNumber + 1U - m_windowSize;
+
+    // Update window.
+    m_window[sequenceNumber % m_windowSize] = newValue;
+
+    // Drop the candidates that left the window.
+    // The new value has not been added yet, so these are not affected by the overwrite above.
+    if (m_minCandidates.size > 0U && m_minCandidates.front() < oldestInWindow)
+        m_minCandidates.popFront();
+    if (m_maxCandidates.size > 0U && m_maxCandidates.front() < oldestInWindow)
+        m_maxCandidates.popFront();
+
+    // Candidates that are not smaller (larger) than the new value can never become the minimum (maximum) again.
+    while (m_minCandidates.size > 0U && value(m_minCandidates.back()).x() >= newValue.x())
+        m_minCandidates.popBack();
+    while (m_maxCandidates.size > 0U && value(m_maxCandidates.back()).y() <= newValue.y())
+        m_maxCandidates.popBack();
+
+    m_minCandidates.pushBack(sequenceNumber);
+    m_maxCandidates.pushBack(sequenceNumber);
+
+    m_range = QVector2D{value(m_minCandidates.front()).x(), value(m_maxCandidates.front()).y()};
 }
 
 QVector2D MovingRange::range() const
@@ -61,10 +72,41 @@ QVector2D MovingRange::range() const
 void MovingRange::printWindow() const
 {
     qDebug() << "Printing queue:";
-    std::queue<QVector2D> tempQueue{m_window};
-    while (!tempQueue.empty())
-    {
-        qDebug() << tempQueue.front();
-        tempQueue.pop();
-    }
+    for (size_t sequenceNumber = m_nextSequenceNumber - m_windowSize; sequenceNumber < m_nextSequenceNumber; ++sequenceNumber)
+        qDebug() << value(sequenceNumber);
+}
+
+void MovingRange::MonotonicQueue::reset(size_t const capacity)
+{
+    sequenceNumbers.assign(capacity, 0U);
+    head = 0U;
+    size = 0U;
+}
+
+size_t MovingRange::MonotonicQueue::front() const
+{
+    return sequenceNumbers[head];
+}
+
+size_t MovingRange::MonotonicQueue::back() const
+{
+    return sequenceNumbers[(head + size - 1U) % sequenceNumbers.size()];
+}
+
+void MovingRange::MonotonicQueue::popFront()
+{
+    head = (head + 1U) % sequenceNumbers.size();
+    --size;
+}
+
+void MovingRange::MonotonicQueue::popBack()
+{
+    --size;
+}
+
+void MovingRange::MonotonicQueue::pushBack(size_t const sequenceNumber)
+{
+    Q_ASSERT(size < sequenceNumbers.size());
+    sequenceNumbers[(head + size) % sequenceNumbers.size()] = sequenceNumber;
+    ++size;
 }
@@ -5,17 +5,40 @@
 #include <QVector2D>
 
 #include <cstddef>
-#include <queue>
+#include <vector>
 
+// The range (minimum of x, maximum of y) of the last windowSize values.
+// The values are kept in a ring buffer. Two monotonic queues hold the candidates for the minimum and the maximum,
+// so an update takes amortized O(1) time and never allocates.
 class MovingRange
 {
+    // A double-ended queue of sequence numbers, stored in a ring buffer with room for a whole window.
+    struct MonotonicQueue
+    {
+        std::vector<size_t> sequenceNumbers;
+        size_t head = 0U;
+        size_t size = 0U;
+
+        void reset(size_t const capacity);
+        [[nodiscard]] size_t front() const;
+        [[nodiscard]] size_t back() const;
+        void popFront();
+        void popBack();
+        void pushBack(size_t const sequenceNumber);
+    };
+
     size_t m_windowSize;
     QVector2D const m_initialValue;
 
-    std::queue<QVector2D> m_window;
+    std::vector<QVector2D> m_window; // Ring buffer, value n is stored at n % m_windowSize.
+    size_t m_nextSequenceNumber = 0U;
+
+    MonotonicQueue m_minCandidates;  // x values increase from front to back.
+    MonotonicQueue m_maxCandidates;  // y values decrease from front to back.
     QVector2D m_range;
 
     void fillWindow();
+    [[nodiscard]] QVector2D const &value(size_t const sequenceNumber) const;
 
 public:
     MovingRange(size_t const windowSize, QVector2D const initialValue);
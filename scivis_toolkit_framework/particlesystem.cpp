@@ -0,0 +1,177 @@
+#include "particlesystem.h"
+
+#include "shaderprogram.h"
+
+#include <algorithm>
+
+using shaderprogram::uniformLocationWithCheck;
+
+namespace
+{
+    // One vec4 per particle: position, age and lifetime.
+    constexpr size_t s_floatsPerParticle = 4U;
+}
+
+void ParticleSystem::create(QOpenGLFunctions_3_3_Core * const gl, size_t const capacity)
+{
+    m_gl = gl;
+
+    // The advection pass only writes the transform feedback buffer, it has no fragment shader. The captured output
+    // has to be declared before linking.
+    m_shaderProgramAdvect.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/particles_advect.vert");
+    char const * const varyings[] = {"particle"};
+    m_gl->glTransformFeedbackVaryings(m_shaderProgramAdvect.programId(), 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    m_shaderProgramAdvect.link();
+
+    m_shaderProgramDraw.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/particles.vert");
+    m_shaderProgramDraw.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/particles.frag");
+    m_shaderProgramDraw.link();
+
+    m_uniformLocationAdvect_velocity = uniformLocationWithCheck(m_shaderProgramAdvect, "velocity");
+    m_uniformLocationAdvect_dt = uniformLocationWithCheck(m_shaderProgramAdvect, "dt");
+    m_uniformLocationAdvect_steps = uniformLocationWithCheck(m_shaderProgramAdvect, "steps");
+    m_uniformLocationAdvect_aspectRatio = uniformLocationWithCheck(m_shaderProgramAdvect, "aspectRatio");
+    m_uniformLocationAdvect_emitters = uniformLocationWithCheck(m_shaderProgramAdvect, "emitters");
+    m_uniformLocationAdvect_numberOfEmitters = uniformLocationWithCheck(m_shaderProgramAdvect, "numberOfEmitters");
+    m_uniformLocationAdvect_particlesPerEmitter = uniformLocationWithCheck(m_shaderProgramAdvect,
+                                                                           "particlesPerEmitter");
+    m_uniformLocationAdvect_emissionStart = uniformLocationWithCheck(m_shaderProgramAdvect, "emissionStart");
+    m_uniformLocationAdvect_capacity = uniformLocationWithCheck(m_shaderProgramAdvect, "capacity");
+    m_uniformLocationAdvect_emissionRadius = uniformLocationWithCheck(m_shaderProgramAdvect, "emissionRadius");
+    m_uniformLocationAdvect_lifetime = uniformLocationWithCheck(m_shaderProgramAdvect, "lifetime");
+    m_uniformLocationAdvect_seed = uniformLocationWithCheck(m_shaderProgramAdvect, "seed");
+    m_uniformLocationDraw_DIM = uniformLocationWithCheck(m_shaderProgramDraw, "DIM");
+    m_uniformLocationDraw_cellSize = uniformLocationWithCheck(m_shaderProgramDraw, "cellSize");
+    m_uniformLocationDraw_colorMap = uniformLocationWithCheck(m_shaderProgramDraw, "colorMap");
+
+    // Attribute 0 is the particle, in both vertex arrays.
+    m_gl->glGenBuffers(2, m_vbos.data());
+    m_gl->glGenVertexArrays(2, m_vaos.data());
+    for (size_t idx = 0U; idx < 2U; ++idx)
+    {
+        m_gl->glBindVertexArray(m_vaos[idx]);
+        m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_vbos[idx]);
+        m_gl->glEnableVertexAttribArray(0U);
+        m_gl->glVertexAttribPointer(0U, static_cast<GLint>(s_floatsPerParticle), GL_FLOAT, GL_FALSE,
+                                    static_cast<GLsizei>(s_floatsPerParticle * sizeof(float)),
+                                    reinterpret_cast<GLvoid*>(0));
+    }
+    m_gl->glBindVertexArray(0U);
+
+    setCapacity(capacity);
+}
+
+void ParticleSystem::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    m_gl->glDeleteVertexArrays(2, m_vaos.data());
+    m_gl->glDeleteBuffers(2, m_vbos.data());
+    m_gl = nullptr;
+}
+
+// The buffers start out with every particle at age and lifetime zero, which is dead.
+void ParticleSystem::setCapacity(size_t const capacity)
+{
+    m_capacity = std::max<size_t>(capacity, 1U);
+    m_current = 0U;
+    m_emissionStart = 0U;
+    m_emitters.clear();
+
+    std::vector<float> const particles(m_capacity * s_floatsPerParticle, 0.0F);
+    for (GLuint const vbo : m_vbos)
+    {
+        m_gl->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        m_gl->glBufferData(GL_ARRAY_BUFFER,
+                           static_cast<GLsizeiptr>(particles.size() * sizeof(float)),
+                           particles.data(),
+                           GL_DYNAMIC_COPY);
+    }
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, 0U);
+}
+
+void ParticleSystem::inject(float const x, float const y)
+{
+    if (m_emitters.size() < 2U * s_maxNumberOfEmitters)
+    {
+        m_emitters.push_back(x);
+        m_emitters.push_back(y);
+    }
+}
+
+// While particles are emitted every step, the ring turns once per s_lifetime steps, so a particle is about to die of
+// age when it is replaced.
+void ParticleSystem::advance(GLuint const velocityTexture, float const dt, size_t const steps,
+                             float const aspectRatio)
+{
+    if (steps == 0U)
+        return;
+
+    size_t const numberOfEmitters = m_emitters.size() / 2U;
+    auto const particlesPerStep = std::max(static_cast<size_t>(static_cast<float>(m_capacity) / s_lifetime),
+                                           size_t{1U});
+    size_t const particlesPerEmitter = numberOfEmitters == 0U
+                                     ? 0U
+                                     : std::max(particlesPerStep / numberOfEmitters, size_t{1U});
+    size_t const numberOfEmitted = std::min(numberOfEmitters * particlesPerEmitter, m_capacity);
+
+    m_shaderProgramAdvect.bind();
+    m_gl->glUniform1i(m_uniformLocationAdvect_velocity, 0);
+    m_gl->glUniform1f(m_uniformLocationAdvect_dt, dt);
+    m_gl->glUniform1f(m_uniformLocationAdvect_steps, static_cast<float>(steps));
+    m_gl->glUniform1f(m_uniformLocationAdvect_aspectRatio, aspectRatio);
+    if (numberOfEmitters > 0U)
+        m_gl->glUniform2fv(m_uniformLocationAdvect_emitters, static_cast<GLsizei>(numberOfEmitters), m_emitters.data());
+    m_gl->glUniform1i(m_uniformLocationAdvect_numberOfEmitters, static_cast<GLint>(numberOfEmitters));
+    m_gl->glUniform1i(m_uniformLocationAdvect_particlesPerEmitter, static_cast<GLint>(particlesPerEmitter));
+    m_gl->glUniform1i(m_uniformLocationAdvect_emissionStart, static_cast<GLint>(m_emissionStart));
+    m_gl->glUniform1i(m_uniformLocationAdvect_capacity, static_cast<GLint>(m_capacity));
+    m_gl->glUniform1f(m_uniformLocationAdvect_emissionRadius, s_emissionRadius);
+    m_gl->glUniform1f(m_uniformLocationAdvect_lifetime, s_lifetime);
+    m_gl->glUniform1ui(m_uniformLocationAdvect_seed, m_seed);
+    m_gl->glActiveTexture(GL_TEXTURE0);
+    m_gl->glBindTexture(GL_TEXTURE_2D, velocityTexture);
+
+    m_gl->glEnable(GL_RASTERIZER_DISCARD);
+    m_gl->glBindVertexArray(m_vaos[m_current]);
+    m_gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0U, m_vbos[1U - m_current]);
+    m_gl->glBeginTransformFeedback(GL_POINTS);
+    m_gl->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_capacity));
+    m_gl->glEndTransformFeedback();
+    m_gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0U, 0U);
+    m_gl->glDisable(GL_RASTERIZER_DISCARD);
+    m_current = 1U - m_current;
+
+    m_emitters.clear();
+    m_emissionStart = (m_emissionStart + numberOfEmitted) % m_capacity;
+    ++m_seed;
+}
+
+void ParticleSystem::draw(size_t const DIMX, size_t const DIMY, float const cellWidth, float const cellHeight,
+                          GLuint const colorMap)
+{
+    m_shaderProgramDraw.bind();
+    m_gl->glUniform2f(m_uniformLocationDraw_DIM, static_cast<float>(DIMX), static_cast<float>(DIMY));
+    m_gl->glUniform2f(m_uniformLocationDraw_cellSize, cellWidth, cellHeight);
+    m_gl->glUniform1i(m_uniformLocationDraw_colorMap, 0);
+    m_gl->glActiveTexture(GL_TEXTURE0);
+    m_gl->glBindTexture(GL_TEXTURE_1D, colorMap);
+
+    m_gl->glEnable(GL_BLEND);
+    m_gl->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_gl->glBindVertexArray(m_vaos[m_current]);
+    m_gl->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(m_capacity));
+    m_gl->glDisable(GL_BLEND);
+}
+
+// Getters
+size_t ParticleSystem::capacity() const
+{
+    return m_capacity;
+}
+
+std::array<GLuint, 2U> const &ParticleSystem::buffers() const
+{
+    return m_vbos;
+}
@@ -0,0 +1,88 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Particles advected through a velocity texture entirely on the GPU. Every particle is a vec4 of its position in
+// texture coordinates, its age and its lifetime, both in simulation steps. A step is a transform feedback pass that
+// reads one vertex buffer and writes the other, so the particles never pass through the CPU.
+// New particles are released around the points given to inject(), replacing the oldest ones: the buffer is used as a
+// ring, and every step respawns the next range of it. A particle that is older than its lifetime is not drawn.
+//
+// Every function has to be called with the context current.
+class ParticleSystem
+{
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    size_t m_capacity = 0U;
+
+    // Two buffers, read from one and written into the other, each with a vertex array that reads it.
+    std::array<GLuint, 2U> m_vbos{};
+    std::array<GLuint, 2U> m_vaos{};
+    size_t m_current = 0U;
+
+    std::vector<float> m_emitters; // x, y of the points emitted since the last step, in texture coordinates.
+    size_t m_emissionStart = 0U;   // The first particle the next step respawns.
+    GLuint m_seed = 0U;            // Changes every step, so the respawned particles scatter differently.
+
+    QOpenGLShaderProgram m_shaderProgramAdvect;
+    QOpenGLShaderProgram m_shaderProgramDraw;
+
+    GLint m_uniformLocationAdvect_velocity;
+    GLint m_uniformLocationAdvect_dt;
+    GLint m_uniformLocationAdvect_steps;
+    GLint m_uniformLocationAdvect_aspectRatio;
+    GLint m_uniformLocationAdvect_emitters;
+    GLint m_uniformLocationAdvect_numberOfEmitters;
+    GLint m_uniformLocationAdvect_particlesPerEmitter;
+    GLint m_uniformLocationAdvect_emissionStart;
+    GLint m_uniformLocationAdvect_capacity;
+    GLint m_uniformLocationAdvect_emissionRadius;
+    GLint m_uniformLocationAdvect_lifetime;
+    GLint m_uniformLocationAdvect_seed;
+    GLint m_uniformLocationDraw_DIM;
+    GLint m_uniformLocationDraw_cellSize;
+    GLint m_uniformLocationDraw_colorMap;
+
+public:
+    // Must match MAX_NUMBER_OF_EMITTERS in particles_advect.vert.
+    static constexpr size_t s_maxNumberOfEmitters = 16U;
+    static constexpr float s_lifetime = 256.0F; // The longest lifetime, in simulation steps. Most live shorter.
+    static constexpr float s_emissionRadius = 0.01F; // In texture coordinates, around the emitted point.
+
+    ParticleSystem() = default;
+    ParticleSystem(ParticleSystem const&) = delete;
+    ParticleSystem& operator=(ParticleSystem const&) = delete;
+
+    // Compiles the shader programs and creates the buffers of capacity particles.
+    void create(QOpenGLFunctions_3_3_Core * const gl, size_t const capacity);
+    void destroy();
+
+    // Reallocates the buffers, which removes all particles.
+    void setCapacity(size_t const capacity);
+
+    // Releases particles around (x, y), in texture coordinates, in the next step. Points beyond
+    // s_maxNumberOfEmitters per step are dropped.
+    void inject(float const x, float const y);
+
+    // Advances the particles by steps simulation steps of dt through velocityTexture, an RG texture of the velocity
+    // in units of the grid width per unit of time, with GL_REPEAT wrapping. aspectRatio is the width over the height of
+    // the grid.
+    void advance(GLuint const velocityTexture, float const dt, size_t const steps, float const aspectRatio);
+
+    // Draws the particles as points at the grid placement of the visualization, colored by their remaining life with
+    // the 1D texture colorMap and faded out towards the end of it.
+    void draw(size_t const DIMX, size_t const DIMY, float const cellWidth, float const cellHeight,
+              GLuint const colorMap);
+
+    // Getters
+    [[nodiscard]] size_t capacity() const;
+    // The two buffers the particles are advected between, for the GPU memory bookkeeping.
+    [[nodiscard]] std::array<GLuint, 2U> const &buffers() const;
+};
+
+#endif // PARTICLESYSTEM_H
@@ -0,0 +1,79 @@
+#include "preintegrationtable.h"
+
+#include <algorithm>
+#include <cmath>
+
+template<typename T>
+T PreIntegrationTable::interpolate(std::vector<T> const &table, float const value) const
+{
+    float const position = std::clamp(value, 0.0F, 1.0F) * static_cast<float>(table.size() - 1U);
+    size_t const level = std::min(static_cast<size_t>(position), table.size() - 2U);
+    float const fraction = position - static_cast<float>(level);
+
+    return table[level] * (1.0F - fraction) + table[level + 1U] * fraction;
+}
+
+void PreIntegrationTable::setTransferFunction(std::vector<QVector4D> const &transferFunction)
+{
+    size_t const numberOfLevels = transferFunction.size();
+    m_extinction.resize(numberOfLevels);
+    m_weightedColor.resize(numberOfLevels);
+    for (size_t level = 0U; level < numberOfLevels; ++level)
+    {
+        // A fully opaque sample would have an infinite extinction.
+        float const alpha = std::min(transferFunction[level].w(), 1.0F - 1e-6F);
+        m_extinction[level] = -std::log(1.0F - alpha);
+        m_weightedColor[level] = m_extinction[level] * transferFunction[level].toVector3D();
+    }
+
+    // Trapezoidal rule between neighbouring levels.
+    float const levelSpacing = 1.0F / static_cast<float>(numberOfLevels - 1U);
+    m_integralExtinction.assign(numberOfLevels, 0.0F);
+    m_integralColor.assign(numberOfLevels, QVector3D{});
+    for (size_t level = 1U; level < numberOfLevels; ++level)
+    {
+        m_integralExtinction[level] = m_integralExtinction[level - 1U]
+                                      + 0.5F * levelSpacing * (m_extinction[level - 1U] + m_extinction[level]);
+        m_integralColor[level] = m_integralColor[level - 1U]
+                                 + 0.5F * levelSpacing * (m_weightedColor[level - 1U] + m_weightedColor[level]);
+    }
+}
+
+void PreIntegrationTable::build(size_t const DIM, std::vector<QVector4D> &table, ThreadPool &threadPool) const
+{
+    table.resize(DIM * DIM);
+    auto const valueOf = [DIM](size_t const idx) { return (static_cast<float>(idx) + 0.5F) / static_cast<float>(DIM); };
+
+    threadPool.parallelFor(0U, DIM, [&](size_t const begin, size_t const end, size_t const) {
+        for (size_t backIdx = begin; backIdx < end; ++backIdx)
+        {
+            float const back = valueOf(backIdx);
+            float const integralExtinctionBack = interpolate(m_integralExtinction, back);
+            QVector3D const integralColorBack = interpolate(m_integralColor, back);
+
+            for (size_t frontIdx = 0U; frontIdx < DIM; ++frontIdx)
+            {
+                float const front = valueOf(frontIdx);
+
+                // The averages of tau and tau * rgb over the values of the step. A constant value has no range to
+                // average over, there the transfer function itself applies.
+                float meanExtinction = interpolate(m_extinction, front);
+                QVector3D meanWeightedColor = interpolate(m_weightedColor, front);
+                if (frontIdx != backIdx)
+                {
+                    float const valueRange = back - front;
+                    meanExtinction = (integralExtinctionBack - interpolate(m_integralExtinction, front)) / valueRange;
+                    meanWeightedColor = (integralColorBack - interpolate(m_integralColor, front)) / valueRange;
+                }
+
+                // The color is the extinction-weighted mean color of the step, premultiplied with its opacity. This
+                // neglects the attenuation within the step, which is small for a single sample step.
+                float const alpha = 1.0F - std::exp(-meanExtinction);
+                QVector3D const color = meanExtinction > 0.0F ? meanWeightedColor * (alpha / meanExtinction)
+                                                              : QVector3D{};
+
+                table[backIdx * DIM + frontIdx] = QVector4D{color, alpha};
+            }
+        }
+    });
+}
@@ -0,0 +1,39 @@
+#ifndef PREINTEGRATIONTABLE_H
+#define PREINTEGRATIONTABLE_H
+
+#include "threadpool.h"
+
+#include <QVector3D>
+#include <QVector4D>
+
+#include <cstddef>
+#include <vector>
+
+// Pre-integrated transfer function after Engel et al., "High-Quality Pre-Integrated Volume Rendering Using
+// Hardware-Accelerated Pixel Shading" (2001). Entry (front, back) of the table is the color and opacity of one sample
+// step through values going linearly from front to back.
+// Instead of integrating every entry in small steps, the transfer function is turned into integral tables once:
+// the extinction of a sample step, tau = -ln(1 - alpha), and the extinction-weighted color, summed from value 0.
+// An entry is then the difference of two table values, so a rebuild is O(DIM^2) after O(levels) for the integrals.
+class PreIntegrationTable
+{
+    std::vector<float> m_extinction;          // tau at every level of the transfer function.
+    std::vector<QVector3D> m_weightedColor;   // tau * rgb at every level.
+    std::vector<float> m_integralExtinction;  // Integral of tau from value 0 up to every level.
+    std::vector<QVector3D> m_integralColor;   // Integral of tau * rgb from value 0 up to every level.
+
+    // The value of a table at value in [0, 1], interpolated between its levels.
+    template<typename T>
+    [[nodiscard]] T interpolate(std::vector<T> const &table, float const value) const;
+
+public:
+    // transferFunction holds the RGBA of evenly spaced values from 0 to 1 (at least two), where alpha is the opacity
+    // of one sample step.
+    void setTransferFunction(std::vector<QVector4D> const &transferFunction);
+
+    // Fills table with DIM x DIM premultiplied RGBA entries, front value along x and back value along y. Entry idx
+    // stands for value (idx + 0.5) / DIM, the value a linearly filtered texture of the table returns it for.
+    void build(size_t const DIM, std::vector<QVector4D> &table, ThreadPool &threadPool) const;
+};
+
+#endif // PREINTEGRATIONTABLE_H
@@ -0,0 +1,365 @@
+#include "preprocessingpipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+// The row kernels below process the interior with SIMD and the remaining values (and the border columns) one by one.
+
+float rowMax(float const * const values, size_t const size)
+{
+    float result = -std::numeric_limits<float>::infinity();
+    size_t idx = 0U;
+#if defined(__AVX2__)
+    __m256 maxima = _mm256_set1_ps(result);
+    for (; idx + 8U <= size; idx += 8U)
+        maxima = _mm256_max_ps(maxima, _mm256_loadu_ps(values + idx));
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, maxima);
+    result = *std::max_element(lanes, lanes + 8);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t maxima = vdupq_n_f32(result);
+    for (; idx + 4U <= size; idx += 4U)
+        maxima = vmaxq_f32(maxima, vld1q_f32(values + idx));
+
+    result = vmaxvq_f32(maxima);
+#endif
+    for (; idx < size; ++idx)
+        result = std::max(result, values[idx]);
+
+    return result;
+}
+
+// dst = floor(clamp(round(src * scale), 0, 255) * step)
+void quantizeRow(float const * const src, float * const dst, size_t const size, float const scale, float const step)
+{
+    size_t idx = 0U;
+#if defined(__AVX2__)
+    __m256 const scales = _mm256_set1_ps(scale);
+    __m256 const steps = _mm256_set1_ps(step);
+    __m256 const zeros = _mm256_setzero_ps();
+    __m256 const maxima = _mm256_set1_ps(255.0F);
+    for (; idx + 8U <= size; idx += 8U)
+    {
+        __m256 const pixel = _mm256_round_ps(_mm256_mul_ps(_mm256_loadu_ps(src + idx), scales),
+                                             _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 const clamped = _mm256_min_ps(_mm256_max_ps(pixel, zeros), maxima);
+        _mm256_storeu_ps(dst + idx, _mm256_floor_ps(_mm256_mul_ps(clamped, steps)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t const zeros = vdupq_n_f32(0.0F);
+    float32x4_t const maxima = vdupq_n_f32(255.0F);
+    for (; idx + 4U <= size; idx += 4U)
+    {
+        float32x4_t const pixel = vrndnq_f32(vmulq_n_f32(vld1q_f32(src + idx), scale));
+        float32x4_t const clamped = vminq_f32(vmaxq_f32(pixel, zeros), maxima);
+        vst1q_f32(dst + idx, vrndmq_f32(vmulq_n_f32(clamped, step)));
+    }
+#endif
+    // std::nearbyint rounds halfway cases to even, like the SIMD paths.
+    for (; idx < size; ++idx)
+        dst[idx] = std::floor(std::clamp(std::nearbyint(src[idx] * scale), 0.0F, 255.0F) * step);
+}
+
+// dst[i] = weight * (src[i - 1] + 2 src[i] + src[i + 1])
+void smoothRow(float const * const src, float * const dst, size_t const size, float const weight)
+{
+    size_t const last = size - 1U;
+    dst[0] = weight * (3.0F * src[0] + src[std::min<size_t>(1U, last)]);
+    if (last == 0U)
+        return;
+
+    size_t idx = 1U;
+#if defined(__AVX2__)
+    __m256 const weights = _mm256_set1_ps(weight);
+    for (; idx + 8U <= last; idx += 8U)
+    {
+        __m256 const center = _mm256_loadu_ps(src + idx);
+        __m256 const sides = _mm256_add_ps(_mm256_loadu_ps(src + idx - 1U), _mm256_loadu_ps(src + idx + 1U));
+        _mm256_storeu_ps(dst + idx, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(center, center), sides), weights));
+    }
+#elif defined(__ARM_NEON)
+    for (; idx + 4U <= last; idx += 4U)
+    {
+        float32x4_t const center = vld1q_f32(src + idx);
+        float32x4_t const sides = vaddq_f32(vld1q_f32(src + idx - 1U), vld1q_f32(src + idx + 1U));
+        vst1q_f32(dst + idx, vmulq_n_f32(vaddq_f32(vaddq_f32(center, center), sides), weight));
+    }
+#endif
+    for (; idx < last; ++idx)
+        dst[idx] = weight * (src[idx - 1U] + 2.0F * src[idx] + src[idx + 1U]);
+
+    dst[last] = weight * (src[last - 1U] + 3.0F * src[last]);
+}
+
+// dst[i] = src[i + 1] - src[i - 1]
+void differenceRow(float const * const src, float * const dst, size_t const size)
+{
+    size_t const last = size - 1U;
+    dst[0] = src[std::min<size_t>(1U, last)] - src[0];
+    if (last == 0U)
+        return;
+
+    size_t idx = 1U;
+#if defined(__AVX2__)
+    for (; idx + 8U <= last; idx += 8U)
+        _mm256_storeu_ps(dst + idx, _mm256_sub_ps(_mm256_loadu_ps(src + idx + 1U), _mm256_loadu_ps(src + idx - 1U)));
+#elif defined(__ARM_NEON)
+    for (; idx + 4U <= last; idx += 4U)
+        vst1q_f32(dst + idx, vsubq_f32(vld1q_f32(src + idx + 1U), vld1q_f32(src + idx - 1U)));
+#endif
+    for (; idx < last; ++idx)
+        dst[idx] = src[idx + 1U] - src[idx - 1U];
+
+    dst[last] = src[last] - src[last - 1U];
+}
+
+// dst = weight * (above + 2 center + below)
+void verticalSmoothRow(float const * const above,
+                       float const * const center,
+                       float const * const below,
+                       float * const dst,
+                       size_t const size,
+                       float const weight)
+{
+    size_t idx = 0U;
+#if defined(__AVX2__)
+    __m256 const weights = _mm256_set1_ps(weight);
+    for (; idx + 8U <= size; idx += 8U)
+    {
+        __m256 const middle = _mm256_loadu_ps(center + idx);
+        __m256 const sides = _mm256_add_ps(_mm256_loadu_ps(above + idx), _mm256_loadu_ps(below + idx));
+        _mm256_storeu_ps(dst + idx, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(middle, middle), sides), weights));
+    }
+#elif defined(__ARM_NEON)
+    for (; idx + 4U <= size; idx += 4U)
+    {
+        float32x4_t const middle = vld1q_f32(center + idx);
+        float32x4_t const sides = vaddq_f32(vld1q_f32(above + idx), vld1q_f32(below + idx));
+        vst1q_f32(dst + idx, vmulq_n_f32(vaddq_f32(vaddq_f32(middle, middle), sides), weight));
+    }
+#endif
+    for (; idx < size; ++idx)
+        dst[idx] = weight * (above[idx] + 2.0F * center[idx] + below[idx]);
+}
+
+// Combines the horizontal passes of the rows above, at and below into the Sobel gradient magnitude:
+// Gx = dAbove + 2 dCenter + dBelow, Gy = sBelow - sAbove.
+void gradientMagnitudeRow(float const * const differenceAbove,
+                          float const * const differenceCenter,
+                          float const * const differenceBelow,
+                          float const * const smoothAbove,
+                          float const * const smoothBelow,
+                          float * const dst,
+                          size_t const size)
+{
+    size_t idx = 0U;
+#if defined(__AVX2__)
+    for (; idx + 8U <= size; idx += 8U)
+    {
+        __m256 const middle = _mm256_loadu_ps(differenceCenter + idx);
+        __m256 const gx = _mm256_add_ps(_mm256_add_ps(middle, middle),
+                                        _mm256_add_ps(_mm256_loadu_ps(differenceAbove + idx),
+                                                      _mm256_loadu_ps(differenceBelow + idx)));
+        __m256 const gy = _mm256_sub_ps(_mm256_loadu_ps(smoothBelow + idx), _mm256_loadu_ps(smoothAbove + idx));
+        _mm256_storeu_ps(dst + idx, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy))));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; idx + 4U <= size; idx += 4U)
+    {
+        float32x4_t const middle = vld1q_f32(differenceCenter + idx);
+        float32x4_t const gx = vaddq_f32(vaddq_f32(middle, middle),
+                                         vaddq_f32(vld1q_f32(differenceAbove + idx), vld1q_f32(differenceBelow + idx)));
+        float32x4_t const gy = vsubq_f32(vld1q_f32(smoothBelow + idx), vld1q_f32(smoothAbove + idx));
+        vst1q_f32(dst + idx, vsqrtq_f32(vmlaq_f32(vmulq_f32(gy, gy), gx, gx)));
+    }
+#endif
+    for (; idx < size; ++idx)
+    {
+        float const gx = differenceAbove[idx] + 2.0F * differenceCenter[idx] + differenceBelow[idx];
+        float const gy = smoothBelow[idx] - smoothAbove[idx];
+        dst[idx] = std::sqrt(gx * gx + gy * gy);
+    }
+}
+}
+
+float const *PreprocessingPipeline::RowWindow::row(long const rowIdx) const
+{
+    auto const clampedRowIdx = static_cast<size_t>(std::clamp(rowIdx, 0L, static_cast<long>(DIMY) - 1L));
+    return data + (clampedRowIdx - firstRow) * DIMX;
+}
+
+void PreprocessingPipeline::apply(std::vector<float> &values,
+                                  size_t const DIMX,
+                                  size_t const DIMY,
+                                  Settings const &settings,
+                                  ThreadPool &threadPool)
+{
+    if (DIMX == 0U || DIMY == 0U || (!settings.quantization && !settings.gaussianBlur && !settings.gradients))
+        return;
+
+    if (m_scratch.size() < threadPool.threadCount())
+        m_scratch.resize(threadPool.threadCount());
+
+    float quantizationScale = 0.0F;
+    float quantizationStep = 1.0F;
+    if (settings.quantization)
+    {
+        // The values are first mapped onto the 8 bit range [0, 255], then onto the 2^n levels of that range.
+        float const maximum = maxValue(values, threadPool);
+        quantizationScale = maximum > 0.0F ? 255.0F / maximum : 0.0F;
+        quantizationStep = PreprocessingPipeline::quantizationStep(settings.quantizationBits);
+    }
+
+    // Four rows of scratch memory per row of the stripe.
+    size_t const rowsPerStripe = std::max<size_t>(4U, s_stripeBytes / (4U * DIMX * sizeof(float)));
+    size_t const numberOfStripes = (DIMY + rowsPerStripe - 1U) / rowsPerStripe;
+
+    m_result.resize(DIMX * DIMY);
+    threadPool.parallelFor(0U, numberOfStripes, [&](size_t const begin, size_t const end, size_t const thread)
+    {
+        for (size_t stripe = begin; stripe < end; ++stripe)
+        {
+            size_t const firstRow = stripe * rowsPerStripe;
+            size_t const endRow = std::min(firstRow + rowsPerStripe, DIMY);
+            processStripe(values, DIMX, DIMY, settings, firstRow, endRow, quantizationScale, quantizationStep,
+                          m_scratch[thread]);
+        }
+    });
+
+    // The previous buffer of values is kept as the output buffer of the next call.
+    values.swap(m_result);
+}
+
+float PreprocessingPipeline::maxValue(std::vector<float> const &values, ThreadPool &threadPool)
+{
+    m_threadMaxima.assign(threadPool.threadCount(), -std::numeric_limits<float>::infinity());
+    threadPool.parallelFor(0U, values.size(), [&](size_t const begin, size_t const end, size_t const thread)
+    {
+        m_threadMaxima[thread] = rowMax(values.data() + begin, end - begin);
+    });
+
+    return *std::max_element(m_threadMaxima.cbegin(), m_threadMaxima.cend());
+}
+
+// Computes output rows [firstRow, endRow). Every filter stage extends the rows it produces by the halo the later
+// stages need, and the last stage writes directly into the result.
+void PreprocessingPipeline::processStripe(std::vector<float> const &values,
+                                          size_t const DIMX,
+                                          size_t const DIMY,
+                                          Settings const &settings,
+                                          size_t const firstRow,
+                                          size_t const endRow,
+                                          float const quantizationScale,
+                                          float const quantizationStep,
+                                          Scratch &scratch)
+{
+    size_t const blurHalo = settings.gaussianBlur ? 1U : 0U;
+    size_t const gradientHalo = settings.gradients ? 1U : 0U;
+
+    // Rows [first, end) extended by halo rows on both sides, limited to the grid.
+    auto const extendRows = [firstRow, endRow, DIMY](size_t const halo, size_t &first, size_t &end)
+    {
+        first = firstRow >= halo ? firstRow - halo : 0U;
+        end = std::min(endRow + halo, DIMY);
+    };
+
+    RowWindow current{values.data(), 0U, DIMX, DIMY};
+    size_t first = 0U;
+    size_t end = 0U;
+
+    if (settings.quantization)
+    {
+        extendRows(blurHalo + gradientHalo, first, end);
+        bool const isLastStage = !settings.gaussianBlur && !settings.gradients;
+
+        float *destination = m_result.data() + first * DIMX;
+        if (!isLastStage)
+        {
+            scratch.quantized.resize((end - first) * DIMX);
+            destination = scratch.quantized.data();
+        }
+
+        for (size_t rowIdx = first; rowIdx < end; ++rowIdx)
+            quantizeRow(current.row(static_cast<long>(rowIdx)), destination + (rowIdx - first) * DIMX, DIMX,
+                        quantizationScale, quantizationStep);
+
+        current = RowWindow{destination, first, DIMX, DIMY};
+    }
+
+    if (settings.gaussianBlur)
+    {
+        extendRows(gradientHalo, first, end);
+        size_t inputFirst = 0U;
+        size_t inputEnd = 0U;
+        extendRows(gradientHalo + 1U, inputFirst, inputEnd);
+
+        scratch.horizontalSmooth.resize((inputEnd - inputFirst) * DIMX);
+        for (size_t rowIdx = inputFirst; rowIdx < inputEnd; ++rowIdx)
+            smoothRow(current.row(static_cast<long>(rowIdx)),
+                      scratch.horizontalSmooth.data() + (rowIdx - inputFirst) * DIMX, DIMX, 0.25F);
+
+        RowWindow const smooth{scratch.horizontalSmooth.data(), inputFirst, DIMX, DIMY};
+        float *destination = m_result.data() + first * DIMX;
+        if (settings.gradients)
+        {
+            scratch.blurred.resize((end - first) * DIMX);
+            destination = scratch.blurred.data();
+        }
+
+        for (size_t rowIdx = first; rowIdx < end; ++rowIdx)
+        {
+            auto const row = static_cast<long>(rowIdx);
+            verticalSmoothRow(smooth.row(row - 1L), smooth.row(row), smooth.row(row + 1L),
+                              destination + (rowIdx - first) * DIMX, DIMX, 0.25F);
+        }
+
+        current = RowWindow{destination, first, DIMX, DIMY};
+    }
+
+    if (settings.gradients)
+    {
+        size_t inputFirst = 0U;
+        size_t inputEnd = 0U;
+        extendRows(1U, inputFirst, inputEnd);
+
+        scratch.horizontalSmooth.resize((inputEnd - inputFirst) * DIMX);
+        scratch.horizontalDifference.resize((inputEnd - inputFirst) * DIMX);
+        for (size_t rowIdx = inputFirst; rowIdx < inputEnd; ++rowIdx)
+        {
+            float const * const row = current.row(static_cast<long>(rowIdx));
+            size_t const offset = (rowIdx - inputFirst) * DIMX;
+            smoothRow(row, scratch.horizontalSmooth.data() + offset, DIMX, 1.0F);
+            differenceRow(row, scratch.horizontalDifference.data() + offset, DIMX);
+        }
+
+        RowWindow const smooth{scratch.horizontalSmooth.data(), inputFirst, DIMX, DIMY};
+        RowWindow const difference{scratch.horizontalDifference.data(), inputFirst, DIMX, DIMY};
+        for (size_t rowIdx = firstRow; rowIdx < endRow; ++rowIdx)
+        {
+            auto const row = static_cast<long>(rowIdx);
+            gradientMagnitudeRow(difference.row(row - 1L), difference.row(row), difference.row(row + 1L),
+                                 smooth.row(row - 1L), smooth.row(row + 1L),
+                                 m_result.data() + rowIdx * DIMX, DIMX);
+        }
+    }
+}
+
+unsigned int PreprocessingPipeline::maxQuantizedValue(unsigned int const quantizationBits)
+{
+    return (1U << std::clamp(quantizationBits, 1U, 8U)) - 1U;
+}
+
+float PreprocessingPipeline::quantizationStep(unsigned int const quantizationBits)
+{
+    return 1.0F / static_cast<float>(1U << (8U - std::clamp(quantizationBits, 1U, 8U)));
+}
@@ -0,0 +1,79 @@
+#ifndef PREPROCESSINGPIPELINE_H
+#define PREPROCESSINGPIPELINE_H
+
+#include "threadpool.h"
+
+#include <cstddef>
+#include <vector>
+
+// Quantization, 3x3 Gaussian blur and Sobel gradient magnitudes of a row-major grid of DIMX * DIMY values,
+// fused into a single pass.
+// The grid is split into stripes of rows that fit in the cache. Each stripe runs all enabled filters back to back,
+// recomputing the one or two halo rows the 3x3 kernels need, so the intermediate results never leave the cache.
+// Both 3x3 kernels are separable and applied as a horizontal and a vertical 3-tap pass. Values outside the grid are
+// clamped to the nearest border value.
+// All scratch memory is kept between calls, so no allocations are made once the grid size is stable.
+class PreprocessingPipeline
+{
+public:
+    struct Settings
+    {
+        bool quantization = false;
+        unsigned int quantizationBits = 8U; // 'n': the values are mapped onto 2^n levels.
+        bool gaussianBlur = false;
+        bool gradients = false;
+    };
+
+private:
+    // Target size of the working set of one stripe, in bytes.
+    static constexpr size_t s_stripeBytes = 256U * 1024U;
+
+    // Intermediate rows of one stripe, per thread.
+    struct Scratch
+    {
+        std::vector<float> quantized;
+        std::vector<float> horizontalSmooth;
+        std::vector<float> horizontalDifference;
+        std::vector<float> blurred;
+    };
+
+    // Rows [firstRow, firstRow + numberOfRows) of an intermediate result.
+    struct RowWindow
+    {
+        float const *data = nullptr;
+        size_t firstRow = 0U;
+        size_t DIMX = 0U; // Values per row.
+        size_t DIMY = 0U; // Rows of the grid.
+
+        // Rows outside the grid are clamped to the border.
+        [[nodiscard]] float const *row(long const rowIdx) const;
+    };
+
+    std::vector<Scratch> m_scratch;
+    std::vector<float> m_threadMaxima;
+    std::vector<float> m_result;
+
+    [[nodiscard]] float maxValue(std::vector<float> const &values, ThreadPool &threadPool);
+
+    void processStripe(std::vector<float> const &values,
+                       size_t const DIMX,
+                       size_t const DIMY,
+                       Settings const &settings,
+                       size_t const firstRow,
+                       size_t const endRow,
+                       float const quantizationScale,
+                       float const quantizationStep,
+                       Scratch &scratch);
+
+public:
+    // Applies the enabled filters to values, in the order quantization, blur, gradients.
+    void apply(std::vector<float> &values, size_t const DIMX, size_t const DIMY, Settings const &settings,
+               ThreadPool &threadPool);
+
+    // L: the highest quantized value, 2^n - 1.
+    [[nodiscard]] static unsigned int maxQuantizedValue(unsigned int const quantizationBits);
+    // The factor 1 / 2^(8 - n) that maps the 256 levels of [0, 255] onto the 2^n quantization levels.
+    [[nodiscard]] static float quantizationStep(unsigned int const quantizationBits);
+};
+
+#endif // PREPROCESSINGPIPELINE_H
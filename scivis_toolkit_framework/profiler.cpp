@@ -0,0 +1,275 @@
+#include "profiler.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+Profiler::CpuScope::CpuScope(Profiler *const profiler, char const *const name, Thread const thread)
+    :
+      m_profiler(profiler != nullptr && profiler->isActive() ? profiler : nullptr),
+      m_name(name),
+      m_thread(thread)
+{
+    if (m_profiler != nullptr)
+        m_start = std::chrono::steady_clock::now();
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+    if (m_profiler == nullptr)
+        return;
+
+    long long const start = m_profiler->microseconds(m_start);
+    long long const end = m_profiler->microseconds(std::chrono::steady_clock::now());
+    m_profiler->addSample(m_name, m_thread, start, end - start);
+}
+
+Profiler::GpuScope::GpuScope(Profiler &profiler, char const *const name)
+    :
+      m_profiler(profiler.isActive() && profiler.m_gl != nullptr && !profiler.m_queryActive ? &profiler : nullptr)
+{
+    if (m_profiler != nullptr)
+        m_profiler->beginQuery(name);
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+    if (m_profiler != nullptr)
+        m_profiler->endQuery();
+}
+
+void Profiler::create(QOpenGLFunctions_3_3_Core *const gl)
+{
+    m_gl = gl;
+}
+
+void Profiler::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    for (PendingQuery const &pendingQuery : m_pendingQueries)
+        m_freeQueries.push_back(pendingQuery.query);
+    m_pendingQueries.clear();
+
+    m_gl->glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+    m_freeQueries.clear();
+    m_gl = nullptr;
+}
+
+void Profiler::beginFrame()
+{
+    collectQueries();
+
+    if (!m_enabled)
+        return;
+
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    size_t const slot = m_frame % s_historySize;
+    for (Stage &stage : m_stages)
+    {
+        stage.history[slot] = stage.current;
+        stage.current = 0.0F;
+    }
+    ++m_frame;
+}
+
+void Profiler::startTrace()
+{
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_traceEvents.clear();
+    }
+    m_tracing = true;
+}
+
+void Profiler::stopTrace()
+{
+    m_tracing = false;
+}
+
+// The Trace Event Format: complete ("X") events in microseconds, and one thread name ("M") event per thread.
+bool Profiler::saveTrace(QString const &fileName) const
+{
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        events = m_traceEvents;
+    }
+
+    std::ofstream file{fileName.toStdString()};
+    if (!file)
+    {
+        qCritical() << "Cannot write the trace" << fileName;
+        return false;
+    }
+
+    auto const threadId = [](Thread const thread) { return static_cast<int>(thread); };
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (auto const &[thread, name] : {std::pair{Thread::Gui, "GUI"}, std::pair{Thread::Simulation, "Simulation"},
+                                       std::pair{Thread::Gpu, "GPU"}})
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << threadId(thread)
+             << ", \"args\": {\"name\": \"" << name << "\"}},\n";
+
+    for (size_t idx = 0U; idx < events.size(); ++idx)
+    {
+        TraceEvent const &event = events[idx];
+        file << "{\"name\": \"" << event.name << "\", \"cat\": \"" << (event.thread == Thread::Gpu ? "gpu" : "cpu")
+             << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << threadId(event.thread)
+             << ", \"ts\": " << event.startMicroseconds << ", \"dur\": " << event.durationMicroseconds << '}'
+             << (idx + 1U < events.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+
+    if (!file)
+    {
+        qCritical() << "Cannot write the trace" << fileName;
+        return false;
+    }
+
+    qDebug() << "Wrote" << events.size() << "trace events to" << fileName;
+    return true;
+}
+
+bool Profiler::isActive() const
+{
+    return m_enabled || m_tracing;
+}
+
+long long Profiler::microseconds(std::chrono::steady_clock::time_point const time) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - m_epoch).count();
+}
+
+// The stages are few, so a linear search is fast enough. The caller has to hold the mutex.
+size_t Profiler::stageIndex(char const *const name, Thread const thread)
+{
+    auto const it = std::find_if(m_stages.cbegin(), m_stages.cend(), [name, thread](Stage const &stage)
+    {
+        return stage.thread == thread && std::strcmp(stage.name, name) == 0;
+    });
+    if (it != m_stages.cend())
+        return static_cast<size_t>(it - m_stages.cbegin());
+
+    m_stages.push_back({name, thread});
+    return m_stages.size() - 1U;
+}
+
+void Profiler::addSample(char const *const name, Thread const thread, long long const startMicroseconds,
+                         long long const durationMicroseconds)
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    addSample(stageIndex(name, thread), startMicroseconds, durationMicroseconds);
+}
+
+// The caller has to hold the mutex.
+void Profiler::addSample(size_t const stage, long long const startMicroseconds, long long const durationMicroseconds)
+{
+    m_stages[stage].current += static_cast<float>(durationMicroseconds) / 1000.0F;
+
+    if (m_tracing && m_traceEvents.size() < s_maximumTraceEvents)
+        m_traceEvents.push_back({m_stages[stage].name, m_stages[stage].thread, startMicroseconds,
+                                 durationMicroseconds});
+}
+
+void Profiler::beginQuery(char const *const name)
+{
+    GLuint query = 0U;
+    if (m_freeQueries.empty())
+        m_gl->glGenQueries(1, &query);
+    else
+    {
+        query = m_freeQueries.back();
+        m_freeQueries.pop_back();
+    }
+
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_activeQuery = {query, stageIndex(name, Thread::Gpu), microseconds(std::chrono::steady_clock::now())};
+    }
+    m_gl->glBeginQuery(GL_TIME_ELAPSED, query);
+    m_queryActive = true;
+}
+
+void Profiler::endQuery()
+{
+    m_gl->glEndQuery(GL_TIME_ELAPSED);
+    m_pendingQueries.push_back(m_activeQuery);
+    m_queryActive = false;
+}
+
+// Queries finish in the order they were issued, so the first one that is not available ends the search.
+void Profiler::collectQueries()
+{
+    size_t collected = 0U;
+    for (; collected < m_pendingQueries.size(); ++collected)
+    {
+        PendingQuery const &pendingQuery = m_pendingQueries[collected];
+
+        GLint available = GL_FALSE;
+        m_gl->glGetQueryObjectiv(pendingQuery.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 nanoseconds = 0U;
+        m_gl->glGetQueryObjectui64v(pendingQuery.query, GL_QUERY_RESULT, &nanoseconds);
+        {
+            std::lock_guard<std::mutex> const lock{m_mutex};
+            addSample(pendingQuery.stage, pendingQuery.startMicroseconds, static_cast<long long>(nanoseconds / 1000U));
+        }
+        m_freeQueries.push_back(pendingQuery.query);
+    }
+
+    m_pendingQueries.erase(m_pendingQueries.begin(),
+                           m_pendingQueries.begin() + static_cast<std::ptrdiff_t>(collected));
+}
+
+// Getters
+bool Profiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+bool Profiler::isTracing() const
+{
+    return m_tracing;
+}
+
+std::vector<Profiler::StageHistory> Profiler::history() const
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+
+    size_t const numberOfFrames = std::min(m_frame, s_historySize);
+    std::vector<StageHistory> histories;
+    histories.reserve(m_stages.size());
+    for (Stage const &stage : m_stages)
+    {
+        StageHistory history{stage.name, stage.thread, std::vector<float>(numberOfFrames)};
+        for (size_t frame = 0U; frame < numberOfFrames; ++frame)
+            history.milliseconds[frame] = stage.history[(m_frame - numberOfFrames + frame) % s_historySize];
+        histories.push_back(std::move(history));
+    }
+
+    return histories;
+}
+
+// Setters
+// Enabling starts the graph with an empty history.
+void Profiler::setEnabled(bool const enabled)
+{
+    if (enabled && !m_enabled)
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        for (Stage &stage : m_stages)
+        {
+            stage.history.fill(0.0F);
+            stage.current = 0.0F;
+        }
+        m_frame = 0U;
+    }
+
+    m_enabled = enabled;
+}
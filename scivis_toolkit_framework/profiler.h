@@ -0,0 +1,150 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Frame time per stage, for the profiling graph and for Chrome traces (chrome://tracing, ui.perfetto.dev).
+// CPU stages are timed by CpuScope, from any thread. GPU passes are timed by GpuScope with GL_TIME_ELAPSED queries.
+// GpuScopes must not be nested, since only one such query can be active at a time. The results of the queries are
+// read back in later frames, once they are available, so the GPU never has to finish a frame for the profiler. A GPU
+// sample is counted in the frame in which it arrives, and is placed in the trace at the CPU time its pass was issued.
+// While neither the graph nor a trace is running, the scopes only read two flags.
+//
+// beginFrame and the GpuScopes have to be called from the GUI thread with the context current.
+class Profiler
+{
+public:
+    enum class Thread
+    {
+        Gui,
+        Simulation,
+        Gpu
+    };
+
+    // The time of a stage in each of the last s_historySize frames, oldest first, in milliseconds.
+    struct StageHistory
+    {
+        std::string name;
+        Thread thread = Thread::Gui;
+        std::vector<float> milliseconds;
+    };
+
+    class CpuScope
+    {
+        Profiler *m_profiler;
+        char const *m_name;
+        Thread m_thread;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        // The name has to outlive the profiler, like a string literal. Does nothing if profiler is nullptr.
+        CpuScope(Profiler *const profiler, char const *const name, Thread const thread = Thread::Gui);
+        CpuScope(CpuScope const&) = delete;
+        CpuScope& operator=(CpuScope const&) = delete;
+        ~CpuScope();
+    };
+
+    class GpuScope
+    {
+        Profiler *m_profiler;
+
+    public:
+        // The name has to outlive the profiler, like a string literal.
+        GpuScope(Profiler &profiler, char const *const name);
+        GpuScope(GpuScope const&) = delete;
+        GpuScope& operator=(GpuScope const&) = delete;
+        ~GpuScope();
+    };
+
+    static constexpr size_t s_historySize = 240U;          // Frames in the graph, 4 seconds at 60 frames per second.
+    static constexpr size_t s_maximumTraceEvents = 1000000U; // Events beyond this are dropped, to bound the memory.
+
+private:
+    struct Stage
+    {
+        char const *name;
+        Thread thread;
+        std::array<float, s_historySize> history{};
+        float current = 0.0F; // Accumulated time of the current frame.
+    };
+
+    struct TraceEvent
+    {
+        char const *name;
+        Thread thread;
+        long long startMicroseconds;
+        long long durationMicroseconds;
+    };
+
+    struct PendingQuery
+    {
+        GLuint query;
+        size_t stage;
+        long long startMicroseconds;
+    };
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    std::atomic<bool> m_enabled{false}; // Collects the history for the graph.
+    std::atomic<bool> m_tracing{false};
+    std::chrono::steady_clock::time_point const m_epoch = std::chrono::steady_clock::now();
+
+    // Guards the stages, the frame counter and the trace events, which the simulation thread also writes.
+    mutable std::mutex m_mutex;
+    std::vector<Stage> m_stages;
+    size_t m_frame = 0U; // Number of completed frames, the next history slot is m_frame % s_historySize.
+    std::vector<TraceEvent> m_traceEvents;
+
+    // Only touched by the GUI thread.
+    std::vector<GLuint> m_freeQueries;
+    std::vector<PendingQuery> m_pendingQueries;
+    PendingQuery m_activeQuery{};
+    bool m_queryActive = false;
+
+    [[nodiscard]] bool isActive() const;
+    [[nodiscard]] long long microseconds(std::chrono::steady_clock::time_point const time) const;
+    [[nodiscard]] size_t stageIndex(char const *const name, Thread const thread);
+    void addSample(char const *const name, Thread const thread, long long const startMicroseconds,
+                   long long const durationMicroseconds);
+    void addSample(size_t const stage, long long const startMicroseconds, long long const durationMicroseconds);
+
+    void beginQuery(char const *const name);
+    void endQuery();
+    void collectQueries();
+
+public:
+    Profiler() = default;
+    Profiler(Profiler const&) = delete;
+    Profiler& operator=(Profiler const&) = delete;
+
+    // Have to be called with the context current: create before the first GpuScope, destroy before the context goes.
+    void create(QOpenGLFunctions_3_3_Core *const gl);
+    void destroy();
+
+    // Closes the previous frame: its times move into the history, and the finished queries are collected.
+    void beginFrame();
+
+    // Starts collecting trace events, dropping those of an earlier trace.
+    void startTrace();
+    void stopTrace();
+    // Writes the events of the last trace to fileName. Returns false, after logging why, if it cannot.
+    bool saveTrace(QString const &fileName) const;
+
+    // Getters
+    [[nodiscard]] bool isEnabled() const;
+    [[nodiscard]] bool isTracing() const;
+    [[nodiscard]] std::vector<StageHistory> history() const;
+
+    // Setters
+    void setEnabled(bool const enabled);
+};
+
+#endif // PROFILER_H
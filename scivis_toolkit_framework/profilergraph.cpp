@@ -0,0 +1,90 @@
+#include "profilergraph.h"
+
+#include <QColor>
+#include <QPainter>
+#include <QPen>
+#include <QPolygonF>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+ProfilerGraph::ProfilerGraph(QWidget *parent) : QWidget(parent)
+{
+    using namespace std::chrono_literals;
+
+    m_timer.start(100ms);
+    connect(&m_timer, &QTimer::timeout, this, [this]
+    {
+        if (m_profiler != nullptr && m_profiler->isEnabled() && isVisible())
+            update();
+    });
+}
+
+void ProfilerGraph::setProfiler(Profiler const *const profiler)
+{
+    m_profiler = profiler;
+    update();
+}
+
+void ProfilerGraph::paintEvent(QPaintEvent *)
+{
+    QPainter painter{this};
+    painter.fillRect(rect(), Qt::black);
+
+    if (m_profiler == nullptr || !m_profiler->isEnabled())
+    {
+        painter.setPen(Qt::gray);
+        painter.drawText(rect(), Qt::AlignCenter, tr("Profiling is off"));
+        return;
+    }
+
+    std::vector<Profiler::StageHistory> const histories = m_profiler->history();
+
+    float maximum = 0.0F;
+    for (Profiler::StageHistory const &history : histories)
+        for (float const milliseconds : history.milliseconds)
+            maximum = std::max(maximum, milliseconds);
+
+    // The smallest scale of the form {1, 2, 5} * 10^n ms that holds the maximum.
+    float scale = 1.0F;
+    for (float decade = 1.0F; scale < maximum; decade *= 10.0F)
+        for (float const step : {1.0F, 2.0F, 5.0F, 10.0F})
+            if (scale < maximum)
+                scale = step * decade;
+
+    QRectF const plot = QRectF{rect()}.adjusted(4.0, 4.0, -4.0, -4.0);
+    painter.setPen(Qt::darkGray);
+    painter.drawLine(plot.topLeft(), plot.topRight());
+    painter.drawText(plot, Qt::AlignRight | Qt::AlignTop, QString::number(static_cast<double>(scale)) + " ms");
+
+    static std::array<QColor, 8U> const colors{QColor{230, 25, 75}, QColor{60, 180, 75}, QColor{255, 225, 25},
+                                               QColor{0, 130, 200}, QColor{245, 130, 48}, QColor{145, 30, 180},
+                                               QColor{70, 240, 240}, QColor{240, 50, 230}};
+
+    double const dx = plot.width() / static_cast<double>(Profiler::s_historySize - 1U);
+    double const lineHeight = painter.fontMetrics().height();
+    for (size_t stage = 0U; stage < histories.size(); ++stage)
+    {
+        Profiler::StageHistory const &history = histories[stage];
+
+        QPen pen{colors[stage % colors.size()]};
+        if (history.thread == Profiler::Thread::Gpu)
+            pen.setStyle(Qt::DashLine);
+        painter.setPen(pen);
+
+        // The newest frame is at the right border.
+        QPolygonF line;
+        double const firstX = plot.right() - dx * static_cast<double>(history.milliseconds.size());
+        for (size_t frame = 0U; frame < history.milliseconds.size(); ++frame)
+            line << QPointF{firstX + dx * static_cast<double>(frame + 1U),
+                            plot.bottom() - plot.height() * static_cast<double>(history.milliseconds[frame] / scale)};
+        painter.drawPolyline(line);
+
+        float const latest = history.milliseconds.empty() ? 0.0F : history.milliseconds.back();
+        QString const prefix = history.thread == Profiler::Thread::Gpu ? "GPU " : "";
+        painter.drawText(QPointF{plot.left() + 2.0, plot.top() + lineHeight * static_cast<double>(stage + 1U)},
+                         prefix + QString::fromStdString(history.name) + ": " +
+                         QString::number(static_cast<double>(latest), 'f', 2) + " ms");
+    }
+}
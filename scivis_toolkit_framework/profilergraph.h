@@ -0,0 +1,28 @@
+#ifndef PROFILERGRAPH_H
+#define PROFILERGRAPH_H
+
+#include "profiler.h"
+
+#include <QTimer>
+#include <QWidget>
+
+// Rolling graph of the stage times of a Profiler: one line per stage over the last Profiler::s_historySize frames,
+// with the latest time of every stage in the legend. GPU stages are drawn dashed. The vertical scale grows to the
+// largest time shown, in steps of 1, 2 and 5 ms.
+class ProfilerGraph : public QWidget
+{
+    Q_OBJECT
+
+    Profiler const *m_profiler = nullptr;
+    QTimer m_timer; // Repaints while the profiler is enabled.
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+public:
+    explicit ProfilerGraph(QWidget *parent = nullptr);
+
+    void setProfiler(Profiler const *const profiler);
+};
+
+#endif // PROFILERGRAPH_H
@@ -0,0 +1,44 @@
+#include "rendergraph.h"
+
+#include <algorithm>
+#include <utility>
+
+void RenderGraph::setPreparation(Resource const resource, std::function<void()> preparation)
+{
+    m_preparations[static_cast<size_t>(resource)] = std::move(preparation);
+}
+
+void RenderGraph::addPass(Pass pass)
+{
+    m_passes.push_back(std::move(pass));
+}
+
+void RenderGraph::execute(Profiler &profiler)
+{
+    std::array<bool, s_numberOfResources> isRead{};
+    for (Pass const &pass : m_passes)
+        for (Resource const resource : pass.reads)
+            isRead[static_cast<size_t>(resource)] = true;
+
+    if (std::find(isRead.cbegin(), isRead.cend(), true) != isRead.cend())
+    {
+        Profiler::GpuScope const gpuScope{profiler, "uploads"};
+        for (size_t resource = 0U; resource < s_numberOfResources; ++resource)
+            if (isRead[resource] && m_preparations[resource])
+                m_preparations[resource]();
+    }
+
+    // Stable, so the overlays keep the order in which they were added.
+    std::stable_sort(m_passes.begin(), m_passes.end(), [](Pass const &lhs, Pass const &rhs)
+    {
+        return lhs.layer < rhs.layer;
+    });
+
+    for (Pass const &pass : m_passes)
+    {
+        Profiler::GpuScope const gpuScope{profiler, pass.name};
+        pass.draw();
+    }
+
+    m_passes.clear();
+}
@@ -0,0 +1,55 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include "profiler.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// The passes of one frame and the GPU resources each of them reads. Before the first pass, every resource that any
+// pass reads is prepared once, in the order of Resource, so a field shared by several passes is uploaded a single time
+// and all uploads of the frame are done together. The passes are then drawn layer by layer: the base layer fills the
+// screen, the overlays are composited over it in the order they were added.
+class RenderGraph
+{
+public:
+    enum class Resource
+    {
+        ScalarFieldTexture,      // The unpreprocessed current scalar field.
+        PreprocessedScalarField, // The current scalar field filtered by the GPU preprocessing passes.
+        HeightFieldTexture,      // The heights of the height plot.
+        LicVelocityField         // The velocities advected by the LIC.
+    };
+    static constexpr size_t s_numberOfResources = 4U;
+
+    enum class Layer
+    {
+        Base,
+        Overlay
+    };
+
+    struct Pass
+    {
+        char const *name; // Also the name of its GPU stage in the profiler.
+        Layer layer;
+        std::vector<Resource> reads;
+        std::function<void()> draw;
+    };
+
+private:
+    std::array<std::function<void()>, s_numberOfResources> m_preparations;
+    std::vector<Pass> m_passes;
+
+public:
+    // The preparation has to leave the resource current for the frame. It is only run for frames that read it.
+    void setPreparation(Resource const resource, std::function<void()> preparation);
+
+    void addPass(Pass pass);
+
+    // Prepares the resources, draws the passes and removes them, so the next frame is built from scratch.
+    void execute(Profiler &profiler);
+};
+
+#endif // RENDERGRAPH_H
@@ -0,0 +1,76 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool Resampler::setShape(size_t const inputWidth, size_t const inputHeight, size_t const xMax, size_t const yMax)
+{
+    if (inputWidth == m_inputWidth && inputHeight == m_inputHeight && xMax == m_xMax && yMax == m_yMax)
+        return false;
+
+    m_inputWidth = inputWidth;
+    m_inputHeight = inputHeight;
+    m_xMax = xMax;
+    m_yMax = yMax;
+
+    m_columnTaps = computeTaps(inputWidth, xMax, 1U);
+    m_rowTaps = computeTaps(inputHeight, yMax, inputWidth);
+    return true;
+}
+
+bool Resampler::setShape(size_t const sideSize, size_t const xMax, size_t const yMax)
+{
+    return setShape(sideSize, sideSize, xMax, yMax);
+}
+
+// Output sample i is located at i * (inputSize - 1) / (outputSize - 1) in input coordinates.
+// A single output sample is placed in the center of the input.
+std::vector<Resampler::Tap> Resampler::computeTaps(size_t const inputSize, size_t const outputSize, size_t const stride)
+{
+    std::vector<Tap> taps(outputSize);
+    if (inputSize == 0U)
+        return taps;
+
+    float const lastInputIdx = static_cast<float>(inputSize - 1U);
+    float const scale = outputSize > 1U ? lastInputIdx / static_cast<float>(outputSize - 1U) : 0.0F;
+    float const offset = outputSize > 1U ? 0.0F : 0.5F * lastInputIdx;
+
+    for (size_t i = 0U; i < outputSize; ++i)
+    {
+        float const position = std::clamp(offset + scale * static_cast<float>(i), 0.0F, lastInputIdx);
+        size_t const index0 = std::min(static_cast<size_t>(std::floor(position)), inputSize - 1U);
+        size_t const index1 = std::min(index0 + 1U, inputSize - 1U);
+
+        taps[i].index0 = index0 * stride;
+        taps[i].index1 = index1 * stride;
+        taps[i].weight = position - static_cast<float>(index0);
+    }
+
+    return taps;
+}
+
+// Getters
+size_t Resampler::inputWidth() const
+{
+    return m_inputWidth;
+}
+
+size_t Resampler::inputHeight() const
+{
+    return m_inputHeight;
+}
+
+size_t Resampler::xMax() const
+{
+    return m_xMax;
+}
+
+size_t Resampler::yMax() const
+{
+    return m_yMax;
+}
+
+void Resampler::resample(float const * const values, std::vector<float> &result) const
+{
+    resample<1U>({values}, {&result});
+}
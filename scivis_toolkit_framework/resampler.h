@@ -0,0 +1,81 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Bilinear resampling of a row-major grid of inputWidth * inputHeight values to xMax * yMax values.
+// The first and last output rows/columns coincide with the first and last input rows/columns.
+// The index and weight tables only depend on the shape, so they are computed once in setShape and then reused for
+// every field (and every frame) of that shape.
+class Resampler
+{
+    struct Tap
+    {
+        size_t index0 = 0U;  // First input sample (a column index, or the offset of a row).
+        size_t index1 = 0U;  // Second input sample.
+        float weight = 0.0F; // Weight of the second sample; the first one has weight 1 - weight.
+    };
+
+    size_t m_inputWidth = 0U;
+    size_t m_inputHeight = 0U;
+    size_t m_xMax = 0U;
+    size_t m_yMax = 0U;
+
+    std::vector<Tap> m_columnTaps; // xMax entries, holding input column indices.
+    std::vector<Tap> m_rowTaps;    // yMax entries, holding input row offsets (row index * inputWidth).
+
+    static std::vector<Tap> computeTaps(size_t const inputSize, size_t const outputSize, size_t const stride);
+
+public:
+    // Returns whether the tables were recomputed.
+    bool setShape(size_t const inputWidth, size_t const inputHeight, size_t const xMax, size_t const yMax);
+    // A square input of sideSize * sideSize values.
+    bool setShape(size_t const sideSize, size_t const xMax, size_t const yMax);
+
+    // Getters
+    [[nodiscard]] size_t inputWidth() const;
+    [[nodiscard]] size_t inputHeight() const;
+    [[nodiscard]] size_t xMax() const;
+    [[nodiscard]] size_t yMax() const;
+
+    void resample(float const * const values, std::vector<float> &result) const;
+
+    // Resamples several fields of the same shape in one pass, so that the tables are read only once.
+    template <size_t NumberOfChannels>
+    void resample(std::array<float const*, NumberOfChannels> const &values,
+                  std::array<std::vector<float>*, NumberOfChannels> const &results) const;
+};
+
+template <size_t NumberOfChannels>
+void Resampler::resample(std::array<float const*, NumberOfChannels> const &values,
+                         std::array<std::vector<float>*, NumberOfChannels> const &results) const
+{
+    for (std::vector<float> * const result : results)
+        result->resize(m_xMax * m_yMax);
+
+    size_t outputIdx = 0U;
+    for (Tap const &rowTap : m_rowTaps)
+    {
+        for (Tap const &columnTap : m_columnTaps)
+        {
+            size_t const idx00 = rowTap.index0 + columnTap.index0;
+            size_t const idx01 = rowTap.index0 + columnTap.index1;
+            size_t const idx10 = rowTap.index1 + columnTap.index0;
+            size_t const idx11 = rowTap.index1 + columnTap.index1;
+
+            for (size_t channel = 0U; channel < NumberOfChannels; ++channel)
+            {
+                float const * const channelValues = values[channel];
+                float const bottom = channelValues[idx00] + columnTap.weight * (channelValues[idx01] - channelValues[idx00]);
+                float const top = channelValues[idx10] + columnTap.weight * (channelValues[idx11] - channelValues[idx10]);
+                (*results[channel])[outputIdx] = bottom + rowTap.weight * (top - bottom);
+            }
+
+            ++outputIdx;
+        }
+    }
+}
+
+#endif // RESAMPLER_H
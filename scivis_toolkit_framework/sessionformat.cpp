@@ -0,0 +1,59 @@
+#include "sessionformat.h"
+
+#include <cstring>
+
+namespace
+{
+    constexpr size_t s_bytesPerValue = sizeof(std::uint32_t);
+
+    std::uint32_t bitsOf(float const value)
+    {
+        std::uint32_t bits = 0U;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+QByteArray sessionformat::compressFields(std::vector<float> const &fields, std::vector<float> const &reference)
+{
+    bool const isDelta = !reference.empty();
+    size_t const size = fields.size();
+
+    QByteArray planes(static_cast<qsizetype>(size * s_bytesPerValue), Qt::Uninitialized);
+    auto * const bytes = reinterpret_cast<unsigned char*>(planes.data());
+    for (size_t idx = 0U; idx < size; ++idx)
+    {
+        std::uint32_t const bits = isDelta ? bitsOf(fields[idx]) ^ bitsOf(reference[idx]) : bitsOf(fields[idx]);
+        for (size_t plane = 0U; plane < s_bytesPerValue; ++plane)
+            bytes[plane * size + idx] = static_cast<unsigned char>(bits >> (8U * plane));
+    }
+
+    return qCompress(planes);
+}
+
+bool sessionformat::decompressFields(QByteArray const &data, size_t const size, std::vector<float> const &reference,
+                                     std::vector<float> &fields)
+{
+    bool const isDelta = !reference.empty();
+    if (isDelta && reference.size() != size)
+        return false;
+
+    QByteArray const planes = qUncompress(data);
+    if (static_cast<size_t>(planes.size()) != size * s_bytesPerValue)
+        return false;
+
+    auto const * const bytes = reinterpret_cast<unsigned char const*>(planes.constData());
+    fields.resize(size);
+    for (size_t idx = 0U; idx < size; ++idx)
+    {
+        std::uint32_t bits = 0U;
+        for (size_t plane = 0U; plane < s_bytesPerValue; ++plane)
+            bits |= static_cast<std::uint32_t>(bytes[plane * size + idx]) << (8U * plane);
+        if (isDelta)
+            bits ^= bitsOf(reference[idx]);
+
+        std::memcpy(&fields[idx], &bits, sizeof(bits));
+    }
+
+    return true;
+}
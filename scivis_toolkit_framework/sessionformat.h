@@ -0,0 +1,57 @@
+#ifndef SESSIONFORMAT_H
+#define SESSIONFORMAT_H
+
+#include <QByteArray>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The file format of a session recording, written by SessionRecorder and read by SessionPlayer.
+// After the magic string, the file is a sequence of records, each starting with its RecordType:
+//     Event:    step, type, idx, DIMY (u64, u8, u64, u64), x, y (f32)
+//     Keyframe: step, firstEvent, DIMX, DIMY (u64), dt, viscosity, rhoInjected (f32), forceRowBegin, forceRowEnd (u64),
+//               isDelta (u8), size (u64), followed by size bytes of compressed fields
+// in the byte order of the recording machine. An event is the input the simulation received before the step after
+// step. A keyframe is the state before that step, taken after the first firstEvent events.
+// The fields of a keyframe are rho, vx, vy, fx and fy, one after another. Their bits are XOR'ed with those of the
+// previous keyframe when isDelta is set, which zeroes the bits of values that barely changed, then split into byte
+// planes, so the sign and exponent bytes follow each other, and compressed with zlib.
+namespace sessionformat
+{
+    constexpr char s_magic[8] = {'S', 'V', 'S', 'E', 'S', 'S', '0', '1'};
+
+    enum class RecordType : std::uint8_t
+    {
+        Event,
+        Keyframe
+    };
+
+    struct Event
+    {
+        enum class Type : std::uint8_t
+        {
+            AddForce,       // Adds the force (x, y) at sample idx.
+            InjectDensity,  // Sets the density of sample idx to the injected density.
+            SetDt,          // x is the time step.
+            SetViscosity,   // x is the viscosity.
+            SetRhoInjected, // x is the injected density.
+            SetDIM          // Resizes the grid to idx * DIMY, which clears all fields.
+        };
+
+        size_t step = 0U;
+        Type type = Type::AddForce;
+        size_t idx = 0U;
+        size_t DIMY = 0U;
+        float x = 0.0F;
+        float y = 0.0F;
+    };
+
+    // Delta against reference, if it is not empty, which has to have the size of fields.
+    [[nodiscard]] QByteArray compressFields(std::vector<float> const &fields, std::vector<float> const &reference);
+    // Returns false if the data is corrupt or does not hold size values.
+    bool decompressFields(QByteArray const &data, size_t const size, std::vector<float> const &reference,
+                          std::vector<float> &fields);
+}
+
+#endif // SESSIONFORMAT_H
@@ -0,0 +1,296 @@
+#include "sessionplayer.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    // Reads the values of a record from the loaded file, failing once the file ends.
+    class RecordReader
+    {
+        std::vector<char> const &m_bytes;
+        size_t m_position = 0U;
+        bool m_failed = false;
+
+    public:
+        RecordReader(std::vector<char> const &bytes, size_t const position)
+            : m_bytes(bytes), m_position(position)
+        {}
+
+        template <typename T>
+        T value()
+        {
+            T result{};
+            if (m_failed || m_bytes.size() - m_position < sizeof(T))
+            {
+                m_failed = true;
+                return result;
+            }
+
+            std::memcpy(&result, m_bytes.data() + m_position, sizeof(T));
+            m_position += sizeof(T);
+            return result;
+        }
+
+        size_t size()
+        {
+            return static_cast<size_t>(value<std::uint64_t>());
+        }
+
+        QByteArray bytes(size_t const count)
+        {
+            if (m_failed || m_bytes.size() - m_position < count)
+            {
+                m_failed = true;
+                return {};
+            }
+
+            QByteArray result(m_bytes.data() + m_position, static_cast<qsizetype>(count));
+            m_position += count;
+            return result;
+        }
+
+        [[nodiscard]] bool atEnd() const
+        {
+            return m_position == m_bytes.size();
+        }
+
+        [[nodiscard]] bool failed() const
+        {
+            return m_failed;
+        }
+
+        [[nodiscard]] size_t position() const
+        {
+            return m_position;
+        }
+    };
+
+    void extractField(std::vector<float> const &fields, size_t const index, size_t const size,
+                      std::vector<float> &field)
+    {
+        auto const begin = fields.cbegin() + static_cast<std::ptrdiff_t>(index * size);
+        field.assign(begin, begin + static_cast<std::ptrdiff_t>(size));
+    }
+}
+
+bool SessionPlayer::load(QString const &fileName)
+{
+    m_events.clear();
+    m_keyframes.clear();
+
+    std::ifstream file{fileName.toStdString(), std::ios::binary};
+    std::vector<char> const bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    if (!file.is_open() || bytes.size() < sizeof(sessionformat::s_magic) ||
+        std::memcmp(bytes.data(), sessionformat::s_magic, sizeof(sessionformat::s_magic)) != 0)
+    {
+        qCritical() << "Cannot read the session recording" << fileName;
+        return false;
+    }
+
+    RecordReader reader{bytes, sizeof(sessionformat::s_magic)};
+    while (!reader.atEnd())
+    {
+        auto const type = static_cast<sessionformat::RecordType>(reader.value<std::uint8_t>());
+        if (type == sessionformat::RecordType::Event)
+        {
+            sessionformat::Event event;
+            event.step = reader.size();
+            event.type = static_cast<sessionformat::Event::Type>(reader.value<std::uint8_t>());
+            event.idx = reader.size();
+            event.DIMY = reader.size();
+            event.x = reader.value<float>();
+            event.y = reader.value<float>();
+            if (reader.failed())
+                break;
+
+            m_events.push_back(event);
+        }
+        else if (type == sessionformat::RecordType::Keyframe)
+        {
+            Keyframe keyframe;
+            keyframe.step = reader.size();
+            keyframe.firstEvent = reader.size();
+            keyframe.state.DIMX = reader.size();
+            keyframe.state.DIMY = reader.size();
+            keyframe.state.dt = reader.value<float>();
+            keyframe.state.viscosity = reader.value<float>();
+            keyframe.state.rhoInjected = reader.value<float>();
+            keyframe.state.forceRowBegin = reader.size();
+            keyframe.state.forceRowEnd = reader.size();
+            keyframe.isDelta = reader.value<std::uint8_t>() != 0U;
+            keyframe.data = reader.bytes(reader.size());
+            if (reader.failed())
+                break;
+
+            // The first keyframe is an intra one, unless the file is corrupt.
+            if (m_keyframes.empty() && keyframe.isDelta)
+                break;
+
+            m_keyframes.push_back(std::move(keyframe));
+        }
+        else
+            break;
+    }
+
+    if (!reader.atEnd())
+        qDebug() << "Warning: the session recording" << fileName << "ends in an incomplete record at byte"
+                 << reader.position();
+
+    if (m_keyframes.empty())
+    {
+        qCritical() << "The session recording" << fileName << "holds no keyframe";
+        m_events.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool SessionPlayer::isLoaded() const
+{
+    return !m_keyframes.empty();
+}
+
+size_t SessionPlayer::firstStep() const
+{
+    return m_keyframes.empty() ? 0U : m_keyframes.front().step;
+}
+
+size_t SessionPlayer::lastStep() const
+{
+    size_t step = m_keyframes.empty() ? 0U : m_keyframes.back().step;
+    if (!m_events.empty())
+        step = std::max(step, m_events.back().step);
+
+    return step;
+}
+
+std::pair<size_t, size_t> SessionPlayer::DIMAt(size_t const step) const
+{
+    if (m_keyframes.empty())
+        return {0U, 0U};
+
+    Keyframe const &keyframe = m_keyframes[keyframeAt(step)];
+    std::pair<size_t, size_t> DIM{keyframe.state.DIMX, keyframe.state.DIMY};
+    for (size_t event = keyframe.firstEvent; event < m_events.size() && m_events[event].step < step; ++event)
+        if (m_events[event].type == sessionformat::Event::Type::SetDIM)
+            DIM = {m_events[event].idx, m_events[event].DIMY};
+
+    return DIM;
+}
+
+size_t SessionPlayer::keyframeAt(size_t const step) const
+{
+    auto const after = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), step,
+                                        [](size_t const value, Keyframe const &keyframe)
+                                        { return value < keyframe.step; });
+    return after == m_keyframes.cbegin() ? 0U : static_cast<size_t>(after - m_keyframes.cbegin()) - 1U;
+}
+
+// A delta keyframe is decoded on top of the previous one, back to the last intra keyframe.
+bool SessionPlayer::decodeKeyframe(size_t const keyframe, Simulation::State &state) const
+{
+    size_t first = keyframe;
+    while (first > 0U && m_keyframes[first].isDelta)
+        --first;
+
+    std::vector<float> const noReference;
+    std::vector<float> fields;
+    std::vector<float> reference;
+    for (size_t idx = first; idx <= keyframe; ++idx)
+    {
+        Simulation::State const &header = m_keyframes[idx].state;
+        if (!sessionformat::decompressFields(m_keyframes[idx].data, 5U * header.DIMX * header.DIMY,
+                                             m_keyframes[idx].isDelta ? reference : noReference, fields))
+        {
+            qCritical() << "Cannot decode the keyframe of step" << m_keyframes[idx].step << "of the session recording";
+            return false;
+        }
+        reference.swap(fields);
+    }
+
+    state = m_keyframes[keyframe].state;
+    size_t const size = state.DIMX * state.DIMY;
+    extractField(reference, 0U, size, state.rho);
+    extractField(reference, 1U, size, state.vx);
+    extractField(reference, 2U, size, state.vy);
+    extractField(reference, 3U, size, state.fx);
+    extractField(reference, 4U, size, state.fy);
+    return true;
+}
+
+bool SessionPlayer::seek(size_t &step, Simulation &simulation, size_t &nextEvent) const
+{
+    if (m_keyframes.empty())
+        return false;
+
+    step = std::clamp(step, firstStep(), lastStep());
+    size_t const keyframe = keyframeAt(step);
+
+    Simulation::State state;
+    if (!decodeKeyframe(keyframe, state))
+        return false;
+
+    simulation.setState(state);
+    nextEvent = m_keyframes[keyframe].firstEvent;
+    for (size_t current = m_keyframes[keyframe].step; current < step; ++current)
+    {
+        applyEvents(current, simulation, nextEvent, true);
+        simulation.doOneSimulationStep();
+    }
+
+    return true;
+}
+
+bool SessionPlayer::applyEvents(size_t const step, Simulation &simulation, size_t &nextEvent,
+                                bool const applyDIMChanges) const
+{
+    for (; nextEvent < m_events.size() && m_events[nextEvent].step <= step; ++nextEvent)
+    {
+        sessionformat::Event const &event = m_events[nextEvent];
+        bool const inGrid = event.idx < simulation.DIMX() * simulation.DIMY();
+        switch (event.type)
+        {
+            case sessionformat::Event::Type::AddForce:
+                if (inGrid)
+                {
+                    simulation.setFx(event.idx, simulation.fx(event.idx) + event.x);
+                    simulation.setFy(event.idx, simulation.fy(event.idx) + event.y);
+                }
+            break;
+
+            case sessionformat::Event::Type::InjectDensity:
+                if (inGrid)
+                    simulation.setRho(event.idx, simulation.rhoInjected());
+            break;
+
+            case sessionformat::Event::Type::SetDt:
+                simulation.setDt(event.x);
+            break;
+
+            case sessionformat::Event::Type::SetViscosity:
+                simulation.setViscosity(event.x);
+            break;
+
+            case sessionformat::Event::Type::SetRhoInjected:
+                simulation.setRhoInjected(event.x);
+            break;
+
+            case sessionformat::Event::Type::SetDIM:
+                if (!applyDIMChanges)
+                    return false;
+
+                if (event.idx > 0U && event.DIMY > 0U)
+                    simulation.setDIM(event.idx, event.DIMY);
+            break;
+        }
+    }
+
+    return true;
+}
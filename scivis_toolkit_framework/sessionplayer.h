@@ -0,0 +1,58 @@
+#ifndef SESSIONPLAYER_H
+#define SESSIONPLAYER_H
+
+#include "sessionformat.h"
+#include "simulation.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Replays a session recorded by SessionRecorder. The recording is loaded into memory as it is stored, compressed; only
+// the keyframes needed by a seek are decoded.
+// Seeking restores the nearest keyframe at or before the step and re-simulates the steps from there, applying the
+// recorded events, so it takes at most one keyframe interval of steps.
+class SessionPlayer
+{
+    struct Keyframe
+    {
+        size_t step = 0U;
+        size_t firstEvent = 0U;
+        Simulation::State state; // Without its fields, which are decoded from data when needed.
+        bool isDelta = false;
+        QByteArray data;
+    };
+
+    std::vector<sessionformat::Event> m_events;
+    std::vector<Keyframe> m_keyframes;
+
+    // The index of the last keyframe at or before step, or of the first one if there is none.
+    [[nodiscard]] size_t keyframeAt(size_t const step) const;
+    bool decodeKeyframe(size_t const keyframe, Simulation::State &state) const;
+
+public:
+    // Reads the recording in fileName, replacing the loaded one. Returns false, after logging why, if it cannot be
+    // read. A recording cut off in the middle of a record is loaded up to the last complete one.
+    bool load(QString const &fileName);
+
+    [[nodiscard]] bool isLoaded() const;
+    // The steps a seek can reach: from the first keyframe up to the last recorded event or keyframe.
+    [[nodiscard]] size_t firstStep() const;
+    [[nodiscard]] size_t lastStep() const;
+    // DIMX and DIMY of the grid at step.
+    [[nodiscard]] std::pair<size_t, size_t> DIMAt(size_t const step) const;
+
+    // Restores the state after step, which is clamped to the recorded steps first, into simulation and sets nextEvent
+    // to the first event after it. Returns false, after logging why, if the keyframe cannot be decoded, leaving the
+    // simulation unchanged.
+    bool seek(size_t &step, Simulation &simulation, size_t &nextEvent) const;
+
+    // Applies the events the simulation received before the step after step, starting from nextEvent, and advances
+    // nextEvent past them. Stops before a grid change unless applyDIMChanges is set, returning false.
+    bool applyEvents(size_t const step, Simulation &simulation, size_t &nextEvent, bool const applyDIMChanges) const;
+};
+
+#endif // SESSIONPLAYER_H
@@ -0,0 +1,248 @@
+#include "sessionrecorder.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace
+{
+    template <typename T>
+    void writeValue(std::ofstream &file, T const value)
+    {
+        file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+    }
+
+    void writeSize(std::ofstream &file, size_t const value)
+    {
+        writeValue(file, static_cast<std::uint64_t>(value));
+    }
+
+    void appendField(std::vector<float> &fields, std::vector<float> const &field)
+    {
+        fields.insert(fields.end(), field.cbegin(), field.cend());
+    }
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+bool SessionRecorder::open(QString const &fileName, size_t const keyframeInterval)
+{
+    close();
+
+    m_file.open(fileName.toStdString(), std::ios::binary | std::ios::trunc);
+    m_file.write(sessionformat::s_magic, sizeof(sessionformat::s_magic));
+    if (!m_file)
+    {
+        qCritical() << "Cannot create the session recording" << fileName;
+        m_file.close();
+        return false;
+    }
+
+    m_fileName = fileName;
+    m_keyframeInterval = std::max<size_t>(keyframeInterval, 1U);
+    m_numberOfEvents = 0U;
+    m_keyframeDue = false;
+    m_reference.clear();
+    m_keyframesSinceIntra = 0U;
+    m_rawBytes = 0U;
+    m_compressedBytes = 0U;
+    m_failed = false;
+    m_writtenKeyframes = 0U;
+
+    // Both queues are empty after a close, so every buffer is free.
+    for (size_t slot = 0U; slot < s_bufferCount; ++slot)
+        m_freeKeyframes.push(slot);
+
+    m_stopRequested = false;
+    m_thread = std::thread{&SessionRecorder::run, this};
+    return true;
+}
+
+void SessionRecorder::close()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_stopRequested = true;
+    m_thread.join();
+    m_file.close();
+
+    size_t slot = 0U;
+    while (m_freeKeyframes.pop(slot))
+        ;
+
+    qDebug() << "Recorded" << m_numberOfEvents << "events and" << m_writtenKeyframes.load() << "keyframes into"
+             << m_fileName << ", compressed from" << m_rawBytes << "to" << m_compressedBytes << "bytes";
+}
+
+void SessionRecorder::run()
+{
+    while (true)
+    {
+        // Read the flag before looking at the queue, so the records pushed before the stop are still written.
+        bool const stopping = m_stopRequested;
+
+        Record record;
+        if (m_records.pop(record))
+        {
+            write(record);
+            continue;
+        }
+
+        if (stopping)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    m_file.flush();
+}
+
+void SessionRecorder::write(Record const &record)
+{
+    if (record.type == sessionformat::RecordType::Keyframe)
+    {
+        writeKeyframe(m_keyframes[record.slot]);
+        m_freeKeyframes.push(record.slot);
+        return;
+    }
+
+    if (m_failed)
+        return;
+
+    sessionformat::Event const &event = record.event;
+    writeValue(m_file, static_cast<std::uint8_t>(sessionformat::RecordType::Event));
+    writeSize(m_file, event.step);
+    writeValue(m_file, static_cast<std::uint8_t>(event.type));
+    writeSize(m_file, event.idx);
+    writeSize(m_file, event.DIMY);
+    writeValue(m_file, event.x);
+    writeValue(m_file, event.y);
+}
+
+// The file is flushed after every keyframe, so a recording that was not closed can be replayed up to its last one.
+void SessionRecorder::writeKeyframe(Keyframe const &keyframe)
+{
+    if (m_failed)
+        return;
+
+    Simulation::State const &state = keyframe.state;
+    m_fields.clear();
+    appendField(m_fields, state.rho);
+    appendField(m_fields, state.vx);
+    appendField(m_fields, state.vy);
+    appendField(m_fields, state.fx);
+    appendField(m_fields, state.fy);
+
+    if (m_keyframesSinceIntra == s_intraInterval || m_reference.size() != m_fields.size())
+    {
+        m_reference.clear();
+        m_keyframesSinceIntra = 0U;
+    }
+    bool const isDelta = !m_reference.empty();
+    QByteArray const data = sessionformat::compressFields(m_fields, m_reference);
+
+    writeValue(m_file, static_cast<std::uint8_t>(sessionformat::RecordType::Keyframe));
+    writeSize(m_file, keyframe.step);
+    writeSize(m_file, keyframe.firstEvent);
+    writeSize(m_file, state.DIMX);
+    writeSize(m_file, state.DIMY);
+    writeValue(m_file, state.dt);
+    writeValue(m_file, state.viscosity);
+    writeValue(m_file, state.rhoInjected);
+    writeSize(m_file, state.forceRowBegin);
+    writeSize(m_file, state.forceRowEnd);
+    writeValue(m_file, static_cast<std::uint8_t>(isDelta));
+    writeSize(m_file, static_cast<size_t>(data.size()));
+    m_file.write(data.constData(), static_cast<std::streamsize>(data.size()));
+
+    if (!m_file.flush())
+    {
+        qCritical() << "Cannot write the session recording" << m_fileName;
+        m_failed = true;
+        return;
+    }
+
+    m_rawBytes += m_fields.size() * sizeof(float);
+    m_compressedBytes += static_cast<size_t>(data.size());
+    m_reference.swap(m_fields);
+    ++m_keyframesSinceIntra;
+    ++m_writtenKeyframes;
+}
+
+void SessionRecorder::pushRecord(Record const &record)
+{
+    while (!m_records.push(record))
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+}
+
+bool SessionRecorder::tryRecordKeyframe(Simulation const &simulation, size_t const step, bool const wait)
+{
+    size_t slot = 0U;
+    while (!m_freeKeyframes.pop(slot))
+    {
+        if (!wait)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    Keyframe &keyframe = m_keyframes[slot];
+    keyframe.step = step;
+    keyframe.firstEvent = m_numberOfEvents;
+    simulation.copyState(keyframe.state);
+
+    Record record;
+    record.type = sessionformat::RecordType::Keyframe;
+    record.slot = slot;
+    pushRecord(record);
+    return true;
+}
+
+void SessionRecorder::recordKeyframe(Simulation const &simulation, size_t const step)
+{
+    if (!m_thread.joinable())
+        return;
+
+    tryRecordKeyframe(simulation, step, true);
+    m_keyframeDue = false;
+}
+
+void SessionRecorder::recordEvent(sessionformat::Event const &event)
+{
+    if (!m_thread.joinable())
+        return;
+
+    Record record;
+    record.event = event;
+    pushRecord(record);
+    ++m_numberOfEvents;
+}
+
+void SessionRecorder::recordStep(Simulation const &simulation, size_t const step)
+{
+    if (!m_thread.joinable())
+        return;
+
+    if (step % m_keyframeInterval == 0U)
+        m_keyframeDue = true;
+
+    if (m_keyframeDue && tryRecordKeyframe(simulation, step, false))
+        m_keyframeDue = false;
+}
+
+// Getters
+bool SessionRecorder::isOpen() const
+{
+    return m_thread.joinable();
+}
+
+size_t SessionRecorder::writtenKeyframes() const
+{
+    return m_writtenKeyframes;
+}
@@ -0,0 +1,102 @@
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include "sessionformat.h"
+#include "simulation.h"
+#include "spscqueue.h"
+
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Records a session of the simulation into one file, see sessionformat.h, from which SessionPlayer replays it: the
+// input and parameter changes as events, and every s_defaultKeyframeInterval steps the complete state as a keyframe to
+// seek to. Replaying the events from a keyframe reproduces the steps after it exactly, so the keyframes only make the
+// seeking fast and can be far apart.
+// Recording only copies the state into one of a few preallocated buffers; a writer thread compresses and writes it.
+// A keyframe that finds no free buffer is retried at the next step. Events are never dropped, as the replay depends
+// on every one of them: an event waits for the writer when the queue is full.
+// Recording has to be done from one thread at a time, opening and closing from the thread that opened the recorder.
+class SessionRecorder
+{
+    struct Record
+    {
+        sessionformat::RecordType type = sessionformat::RecordType::Event;
+        sessionformat::Event event; // Of an event.
+        size_t slot = 0U;           // Of a keyframe, its buffer.
+    };
+
+    struct Keyframe
+    {
+        size_t step = 0U;
+        size_t firstEvent = 0U;
+        Simulation::State state;
+    };
+
+    static constexpr size_t s_bufferCount = 4U;
+    static constexpr size_t s_intraInterval = 8U; // Every this many keyframes one is not a delta, limiting seek decoding.
+
+    std::array<Keyframe, s_bufferCount> m_keyframes;
+    SpscQueue<size_t> m_freeKeyframes{s_bufferCount + 1U}; // Pushed by the writer thread, popped by recording.
+    SpscQueue<Record> m_records{8192U};                    // Pushed by recording, popped by the writer thread.
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<size_t> m_writtenKeyframes{0U};
+
+    QString m_fileName;
+    size_t m_keyframeInterval = 0U;
+
+    // Only touched by recording.
+    size_t m_numberOfEvents = 0U;
+    bool m_keyframeDue = false;
+
+    // Only touched by the writer thread while it is running.
+    std::ofstream m_file;
+    std::vector<float> m_fields;    // Of the keyframe being written.
+    std::vector<float> m_reference; // Of the previous keyframe, empty after an intra keyframe is due.
+    size_t m_keyframesSinceIntra = 0U;
+    size_t m_rawBytes = 0U;
+    size_t m_compressedBytes = 0U;
+    bool m_failed = false;
+
+    void run();
+    void write(Record const &record);
+    void writeKeyframe(Keyframe const &keyframe);
+
+    void pushRecord(Record const &record);
+    bool tryRecordKeyframe(Simulation const &simulation, size_t const step, bool const wait);
+
+public:
+    static constexpr size_t s_defaultKeyframeInterval = 64U;
+
+    SessionRecorder() = default;
+    SessionRecorder(SessionRecorder const&) = delete;
+    SessionRecorder& operator=(SessionRecorder const&) = delete;
+    ~SessionRecorder();
+
+    // Starts a recording into fileName, overwriting it. Returns false, after logging why, if it cannot be created.
+    bool open(QString const &fileName, size_t const keyframeInterval = s_defaultKeyframeInterval);
+
+    // Writes the records still queued and closes the file. Nothing may be recording anymore.
+    void close();
+
+    // Records the state of the simulation after step as a keyframe, waiting for a free buffer. A recording starts with
+    // one, so the events have a state to be replayed from.
+    void recordKeyframe(Simulation const &simulation, size_t const step);
+    // Records an event the simulation received before the step after step.
+    void recordEvent(sessionformat::Event const &event);
+    // Called after every step, records a keyframe when one is due.
+    void recordStep(Simulation const &simulation, size_t const step);
+
+    // Getters
+    [[nodiscard]] bool isOpen() const;
+    [[nodiscard]] size_t writtenKeyframes() const;
+};
+
+#endif // SESSIONRECORDER_H
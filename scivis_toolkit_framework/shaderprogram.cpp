@@ -0,0 +1,12 @@
+#include "shaderprogram.h"
+
+#include <QDebug>
+
+GLint shaderprogram::uniformLocationWithCheck(QOpenGLShaderProgram const &openGLShaderProgram, char const * const name)
+{
+    GLint const loc = openGLShaderProgram.uniformLocation(name);
+    if (loc == -1)
+        qDebug() << "Warning: retrieving uniform location for" << name << "has failed.";
+
+    return loc;
+}
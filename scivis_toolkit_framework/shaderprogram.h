@@ -0,0 +1,13 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <QOpenGLShaderProgram>
+
+// Helpers shared by the classes that create their own shader programs.
+namespace shaderprogram
+{
+    // The location of a uniform of a linked program, with a warning if the program has no such (active) uniform.
+    [[nodiscard]] GLint uniformLocationWithCheck(QOpenGLShaderProgram const &openGLShaderProgram, char const * const name);
+}
+
+#endif // SHADERPROGRAM_H
@@ -0,0 +1,34 @@
+#version 330 core
+// glyph vertex shader, builds the model transformation of each instance from its direction and magnitude
+
+layout (location = 0) in vec4 vertCoordinates_in;
+layout (location = 6) in vec4 instanceData_in; // (direction x, direction y, scaled magnitude, glyph index)
+
+uniform ivec2 numberOfGlyphs;  // Number of glyphs in x- and y-direction.
+uniform vec2 gridOrigin;       // Position of the bottom-left glyph.
+uniform vec2 glyphSpacing;     // Distance between two neighbouring glyphs.
+uniform float glyphSize;       // Length of a glyph with a scaled magnitude of 1.
+
+out vec3 vertPosition;
+out float value;
+
+void main()
+{
+    // The instances are compacted to the visible glyphs, so the index in the glyph grid is passed along.
+    int instanceIdx = int(instanceData_in.w);
+    ivec2 glyphIdx = ivec2(instanceIdx % numberOfGlyphs.x, instanceIdx / numberOfGlyphs.x);
+    vec2 translation = gridOrigin + vec2(glyphIdx) * glyphSpacing;
+
+    // The glyph geometry points in the +y direction. Rotate it towards the vector, or keep it upright for a zero vector.
+    vec2 direction = instanceData_in.xy;
+    float directionLength = length(direction);
+    vec2 up = directionLength > 0.0F ? direction / directionLength : vec2(0.0F, 1.0F);
+    vec2 right = vec2(up.y, -up.x);
+
+    value = instanceData_in.z;
+    float scale = glyphSize * clamp(value, 0.0F, 1.0F);
+
+    vec3 scaled = scale * vertCoordinates_in.xyz;
+    vertPosition = vec3(translation + scaled.x * right + scaled.y * up, scaled.z);
+    gl_Position = vec4(vertPosition, 1.0F);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+// gpusimulation_advect fragment shader, semi-Lagrangian advection like advection::advectRows
+
+uniform sampler2D field;
+uniform sampler2D velocity;
+uniform float texelSize;
+uniform float dt;
+
+out vec4 advected;
+
+void main()
+{
+    // The grid spans [0, 1], so the velocity moves texture coordinates directly.
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+    vec2 origin = texCoord - dt * texture(velocity, texCoord).xy;
+    advected = texture(field, origin);
+}
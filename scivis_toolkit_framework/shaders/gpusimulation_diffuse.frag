@@ -0,0 +1,20 @@
+#version 330 core
+// gpusimulation_diffuse fragment shader, one Jacobi iteration of (1 - alpha * laplacian) v = rightHandSide
+
+uniform sampler2D velocity;
+uniform sampler2D rightHandSide;
+uniform float texelSize;
+uniform float alpha; // viscosity * dt / cellSize^2
+
+out vec4 diffused;
+
+void main()
+{
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+    vec2 neighbours = texture(velocity, texCoord + vec2(texelSize, 0.0F)).xy
+                    + texture(velocity, texCoord - vec2(texelSize, 0.0F)).xy
+                    + texture(velocity, texCoord + vec2(0.0F, texelSize)).xy
+                    + texture(velocity, texCoord - vec2(0.0F, texelSize)).xy;
+
+    diffused = vec4((texture(rightHandSide, texCoord).xy + alpha * neighbours) / (1.0F + 4.0F * alpha), 0.0F, 0.0F);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+// gpusimulation_divergence fragment shader, central differences in units of cells
+
+uniform sampler2D velocity;
+uniform float texelSize;
+
+out vec4 divergence;
+
+void main()
+{
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+    float right = texture(velocity, texCoord + vec2(texelSize, 0.0F)).x;
+    float left = texture(velocity, texCoord - vec2(texelSize, 0.0F)).x;
+    float top = texture(velocity, texCoord + vec2(0.0F, texelSize)).y;
+    float bottom = texture(velocity, texCoord - vec2(0.0F, texelSize)).y;
+
+    divergence = vec4(0.5F * (right - left + top - bottom), 0.0F, 0.0F, 0.0F);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+// gpusimulation_forces fragment shader, mirrors Simulation::set_forces
+
+uniform sampler2D force;
+uniform sampler2D velocity;
+uniform sampler2D density;
+uniform float texelSize;
+uniform float dt;
+
+layout (location = 0) out vec4 forceOut;
+layout (location = 1) out vec4 velocityOut;
+layout (location = 2) out vec4 densityOut;
+
+void main()
+{
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+
+    // Reduce force and apply it, reduce density.
+    vec2 reducedForce = 0.85F * texture(force, texCoord).xy;
+    forceOut = vec4(reducedForce, 0.0F, 0.0F);
+    velocityOut = vec4(texture(velocity, texCoord).xy + dt * reducedForce, 0.0F, 0.0F);
+    densityOut = vec4(0.995F * texture(density, texCoord).r, 0.0F, 0.0F, 0.0F);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// gpusimulation_pressure fragment shader, one Jacobi iteration of laplacian p = divergence in units of cells
+
+uniform sampler2D pressure;
+uniform sampler2D divergence;
+uniform float texelSize;
+
+out vec4 pressureOut;
+
+void main()
+{
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+    float neighbours = texture(pressure, texCoord + vec2(texelSize, 0.0F)).r
+                     + texture(pressure, texCoord - vec2(texelSize, 0.0F)).r
+                     + texture(pressure, texCoord + vec2(0.0F, texelSize)).r
+                     + texture(pressure, texCoord - vec2(0.0F, texelSize)).r;
+
+    pressureOut = vec4(0.25F * (neighbours - texture(divergence, texCoord).r), 0.0F, 0.0F, 0.0F);
+}
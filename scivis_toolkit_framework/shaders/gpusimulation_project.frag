@@ -0,0 +1,19 @@
+#version 330 core
+// gpusimulation_project fragment shader, subtracts the pressure gradient to make the velocity divergence free
+
+uniform sampler2D velocity;
+uniform sampler2D pressure;
+uniform float texelSize;
+
+out vec4 projected;
+
+void main()
+{
+    vec2 texCoord = gl_FragCoord.xy * texelSize;
+    vec2 gradient = 0.5F * vec2(texture(pressure, texCoord + vec2(texelSize, 0.0F)).r
+                                - texture(pressure, texCoord - vec2(texelSize, 0.0F)).r,
+                                texture(pressure, texCoord + vec2(0.0F, texelSize)).r
+                                - texture(pressure, texCoord - vec2(0.0F, texelSize)).r);
+
+    projected = vec4(texture(velocity, texCoord).xy - gradient, 0.0F, 0.0F);
+}
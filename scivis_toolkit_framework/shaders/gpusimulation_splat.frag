@@ -0,0 +1,11 @@
+#version 330 core
+// gpusimulation_splat fragment shader
+
+in vec2 value;
+
+out vec4 color;
+
+void main()
+{
+    color = vec4(value, 0.0F, 0.0F);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+// gpusimulation_splat vertex shader, one point per texel written by the mouse input
+
+layout (location = 0) in vec2 texel_in;
+layout (location = 1) in vec2 value_in;
+
+uniform float DIM;
+
+out vec2 value;
+
+void main()
+{
+    gl_Position = vec4(2.0F * (texel_in + 0.5F) / DIM - 1.0F, 0.0F, 1.0F);
+    value = value_in;
+}
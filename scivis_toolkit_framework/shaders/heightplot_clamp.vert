@@ -24,12 +24,97 @@ uniform mat3 normalTransform;
 uniform vec4 material; // Contains 4 floats, in order: k_a, k_d, k_s, alpha.
 uniform vec3 lightPosition;
 
+// When set, the scalar values are read from the scalar field texture of the scalar data view instead of value_in.
+uniform bool sampleScalarField;
+uniform sampler2D scalarField;
+
+float scalarValue()
+{
+    // The vertex ID is the grid index, the texture has one texel per grid point.
+    int DIM = textureSize(scalarField, 0).x;
+    return sampleScalarField ? texelFetch(scalarField, ivec2(gl_VertexID % DIM, gl_VertexID / DIM), 0).r : value_in;
+}
+
+// When set, the heights are read from the height field texture and the normals are computed from it in this shader,
+// instead of being read from height and vertNormals_in.
+uniform bool sampleHeightField;
+uniform sampler2D heightField;
+uniform float heightScale;
+uniform vec2 cellSize; // Distance between two neighbouring grid points.
+
+float heightAt(ivec2 gridIdx)
+{
+    return heightScale * texelFetch(heightField, gridIdx, 0).r;
+}
+
+// Level of detail: the grid is drawn as patches, each with its own step between the vertices (see HeightplotLod).
+// The vertices on an edge shared with a coarser neighbour are moved onto the edge of that neighbour to avoid cracks.
+uniform bool useLod;
+uniform ivec2 patchOrigin;
+uniform ivec2 patchSize;      // In cells.
+uniform ivec4 neighbourSteps; // Vertex steps of the left, right, bottom and top neighbours, 0 unless coarser.
+
+// The height on the edge of a patch with the given vertex step; the edge runs along the given axis.
+float edgeHeight(ivec2 gridIdx, int axis, int step)
+{
+    int offset = (gridIdx[axis] - patchOrigin[axis]) % step;
+    if (offset == 0)
+        return heightAt(gridIdx);
+
+    ivec2 start = gridIdx;
+    start[axis] -= offset;
+    ivec2 end = start;
+    end[axis] += step;
+    return mix(heightAt(start), heightAt(end), float(offset) / float(step));
+}
+
+float heightValue()
+{
+    if (!sampleHeightField)
+        return height;
+
+    int DIM = textureSize(heightField, 0).x;
+    ivec2 gridIdx = ivec2(gl_VertexID % DIM, gl_VertexID / DIM);
+    if (useLod)
+    {
+        ivec2 localIdx = gridIdx - patchOrigin;
+        if (localIdx.x == 0 && neighbourSteps.x > 0)
+            return edgeHeight(gridIdx, 1, neighbourSteps.x);
+        if (localIdx.x == patchSize.x && neighbourSteps.y > 0)
+            return edgeHeight(gridIdx, 1, neighbourSteps.y);
+        if (localIdx.y == 0 && neighbourSteps.z > 0)
+            return edgeHeight(gridIdx, 0, neighbourSteps.z);
+        if (localIdx.y == patchSize.y && neighbourSteps.w > 0)
+            return edgeHeight(gridIdx, 0, neighbourSteps.w);
+    }
+
+    return heightAt(gridIdx);
+}
+
+// Central differences of the height field, one-sided at the border of the grid.
+vec3 vertexNormal()
+{
+    if (!sampleHeightField)
+        return vertNormals_in;
+
+    ivec2 size = textureSize(heightField, 0);
+    ivec2 gridIdx = ivec2(gl_VertexID % size.x, gl_VertexID / size.x);
+    ivec2 left  = max(gridIdx - ivec2(1, 0), ivec2(0));
+    ivec2 right = min(gridIdx + ivec2(1, 0), size - 1);
+    ivec2 down  = max(gridIdx - ivec2(0, 1), ivec2(0));
+    ivec2 up    = min(gridIdx + ivec2(0, 1), size - 1);
+
+    float dhdx = (heightAt(right) - heightAt(left)) / (float(right.x - left.x) * cellSize.x);
+    float dhdy = (heightAt(up) - heightAt(down)) / (float(up.y - down.y) * cellSize.y);
+    return normalize(vec3(-dhdx, -dhdy, 1.0F));
+}
+
 void main()
 {
-    gl_Position = projectionTransform * viewTransform * vec4(vertCoordinates_in, height, 1.0F);
+    gl_Position = projectionTransform * viewTransform * vec4(vertCoordinates_in, heightValue(), 1.0F);
 
     // Placeholder values
-    value = clampMin + clampMax;
+    value = scalarValue() + clampMin + clampMax;
     shading = transferK + material.x + lightPosition.x;
-    heightChange = normalTransform[0][0];
+    heightChange = normalTransform[0][0] + vertexNormal().x;
 }
@@ -1,7 +1,7 @@
 #version 330 core
 // isolines fragment shader
 
-uniform vec3 isolineColor;
+in vec3 isolineColor;
 
 out vec4 color;
 
@@ -1,20 +1,41 @@
 #version 330 core
 // isolines vertex shader
 
+// Must match Visualization::s_maxNumberOfIsolines.
+#define MAX_NUMBER_OF_ISOLINES 64
+
 layout (location = 0) in vec4 vertCoordinates_in;
 layout (location = 1) in float value_in;
 
-uniform float rho;
+// All isolines are drawn in a single instanced draw call: instance n extracts the isoline of isolineValues[n].
+uniform float isolineValues[MAX_NUMBER_OF_ISOLINES];
+uniform vec3 isolineColors[MAX_NUMBER_OF_ISOLINES];
+
+// When set, the values are read from the scalar field texture of the scalar data view instead of value_in.
+uniform bool sampleScalarField;
+uniform sampler2D scalarField;
 
 out VS_OUT
 {
     float value;
     int greaterThanRho;
+    float rho;
+    vec3 color;
 } vs_out;
 
 void main()
 {
     gl_Position = vertCoordinates_in;
-    vs_out.value = value_in;
-    vs_out.greaterThanRho = int(value_in > rho);
+
+    // The vertex ID is the grid index, the texture has one texel per grid point.
+    int DIM = textureSize(scalarField, 0).x;
+    float currentValue = sampleScalarField ? texelFetch(scalarField, ivec2(gl_VertexID % DIM, gl_VertexID / DIM), 0).r
+                                           : value_in;
+
+    float rho = isolineValues[gl_InstanceID];
+
+    vs_out.value = currentValue;
+    vs_out.greaterThanRho = int(currentValue > rho);
+    vs_out.rho = rho;
+    vs_out.color = isolineColors[gl_InstanceID];
 }
@@ -0,0 +1,50 @@
+#version 330 core
+// isolines vertex shader for the segments extracted on the CPU
+
+// Must match Visualization::s_maxNumberOfIsolines.
+#define MAX_NUMBER_OF_ISOLINES 64
+
+layout (location = 0) in vec2 gridPosition_in; // Grid coordinates, (i, j) is the position of grid point i + j * DIMX.
+layout (location = 1) in float level_in;       // Index of the isovalue.
+
+uniform vec2 cellSize;
+uniform vec3 isolineColors[MAX_NUMBER_OF_ISOLINES];
+
+// When set, the segments are drawn on the surface of the height plot instead of in the plane.
+uniform bool onHeightplot;
+uniform mat4 projectionTransform;
+uniform mat4 viewTransform;
+uniform sampler2D heightField;
+uniform float heightScale;
+
+out vec3 isolineColor;
+
+// Bilinear between the four grid points around the position, as the segments end between grid points.
+float heightAt(vec2 gridPosition)
+{
+    ivec2 maxIdx = textureSize(heightField, 0) - 1;
+    ivec2 idx = clamp(ivec2(floor(gridPosition)), ivec2(0), max(maxIdx - 1, ivec2(0)));
+    vec2 t = clamp(gridPosition - vec2(idx), 0.0F, 1.0F);
+
+    float bottom = mix(texelFetch(heightField, idx, 0).r,
+                       texelFetch(heightField, min(idx + ivec2(1, 0), maxIdx), 0).r, t.x);
+    float top = mix(texelFetch(heightField, min(idx + ivec2(0, 1), maxIdx), 0).r,
+                    texelFetch(heightField, min(idx + ivec2(1, 1), maxIdx), 0).r, t.x);
+    return heightScale * mix(bottom, top, t.y);
+}
+
+void main()
+{
+    // Same placement as the grid points in Visualization::opengl_updateScalarPoints.
+    vec2 position = cellSize * (gridPosition_in + 1.0F) - 1.0F;
+    if (onHeightplot)
+    {
+        // Lifted slightly, so the lines are not hidden in the surface between the grid points.
+        float lift = 0.25F * min(cellSize.x, cellSize.y);
+        gl_Position = projectionTransform * viewTransform * vec4(position, heightAt(gridPosition_in) + lift, 1.0F);
+    }
+    else
+        gl_Position = vec4(position, 0.0F, 1.0F);
+
+    isolineColor = isolineColors[int(level_in)];
+}
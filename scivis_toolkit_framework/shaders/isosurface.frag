@@ -0,0 +1,32 @@
+#version 330 core
+// isosurface fragment shader, Blinn-Phong with the light of the volume rendering shaders
+
+in vec3 position;
+in vec3 normal;
+
+uniform vec3 eye;
+uniform vec3 color;
+
+out vec4 fragColor;
+
+const vec3 lightDir = vec3(1.0F, 1.0F, 1.0F);
+const float ka = 0.3F;  // ambient contribution
+const float kd = 0.6F;  // diffuse contribution
+const float ks = 0.4F;  // specular contribution
+const float exponent = 50.0F;  // specular exponent (shininess)
+
+void main()
+{
+    vec3 V = normalize(eye - position);
+    vec3 N = normalize(normal);
+    // Both sides of the surface are lit alike.
+    if (dot(N, V) < 0.0F)
+        N = -N;
+
+    vec3 L = normalize(lightDir);
+    vec3 H = normalize(L + V);
+    float diffuse = max(dot(N, L), 0.0F);
+    float specular = diffuse > 0.0F ? pow(max(dot(N, H), 0.0F), exponent) : 0.0F;
+
+    fragColor = vec4((ka + kd * diffuse) * color + ks * specular * vec3(1.0F), 1.0F);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+// isosurface vertex shader
+
+layout (location = 0) in vec3 position_in; // Normalized volume coordinates.
+layout (location = 1) in vec3 normal_in;
+
+uniform mat4 viewProjection;
+
+out vec3 position;
+out vec3 normal;
+
+void main()
+{
+    // The volume renderer places the volume in the unit cube centered at the origin.
+    position = position_in - 0.5F;
+    normal = normal_in;
+    gl_Position = viewProjection * vec4(position, 1.0F);
+}
@@ -11,10 +11,18 @@ in vec2 texCoordinates;
 
 out vec4 color;
 
+// The velocity field texture holds the raw velocities, this returns the normalized direction (or zero).
+vec2 velocityDirection(vec2 position)
+{
+    vec2 velocity = texture(velocityField, position).xy;
+    float magnitude = length(velocity);
+    return magnitude == 0.0F ? vec2(0.0F) : velocity / magnitude;
+}
+
 void main()
 {
     // Placeholder computations to prevent warnings
-    float magnitude = length(texture(velocityField, texCoordinates).xy);
+    float magnitude = length(velocityDirection(texCoordinates));
     float noiseValue = texture(noiseTexture, texCoordinates).r;
     float nonsenseValue = magnitude * noiseValue * stepSize * streamlineLength;
 
@@ -0,0 +1,41 @@
+#version 330 core
+// lic_accumulate fragment shader, one step of the temporally coherent LIC
+
+uniform sampler2D noiseTexture;
+uniform sampler2D velocityField;
+uniform sampler2D previousConvolution;
+
+uniform int streamlineLength; // i.e. L. One way (backwards).
+uniform float stepSize;
+uniform bool resetConvolution;
+
+in vec2 texCoordinates;
+
+out vec4 color;
+
+// The velocity field texture holds the raw velocities, this returns the normalized direction (or zero).
+vec2 velocityDirection(vec2 position)
+{
+    vec2 velocity = texture(velocityField, position).xy;
+    float magnitude = length(velocity);
+    return magnitude == 0.0F ? vec2(0.0F) : velocity / magnitude;
+}
+
+void main()
+{
+    float noiseValue = texture(noiseTexture, texCoordinates).r;
+    if (resetConvolution)
+    {
+        color = vec4(noiseValue, 0.0F, 0.0F, 1.0F);
+        return;
+    }
+
+    // The previous convolution one step upstream already holds the samples further along the streamline, so every
+    // pixel adds only its own noise sample. This is an exponentially weighted convolution over about streamlineLength
+    // steps, at the cost of a single step per pass.
+    vec2 upstream = texCoordinates - stepSize * velocityDirection(texCoordinates);
+    float previousValue = texture(previousConvolution, upstream).r;
+    float weight = 1.0F / float(max(streamlineLength, 1));
+
+    color = vec4(mix(previousValue, noiseValue, weight), 0.0F, 0.0F, 1.0F);
+}
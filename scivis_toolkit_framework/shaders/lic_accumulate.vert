@@ -0,0 +1,14 @@
+#version 330 core
+// lic_accumulate vertex shader, covers the whole convolution framebuffer
+
+layout (location = 0) in vec4 vertCoordinates_in;
+layout (location = 1) in vec2 texCoordinates_in;
+
+out vec2 texCoordinates;
+
+void main()
+{
+    // The LIC quad has a border on screen, but the convolution texture maps to the whole framebuffer.
+    gl_Position = vec4(2.0F * texCoordinates_in - 1.0F, 0.0F, 1.0F);
+    texCoordinates = texCoordinates_in;
+}
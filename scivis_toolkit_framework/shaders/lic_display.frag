@@ -0,0 +1,20 @@
+#version 330 core
+// lic_display fragment shader, shows the convolution of lic_accumulate.frag
+
+uniform sampler2D convolution;
+uniform int streamlineLength;
+
+in vec2 texCoordinates;
+
+out vec4 color;
+
+void main()
+{
+    // Averaging reduces the contrast of the uniform noise (mean 0.5). For an exponential filter with weight w, the
+    // standard deviation shrinks by sqrt(w / (2 - w)), this restores it.
+    float weight = 1.0F / float(max(streamlineLength, 1));
+    float gain = sqrt((2.0F - weight) / weight);
+    float value = clamp(0.5F + gain * (texture(convolution, texCoordinates).r - 0.5F), 0.0F, 1.0F);
+
+    color = vec4(value, value, value, 1.0F);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+// particles fragment shader
+
+in float life;
+
+uniform sampler1D colorMap;
+
+out vec4 color;
+
+void main()
+{
+    color = vec4(texture(colorMap, life).rgb, life);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+// particles vertex shader, one point per particle
+
+layout (location = 0) in vec4 particle_in; // Position in texture coordinates, age and lifetime in steps.
+
+uniform vec2 DIM; // DIMX and DIMY.
+uniform vec2 cellSize;
+
+out float life; // The remaining part of the lifetime, from 1 down to 0.
+
+void main()
+{
+    if (particle_in.z >= particle_in.w)
+    {
+        gl_Position = vec4(2.0F, 2.0F, 2.0F, 1.0F); // Dead, outside the clip volume.
+        life = 0.0F;
+        return;
+    }
+
+    // Texel (i, j) is centered at ((i, j) + 0.5) / DIM. Same placement as the grid points in
+    // Visualization::opengl_updateScalarPoints.
+    vec2 gridPosition = particle_in.xy * DIM - 0.5F;
+    gl_Position = vec4(cellSize * (gridPosition + 1.0F) - 1.0F, 0.0F, 1.0F);
+    life = 1.0F - particle_in.z / particle_in.w;
+}
@@ -0,0 +1,69 @@
+#version 330 core
+// particles_advect vertex shader, one RK2 step of a particle per vertex, captured with transform feedback
+
+// Must match ParticleSystem::s_maxNumberOfEmitters.
+#define MAX_NUMBER_OF_EMITTERS 16
+
+layout (location = 0) in vec4 particle_in; // Position in texture coordinates, age and lifetime in steps.
+
+uniform sampler2D velocity;
+uniform float dt;
+uniform float steps;
+uniform float aspectRatio; // DIMX / DIMY, converts the y velocity from the units of the grid width.
+
+// The particles [emissionStart, emissionStart + numberOfEmitters * particlesPerEmitter) of the ring are respawned,
+// particlesPerEmitter around every emitter.
+uniform vec2 emitters[MAX_NUMBER_OF_EMITTERS];
+uniform int numberOfEmitters;
+uniform int particlesPerEmitter;
+uniform int emissionStart;
+uniform int capacity;
+uniform float emissionRadius;
+uniform float lifetime;
+uniform uint seed;
+
+out vec4 particle;
+
+uint hash(uint x)
+{
+    x ^= x >> 16U;
+    x *= 0x7feb352dU;
+    x ^= x >> 15U;
+    x *= 0x846ca68bU;
+    x ^= x >> 16U;
+    return x;
+}
+
+// Uniform in [0, 1).
+float random(uint x)
+{
+    return float(hash(x) >> 8U) / 16777216.0F;
+}
+
+void main()
+{
+    int offset = (gl_VertexID - emissionStart + capacity) % capacity;
+    if (offset < numberOfEmitters * particlesPerEmitter)
+    {
+        // Uniform over a disc around the emitter, with a lifetime between half and all of the longest.
+        uint key = hash(uint(gl_VertexID) ^ hash(seed));
+        float angle = 6.28318531F * random(key);
+        float radius = emissionRadius * sqrt(random(key + 1U));
+        vec2 position = emitters[offset / particlesPerEmitter] + radius * vec2(cos(angle), sin(angle));
+        particle = vec4(fract(position), 0.0F, lifetime * (0.5F + 0.5F * random(key + 2U)));
+        return;
+    }
+
+    if (particle_in.z >= particle_in.w)
+    {
+        particle = particle_in; // Dead, until it is respawned.
+        return;
+    }
+
+    // Midpoint rule over all steps at once. The grid is periodic, like the simulation.
+    float h = dt * steps;
+    vec2 scale = vec2(1.0F, aspectRatio);
+    vec2 midpoint = particle_in.xy + 0.5F * h * scale * texture(velocity, particle_in.xy).xy;
+    vec2 position = particle_in.xy + h * scale * texture(velocity, midpoint).xy;
+    particle = vec4(fract(position), particle_in.z + steps, particle_in.w);
+}
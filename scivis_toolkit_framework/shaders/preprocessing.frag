@@ -0,0 +1,65 @@
+#version 330 core
+// preprocessing fragment shader, one filter pass over the scalar field with one fragment per grid point
+
+#define PASS_QUANTIZATION 0
+#define PASS_BLUR_HORIZONTAL 1
+#define PASS_BLUR_VERTICAL 2
+#define PASS_GRADIENTS 3
+
+uniform sampler2D field;        // Result of the previous pass, the values are in the red channel.
+uniform sampler2D range;        // 1x1 texel holding the (min, max) of the unfiltered field, see preprocessing_range.frag.
+uniform int pass;
+uniform float quantizationStep; // 1 / 2^(8 - n), maps the 256 levels of [0, 255] onto 2^n levels.
+
+out vec2 result; // (value, gradient direction in radians)
+
+// Values outside the grid are clamped to the nearest border value.
+float valueAt(ivec2 idx)
+{
+    ivec2 lastIdx = textureSize(field, 0) - 1;
+    return texelFetch(field, clamp(idx, ivec2(0), lastIdx), 0).r;
+}
+
+void main()
+{
+    ivec2 idx = ivec2(gl_FragCoord.xy);
+
+    switch (pass)
+    {
+    case PASS_QUANTIZATION:
+    {
+        float maxValue = texelFetch(range, ivec2(0), 0).g;
+        float scale = maxValue > 0.0F ? 255.0F / maxValue : 0.0F;
+        float pixel = clamp(roundEven(valueAt(idx) * scale), 0.0F, 255.0F);
+        result = vec2(floor(pixel * quantizationStep), 0.0F);
+    }
+    break;
+
+    // The 3x3 Gaussian kernel is the outer product of [1 2 1] / 4 with itself.
+    case PASS_BLUR_HORIZONTAL:
+        result = vec2(0.25F * (valueAt(idx - ivec2(1, 0)) + 2.0F * valueAt(idx) + valueAt(idx + ivec2(1, 0))), 0.0F);
+        break;
+
+    case PASS_BLUR_VERTICAL:
+        result = vec2(0.25F * (valueAt(idx - ivec2(0, 1)) + 2.0F * valueAt(idx) + valueAt(idx + ivec2(0, 1))), 0.0F);
+        break;
+
+    // Sobel: Gx = [1 2 1]^T * [-1 0 1], Gy = [-1 0 1]^T * [1 2 1].
+    case PASS_GRADIENTS:
+    {
+        float v00 = valueAt(idx + ivec2(-1, -1));
+        float v10 = valueAt(idx + ivec2( 0, -1));
+        float v20 = valueAt(idx + ivec2( 1, -1));
+        float v01 = valueAt(idx + ivec2(-1,  0));
+        float v21 = valueAt(idx + ivec2( 1,  0));
+        float v02 = valueAt(idx + ivec2(-1,  1));
+        float v12 = valueAt(idx + ivec2( 0,  1));
+        float v22 = valueAt(idx + ivec2( 1,  1));
+
+        float gx = (v20 - v00) + 2.0F * (v21 - v01) + (v22 - v02);
+        float gy = (v02 - v00) + 2.0F * (v12 - v10) + (v22 - v20);
+        result = vec2(length(vec2(gx, gy)), atan(gy, gx));
+    }
+    break;
+    }
+}
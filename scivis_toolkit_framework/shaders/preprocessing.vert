@@ -0,0 +1,9 @@
+#version 330 core
+// preprocessing vertex shader, covers the whole framebuffer with a triangle strip of 4 vertices
+
+void main()
+{
+    // Vertices 0..3 map to the corners (0, 0), (1, 0), (0, 1) and (1, 1).
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    gl_Position = vec4(2.0F * corner - 1.0F, 0.0F, 1.0F);
+}
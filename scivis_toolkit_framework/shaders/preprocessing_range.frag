@@ -0,0 +1,31 @@
+#version 330 core
+// preprocessing_range fragment shader, one level of the (min, max) reduction of a field
+
+#define BLOCK_SIZE 4
+
+uniform sampler2D field;
+uniform bool reduceValues; // The first level reads values (red channel), later levels read (min, max) pairs.
+
+out vec2 range;
+
+// Each fragment reduces a block of BLOCK_SIZE x BLOCK_SIZE texels, so every level is BLOCK_SIZE times smaller.
+void main()
+{
+    ivec2 size = textureSize(field, 0);
+    ivec2 blockOrigin = ivec2(gl_FragCoord.xy) * BLOCK_SIZE;
+
+    range = vec2(3.402823466e38F, -3.402823466e38F);
+    for (int j = 0; j < BLOCK_SIZE; ++j)
+    {
+        for (int i = 0; i < BLOCK_SIZE; ++i)
+        {
+            ivec2 idx = blockOrigin + ivec2(i, j);
+            if (any(greaterThanEqual(idx, size)))
+                continue;
+
+            vec2 texel = texelFetch(field, idx, 0).rg;
+            vec2 blockRange = reduceValues ? texel.rr : texel;
+            range = vec2(min(range.x, blockRange.x), max(range.y, blockRange.y));
+        }
+    }
+}
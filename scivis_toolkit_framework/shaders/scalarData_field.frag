@@ -0,0 +1,38 @@
+#version 330 core
+// scalarData_field fragment shader, maps the scalar field texture per fragment
+
+in vec2 texCoordinates;
+
+uniform sampler2D scalarField;      // R32F, one texel per simulation grid point.
+uniform sampler1D textureSampler;   // Color map.
+
+uniform float rangeMin;             // The range that is mapped to [0, 1]: the clamp range or the scaling range.
+uniform float rangeMax;
+uniform float transferK;
+
+uniform bool useCustomColorMap;
+uniform vec3 colorMapColors[3];
+
+out vec4 color;
+
+void main()
+{
+    float value = texture(scalarField, texCoordinates).r;
+
+    // Map the range [rangeMin, rangeMax] to [0, 1].
+    float range = max(rangeMax - rangeMin, 1e-20F);
+    value = clamp((value - rangeMin) / range, 0.0F, 1.0F);
+
+    // Apply transfer function.
+    value = pow(value, transferK);
+
+    if (useCustomColorMap)
+    {
+        // Interpolate linearly between the three colors.
+        vec3 colorFromColorMap = value < 0.5F ? mix(colorMapColors[0], colorMapColors[1], 2.0F * value)
+                                              : mix(colorMapColors[1], colorMapColors[2], 2.0F * value - 1.0F);
+        color = vec4(colorFromColorMap, 1.0F);
+    }
+    else
+        color = texture(textureSampler, value);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+// streamlines fragment shader
+
+in float value;
+
+uniform sampler1D textureSampler;
+
+out vec4 color;
+
+void main()
+{
+    color = vec4(texture(textureSampler, value).rgb, 1.0F);
+}
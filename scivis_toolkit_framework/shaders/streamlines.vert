@@ -0,0 +1,17 @@
+#version 330 core
+// streamlines vertex shader
+
+layout (location = 0) in vec2 gridPosition_in; // Grid coordinates, (i, j) is the position of grid point i + j * DIMX.
+layout (location = 1) in float speed_in;
+
+uniform vec2 cellSize;
+uniform float maxSpeed;
+
+out float value;
+
+void main()
+{
+    // Same placement as the grid points in Visualization::opengl_updateScalarPoints.
+    gl_Position = vec4(cellSize * (gridPosition_in + 1.0F) - 1.0F, 0.0F, 1.0F);
+    value = clamp(speed_in / maxSpeed, 0.0F, 1.0F);
+}
@@ -9,6 +9,29 @@ uniform vec2 iResolution;
 uniform float iTime;
 uniform sampler3D textureSampler;
 
+// Bricking of the volume in textureSampler, see BrickLayout. A volume that is not bricked is one brick in one cell.
+uniform vec3 brickCount;
+uniform vec3 brickScale;
+uniform vec3 atlasCellCount;
+uniform vec3 atlasCellExtent;
+uniform vec3 atlasGhostOffset;
+uniform vec3 atlasCoreExtent;
+
+// BC4 compressed volume, one layer per z slice (see Bc4Volume). Used instead of textureSampler when isCompressed.
+uniform bool isCompressed;
+uniform sampler2DArray compressedSampler;
+
+// Visible (1) and fully transparent (0) cells of the volume, see VolumeOccupancy.
+uniform sampler3D occupancySampler;
+uniform vec3 occupancyCellExtent; // Size of one cell, in normalized volume coordinates.
+
+// Sampling, set at runtime to trade quality for frame time.
+uniform float stepScale;             // Factor for the step length.
+uniform float maxAdaptiveStepScale;  // Largest extra factor for the step length where the volume barely changes (1: off).
+uniform float adaptiveStepThreshold; // Change of the sample value between two samples from which steps keep their length.
+uniform float terminationOpacity;    // A ray stops once its accumulated opacity reaches this value.
+uniform float rayOffset;             // Offset of the first sample along the ray, in steps. Varied for progressive rendering.
+
 out vec4 color;
 
 // bounding box
@@ -41,6 +64,23 @@ const vec3 colorNode0 = vec3(0.0F, 0.0F, 1.0F);  // blue
 const vec3 colorNode1 = vec3(0.0F, 1.0F, 0.0F);  // green
 const vec3 colorNode2 = vec3(1.0F, 0.0F, 0.0F);  // red
 
+/**
+ *	Samples the BC4 compressed volume at a given position inside of it.
+ *
+ *	@param texCoord The position one wants to retrieve the sample of (in world coordinates).
+ *	@return The sample value at the given position.
+ */
+float sampleCompressedVolume(vec3 texCoord)
+{
+    // The layers of an array texture are not filtered with each other, so z is interpolated here.
+    float depth = float(textureSize(compressedSampler, 0).z);
+    float slice = clamp(texCoord.z * depth - 0.5F, 0.0F, depth - 1.0F);
+    float lowerSlice = floor(slice);
+    float lower = texture(compressedSampler, vec3(texCoord.xy, lowerSlice)).r;
+    float upper = texture(compressedSampler, vec3(texCoord.xy, min(lowerSlice + 1.0F, depth - 1.0F))).r;
+    return mix(lower, upper, slice - lowerSlice);
+}
+
 /**
  *	Samples the volume texture at a given position.
  *
@@ -49,7 +89,58 @@ const vec3 colorNode2 = vec3(1.0F, 0.0F, 0.0F);  // red
  */
 float sampleVolume(vec3 texCoord)
 {
-    return texture(textureSampler, texCoord).r;
+    // Outside of the volume, a brick would read its neighbouring cell instead of the border.
+    if (any(lessThan(texCoord, vec3(0.0F))) || any(greaterThan(texCoord, vec3(1.0F))))
+        return 0.0F;
+
+    if (isCompressed)
+        return sampleCompressedVolume(texCoord);
+
+    vec3 brickCoord = texCoord * brickScale;
+    vec3 brick = clamp(floor(brickCoord), vec3(0.0F), brickCount - 1.0F);
+
+    // The bricks fill the cells of the atlas x first, then y, then z.
+    float brickIdx = brick.x + brickCount.x * (brick.y + brickCount.y * brick.z);
+    float row = floor((brickIdx + 0.5F) / atlasCellCount.x);
+    float layer = floor((row + 0.5F) / atlasCellCount.y);
+    vec3 cell = vec3(brickIdx - row * atlasCellCount.x, row - layer * atlasCellCount.y, layer);
+
+    vec3 atlasCoord = cell * atlasCellExtent + atlasGhostOffset + (brickCoord - brick) * atlasCoreExtent;
+    return texture(textureSampler, atlasCoord).r;
+}
+
+/**
+ *	Looks up whether a position lies in a cell that is fully transparent under the transfer function.
+ *
+ *	@param texCoord The position (in normalized volume coordinates).
+ *	@return True if nothing in the cell around texCoord contributes to the image.
+ */
+bool isEmptySpace(vec3 texCoord)
+{
+    ivec3 cell = clamp(ivec3(floor(texCoord / occupancyCellExtent)), ivec3(0), textureSize(occupancySampler, 0) - 1);
+    return texelFetch(occupancySampler, cell, 0).r == 0.0F;
+}
+
+/**
+ *	Computes the ray parameter of the first sample behind the empty cell around a position.
+ *	The samples stay on the same positions as without skipping, and at least one sample is skipped.
+ *
+ *	@param texCoord The position of the current sample (in normalized volume coordinates).
+ *	@param rayDir The direction of the ray.
+ *	@param t The ray parameter of the current sample.
+ *	@param tNear The ray parameter of the first sample.
+ *	@param rayStepSize The distance between two samples.
+ *	@return The ray parameter of the next sample to take.
+ */
+float skipEmptySpace(vec3 texCoord, vec3 rayDir, float t, float tNear, float rayStepSize)
+{
+    vec3 cell = floor(texCoord / occupancyCellExtent);
+    vec3 exitPlanes = (cell + step(0.0F, rayDir)) * occupancyCellExtent;
+    vec3 tPlanes = abs(exitPlanes - texCoord) / max(abs(rayDir), vec3(1e-6F));
+    float tExit = t + min(min(tPlanes.x, tPlanes.y), tPlanes.z);
+
+    float currentStep = floor((t - tNear) / rayStepSize + 0.5F);
+    return tNear + max(ceil((tExit - tNear) / rayStepSize), currentStep + 1.0F) * rayStepSize;
 }
 
 /**
@@ -135,6 +226,20 @@ vec4 lighting(vec4 diffuseColor, vec3 normal, vec3 eyeDir)
 
 // *** *** //
 
+/**
+ *	Computes the length of the next step along the ray. Steps grow up to maxAdaptiveStepScale times where the volume
+ *	barely changes from one sample to the next, and keep their base length where it changes by adaptiveStepThreshold.
+ *
+ *	@param baseStepLength The step length without adaptation.
+ *	@param valueChange The change of the sample value since the previous sample.
+ *	@return The length of the next step.
+ */
+float adaptiveStepLength(float baseStepLength, float valueChange)
+{
+    float homogeneity = 1.0F - clamp(abs(valueChange) / adaptiveStepThreshold, 0.0F, 1.0F);
+    return baseStepLength * mix(1.0F, maxAdaptiveStepScale, homogeneity);
+}
+
 /**
  *	Correct opacity for the current sampling rate
  *
@@ -241,11 +346,9 @@ void mainImage(out vec4 fragColor)
         return;
     }
 
-    float rayStepSize = (bbMax.x - bbMin.x) / float(sampleNum);
+    float rayStepSize = stepScale * (bbMax.x - bbMin.x) / float(sampleNum);
     vec4 finalColor = vec4(0.0F);
     vec3 finalGradient = vec3(0.0F);
-    // ratio between current sampling rate vs. the original sampling rate
-    float opacityCorrectionFactor = 1.0F / (float(sampleNum) * voxelWidth);
     /******************** main raycasting loop *******************/
 
     // For maximum intensity composition
@@ -255,15 +358,34 @@ void mainImage(out vec4 fragColor)
     float sumIntense = 0.0F;
     int hitCount = 0;
 
-    float t = tNear;
+    float tStart = tNear + rayOffset * rayStepSize;
+    float t = tStart;
     int i = 0;
+    float previousValue = -1.0F; // Starts with a step of the base length.
     while(t < tFar && i < sampleNum)
     {
         vec3 pos = camPos + t * rayDir;
         // Use normalized volume coordinate
         vec3 texCoord = pos + 0.5F;
+
+        // Cells that are transparent everywhere add nothing to the accumulated color.
+        if (technique == 0 && isEmptySpace(texCoord))
+        {
+            t = skipEmptySpace(texCoord, rayDir, t, tStart, rayStepSize);
+            previousValue = -1.0F;
+            continue;
+        }
+
         float value = sampleVolume(texCoord);
 
+        // Only the accumulation may skip over samples; the projections need all of them.
+        float stepLength = rayStepSize;
+        if (technique == 0)
+            stepLength = adaptiveStepLength(rayStepSize, value - previousValue);
+
+        // ratio between current sampling rate vs. the original sampling rate
+        float opacityCorrectionFactor = stepLength / voxelWidth;
+
         if (technique == 0)
             accumulation(value, opacityCorrectionFactor, finalColor);
         else if (technique == 1)
@@ -273,7 +395,12 @@ void mainImage(out vec4 fragColor)
         else
             accumulation(value, opacityCorrectionFactor, finalColor);
 
-        t += rayStepSize;
+        // Early ray termination: whatever lies behind is hidden.
+        if (technique == 0 && finalColor.a >= terminationOpacity)
+            break;
+
+        previousValue = value;
+        t += stepLength;
     }
 
 
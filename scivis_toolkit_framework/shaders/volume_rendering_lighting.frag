@@ -10,6 +10,19 @@ in vec2 uv;
 uniform vec2 iResolution;
 uniform float iTime;
 
+// Sampling, set at runtime to trade quality for frame time.
+uniform float stepScale;             // Factor for the step length.
+uniform float maxAdaptiveStepScale;  // Largest extra factor for the step length where the volume barely changes (1: off).
+uniform float adaptiveStepThreshold; // Change of the sample value between two samples from which steps keep their length.
+uniform float terminationOpacity;    // A ray stops once its accumulated opacity reaches this value.
+uniform float rayOffset;             // Offset of the first sample along the ray, in steps. Varied for progressive rendering.
+
+// Gradients baked over the bounding box, see Visualization::opengl_bakeVolumeRenderingLightingGradients().
+uniform bool bakeGradients;           // Write the gradient at (uv, bakeSlice) of the bounding box instead of casting rays.
+uniform float bakeSlice;
+uniform bool usePrecomputedGradients; // Fetch the gradients from gradientSampler instead of estimating them.
+uniform sampler3D gradientSampler;
+
 out vec4 color;
 
 // first three coordinates: center position
@@ -106,6 +119,20 @@ float sampleVolume(vec3 volumeCoord)
     return result;
 }
 
+/**
+ *	Computes the length of the next step along the ray. Steps grow up to maxAdaptiveStepScale times where the volume
+ *	barely changes from one sample to the next, and keep their base length where it changes by adaptiveStepThreshold.
+ *
+ *	@param baseStepLength The step length without adaptation.
+ *	@param valueChange The change of the sample value since the previous sample.
+ *	@return The length of the next step.
+ */
+float adaptiveStepLength(float baseStepLength, float valueChange)
+{
+    float homogeneity = 1.0F - clamp(abs(valueChange) / adaptiveStepThreshold, 0.0F, 1.0F);
+    return baseStepLength * mix(1.0F, maxAdaptiveStepScale, homogeneity);
+}
+
 /**
  *	Evaluates the transfer function for a given sample value
  *
@@ -185,6 +212,53 @@ vec3 gradientIntermediate(vec3 pos)
     return result;
 }
 
+/**
+ *	Returns the gradient at a given position, estimated with the differences selected at the top of this file.
+ *
+ *	@param pos The position from which the gradient should be determined
+ *	@return The gradient at pos.
+ */
+vec3 gradient(vec3 pos)
+{
+    #ifdef USE_INTERMEDIATE
+    return gradientIntermediate(pos);
+    #else
+    #ifdef USE_CENTRAL
+    return gradientCentral(pos);
+    #else
+    return vec3(0.0F);
+    #endif // USE_CENTRAL
+    #endif // USE_INTERMEDIATE
+}
+
+/**
+ *	Returns the baked gradient at a given position: a single texture fetch instead of the samples of the differences.
+ *	Only the direction is kept, which is all the lighting needs.
+ *
+ *	@param pos The position from which the gradient should be determined
+ *	@return The direction of the gradient at pos, or zero where there is none.
+ */
+vec3 precomputedGradient(vec3 pos)
+{
+    vec4 texel = texture(gradientSampler, (pos - bbMin) / (bbMax - bbMin));
+    return (texel.rgb * 2.0F - 1.0F) * texel.a;
+}
+
+/**
+ *	Encodes the gradient at the texel (uv, bakeSlice) of the gradient texture for precomputedGradient().
+ *
+ *	@return The direction of the gradient in rgb (in [0, 1]) and whether there is one in a.
+ */
+vec4 bakeGradient()
+{
+    vec3 grad = gradient(mix(bbMin, bbMax, vec3(uv, bakeSlice)));
+    float magnitude = length(grad);
+    if (!(magnitude > 0.0F))
+        return vec4(0.5F, 0.5F, 0.5F, 0.0F);
+
+    return vec4(grad / magnitude * 0.5F + 0.5F, 1.0F);
+}
+
 /**
  *	Computes the color of the lit surface of an object, using a global
  *	directional light source.
@@ -250,31 +324,34 @@ void mainImage(out vec4 fragColor)
         return;
     }
 
-    vec3 pos = camPos + rayDir * tNear;
-    float rayStepSize = (bbMax.x - bbMin.x) / float(sampleNum);
+    // The transfer function is tuned for sampleNum steps of referenceStepSize through the bounding box.
+    float referenceStepSize = (bbMax.x - bbMin.x) / float(sampleNum);
+    float rayStepSize = stepScale * referenceStepSize;
+    float tEnd = tNear + float(sampleNum) * referenceStepSize;
     vec4 finalColor = vec4(0.0F);
     vec3 finalGradient = vec3(0.0F);
 
     /******************** main raycasting loop *******************/
-    for (int i = 0; i < sampleNum; ++i)
+    float t = tNear + (1.0F - rayOffset) * rayStepSize;
+    float previousValue = -1.0F; // Starts with a step of the base length.
+    while (t < tEnd + 0.5F * rayStepSize)
     {
-        if (finalColor.a > 0.99F)
+        if (finalColor.a >= terminationOpacity)
             break; // early ray termination!
 
-        pos += rayStepSize * rayDir;
+        vec3 pos = camPos + t * rayDir;
         float sampleValue = sampleVolume(pos);
         vec4 color = transferFunction(sampleValue);
 
+        float stepLength = adaptiveStepLength(rayStepSize, sampleValue - previousValue);
+        previousValue = sampleValue;
+        t += stepLength;
+
+        // Opacity correction for the length of this step.
+        color.a = 1.0F - pow(1.0F - color.a, stepLength / referenceStepSize);
+
 
-        #ifdef USE_INTERMEDIATE
-        vec3 grad = gradientIntermediate(pos);
-        #else
-        #ifdef USE_CENTRAL
-        vec3 grad = gradientCentral(pos);
-        #else
-        vec3 grad = vec3(0.0F);
-        #endif // USE_CENTRAL
-        #endif // USE_INTERMEDIATE
+        vec3 grad = usePrecomputedGradients ? precomputedGradient(pos) : gradient(pos);
 
 
      /****************** lighting ********************************/
@@ -291,5 +368,11 @@ void mainImage(out vec4 fragColor)
 
 void main()
 {
+    if (bakeGradients)
+    {
+        color = bakeGradient();
+        return;
+    }
+
     mainImage(color);
 }
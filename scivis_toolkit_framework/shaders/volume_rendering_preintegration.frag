@@ -6,6 +6,26 @@ in vec2 uv;
 uniform vec2 iResolution;
 uniform float iTime;
 uniform sampler3D textureSampler;
+
+// Bricking of the volume in textureSampler, see BrickLayout. A volume that is not bricked is one brick in one cell.
+uniform vec3 brickCount;
+uniform vec3 brickScale;
+uniform vec3 atlasCellCount;
+uniform vec3 atlasCellExtent;
+uniform vec3 atlasGhostOffset;
+uniform vec3 atlasCoreExtent;
+
+// BC4 compressed volume, one layer per z slice (see Bc4Volume). Used instead of textureSampler when isCompressed.
+uniform bool isCompressed;
+uniform sampler2DArray compressedSampler;
+
+// Sampling, set at runtime to trade quality for frame time.
+uniform float stepScale;             // Factor for the step length.
+uniform float maxAdaptiveStepScale;  // Largest extra factor for the step length where the volume barely changes (1: off).
+uniform float adaptiveStepThreshold; // Change of the sample value between two samples from which steps keep their length.
+uniform float terminationOpacity;    // A ray stops once its accumulated opacity reaches this value.
+uniform float rayOffset;             // Offset of the first sample along the ray, in steps. Varied for progressive rendering.
+
 uniform sampler2D lookupTable;
 
 out vec4 color;
@@ -32,6 +52,23 @@ const vec3 colorNode0 = vec3(0.0F, 0.0F, 1.0F);  // blue
 const vec3 colorNode1 = vec3(0.0F, 1.0F, 0.0F); // green
 const vec3 colorNode2 = vec3(1.0F, 0.0F, 0.0F);  // red
 
+/**
+ *	Samples the BC4 compressed volume at a given position inside of it.
+ *
+ *	@param texCoord The position one wants to retrieve the sample of (in world coordinates).
+ *	@return The sample value at the given position.
+ */
+float sampleCompressedVolume(vec3 texCoord)
+{
+    // The layers of an array texture are not filtered with each other, so z is interpolated here.
+    float depth = float(textureSize(compressedSampler, 0).z);
+    float slice = clamp(texCoord.z * depth - 0.5F, 0.0F, depth - 1.0F);
+    float lowerSlice = floor(slice);
+    float lower = texture(compressedSampler, vec3(texCoord.xy, lowerSlice)).r;
+    float upper = texture(compressedSampler, vec3(texCoord.xy, min(lowerSlice + 1.0F, depth - 1.0F))).r;
+    return mix(lower, upper, slice - lowerSlice);
+}
+
 /**
  *	Samples the volume texture at a given position.
  *
@@ -40,7 +77,24 @@ const vec3 colorNode2 = vec3(1.0F, 0.0F, 0.0F);  // red
  */
 float sampleVolume(vec3 texCoord)
 {
-    return texture(textureSampler, texCoord).r;
+    // Outside of the volume, a brick would read its neighbouring cell instead of the border.
+    if (any(lessThan(texCoord, vec3(0.0F))) || any(greaterThan(texCoord, vec3(1.0F))))
+        return 0.0F;
+
+    if (isCompressed)
+        return sampleCompressedVolume(texCoord);
+
+    vec3 brickCoord = texCoord * brickScale;
+    vec3 brick = clamp(floor(brickCoord), vec3(0.0F), brickCount - 1.0F);
+
+    // The bricks fill the cells of the atlas x first, then y, then z.
+    float brickIdx = brick.x + brickCount.x * (brick.y + brickCount.y * brick.z);
+    float row = floor((brickIdx + 0.5F) / atlasCellCount.x);
+    float layer = floor((row + 0.5F) / atlasCellCount.y);
+    vec3 cell = vec3(brickIdx - row * atlasCellCount.x, row - layer * atlasCellCount.y, layer);
+
+    vec3 atlasCoord = cell * atlasCellExtent + atlasGhostOffset + (brickCoord - brick) * atlasCoreExtent;
+    return texture(textureSampler, atlasCoord).r;
 }
 
 /**
@@ -101,6 +155,20 @@ bool intersectBoundingBox(vec3 rayOrig, vec3 rayDir, out float tNear, out float
     return smallestTMax > largestTMin;
 }
 
+/**
+ *	Computes the length of the next step along the ray. Steps grow up to maxAdaptiveStepScale times where the volume
+ *	barely changes from one sample to the next, and keep their base length where it changes by adaptiveStepThreshold.
+ *
+ *	@param baseStepLength The step length without adaptation.
+ *	@param valueChange The change of the sample value since the previous sample.
+ *	@return The length of the next step.
+ */
+float adaptiveStepLength(float baseStepLength, float valueChange)
+{
+    float homogeneity = 1.0F - clamp(abs(valueChange) / adaptiveStepThreshold, 0.0F, 1.0F);
+    return baseStepLength * mix(1.0F, maxAdaptiveStepScale, homogeneity);
+}
+
 /**
  *	Correct opacity for the current sampling rate
  *
@@ -179,11 +247,9 @@ void mainImage(out vec4 fragColor)
         return;
     }
 
-    float rayStepSize = (bbMax.x - bbMin.x) / float(sampleNum);
+    float rayStepSize = stepScale * (bbMax.x - bbMin.x) / float(sampleNum);
     vec4 finalColor = vec4(0.0F);
     vec3 finalGradient = vec3(0.0F);
-    // ratio between current sampling rate vs. the original sampling rate
-    float opacityCorrectionFactor = 1.0F / (float(sampleNum) * voxelWidth);
     
     /******************** main raycasting loop *******************/
 
@@ -194,8 +260,10 @@ void mainImage(out vec4 fragColor)
     float sumIntense = 0.0F;
     int hitCount = 0;
 
-    float t = tNear;
+    float tStart = tNear + rayOffset * rayStepSize;
+    float t = tStart;
     int i = 0;
+    float previousValue = -1.0F; // Starts with a step of the base length.
     while(t < tFar && i < sampleNum)
     {
         vec3 pos = camPos + t * rayDir;
@@ -203,13 +271,22 @@ void mainImage(out vec4 fragColor)
         vec3 texCoord = pos + 0.5F; // Use normalized volume coordinate
         float value = sampleVolume(texCoord);
 
+        float stepLength = adaptiveStepLength(rayStepSize, value - previousValue);
+        // ratio between current sampling rate vs. the original sampling rate
+        float opacityCorrectionFactor = stepLength / voxelWidth;
+
         // TODO: Modify to use the pre-integration table you generated in the previous sub-task.
         // Here available as the 2D texture "lookupTable".
         finalColor += texture(lookupTable, vec2(0.5F, 0.5F)) * 0.0001F; // placeholder
 
         accumulation(value, opacityCorrectionFactor, finalColor);
 
-        t += rayStepSize;
+        // Early ray termination: whatever lies behind is hidden.
+        if (finalColor.a >= terminationOpacity)
+            break;
+
+        previousValue = value;
+        t += stepLength;
     }
 
     fragColor.rgb = mix(background.rgb, finalColor.rgb, finalColor.a);
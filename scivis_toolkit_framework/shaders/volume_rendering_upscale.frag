@@ -0,0 +1,45 @@
+#version 330 core
+// volume_rendering_upscale fragment shader, upscales the reduced resolution volume rendering with a bilateral filter
+
+in vec2 uv;
+
+uniform sampler2D image;
+
+out vec4 color;
+
+// Standard deviations of the spatial weights (in texels of image) and of the range weights (in color).
+const float spatialSigma = 0.6F;
+const float rangeSigma = 0.1F;
+
+void main()
+{
+    vec2 size = vec2(textureSize(image, 0));
+    vec2 position = uv * size - 0.5F; // In texels, relative to the centre of the first one.
+    vec2 base = floor(position);
+
+    // The texel that covers this pixel is the reference of the range weights: neighbours of a different color, i.e. on
+    // the other side of an edge, barely contribute, so edges stay sharp while smooth regions are interpolated.
+    vec4 reference = texelFetch(image, ivec2(clamp(floor(uv * size), vec2(0.0F), size - 1.0F)), 0);
+
+    vec4 sum = vec4(0.0F);
+    float weightSum = 0.0F;
+    for (int y = -1; y <= 2; ++y)
+    {
+        for (int x = -1; x <= 2; ++x)
+        {
+            vec2 texel = base + vec2(x, y);
+            vec4 sampleColor = texelFetch(image, ivec2(clamp(texel, vec2(0.0F), size - 1.0F)), 0);
+
+            vec2 offset = texel - position;
+            vec4 difference = sampleColor - reference;
+            float weight = exp(-dot(offset, offset) / (2.0F * spatialSigma * spatialSigma)
+                               - dot(difference, difference) / (2.0F * rangeSigma * rangeSigma));
+
+            sum += weight * sampleColor;
+            weightSum += weight;
+        }
+    }
+
+    // The reference texel is always among the samples, so weightSum does not vanish.
+    color = sum / weightSum;
+}
@@ -1,9 +1,11 @@
 #include "simulation.h"
 
+#include "advection.h"
 #include "interpolation.h"
 
 #include <QDebug>
 
+#include <algorithm>
 #include <cmath>
 
 #include <fstream> // load data
@@ -12,15 +14,24 @@
 //                 Although the simulation takes place on a 2D grid, we allocate all data structures as 1D arrays.
 Simulation::Simulation(size_t const DIM)
     :
-      m_DIM(DIM)
+      Simulation(DIM, DIM)
+{
+}
+
+Simulation::Simulation(size_t const DIMX, size_t const DIMY)
+    :
+      m_DIMX(DIMX),
+      m_DIMY(DIMY),
+      m_threadPool(std::make_shared<ThreadPool>(ThreadPool::hardwareThreadCount()))
 {
     initializeDataStructures();
 }
 
-void Simulation::initializeDimensions(size_t const DIM)
+void Simulation::initializeDimensions(size_t const DIMX, size_t const DIMY)
 {
-    m_DIM = DIM;
-    m_numberOfSamples = m_DIM * m_DIM;
+    m_DIMX = DIMX;
+    m_DIMY = DIMY;
+    m_numberOfSamples = m_DIMX * m_DIMY;
     m_numberOfSamplesLong = static_cast<long>(m_numberOfSamples);
 }
 
@@ -36,11 +47,9 @@ void Simulation::initializeDataStructures()
     m_vx0.resize(m_numberOfSamples, 0.0F);
     m_vy0.resize(m_numberOfSamples, 0.0F);
 
-    // Set pocketfft parameters
-    m_shapeIn = {m_DIM, m_DIM};
-    m_strideIn = {static_cast<long>(m_DIM * sizeof(float)), sizeof(float)};
-    m_strideOut = {static_cast<long>((m_DIM + 2U) * sizeof(float)), sizeof(std::complex<float>)};
-    m_axes = {0U, 1U};
+    // Plan the FFTs and allocate the spectral buffers for the current grid size.
+    m_fft.resize(m_DIMX, m_DIMY, m_threadPool->threadCount());
+    m_spectralDerivatives.resize(m_DIMX, m_DIMY);
 }
 
 void Simulation::resetData()
@@ -54,157 +63,164 @@ void Simulation::resetData()
     std::fill(m_vy.begin(), m_vy.end(), 0.0F);
     std::fill(m_vx0.begin(), m_vx0.end(), 0.0F);
     std::fill(m_vy0.begin(), m_vy0.end(), 0.0F);
+
+    m_forceRowBegin = 0U;
+    m_forceRowEnd = 0U;
+    m_speedMaxima.clear();
+    m_spectralDerivatives.reset();
 }
 
 void Simulation::solve()
 {
-    // n is an integer alias for m_DIM.
-    auto const n = static_cast<int>(m_DIM);
-
-    auto const applyTimeStep = [this](float const v, float const v0) { return v + m_dt * v0; };
-    std::transform(m_vx.cbegin(), m_vx.cend(), m_vx0.cbegin(), m_vx.begin(), applyTimeStep);
-    std::transform(m_vy.cbegin(), m_vy.cend(), m_vy0.cbegin(), m_vy.begin(), applyTimeStep);
-
-    // Copy the current velocity field to the previous velocity field
-    m_vx0 = m_vx;
-    m_vy0 = m_vy;
+    // Integer aliases for m_DIMX and m_DIMY.
+    auto const width = static_cast<int>(m_DIMX);
+    auto const height = static_cast<int>(m_DIMY);
+    ThreadPool &threadPool = *m_threadPool;
 
+    // The forces have been applied and the velocity field copied to the previous one by set_forces.
+    // The rows are split between the threads.
+    threadPool.parallelFor(0U, m_DIMY, [=](size_t const begin, size_t const end, size_t)
     {
-        // Pointer aliases for simpler C-style access
-        float * const vx  = m_vx.data();
-        float * const vy  = m_vy.data();
-        float * const vx0 = m_vx0.data();
-        float * const vy0 = m_vy0.data();
-
-        for (int i = 0; i < n; ++i)
-        {
-            float const x = (0.5F / n) + i * (1.0F / n);
-            for (int j = 0; j < n; ++j)
-            {
-                float const y = (0.5F / n) + j * (1.0F / n);
-
-                float const x0 = n * (x - m_dt * vx0[i + n * j]) - 0.5F;
-                float const y0 = n * (y - m_dt * vy0[i + n * j]) - 0.5F;
-
-                auto i0 = static_cast<int>(std::floor(x0));
-                float const s = x0 - i0;
-                i0 = (n + (i0 % n)) % n;
-                int const i1 = (i0 + 1) % n;
-
-                auto j0 = static_cast<int>(std::floor(y0));
-                float const t = y0 - j0;
-                j0 = (n + (j0 % n)) % n;
-                int const j1 = (j0 + 1) % n;
-
-                vx[i + n * j] = (1 - s) * ((1 - t) * vx0[i0 + n * j0]
-                              + t * vx0[i0 + n * j1])
-                              + s * ((1 - t) * vx0[i1 + n * j0]
-                              + t * vx0[i1 + n * j1]);
-
-                vy[i + n * j] = (1 - s) * ((1 - t) * vy0[i0 + n * j0]
-                              + t * vy0[i0 + n * j1])
-                              + s * ((1 - t) * vy0[i1 + n * j0]
-                              + t * vy0[i1 + n * j1]);
-            }
-        }
-    }
+        advection::advectRows(width, height, m_dt, m_vx0.data(), m_vy0.data(),
+                              m_vx0.data(), m_vx.data(),
+                              m_vy0.data(), m_vy.data(),
+                              static_cast<int>(begin), static_cast<int>(end));
+    });
 
-    // Copy the current velocity field to the previous velocity field
-    m_vx0 = m_vx;
-    m_vy0 = m_vy;
+    std::complex<float> * const vx0_fft = m_fft.spectrumX().data();
+    std::complex<float> * const vy0_fft = m_fft.spectrumY().data();
 
-    std::vector<std::complex<float>> vx0_fft(m_DIM * (m_DIM / 2U + 1U));
-    std::vector<std::complex<float>> vy0_fft(m_DIM * (m_DIM / 2U + 1U));
+    m_fft.forward(m_vx.data(), vx0_fft, threadPool);
+    m_fft.forward(m_vy.data(), vy0_fft, threadPool);
 
-    pocketfft::r2c(m_shapeIn, m_strideIn, m_strideOut, m_axes, true, m_vx0.data(), vx0_fft.data(), 1.0F);
-    pocketfft::r2c(m_shapeIn, m_strideIn, m_strideOut, m_axes, true, m_vy0.data(), vy0_fft.data(), 1.0F);
+    // The derived fields reuse the spectra, before and after the projection.
+    float const normalizationFactor = 1.0F / static_cast<float>(m_DIMX * m_DIMY);
+    m_spectralDerivatives.computeUnprojected(vx0_fft, vy0_fft, normalizationFactor, m_fft, threadPool);
 
-    for (size_t j = 0U; j < m_DIM; ++j)
+    // Viscosity and projection. The filter coefficients are only recomputed when dt or the viscosity changed.
+    m_spectralFilter.update(m_DIMX, m_DIMY, m_dt, m_viscosity);
+    threadPool.parallelFor(0U, m_spectralFilter.size() / 2U, [=](size_t const begin, size_t const end, size_t)
     {
-        size_t const m = (m_DIM / 2U) + 1U; // Number of columns in the FFT matrix
-        for (size_t i = 0U; i < m; ++i)
-        {
-            auto const x = static_cast<float>(i);
-            float const y = j <= (m_DIM / 2U) ? static_cast<float>(j) : static_cast<float>(j) - static_cast<float>(m_DIM);
-            float const r = std::pow(x, 2.0F) + std::pow(y, 2.0F);
-            if (r == 0.0F)
-                continue;
+        m_spectralFilter.apply(vx0_fft, vy0_fft, 2U * begin, 2U * end);
+    });
 
-            size_t const idx = i + (m * j);
+    m_spectralDerivatives.computeProjected(vx0_fft, vy0_fft, normalizationFactor, m_fft, threadPool);
+    m_fft.backward(vx0_fft, m_vx.data(), normalizationFactor, threadPool);
+    m_fft.backward(vy0_fft, m_vy.data(), normalizationFactor, threadPool);
+}
 
-            std::complex<float> const U{vx0_fft[idx]};
-            std::complex<float> const V{vy0_fft[idx]};
+// Takes the derived fields from the spectra of the current velocity, outside of a step. The velocity is the result of a
+// projection already, or zero.
+void Simulation::updateSpectralDerivatives()
+{
+    if (m_spectralDerivatives.fields() == 0U)
+        return;
 
-            float const filterFactor = std::exp(-r * m_dt * m_viscosity);
-            vx0_fft[idx] = filterFactor * ((1.0F - x * x / r) * U - x * y / r * V);
-            vy0_fft[idx] = filterFactor * (-y * x / r * U + (1.0F - y * y / r) * V);
-        }
-    }
+    ThreadPool &threadPool = *m_threadPool;
+    std::complex<float> * const vx_fft = m_fft.spectrumX().data();
+    std::complex<float> * const vy_fft = m_fft.spectrumY().data();
+    m_fft.forward(m_vx.data(), vx_fft, threadPool);
+    m_fft.forward(m_vy.data(), vy_fft, threadPool);
 
-    float const normalizationFactor = 1.0F / static_cast<float>(m_DIM * m_DIM);
-    // Note: stride_in and stride_out are now reversed
-    pocketfft::c2r(m_shapeIn, m_strideOut, m_strideIn, m_axes, false, vx0_fft.data(), m_vx.data(), normalizationFactor);
-    pocketfft::c2r(m_shapeIn, m_strideOut, m_strideIn, m_axes, false, vy0_fft.data(), m_vy.data(), normalizationFactor);
+    float const normalizationFactor = 1.0F / static_cast<float>(m_DIMX * m_DIMY);
+    m_spectralDerivatives.computeUnprojected(vx_fft, vy_fft, normalizationFactor, m_fft, threadPool);
+    m_spectralDerivatives.computeProjected(vx_fft, vy_fft, normalizationFactor, m_fft, threadPool);
 }
 
 // diffuse_matter: This function diffuses matter that has been placed in the velocity field. It's almost identical to the
 // velocity diffusion step in the function above. The input matter densities are in m_rho0 and the result is written into m_rho.
 void Simulation::diffuse_matter()
 {
-    // n is an integer alias for m_DIM.
-    int const n = static_cast<int>(m_DIM);
-
-    // Use the underlying pointer to access the elements using integers/longs instead of size_t and casts.
-    float * const vx  = m_vx.data();
-    float * const vy  = m_vy.data();
-    float * const rho = m_rho.data();
-    float * const rho0 = m_rho0.data();
+    // Integer aliases for m_DIMX and m_DIMY.
+    auto const width = static_cast<int>(m_DIMX);
+    auto const height = static_cast<int>(m_DIMY);
 
-    float x, y, x0, y0, s, t;
-    int i, j, i0, j0, i1, j1;
+    // The rows are split between the threads.
+    m_threadPool->parallelFor(0U, m_DIMY, [=](size_t const begin, size_t const end, size_t)
+    {
+        advection::advectRows(width, height, m_dt, m_vx.data(), m_vy.data(),
+                              m_rho0.data(), m_rho.data(),
+                              static_cast<int>(begin), static_cast<int>(end));
+    });
+}
 
-    for (j = 0, y = 0.5F / n; j < n; ++j, y += 1.0F / n)
+//set_forces: dampen the user-controlled forces and matter density to get a stable simulation, apply the forces to the
+//            velocity field for one time step and copy it to the previous velocity field for the solver.
+//            All of this is one pass over the grid; the forces are only touched in the rows where they are nonzero.
+void Simulation::set_forces()
+{
+    m_forceMaxima.assign(m_threadPool->threadCount(), 0.0F);
+    m_speedMaxima.assign(m_threadPool->threadCount(), 0.0F);
+    m_threadPool->parallelFor(0U, m_DIMY, [this](size_t const beginRow, size_t const endRow, size_t const thread)
     {
-        for (i = 0, x = 0.5F / n; i < n ; ++i, x += 1.0F / n)
+        for (size_t row = beginRow; row < endRow; ++row)
         {
-            x0 = n * (x - m_dt * vx[i + n * j]) - 0.5F;
-            y0 = n * (y - m_dt * vy[i + n * j]) - 0.5F;
-            i0 = static_cast<int>(std::floor(x0));
-            s = x0 - i0;
-            i0 = (n + (i0 % n)) % n;
-            i1 = (i0 + 1) % n;
-            j0 = static_cast<int>(std::floor(y0));
-            t = y0 - j0;
-            j0 = (n + (j0 % n)) % n;
-            j1 = (j0 + 1) % n;
-            rho[i + n * j] = (1 - s) * ((1 - t) * rho0[i0 + n * j0]
-                           + t * rho0[i0 + n * j1])
-                           + s * ((1 - t) * rho0[i1 + n * j0]
-                           + t * rho0[i1 + n * j1]);
+            size_t const begin = row * m_DIMX;
+            size_t const end = begin + m_DIMX;
+
+            // Reduce density and copy to current density.
+            for (size_t idx = begin; idx < end; ++idx)
+                m_rho0[idx] = 0.995F * m_rho[idx];
+
+            if (row >= m_forceRowBegin && row < m_forceRowEnd)
+            {
+                float forceMaximum = 0.0F;
+                for (size_t idx = begin; idx < end; ++idx)
+                {
+                    // Reduce force and apply it.
+                    m_fx[idx] *= 0.85F;
+                    m_fy[idx] *= 0.85F;
+                    m_vx[idx] += m_dt * m_fx[idx];
+                    m_vy[idx] += m_dt * m_fy[idx];
+                    forceMaximum = std::max({forceMaximum, std::abs(m_fx[idx]), std::abs(m_fy[idx])});
+                }
+                m_forceMaxima[thread] = std::max(m_forceMaxima[thread], forceMaximum);
+            }
+
+            // Copy the current velocity field to the previous velocity field.
+            float speedMaximum = 0.0F;
+            for (size_t idx = begin; idx < end; ++idx)
+            {
+                m_vx0[idx] = m_vx[idx];
+                m_vy0[idx] = m_vy[idx];
+                speedMaximum = std::max(speedMaximum, m_vx[idx] * m_vx[idx] + m_vy[idx] * m_vy[idx]);
+            }
+            m_speedMaxima[thread] = std::max(m_speedMaxima[thread], speedMaximum);
         }
+    });
+
+    // Forces that have decayed below epsilon are dropped, after which the forces cost nothing until the next drag.
+    if (m_forceRowBegin < m_forceRowEnd
+        && *std::max_element(m_forceMaxima.cbegin(), m_forceMaxima.cend()) < s_forceEpsilon)
+    {
+        std::fill(m_fx.begin() + static_cast<long>(m_forceRowBegin * m_DIMX),
+                  m_fx.begin() + static_cast<long>(m_forceRowEnd * m_DIMX), 0.0F);
+        std::fill(m_fy.begin() + static_cast<long>(m_forceRowBegin * m_DIMX),
+                  m_fy.begin() + static_cast<long>(m_forceRowEnd * m_DIMX), 0.0F);
+        m_forceRowBegin = 0U;
+        m_forceRowEnd = 0U;
     }
 }
 
-//set_forces: copy user-controlled forces to the force vectors that are sent to the solver.
-//            Also dampen forces and matter density to get a stable simulation.
-void Simulation::set_forces()
+// Extends the rows of nonzero forces by the row of sample idx.
+void Simulation::activateForceRow(size_t const idx)
 {
-    // Reduce density and copy to current density.
-    std::transform(m_rho.cbegin(), m_rho.cend(), m_rho0.begin(), [] (auto const e) { return 0.995F * e; });
-
-    // Reduce force.
-    std::transform(m_fx.cbegin(), m_fx.cend(), m_fx.begin(), [] (auto const e) { return 0.85F * e; });
-    std::transform(m_fy.cbegin(), m_fy.cend(), m_fy.begin(), [] (auto const e) { return 0.85F * e; });
+    size_t const row = idx / m_DIMX;
+    if (m_forceRowBegin == m_forceRowEnd)
+    {
+        m_forceRowBegin = row;
+        m_forceRowEnd = row + 1U;
+        return;
+    }
 
-    // Copy forces to velocities.
-    std::copy(m_fx.cbegin(), m_fx.cend(), m_vx0.begin());
-    std::copy(m_fy.cbegin(), m_fy.cend(), m_vy0.begin());
+    m_forceRowBegin = std::min(m_forceRowBegin, row);
+    m_forceRowEnd = std::max(m_forceRowEnd, row + 1U);
 }
 
 // doOneSimulationStep: Do one complete cycle of the simulation:
-//      - set_forces:
-//      - solve:            read forces from the user
-//      - diffuse_matter:   compute a new set of velocities
+//      - set_forces:       read forces from the user and apply them
+//      - solve:            compute a new set of velocities
+//      - diffuse_matter:   move the matter along with them
 //      - gluPostRedisplay: draw a new visualization frame
 
 void Simulation::doOneSimulationStep()
@@ -214,16 +230,64 @@ void Simulation::doOneSimulationStep()
     diffuse_matter();
 }
 
+void Simulation::copyState(State &state) const
+{
+    state.DIMX = m_DIMX;
+    state.DIMY = m_DIMY;
+    state.dt = m_dt;
+    state.viscosity = m_viscosity;
+    state.rhoInjected = m_rhoInjected;
+    state.forceRowBegin = m_forceRowBegin;
+    state.forceRowEnd = m_forceRowEnd;
+    state.rho.assign(m_rho.cbegin(), m_rho.cend());
+    state.vx.assign(m_vx.cbegin(), m_vx.cend());
+    state.vy.assign(m_vy.cbegin(), m_vy.cend());
+    state.fx.assign(m_fx.cbegin(), m_fx.cend());
+    state.fy.assign(m_fy.cbegin(), m_fy.cend());
+}
+
+// The previous fields and the maximum speed are not part of the state: set_forces overwrites them before they are read.
+void Simulation::setState(State const &state)
+{
+    if (state.DIMX != m_DIMX || state.DIMY != m_DIMY)
+        setDIM(state.DIMX, state.DIMY);
+    else
+        resetData();
+
+    m_dt = state.dt;
+    m_viscosity = state.viscosity;
+    m_rhoInjected = state.rhoInjected;
+    m_forceRowBegin = state.forceRowBegin;
+    m_forceRowEnd = state.forceRowEnd;
+    std::copy(state.rho.cbegin(), state.rho.cend(), m_rho.begin());
+    std::copy(state.vx.cbegin(), state.vx.cend(), m_vx.begin());
+    std::copy(state.vy.cbegin(), state.vy.cend(), m_vy.begin());
+    std::copy(state.fx.cbegin(), state.fx.cend(), m_fx.begin());
+    std::copy(state.fy.cbegin(), state.fy.cend(), m_fy.begin());
+
+    updateSpectralDerivatives();
+}
+
 
 // Getters
-std::vector<float> Simulation::density() const
+size_t Simulation::DIMX() const
+{
+    return m_DIMX;
+}
+
+size_t Simulation::DIMY() const
+{
+    return m_DIMY;
+}
+
+std::vector<float> const &Simulation::density() const
 {
     return m_rho;
 }
 
 std::vector<float> Simulation::densityInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(m_rho, m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(m_rho, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 std::vector<float> const &Simulation::velocityX() const
@@ -238,32 +302,42 @@ std::vector<float> const &Simulation::velocityY() const
 
 std::vector<float> Simulation::velocityXInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(m_vx, m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(m_vx, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 std::vector<float> Simulation::velocityYInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(m_vy, m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(m_vy, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 std::vector<float> Simulation::velocityMagnitudeInterpolated(size_t const numberOfRows, size_t const numberOfColums) const
 {
-    return interpolation::interpolateSquareVector(velocityMagnitude(), m_DIM, numberOfRows, numberOfColums);
+    return interpolation::interpolateGridVector(velocityMagnitude(), m_DIMX, m_DIMY, numberOfRows, numberOfColums);
+}
+
+std::vector<float> const &Simulation::forceFieldX() const
+{
+    return m_fx;
+}
+
+std::vector<float> const &Simulation::forceFieldY() const
+{
+    return m_fy;
 }
 
 std::vector<float> Simulation::forceFieldXInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(m_fx, m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(m_fx, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 std::vector<float> Simulation::forceFieldYInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(m_fy, m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(m_fy, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 std::vector<float> Simulation::forceFieldMagnitudeInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
 {
-    return interpolation::interpolateSquareVector(forceFieldMagnitude(), m_DIM, numberOfRows, numberOfColumns);
+    return interpolation::interpolateGridVector(forceFieldMagnitude(), m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
 }
 
 // Note that the dimensions of m_vx and m_vy are larger than what is returned.
@@ -290,6 +364,31 @@ std::vector<float> Simulation::forceFieldMagnitude() const
    return forceFieldMagnitude;
 }
 
+std::vector<float> const &Simulation::vorticity() const
+{
+    return m_spectralDerivatives.vorticity();
+}
+
+std::vector<float> const &Simulation::unprojectedDivergence() const
+{
+    return m_spectralDerivatives.divergence();
+}
+
+std::vector<float> const &Simulation::qCriterion() const
+{
+    return m_spectralDerivatives.qCriterion();
+}
+
+unsigned int Simulation::spectralFields() const
+{
+    return m_spectralDerivatives.fields();
+}
+
+size_t Simulation::threadCount() const
+{
+    return m_threadPool->threadCount();
+}
+
 float Simulation::dt() const
 {
     return m_dt;
@@ -305,6 +404,14 @@ float Simulation::rhoInjected() const
     return m_rhoInjected;
 }
 
+float Simulation::maxSpeed() const
+{
+    if (m_speedMaxima.empty())
+        return 0.0F;
+
+    return std::sqrt(*std::max_element(m_speedMaxima.cbegin(), m_speedMaxima.cend()));
+}
+
 float Simulation::vx(size_t const idx) const
 {
     return m_vx[idx];
@@ -343,11 +450,36 @@ float Simulation::rho(size_t const idx) const
 // Setters
 void Simulation::setDIM(size_t const DIM)
 {
-    initializeDimensions(DIM);
+    setDIM(DIM, DIM);
+}
+
+void Simulation::setDIM(size_t const DIMX, size_t const DIMY)
+{
+    initializeDimensions(DIMX, DIMY);
     initializeDataStructures();
     resetData();
 }
 
+// Sets the number of threads used by a simulation step. Zero selects the number of hardware threads.
+void Simulation::setThreadCount(size_t const threadCount)
+{
+    size_t const count = threadCount == 0U ? ThreadPool::hardwareThreadCount() : threadCount;
+    if (count == m_threadPool->threadCount())
+        return;
+
+    m_threadPool = std::make_shared<ThreadPool>(count);
+    m_fft.resize(m_DIMX, m_DIMY, count);
+}
+
+void Simulation::setSpectralFields(unsigned int const fields)
+{
+    if (fields == m_spectralDerivatives.fields())
+        return;
+
+    m_spectralDerivatives.setFields(fields);
+    updateSpectralDerivatives();
+}
+
 void Simulation::setDt(float const dt)
 {
     m_dt = dt;
@@ -366,11 +498,13 @@ void Simulation::setRhoInjected(float const rhoInjected)
 void Simulation::setFx(size_t const idx, float const force)
 {
     m_fx[idx] = force;
+    activateForceRow(idx);
 }
 
 void Simulation::setFy(size_t const idx, float const force)
 {
     m_fy[idx] = force;
+    activateForceRow(idx);
 }
 
 void Simulation::setRho(size_t const idx, float const smokeDensity)
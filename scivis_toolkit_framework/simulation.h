@@ -1,15 +1,20 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
-#include "pocketfft_hdronly.h"
+#include "fftworkspace.h"
+#include "spectralderivatives.h"
+#include "spectralfilter.h"
+#include "threadpool.h"
 
+#include <memory>
 #include <vector>
 
 class Simulation
 {
     //--- SIMULATION PARAMETERS ------------------------------------------------------------------------
-    size_t m_DIM;                 // Size of simulation grid.
-    size_t m_numberOfSamples = m_DIM * m_DIM;
+    size_t m_DIMX;                // Width of simulation grid.
+    size_t m_DIMY;                // Height of simulation grid. The cells are square, see SpectralFilter.
+    size_t m_numberOfSamples = m_DIMX * m_DIMY;
     long m_numberOfSamplesLong = static_cast<long>(m_numberOfSamples);
 
     float m_dt = 0.4F;                  // Simulation time step.
@@ -20,17 +25,32 @@ class Simulation
     std::vector<float> m_vx0, m_vy0;    // (vx0,vy0) = velocity field at the previous moment.
     std::vector<float> m_fx, m_fy;      // (fx,fy)   = user-controlled simulation forces, steered with the mouse.
     std::vector<float> m_rho, m_rho0;   // Smoke density at the current (rho) and previous (rho0) moment.
-
-    // pocketfft parameters
-    pocketfft::shape_t m_shapeIn;
-    pocketfft::stride_t m_strideIn;
-    pocketfft::stride_t m_strideOut;
-    pocketfft::shape_t m_axes;
+    // All of these stay float32, also with FieldPrecision::Float16, which applies to the published SimulationFrames
+    // only. The density and forces are state that every step reads, decays and writes back, so storing them as halves
+    // would round them again every step, and the 11-bit mantissa would let that error accumulate over a run; the
+    // decaying forces would drop below the normal half range (6e-5) long before s_forceEpsilon. The frames, of which
+    // there are three and which are copied after every step, hold most of the field memory and copy traffic.
+
+    // The forces decay every step, so they are nonzero in the rows touched by the mouse only, and only until they have
+    // decayed below s_forceEpsilon. Outside of [m_forceRowBegin, m_forceRowEnd) they are exactly 0.
+    size_t m_forceRowBegin = 0U;
+    size_t m_forceRowEnd = 0U;
+    std::vector<float> m_forceMaxima;   // Largest remaining force per thread of the last step.
+    std::vector<float> m_speedMaxima;   // Largest squared speed per thread of the last step, see maxSpeed.
+    static constexpr float s_forceEpsilon = 1e-6F;
+
+    // Worker threads for the simulation step. Shared by copies of the simulation; ThreadPool serializes its users.
+    std::shared_ptr<ThreadPool> m_threadPool;
+
+    // FFT plans and spectral buffers, reused by every call to solve().
+    FftWorkspace m_fft;
+    SpectralFilter m_spectralFilter;
+    SpectralDerivatives m_spectralDerivatives;
 
     // Functions
 
     // Data management
-    void initializeDimensions(size_t const DIM);
+    void initializeDimensions(size_t const DIMX, size_t const DIMY);
     void initializeDataStructures();
     void resetData();
 
@@ -38,10 +58,27 @@ class Simulation
     void solve();
     void diffuse_matter();
     void set_forces();
+    void activateForceRow(size_t const idx);
+    void updateSpectralDerivatives();
 
 public:
+    // Everything a step depends on, so a simulation restored from it continues exactly like the one it was copied from.
+    // The fields are row-major DIMX * DIMY grids.
+    struct State
+    {
+        size_t DIMX = 0U;
+        size_t DIMY = 0U;
+        float dt = 0.0F;
+        float viscosity = 0.0F;
+        float rhoInjected = 0.0F;
+        size_t forceRowBegin = 0U;
+        size_t forceRowEnd = 0U;
+        std::vector<float> rho, vx, vy, fx, fy;
+    };
+
     // Functions
     Simulation(size_t const DIM);
+    Simulation(size_t const DIMX, size_t const DIMY);
     Simulation(Simulation const&) = default;
     Simulation& operator=(Simulation const&) = default;
     Simulation(Simulation&&) = default;
@@ -50,8 +87,16 @@ public:
 
     void doOneSimulationStep();
 
+    // Copies into the vectors of state, which keep their capacity.
+    void copyState(State &state) const;
+    // Resizes the grid if needed. The thread count is kept.
+    void setState(State const &state);
+
     // Getters
-    [[nodiscard]] std::vector<float> density() const;
+    [[nodiscard]] size_t DIMX() const;
+    [[nodiscard]] size_t DIMY() const;
+
+    [[nodiscard]] std::vector<float> const &density() const;
     [[nodiscard]] std::vector<float> densityInterpolated(size_t const numberOfRows,
                                                          size_t const numberOfColumns) const;
 
@@ -67,6 +112,9 @@ public:
     [[nodiscard]] std::vector<float> velocityMagnitudeInterpolated(
         size_t const numberOfRows, size_t const numberOfColums) const;
 
+    [[nodiscard]] std::vector<float> const &forceFieldX() const;
+    [[nodiscard]] std::vector<float> const &forceFieldY() const;
+
     [[nodiscard]] std::vector<float> forceFieldXInterpolated(size_t const numberOfRows,
                                                              size_t const numberOfColumns) const;
     [[nodiscard]] std::vector<float> forceFieldYInterpolated(size_t const numberOfRows,
@@ -76,9 +124,20 @@ public:
     [[nodiscard]] std::vector<float> forceFieldMagnitudeInterpolated(
         size_t const numberOfRows, size_t const numberOfColumns) const;
 
+    // The fields of SpectralDerivatives, of the velocity of the last step. Empty unless selected.
+    [[nodiscard]] std::vector<float> const &vorticity() const;
+    [[nodiscard]] std::vector<float> const &unprojectedDivergence() const;
+    [[nodiscard]] std::vector<float> const &qCriterion() const;
+    [[nodiscard]] unsigned int spectralFields() const;
+
+    [[nodiscard]] size_t threadCount() const;
+
     [[nodiscard]] float dt() const;
     [[nodiscard]] float viscosity() const;
     [[nodiscard]] float rhoInjected() const;
+    // The largest speed of the last step, after the forces were applied and before the advection. Free, as it is
+    // taken in the pass of set_forces.
+    [[nodiscard]] float maxSpeed() const;
 
     [[nodiscard]] float vx(size_t const idx) const;
     [[nodiscard]] float vy(size_t const idx) const;
@@ -91,6 +150,13 @@ public:
 
     // Setters
     void setDIM(size_t const DIM);
+    void setDIM(size_t const DIMX, size_t const DIMY);
+
+    void setThreadCount(size_t const threadCount);
+
+    // A combination of the SpectralDerivatives flags. Newly selected fields are computed from the current velocity at
+    // once, the divergence before the projection being the one left after the last projection.
+    void setSpectralFields(unsigned int const fields);
 
     void setDt(float const dt);
     void setViscosity(float const viscosity);
@@ -0,0 +1,212 @@
+#include "simulationframe.h"
+
+#include "interpolation.h"
+#include "simulation.h"
+
+namespace
+{
+    std::vector<float> toFloats(std::vector<HalfFloat::Bits> const &halves)
+    {
+        std::vector<float> values;
+        HalfFloat::toFloats(halves, values);
+        return values;
+    }
+}
+
+// Copies the fields of the simulation into this frame. The buffers are reused when the grid size and precision are
+// unchanged; the buffers of the other precision are released.
+void SimulationFrame::copyFrom(Simulation const &simulation, size_t const step, size_t const frameNumber,
+                               FieldPrecision const precision)
+{
+    m_step = step;
+    m_frameNumber = frameNumber;
+    m_DIMX = simulation.DIMX();
+    m_DIMY = simulation.DIMY();
+    m_precision = precision;
+
+    m_vx = simulation.velocityX();
+    m_vy = simulation.velocityY();
+
+    unsigned int const spectralFields = simulation.spectralFields();
+    auto const copySpectralField = [spectralFields](std::vector<float> &field, std::vector<float> const &source,
+                                                    unsigned int const flag)
+    {
+        if ((spectralFields & flag) != 0U)
+            field = source;
+        else
+            field = {};
+    };
+    copySpectralField(m_vorticity, simulation.vorticity(), SpectralDerivatives::s_vorticity);
+    copySpectralField(m_unprojectedDivergence, simulation.unprojectedDivergence(), SpectralDerivatives::s_divergence);
+    copySpectralField(m_qCriterion, simulation.qCriterion(), SpectralDerivatives::s_qCriterion);
+
+    switch (precision)
+    {
+        case FieldPrecision::Float32:
+            m_rho = simulation.density();
+            m_fx = simulation.forceFieldX();
+            m_fy = simulation.forceFieldY();
+            m_rhoHalf = {};
+            m_fxHalf = {};
+            m_fyHalf = {};
+        break;
+
+        case FieldPrecision::Float16:
+            HalfFloat::fromFloats(simulation.density(), m_rhoHalf);
+            HalfFloat::fromFloats(simulation.forceFieldX(), m_fxHalf);
+            HalfFloat::fromFloats(simulation.forceFieldY(), m_fyHalf);
+            m_rho = {};
+            m_fx = {};
+            m_fy = {};
+        break;
+    }
+}
+
+// Getters
+size_t SimulationFrame::step() const
+{
+    return m_step;
+}
+
+size_t SimulationFrame::frameNumber() const
+{
+    return m_frameNumber;
+}
+
+size_t SimulationFrame::DIMX() const
+{
+    return m_DIMX;
+}
+
+size_t SimulationFrame::DIMY() const
+{
+    return m_DIMY;
+}
+
+FieldPrecision SimulationFrame::precision() const
+{
+    return m_precision;
+}
+
+std::vector<HalfFloat::Bits> const &SimulationFrame::densityHalf() const
+{
+    return m_rhoHalf;
+}
+
+std::vector<HalfFloat::Bits> const &SimulationFrame::forceFieldXHalf() const
+{
+    return m_fxHalf;
+}
+
+std::vector<HalfFloat::Bits> const &SimulationFrame::forceFieldYHalf() const
+{
+    return m_fyHalf;
+}
+
+std::vector<float> const &SimulationFrame::density() const
+{
+    return m_rho;
+}
+
+std::vector<float> SimulationFrame::densityInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return interpolation::interpolateGridVector(toFloats(m_rhoHalf), m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+
+    return interpolation::interpolateGridVector(m_rho, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+}
+
+std::vector<float> const &SimulationFrame::velocityX() const
+{
+    return m_vx;
+}
+
+std::vector<float> const &SimulationFrame::velocityY() const
+{
+    return m_vy;
+}
+
+std::vector<float> SimulationFrame::velocityXInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
+{
+    return interpolation::interpolateGridVector(m_vx, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+}
+
+std::vector<float> SimulationFrame::velocityYInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
+{
+    return interpolation::interpolateGridVector(m_vy, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+}
+
+std::vector<float> const &SimulationFrame::forceFieldX() const
+{
+    return m_fx;
+}
+
+std::vector<float> const &SimulationFrame::forceFieldY() const
+{
+    return m_fy;
+}
+
+std::vector<float> SimulationFrame::forceFieldXInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return interpolation::interpolateGridVector(toFloats(m_fxHalf), m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+
+    return interpolation::interpolateGridVector(m_fx, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+}
+
+std::vector<float> SimulationFrame::forceFieldYInterpolated(size_t const numberOfRows, size_t const numberOfColumns) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return interpolation::interpolateGridVector(toFloats(m_fyHalf), m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+
+    return interpolation::interpolateGridVector(m_fy, m_DIMX, m_DIMY, numberOfRows, numberOfColumns);
+}
+
+std::vector<float> const &SimulationFrame::vorticity() const
+{
+    return m_vorticity;
+}
+
+std::vector<float> const &SimulationFrame::unprojectedDivergence() const
+{
+    return m_unprojectedDivergence;
+}
+
+std::vector<float> const &SimulationFrame::qCriterion() const
+{
+    return m_qCriterion;
+}
+
+float SimulationFrame::vx(size_t const idx) const
+{
+    return m_vx[idx];
+}
+
+float SimulationFrame::vy(size_t const idx) const
+{
+    return m_vy[idx];
+}
+
+float SimulationFrame::fx(size_t const idx) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return HalfFloat::toFloat(m_fxHalf[idx]);
+
+    return m_fx[idx];
+}
+
+float SimulationFrame::fy(size_t const idx) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return HalfFloat::toFloat(m_fyHalf[idx]);
+
+    return m_fy[idx];
+}
+
+float SimulationFrame::rho(size_t const idx) const
+{
+    if (m_precision == FieldPrecision::Float16)
+        return HalfFloat::toFloat(m_rhoHalf[idx]);
+
+    return m_rho[idx];
+}
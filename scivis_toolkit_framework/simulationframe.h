@@ -0,0 +1,84 @@
+#ifndef SIMULATIONFRAME_H
+#define SIMULATIONFRAME_H
+
+#include "datatype.h"
+#include "halffloat.h"
+
+#include <cstddef>
+#include <vector>
+
+class Simulation;
+
+// A copy of the simulation fields after one step, which the renderer reads while the simulation continues.
+// The getters mirror the ones of Simulation. Derived fields are computed by DerivedFieldCache.
+//
+// With FieldPrecision::Float16 the density and force fields are stored as halves, which halves the copy of every step
+// and the memory of the three frames, and lets these fields be uploaded as GL_HALF_FLOAT. The velocity stays in float,
+// it is advected along by the LIC and integrated by the glyphs. In that case density(), forceFieldX() and forceFieldY()
+// are empty: read the halves, or the floats that DerivedFieldCache decodes from them once per frame.
+//
+// The fields of SpectralDerivatives are copied only when selected in the simulation, and are empty otherwise.
+class SimulationFrame
+{
+    size_t m_step = 0U;
+    size_t m_frameNumber = 0U; // Increases with every published frame, also when the simulation is paused.
+    size_t m_DIMX = 0U;
+    size_t m_DIMY = 0U;
+    FieldPrecision m_precision = FieldPrecision::Float32;
+
+    std::vector<float> m_rho;
+    std::vector<float> m_vx, m_vy;
+    std::vector<float> m_fx, m_fy;
+    std::vector<float> m_vorticity, m_unprojectedDivergence, m_qCriterion;
+
+    std::vector<HalfFloat::Bits> m_rhoHalf;
+    std::vector<HalfFloat::Bits> m_fxHalf, m_fyHalf;
+
+public:
+    void copyFrom(Simulation const &simulation, size_t const step, size_t const frameNumber,
+                  FieldPrecision const precision);
+
+    // Getters
+    [[nodiscard]] size_t step() const;
+    [[nodiscard]] size_t frameNumber() const;
+    [[nodiscard]] size_t DIMX() const;
+    [[nodiscard]] size_t DIMY() const;
+    [[nodiscard]] FieldPrecision precision() const;
+
+    // Only filled with FieldPrecision::Float16.
+    [[nodiscard]] std::vector<HalfFloat::Bits> const &densityHalf() const;
+    [[nodiscard]] std::vector<HalfFloat::Bits> const &forceFieldXHalf() const;
+    [[nodiscard]] std::vector<HalfFloat::Bits> const &forceFieldYHalf() const;
+
+    [[nodiscard]] std::vector<float> const &density() const;
+    [[nodiscard]] std::vector<float> densityInterpolated(size_t const numberOfRows,
+                                                         size_t const numberOfColumns) const;
+
+    [[nodiscard]] std::vector<float> const &velocityX() const;
+    [[nodiscard]] std::vector<float> const &velocityY() const;
+
+    [[nodiscard]] std::vector<float> velocityXInterpolated(size_t const numberOfRows,
+                                                           size_t const numberOfColumns) const;
+    [[nodiscard]] std::vector<float> velocityYInterpolated(size_t const numberOfRows,
+                                                           size_t const numberOfColumns) const;
+
+    [[nodiscard]] std::vector<float> const &forceFieldX() const;
+    [[nodiscard]] std::vector<float> const &forceFieldY() const;
+
+    [[nodiscard]] std::vector<float> forceFieldXInterpolated(size_t const numberOfRows,
+                                                             size_t const numberOfColumns) const;
+    [[nodiscard]] std::vector<float> forceFieldYInterpolated(size_t const numberOfRows,
+                                                             size_t const numberOfColumns) const;
+
+    [[nodiscard]] std::vector<float> const &vorticity() const;
+    [[nodiscard]] std::vector<float> const &unprojectedDivergence() const;
+    [[nodiscard]] std::vector<float> const &qCriterion() const;
+
+    [[nodiscard]] float vx(size_t const idx) const;
+    [[nodiscard]] float vy(size_t const idx) const;
+    [[nodiscard]] float fx(size_t const idx) const;
+    [[nodiscard]] float fy(size_t const idx) const;
+    [[nodiscard]] float rho(size_t const idx) const;
+};
+
+#endif // SIMULATIONFRAME_H
@@ -0,0 +1,495 @@
+#include "simulationworker.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+SimulationWorker::SimulationWorker(size_t const DIM)
+    :
+      m_simulation(DIM),
+      m_targetDt(m_simulation.dt()),
+      m_stepDt(m_simulation.dt()),
+      m_dt(m_simulation.dt()),
+      m_viscosity(m_simulation.viscosity()),
+      m_rhoInjected(m_simulation.rhoInjected())
+{
+    resetFrames();
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    stop();
+}
+
+void SimulationWorker::start()
+{
+    if (m_thread.joinable())
+        return;
+
+    m_stopRequested = false;
+    m_thread = std::thread{&SimulationWorker::run, this};
+}
+
+void SimulationWorker::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_stopRequested = true;
+    m_thread.join();
+}
+
+// One frame is published per interval, after all steps of that interval.
+void SimulationWorker::run()
+{
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    auto nextStep = Clock::now();
+    auto lastUpdate = nextStep;
+    m_dueTime = 0.0;
+
+    while (!m_stopRequested)
+    {
+        bool frameChanged = applyCommands();
+
+        auto const intervalStart = Clock::now();
+        Seconds const interval = std::chrono::microseconds{m_stepIntervalMicroseconds.load()};
+        if (m_paused)
+            m_dueTime = 0.0;
+        else
+        {
+            // Beyond s_maxStepsPerInterval steps behind, the time is dropped: the simulation slows down instead.
+            m_dueTime += static_cast<double>(m_targetDt) * (Seconds{intervalStart - lastUpdate} / interval);
+            m_dueTime = std::min(m_dueTime, static_cast<double>(s_maxStepsPerInterval * m_targetDt));
+
+            // A step is taken once half of it is due, so the jitter of the sleep does not alternate between zero and
+            // two steps per interval. Later steps are only taken while the previous one still fits in the interval.
+            Seconds stepDuration{0.0};
+            for (size_t step = 0U; step < s_maxStepsPerInterval; ++step)
+            {
+                // A replay takes the time steps of the recording, set by its events.
+                if (m_sessionPlayer != nullptr && !applyReplayEvents())
+                {
+                    frameChanged = true;
+                    break;
+                }
+
+                float const dt = m_sessionPlayer != nullptr ? m_simulation.dt() : nextStepDt();
+                if (m_dueTime < 0.5 * static_cast<double>(dt) ||
+                    (step > 0U && Clock::now() - intervalStart + stepDuration > interval))
+                    break;
+
+                auto const stepStart = Clock::now();
+                doOneSimulationStep(dt);
+                stepDuration = Clock::now() - stepStart;
+                m_dueTime -= static_cast<double>(dt);
+                frameChanged = true;
+            }
+        }
+        lastUpdate = intervalStart;
+
+        if (frameChanged)
+        {
+            Profiler::CpuScope const scope{m_profiler, "publishFrame", Profiler::Thread::Simulation};
+            publishFrame();
+        }
+
+        auto const now = Clock::now();
+        nextStep += std::chrono::microseconds{m_stepIntervalMicroseconds.load()};
+        if (nextStep < now)
+            nextStep = now;
+
+        std::this_thread::sleep_until(nextStep);
+    }
+}
+
+// The requested dt, or the equal part of it that keeps the fastest fluid of the last step below s_maxCflNumber cells
+// per step. Splitting into equal parts keeps dt, and with it the spectral filter, the same from step to step.
+float SimulationWorker::nextStepDt() const
+{
+    if (!m_adaptiveDt)
+        return m_targetDt;
+
+    float const cellsPerStep = m_targetDt * m_simulation.maxSpeed() *
+                               static_cast<float>(std::max(m_simulation.DIMX(), m_simulation.DIMY()));
+    auto const substeps = static_cast<size_t>(std::ceil(cellsPerStep / s_maxCflNumber));
+    return m_targetDt / static_cast<float>(std::clamp<size_t>(substeps, 1U, s_maxStepsPerInterval));
+}
+
+void SimulationWorker::doOneSimulationStep(float const dt)
+{
+    if (m_simulation.dt() != dt)
+    {
+        recordEvent(sessionformat::Event::Type::SetDt, 0U, dt, 0.0F);
+        m_simulation.setDt(dt);
+    }
+
+    {
+        Profiler::CpuScope const scope{m_profiler, "doOneSimulationStep", Profiler::Thread::Simulation};
+        m_simulation.doOneSimulationStep();
+    }
+    ++m_step;
+    m_stepDt = dt;
+
+    if (m_snapshotWriter != nullptr)
+        m_snapshotWriter->tryAppend(m_simulation, m_step);
+
+    if (m_sessionRecorder != nullptr && m_sessionPlayer == nullptr)
+        m_sessionRecorder->recordStep(m_simulation, m_step);
+}
+
+// Applies all queued commands to the simulation. Returns whether any fields were changed.
+// While replaying, only the time step is kept, as the pace of the replay, and the derived fields that are shown; the
+// recording sets everything else.
+bool SimulationWorker::applyCommands()
+{
+    bool fieldsChanged = false;
+
+    Command command;
+    while (m_commands.pop(command))
+    {
+        if (m_sessionPlayer != nullptr && command.type != Command::Type::SetDt &&
+            command.type != Command::Type::SetSpectralFields)
+            continue;
+
+        switch (command.type)
+        {
+            case Command::Type::AddForce:
+                m_simulation.setFx(command.idx, m_simulation.fx(command.idx) + command.x);
+                m_simulation.setFy(command.idx, m_simulation.fy(command.idx) + command.y);
+                recordEvent(sessionformat::Event::Type::AddForce, command.idx, command.x, command.y);
+                fieldsChanged = true;
+            break;
+
+            case Command::Type::InjectDensity:
+                m_simulation.setRho(command.idx, m_simulation.rhoInjected());
+                recordEvent(sessionformat::Event::Type::InjectDensity, command.idx, 0.0F, 0.0F);
+                fieldsChanged = true;
+            break;
+
+            case Command::Type::SetDt:
+                m_targetDt = command.x; // Applied, and recorded, by the next step, see nextStepDt.
+            break;
+
+            case Command::Type::SetViscosity:
+                m_simulation.setViscosity(command.x);
+                recordEvent(sessionformat::Event::Type::SetViscosity, 0U, command.x, 0.0F);
+            break;
+
+            case Command::Type::SetRhoInjected:
+                m_simulation.setRhoInjected(command.x);
+                recordEvent(sessionformat::Event::Type::SetRhoInjected, 0U, command.x, 0.0F);
+            break;
+
+            case Command::Type::SetSpectralFields:
+                m_simulation.setSpectralFields(static_cast<unsigned int>(command.idx));
+                fieldsChanged = true; // Publishes the newly selected fields while paused as well.
+            break;
+        }
+    }
+
+    return fieldsChanged;
+}
+
+// Applies the recorded events before the next step. Returns false, ending the replay, when the recording ends or the
+// grid size changes, as the visualization has to be resized first; seeking past the change continues it.
+bool SimulationWorker::applyReplayEvents()
+{
+    if (m_sessionPlayer->applyEvents(m_step, m_simulation, m_nextReplayEvent, false) &&
+        m_step < m_sessionPlayer->lastStep())
+        return true;
+
+    m_sessionPlayer = nullptr;
+    m_replaying = false;
+    return false;
+}
+
+void SimulationWorker::recordEvent(sessionformat::Event::Type const type, size_t const idx, float const x,
+                                   float const y)
+{
+    if (m_sessionRecorder == nullptr || m_sessionPlayer != nullptr)
+        return;
+
+    sessionformat::Event event;
+    event.step = m_step;
+    event.type = type;
+    event.idx = idx;
+    event.x = x;
+    event.y = y;
+    m_sessionRecorder->recordEvent(event);
+}
+
+void SimulationWorker::publishFrame()
+{
+    m_frames[m_backFrame].copyFrom(m_simulation, m_step, ++m_frameNumber, m_fieldPrecision);
+    m_backFrame = m_middleFrame.exchange(m_backFrame | s_newFrameFlag, std::memory_order_acq_rel) & ~s_newFrameFlag;
+}
+
+bool SimulationWorker::acquireLatestFrame()
+{
+    if ((m_middleFrame.load(std::memory_order_relaxed) & s_newFrameFlag) == 0U)
+        return false;
+
+    m_frontFrame = m_middleFrame.exchange(m_frontFrame, std::memory_order_acq_rel) & ~s_newFrameFlag;
+    return true;
+}
+
+bool SimulationWorker::hasNewFrame() const
+{
+    return (m_middleFrame.load(std::memory_order_relaxed) & s_newFrameFlag) != 0U;
+}
+
+// Fills all frames with the current state of the simulation. Only valid while the worker thread is stopped.
+void SimulationWorker::resetFrames()
+{
+    ++m_frameNumber;
+    for (SimulationFrame &frame : m_frames)
+        frame.copyFrom(m_simulation, m_step, m_frameNumber, m_fieldPrecision);
+
+    m_backFrame = 0U;
+    m_middleFrame = 1U;
+    m_frontFrame = 2U;
+}
+
+void SimulationWorker::pushCommand(Command const &command)
+{
+    if (!m_commands.push(command))
+        qDebug() << "Simulation command queue is full, dropping input";
+}
+
+SimulationFrame const &SimulationWorker::frame() const
+{
+    return m_frames[m_frontFrame];
+}
+
+void SimulationWorker::addForce(size_t const idx, float const fx, float const fy)
+{
+    pushCommand({Command::Type::AddForce, idx, fx, fy});
+}
+
+void SimulationWorker::injectDensity(size_t const idx)
+{
+    pushCommand({Command::Type::InjectDensity, idx, 0.0F, 0.0F});
+}
+
+// Getters
+bool SimulationWorker::isPaused() const
+{
+    return m_paused;
+}
+
+bool SimulationWorker::isReplaying() const
+{
+    return m_replaying;
+}
+
+FieldPrecision SimulationWorker::fieldPrecision() const
+{
+    return m_fieldPrecision;
+}
+
+float SimulationWorker::dt() const
+{
+    return m_dt;
+}
+
+float SimulationWorker::stepDt() const
+{
+    return m_stepDt;
+}
+
+bool SimulationWorker::adaptiveDt() const
+{
+    return m_adaptiveDt;
+}
+
+float SimulationWorker::viscosity() const
+{
+    return m_viscosity;
+}
+
+float SimulationWorker::rhoInjected() const
+{
+    return m_rhoInjected;
+}
+
+unsigned int SimulationWorker::spectralFields() const
+{
+    return m_spectralFields;
+}
+
+// Setters
+void SimulationWorker::setPaused(bool const paused)
+{
+    m_paused = paused;
+}
+
+void SimulationWorker::setStepInterval(std::chrono::microseconds const interval)
+{
+    m_stepIntervalMicroseconds = interval.count();
+}
+
+void SimulationWorker::setDIM(size_t const DIM)
+{
+    setDIM(DIM, DIM);
+}
+
+void SimulationWorker::setDIM(size_t const DIMX, size_t const DIMY)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    // Apply the remaining input first; its indices refer to the old grid. The grid of a replay is changed by its
+    // events, another one ends it.
+    applyCommands();
+    if (m_sessionRecorder != nullptr && m_sessionPlayer == nullptr)
+    {
+        sessionformat::Event event;
+        event.step = m_step;
+        event.type = sessionformat::Event::Type::SetDIM;
+        event.idx = DIMX;
+        event.DIMY = DIMY;
+        m_sessionRecorder->recordEvent(event);
+    }
+    m_sessionPlayer = nullptr;
+    m_replaying = false;
+    m_simulation.setDIM(DIMX, DIMY);
+    resetFrames();
+
+    if (wasRunning)
+        start();
+}
+
+void SimulationWorker::setThreadCount(size_t const threadCount)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    m_simulation.setThreadCount(threadCount);
+
+    if (wasRunning)
+        start();
+}
+
+// Republishes the current state in the new precision, so the renderer never sees frames of both.
+void SimulationWorker::setFieldPrecision(FieldPrecision const precision)
+{
+    if (precision == m_fieldPrecision)
+        return;
+
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    m_fieldPrecision = precision;
+    resetFrames();
+
+    if (wasRunning)
+        start();
+}
+
+void SimulationWorker::setSnapshotWriter(SnapshotWriter *const snapshotWriter)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    m_snapshotWriter = snapshotWriter;
+
+    if (wasRunning)
+        start();
+}
+
+void SimulationWorker::setProfiler(Profiler *const profiler)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    m_profiler = profiler;
+
+    if (wasRunning)
+        start();
+}
+
+void SimulationWorker::setSessionRecorder(SessionRecorder *const sessionRecorder)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    if (m_sessionRecorder != nullptr && m_sessionPlayer == nullptr)
+        m_sessionRecorder->recordKeyframe(m_simulation, m_step);
+
+    m_sessionRecorder = sessionRecorder;
+    if (m_sessionRecorder != nullptr && m_sessionPlayer == nullptr)
+        m_sessionRecorder->recordKeyframe(m_simulation, m_step);
+
+    if (wasRunning)
+        start();
+}
+
+bool SimulationWorker::seek(SessionPlayer const &player, size_t &step)
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    size_t nextEvent = 0U;
+    bool const restored = player.seek(step, m_simulation, nextEvent);
+    if (restored)
+    {
+        m_sessionPlayer = &player;
+        m_nextReplayEvent = nextEvent;
+        m_replaying = true;
+        m_step = step;
+        m_stepDt = m_simulation.dt();
+        resetFrames();
+    }
+
+    if (wasRunning)
+        start();
+
+    return restored;
+}
+
+void SimulationWorker::stopReplay()
+{
+    bool const wasRunning = m_thread.joinable();
+    stop();
+
+    m_sessionPlayer = nullptr;
+    m_replaying = false;
+
+    if (wasRunning)
+        start();
+}
+
+void SimulationWorker::setDt(float const dt)
+{
+    m_dt = dt;
+    pushCommand({Command::Type::SetDt, 0U, dt, 0.0F});
+}
+
+void SimulationWorker::setAdaptiveDt(bool const adaptiveDt)
+{
+    m_adaptiveDt = adaptiveDt;
+}
+
+void SimulationWorker::setViscosity(float const viscosity)
+{
+    m_viscosity = viscosity;
+    pushCommand({Command::Type::SetViscosity, 0U, viscosity, 0.0F});
+}
+
+void SimulationWorker::setRhoInjected(float const rhoInjected)
+{
+    m_rhoInjected = rhoInjected;
+    pushCommand({Command::Type::SetRhoInjected, 0U, rhoInjected, 0.0F});
+}
+
+void SimulationWorker::setSpectralFields(unsigned int const fields)
+{
+    if (fields == m_spectralFields)
+        return;
+
+    m_spectralFields = fields;
+    pushCommand({Command::Type::SetSpectralFields, fields, 0.0F, 0.0F});
+}
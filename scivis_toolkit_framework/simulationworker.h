@@ -0,0 +1,166 @@
+#ifndef SIMULATIONWORKER_H
+#define SIMULATIONWORKER_H
+
+#include "profiler.h"
+#include "sessionplayer.h"
+#include "sessionrecorder.h"
+#include "simulation.h"
+#include "simulationframe.h"
+#include "snapshotwriter.h"
+#include "spscqueue.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+// Runs the simulation on its own thread, independent of the render rate.
+// The steps follow the wall clock: every step interval adds dt to the simulated time that is due, and the worker steps
+// until it has caught up. When a step takes longer than the interval, the steps of one interval are limited to what
+// fits in it and the simulation falls behind the clock instead of piling up steps. With the adaptive time step, dt is
+// split into equal substeps that move the fastest fluid at most s_maxCflNumber cells each.
+// After every step the fields are published into a triple buffer of SimulationFrames: the worker always owns one frame,
+// the renderer owns another, and the third holds the latest published frame. Neither side ever waits for the other.
+// User input and parameter changes go to the worker through a lock-free queue and are applied between two steps.
+// A session recorder logs them, with the time step of every step, as the events that reproduce the steps. While a
+// recorded session is replayed, its events take the place of the input instead.
+// Except for the worker thread itself, every function has to be called from the same (GUI) thread.
+class SimulationWorker
+{
+    struct Command
+    {
+        enum class Type
+        {
+            AddForce,
+            InjectDensity,
+            SetDt,
+            SetViscosity,
+            SetRhoInjected,
+            SetSpectralFields // The flags in idx.
+        };
+
+        Type type = Type::AddForce;
+        size_t idx = 0U;
+        float x = 0.0F;
+        float y = 0.0F;
+    };
+
+    // Only touched by the worker thread while it is running.
+    Simulation m_simulation;
+    size_t m_step = 0U;
+    size_t m_frameNumber = 0U;
+    FieldPrecision m_fieldPrecision = FieldPrecision::Float32;
+    SnapshotWriter *m_snapshotWriter = nullptr; // Records every step when set.
+    Profiler *m_profiler = nullptr;             // Times the steps when set.
+    // Records the events and keyframes of the session when set.
+    SessionRecorder *m_sessionRecorder = nullptr;
+    // Replays a session instead of taking input when set, from its event m_nextReplayEvent.
+    SessionPlayer const *m_sessionPlayer = nullptr;
+    size_t m_nextReplayEvent = 0U;
+    float m_targetDt;                           // The time step that is due per step interval.
+    double m_dueTime = 0.0;                     // Simulated time the steps are behind the wall clock.
+
+    std::array<SimulationFrame, 3U> m_frames;
+    size_t m_backFrame = 0U;                // Owned by the worker thread.
+    size_t m_frontFrame = 2U;               // Owned by the GUI thread.
+    std::atomic<size_t> m_middleFrame{1U};  // Latest published frame, or'ed with s_newFrameFlag until it is acquired.
+    static constexpr size_t s_newFrameFlag = 4U;
+
+    SpscQueue<Command> m_commands{4096U};
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<bool> m_paused{false};
+    std::atomic<long long> m_stepIntervalMicroseconds{17000}; // 17ms, approximately 60 steps per second.
+    std::atomic<bool> m_adaptiveDt{false};
+    std::atomic<bool> m_replaying{false};
+    std::atomic<float> m_stepDt;          // The time step of the latest step.
+
+    static constexpr size_t s_maxStepsPerInterval = 8U; // Also the most substeps of the adaptive time step.
+    static constexpr float s_maxCflNumber = 1.0F;       // Cells moved per step by the fastest fluid.
+
+    // GUI-side copies of the simulation parameters.
+    float m_dt;
+    float m_viscosity;
+    float m_rhoInjected;
+    unsigned int m_spectralFields = 0U;
+
+    void run();
+    [[nodiscard]] float nextStepDt() const;
+    void doOneSimulationStep(float const dt);
+    bool applyCommands();
+    bool applyReplayEvents();
+    void recordEvent(sessionformat::Event::Type const type, size_t const idx, float const x, float const y);
+    void publishFrame();
+    void resetFrames();
+    void pushCommand(Command const &command);
+
+public:
+    explicit SimulationWorker(size_t const DIM);
+    SimulationWorker(SimulationWorker const&) = delete;
+    SimulationWorker& operator=(SimulationWorker const&) = delete;
+    ~SimulationWorker();
+
+    void start();
+    void stop();
+
+    // Swaps in the latest published frame, if there is one. Returns whether the frame changed.
+    bool acquireLatestFrame();
+    // Whether a frame was published since the last acquireLatestFrame.
+    [[nodiscard]] bool hasNewFrame() const;
+    [[nodiscard]] SimulationFrame const &frame() const;
+
+    // Input, applied before the next step.
+    void addForce(size_t const idx, float const fx, float const fy);
+    void injectDensity(size_t const idx);
+
+    // Getters
+    [[nodiscard]] bool isPaused() const;
+    // Cleared by the worker when the replay reaches the end of the recording, or a change of the grid size.
+    [[nodiscard]] bool isReplaying() const;
+    [[nodiscard]] FieldPrecision fieldPrecision() const;
+
+    [[nodiscard]] float dt() const;
+    // Less than dt while the adaptive time step splits the steps.
+    [[nodiscard]] float stepDt() const;
+    [[nodiscard]] bool adaptiveDt() const;
+    [[nodiscard]] float viscosity() const;
+    [[nodiscard]] float rhoInjected() const;
+    [[nodiscard]] unsigned int spectralFields() const;
+
+    // Setters
+    void setPaused(bool const paused);
+    void setStepInterval(std::chrono::microseconds const interval);
+
+    // Stops the worker while the simulation is resized, its thread pool is replaced, the frames change precision or the
+    // snapshot writer is replaced.
+    void setDIM(size_t const DIM);
+    void setDIM(size_t const DIMX, size_t const DIMY);
+    void setThreadCount(size_t const threadCount);
+    void setFieldPrecision(FieldPrecision const precision);
+    // The writer has to stay open until it is replaced, or set to nullptr.
+    void setSnapshotWriter(SnapshotWriter *const snapshotWriter);
+    // The profiler has to outlive the worker, or be replaced first.
+    void setProfiler(Profiler *const profiler);
+    // The recorder has to stay open until it is replaced, or set to nullptr. It starts with a keyframe of the current
+    // state, and the replaced one ends with one.
+    void setSessionRecorder(SessionRecorder *const sessionRecorder);
+
+    // Restores the state of step from player, which has to outlive the replay, and replays the recording from there.
+    // Nothing is recorded while replaying. Returns false if the state cannot be restored, leaving the simulation as it
+    // was. Both stop the worker, like setDIM.
+    bool seek(SessionPlayer const &player, size_t &step);
+    void stopReplay();
+
+    void setDt(float const dt);
+    void setAdaptiveDt(bool const adaptiveDt);
+    void setViscosity(float const viscosity);
+    void setRhoInjected(float const rhoInjected);
+    // The SpectralDerivatives flags of the fields to compute and publish. They are not part of the simulation state, so
+    // they are not recorded and also apply while replaying. Only a change is sent to the worker, so this can be called
+    // every frame.
+    void setSpectralFields(unsigned int const fields);
+};
+
+#endif // SIMULATIONWORKER_H
@@ -0,0 +1,265 @@
+#include "snapshotwriter.h"
+
+#include "simulation.h"
+
+#include <QDebug>
+#include <QDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace
+{
+    // The .npy byte order character of this machine.
+    char byteOrder()
+    {
+        std::uint16_t const one = 1U;
+        return *reinterpret_cast<unsigned char const*>(&one) == 1U ? '<' : '>';
+    }
+
+    // Version 1.0 of the format: magic string, version, header length and a Python dict literal padded with spaces
+    // to headerSize bytes, ending in a newline.
+    bool writeNpyHeader(std::ofstream &file, std::string const &descr, std::string const &shape, size_t const headerSize)
+    {
+        std::string header = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" + shape + "), }";
+        size_t const preambleSize = 10U;
+        if (preambleSize + header.size() + 1U > headerSize)
+            return false;
+
+        header.resize(headerSize - preambleSize - 1U, ' ');
+        header += '\n';
+
+        auto const headerLength = static_cast<std::uint16_t>(header.size());
+        char const preamble[preambleSize] = {'\x93', 'N', 'U', 'M', 'P', 'Y', '\x01', '\x00',
+                                             static_cast<char>(headerLength & 0xFFU),
+                                             static_cast<char>(headerLength >> 8U)};
+
+        auto const end = file.tellp();
+        file.seekp(0);
+        file.write(preamble, preambleSize);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        if (end > static_cast<std::streamoff>(headerSize))
+            file.seekp(end);
+        return static_cast<bool>(file);
+    }
+
+    std::string chunkFileName(QString const &directory, size_t const chunkIndex, QString const &suffix)
+    {
+        QString const name = QStringLiteral("snapshots_%1%2.npy").arg(chunkIndex, 6, 10, QLatin1Char('0')).arg(suffix);
+        return QDir{directory}.filePath(name).toStdString();
+    }
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    close();
+}
+
+bool SnapshotWriter::open(QString const &directory, FieldPrecision const precision, size_t const framesPerChunk)
+{
+    close();
+
+    if (!QDir{}.mkpath(directory))
+    {
+        qCritical() << "Cannot create the snapshot directory" << directory;
+        return false;
+    }
+
+    m_directory = directory;
+    m_precision = precision;
+    m_framesPerChunk = std::max<size_t>(framesPerChunk, 1U);
+    m_chunkIndex = 0U;
+    m_chunkFrames = 0U;
+    m_failed = false;
+    m_writtenFrames = 0U;
+    m_droppedFrames = 0U;
+
+    // Both queues are empty after a close, so every buffer is free.
+    for (size_t slot = 0U; slot < s_bufferCount; ++slot)
+        m_freeSnapshots.push(slot);
+
+    m_stopRequested = false;
+    m_thread = std::thread{&SnapshotWriter::run, this};
+    return true;
+}
+
+void SnapshotWriter::close()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_stopRequested = true;
+    m_thread.join();
+
+    size_t slot = 0U;
+    while (m_freeSnapshots.pop(slot))
+        ;
+
+    qDebug() << "Recorded" << m_writtenFrames.load() << "snapshots into" << m_directory << "and dropped"
+             << m_droppedFrames.load();
+}
+
+void SnapshotWriter::run()
+{
+    while (true)
+    {
+        // Read the flag before looking at the queue, so the frames appended before the stop are still written.
+        bool const stopping = m_stopRequested;
+
+        size_t slot = 0U;
+        if (m_filledSnapshots.pop(slot))
+        {
+            write(m_snapshots[slot]);
+            m_freeSnapshots.push(slot);
+            continue;
+        }
+
+        if (stopping)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    finishChunk();
+}
+
+void SnapshotWriter::write(Snapshot const &snapshot)
+{
+    if (m_failed)
+        return;
+
+    bool const gridChanged = snapshot.DIMX != m_chunkDIMX || snapshot.DIMY != m_chunkDIMY;
+    if (m_chunk.is_open() && (gridChanged || m_chunkFrames == m_framesPerChunk))
+        finishChunk();
+
+    if (!m_chunk.is_open() && !startChunk(snapshot.DIMX, snapshot.DIMY))
+    {
+        m_failed = true;
+        return;
+    }
+
+    if (m_precision == FieldPrecision::Float16)
+    {
+        HalfFloat::fromFloats(snapshot.fields, m_halves);
+        m_chunk.write(reinterpret_cast<char const*>(m_halves.data()),
+                      static_cast<std::streamsize>(m_halves.size() * sizeof(HalfFloat::Bits)));
+    }
+    else
+        m_chunk.write(reinterpret_cast<char const*>(snapshot.fields.data()),
+                      static_cast<std::streamsize>(snapshot.fields.size() * sizeof(float)));
+
+    auto const step = static_cast<std::uint64_t>(snapshot.step);
+    m_chunkSteps.write(reinterpret_cast<char const*>(&step), sizeof(step));
+
+    ++m_chunkFrames;
+    if (!writeHeaders() || !m_chunk.flush() || !m_chunkSteps.flush())
+    {
+        qCritical() << "Cannot write snapshot chunk" << m_chunkIndex << "in" << m_directory;
+        m_failed = true;
+        return;
+    }
+
+    ++m_writtenFrames;
+}
+
+bool SnapshotWriter::startChunk(size_t const DIMX, size_t const DIMY)
+{
+    m_chunk.open(chunkFileName(m_directory, m_chunkIndex, QString{}), std::ios::binary | std::ios::trunc);
+    m_chunkSteps.open(chunkFileName(m_directory, m_chunkIndex, QStringLiteral("_steps")),
+                      std::ios::binary | std::ios::trunc);
+    m_chunkDIMX = DIMX;
+    m_chunkDIMY = DIMY;
+    m_chunkFrames = 0U;
+
+    if (!m_chunk || !m_chunkSteps || !writeHeaders())
+    {
+        qCritical() << "Cannot create snapshot chunk" << m_chunkIndex << "in" << m_directory;
+        return false;
+    }
+
+    return true;
+}
+
+void SnapshotWriter::finishChunk()
+{
+    if (!m_chunk.is_open())
+        return;
+
+    m_chunk.close();
+    m_chunkSteps.close();
+    ++m_chunkIndex;
+}
+
+// Writes the headers for the current number of frames, leaving the files positioned at their ends.
+bool SnapshotWriter::writeHeaders()
+{
+    std::string const descr = std::string{byteOrder()} + (m_precision == FieldPrecision::Float16 ? "f2" : "f4");
+    std::string const frames = std::to_string(m_chunkFrames);
+    std::string const shape = frames + ", 3, " + std::to_string(m_chunkDIMY) + ", " + std::to_string(m_chunkDIMX);
+
+    return writeNpyHeader(m_chunk, descr, shape, s_headerSize) &&
+           writeNpyHeader(m_chunkSteps, std::string{byteOrder()} + "u8", frames + ",", s_headerSize);
+}
+
+void SnapshotWriter::fillSnapshot(size_t const slot, Simulation const &simulation, size_t const step)
+{
+    Snapshot &snapshot = m_snapshots[slot];
+    snapshot.step = step;
+    snapshot.DIMX = simulation.DIMX();
+    snapshot.DIMY = simulation.DIMY();
+
+    size_t const numberOfCells = snapshot.DIMX * snapshot.DIMY;
+    snapshot.fields.resize(3U * numberOfCells);
+    std::copy(simulation.density().cbegin(), simulation.density().cend(), snapshot.fields.begin());
+    std::copy(simulation.velocityX().cbegin(), simulation.velocityX().cend(),
+              snapshot.fields.begin() + static_cast<std::ptrdiff_t>(numberOfCells));
+    std::copy(simulation.velocityY().cbegin(), simulation.velocityY().cend(),
+              snapshot.fields.begin() + static_cast<std::ptrdiff_t>(2U * numberOfCells));
+
+    m_filledSnapshots.push(slot);
+}
+
+bool SnapshotWriter::tryAppend(Simulation const &simulation, size_t const step)
+{
+    if (!m_thread.joinable())
+        return false;
+
+    size_t slot = 0U;
+    if (!m_freeSnapshots.pop(slot))
+    {
+        ++m_droppedFrames;
+        return false;
+    }
+
+    fillSnapshot(slot, simulation, step);
+    return true;
+}
+
+void SnapshotWriter::append(Simulation const &simulation, size_t const step)
+{
+    if (!m_thread.joinable())
+        return;
+
+    size_t slot = 0U;
+    while (!m_freeSnapshots.pop(slot))
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+    fillSnapshot(slot, simulation, step);
+}
+
+bool SnapshotWriter::isOpen() const
+{
+    return m_thread.joinable();
+}
+
+size_t SnapshotWriter::writtenFrames() const
+{
+    return m_writtenFrames;
+}
+
+size_t SnapshotWriter::droppedFrames() const
+{
+    return m_droppedFrames;
+}
@@ -0,0 +1,100 @@
+#ifndef SNAPSHOTWRITER_H
+#define SNAPSHOTWRITER_H
+
+#include "datatype.h"
+#include "halffloat.h"
+#include "spscqueue.h"
+
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+class Simulation;
+
+// Records the density and velocity of simulation steps into NumPy .npy files, which Python can memory-map with
+// np.load(fileName, mmap_mode='r'); see ML_for_VIS/simulation_snapshots.py.
+// The frames are split over chunks snapshots_000000.npy, snapshots_000001.npy, ... of shape
+// (frames, 3, DIMY, DIMX), holding rho, vx and vy of every frame, as float32 or float16. Next to every chunk,
+// snapshots_000000_steps.npy holds the simulation step of each frame. A chunk ends after framesPerChunk frames, or when
+// the grid size changes. The header of a chunk is rewritten and the files flushed after every frame, so they can be
+// read while recording.
+// Appending only copies the fields into one of a few preallocated buffers; a writer thread converts and writes them.
+// Appending has to be done from one thread at a time, all other functions from the thread that opened the writer.
+class SnapshotWriter
+{
+    struct Snapshot
+    {
+        size_t step = 0U;
+        size_t DIMX = 0U;
+        size_t DIMY = 0U;
+        std::vector<float> fields; // rho, vx and vy, one after another.
+    };
+
+    static constexpr size_t s_bufferCount = 8U;
+    static constexpr size_t s_headerSize = 128U; // Of the .npy files, a multiple of 64 as the format recommends.
+
+    std::array<Snapshot, s_bufferCount> m_snapshots;
+    SpscQueue<size_t> m_freeSnapshots{s_bufferCount + 1U};   // Pushed by the writer thread, popped by appending.
+    SpscQueue<size_t> m_filledSnapshots{s_bufferCount + 1U}; // Pushed by appending, popped by the writer thread.
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<size_t> m_writtenFrames{0U};
+    std::atomic<size_t> m_droppedFrames{0U};
+
+    QString m_directory;
+    FieldPrecision m_precision = FieldPrecision::Float32;
+    size_t m_framesPerChunk = 0U;
+
+    // Only touched by the writer thread while it is running.
+    std::ofstream m_chunk;
+    std::ofstream m_chunkSteps;
+    size_t m_chunkIndex = 0U;
+    size_t m_chunkFrames = 0U;
+    size_t m_chunkDIMX = 0U;
+    size_t m_chunkDIMY = 0U;
+    bool m_failed = false;
+    std::vector<HalfFloat::Bits> m_halves;
+
+    void run();
+    void write(Snapshot const &snapshot);
+    bool startChunk(size_t const DIMX, size_t const DIMY);
+    void finishChunk();
+    bool writeHeaders();
+
+    void fillSnapshot(size_t const slot, Simulation const &simulation, size_t const step);
+
+public:
+    static constexpr size_t s_defaultFramesPerChunk = 256U;
+
+    SnapshotWriter() = default;
+    SnapshotWriter(SnapshotWriter const&) = delete;
+    SnapshotWriter& operator=(SnapshotWriter const&) = delete;
+    ~SnapshotWriter();
+
+    // Starts a recording into directory, which is created if needed. Chunks of an earlier recording there are
+    // overwritten. Returns false, after logging why, if the directory cannot be created.
+    bool open(QString const &directory, FieldPrecision const precision,
+              size_t const framesPerChunk = s_defaultFramesPerChunk);
+
+    // Writes the frames still buffered and closes the files. Nothing may be appending anymore.
+    void close();
+
+    // Returns false if the writer is not open, or, dropping the frame, if all buffers are still waiting to be written,
+    // so the simulation never waits for the disk.
+    bool tryAppend(Simulation const &simulation, size_t const step);
+    // Waits for a free buffer instead, for recordings that have to be complete.
+    void append(Simulation const &simulation, size_t const step);
+
+    // Getters
+    [[nodiscard]] bool isOpen() const;
+    [[nodiscard]] size_t writtenFrames() const;
+    [[nodiscard]] size_t droppedFrames() const;
+};
+
+#endif // SNAPSHOTWRITER_H
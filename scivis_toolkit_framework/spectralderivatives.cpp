@@ -0,0 +1,155 @@
+#include "spectralderivatives.h"
+
+#include <algorithm>
+
+namespace
+{
+    // i * k * z
+    std::complex<float> derivative(float const k, std::complex<float> const z)
+    {
+        return {-k * z.imag(), k * z.real()};
+    }
+}
+
+void SpectralDerivatives::resize(size_t const width, size_t const height)
+{
+    if (width == m_width && height == m_height)
+        return;
+
+    m_width = width;
+    m_height = height;
+    m_spectrumColumns = m_width / 2U + 1U;
+
+    // Per grid cell, the domain is width cells wide and height cells high.
+    float const twoPi = 6.283185307F;
+    m_wavenumbersX.resize(m_spectrumColumns);
+    for (size_t i = 0U; i < m_spectrumColumns; ++i)
+        m_wavenumbersX[i] = 2U * i == m_width ? 0.0F : twoPi * static_cast<float>(i) / static_cast<float>(m_width);
+
+    m_wavenumbersY.resize(m_height);
+    for (size_t j = 0U; j < m_height; ++j)
+    {
+        float const y = j <= m_height / 2U ? static_cast<float>(j) : static_cast<float>(j) - static_cast<float>(m_height);
+        m_wavenumbersY[j] = 2U * j == m_height ? 0.0F : twoPi * y / static_cast<float>(m_height);
+    }
+
+    m_spectrumA.assign(m_height * m_spectrumColumns, std::complex<float>{});
+    m_spectrumB.assign(m_height * m_spectrumColumns, std::complex<float>{});
+    m_spectrumC.assign(m_height * m_spectrumColumns, std::complex<float>{});
+    allocateFields();
+}
+
+// The vorticity is kept for the Q-criterion as well.
+void SpectralDerivatives::allocateFields()
+{
+    size_t const size = m_width * m_height;
+    auto const allocate = [size](std::vector<float> &field, bool const isSelected)
+    {
+        if (isSelected)
+            field.assign(size, 0.0F);
+        else
+            field = {};
+    };
+
+    allocate(m_vorticity, (m_fields & (s_vorticity | s_qCriterion)) != 0U);
+    allocate(m_divergence, (m_fields & s_divergence) != 0U);
+    allocate(m_qCriterion, (m_fields & s_qCriterion) != 0U);
+    allocate(m_strain, (m_fields & s_qCriterion) != 0U);
+    allocate(m_shear, (m_fields & s_qCriterion) != 0U);
+}
+
+void SpectralDerivatives::computeUnprojected(std::complex<float> const * const U, std::complex<float> const * const V,
+                                             float const normalizationFactor, FftWorkspace &fft,
+                                             ThreadPool &threadPool)
+{
+    if ((m_fields & s_divergence) == 0U)
+        return;
+
+    threadPool.parallelFor(0U, m_height, [=](size_t const begin, size_t const end, size_t)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            float const ky = m_wavenumbersY[j];
+            for (size_t i = 0U, idx = j * m_spectrumColumns; i < m_spectrumColumns; ++i, ++idx)
+                m_spectrumA[idx] = derivative(m_wavenumbersX[i], U[idx]) + derivative(ky, V[idx]);
+        }
+    });
+    fft.backward(m_spectrumA.data(), m_divergence.data(), normalizationFactor, threadPool);
+}
+
+void SpectralDerivatives::computeProjected(std::complex<float> const * const U, std::complex<float> const * const V,
+                                           float const normalizationFactor, FftWorkspace &fft, ThreadPool &threadPool)
+{
+    bool const computeQCriterion = (m_fields & s_qCriterion) != 0U;
+    if ((m_fields & s_vorticity) == 0U && !computeQCriterion)
+        return;
+
+    threadPool.parallelFor(0U, m_height, [=](size_t const begin, size_t const end, size_t)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            float const ky = m_wavenumbersY[j];
+            for (size_t i = 0U, idx = j * m_spectrumColumns; i < m_spectrumColumns; ++i, ++idx)
+            {
+                float const kx = m_wavenumbersX[i];
+                m_spectrumA[idx] = derivative(kx, V[idx]) - derivative(ky, U[idx]);
+                if (computeQCriterion)
+                {
+                    m_spectrumB[idx] = derivative(kx, U[idx]);
+                    m_spectrumC[idx] = derivative(ky, U[idx]) + derivative(kx, V[idx]);
+                }
+            }
+        }
+    });
+    fft.backward(m_spectrumA.data(), m_vorticity.data(), normalizationFactor, threadPool);
+    if (!computeQCriterion)
+        return;
+
+    fft.backward(m_spectrumB.data(), m_strain.data(), normalizationFactor, threadPool);
+    fft.backward(m_spectrumC.data(), m_shear.data(), normalizationFactor, threadPool);
+
+    // With du/dy * dv/dx = (shear^2 - vorticity^2) / 4.
+    threadPool.parallelFor(0U, m_qCriterion.size(), [this](size_t const begin, size_t const end, size_t)
+    {
+        for (size_t idx = begin; idx < end; ++idx)
+            m_qCriterion[idx] = 0.25F * (m_vorticity[idx] * m_vorticity[idx] - m_shear[idx] * m_shear[idx]) -
+                                m_strain[idx] * m_strain[idx];
+    });
+}
+
+void SpectralDerivatives::reset()
+{
+    for (std::vector<float> *field : {&m_vorticity, &m_divergence, &m_qCriterion})
+        std::fill(field->begin(), field->end(), 0.0F);
+}
+
+// Getters
+unsigned int SpectralDerivatives::fields() const
+{
+    return m_fields;
+}
+
+std::vector<float> const &SpectralDerivatives::vorticity() const
+{
+    return m_vorticity;
+}
+
+std::vector<float> const &SpectralDerivatives::divergence() const
+{
+    return m_divergence;
+}
+
+std::vector<float> const &SpectralDerivatives::qCriterion() const
+{
+    return m_qCriterion;
+}
+
+// Setters
+void SpectralDerivatives::setFields(unsigned int const fields)
+{
+    if (fields == m_fields)
+        return;
+
+    m_fields = fields;
+    allocateFields();
+}
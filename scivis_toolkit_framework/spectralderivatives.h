@@ -0,0 +1,73 @@
+#ifndef SPECTRALDERIVATIVES_H
+#define SPECTRALDERIVATIVES_H
+
+#include "fftworkspace.h"
+#include "threadpool.h"
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Fields derived from the velocity spectrum that the solver transforms every step anyway. A derivative along x or y is
+// a multiplication of the spectrum by i times the wavenumber, so a field costs an inverse transform instead of a pass
+// of finite differences over the grid, and is exact for the resolved frequencies. The wavenumbers are the ones of
+// SpectralFilter, scaled by 2 pi / width to derivatives per grid cell. The Nyquist row and column of a real field have
+// no odd derivative, so they are dropped.
+// - The vorticity dv/dx - du/dy.
+// - The divergence du/dx + dv/dy before the projection, which is the part the projection removes: after it, the
+//   velocity is divergence-free up to rounding.
+// - The Q-criterion -(du/dx^2 + du/dy * dv/dx), the excess of rotation over strain of the divergence-free velocity.
+//   It is quadratic in the derivatives, so it takes the transforms of du/dx and du/dy + dv/dx besides the one of the
+//   vorticity.
+// Only the selected fields are computed; the others stay empty.
+class SpectralDerivatives
+{
+public:
+    // Bit flags of the fields to compute.
+    static constexpr unsigned int s_vorticity = 1U;
+    static constexpr unsigned int s_divergence = 2U;
+    static constexpr unsigned int s_qCriterion = 4U;
+
+private:
+    size_t m_width = 0U;
+    size_t m_height = 0U;
+    size_t m_spectrumColumns = 0U;
+    unsigned int m_fields = 0U;
+
+    // i times these is the derivative along x of a column, and along y of a row.
+    std::vector<float> m_wavenumbersX;
+    std::vector<float> m_wavenumbersY;
+
+    std::vector<std::complex<float>> m_spectrumA, m_spectrumB, m_spectrumC; // Overwritten by the inverse transforms.
+    std::vector<float> m_vorticity, m_divergence, m_qCriterion;
+    std::vector<float> m_strain, m_shear; // du/dx and du/dy + dv/dx, for the Q-criterion.
+
+    void allocateFields();
+
+public:
+    void resize(size_t const width, size_t const height);
+
+    // Called with the spectra U and V of the velocity, before and after the projection. normalizationFactor is the
+    // one of the inverse transforms of the velocity.
+    void computeUnprojected(std::complex<float> const * const U, std::complex<float> const * const V,
+                            float const normalizationFactor, FftWorkspace &fft, ThreadPool &threadPool);
+    void computeProjected(std::complex<float> const * const U, std::complex<float> const * const V,
+                          float const normalizationFactor, FftWorkspace &fft, ThreadPool &threadPool);
+
+    // Sets the selected fields to 0.
+    void reset();
+
+    // Getters
+    [[nodiscard]] unsigned int fields() const;
+    // Per grid cell, row-major like the velocity. Empty if not selected, except for the vorticity, which the
+    // Q-criterion needs as well.
+    [[nodiscard]] std::vector<float> const &vorticity() const;
+    [[nodiscard]] std::vector<float> const &divergence() const;
+    [[nodiscard]] std::vector<float> const &qCriterion() const;
+
+    // Setters
+    // A combination of the flags. The fields are computed from the next call on.
+    void setFields(unsigned int const fields);
+};
+
+#endif // SPECTRALDERIVATIVES_H
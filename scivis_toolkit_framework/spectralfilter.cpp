@@ -0,0 +1,150 @@
+#include "spectralfilter.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void SpectralFilter::update(size_t const width, size_t const height, float const dt, float const viscosity)
+{
+    ++m_numberOfUpdates;
+    if (width != m_width || height != m_height || viscosity != m_viscosity)
+    {
+        m_width = width;
+        m_height = height;
+        m_viscosity = viscosity;
+        m_tables.clear();
+    }
+
+    for (size_t idx = 0U; idx < m_tables.size(); ++idx)
+    {
+        if (m_tables[idx].dt == dt)
+        {
+            m_currentTables = idx;
+            m_tables[idx].lastUse = m_numberOfUpdates;
+            return;
+        }
+    }
+
+    // Replace the least recently used tables once the cache is full.
+    if (m_tables.size() < s_cachedTimeSteps)
+    {
+        m_tables.emplace_back();
+        m_currentTables = m_tables.size() - 1U;
+    }
+    else
+    {
+        m_currentTables = static_cast<size_t>(std::min_element(m_tables.cbegin(), m_tables.cend(),
+                                                               [](Tables const &a, Tables const &b)
+                                                               {
+                                                                   return a.lastUse < b.lastUse;
+                                                               }) - m_tables.cbegin());
+    }
+
+    Tables &tables = m_tables[m_currentTables];
+    tables.dt = dt;
+    tables.lastUse = m_numberOfUpdates;
+    computeTables(tables);
+}
+
+void SpectralFilter::computeTables(Tables &tables) const
+{
+    size_t const m = (m_width / 2U) + 1U; // Number of columns in the FFT matrix
+    tables.coefficientUU.resize(2U * m_height * m);
+    tables.coefficientUV.resize(2U * m_height * m);
+    tables.coefficientVV.resize(2U * m_height * m);
+
+    float const aspectRatio = static_cast<float>(m_width) / static_cast<float>(m_height);
+    for (size_t j = 0U; j < m_height; ++j)
+    {
+        for (size_t i = 0U; i < m; ++i)
+        {
+            auto const x = static_cast<float>(i);
+            float const y = aspectRatio * (j <= (m_height / 2U) ? static_cast<float>(j)
+                                                                : static_cast<float>(j) - static_cast<float>(m_height));
+            float const r = x * x + y * y;
+
+            // The mean flow (r == 0) passes unchanged.
+            float uu = 1.0F;
+            float uv = 0.0F;
+            float vv = 1.0F;
+            if (r != 0.0F)
+            {
+                float const filterFactor = std::exp(-r * tables.dt * m_viscosity);
+                uu = filterFactor * (1.0F - x * x / r);
+                uv = filterFactor * (-x * y / r);
+                vv = filterFactor * (1.0F - y * y / r);
+            }
+
+            size_t const idx = 2U * (i + (m * j));
+            tables.coefficientUU[idx] = tables.coefficientUU[idx + 1U] = uu;
+            tables.coefficientUV[idx] = tables.coefficientUV[idx + 1U] = uv;
+            tables.coefficientVV[idx] = tables.coefficientVV[idx + 1U] = vv;
+        }
+    }
+}
+
+size_t SpectralFilter::size() const
+{
+    return m_tables.empty() ? 0U : m_tables[m_currentTables].coefficientUU.size();
+}
+
+void SpectralFilter::apply(std::complex<float> *U, std::complex<float> *V, size_t const begin, size_t const end) const
+{
+    Q_ASSERT(begin % 2U == 0U && end <= size());
+
+    // std::complex<float> is stored as two consecutive floats.
+    float * const u = reinterpret_cast<float *>(U);
+    float * const v = reinterpret_cast<float *>(V);
+    Tables const &tables = m_tables[m_currentTables];
+    float const * const uu = tables.coefficientUU.data();
+    float const * const uv = tables.coefficientUV.data();
+    float const * const vv = tables.coefficientVV.data();
+
+    size_t idx = begin;
+
+#if defined(__AVX2__)
+    for (; idx + 8U <= end; idx += 8U)
+    {
+        __m256 const valueU = _mm256_loadu_ps(u + idx);
+        __m256 const valueV = _mm256_loadu_ps(v + idx);
+        __m256 const coefficientUV = _mm256_loadu_ps(uv + idx);
+
+        __m256 const newU = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(uu + idx), valueU),
+                                          _mm256_mul_ps(coefficientUV, valueV));
+        __m256 const newV = _mm256_add_ps(_mm256_mul_ps(coefficientUV, valueU),
+                                          _mm256_mul_ps(_mm256_loadu_ps(vv + idx), valueV));
+
+        _mm256_storeu_ps(u + idx, newU);
+        _mm256_storeu_ps(v + idx, newV);
+    }
+#elif defined(__ARM_NEON)
+    for (; idx + 4U <= end; idx += 4U)
+    {
+        float32x4_t const valueU = vld1q_f32(u + idx);
+        float32x4_t const valueV = vld1q_f32(v + idx);
+        float32x4_t const coefficientUV = vld1q_f32(uv + idx);
+
+        float32x4_t const newU = vmlaq_f32(vmulq_f32(vld1q_f32(uu + idx), valueU), coefficientUV, valueV);
+        float32x4_t const newV = vmlaq_f32(vmulq_f32(coefficientUV, valueU), vld1q_f32(vv + idx), valueV);
+
+        vst1q_f32(u + idx, newU);
+        vst1q_f32(v + idx, newV);
+    }
+#endif
+
+    // Scalar fallback, and the remainder of the vectorized loops.
+    for (; idx < end; ++idx)
+    {
+        float const valueU = u[idx];
+        float const valueV = v[idx];
+        u[idx] = uu[idx] * valueU + uv[idx] * valueV;
+        v[idx] = uv[idx] * valueU + vv[idx] * valueV;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SPECTRALFILTER_H
+#define SPECTRALFILTER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// The viscosity filter and the projection onto the divergence-free fields, applied to the velocity spectrum.
+// For every wavenumber k = (x, y) with r = |k|^2 the filter computes
+//     U' = f * ((1 - x^2 / r) * U - x * y / r * V),
+//     V' = f * (-x * y / r * U + (1 - y^2 / r) * V),
+// with f = exp(-r * dt * viscosity). On a width x height grid with square cells the domain is height / width times as
+// high as it is wide, so the wavenumbers along y are scaled by width / height.
+// The three coefficients in front of U and V only change with the grid size, dt and viscosity, so they are tabulated
+// once and reused by every step until one of those changes.
+// The tables hold every coefficient twice (for the real and the imaginary part), so applying the filter is a
+// streaming multiply-add over the interleaved complex values.
+// The adaptive time step of SimulationWorker alternates between a few fractions of dt as the number of substeps
+// follows the flow, so the tables of the last s_cachedTimeSteps values of dt are kept. Switching between them costs
+// nothing, instead of an exp per spectral cell; a change of the grid size or viscosity drops them all.
+class SpectralFilter
+{
+    // As many as the substep counts of SimulationWorker.
+    static constexpr size_t s_cachedTimeSteps = 8U;
+
+    struct Tables
+    {
+        float dt = -1.0F;
+        size_t lastUse = 0U;
+        std::vector<float> coefficientUU; // f * (1 - x^2 / r)
+        std::vector<float> coefficientUV; // -f * x * y / r
+        std::vector<float> coefficientVV; // f * (1 - y^2 / r)
+    };
+
+    size_t m_width = 0U;
+    size_t m_height = 0U;
+    float m_viscosity = -1.0F;
+
+    std::vector<Tables> m_tables;
+    size_t m_currentTables = 0U;
+    size_t m_numberOfUpdates = 0U;
+
+    void computeTables(Tables &tables) const;
+
+public:
+    // Selects the tables of dt, computing them if they are not cached, and drops the cached tables if the grid size or
+    // viscosity changed since the last call.
+    void update(size_t const width, size_t const height, float const dt, float const viscosity);
+
+    // The number of floats in a spectrum: two per complex value.
+    [[nodiscard]] size_t size() const;
+
+    // Filters the floats [begin, end) of the interleaved spectra U and V in place. begin must be even.
+    void apply(std::complex<float> *U, std::complex<float> *V, size_t const begin, size_t const end) const;
+};
+
+#endif // SPECTRALFILTER_H
@@ -0,0 +1,55 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// One slot is kept empty to tell a full queue from an empty one, so it holds capacity - 1 elements.
+template <typename T>
+class SpscQueue
+{
+    std::vector<T> m_buffer;
+    alignas(64) std::atomic<size_t> m_head{0U}; // Next element to pop, written by the consumer.
+    alignas(64) std::atomic<size_t> m_tail{0U}; // Next free slot, written by the producer.
+
+    [[nodiscard]] size_t next(size_t const idx) const
+    {
+        return idx + 1U == m_buffer.size() ? 0U : idx + 1U;
+    }
+
+public:
+    explicit SpscQueue(size_t const capacity)
+        :
+          m_buffer(capacity < 2U ? 2U : capacity)
+    {
+    }
+
+    // Producer only. Returns false, and drops the element, if the queue is full.
+    bool push(T const &value)
+    {
+        size_t const tail = m_tail.load(std::memory_order_relaxed);
+        size_t const nextTail = next(tail);
+        if (nextTail == m_head.load(std::memory_order_acquire))
+            return false;
+
+        m_buffer[tail] = value;
+        m_tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the queue is empty.
+    bool pop(T &value)
+    {
+        size_t const head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        value = m_buffer[head];
+        m_head.store(next(head), std::memory_order_release);
+        return true;
+    }
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,122 @@
+#include "streamingbuffer.h"
+
+#include <QDebug>
+
+#include <cstring>
+
+void StreamingBuffer::create(QOpenGLFunctions_3_3_Core * const gl)
+{
+    m_gl = gl;
+    m_gl->glGenBuffers(1, &m_buffer);
+}
+
+void StreamingBuffer::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    deleteFences();
+    m_gl->glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0U;
+    m_regionSize = 0U;
+}
+
+void StreamingBuffer::allocate(size_t const regionSize)
+{
+    // Orphaning: the driver keeps the old storage alive until pending draw calls are done with it.
+    deleteFences();
+    m_regionSize = regionSize;
+    m_currentRegion = s_numberOfRegions - 1U;
+
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    m_gl->glBufferData(GL_ARRAY_BUFFER,
+                       static_cast<GLsizeiptr>(s_numberOfRegions * m_regionSize),
+                       static_cast<GLvoid*>(nullptr),
+                       GL_STREAM_DRAW);
+}
+
+void *StreamingBuffer::map(size_t const size)
+{
+    if (size > m_regionSize)
+        allocate(size);
+
+    m_currentRegion = (m_currentRegion + 1U) % s_numberOfRegions;
+    waitForRegion(m_currentRegion);
+
+    m_gl->glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    void * const dataPtr = m_gl->glMapBufferRange(GL_ARRAY_BUFFER,
+                                                  static_cast<GLintptr>(m_currentRegion * m_regionSize),
+                                                  static_cast<GLsizeiptr>(size),
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                                  GL_MAP_UNSYNCHRONIZED_BIT);
+    m_isMapped = dataPtr != nullptr;
+    if (!m_isMapped)
+        qDebug() << "Warning: StreamingBuffer: mapping a region has failed";
+
+    return dataPtr;
+}
+
+// Unmapping a buffer that is not mapped raises GL_INVALID_OPERATION, so a failed map is not unmapped.
+GLintptr StreamingBuffer::unmap()
+{
+    if (m_isMapped && m_gl->glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+        qDebug() << "StreamingBuffer: buffer contents were lost while mapped";
+
+    m_isMapped = false;
+    return static_cast<GLintptr>(m_currentRegion * m_regionSize);
+}
+
+GLintptr StreamingBuffer::write(void const * const data, size_t const size)
+{
+    void * const dataPtr = map(size);
+    if (dataPtr == nullptr)
+        return static_cast<GLintptr>(m_currentRegion * m_regionSize);
+
+    std::memcpy(dataPtr, data, size);
+    return unmap();
+}
+
+void StreamingBuffer::fence()
+{
+    if (m_fences[m_currentRegion] != nullptr)
+        m_gl->glDeleteSync(m_fences[m_currentRegion]);
+
+    m_fences[m_currentRegion] = m_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Blocks until the GPU is done with the draw calls that read this region. With three regions this normally
+// returns immediately: the region was last used two frames ago.
+void StreamingBuffer::waitForRegion(size_t const region)
+{
+    GLsync &regionFence = m_fences[region];
+    if (regionFence == nullptr)
+        return;
+
+    GLuint64 constexpr timeout = 1'000'000'000U; // 1 second, in nanoseconds.
+    GLenum result = m_gl->glClientWaitSync(regionFence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = m_gl->glClientWaitSync(regionFence, 0, timeout);
+
+    if (result == GL_WAIT_FAILED)
+        qDebug() << "StreamingBuffer: waiting for a fence failed";
+
+    m_gl->glDeleteSync(regionFence);
+    regionFence = nullptr;
+}
+
+void StreamingBuffer::deleteFences()
+{
+    for (GLsync &regionFence : m_fences)
+    {
+        if (regionFence != nullptr)
+            m_gl->glDeleteSync(regionFence);
+
+        regionFence = nullptr;
+    }
+}
+
+// Getters
+GLuint StreamingBuffer::buffer() const
+{
+    return m_buffer;
+}
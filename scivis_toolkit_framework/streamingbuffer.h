@@ -0,0 +1,55 @@
+#ifndef STREAMINGBUFFER_H
+#define STREAMINGBUFFER_H
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <array>
+#include <cstddef>
+
+// A vertex buffer for data that is uploaded every frame.
+// The buffer is split into s_numberOfRegions regions that are written round-robin, so the CPU writes one region while
+// the GPU may still read the others. A fence per region makes sure a region is never overwritten while it is in use.
+// The regions are mapped unsynchronized, which avoids the implicit synchronization (or hidden copy) of
+// glBufferSubData and glMapBuffer on a buffer that is still being read.
+//
+// Usage per frame: write (or map/unmap) the data, point the vertex attributes at the returned offset, draw, then fence.
+class StreamingBuffer
+{
+    static constexpr size_t s_numberOfRegions = 3U;
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    GLuint m_buffer = 0U;
+
+    size_t m_regionSize = 0U; // In bytes.
+    size_t m_currentRegion = s_numberOfRegions - 1U;
+    std::array<GLsync, s_numberOfRegions> m_fences{};
+    bool m_isMapped = false; // Whether the last map succeeded and has not been unmapped yet.
+
+    void waitForRegion(size_t const region);
+    void deleteFences();
+
+public:
+    void create(QOpenGLFunctions_3_3_Core * const gl);
+    void destroy();
+
+    // (Re)allocates the buffer storage, orphaning the previous storage.
+    void allocate(size_t const regionSize);
+
+    // Maps the next free region for writing and binds the buffer to GL_ARRAY_BUFFER.
+    // The storage grows if size exceeds the region size. Returns nullptr if the region cannot be mapped.
+    [[nodiscard]] void *map(size_t const size);
+    // Unmaps the region, unless its map failed, and returns its byte offset within the buffer.
+    GLintptr unmap();
+
+    // Copies the data into the next free region and returns its byte offset within the buffer. Nothing is copied if
+    // the region cannot be mapped.
+    GLintptr write(void const * const data, size_t const size);
+
+    // Marks the current region as in use by the draw calls issued so far.
+    void fence();
+
+    // Getters
+    [[nodiscard]] GLuint buffer() const;
+};
+
+#endif // STREAMINGBUFFER_H
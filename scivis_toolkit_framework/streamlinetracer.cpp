@@ -0,0 +1,338 @@
+#include "streamlinetracer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr size_t s_batchSize = StreamlineTracer::s_batchSize;
+    using Lanes = std::array<float, s_batchSize>;
+    using Corners = std::array<int, s_batchSize>;
+
+    // The lower left corners of the bilinear stencils and the weights within their cells. The positions are clamped
+    // to the grid and the corners to one cell before its last row and column, so all four corners of every stencil
+    // are inside the grid and the samples are read without bounds checks.
+    inline void stencils(Lanes const &x, Lanes const &y, int const DIMX, int const DIMY, Corners &corners, Lanes &s,
+                         Lanes &t)
+    {
+        auto const lastX = static_cast<float>(DIMX - 1);
+        auto const lastY = static_cast<float>(DIMY - 1);
+        for (size_t lane = 0U; lane < s_batchSize; ++lane)
+        {
+            float const cx = std::clamp(x[lane], 0.0F, lastX);
+            float const cy = std::clamp(y[lane], 0.0F, lastY);
+            int const i0 = std::min(static_cast<int>(cx), DIMX - 2);
+            int const j0 = std::min(static_cast<int>(cy), DIMY - 2);
+
+            s[lane] = cx - static_cast<float>(i0);
+            t[lane] = cy - static_cast<float>(j0);
+            corners[lane] = i0 + DIMX * j0;
+        }
+    }
+
+    inline void bilinear(float const *field, int const DIMX, Corners const &corners, Lanes const &s, Lanes const &t,
+                         Lanes &result)
+    {
+#if defined(__AVX2__)
+        static_assert(s_batchSize == 8U, "One batch is one AVX2 vector");
+
+        __m256i const idx00 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(corners.data()));
+        __m256i const idx10 = _mm256_add_epi32(idx00, _mm256_set1_epi32(1));
+        __m256i const idx01 = _mm256_add_epi32(idx00, _mm256_set1_epi32(DIMX));
+        __m256i const idx11 = _mm256_add_epi32(idx01, _mm256_set1_epi32(1));
+
+        __m256 const sv = _mm256_loadu_ps(s.data());
+        __m256 const tv = _mm256_loadu_ps(t.data());
+        __m256 const a = _mm256_i32gather_ps(field, idx00, 4);
+        __m256 const b = _mm256_i32gather_ps(field, idx01, 4);
+        __m256 const c = _mm256_i32gather_ps(field, idx10, 4);
+        __m256 const d = _mm256_i32gather_ps(field, idx11, 4);
+
+        __m256 const left = _mm256_add_ps(a, _mm256_mul_ps(tv, _mm256_sub_ps(b, a)));
+        __m256 const right = _mm256_add_ps(c, _mm256_mul_ps(tv, _mm256_sub_ps(d, c)));
+        _mm256_storeu_ps(result.data(), _mm256_add_ps(left, _mm256_mul_ps(sv, _mm256_sub_ps(right, left))));
+#else
+        for (size_t lane = 0U; lane < s_batchSize; ++lane)
+        {
+            int const idx = corners[lane];
+            float const left = field[idx] + t[lane] * (field[idx + DIMX] - field[idx]);
+            float const right = field[idx + 1] + t[lane] * (field[idx + DIMX + 1] - field[idx + 1]);
+            result[lane] = left + s[lane] * (right - left);
+        }
+#endif
+    }
+
+    // The velocity of one frame, normalized to the step size.
+    class FieldSampler
+    {
+        float const *m_velocityX;
+        float const *m_velocityY;
+        int m_DIMX;
+        int m_DIMY;
+        float m_stepSize;
+
+    public:
+        FieldSampler(std::vector<float> const &velocityX, std::vector<float> const &velocityY, size_t const DIMX,
+                     size_t const DIMY, float const stepSize)
+            :
+              m_velocityX(velocityX.data()),
+              m_velocityY(velocityY.data()),
+              m_DIMX(static_cast<int>(DIMX)),
+              m_DIMY(static_cast<int>(DIMY)),
+              m_stepSize(stepSize)
+        {}
+
+        void sample(Lanes const &x, Lanes const &y, float const, Lanes &dx, Lanes &dy, Lanes &speed) const
+        {
+            Corners corners;
+            Lanes s;
+            Lanes t;
+            stencils(x, y, m_DIMX, m_DIMY, corners, s, t);
+            bilinear(m_velocityX, m_DIMX, corners, s, t, dx);
+            bilinear(m_velocityY, m_DIMX, corners, s, t, dy);
+
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                speed[lane] = std::sqrt(dx[lane] * dx[lane] + dy[lane] * dy[lane]);
+                float const scale = m_stepSize / std::max(speed[lane], 1e-20F);
+                dx[lane] *= scale;
+                dy[lane] *= scale;
+            }
+        }
+    };
+
+    // The velocity history, linear in time between its frames. The displacement is in cells per frame.
+    class HistorySampler
+    {
+        TimeHistory const &m_historyX;
+        TimeHistory const &m_historyY;
+        int m_DIMX;
+        int m_DIMY;
+        float m_cellsPerVelocity;
+
+    public:
+        HistorySampler(TimeHistory const &historyX, TimeHistory const &historyY, float const cellsPerVelocity)
+            :
+              m_historyX(historyX),
+              m_historyY(historyY),
+              m_DIMX(static_cast<int>(historyX.DIMX())),
+              m_DIMY(static_cast<int>(historyX.DIMY())),
+              m_cellsPerVelocity(cellsPerVelocity)
+        {}
+
+        void sample(Lanes const &x, Lanes const &y, float const time, Lanes &dx, Lanes &dy, Lanes &speed) const
+        {
+            Corners corners;
+            Lanes s;
+            Lanes t;
+            stencils(x, y, m_DIMX, m_DIMY, corners, s, t);
+
+            size_t const last = m_historyX.capacity() - 1U;
+            auto const t0 = std::min(static_cast<size_t>(time), last);
+            size_t const t1 = std::min(t0 + 1U, last);
+            float const w = time - static_cast<float>(t0);
+
+            auto const value = [&](TimeHistory const &history, size_t const lane)
+            {
+                auto const i = static_cast<size_t>(corners[lane] % m_DIMX);
+                auto const j = static_cast<size_t>(corners[lane] / m_DIMX);
+                auto const at = [&](size_t const di, size_t const dj)
+                {
+                    float const first = history.value(i + di, j + dj, t0);
+                    return first + w * (history.value(i + di, j + dj, t1) - first);
+                };
+
+                float const left = at(0U, 0U) + t[lane] * (at(0U, 1U) - at(0U, 0U));
+                float const right = at(1U, 0U) + t[lane] * (at(1U, 1U) - at(1U, 0U));
+                return left + s[lane] * (right - left);
+            };
+
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                float const u = value(m_historyX, lane);
+                float const v = value(m_historyY, lane);
+                speed[lane] = std::sqrt(u * u + v * v);
+                dx[lane] = m_cellsPerVelocity * u;
+                dy[lane] = m_cellsPerVelocity * v;
+            }
+        }
+    };
+
+    // Traces the batch of seeds starting at firstSeed; a partial batch repeats its last seed in the unused lanes.
+    // After numberOfSteps steps, or once all lanes left the grid, the remaining vertices repeat the last one.
+    template <typename Sampler>
+    float traceBatch(Sampler const &sampler, std::vector<StreamlineTracer::Seed> const &seeds, size_t const firstSeed,
+                     size_t const numberOfVertices, size_t const numberOfSteps, float const startTime,
+                     size_t const DIMX, size_t const DIMY, StreamlineTracer::Vertex *result)
+    {
+        size_t const count = std::min(s_batchSize, seeds.size() - firstSeed);
+        auto const lastX = static_cast<float>(DIMX - 1U);
+        auto const lastY = static_cast<float>(DIMY - 1U);
+
+        Lanes x;
+        Lanes y;
+        std::array<bool, s_batchSize> active{};
+        for (size_t lane = 0U; lane < s_batchSize; ++lane)
+        {
+            StreamlineTracer::Seed const &seed = seeds[firstSeed + std::min(lane, count - 1U)];
+            x[lane] = seed.x;
+            y[lane] = seed.y;
+            active[lane] = seed.x >= 0.0F && seed.x <= lastX && seed.y >= 0.0F && seed.y <= lastY;
+        }
+
+        Lanes k1x, k1y, k2x, k2y, k3x, k3y, k4x, k4y;
+        Lanes px, py;
+        Lanes speed;
+        Lanes stageSpeed;
+        float maxSpeed = 0.0F;
+        float time = startTime;
+        for (size_t vertex = 0U; vertex < numberOfVertices; ++vertex)
+        {
+            // The first stage also gives the speed at the vertex.
+            sampler.sample(x, y, time, k1x, k1y, speed);
+            for (size_t lane = 0U; lane < count; ++lane)
+            {
+                result[(firstSeed + lane) * numberOfVertices + vertex] = {x[lane], y[lane], speed[lane]};
+                maxSpeed = std::max(maxSpeed, speed[lane]);
+            }
+
+            bool const anyActive = std::find(active.cbegin(), active.cend(), true) != active.cend();
+            if (vertex == numberOfSteps || !anyActive)
+            {
+                for (size_t lane = 0U; lane < count; ++lane)
+                {
+                    StreamlineTracer::Vertex *const line = result + (firstSeed + lane) * numberOfVertices;
+                    std::fill(line + vertex + 1U, line + numberOfVertices, line[vertex]);
+                }
+                break;
+            }
+
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                px[lane] = x[lane] + 0.5F * k1x[lane];
+                py[lane] = y[lane] + 0.5F * k1y[lane];
+            }
+            sampler.sample(px, py, time + 0.5F, k2x, k2y, stageSpeed);
+
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                px[lane] = x[lane] + 0.5F * k2x[lane];
+                py[lane] = y[lane] + 0.5F * k2y[lane];
+            }
+            sampler.sample(px, py, time + 0.5F, k3x, k3y, stageSpeed);
+
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                px[lane] = x[lane] + k3x[lane];
+                py[lane] = y[lane] + k3y[lane];
+            }
+            sampler.sample(px, py, time + 1.0F, k4x, k4y, stageSpeed);
+
+            // A lane that leaves the grid stops at its last position inside.
+            for (size_t lane = 0U; lane < s_batchSize; ++lane)
+            {
+                float const nx = x[lane] + (k1x[lane] + 2.0F * (k2x[lane] + k3x[lane]) + k4x[lane]) / 6.0F;
+                float const ny = y[lane] + (k1y[lane] + 2.0F * (k2y[lane] + k3y[lane]) + k4y[lane]) / 6.0F;
+                active[lane] = active[lane] && nx >= 0.0F && nx <= lastX && ny >= 0.0F && ny <= lastY;
+                x[lane] = active[lane] ? nx : x[lane];
+                y[lane] = active[lane] ? ny : y[lane];
+            }
+
+            time += 1.0F;
+        }
+
+        return maxSpeed;
+    }
+
+    template <typename Sampler>
+    float traceAll(Sampler const &sampler, std::vector<StreamlineTracer::Seed> const &seeds,
+                   size_t const numberOfVertices, size_t const numberOfSteps, float const startTime, size_t const DIMX,
+                   size_t const DIMY, ThreadPool &threadPool, std::vector<float> &threadMaxima, StreamlineTracer::Vertex *result)
+    {
+        size_t const numberOfBatches = (seeds.size() + s_batchSize - 1U) / s_batchSize;
+        threadMaxima.assign(threadPool.threadCount(), 0.0F);
+
+        threadPool.parallelFor(0U, numberOfBatches, [&](size_t const begin, size_t const end, size_t const thread)
+        {
+            for (size_t batch = begin; batch < end; ++batch)
+            {
+                float const maxSpeed = traceBatch(sampler, seeds, batch * s_batchSize, numberOfVertices,
+                                                  numberOfSteps, startTime, DIMX, DIMY, result);
+                threadMaxima[thread] = std::max(threadMaxima[thread], maxSpeed);
+            }
+        });
+
+        return *std::max_element(threadMaxima.cbegin(), threadMaxima.cend());
+    }
+}
+
+float StreamlineTracer::traceStreamlines(std::vector<float> const &velocityX,
+                                         std::vector<float> const &velocityY,
+                                         size_t const DIMX,
+                                         size_t const DIMY,
+                                         std::vector<Seed> const &seeds,
+                                         size_t const numberOfVertices,
+                                         float const stepSize,
+                                         ThreadPool &threadPool,
+                                         Vertex *result)
+{
+    if (DIMX < 2U || DIMY < 2U || seeds.empty() || numberOfVertices == 0U ||
+        velocityX.size() != DIMX * DIMY || velocityY.size() != DIMX * DIMY)
+        return 0.0F;
+
+    FieldSampler const sampler{velocityX, velocityY, DIMX, DIMY, stepSize};
+    return traceAll(sampler, seeds, numberOfVertices, numberOfVertices - 1U, 0.0F, DIMX, DIMY, threadPool,
+                    m_threadMaxima, result);
+}
+
+void StreamlineTracer::recordFrame(std::vector<float> const &velocityX,
+                                   std::vector<float> const &velocityY,
+                                   size_t const DIMX,
+                                   size_t const DIMY,
+                                   size_t const capacity,
+                                   size_t const step)
+{
+    if (m_historyX.DIMX() != DIMX || m_historyX.DIMY() != DIMY || m_historyX.capacity() != capacity ||
+        (!m_historySteps.empty() && step < m_historySteps.back()))
+    {
+        m_historyX.reset(DIMX, DIMY, capacity);
+        m_historyY.reset(DIMX, DIMY, capacity);
+        m_historySteps.clear();
+    }
+
+    if (capacity == 0U || velocityX.size() != DIMX * DIMY || velocityY.size() != DIMX * DIMY ||
+        (!m_historySteps.empty() && step == m_historySteps.back()))
+        return;
+
+    m_historyX.push(velocityX);
+    m_historyY.push(velocityY);
+    m_historySteps.push_back(step);
+    if (m_historySteps.size() > capacity)
+        m_historySteps.pop_front();
+}
+
+float StreamlineTracer::tracePathlines(std::vector<Seed> const &seeds, float const dt, ThreadPool &threadPool,
+                                       Vertex *result)
+{
+    size_t const DIMX = m_historyX.DIMX();
+    size_t const DIMY = m_historyX.DIMY();
+    size_t const capacity = m_historyX.capacity();
+    size_t const size = m_historyX.size();
+    if (DIMX < 2U || DIMY < 2U || seeds.empty() || size == 0U)
+        return 0.0F;
+
+    // The frames are not always consecutive steps, the renderer may skip some.
+    float const stepsPerFrame = size > 1U ? static_cast<float>(m_historySteps.back() - m_historySteps.front()) /
+                                            static_cast<float>(size - 1U)
+                                          : 0.0F;
+
+    // The cells are 1 / DIMX wide in the units of the velocity, see advection.h.
+    HistorySampler const sampler{m_historyX, m_historyY, static_cast<float>(DIMX) * dt * stepsPerFrame};
+    return traceAll(sampler, seeds, capacity, size - 1U, static_cast<float>(capacity - size), DIMX, DIMY, threadPool,
+                    m_threadMaxima, result);
+}
@@ -0,0 +1,71 @@
+#ifndef STREAMLINETRACER_H
+#define STREAMLINETRACER_H
+
+#include "threadpool.h"
+#include "timehistory.h"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Streamlines and pathlines of the velocity on a row-major grid of DIMX * DIMY values, integrated with RK4 from
+// a list of seeds. Every line has the same number of vertices: line k is [k * numberOfVertices, (k + 1) *
+// numberOfVertices) of the result, so the threads write disjoint ranges, straight into a mapped vertex buffer, and the
+// lines are drawn as line strips. A line that leaves the grid repeats its last vertex.
+// The seeds are traced in batches of s_batchSize, one RK4 stage for the whole batch at a time, and the batches are
+// distributed over the threads of a ThreadPool. The work grows with the number of seeds and vertices, not with the grid.
+class StreamlineTracer
+{
+public:
+    struct Vertex
+    {
+        float x;     // Grid coordinates: (i, j) is the position of value i + j * DIMX.
+        float y;
+        float speed; // Magnitude of the velocity at the vertex.
+    };
+
+    struct Seed
+    {
+        float x; // Grid coordinates, like Vertex.
+        float y;
+    };
+
+    static constexpr size_t s_batchSize = 8U;
+
+private:
+    // The velocities of the last frames, for the pathlines.
+    TimeHistory m_historyX;
+    TimeHistory m_historyY;
+    std::deque<size_t> m_historySteps; // The simulation step of every frame in the history, oldest first.
+
+    std::vector<float> m_threadMaxima; // The largest speed per thread.
+
+public:
+    // The lines follow the direction of the field in steps of stepSize cells, so they advance evenly where the flow is
+    // slow. Returns the largest speed on the lines.
+    float traceStreamlines(std::vector<float> const &velocityX,
+                           std::vector<float> const &velocityY,
+                           size_t const DIMX,
+                           size_t const DIMY,
+                           std::vector<Seed> const &seeds,
+                           size_t const numberOfVertices,
+                           float const stepSize,
+                           ThreadPool &threadPool,
+                           Vertex *result);
+
+    // Adds a frame to the velocity history of the pathlines. The history keeps the last capacity frames and restarts
+    // when the grid or capacity changes, or when the simulation restarts. A frame of the newest step is ignored.
+    void recordFrame(std::vector<float> const &velocityX,
+                     std::vector<float> const &velocityY,
+                     size_t const DIMX,
+                     size_t const DIMY,
+                     size_t const capacity,
+                     size_t const step);
+
+    // The seeds are released at the oldest frame of the history and advected to the newest one, one RK4 step per frame.
+    // dt is the time step of the simulation. Every line has capacity vertices, see recordFrame.
+    // Returns the largest speed on the lines.
+    float tracePathlines(std::vector<Seed> const &seeds, float const dt, ThreadPool &threadPool, Vertex *result);
+};
+
+#endif // STREAMLINETRACER_H
@@ -0,0 +1,101 @@
+#include "threadpool.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t const threadCount)
+    :
+      m_threadCount(std::max<size_t>(threadCount, 1U))
+{
+    m_workers.reserve(m_threadCount - 1U);
+    for (size_t thread = 1U; thread < m_threadCount; ++thread)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, thread);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (std::thread &worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t const begin, size_t const end, RangeFunction const &function)
+{
+    if (begin >= end)
+        return;
+
+    // Not worth waking up the workers.
+    if (m_workers.empty() || end - begin == 1U)
+    {
+        function(begin, end, 0U);
+        return;
+    }
+
+    std::lock_guard<std::mutex> const dispatchLock{m_dispatchMutex};
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_function = &function;
+        m_begin = begin;
+        m_end = end;
+        m_pendingWorkers = m_workers.size();
+        ++m_generation;
+    }
+    m_workAvailable.notify_all();
+
+    runChunk(0U);
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_workDone.wait(lock, [this] { return m_pendingWorkers == 0U; });
+    m_function = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t const thread)
+{
+    size_t lastGeneration = 0U;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_workAvailable.wait(lock, [this, lastGeneration] { return m_stopping || m_generation != lastGeneration; });
+            if (m_stopping)
+                return;
+            lastGeneration = m_generation;
+        }
+
+        runChunk(thread);
+
+        {
+            std::lock_guard<std::mutex> const lock{m_mutex};
+            --m_pendingWorkers;
+        }
+        m_workDone.notify_one();
+    }
+}
+
+// Processes the part of the current range that belongs to the given thread.
+void ThreadPool::runChunk(size_t const thread) const
+{
+    Q_ASSERT(m_function != nullptr);
+
+    size_t const count = m_end - m_begin;
+    size_t const chunkBegin = m_begin + (count * thread) / m_threadCount;
+    size_t const chunkEnd = m_begin + (count * (thread + 1U)) / m_threadCount;
+    if (chunkBegin < chunkEnd)
+        (*m_function)(chunkBegin, chunkEnd, thread);
+}
+
+size_t ThreadPool::threadCount() const
+{
+    return m_threadCount;
+}
+
+size_t ThreadPool::hardwareThreadCount()
+{
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1U);
+}
@@ -0,0 +1,53 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that split index ranges between them.
+// The calling thread takes part in the work, so a pool of N threads starts N - 1 workers.
+class ThreadPool
+{
+public:
+    // Receives the half-open range [begin, end) and the index of the thread that processes it (0 <= thread < threadCount()).
+    using RangeFunction = std::function<void(size_t const begin, size_t const end, size_t const thread)>;
+
+private:
+    size_t m_threadCount;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_dispatchMutex; // Serializes calls to parallelFor.
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+
+    RangeFunction const *m_function = nullptr;
+    size_t m_begin = 0U;
+    size_t m_end = 0U;
+    size_t m_generation = 0U;
+    size_t m_pendingWorkers = 0U;
+    bool m_stopping = false;
+
+    void workerLoop(size_t const thread);
+    void runChunk(size_t const thread) const;
+
+public:
+    explicit ThreadPool(size_t const threadCount);
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+    ~ThreadPool();
+
+    // Splits [begin, end) into threadCount() contiguous chunks and blocks until all of them are processed.
+    void parallelFor(size_t const begin, size_t const end, RangeFunction const &function);
+
+    [[nodiscard]] size_t threadCount() const;
+
+    // The number of hardware threads, or 1 if this cannot be determined.
+    [[nodiscard]] static size_t hardwareThreadCount();
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,139 @@
+#include "timehistory.h"
+
+#include <algorithm>
+
+void TimeHistory::reset(size_t const DIMX, size_t const DIMY, size_t const capacity)
+{
+    if (DIMX != m_DIMX || DIMY != m_DIMY || capacity != m_capacity)
+    {
+        m_DIMX = DIMX;
+        m_DIMY = DIMY;
+        m_capacity = capacity;
+        m_numberOfTileColumns = (DIMX + s_tileWidth - 1U) / s_tileWidth;
+        m_values.assign(m_numberOfTileColumns * m_DIMY * m_capacity * s_tileWidth, 0.0F);
+    }
+
+    clear();
+}
+
+void TimeHistory::clear()
+{
+    m_size = 0U;
+    m_newestSlot = m_capacity > 0U ? m_capacity - 1U : 0U;
+}
+
+void TimeHistory::push(std::vector<float> const &frame)
+{
+    if (m_capacity == 0U || frame.size() != m_DIMX * m_DIMY)
+        return;
+
+    m_newestSlot = (m_newestSlot + 1U) % m_capacity;
+    m_size = std::min(m_size + 1U, m_capacity);
+
+    for (size_t y = 0U; y < m_DIMY; ++y)
+    {
+        float const * const row = frame.data() + y * m_DIMX;
+        for (size_t tileColumn = 0U; tileColumn < m_numberOfTileColumns; ++tileColumn)
+        {
+            size_t const firstX = tileColumn * s_tileWidth;
+            size_t const width = std::min(s_tileWidth, m_DIMX - firstX);
+            std::copy_n(row + firstX, width, m_values.begin() + tileOffset(tileColumn, y) + m_newestSlot * s_tileWidth);
+        }
+    }
+}
+
+// Getters
+size_t TimeHistory::DIMX() const
+{
+    return m_DIMX;
+}
+
+size_t TimeHistory::DIMY() const
+{
+    return m_DIMY;
+}
+
+size_t TimeHistory::capacity() const
+{
+    return m_capacity;
+}
+
+size_t TimeHistory::size() const
+{
+    return m_size;
+}
+
+float TimeHistory::value(size_t const x, size_t const y, size_t const t) const
+{
+    size_t const tileColumn = x / s_tileWidth;
+    return m_values[tileOffset(tileColumn, y) + slot(t) * s_tileWidth + x % s_tileWidth];
+}
+
+void TimeHistory::sliceX(size_t const x, size_t const numberOfFrames, std::vector<float> &result) const
+{
+    if (m_size == 0U)
+        return;
+
+    size_t const width = std::min(numberOfFrames, m_capacity);
+    size_t const firstT = m_capacity - width;
+    result.resize(m_DIMY * width);
+    size_t const tileColumn = x / s_tileWidth;
+    size_t const xInTile = x % s_tileWidth;
+    for (size_t y = 0U; y < m_DIMY; ++y)
+    {
+        size_t const offset = tileOffset(tileColumn, y) + xInTile;
+        for (size_t t = 0U; t < width; ++t)
+            result[y * width + t] = m_values[offset + slot(firstT + t) * s_tileWidth];
+    }
+}
+
+void TimeHistory::sliceY(size_t const y, size_t const numberOfFrames, std::vector<float> &result) const
+{
+    if (m_size == 0U)
+        return;
+
+    size_t const height = std::min(numberOfFrames, m_capacity);
+    size_t const firstT = m_capacity - height;
+    result.resize(height * m_DIMX);
+    for (size_t t = 0U; t < height; ++t)
+    {
+        size_t const slotOffset = slot(firstT + t) * s_tileWidth;
+        for (size_t tileColumn = 0U; tileColumn < m_numberOfTileColumns; ++tileColumn)
+        {
+            size_t const firstX = tileColumn * s_tileWidth;
+            size_t const width = std::min(s_tileWidth, m_DIMX - firstX);
+            std::copy_n(m_values.begin() + tileOffset(tileColumn, y) + slotOffset, width, result.begin() + t * m_DIMX + firstX);
+        }
+    }
+}
+
+void TimeHistory::sliceT(size_t const t, std::vector<float> &result) const
+{
+    if (m_size == 0U)
+        return;
+
+    result.resize(m_DIMX * m_DIMY);
+    size_t const slotOffset = slot(t) * s_tileWidth;
+    for (size_t y = 0U; y < m_DIMY; ++y)
+    {
+        for (size_t tileColumn = 0U; tileColumn < m_numberOfTileColumns; ++tileColumn)
+        {
+            size_t const firstX = tileColumn * s_tileWidth;
+            size_t const width = std::min(s_tileWidth, m_DIMX - firstX);
+            std::copy_n(m_values.begin() + tileOffset(tileColumn, y) + slotOffset, width, result.begin() + y * m_DIMX + firstX);
+        }
+    }
+}
+
+// Maps a window position to a ring buffer slot. Positions before the oldest frame map to the oldest frame.
+size_t TimeHistory::slot(size_t const t) const
+{
+    size_t const age = std::min(m_capacity - 1U - std::min(t, m_capacity - 1U), m_size - 1U); // 0 is the newest frame.
+    return (m_newestSlot + m_capacity - age) % m_capacity;
+}
+
+// Offset of the tile holding the s_tileWidth values starting at x = tileColumn * s_tileWidth of row y, for all slots.
+size_t TimeHistory::tileOffset(size_t const tileColumn, size_t const y) const
+{
+    return (tileColumn * m_DIMY + y) * m_capacity * s_tileWidth;
+}
@@ -0,0 +1,55 @@
+#ifndef TIMEHISTORY_H
+#define TIMEHISTORY_H
+
+#include <cstddef>
+#include <vector>
+
+// A fixed-capacity ring buffer of the most recent scalar fields of a DIMX x DIMY grid, seen as a 3D block (x, y, t).
+// Slices are indexed by the position t in the window, with t = capacity() - 1 the newest frame. Until the window is
+// full, the positions before the oldest frame repeat the oldest frame.
+//
+// The storage is allocated once per shape and every new frame overwrites the oldest one in place.
+// The values are stored in tiles of s_tileWidth neighbouring x values: the tile of (tile column, y) holds those
+// values for all frames, frame after frame. A t-slice then reads runs of s_tileWidth values, an x-slice reads one
+// value every s_tileWidth values and a y-slice reads whole tiles, instead of one value per DIMX values for an x-slice
+// of frames stored one after the other.
+class TimeHistory
+{
+    static constexpr size_t s_tileWidth = 8U;
+
+    size_t m_DIMX = 0U;
+    size_t m_DIMY = 0U;
+    size_t m_capacity = 0U;
+    size_t m_numberOfTileColumns = 0U;
+    size_t m_size = 0U;         // Number of frames held, at most m_capacity.
+    size_t m_newestSlot = 0U;   // Slot of the newest frame.
+    std::vector<float> m_values;
+
+    [[nodiscard]] size_t slot(size_t const t) const;
+    [[nodiscard]] size_t tileOffset(size_t const tileColumn, size_t const y) const;
+
+public:
+    // (Re)allocates the storage if the shape changed. The history is empty afterwards.
+    void reset(size_t const DIMX, size_t const DIMY, size_t const capacity);
+    void clear();
+
+    // Copies a DIMX x DIMY frame over the oldest frame.
+    void push(std::vector<float> const &frame);
+
+    // Getters
+    [[nodiscard]] size_t DIMX() const;
+    [[nodiscard]] size_t DIMY() const;
+    [[nodiscard]] size_t capacity() const;
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] float value(size_t const x, size_t const y, size_t const t) const;
+
+    // The slices are row-major images. A slice of an empty history is left unchanged.
+    // The x slice is numberOfFrames columns (t) by DIMY rows (y), the y slice DIMX columns (x) by numberOfFrames rows
+    // (t). Both cover the newest numberOfFrames positions of the window, at most capacity().
+    void sliceX(size_t const x, size_t const numberOfFrames, std::vector<float> &result) const;
+    void sliceY(size_t const y, size_t const numberOfFrames, std::vector<float> &result) const;
+    void sliceT(size_t const t, std::vector<float> &result) const; // DIMX columns (x) by DIMY rows (y).
+};
+
+#endif // TIMEHISTORY_H
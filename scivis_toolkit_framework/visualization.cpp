@@ -9,15 +9,20 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <utility>
 
 Visualization::Visualization(QWidget *parent) : QOpenGLWidget(parent)
 {
     qDebug() << "Visualization constructor";
 
+    m_glyphResampler.setShape(m_DIMX, m_DIMY, m_numberOfGlyphsX, m_numberOfGlyphsY);
+
     using namespace std::chrono_literals;
 
-    // Start the simulation loop.
-    m_timer.start(17ms); // Each frame takes 17ms, making the simulation run at approximately 60 FPS
+    // Start the simulation loop. The simulation steps on its own thread; the timer only triggers repaints.
+    m_simulationWorker.setProfiler(&m_profiler);
+    m_simulationWorker.start();
+    m_timer.start(17ms); // Each frame takes 17ms, making the visualization run at approximately 60 FPS
     connect(&m_timer, SIGNAL(timeout()), this, SLOT(doOneSimulationStep()));
 
     m_elapsedTimer.start();
@@ -29,15 +34,45 @@ Visualization::~Visualization()
 
     qDebug() << "Visualization destructor";
 
+    m_simulationWorker.stop();
+
     opengl_deleteObjects();
 }
 
 void Visualization::doOneSimulationStep()
 {
-    if (m_isRunning)
-        m_simulation.doOneSimulationStep();
+    m_simulationWorker.setPaused(!m_isRunning || simulatesOnGpu());
 
-    update();
+    if (needsRender())
+        update();
+}
+
+void Visualization::requestRender()
+{
+    ++m_parameterRevision;
+}
+
+// A new simulation frame, a changed parameter, or an image that changes by itself: the GPU simulation, the ping-pong
+// LIC until its convolution has converged, the volume rendering clock, and the progressive volume rendering until all
+// of its frames are averaged.
+bool Visualization::needsRender() const
+{
+    if (m_parameterRevision != m_renderedParameterRevision || m_simulationWorker.hasNewFrame())
+        return true;
+
+    if (simulatesOnGpu() && m_isRunning)
+        return true;
+
+    // A few passes per paint only, so a convolution that restarted from noise takes several paints to converge.
+    if (m_drawLIC && !m_drawHeightplot && m_licReuseConvolution &&
+        (!m_licConvolutionIsValid || m_licPassesSinceReset < s_licConvergencePassesPerStep * m_licStreamlineLength))
+        return true;
+
+    // The isosurface is drawn at once, without the progressive frames.
+    bool const drawsIsosurface = m_drawVolumeIsosurface && m_volumeRenderTexture == VolumeRenderTexture::DataRaw;
+    return m_drawVolumeRendering &&
+           (!m_volumeRenderingTimeIsPaused ||
+            (!drawsIsosurface && m_volumeRenderingProgressiveFrame < s_volumeRenderingProgressiveFrames));
 }
 
 void Visualization::initializeGL()
@@ -62,74 +97,229 @@ void Visualization::initializeGL()
 
     glClearColor(0.2F, 0.1F, 0.2F, 1.0F);
 
-    // Retrieve default textures.
+    // The triangle strips of the grid are separated by restart indices, see opengl_setupScalarData.
+    glEnable(GL_PRIMITIVE_RESTART);
+
+    // Retrieve the default color maps.
     auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
-    std::vector<Color> const defaultScalarDataColorMap = mainWindowPtr->m_defaultScalarDataColorMap;
-    std::vector<Color> const defaultVectorDataColorMap = mainWindowPtr->m_defaultVectorDataColorMap;
 
     opengl_generateObjects();
     opengl_createShaderPrograms();
 
     opengl_setupAllBuffers();
+    opengl_setupRenderGraph();
 
-    opengl_loadScalarDataTexture(defaultScalarDataColorMap);
-    opengl_loadVectorDataTexture(defaultVectorDataColorMap);
+    opengl_loadScalarDataTexture(mainWindowPtr->m_scalarDataColorMap, mainWindowPtr->m_numberOfColorsScalarData);
+    opengl_loadVectorDataTexture(mainWindowPtr->m_vectorDataColorMap, mainWindowPtr->m_numberOfColorsVectorData);
 
     opengl_rotateView();
 }
 
+// Every pass is timed on the CPU by its draw function, and on the GPU by the render graph.
 void Visualization::paintGL()
 {
-    // The height plot, LIC and volume rendering must be drawn by themselves.
-    // The scalar data, isolines and vector data drawing can be combined.
-    if (m_drawHeightplot)
+    m_profiler.beginFrame();
+    Profiler::CpuScope const scope{&m_profiler, "paintGL"};
+
+    m_renderedParameterRevision = m_parameterRevision;
+
+    // The simulation only computes the spectral fields that are shown, from its next step on.
+    m_simulationWorker.setSpectralFields(requiredSpectralFields());
+
+    // All visualizations of this frame use the same simulation frame.
+    m_simulationWorker.acquireLatestFrame();
+    m_preprocessedTextureIsCurrent = false;
+
+    // Before anything draws, so the resources of this frame are resident.
+    m_gpuMemory.update(activeGpuMemoryGroups());
+    if (m_gpuMemory.takeChanged())
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
+        mainWindowPtr->setGpuMemoryUsage(m_gpuMemory.residentBytes(), m_gpuMemory.evictedBytes(),
+                                         m_gpuMemory.driverAvailableKilobytes());
+    }
 
-        opengl_drawHeightplot();
-        return;
+    if (simulatesOnGpu())
+    {
+        if (m_gpuSimulation.DIM() != m_DIMX)
+            m_gpuSimulation.setDIM(m_DIMX);
+
+        if (m_isRunning)
+        {
+            Profiler::CpuScope const gpuSimulationScope{&m_profiler, "GpuSimulation::doOneSimulationStep"};
+            Profiler::GpuScope const gpuScope{m_profiler, "simulation"};
+            m_gpuSimulation.doOneSimulationStep(m_simulationWorker.dt(), m_simulationWorker.viscosity());
+        }
     }
 
     // The height plot requires clearing the color buffer *and* depth buffer.
     // The other visualizations only require clearing the color buffer.
-    glClear(GL_COLOR_BUFFER_BIT);
+    glClear(m_drawHeightplot ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT);
+
+    addRenderPasses();
+    m_renderGraph.execute(m_profiler);
+}
 
-    if (m_drawLIC)
+// The base layer is the first enabled of the height plot, LIC, volume rendering and scalar data. The isolines,
+// streamlines, particles and glyphs are composited over it: all over the LIC and the scalar data, and the isolines on the surface
+// of the height plot. The volume rendering has a camera of its own, so it is drawn alone.
+void Visualization::addRenderPasses()
+{
+    using Resource = RenderGraph::Resource;
+    using Layer = RenderGraph::Layer;
+
+    ScalarDataType const isolineDataType = m_manuallyChooseIsolineDataType ? m_currentIsolineDataType : m_currentScalarDataType;
+    bool const drawScalarDataBase = !m_drawHeightplot && !m_drawLIC && !m_drawVolumeRendering && m_drawScalarData &&
+                                    !(simulatesOnGpu() && m_currentScalarDataType == ScalarDataType::Density);
+    bool const drawOverlays = !m_drawVolumeRendering || m_drawHeightplot || m_drawLIC;
+
+    if (m_drawHeightplot)
     {
-        opengl_drawLic();
-        return;
+        std::vector<Resource> reads;
+        if (usesGpuPreprocessing())
+            reads.push_back(Resource::PreprocessedScalarField);
+        if (m_drawScalarDataAsTexture)
+            reads.push_back(Resource::ScalarFieldTexture);
+        if (m_computeHeightplotNormalsOnGpu || m_drawHeightplotLod)
+            reads.push_back(Resource::HeightFieldTexture);
+
+        m_renderGraph.addPass({"height plot", Layer::Base, std::move(reads), [this] { opengl_drawHeightplot(); }});
     }
-
-    if (m_drawVolumeRendering)
+    else if (m_drawLIC)
+        m_renderGraph.addPass({"LIC", Layer::Base, {Resource::LicVelocityField}, [this] { opengl_drawLic(); }});
+    else if (m_drawVolumeRendering)
+        m_renderGraph.addPass({"volume rendering", Layer::Base, {}, [this] { opengl_drawVolumeRendering(); }});
+    else if (m_drawScalarData)
     {
-        opengl_drawVolumeRendering();
+        // The CPU preprocessing uploads its own values, which are of no use to the other passes.
+        std::vector<Resource> reads;
+        if (drawScalarDataBase && usesGpuPreprocessing())
+            reads.push_back(Resource::PreprocessedScalarField);
+        else if (drawScalarDataBase && !usesPreprocessing() && m_drawScalarDataAsTexture)
+            reads.push_back(Resource::ScalarFieldTexture);
+
+        m_renderGraph.addPass({"scalar data", Layer::Base, std::move(reads), [this] { drawScalarData(); }});
+    }
+
+    if (!drawOverlays)
         return;
+
+    if (m_drawIsolines && m_drawHeightplot)
+    {
+        m_renderGraph.addPass({"isolines", Layer::Overlay, {Resource::HeightFieldTexture},
+                               [this] { opengl_drawIsolinesOnHeightplot(); }});
     }
+    else if (m_drawIsolines)
+    {
+        // The isolines sample the field the scalar data view uploaded or filtered, see opengl_drawIsolines.
+        std::vector<Resource> reads;
+        bool const scalarDataUploadsOwnValues = drawScalarDataBase && usesPreprocessing() && !usesGpuPreprocessing();
+        if (!m_extractIsolinesOnCpu && isolineDataType == m_currentScalarDataType)
+        {
+            if (drawScalarDataBase && usesGpuPreprocessing())
+                reads.push_back(Resource::PreprocessedScalarField);
+            else if (m_drawScalarDataAsTexture && !scalarDataUploadsOwnValues)
+                reads.push_back(Resource::ScalarFieldTexture);
+        }
 
-    if (m_drawScalarData)
-        drawScalarData();
+        m_renderGraph.addPass({"isolines", Layer::Overlay, std::move(reads), [this] { opengl_drawIsolines(); }});
+    }
 
-    if (m_drawIsolines)
+    if (m_drawStreamlines && !m_drawHeightplot)
+        m_renderGraph.addPass({"streamlines", Layer::Overlay, {}, [this] { opengl_drawStreamlines(); }});
+
+    if (m_drawParticles && !m_drawHeightplot)
     {
-        m_shaderProgramIsolines.bind();
-        glUniform3fv(m_uniformLocationIsolines_color, 1, &m_isolineColor[0]);
-        opengl_drawIsolines();
+        // The GPU simulation provides its own velocity texture.
+        std::vector<Resource> reads;
+        if (!simulatesOnGpu())
+            reads.push_back(Resource::LicVelocityField);
+
+        m_renderGraph.addPass({"particles", Layer::Overlay, std::move(reads), [this] { opengl_drawParticles(); }});
     }
 
-    if (m_drawVectorData)
+    if (m_drawVectorData && !m_drawHeightplot)
     {
-        m_shaderProgramVectorData.bind();
-        glUniform1i(m_uniformLocationTextureColorMapInstanced, 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_1D, m_vectorDataTextureLocation);
-        drawGlyphs();
+        m_renderGraph.addPass({"glyphs", Layer::Overlay, {}, [this]
+        {
+            if (m_computeGlyphTransformsOnGpu)
+            {
+                m_shaderProgramVectorDataGpu.bind();
+                glUniform1i(m_uniformLocationVectorDataGpu_texture, 0);
+            }
+            else
+            {
+                m_shaderProgramVectorData.bind();
+                glUniform1i(m_uniformLocationTextureColorMapInstanced, 0);
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_1D, m_vectorDataTextureLocation);
+            drawGlyphs();
+        }});
     }
 }
 
+// GpuSimulation is square only, a rectangular grid stays on the CPU simulation.
+bool Visualization::simulatesOnGpu() const
+{
+    return m_simulateOnGpu && m_DIMX == m_DIMY;
+}
+
+// The groups of GPU resources the passes of addRenderPasses use.
+GpuMemoryManager::Groups Visualization::activeGpuMemoryGroups() const
+{
+    using Group = GpuMemoryManager::Group;
+
+    bool const drawOverlays = !m_drawVolumeRendering || m_drawHeightplot || m_drawLIC;
+    bool const drawParticles = m_drawParticles && !m_drawHeightplot && drawOverlays;
+
+    GpuMemoryManager::Groups groups{};
+    groups[static_cast<size_t>(Group::Shared)] = true;
+    groups[static_cast<size_t>(Group::HeightPlot)] = m_drawHeightplot;
+    groups[static_cast<size_t>(Group::Lic)] = (m_drawLIC && !m_drawHeightplot) || (drawParticles && !simulatesOnGpu());
+    groups[static_cast<size_t>(Group::VolumeRendering)] = m_drawVolumeRendering && !m_drawHeightplot && !m_drawLIC;
+    groups[static_cast<size_t>(Group::Particles)] = drawParticles;
+    groups[static_cast<size_t>(Group::GpuSimulation)] = simulatesOnGpu();
+    return groups;
+}
+
+// The SpectralDerivatives flags of the scalar data types that are selected. The scalar data type is also the color of the
+// height plot, so it always counts.
+unsigned int Visualization::requiredSpectralFields() const
+{
+    auto const flag = [](ScalarDataType const type)
+    {
+        switch (type)
+        {
+            case ScalarDataType::Vorticity:
+                return SpectralDerivatives::s_vorticity;
+
+            case ScalarDataType::UnprojectedVelocityDivergence:
+                return SpectralDerivatives::s_divergence;
+
+            case ScalarDataType::QCriterion:
+                return SpectralDerivatives::s_qCriterion;
+
+            default:
+                return 0U;
+        }
+    };
+
+    ScalarDataType const isolineDataType = m_manuallyChooseIsolineDataType ? m_currentIsolineDataType : m_currentScalarDataType;
+    unsigned int fields = flag(m_currentScalarDataType);
+    if (m_drawIsolines)
+        fields |= flag(isolineDataType);
+    if (m_drawHeightplot)
+        fields |= flag(m_currentHeightplotDataType);
+
+    return fields;
+}
+
 void Visualization::resizeGL(int const width, int const height)
 {
-    m_cellWidth  = 2.0F / static_cast<float>(m_DIM + 1U);
-    m_cellHeight = 2.0F / static_cast<float>(m_DIM + 1U);
+    m_cellWidth  = 2.0F / static_cast<float>(m_DIMX + 1U);
+    m_cellHeight = 2.0F / static_cast<float>(m_DIMY + 1U);
+    m_derivedFields.setCellSize(m_cellWidth, m_cellHeight);
 
     opengl_updateScalarPoints();
 
@@ -146,28 +336,26 @@ void Visualization::resizeGL(int const width, int const height)
 
     opengl_updateLicPoints();
     opengl_generateAndLoadLicNoiseTexture();
+    opengl_resizeLicConvolution();
     setLicStepSize(0.5F);
 }
 
 void Visualization::drawGlyphs()
 {
+    Profiler::CpuScope const scope{&m_profiler, "drawGlyphs"};
+
+    SimulationFrame const &frame = m_simulationWorker.frame();
+
+    std::vector<float> const &magnitude = m_derivedFields.vectorMagnitude(m_currentVectorDataType, frame);
+    float const * const directionX = m_derivedFields.vectorX(m_currentVectorDataType, frame).data();
+    float const * const directionY = m_derivedFields.vectorY(m_currentVectorDataType, frame).data();
+
+    // Resample all three channels to the glyph grid in a single pass over the resampling tables.
     std::vector<float> vectorMagnitude;
     std::vector<float> vectorDirectionX;
     std::vector<float> vectorDirectionY;
-    switch (m_currentVectorDataType)
-    {
-        case VectorDataType::Velocity:
-            vectorMagnitude = m_simulation.velocityMagnitudeInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-            vectorDirectionX = m_simulation.velocityXInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-            vectorDirectionY = m_simulation.velocityYInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-        break;
-
-        case VectorDataType::ForceField:
-            vectorMagnitude = m_simulation.forceFieldMagnitudeInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-            vectorDirectionX = m_simulation.forceFieldXInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-            vectorDirectionY = m_simulation.forceFieldYInterpolated(m_numberOfGlyphsX, m_numberOfGlyphsY);
-        break;
-    }
+    m_glyphResampler.resample<3U>({magnitude.data(), directionX, directionY},
+                                  {&vectorMagnitude, &vectorDirectionX, &vectorDirectionY});
 
     // Scale the magnitudes to where these become visible.
     std::transform(vectorMagnitude.begin(), vectorMagnitude.end(), vectorMagnitude.begin(),
@@ -187,12 +375,21 @@ void Visualization::drawGlyphs()
 
     size_t const numberOfInstances = m_numberOfGlyphsX * m_numberOfGlyphsY;
 
+    // The vertex shader builds the transformations from the direction and magnitude of each glyph.
+    if (m_computeGlyphTransformsOnGpu)
+    {
+        size_t const numberOfVisibleInstances = opengl_bufferGlyphInstanceData(vectorDirectionX, vectorDirectionY,
+                                                                               vectorMagnitude);
+        opengl_drawGlyphInstances(numberOfVisibleInstances);
+        return;
+    }
+
     // Create model transformation matrices
     std::vector<float> modelTransformationMatrices;
     /* Fill the container modelTransformationMatrices here...
      * Use the following variables:
      * modelTransformationMatrix: This vector should contain the result.
-     * m_DIM: The grid dimensions of the simulation. The simulation uses m_DIM * m_DIM data points.
+     * m_DIMX, m_DIMY: The grid dimensions of the simulation. The simulation uses m_DIMX * m_DIMY data points.
      * m_cellWidth, m_cellHeight: A cell, made up of 4 simulation data points, has the size m_cellWidth * m_cellHeight for the visualization.
      *                            The border around the visualization also has a width/height of m_cellWidth/m_cellHeight.
      *                            Note: The bottom-left corner of the OpenGL widget has the coordinate (-1, -1),
@@ -205,32 +402,9 @@ void Visualization::drawGlyphs()
     modelTransformationMatrices = std::vector<float>(numberOfInstances * 16U, 0.0F); // Remove this placeholder initialization
 
     // Buffering section starts here.
-    glBindVertexArray(m_vaoGlyphs);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboValuesGlyphs);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    static_cast<GLsizeiptr>(vectorMagnitude.size() * sizeof(float)),
-                    vectorMagnitude.data());
-
-    // Buffer model transformation matrices.
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboModelTransformationMatricesGlyphs);
-    void * const dataPtr = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    memcpy(dataPtr, modelTransformationMatrices.data(), modelTransformationMatrices.size() * sizeof(float));
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-
-    if (m_currentGlyphType == Glyph::GlyphType::Hedgehog)
-        glDrawElementsInstanced(GL_LINES,
-                                static_cast<GLsizei>(m_glyphIndicesSize),
-                                GL_UNSIGNED_SHORT,
-                                reinterpret_cast<GLvoid*>(0),
-                                static_cast<GLsizei>(numberOfInstances));
-    else
-        glDrawElementsInstanced(GL_TRIANGLE_STRIP,
-                                static_cast<GLsizei>(m_glyphIndicesSize),
-                                GL_UNSIGNED_SHORT,
-                                reinterpret_cast<GLvoid*>(0),
-                                static_cast<GLsizei>(numberOfInstances));
+    opengl_bufferGlyphTransformations(vectorMagnitude, modelTransformationMatrices);
+
+    opengl_drawGlyphInstances(numberOfInstances);
 }
 
 
@@ -256,7 +430,12 @@ void Visualization::applyQuantization(std::vector<float> &scalarValues) const
     // Convert the image's data back to floating point values, so that it can be processed as usual.
     scalarValues = std::vector<float>{image.cbegin(), image.cend()};
 
-    // Force the clamping range in the GUI to be [0, L].
+    setQuantizationClampingRange(L);
+}
+
+// Force the clamping range in the GUI to be [0, L].
+void Visualization::setQuantizationClampingRange(unsigned int const L) const
+{
     auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
     Q_ASSERT(mainWindowPtr != nullptr);
     mainWindowPtr->on_scalarDataMappingClampingMaxSlider_valueChanged(0);
@@ -293,10 +472,13 @@ void Visualization::applyGradients(std::vector<float> &scalarValues) const
  * e.g. "scalarValues = v;".
  *
  * m_sliceIdx contains the value set in the GUI.
- * m_DIM contains the current dimensions of the square (m_DIM * m_DIM).
- * m_slicingWindowSize contains the size of the window (here, also m_DIM).
+ * m_DIMX and m_DIMY contain the current dimensions of the grid (m_DIMX * m_DIMY).
+ * m_slicingWindowSize contains the size of the window (here, the larger of m_DIMX and m_DIMY).
+ *    An x slice uses the newest m_DIMX frames of it, a y slice the newest m_DIMY.
  * m_slicingDirection contains the slicing direction set in the GUI and
  *    is already handled in a switch statement.
+ * m_scalarHistory holds the last m_slicingWindowSize frames of scalarValues,
+ *    m_scalarHistory.value(x, y, t) reads a value of this 3D block.
  */
 void Visualization::applySlicing(std::vector<float> &scalarValues)
 {
@@ -322,119 +504,147 @@ void Visualization::applySlicing(std::vector<float> &scalarValues)
     }
 }
 
-void Visualization::applyPreprocessing(std::vector<float> &scalarValues)
+bool Visualization::usesPreprocessing() const
 {
-    if (m_useQuantization)
-        applyQuantization(scalarValues);
-
-    if (m_useGaussianBlur)
-        applyGaussianBlur(scalarValues);
-
-    if (m_useGradients)
-        applyGradients(scalarValues);
+    return m_useQuantization || m_useGaussianBlur || m_useGradients || m_useSlicing;
+}
 
-    if (m_useSlicing)
-        applySlicing(scalarValues);
+// The GPU filters work on the scalar field texture. Slicing is only implemented on the CPU.
+bool Visualization::usesGpuPreprocessing() const
+{
+    return m_preprocessingBackend == PreprocessingBackend::Gpu &&
+           m_drawScalarDataAsTexture &&
+           !m_useSlicing &&
+           (m_useQuantization || m_useGaussianBlur || m_useGradients);
 }
 
-void Visualization::drawScalarData()
+void Visualization::applyPreprocessing(std::vector<float> &scalarValues)
 {
-    std::vector<float> scalarValues;
+    Profiler::CpuScope const scope{&m_profiler, "applyPreprocessing"};
 
-    switch (m_currentScalarDataType)
+    // The GPU backend falls back to the fused CPU filters when its result cannot be used.
+    if (m_preprocessingBackend != PreprocessingBackend::Reference)
     {
-        case ScalarDataType::Density:
-            scalarValues = m_simulation.density();
-        break;
-
-        case ScalarDataType::ForceFieldMagnitude:
-            scalarValues = m_simulation.forceFieldMagnitude();
-        break;
-
-        case ScalarDataType::VelocityMagnitude:
-            scalarValues = m_simulation.velocityMagnitude();
-        break;
+        PreprocessingPipeline::Settings const settings{m_useQuantization, m_quantizationBits, m_useGaussianBlur, m_useGradients};
+        m_preprocessingPipeline.apply(scalarValues, m_DIMX, m_DIMY, settings, m_threadPool);
+        if (m_useQuantization)
+            setQuantizationClampingRange(PreprocessingPipeline::maxQuantizedValue(m_quantizationBits));
+    }
+    else
+    {
+        if (m_useQuantization)
+            applyQuantization(scalarValues);
 
-        case ScalarDataType::VelocityDivergence:
-            scalarValues = velocityDivergence();
-        break;
+        if (m_useGaussianBlur)
+            applyGaussianBlur(scalarValues);
 
-        case ScalarDataType::ForceFieldDivergence:
-            scalarValues = forceFieldDivergence();
-        break;
+        if (m_useGradients)
+            applyGradients(scalarValues);
     }
 
-    applyPreprocessing(scalarValues);
-    opengl_drawScalarData(scalarValues);
+    if (m_useSlicing)
+    {
+        updateScalarHistory(scalarValues);
+        if (m_preprocessingBackend == PreprocessingBackend::Reference)
+            applySlicing(scalarValues);
+        else
+            sliceScalarHistory(scalarValues);
+    }
 }
 
-std::vector<float> Visualization::velocityDivergence() const
+// Adds the values of a new simulation frame to the history. The history restarts when the data type or the grid
+// size changes.
+void Visualization::updateScalarHistory(std::vector<float> const &scalarValues)
 {
-    std::vector<float> velocityDivergence;
-    velocityDivergence.resize(m_DIM * m_DIM);
-
-    auto const backwardFiniteDifference = [&](size_t const idx, size_t const previousX_idx, size_t const previousY_idx)
+    if (m_scalarHistory.DIMX() != m_DIMX || m_scalarHistory.DIMY() != m_DIMY || m_scalarHistory.capacity() != m_slicingWindowSize ||
+        m_scalarHistoryType != m_currentScalarDataType)
     {
-        return (m_simulation.vx(idx) - m_simulation.vx(previousX_idx)) / m_cellWidth +
-               (m_simulation.vy(idx) - m_simulation.vy(previousY_idx)) / m_cellHeight;
-    };
+        m_scalarHistory.reset(m_DIMX, m_DIMY, m_slicingWindowSize);
+        m_scalarHistoryType = m_currentScalarDataType;
+        m_scalarHistoryFrameNumber = std::numeric_limits<size_t>::max();
+    }
 
-    velocityDivergence.at(0) = backwardFiniteDifference(0, m_DIM - 1, (m_DIM - 1) * m_DIM);
-    for (size_t idx = 1; idx < m_DIM; ++idx)
-        velocityDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx + (m_DIM - 1) * m_DIM);
+    size_t const frameNumber = m_simulationWorker.frame().frameNumber();
+    if (frameNumber == m_scalarHistoryFrameNumber)
+        return;
 
-    for (size_t idx = m_DIM; idx < (m_DIM - 1) * m_DIM; ++idx)
+    m_scalarHistory.push(scalarValues);
+    m_scalarHistoryFrameNumber = frameNumber;
+}
+
+// Replaces the values by a slice of the history. The x and y slices are drawn on the DIMX x DIMY grid, so an x slice
+// covers the newest DIMX frames and a y slice the newest DIMY frames.
+void Visualization::sliceScalarHistory(std::vector<float> &scalarValues) const
+{
+    switch (m_slicingDirection)
     {
-        if (idx % m_DIM == 0)
-            velocityDivergence.at(idx) = backwardFiniteDifference(idx, idx + m_DIM - 1, idx - m_DIM);
-        else
-            velocityDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx - m_DIM);
-    }
+    case SlicingDirection::x:
+        if (m_slicingWindowSize >= m_DIMX)
+            m_scalarHistory.sliceX(std::min(m_sliceIdx, m_DIMX - 1U), m_DIMX, scalarValues);
+        break;
 
-    velocityDivergence.at((m_DIM - 1) * m_DIM) = backwardFiniteDifference((m_DIM - 1) * m_DIM, m_DIM * m_DIM - 1, 0);
-    for (size_t idx = (m_DIM - 1) * m_DIM + 1; idx < m_DIM * m_DIM; ++idx)
-        velocityDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx - (m_DIM - 1) * m_DIM);
+    case SlicingDirection::y:
+        if (m_slicingWindowSize >= m_DIMY)
+            m_scalarHistory.sliceY(std::min(m_sliceIdx, m_DIMY - 1U), m_DIMY, scalarValues);
+        break;
 
-    return velocityDivergence;
+    case SlicingDirection::t:
+        m_scalarHistory.sliceT(std::min(m_sliceIdx, m_slicingWindowSize - 1U), scalarValues);
+        break;
+    }
 }
 
-std::vector<float> Visualization::forceFieldDivergence() const
+void Visualization::drawScalarData()
 {
-    std::vector<float> forceFieldDivergence;
-    forceFieldDivergence.resize(m_DIM * m_DIM);
+    Profiler::CpuScope const scope{&m_profiler, "drawScalarData"};
 
-    auto const backwardFiniteDifference = [&](size_t const idx, size_t const previousX_idx, size_t const previousY_idx)
+    if (simulatesOnGpu() && m_currentScalarDataType == ScalarDataType::Density)
     {
-        return (m_simulation.fx(idx) - m_simulation.fx(previousX_idx)) / m_cellWidth +
-               (m_simulation.fy(idx) - m_simulation.fy(previousY_idx)) / m_cellHeight;
-    };
+        opengl_drawGpuSimulationDensity();
+        return;
+    }
 
-    forceFieldDivergence.at(0) = backwardFiniteDifference(0, m_DIM - 1, (m_DIM - 1) * m_DIM);
-    for (size_t idx = 1; idx < m_DIM; ++idx)
-        forceFieldDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx + (m_DIM - 1) * m_DIM);
+    std::vector<float> const &scalarField = this->scalarField(m_currentScalarDataType);
 
-    for (size_t idx = m_DIM; idx < (m_DIM - 1) * m_DIM; ++idx)
+    if (usesGpuPreprocessing())
     {
-        if (idx % m_DIM == 0)
-            forceFieldDivergence.at(idx) = backwardFiniteDifference(idx, idx + m_DIM - 1, idx - m_DIM);
+        opengl_drawPreprocessedScalarDataTexture();
+        if (m_useQuantization)
+            setQuantizationClampingRange(PreprocessingPipeline::maxQuantizedValue(m_quantizationBits));
+    }
+    // Preprocessing modifies the values, so only then a copy is needed.
+    else if (usesPreprocessing())
+    {
+        m_preprocessedValues = scalarField;
+        applyPreprocessing(m_preprocessedValues);
+        if (m_drawScalarDataAsTexture)
+            opengl_drawScalarDataTexture(m_preprocessedValues, true);
         else
-            forceFieldDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx - m_DIM);
+            opengl_drawScalarData(m_preprocessedValues);
     }
+    else if (m_drawScalarDataAsTexture)
+        opengl_drawScalarDataTexture(scalarField, false);
+    else
+        opengl_drawScalarData(scalarField);
+}
 
-    forceFieldDivergence.at((m_DIM - 1) * m_DIM) = backwardFiniteDifference((m_DIM - 1) * m_DIM, m_DIM * m_DIM - 1, 0);
-    for (size_t idx = (m_DIM - 1) * m_DIM + 1; idx < m_DIM * m_DIM; ++idx)
-        forceFieldDivergence.at(idx) = backwardFiniteDifference(idx, idx - 1, idx - (m_DIM - 1) * m_DIM);
-
-    return forceFieldDivergence;
+// Returns the scalar field of the given type for the current simulation frame.
+// Derived fields are computed once per frame and shared by all draw paths.
+std::vector<float> const &Visualization::scalarField(ScalarDataType const type)
+{
+    return m_derivedFields.scalarField(type, m_simulationWorker.frame());
 }
 
-std::vector<QVector3D> Visualization::computeNormals(std::vector<float> heights) const
+std::vector<QVector3D> Visualization::computeNormals(std::vector<float> const &heights) const
 {
     return std::vector<QVector3D>(heights.size(), QVector3D(0.0F, 0.0F, 1.0F));
 }
 
 namespace
 {
+    // Mirrors transferFunction() of the volume rendering shaders.
+    // After changing it, call opengl_updateVolumeOccupancyTexture() so that empty-space skipping follows, and
+    // opengl_updatePreIntegrationLookupTable() for the pre-integrated table.
     QVector4D transferFunction(float value)
     {
         // Define colors for the colormap
@@ -473,27 +683,34 @@ namespace
 
         return color;
     }
-
-    float opacityCorrection(float const alpha, float const sampleRatio)
-    {
-         return 1.0F - std::pow(1.0F - alpha, sampleRatio);
-    }
 }
 
-std::vector<QVector4D> Visualization::computePreIntegrationLookupTable(size_t const DIM) const
+// Pre-integrates transferFunction through integral tables, see PreIntegrationTable. The result holds premultiplied
+// colors, front value along x and back value along y.
+std::vector<QVector4D> Visualization::computePreIntegrationLookupTable(size_t const DIM)
 {
-    unsigned int const L = 100U; // total number of steps from 0 to delta-t
+    std::vector<QVector4D> transferFunctionLevels(VolumeOccupancy::s_numberOfLevels);
+    for (size_t level = 0U; level < transferFunctionLevels.size(); ++level)
+        transferFunctionLevels[level] = transferFunction(static_cast<float>(level));
 
-    // TODO: modify the transferFunction and add necessary functions
+    PreIntegrationTable preIntegrationTable;
+    preIntegrationTable.setTransferFunction(transferFunctionLevels);
 
-    // placeholder values
     std::vector<QVector4D> lookupTable;
-    for (size_t idx = 0U; idx < DIM * DIM; ++idx)
-        lookupTable.push_back({0.5F, 0.5F, 0.5F, 1.0F});
-
+    preIntegrationTable.build(DIM, lookupTable, m_threadPool);
     return lookupTable;
 }
 
+// The levels [0, 255] of the volume that are not fully transparent under the transfer function.
+std::array<bool, VolumeOccupancy::s_numberOfLevels> Visualization::computeVisibleVolumeLevels() const
+{
+    std::array<bool, VolumeOccupancy::s_numberOfLevels> isVisible{};
+    for (size_t level = 0U; level < VolumeOccupancy::s_numberOfLevels; ++level)
+        isVisible[level] = transferFunction(static_cast<float>(level))[3] > 0.0F;
+
+    return isVisible;
+}
+
 void Visualization::onMessageLogged(QOpenGLDebugMessage const &Message) const
 {
     qDebug() << "Log from Visualization:" << Message;
@@ -501,16 +718,27 @@ void Visualization::onMessageLogged(QOpenGLDebugMessage const &Message) const
 
 // Setters
 void Visualization::setDIM(size_t const DIM)
+{
+    setDIM(DIM, DIM);
+}
+
+void Visualization::setDIM(size_t const DIMX, size_t const DIMY)
 {
     // Stop the simulation, do all resizing, then continue.
     m_timer.stop();
 
-    m_DIM = DIM;
-    m_numberOfGlyphsX = m_DIM;
-    m_numberOfGlyphsY = m_DIM;
+    m_DIMX = DIMX;
+    m_DIMY = DIMY;
+    // The x and y slices are drawn on the grid, so the window follows its size. The frames of the old size are dropped.
+    m_slicingWindowSize = std::max(m_DIMX, m_DIMY);
+    m_scalarHistory.reset(m_DIMX, m_DIMY, m_slicingWindowSize);
+    m_scalarHistoryFrameNumber = std::numeric_limits<size_t>::max();
+    m_numberOfGlyphsX = m_DIMX;
+    m_numberOfGlyphsY = m_DIMY;
+    m_glyphResampler.setShape(m_DIMX, m_DIMY, m_numberOfGlyphsX, m_numberOfGlyphsY);
     opengl_setupAllBuffers();
     resizeGL(width(), height());
-    m_simulation.setDIM(m_DIM);
+    m_simulationWorker.setDIM(m_DIMX, m_DIMY);
 
     m_timer.start();
 }
@@ -518,12 +746,14 @@ void Visualization::setDIM(size_t const DIM)
 void Visualization::setNumberOfGlyphsX(size_t const numberOfGlyphsX)
 {
     m_numberOfGlyphsX = numberOfGlyphsX;
+    m_glyphResampler.setShape(m_DIMX, m_DIMY, m_numberOfGlyphsX, m_numberOfGlyphsY);
     opengl_setupGlyphsPerInstanceData();
 }
 
 void Visualization::setNumberOfGlyphsY(size_t const numberOfGlyphsY)
 {
     m_numberOfGlyphsY = numberOfGlyphsY;
+    m_glyphResampler.setShape(m_DIMX, m_DIMY, m_numberOfGlyphsX, m_numberOfGlyphsY);
     opengl_setupGlyphsPerInstanceData();
 }
 
@@ -1,15 +1,37 @@
 #ifndef VISUALIZATION_H
 #define VISUALIZATION_H
 
+#include "bricklayout.h"
 #include "color.h"
+#include "colormapcache.h"
 #include "datatype.h"
 #include "datraw.h"
+#include "derivedfieldcache.h"
 #include "glyph.h"
+#include "gpumemorymanager.h"
+#include "gpusimulation.h"
+#include "heightplotlod.h"
+#include "isosurfacemesh.h"
 #include "lic.h"
+#include "marchingcubes.h"
+#include "marchingsquares.h"
 #include "movingrange.h"
-#include "simulation.h"
+#include "particlesystem.h"
+#include "preintegrationtable.h"
+#include "preprocessingpipeline.h"
+#include "profiler.h"
+#include "rendergraph.h"
+#include "resampler.h"
+#include "simulationworker.h"
+#include "streamingbuffer.h"
+#include "streamlinetracer.h"
+#include "threadpool.h"
+#include "timehistory.h"
+#include "volumeoccupancy.h"
+#include "volumestreamer.h"
 
 #include <QElapsedTimer>
+#include <QVector2D>
 #include <QVector3D>
 #include <QMatrix3x3>
 #include <QOpenGLDebugLogger>
@@ -18,10 +40,13 @@
 #include <QOpenGLWidget>
 #include <QTimer>
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <deque>
+#include <limits>
 #include <string>
+#include <tuple>
 #include <vector>
 
 class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
@@ -49,6 +74,13 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
         t
     };
 
+    enum class PreprocessingBackend
+    {
+        Reference, // The applyQuantization, applyGaussianBlur and applyGradients functions.
+        FusedCpu,  // PreprocessingPipeline.
+        Gpu        // Fragment shader passes on the scalar field texture.
+    };
+
     enum class IsolinesAmbiguousCaseDecider
     {
         Midpoint,
@@ -76,7 +108,12 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
         VolumeRendererOverlayRendering
     };
 
-    QTimer m_timer; // For triggering simulation updates and render events.
+    QTimer m_timer; // For triggering render events.
+
+    // Render on demand: the timer only repaints when the image can have changed since the last paintGL. In between,
+    // QOpenGLWidget keeps showing the last frame from its own framebuffer.
+    size_t m_parameterRevision = 1U;         // Bumped by requestRender, for the MainWindow slots and camera changes.
+    size_t m_renderedParameterRevision = 0U; // The revision the last frame was rendered with.
     QElapsedTimer m_elapsedTimer; // For measuring elapsed time.
     QOpenGLDebugLogger m_debugLogger;
 
@@ -93,12 +130,47 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     bool m_volumeRenderingTimeIsPaused = false; // Pause 3D volume rendering
     float m_volumeRenderingPauseTimestamp = 0.0F;
 
-    size_t m_DIM = 64U;             // Size of simulation grid. Must be even.
+    // Sampling of the volume rendering rays, see the sampling uniforms of the volume rendering shaders.
+    float m_volumeRenderingStepScale = 1.0F;
+    float m_volumeRenderingMaxAdaptiveStepScale = 1.0F;
+    float m_volumeRenderingAdaptiveStepThreshold = 0.02F;
+    float m_volumeRenderingTerminationOpacity = 0.99F;
+
+    // Progressive rendering: while the image changes, rays are cast for every n-th pixel per axis only and upscaled.
+    // Once it stands still, the full resolution image is refined over a number of frames and then kept as it is.
+    int m_volumeRenderingInteractiveDownsampling = 2; // n, 1 casts a ray for every pixel.
+
+    // Volumetric lighting fetches its gradients from a texture baked once at startup instead of estimating them.
+    bool m_volumeRenderingUsePrecomputedGradients = true;
+
+    // Store the time steps of .dat files as BC4 compressed slices (applies to the next load).
+    bool m_volumeRenderingCompressDataRaw = false;
+
+    // Draw the marching cubes isosurface of .dat volumes instead of casting rays, at an isovalue normalized to the range
+    // of the scalar type.
+    bool m_drawVolumeIsosurface = false;
+    float m_volumeIsovalue = 0.5F;
+
+    size_t m_DIMX = 64U;            // Width of the simulation grid. Must be even.
+    size_t m_DIMY = 64U;            // Height of the simulation grid. Must be even.
 
     float m_cellWidth;		        // Grid cell width
     float m_cellHeight;      		// Grid cell height
 
-    Simulation m_simulation{m_DIM};
+    Profiler m_profiler;                        // Stage times of the GUI, simulation and GPU, shared with the worker.
+    SnapshotWriter m_snapshotWriter;            // Records the steps of the worker, declared first to outlive it.
+    SessionRecorder m_sessionRecorder;          // Records the session of the worker, also declared first.
+    SessionPlayer m_sessionPlayer;              // The loaded recording the worker replays.
+    SimulationWorker m_simulationWorker{m_DIMX}; // Steps the simulation on its own thread, on a square grid at first.
+    RenderGraph m_renderGraph;                  // The passes of the frame being drawn, rebuilt by every paintGL call.
+    GpuMemoryManager m_gpuMemory;               // Tracks the buffers and textures below, and evicts unused ones.
+
+    // Steps the simulation in the GL context instead, once per frame. Only the scalar data view of the density follows
+    // it, the other views keep showing the (paused) CPU simulation. GpuSimulation is square only, so a rectangular grid
+    // keeps simulating on the CPU, see simulatesOnGpu.
+    GpuSimulation m_gpuSimulation;
+    bool m_simulateOnGpu = false;
+    DerivedFieldCache m_derivedFields;          // Magnitudes and divergences of the current simulation frame.
 
     // Scalar info
     ScalarDataType m_currentScalarDataType = ScalarDataType::Density;
@@ -106,9 +178,27 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     float m_scalarDataScale = 0.1F;
     float m_clampMin = 0.0F;                                              // Minimum density we want to visualize.
     float m_clampMax = 1.0F;                                              // Maximum density we want to visualize.
-//    float m_clampMax = static_cast<float>(m_simulation.rhoInjected());    // Maximum density we want to visualize.
+//    float m_clampMax = static_cast<float>(m_simulationWorker.rhoInjected());    // Maximum density we want to visualize.
     float m_transferK = 1.0F;                                             // The K in the transfer function: t(f) = f^K.
 
+    // Scalar field texture. When enabled, the scalar data is drawn as a single textured quad.
+    bool m_drawScalarDataAsTexture = false;
+    size_t m_scalarFieldTextureDIMX = 0U;
+    size_t m_scalarFieldTextureDIMY = 0U;
+    size_t m_scalarFieldTextureFrameNumber = std::numeric_limits<size_t>::max();
+    ScalarDataType m_scalarFieldTextureType = ScalarDataType::Density;
+    bool m_scalarFieldTextureIsShared = false; // The texture holds unpreprocessed values, so other views can use it.
+
+    // GPU preprocessing. The filters run as fragment shader passes on the scalar field texture, ping-ponging between
+    // two RG32F textures of (value, gradient direction). The result is sampled by the scalar data, isolines and
+    // height plot shaders directly.
+    static constexpr size_t s_maxPreprocessingRangeLevels = 8U; // Each level is 4 times smaller, enough for sides <= 65536.
+    size_t m_preprocessedTexture = 0U;          // Index of the latest result in m_preprocessingTextures.
+    ScalarDataType m_preprocessedTextureType = ScalarDataType::Density;
+    bool m_preprocessedTextureIsCurrent = false; // The result belongs to the current paintGL call.
+    size_t m_preprocessingRangeLevels = 0U;      // Number of levels of the (min, max) reduction for this grid.
+    size_t m_preprocessingRangeReadbacks = 0U;   // Number of ranges read back so far, selects the pixel buffer.
+
     // Custom color map. Only used for scalar data
     bool m_useCustomColorMap = false;
     std::array<Color, 3U> m_customColors{Color{1.0F, 0.0F, 0.0F}, Color{0.0F, 1.0F, 0.0F}, Color{0.0F, 0.0F, 1.0F}};
@@ -122,6 +212,28 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     size_t m_glyphIndicesSize;											// Number of indices of current glyph type.
     size_t m_numberOfGlyphsX = 50U;                                     // Number of glyphs in x-direction.
     size_t m_numberOfGlyphsY = 50U;                                     // Number of glyphs in y-direction.
+    Resampler m_glyphResampler;                                         // Resamples the vector field to the glyph grid.
+    bool m_computeGlyphTransformsOnGpu = false;                         // Build the glyph transformations in glyph_gpu.vert.
+
+    // Streamline info. The lines are traced on the CPU from a grid of seeds and colored by the speed.
+    bool m_drawStreamlines = false;
+    bool m_drawPathlines = false;        // Trace through the velocity of the last frames instead of the current frame.
+    size_t m_streamlineSeedsPerRow = 32U;
+    size_t m_streamlineLength = 64U;     // Vertices per line, and frames in the history of the pathlines.
+    static constexpr float s_streamlineStepSize = 0.5F; // In cells.
+    StreamlineTracer m_streamlineTracer;
+    std::vector<StreamlineTracer::Seed> m_streamlineSeeds;
+    size_t m_streamlineSeedsDIMX = 0U;     // The grid the seeds were placed on.
+    size_t m_streamlineSeedsDIMY = 0U;
+    std::vector<GLint> m_streamlineFirsts; // First vertex and vertex count of every line, for glMultiDrawArrays.
+    std::vector<GLsizei> m_streamlineCounts;
+
+    // Particle info. The particles are advected through the velocity texture on the GPU and released by dragging.
+    bool m_drawParticles = false;
+    size_t m_numberOfParticles = 256000U;
+    static constexpr size_t s_maxParticleStepsPerFrame = 4U; // Simulation steps the particles catch up on at once.
+    ParticleSystem m_particleSystem;
+    size_t m_particlesStep = 0U; // The simulation step the particles were advanced to.
 
     // Isolines info
     ScalarDataType m_currentIsolineDataType = ScalarDataType::Density;
@@ -133,9 +245,24 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     float m_isolineMaxValue = 0.5F;
     QVector3D m_isolineColor{1.0F, 1.0F, 1.0F};
     size_t m_numberOfIsolinesIndices;
+    // The isovalues and colors are uniforms of the isolines shaders, uploaded only after one of the above changed.
+    static constexpr size_t s_maxNumberOfIsolines = 64U; // Must match MAX_NUMBER_OF_ISOLINES in the isolines shaders.
+    bool m_isolineLevelsChanged = true;
+    std::vector<float> m_isolineValues;
+    std::vector<Color> m_isolineColors;
+    bool m_extractIsolinesOnCpu = false; // Extract with marching squares on the CPU instead of in isolines.geom.
+    MarchingSquares m_marchingSquares;
+    std::vector<MarchingSquares::Vertex> m_isolineSegments;
+    ThreadPool m_threadPool{ThreadPool::hardwareThreadCount()};
 
     // Height plot info
     ScalarDataType m_currentHeightplotDataType = ScalarDataType::Density;
+    bool m_computeHeightplotNormalsOnGpu = false; // Upload only the heights, the shader computes the normals.
+    static constexpr float s_heightplotHeightScale = 1.0F / 9.0F; // Scaling of the heights for nicer results.
+    bool m_drawHeightplotLod = false; // Draw coarser patches where the detail is not visible. Implies GPU normals.
+    size_t m_heightFieldTextureFrameNumber = std::numeric_limits<size_t>::max(); // Of m_heightplotHeightTexture.
+    ScalarDataType m_heightFieldTextureType = ScalarDataType::Density;
+    HeightplotLod m_heightplotLod;
     QVector3D const m_rotationDefault{120.0F, 180.0F, 0.0F};
     QVector3D m_rotation{m_rotationDefault};
 
@@ -145,68 +272,135 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     int m_licTextureHeight;
     float m_licStepSize;
     int m_licStreamlineLength = 10;
+    size_t m_licVelocityFieldFrameNumber = std::numeric_limits<size_t>::max(); // Frame held by m_licVelocityField.
+    bool m_licReuseConvolution = false;       // Continue from the convolution of the previous frame (ping-pong).
+    bool m_licConvolutionIsValid = false;     // The current convolution texture holds a result for this size.
+    size_t m_licCurrentConvolution = 0U;      // Index of the latest result in m_licConvolutionTextures.
+    int m_licPassesSinceReset = 0;            // Passes accumulated into the convolution since it restarted from noise.
+    static constexpr int s_licPassesPerFrame = 4;
+    // Passes, per step of the streamline length, after which the convolution has converged and needs no more frames.
+    static constexpr int s_licConvergencePassesPerStep = 3;
 
     // Volume rendering info
     VolumeRenderTexture m_volumeRenderTexture = VolumeRenderTexture::SyntheticCube;
     VolumeRenderFragShader m_volumeRenderFragShader = VolumeRenderFragShader::VolumeRenderer;
     std::string m_datFilePath;
     datraw::raw_reader<char>::info_type m_datRawInfo;
-    std::vector<std::uint8_t> m_volumeRenderTextureData;
+    VolumeStreamer m_volumeStreamer; // Plays the time steps of the .dat file, one mapped raw file per time step.
+    BrickLayout m_volumeRenderingBrickLayout; // Layout of the texture in m_volumeRenderingTextureLocation.
+    GLuint m_volumeRenderingCompressedTexture; // 2D array texture of the streamer when it holds BC4 slices.
+    bool m_volumeRenderingIsCompressed = false; // The volume is read from m_volumeRenderingCompressedTexture.
+    std::vector<VolumeOccupancy> m_volumeOccupancies; // Value ranges per cell, one for every time step of the .dat file.
+    size_t m_volumeOccupancyTimeStep = std::numeric_limits<size_t>::max(); // Time step held by m_volumeOccupancyTexture.
+    std::array<float, 3U> m_volumeOccupancyCellExtent{1.0F, 1.0F, 1.0F};
+    MarchingCubes m_marchingCubes; // Extracts from m_isosurfaceTimeSteps, with the bricks of m_volumeOccupancies.
+    IsosurfaceMesh m_isosurfaceMesh;
+    std::vector<datraw::memory_mapped_file> m_isosurfaceTimeSteps; // The raw files of the .dat file, mapped once more.
+    size_t m_isosurfaceTimeStep = std::numeric_limits<size_t>::max(); // Time step m_marchingCubes extracts from.
+    static constexpr float s_volumeRenderingTimeStepsPerSecond = 4.0F;
+    static constexpr size_t s_dataRawLoadThreadCount = 4U; // Raw files of a .dat file that are read at the same time.
+
+    // Everything the volume rendering image depends on besides the volume itself: time stamp, fragment shader,
+    // texture, time step, sampling and gradients. The image changes when any of them does.
+    using VolumeRenderingImageState = std::tuple<float, VolumeRenderFragShader, VolumeRenderTexture, size_t, float, float, float, float, bool>;
+    VolumeRenderingImageState m_volumeRenderingImageState{};
+    size_t m_volumeRenderingProgressiveFrame = 0U; // Number of frames averaged in the full resolution target.
+    static constexpr size_t s_volumeRenderingProgressiveFrames = 16U;
+    static constexpr size_t s_volumeRenderingReducedTarget = 0U;
+    static constexpr size_t s_volumeRenderingFullTarget = 1U;
+    std::array<std::array<GLsizei, 2U>, 2U> m_volumeRenderingTargetSizes{};
 
     // Functions
-    [[nodiscard]] std::vector<float> velocityDivergence() const;
-    [[nodiscard]] std::vector<float> forceFieldDivergence() const;
+    [[nodiscard]] std::vector<float> const &scalarField(ScalarDataType const type);
 
-    [[nodiscard]] std::vector<QVector3D> computeNormals(std::vector<float> height) const;
-    [[nodiscard]] std::vector<QVector4D> computePreIntegrationLookupTable(size_t const DIM) const;
+    [[nodiscard]] std::vector<QVector3D> computeNormals(std::vector<float> const &height) const;
+    [[nodiscard]] std::vector<QVector4D> computePreIntegrationLookupTable(size_t const DIM);
+    [[nodiscard]] std::array<bool, VolumeOccupancy::s_numberOfLevels> computeVisibleVolumeLevels() const;
 
     void input_drag(int const mx, int my);
 
     // OpenGL related members
     GLuint m_vaoScalarData;
     GLuint m_vboScalarPoints;
-    GLuint m_vboScalarData;
+    StreamingBuffer m_vboScalarData;
     GLuint m_eboScalarData;
+    GLuint m_vaoScalarDataQuad;
+    GLuint m_vboScalarDataQuad;
+    GLuint m_scalarFieldTexture;
 
     GLuint m_vaoGlyphs;
     GLuint m_vboGlyphs;
     GLuint m_eboGlyphs;
-    GLuint m_vboModelTransformationMatricesGlyphs;
-    GLuint m_vboValuesGlyphs;
+    StreamingBuffer m_vboModelTransformationMatricesGlyphs;
+    StreamingBuffer m_vboValuesGlyphs;
+    StreamingBuffer m_vboInstanceDataGlyphs;
 
     GLuint m_vaoIsolines;
+    StreamingBuffer m_vboIsolineValues;
     GLuint m_eboIsolines;
+    GLuint m_vaoIsolineSegments;
+    StreamingBuffer m_vboIsolineSegments;
+
+    GLuint m_vaoStreamlines;
+    StreamingBuffer m_vboStreamlines;
 
     GLuint m_vaoHeightplot;
     GLuint m_vboHeightplotPoints;
-    GLuint m_vboHeightplotScalarValues;
-    GLuint m_vboHeightplotHeight;
-    GLuint m_vboHeightplotNormals;
+    StreamingBuffer m_vboHeightplotScalarValues;
+    StreamingBuffer m_vboHeightplotHeight;
+    StreamingBuffer m_vboHeightplotNormals;
     GLuint m_eboHeightplot;
+    GLuint m_heightplotHeightTexture;
+    GLuint m_eboHeightplotLod;
 
     GLuint m_vaoLic;
     GLuint m_vboLic;
     GLuint m_licNoiseTexture;
     GLuint m_licVelocityField;
+    GLuint m_pboLicVelocityField;
+    std::array<GLuint, 2U> m_licFramebuffers;
+    std::array<GLuint, 2U> m_licConvolutionTextures;
+
+    std::array<GLuint, 2U> m_preprocessingFramebuffers;
+    std::array<GLuint, 2U> m_preprocessingTextures;
+    std::array<GLuint, s_maxPreprocessingRangeLevels> m_preprocessingRangeFramebuffers;
+    std::array<GLuint, s_maxPreprocessingRangeLevels> m_preprocessingRangeTextures;
+    std::array<GLuint, 2U> m_pboPreprocessingRange;
 
     GLuint m_vaoVolumeRendering;
     GLuint m_vboVolumeRendering;
     GLuint m_volumeRenderingTextureLocation;
     GLuint m_volumeRenderingTextureLocationPreIntegrationLookupTable;
+    GLuint m_volumeOccupancyTexture;
+    GLuint m_volumeRenderingLightingGradientTexture; // RGB10_A2 gradient directions over the bounding box of the scene.
+    GLuint m_volumeRenderingLightingGradientFramebuffer;
+    static constexpr GLsizei s_volumeRenderingLightingGradientSize = 128;
+    std::array<GLuint, 2U> m_volumeRenderingFramebuffers; // Reduced and full resolution targets of the raycasting.
+    std::array<GLuint, 2U> m_volumeRenderingTargetTextures;
 
     QOpenGLShaderProgram m_shaderProgramScalarDataScaleTexture;
     QOpenGLShaderProgram m_shaderProgramScalarDataScaleCustomColorMap;
     QOpenGLShaderProgram m_shaderProgramScalarDataClampTexture;
     QOpenGLShaderProgram m_shaderProgramScalarDataClampCustomColorMap;
+    QOpenGLShaderProgram m_shaderProgramScalarDataField;
     QOpenGLShaderProgram m_shaderProgramVectorData;
+    QOpenGLShaderProgram m_shaderProgramVectorDataGpu;
     QOpenGLShaderProgram m_shaderProgramIsolines;
+    QOpenGLShaderProgram m_shaderProgramIsolineSegments;
+    QOpenGLShaderProgram m_shaderProgramStreamlines;
     QOpenGLShaderProgram m_shaderProgramHeightplotScale;
     QOpenGLShaderProgram m_shaderProgramHeightplotClamp;
     QOpenGLShaderProgram m_shaderProgramLic;
+    QOpenGLShaderProgram m_shaderProgramLicAccumulate;
+    QOpenGLShaderProgram m_shaderProgramLicDisplay;
+    QOpenGLShaderProgram m_shaderProgramPreprocessing;
+    QOpenGLShaderProgram m_shaderProgramPreprocessingRange;
     QOpenGLShaderProgram m_shaderProgramVolumeRendering;
     QOpenGLShaderProgram m_shaderProgramVolumeRenderingLighting;
     QOpenGLShaderProgram m_shaderProgramVolumeRenderingPreIntegration;
     QOpenGLShaderProgram m_shaderProgramVolumeRenderingOverlayRendering;
+    QOpenGLShaderProgram m_shaderProgramVolumeRenderingUpscale;
+    bool m_volumeRenderingShaderProgramsCreated = false; // The volume rendering programs are linked on first use.
 
     GLint m_uniformLocationScalarDataScaleTexture_rangeMin;
     GLint m_uniformLocationScalarDataScaleTexture_rangeMax;
@@ -228,12 +422,40 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     GLint m_uniformLocationScalarDataClampCustomColorMap_transferK;
     GLint m_uniformLocationScalarDataClampCustomColorMap_colorMapColors;
 
+    GLint m_uniformLocationScalarDataField_scalarField;
+    GLint m_uniformLocationScalarDataField_texture;
+    GLint m_uniformLocationScalarDataField_rangeMin;
+    GLint m_uniformLocationScalarDataField_rangeMax;
+    GLint m_uniformLocationScalarDataField_transferK;
+    GLint m_uniformLocationScalarDataField_useCustomColorMap;
+    GLint m_uniformLocationScalarDataField_colorMapColors;
+
     GLint m_uniformLocationTextureColorMapInstanced;
 
+    GLint m_uniformLocationVectorDataGpu_texture;
+    GLint m_uniformLocationVectorDataGpu_numberOfGlyphs;
+    GLint m_uniformLocationVectorDataGpu_gridOrigin;
+    GLint m_uniformLocationVectorDataGpu_glyphSpacing;
+    GLint m_uniformLocationVectorDataGpu_glyphSize;
+
     GLint m_uniformLocationIsolines_useInterpolation;
     GLint m_uniformLocationIsolines_ambiguousCaseMidpoint;
-    GLint m_uniformLocationIsolines_color;
-    GLint m_uniformLocationIsolines_rho;
+    GLint m_uniformLocationIsolines_values;
+    GLint m_uniformLocationIsolines_colors;
+    GLint m_uniformLocationIsolines_sampleScalarField;
+    GLint m_uniformLocationIsolines_scalarField;
+
+    GLint m_uniformLocationStreamlines_cellSize;
+    GLint m_uniformLocationStreamlines_maxSpeed;
+    GLint m_uniformLocationStreamlines_texture;
+
+    GLint m_uniformLocationIsolineSegments_cellSize;
+    GLint m_uniformLocationIsolineSegments_colors;
+    GLint m_uniformLocationIsolineSegments_onHeightplot;
+    GLint m_uniformLocationIsolineSegments_projection;
+    GLint m_uniformLocationIsolineSegments_view;
+    GLint m_uniformLocationIsolineSegments_heightField;
+    GLint m_uniformLocationIsolineSegments_heightScale;
 
     GLint m_uniformLocationHeightplotScale_rangeMin;
     GLint m_uniformLocationHeightplotScale_rangeMax;
@@ -244,6 +466,16 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     GLint m_uniformLocationHeightplotScale_material;
     GLint m_uniformLocationHeightplotScale_light;
     GLint m_uniformLocationHeightplotScale_texture;
+    GLint m_uniformLocationHeightplotScale_sampleScalarField;
+    GLint m_uniformLocationHeightplotScale_scalarField;
+    GLint m_uniformLocationHeightplotScale_sampleHeightField;
+    GLint m_uniformLocationHeightplotScale_heightField;
+    GLint m_uniformLocationHeightplotScale_heightScale;
+    GLint m_uniformLocationHeightplotScale_cellSize;
+    GLint m_uniformLocationHeightplotScale_useLod;
+    GLint m_uniformLocationHeightplotScale_patchOrigin;
+    GLint m_uniformLocationHeightplotScale_patchSize;
+    GLint m_uniformLocationHeightplotScale_neighbourSteps;
 
     GLint m_uniformLocationHeightplotClamp_clampMin;
     GLint m_uniformLocationHeightplotClamp_clampMax;
@@ -254,18 +486,52 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     GLint m_uniformLocationHeightplotClamp_material;
     GLint m_uniformLocationHeightplotClamp_light;
     GLint m_uniformLocationHeightplotClamp_texture;
+    GLint m_uniformLocationHeightplotClamp_sampleScalarField;
+    GLint m_uniformLocationHeightplotClamp_scalarField;
+    GLint m_uniformLocationHeightplotClamp_sampleHeightField;
+    GLint m_uniformLocationHeightplotClamp_heightField;
+    GLint m_uniformLocationHeightplotClamp_heightScale;
+    GLint m_uniformLocationHeightplotClamp_cellSize;
+    GLint m_uniformLocationHeightplotClamp_useLod;
+    GLint m_uniformLocationHeightplotClamp_patchOrigin;
+    GLint m_uniformLocationHeightplotClamp_patchSize;
+    GLint m_uniformLocationHeightplotClamp_neighbourSteps;
 
     GLint m_uniformLocationLicNoiseTexture;
     GLint m_uniformLocationLicVelocityField;
     GLint m_uniformLocationLicStreamlineLength;
     GLint m_uniformLocationLicStepSize;
 
+    GLint m_uniformLocationLicAccumulate_noiseTexture;
+    GLint m_uniformLocationLicAccumulate_velocityField;
+    GLint m_uniformLocationLicAccumulate_previousConvolution;
+    GLint m_uniformLocationLicAccumulate_streamlineLength;
+    GLint m_uniformLocationLicAccumulate_stepSize;
+    GLint m_uniformLocationLicAccumulate_resetConvolution;
+
+    GLint m_uniformLocationLicDisplay_convolution;
+    GLint m_uniformLocationLicDisplay_streamlineLength;
+
+    GLint m_uniformLocationPreprocessing_field;
+    GLint m_uniformLocationPreprocessing_range;
+    GLint m_uniformLocationPreprocessing_pass;
+    GLint m_uniformLocationPreprocessing_quantizationStep;
+
+    GLint m_uniformLocationPreprocessingRange_field;
+    GLint m_uniformLocationPreprocessingRange_reduceValues;
+
     GLint m_uniformLocationVolumeRendering_iTime;
     GLint m_uniformLocationVolumeRendering_iResolution;
     GLint m_uniformLocationVolumeRenderingTexture;
+    GLint m_uniformLocationVolumeRendering_occupancySampler;
+    GLint m_uniformLocationVolumeRendering_occupancyCellExtent;
 
     GLint m_uniformLocationVolumeRendering_iTimeLighting;
     GLint m_uniformLocationVolumeRendering_iResolutionLighting;
+    GLint m_uniformLocationVolumeRenderingLighting_bakeGradients;
+    GLint m_uniformLocationVolumeRenderingLighting_bakeSlice;
+    GLint m_uniformLocationVolumeRenderingLighting_usePrecomputedGradients;
+    GLint m_uniformLocationVolumeRenderingLighting_gradientSampler;
 //    GLint m_uniformLocationVolumeRenderingTextureLighting;
 
     GLint m_uniformLocationVolumeRenderingPreIntegration_iTime;
@@ -277,8 +543,44 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     GLint m_uniformLocationVolumeRenderingOverlayRendering_iResolution;
     GLint m_uniformLocationVolumeRenderingOverlayRenderingTexture;
 
-    GLuint m_scalarDataTextureLocation;
-    GLuint m_vectorDataTextureLocation;
+    GLint m_uniformLocationVolumeRenderingUpscale_image;
+
+    // The bricking uniforms of the volume rendering shaders that sample the volume, see BrickLayout, and the switch to
+    // the compressed volume, see Bc4Volume.
+    struct VolumeBrickingUniformLocations
+    {
+        GLint brickCount;
+        GLint brickScale;
+        GLint atlasCellCount;
+        GLint atlasCellExtent;
+        GLint atlasGhostOffset;
+        GLint atlasCoreExtent;
+        GLint isCompressed;
+        GLint compressedSampler;
+    };
+    VolumeBrickingUniformLocations m_uniformLocationVolumeRendering_bricking;
+    VolumeBrickingUniformLocations m_uniformLocationVolumeRenderingPreIntegration_bricking;
+    VolumeBrickingUniformLocations m_uniformLocationVolumeRenderingOverlayRendering_bricking;
+    [[nodiscard]] static VolumeBrickingUniformLocations volumeBrickingUniformLocationsWithCheck(QOpenGLShaderProgram const &openGLShaderProgram);
+
+    // The sampling uniforms of the volume rendering shaders: step length, adaptive steps and early ray termination.
+    struct VolumeSamplingUniformLocations
+    {
+        GLint stepScale;
+        GLint maxAdaptiveStepScale;
+        GLint adaptiveStepThreshold;
+        GLint terminationOpacity;
+        GLint rayOffset;
+    };
+    VolumeSamplingUniformLocations m_uniformLocationVolumeRendering_sampling;
+    VolumeSamplingUniformLocations m_uniformLocationVolumeRenderingLighting_sampling;
+    VolumeSamplingUniformLocations m_uniformLocationVolumeRenderingPreIntegration_sampling;
+    VolumeSamplingUniformLocations m_uniformLocationVolumeRenderingOverlayRendering_sampling;
+    [[nodiscard]] static VolumeSamplingUniformLocations volumeSamplingUniformLocationsWithCheck(QOpenGLShaderProgram const &openGLShaderProgram);
+
+    ColorMapCache m_colorMapCache;         // Owns the color map textures, shared with the legends.
+    GLuint m_scalarDataTextureLocation = 0U;
+    GLuint m_vectorDataTextureLocation = 0U;
 
     QMatrix4x4 m_projectionTransformationMatrix;
     QMatrix4x4 m_viewTransformationMatrix;
@@ -291,6 +593,7 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
 
     MovingRange m_minMaxDensity{1U, {0.0F, 0.0F}};
 
+    [[nodiscard]] bool usesPreprocessing() const;
     void applyPreprocessing(std::vector<float> &scalarValues);
 
     // Quantization
@@ -306,17 +609,31 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     bool m_useGradients = false;
     void applyGradients(std::vector<float> &scalarValues) const;
 
+    // Quantization, blur and gradients can also run as one multithreaded pass, or on the GPU.
+    PreprocessingBackend m_preprocessingBackend = PreprocessingBackend::Reference;
+    PreprocessingPipeline m_preprocessingPipeline;
+    std::vector<float> m_preprocessedValues; // Reused between frames, so that the copy does not allocate.
+    void setQuantizationClampingRange(unsigned int const L) const;
+    [[nodiscard]] bool usesGpuPreprocessing() const;
+
     // Slicing
     bool m_useSlicing = false;
-    size_t const m_slicingWindowSize = m_DIM;
+    size_t m_slicingWindowSize = std::max(m_DIMX, m_DIMY); // Follows the grid size, see setDIM.
     SlicingDirection m_slicingDirection = SlicingDirection::x;
     size_t m_sliceIdx = 0U;
+    TimeHistory m_scalarHistory; // The last m_slicingWindowSize frames of the values that are sliced.
+    size_t m_scalarHistoryFrameNumber = std::numeric_limits<size_t>::max();
+    ScalarDataType m_scalarHistoryType = ScalarDataType::Density;
 
+    void updateScalarHistory(std::vector<float> const &scalarValues);
     void applySlicing(std::vector<float> &scalarValues);
+    void sliceScalarHistory(std::vector<float> &scalarValues) const;
 
 
-    // Indices used in OpenGL indexed rendering
-    std::vector<unsigned short> m_indices;
+    // Indices used in OpenGL indexed rendering. These are uploaded as 16 bit indices if the grid is small enough.
+    std::vector<unsigned int> m_indices;
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
+    GLuint m_primitiveRestartIndex = 0xFFFFU;
 
 
     // OpenGL related functions
@@ -328,51 +645,108 @@ class Visualization : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core
     void opengl_createShaderProgramScalarDataScaleCustomColorMap();
     void opengl_createShaderProgramScalarDataClampTexture();
     void opengl_createShaderProgramScalarDataClampCustomColorMap();
+    void opengl_createShaderProgramScalarDataField();
     void opengl_createShaderProgramColorMapInstanced();
+    void opengl_createShaderProgramColorMapInstancedGpu();
     void opengl_createShaderProgramIsolines();
+    void opengl_createShaderProgramIsolineSegments();
+    void opengl_createShaderProgramStreamlines();
     void opengl_createShaderProgramHeightplotScale();
     void opengl_createShaderProgramHeightplotClamp();
     void opengl_createShaderProgramLic();
+    void opengl_createShaderProgramLicAccumulate();
+    void opengl_createShaderProgramLicDisplay();
+    void opengl_createShaderProgramPreprocessing();
+    void opengl_createShaderProgramPreprocessingRange();
     void opengl_createShaderProgramVolumeRendering();
     void opengl_createShaderProgramVolumeRenderingLighting();
     void opengl_createShaderProgramVolumeRenderingPreIntegration();
     void opengl_createShaderProgramVolumeRenderingOverlayRendering();
+    void opengl_createShaderProgramVolumeRenderingUpscale();
+    void opengl_createVolumeRenderingShaderPrograms();
 
-    void opengl_loadScalarDataTexture(std::vector<Color> const &colorMap);
-    void opengl_loadVectorDataTexture(std::vector<Color> const &colorMap);
+    // Select the color map of the scalar or vector data, and return its texture for the legends.
+    GLuint opengl_loadScalarDataTexture(ColorMap const colorMap, size_t const numberOfColors);
+    GLuint opengl_loadVectorDataTexture(ColorMap const colorMap, size_t const numberOfColors);
     void opengl_generateAndLoadLicNoiseTexture();
-    void opengl_loadLicVelocityField(std::vector<float> const &velocityField);
+    void opengl_resizeLicConvolution();
+    void opengl_updateLicVelocityField();
 
     void opengl_setupAllBuffers();
+    void opengl_setupRenderGraph();
+    void opengl_trackGpuMemory();
+    void addRenderPasses();
+    [[nodiscard]] bool simulatesOnGpu() const;
+    [[nodiscard]] GpuMemoryManager::Groups activeGpuMemoryGroups() const;
+    [[nodiscard]] unsigned int requiredSpectralFields() const;
+    void opengl_bufferIndices(std::vector<unsigned int> const &indices);
     void opengl_setupScalarData();
     void opengl_updateScalarPoints();
     void drawScalarData();
     void opengl_drawScalarData(std::vector<float> const &scalarValues);
+    void opengl_drawScalarDataTexture(std::vector<float> const &scalarValues, bool const isPreprocessed);
+    void opengl_drawPreprocessedScalarDataTexture();
+    void opengl_drawGpuSimulationDensity();
+    void opengl_updateScalarFieldTexture(ScalarDataType const type, std::vector<float> const &scalarValues,
+                                         bool const isPreprocessed);
+    [[nodiscard]] bool scalarFieldTextureHolds(ScalarDataType const type) const;
+    void opengl_drawScalarFieldQuad(QVector2D const range, GLuint const scalarFieldTexture);
+
+    void opengl_setupPreprocessing();
+    void opengl_preprocessScalarFieldOnGpu();
+    void opengl_reduceRange(GLuint const texture);
+    [[nodiscard]] QVector2D opengl_preprocessedRange();
+    [[nodiscard]] QVector2D opengl_textureRange(GLuint const texture);
+    [[nodiscard]] bool preprocessedTextureHolds(ScalarDataType const type) const;
 
     void opengl_setupGlyphs();
     void opengl_bufferSingleGlyph();
     void opengl_setupGlyphsPerInstanceData();
+    [[nodiscard]] size_t opengl_bufferGlyphInstanceData(std::vector<float> const &directionX,
+                                                        std::vector<float> const &directionY,
+                                                        std::vector<float> const &magnitude);
+    void opengl_bufferGlyphTransformations(std::vector<float> const &values,
+                                           std::vector<float> const &modelTransformationMatrices);
+    void opengl_drawGlyphInstances(size_t const numberOfInstances);
     void drawGlyphs();
 
     void opengl_setupIsolines();
+    void opengl_setupIsolineSegments();
+    void opengl_updateIsolineLevels();
     void opengl_drawIsolines();
+    void opengl_drawIsolinesOnHeightplot();
+    void opengl_drawIsolineSegments(bool const onHeightplot);
+
+    void opengl_setupStreamlines();
+    void updateStreamlineSeeds();
+    void opengl_drawStreamlines();
+    void opengl_drawParticles();
 
     void opengl_setupHeightplot();
+    [[nodiscard]] GLuint opengl_updateHeightFieldTexture();
     void opengl_drawHeightplot();
     void opengl_rotateView();
 
     void opengl_setupLic();
     void opengl_updateLicPoints();
     void opengl_drawLic();
+    void opengl_drawLicReusingConvolution();
 
     void opengl_setupVolumeRendering();
     void opengl_updateTexture();
     void opengl_updatePreIntegrationLookupTable();
+    void opengl_bakeVolumeRenderingLightingGradients();
     void opengl_updateTextureSyntheticCube();
     void opengl_updateTextureSyntheticScene();
     void opengl_updateTextureLoadDataRawFromFile();
     void opengl_loadDataRawFromFile();
+    void opengl_updateVolumeOccupancyTexture();
+    void opengl_setVolumeBrickingUniforms(VolumeBrickingUniformLocations const &locations);
+    void opengl_setVolumeSamplingUniforms(VolumeSamplingUniformLocations const &locations, float const rayOffset);
+    bool opengl_resizeVolumeRenderingTarget(size_t const target, GLsizei const width, GLsizei const height);
+    void opengl_castVolumeRenderingRays(float const rayOffset);
     void opengl_drawVolumeRendering();
+    void opengl_drawVolumeIsosurface();
 
 protected:
     void initializeGL() override;
@@ -381,9 +755,15 @@ protected:
 
     void mouseMoveEvent(QMouseEvent *ev) override;
 
+    [[nodiscard]] bool needsRender() const;
+
 private slots:
     void onMessageLogged(QOpenGLDebugMessage const &Message) const;
 
+signals:
+    // Emitted while loading a .dat file, each time more of its time steps have been read.
+    void dataRawLoadProgress(int completedTimeSteps, int timeSteps);
+
 public slots:
     void doOneSimulationStep();
 
@@ -395,8 +775,12 @@ public:
     Visualization& operator=(Visualization&&) = delete;
     ~Visualization() override;
 
+    // Repaints with the next timer tick, after a parameter of the visualization changed.
+    void requestRender();
+
     // Setters
     void setDIM(size_t const DIM);
+    void setDIM(size_t const DIMX, size_t const DIMY);
 
     void setNumberOfGlyphsX(size_t const numberOfGlyphsX);
     void setNumberOfGlyphsY(size_t const numberOfGlyphsY);
@@ -22,12 +22,12 @@ void Visualization::input_drag(int const mx, int my)
     static int lmy = 0;
 
     // Compute the array index that corresponds to the cursor location.
-    // X ranges from 0 (left) to m_DIM (right)
-    // Y ranges from 0 (bottom) to m_DIM (top)
-    auto X = static_cast<size_t>(std::floor(static_cast<float>(m_DIM + 1) * (static_cast<float>(mx) / static_cast<float>(width()))));
-    auto Y = static_cast<size_t>(std::floor(static_cast<float>(m_DIM + 1) * (static_cast<float>(my) / static_cast<float>(height()))));
-    X = std::clamp(X, static_cast<size_t>(0), m_DIM - 1);
-    Y = std::clamp(Y, static_cast<size_t>(0), m_DIM - 1);
+    // X ranges from 0 (left) to m_DIMX (right)
+    // Y ranges from 0 (bottom) to m_DIMY (top)
+    auto X = static_cast<size_t>(std::floor(static_cast<float>(m_DIMX + 1) * (static_cast<float>(mx) / static_cast<float>(width()))));
+    auto Y = static_cast<size_t>(std::floor(static_cast<float>(m_DIMY + 1) * (static_cast<float>(my) / static_cast<float>(height()))));
+    X = std::clamp(X, static_cast<size_t>(0), m_DIMX - 1);
+    Y = std::clamp(Y, static_cast<size_t>(0), m_DIMY - 1);
 
     // Add force at the cursor location.
     auto dx = static_cast<float>(mx - lmx);
@@ -40,11 +40,25 @@ void Visualization::input_drag(int const mx, int my)
         dy *= 0.1F / length;
     }
 
-    size_t const idx = X + Y * m_DIM;
+    size_t const idx = X + Y * m_DIMX;
 
-    m_simulation.setFx(idx, m_simulation.fx(idx) + dx);
-    m_simulation.setFy(idx, m_simulation.fy(idx) + dy);
-    m_simulation.setRho(idx, m_simulation.rhoInjected());
+    if (simulatesOnGpu())
+    {
+        m_gpuSimulation.addForce(idx, dx, dy);
+        m_gpuSimulation.injectDensity(idx, m_simulationWorker.rhoInjected());
+    }
+    else
+    {
+        m_simulationWorker.addForce(idx, dx, dy);
+        m_simulationWorker.injectDensity(idx);
+    }
+
+    // Release particles at the cursor location.
+    if (m_drawParticles)
+    {
+        m_particleSystem.inject((static_cast<float>(X) + 0.5F) / static_cast<float>(m_DIMX),
+                                (static_cast<float>(Y) + 0.5F) / static_cast<float>(m_DIMY));
+    }
 
     // Store the current mouse position as the previous mouse position.
     lmx = mx;
@@ -1,47 +1,88 @@
 #include "visualization.h"
 
+#include "bc4volume.h"
+#include "datarawloader.h"
 #include "mainwindow.h"
+#include "shaderprogram.h"
 
 #include <QVector2D>
 #include <QVector4D>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
+
+using shaderprogram::uniformLocationWithCheck;
 
 // Generate all necessary VAOs, VBOs, EBOs and texture names
 void Visualization::opengl_generateObjects()
 {
+    m_profiler.create(this);
+
     glGenVertexArrays(1, &m_vaoScalarData);
     glGenBuffers(1, &m_vboScalarPoints);
-    glGenBuffers(1, &m_vboScalarData);
+    m_vboScalarData.create(this);
     glGenBuffers(1, &m_eboScalarData);
-    glGenTextures(1, &m_scalarDataTextureLocation);
+    glGenVertexArrays(1, &m_vaoScalarDataQuad);
+    glGenBuffers(1, &m_vboScalarDataQuad);
+    glGenTextures(1, &m_scalarFieldTexture);
 
     glGenVertexArrays(1, &m_vaoGlyphs);
     glGenBuffers(1, &m_vboGlyphs);
     glGenBuffers(1, &m_eboGlyphs);
-    glGenBuffers(1, &m_vboModelTransformationMatricesGlyphs);
-    glGenBuffers(1, &m_vboValuesGlyphs);
-    glGenTextures(1, &m_vectorDataTextureLocation);
+    m_vboModelTransformationMatricesGlyphs.create(this);
+    m_vboValuesGlyphs.create(this);
+    m_vboInstanceDataGlyphs.create(this);
 
     glGenVertexArrays(1, &m_vaoIsolines);
+    m_vboIsolineValues.create(this);
     glGenBuffers(1, &m_eboIsolines);
+    glGenVertexArrays(1, &m_vaoIsolineSegments);
+    m_vboIsolineSegments.create(this);
+
+    glGenVertexArrays(1, &m_vaoStreamlines);
+    m_vboStreamlines.create(this);
 
     glGenVertexArrays(1, &m_vaoHeightplot);
     glGenBuffers(1, &m_vboHeightplotPoints);
-    glGenBuffers(1, &m_vboHeightplotScalarValues);
-    glGenBuffers(1, &m_vboHeightplotHeight);
-    glGenBuffers(1, &m_vboHeightplotNormals);
+    m_vboHeightplotScalarValues.create(this);
+    m_vboHeightplotHeight.create(this);
+    m_vboHeightplotNormals.create(this);
     glGenBuffers(1, &m_eboHeightplot);
+    glGenTextures(1, &m_heightplotHeightTexture);
+    glGenBuffers(1, &m_eboHeightplotLod);
 
     glGenVertexArrays(1, &m_vaoLic);
     glGenBuffers(1, &m_vboLic);
     glGenTextures(1, &m_licNoiseTexture);
     glGenTextures(1, &m_licVelocityField);
+    glGenBuffers(1, &m_pboLicVelocityField);
+    glGenFramebuffers(2, m_licFramebuffers.data());
+    glGenTextures(2, m_licConvolutionTextures.data());
+
+    glGenFramebuffers(2, m_preprocessingFramebuffers.data());
+    glGenTextures(2, m_preprocessingTextures.data());
+    glGenFramebuffers(static_cast<GLsizei>(s_maxPreprocessingRangeLevels), m_preprocessingRangeFramebuffers.data());
+    glGenTextures(static_cast<GLsizei>(s_maxPreprocessingRangeLevels), m_preprocessingRangeTextures.data());
+    glGenBuffers(2, m_pboPreprocessingRange.data());
 
     glGenVertexArrays(1, &m_vaoVolumeRendering);
     glGenBuffers(1, &m_vboVolumeRendering);
     glGenTextures(1, &m_volumeRenderingTextureLocation);
     glGenTextures(1, &m_volumeRenderingTextureLocationPreIntegrationLookupTable);
+    glGenTextures(1, &m_volumeRenderingCompressedTexture);
+    glGenTextures(1, &m_volumeOccupancyTexture);
+    glGenTextures(1, &m_volumeRenderingLightingGradientTexture);
+    glGenFramebuffers(1, &m_volumeRenderingLightingGradientFramebuffer);
+    glGenFramebuffers(2, m_volumeRenderingFramebuffers.data());
+    glGenTextures(2, m_volumeRenderingTargetTextures.data());
+    m_volumeStreamer.create(this);
+    m_gpuSimulation.create(this, m_DIMX);
+    m_particleSystem.create(this, m_numberOfParticles);
+    m_isosurfaceMesh.create(this);
+
+    opengl_trackGpuMemory();
 }
 
 void Visualization::opengl_createShaderPrograms()
@@ -50,79 +91,219 @@ void Visualization::opengl_createShaderPrograms()
     opengl_createShaderProgramScalarDataScaleCustomColorMap();
     opengl_createShaderProgramScalarDataClampTexture();
     opengl_createShaderProgramScalarDataClampCustomColorMap();
+    opengl_createShaderProgramScalarDataField();
     opengl_createShaderProgramColorMapInstanced();
+    opengl_createShaderProgramColorMapInstancedGpu();
     opengl_createShaderProgramIsolines();
+    opengl_createShaderProgramIsolineSegments();
+    opengl_createShaderProgramStreamlines();
     opengl_createShaderProgramHeightplotScale();
     opengl_createShaderProgramHeightplotClamp();
     opengl_createShaderProgramLic();
+    opengl_createShaderProgramLicAccumulate();
+    opengl_createShaderProgramLicDisplay();
+    opengl_createShaderProgramPreprocessing();
+    opengl_createShaderProgramPreprocessingRange();
+    // The volume rendering programs are the slowest to compile, and only linked the first time they are drawn, see
+    // opengl_createVolumeRenderingShaderPrograms.
+}
+
+// Links the volume rendering programs if that did not happen yet, and bakes the gradients of the lighting shader.
+void Visualization::opengl_createVolumeRenderingShaderPrograms()
+{
+    if (m_volumeRenderingShaderProgramsCreated)
+        return;
+
     opengl_createShaderProgramVolumeRendering();
     opengl_createShaderProgramVolumeRenderingLighting();
     opengl_createShaderProgramVolumeRenderingPreIntegration();
     opengl_createShaderProgramVolumeRenderingOverlayRendering();
+    opengl_createShaderProgramVolumeRenderingUpscale();
+    m_volumeRenderingShaderProgramsCreated = true;
+
+    opengl_bakeVolumeRenderingLightingGradients();
 }
 
 void Visualization::opengl_setupAllBuffers()
 {
     opengl_setupScalarData();
+    opengl_setupPreprocessing();
     opengl_setupGlyphs();
     opengl_setupIsolines();
+    opengl_setupIsolineSegments();
+    opengl_setupStreamlines();
     opengl_setupHeightplot();
     opengl_setupLic();
     opengl_setupVolumeRendering();
 }
 
+// The uploads that passes can share. Each of them skips the upload when the resource already holds the frame.
+void Visualization::opengl_setupRenderGraph()
+{
+    m_renderGraph.setPreparation(RenderGraph::Resource::ScalarFieldTexture, [this]
+    {
+        opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarField(m_currentScalarDataType), false);
+    });
+
+    m_renderGraph.setPreparation(RenderGraph::Resource::PreprocessedScalarField, [this]
+    {
+        opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarField(m_currentScalarDataType), false);
+        opengl_preprocessScalarFieldOnGpu();
+    });
+
+    m_renderGraph.setPreparation(RenderGraph::Resource::HeightFieldTexture, [this]
+    {
+        static_cast<void>(opengl_updateHeightFieldTexture());
+    });
+
+    m_renderGraph.setPreparation(RenderGraph::Resource::LicVelocityField, [this]
+    {
+        opengl_updateLicVelocityField();
+    });
+}
+
+// The streaming buffers of the height plot are rewritten every frame, so their contents are not kept when evicted. The
+// color map textures of m_colorMapCache are shared with the legends and not tracked.
+void Visualization::opengl_trackGpuMemory()
+{
+    using Group = GpuMemoryManager::Group;
+
+    m_gpuMemory.create(this);
+
+    m_gpuMemory.addBuffer(m_vboScalarPoints, Group::Shared, "scalar data points");
+    m_gpuMemory.addBuffer(m_vboScalarData.buffer(), Group::Shared, "scalar data values", false);
+    m_gpuMemory.addBuffer(m_eboScalarData, Group::Shared, "scalar data indices");
+    m_gpuMemory.addBuffer(m_vboScalarDataQuad, Group::Shared, "scalar data quad");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D, m_scalarFieldTexture, Group::Shared, "scalar field texture");
+    m_gpuMemory.addBuffer(m_vboGlyphs, Group::Shared, "glyph vertices");
+    m_gpuMemory.addBuffer(m_eboGlyphs, Group::Shared, "glyph indices");
+    m_gpuMemory.addBuffer(m_vboModelTransformationMatricesGlyphs.buffer(), Group::Shared, "glyph transformations", false);
+    m_gpuMemory.addBuffer(m_vboValuesGlyphs.buffer(), Group::Shared, "glyph values", false);
+    m_gpuMemory.addBuffer(m_vboInstanceDataGlyphs.buffer(), Group::Shared, "glyph instances", false);
+    m_gpuMemory.addBuffer(m_vboIsolineValues.buffer(), Group::Shared, "isoline values", false);
+    m_gpuMemory.addBuffer(m_eboIsolines, Group::Shared, "isoline indices");
+    m_gpuMemory.addBuffer(m_vboIsolineSegments.buffer(), Group::Shared, "isoline segments", false);
+    m_gpuMemory.addBuffer(m_vboStreamlines.buffer(), Group::Shared, "streamlines", false);
+    for (GLuint const texture : m_preprocessingTextures)
+        m_gpuMemory.addTexture(GL_TEXTURE_2D, texture, Group::Shared, "preprocessing");
+    for (GLuint const texture : m_preprocessingRangeTextures)
+        m_gpuMemory.addTexture(GL_TEXTURE_2D, texture, Group::Shared, "preprocessing range");
+    for (GLuint const buffer : m_pboPreprocessingRange)
+        m_gpuMemory.addBuffer(buffer, Group::Shared, "preprocessing range readback", false);
+    m_gpuMemory.addBuffer(m_vboVolumeRendering, Group::Shared, "volume rendering quad");
+
+    m_gpuMemory.addBuffer(m_vboHeightplotPoints, Group::HeightPlot, "height plot points");
+    m_gpuMemory.addBuffer(m_vboHeightplotScalarValues.buffer(), Group::HeightPlot, "height plot values", false);
+    m_gpuMemory.addBuffer(m_vboHeightplotHeight.buffer(), Group::HeightPlot, "height plot heights", false);
+    m_gpuMemory.addBuffer(m_vboHeightplotNormals.buffer(), Group::HeightPlot, "height plot normals", false);
+    m_gpuMemory.addBuffer(m_eboHeightplot, Group::HeightPlot, "height plot indices");
+    m_gpuMemory.addBuffer(m_eboHeightplotLod, Group::HeightPlot, "height plot LOD indices");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D, m_heightplotHeightTexture, Group::HeightPlot, "height field texture");
+
+    m_gpuMemory.addBuffer(m_vboLic, Group::Lic, "LIC points");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D, m_licNoiseTexture, Group::Lic, "LIC noise");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D, m_licVelocityField, Group::Lic, "LIC velocity field");
+    m_gpuMemory.addBuffer(m_pboLicVelocityField, Group::Lic, "LIC velocity field upload", false);
+    for (GLuint const texture : m_licConvolutionTextures)
+        m_gpuMemory.addTexture(GL_TEXTURE_2D, texture, Group::Lic, "LIC convolution");
+
+    m_gpuMemory.addTexture(GL_TEXTURE_3D, m_volumeRenderingTextureLocation, Group::VolumeRendering, "volume");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D_ARRAY, m_volumeRenderingCompressedTexture, Group::VolumeRendering,
+                           "compressed volume");
+    m_gpuMemory.addTexture(GL_TEXTURE_3D, m_volumeOccupancyTexture, Group::VolumeRendering, "volume occupancy");
+    m_gpuMemory.addTexture(GL_TEXTURE_3D, m_volumeRenderingLightingGradientTexture, Group::VolumeRendering,
+                           "volume lighting gradients");
+    m_gpuMemory.addTexture(GL_TEXTURE_2D, m_volumeRenderingTextureLocationPreIntegrationLookupTable,
+                           Group::VolumeRendering, "pre-integration table");
+    for (GLuint const texture : m_volumeRenderingTargetTextures)
+        m_gpuMemory.addTexture(GL_TEXTURE_2D, texture, Group::VolumeRendering, "volume rendering target");
+    for (GLuint const buffer : m_isosurfaceMesh.buffers())
+        m_gpuMemory.addBuffer(buffer, Group::VolumeRendering, "isosurface");
+
+    for (GLuint const buffer : m_particleSystem.buffers())
+        m_gpuMemory.addBuffer(buffer, Group::Particles, "particles");
+
+    for (GLuint const texture : m_gpuSimulation.textures())
+        m_gpuMemory.addTexture(GL_TEXTURE_2D, texture, Group::GpuSimulation, "GPU simulation field");
+    m_gpuMemory.addBuffer(m_gpuSimulation.splatBuffer(), Group::GpuSimulation, "GPU simulation splats", false);
+}
+
 void Visualization::opengl_deleteObjects()
 {
+    m_profiler.destroy();
+    m_gpuMemory.destroy();
+
     glDeleteVertexArrays(1, &m_vaoScalarData);
     glDeleteBuffers(1, &m_vboScalarPoints);
-    glDeleteBuffers(1, &m_vboScalarData);
+    m_vboScalarData.destroy();
     glDeleteBuffers(1, &m_eboScalarData);
+    glDeleteVertexArrays(1, &m_vaoScalarDataQuad);
+    glDeleteBuffers(1, &m_vboScalarDataQuad);
+    glDeleteTextures(1, &m_scalarFieldTexture);
 
     glDeleteVertexArrays(1, &m_vaoGlyphs);
     glDeleteBuffers(1, &m_vboGlyphs);
     glDeleteBuffers(1, &m_eboGlyphs);
-    glDeleteBuffers(1, &m_vboModelTransformationMatricesGlyphs);
-    glDeleteBuffers(1, &m_vboValuesGlyphs);
+    m_vboModelTransformationMatricesGlyphs.destroy();
+    m_vboValuesGlyphs.destroy();
+    m_vboInstanceDataGlyphs.destroy();
 
     glDeleteVertexArrays(1, &m_vaoIsolines);
+    m_vboIsolineValues.destroy();
     glDeleteBuffers(1, &m_eboIsolines);
+    glDeleteVertexArrays(1, &m_vaoIsolineSegments);
+    m_vboIsolineSegments.destroy();
+
+    glDeleteVertexArrays(1, &m_vaoStreamlines);
+    m_vboStreamlines.destroy();
 
     glDeleteVertexArrays(1, &m_vaoHeightplot);
     glDeleteBuffers(1, &m_vboHeightplotPoints);
-    glDeleteBuffers(1, &m_vboHeightplotHeight);
-    glDeleteBuffers(1, &m_vboHeightplotScalarValues);
-    glDeleteBuffers(1, &m_vboHeightplotNormals);
+    m_vboHeightplotHeight.destroy();
+    m_vboHeightplotScalarValues.destroy();
+    m_vboHeightplotNormals.destroy();
     glDeleteBuffers(1, &m_eboHeightplot);
+    glDeleteTextures(1, &m_heightplotHeightTexture);
+    glDeleteBuffers(1, &m_eboHeightplotLod);
 
     glDeleteBuffers(1, &m_vaoLic);
     glDeleteBuffers(1, &m_vboLic);
     glDeleteTextures(1, &m_licNoiseTexture);
     glDeleteTextures(1, &m_licVelocityField);
+    glDeleteBuffers(1, &m_pboLicVelocityField);
+    glDeleteFramebuffers(2, m_licFramebuffers.data());
+    glDeleteTextures(2, m_licConvolutionTextures.data());
+
+    glDeleteFramebuffers(2, m_preprocessingFramebuffers.data());
+    glDeleteTextures(2, m_preprocessingTextures.data());
+    glDeleteFramebuffers(static_cast<GLsizei>(s_maxPreprocessingRangeLevels), m_preprocessingRangeFramebuffers.data());
+    glDeleteTextures(static_cast<GLsizei>(s_maxPreprocessingRangeLevels), m_preprocessingRangeTextures.data());
+    glDeleteBuffers(2, m_pboPreprocessingRange.data());
 
-    glDeleteTextures(1, &m_scalarDataTextureLocation);
-    glDeleteTextures(1, &m_vectorDataTextureLocation);
+    m_colorMapCache.destroy(*this);
 
     glDeleteVertexArrays(1, &m_vaoVolumeRendering);
     glDeleteBuffers(1, &m_vboVolumeRendering);
     glDeleteTextures(1, &m_volumeRenderingTextureLocation);
     glDeleteTextures(1, &m_volumeRenderingTextureLocationPreIntegrationLookupTable);
+    glDeleteTextures(1, &m_volumeRenderingCompressedTexture);
+    glDeleteTextures(1, &m_volumeOccupancyTexture);
+    glDeleteTextures(1, &m_volumeRenderingLightingGradientTexture);
+    glDeleteFramebuffers(1, &m_volumeRenderingLightingGradientFramebuffer);
+    glDeleteFramebuffers(2, m_volumeRenderingFramebuffers.data());
+    glDeleteTextures(2, m_volumeRenderingTargetTextures.data());
+    m_volumeStreamer.destroy();
+    m_gpuSimulation.destroy();
+    m_particleSystem.destroy();
+    m_isosurfaceMesh.destroy();
 }
 
-void Visualization::opengl_loadScalarDataTexture(std::vector<Color> const &colorMap)
+// The texture is built and uploaded by m_colorMapCache the first time the color map is used.
+GLuint Visualization::opengl_loadScalarDataTexture(ColorMap const colorMap, size_t const numberOfColors)
 {
-    glBindTexture(GL_TEXTURE_1D, m_scalarDataTextureLocation);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glTexImage1D(GL_TEXTURE_1D,
-                 0,
-                 GL_RGB32F,
-                 static_cast<GLint>(colorMap.size()),
-                 0,
-                 GL_RGB,
-                 GL_FLOAT,
-                 colorMap.data());
+    m_scalarDataTextureLocation = m_colorMapCache.select(*this, ColorMapCache::Slot::ScalarData, colorMap,
+                                                         numberOfColors, m_customColors);
+    return m_scalarDataTextureLocation;
 }
 
 void Visualization::opengl_setupScalarData()
@@ -131,50 +312,150 @@ void Visualization::opengl_setupScalarData()
 
     glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarPoints);
     glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * 2U * sizeof(float)),
+                 static_cast<GLsizeiptr>(m_DIMX * m_DIMY * 2U * sizeof(float)),
                  static_cast<GLvoid*>(nullptr),
                  GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0U);
     glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(0));
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarData);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
+    // The scalar values are streamed, their attribute pointer is moved to the written region when drawing.
+    m_vboScalarData.allocate(m_DIMX * m_DIMY * sizeof(float));
     glEnableVertexAttribArray(1U);
     glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(0));
 
-    size_t const numberOfTriangleStripIndices = (m_DIM - 1U) * (2U * m_DIM + 2U) - 2U;
+    // 16 bit indices suffice up to 65535 grid points. The largest value of the index type is reserved for primitive
+    // restart.
+    bool const use16BitIndices = m_DIMX * m_DIMY <= std::numeric_limits<unsigned short>::max();
+    m_indexType = use16BitIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    m_primitiveRestartIndex = use16BitIndices ? std::numeric_limits<unsigned short>::max()
+                                              : std::numeric_limits<unsigned int>::max();
+    glPrimitiveRestartIndex(m_primitiveRestartIndex);
+
+    // Each strip has 2 * DIMX indices, followed by a restart index (except for the last strip).
+    size_t const numberOfTriangleStripIndices = (m_DIMY - 1U) * (2U * m_DIMX + 1U) - 1U;
 
     // When the grid is resized, this function is called again, hence we need to clear m_indices.
     m_indices.clear();
     m_indices.reserve(numberOfTriangleStripIndices);
 
-    for (unsigned short stripIdx = 0U; stripIdx < (m_DIM * (m_DIM - 1U)); stripIdx += m_DIM)
+    for (size_t stripIdx = 0U; stripIdx < (m_DIMX * (m_DIMY - 1U)); stripIdx += m_DIMX)
     {
-        unsigned short lastUsedIdx;
-        for (unsigned short idx = stripIdx; idx < (stripIdx + m_DIM); ++idx)
-        {
-            m_indices.push_back(idx);
+        if (stripIdx != 0U)
+            m_indices.push_back(m_primitiveRestartIndex); // Start the next strip without requiring a new draw call.
 
-            lastUsedIdx = static_cast<unsigned short>(idx + m_DIM);
-            m_indices.push_back(lastUsedIdx);
+        for (size_t idx = stripIdx; idx < (stripIdx + m_DIMX); ++idx)
+        {
+            m_indices.push_back(static_cast<unsigned int>(idx));
+            m_indices.push_back(static_cast<unsigned int>(idx + m_DIMX));
         }
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboScalarData);
+    opengl_bufferIndices(m_indices);
+
+    // The quad for the scalar field texture: 4 vertices of (position, texture coordinates), filled on resize.
+    glBindVertexArray(m_vaoScalarDataQuad);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarDataQuad);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(8U * sizeof(QVector2D)),
+                 static_cast<GLvoid*>(nullptr),
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0U);
+    glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, 2U * sizeof(QVector2D), reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1U);
+    glVertexAttribPointer(1U, 2, GL_FLOAT, GL_FALSE, 2U * sizeof(QVector2D), reinterpret_cast<GLvoid*>(sizeof(QVector2D)));
+
+    glBindTexture(GL_TEXTURE_2D, m_scalarFieldTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R32F,
+                 static_cast<GLsizei>(m_DIMX),
+                 static_cast<GLsizei>(m_DIMY),
+                 0,
+                 GL_RED,
+                 GL_FLOAT,
+                 static_cast<GLvoid*>(nullptr));
+    m_scalarFieldTextureDIMX = m_DIMX;
+    m_scalarFieldTextureDIMY = m_DIMY;
+    m_scalarFieldTextureFrameNumber = std::numeric_limits<size_t>::max();
+}
+
+// Allocates the DIMX x DIMY filter targets and the levels of the range reduction.
+void Visualization::opengl_setupPreprocessing()
+{
+    auto const allocateTarget = [this](GLuint const texture, GLuint const framebuffer, GLsizei const width,
+                                       GLsizei const height, GLint const filter)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, static_cast<GLvoid*>(nullptr));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            qDebug() << "Preprocessing framebuffer of size" << width << "x" << height << "is incomplete.";
+    };
+
+    // The filtered field is drawn like the scalar field texture, so it is filtered linearly as well.
+    for (size_t idx = 0U; idx < m_preprocessingTextures.size(); ++idx)
+        allocateTarget(m_preprocessingTextures[idx], m_preprocessingFramebuffers[idx], static_cast<GLsizei>(m_DIMX),
+                       static_cast<GLsizei>(m_DIMY), GL_LINEAR);
 
-        // Add degenerate vertices to start rendering the next strip without requiring a new (expensive) draw call.
-        // Note: there's no special case for the last triangle, so a couple of redundant indices are added.
-        m_indices.push_back(lastUsedIdx); // Repeat last added vertex.
-        m_indices.push_back(static_cast<unsigned short>(stripIdx + m_DIM)); // Add first vertex of next strip, so that it will appear twice.
+    // Every level is 4 times smaller than the previous one along both axes, down to a single texel.
+    auto levelWidth = static_cast<GLsizei>(m_DIMX);
+    auto levelHeight = static_cast<GLsizei>(m_DIMY);
+    m_preprocessingRangeLevels = 0U;
+    do
+    {
+        levelWidth = (levelWidth + 3) / 4;
+        levelHeight = (levelHeight + 3) / 4;
+        allocateTarget(m_preprocessingRangeTextures[m_preprocessingRangeLevels],
+                       m_preprocessingRangeFramebuffers[m_preprocessingRangeLevels],
+                       levelWidth,
+                       levelHeight,
+                       GL_NEAREST);
+        ++m_preprocessingRangeLevels;
+    } while ((levelWidth > 1 || levelHeight > 1) && m_preprocessingRangeLevels < s_maxPreprocessingRangeLevels);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+
+    for (GLuint const pbo : m_pboPreprocessingRange)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+                     static_cast<GLsizeiptr>(2U * sizeof(GLfloat)),
+                     static_cast<GLvoid*>(nullptr),
+                     GL_STREAM_READ);
     }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
 
-    // No primitive restart, so the last (degenerated) triangles can be removed.
-    m_indices.erase(m_indices.end() - 2U, m_indices.end());
+    m_preprocessingRangeReadbacks = 0U;
+    m_preprocessedTextureIsCurrent = false;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboScalarData);
+// Buffers the indices into the bound element array buffer, using the index type chosen for the current grid size.
+void Visualization::opengl_bufferIndices(std::vector<unsigned int> const &indices)
+{
+    if (m_indexType == GL_UNSIGNED_INT)
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+                     indices.data(),
+                     GL_STATIC_DRAW);
+        return;
+    }
+
+    std::vector<unsigned short> const shortIndices(indices.cbegin(), indices.cend());
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_indices.size() * sizeof(unsigned short)),
-                 m_indices.data(),
+                 static_cast<GLsizeiptr>(shortIndices.size() * sizeof(unsigned short)),
+                 shortIndices.data(),
                  GL_STATIC_DRAW);
 }
 
@@ -189,28 +470,57 @@ void Visualization::opengl_setupIsolines()
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(0));
 
-    // Reuse the scalar data buffer.
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarData);
+    // The scalar values are streamed into their own buffer, their attribute pointer is moved when drawing.
+    m_vboIsolineValues.allocate(m_DIMX * m_DIMY * sizeof(float));
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(0));
 
     m_numberOfIsolinesIndices = 4U; // Placeholder value. Set this to the length of the index list.
 
-    std::vector<unsigned short> indices;
+    std::vector<unsigned int> indices;
     indices.reserve(m_numberOfIsolinesIndices);
 
     // Replace the placeholder code below with code that, for each quad in the grid, computes its
     // four indices and adds it to the indices vector.
     indices.push_back(0U);
-    indices.push_back(m_DIM / 2U);
-    indices.push_back((m_DIM / 2U) + (m_DIM / 2U) * m_DIM);
-    indices.push_back(m_DIM * (m_DIM / 2U));
+    indices.push_back(static_cast<unsigned int>(m_DIMX / 2U));
+    indices.push_back(static_cast<unsigned int>((m_DIMX / 2U) + (m_DIMY / 2U) * m_DIMX));
+    indices.push_back(static_cast<unsigned int>(m_DIMX * (m_DIMY / 2U)));
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboIsolines);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned short)),
-                 indices.data(),
-                 GL_STATIC_DRAW);
+    opengl_bufferIndices(indices);
+}
+
+void Visualization::opengl_setupIsolineSegments()
+{
+    glBindVertexArray(m_vaoIsolineSegments);
+
+    // The segments are streamed, their attribute pointers are moved when drawing.
+    // The buffer grows when a frame has more segments; start with room for one isoline through every row.
+    m_vboIsolineSegments.allocate(2U * m_DIMY * sizeof(MarchingSquares::Vertex));
+
+    // Set grid coordinates to location 0 and isovalue indices to location 1
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, sizeof(MarchingSquares::Vertex), reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, sizeof(MarchingSquares::Vertex),
+                          reinterpret_cast<GLvoid*>(offsetof(MarchingSquares::Vertex, level)));
+}
+
+void Visualization::opengl_setupStreamlines()
+{
+    glBindVertexArray(m_vaoStreamlines);
+
+    // The tracer writes the lines straight into the mapped buffer, their attribute pointers are moved when drawing.
+    m_vboStreamlines.allocate(m_streamlineSeedsPerRow * m_streamlineSeedsPerRow * m_streamlineLength *
+                              sizeof(StreamlineTracer::Vertex));
+
+    // Set grid coordinates to location 0 and speeds to location 1
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, sizeof(StreamlineTracer::Vertex), reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, sizeof(StreamlineTracer::Vertex),
+                          reinterpret_cast<GLvoid*>(offsetof(StreamlineTracer::Vertex, speed)));
 }
 
 void Visualization::opengl_setupGlyphs()
@@ -275,45 +585,146 @@ void Visualization::opengl_setupGlyphsPerInstanceData()
     // Buffering section starts here.
     glBindVertexArray(m_vaoGlyphs);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboValuesGlyphs);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_numberOfGlyphsX * m_numberOfGlyphsY * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
+    // The per-instance data is streamed, the attribute pointers are moved to the written regions when drawing.
+    size_t const numberOfInstances = m_numberOfGlyphsX * m_numberOfGlyphsY;
 
     // Buffer values.
-    static bool firstRun = true;
-    if (firstRun)
-    {
-        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
-        glEnableVertexAttribArray(1);
-        glVertexAttribDivisor(1, 1);
-    }
+    m_vboValuesGlyphs.allocate(numberOfInstances * sizeof(float));
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
 
     // Buffer model transformation matrices.
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboModelTransformationMatricesGlyphs);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_numberOfGlyphsX * m_numberOfGlyphsY * 16U * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
-
     // A location can maximally hold 4 values, so for a 4x4 matrix,
     // 4 attribute pointers need to be defined.
-    if (firstRun)
+    m_vboModelTransformationMatricesGlyphs.allocate(numberOfInstances * 16U * sizeof(float));
+    for (unsigned int columnIdx = 0; columnIdx < 4; ++columnIdx)
+    {
+        glVertexAttribPointer(2 + columnIdx,
+                              4,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              16U * sizeof(float),
+                              reinterpret_cast<GLvoid*>(4U * sizeof(float) * columnIdx));
+        glEnableVertexAttribArray(2 + columnIdx);
+        glVertexAttribDivisor(2 + columnIdx, 1);
+    }
+
+    // Buffer the compact instance data (direction x, direction y, magnitude, glyph index) used by glyph_gpu.vert.
+    // It has its own location, so both glyph shaders can use the same vertex array object.
+    m_vboInstanceDataGlyphs.allocate(numberOfInstances * 4U * sizeof(float));
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+}
+
+void Visualization::opengl_bufferGlyphTransformations(std::vector<float> const &values,
+                                                      std::vector<float> const &modelTransformationMatrices)
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_bufferGlyphTransformations"};
+
+    glBindVertexArray(m_vaoGlyphs);
+
+    GLintptr const valuesOffset = m_vboValuesGlyphs.write(values.data(), values.size() * sizeof(float));
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(valuesOffset));
+
+    GLintptr const matricesOffset = m_vboModelTransformationMatricesGlyphs.write(modelTransformationMatrices.data(),
+                                                                                 modelTransformationMatrices.size() * sizeof(float));
+    for (unsigned int columnIdx = 0; columnIdx < 4; ++columnIdx)
+    {
+        glVertexAttribPointer(2 + columnIdx,
+                              4,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              16U * sizeof(float),
+                              reinterpret_cast<GLvoid*>(matricesOffset + 4U * sizeof(float) * columnIdx));
+    }
+}
+
+// Only the glyphs that cover at least a quarter pixel are written, compacted, with their index in the glyph grid.
+// In most flows the velocity is close to zero in most of the domain, so the vertex work follows the active flow.
+// Returns the number of glyphs written.
+size_t Visualization::opengl_bufferGlyphInstanceData(std::vector<float> const &directionX,
+                                                     std::vector<float> const &directionY,
+                                                     std::vector<float> const &magnitude)
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_bufferGlyphInstanceData"};
+
+    // The glyphs are placed on the same positions as the resampled data:
+    // the outer glyphs lie on the outer simulation grid points.
+    float const gridWidth = static_cast<float>(m_DIMX - 1U) * m_cellWidth;
+    float const gridHeight = static_cast<float>(m_DIMY - 1U) * m_cellHeight;
+
+    float const glyphSpacingX = m_numberOfGlyphsX > 1U ? gridWidth / static_cast<float>(m_numberOfGlyphsX - 1U) : 0.0F;
+    float const glyphSpacingY = m_numberOfGlyphsY > 1U ? gridHeight / static_cast<float>(m_numberOfGlyphsY - 1U) : 0.0F;
+    float const originX = m_numberOfGlyphsX > 1U ? m_cellWidth - 1.0F : m_cellWidth - 1.0F + 0.5F * gridWidth;
+    float const originY = m_numberOfGlyphsY > 1U ? m_cellHeight - 1.0F : m_cellHeight - 1.0F + 0.5F * gridHeight;
+
+    float glyphSize = std::min(glyphSpacingX, glyphSpacingY);
+    if (glyphSize == 0.0F)
+        glyphSize = std::max(std::max(glyphSpacingX, glyphSpacingY), std::min(gridWidth, gridHeight));
+
+    glUniform2i(m_uniformLocationVectorDataGpu_numberOfGlyphs,
+                static_cast<GLint>(m_numberOfGlyphsX),
+                static_cast<GLint>(m_numberOfGlyphsY));
+    glUniform2f(m_uniformLocationVectorDataGpu_gridOrigin, originX, originY);
+    glUniform2f(m_uniformLocationVectorDataGpu_glyphSpacing, glyphSpacingX, glyphSpacingY);
+    glUniform1f(m_uniformLocationVectorDataGpu_glyphSize, glyphSize);
+
+    size_t const numberOfInstances = magnitude.size();
+
+    // A glyph is glyphSize * magnitude long, in clip coordinates, which span width() / 2 or height() / 2 pixels each.
+    float const minimumMagnitude = 0.5F / (glyphSize * static_cast<float>(std::max(width(), height())));
+
+    glBindVertexArray(m_vaoGlyphs);
+    auto * const dataPtr = static_cast<float*>(m_vboInstanceDataGlyphs.map(numberOfInstances * 4U * sizeof(float)));
+    size_t numberOfVisibleInstances = 0U;
+    if (dataPtr != nullptr)
     {
-        firstRun = false;
-        for (unsigned int columnIdx = 0; columnIdx < 4; ++columnIdx)
+        for (size_t idx = 0U; idx < numberOfInstances; ++idx)
         {
-            glVertexAttribPointer(2 + columnIdx,
-                                  4,
-                                  GL_FLOAT,
-                                  GL_FALSE,
-                                  16U * sizeof(float),
-                                  reinterpret_cast<GLvoid*>(4U * sizeof(float) * columnIdx));
-            glEnableVertexAttribArray(2 + columnIdx);
-            glVertexAttribDivisor(2 + columnIdx, 1);
+            if (!(magnitude[idx] >= minimumMagnitude))
+                continue;
+
+            float * const instance = dataPtr + 4U * numberOfVisibleInstances++;
+            instance[0] = directionX[idx];
+            instance[1] = directionY[idx];
+            instance[2] = magnitude[idx];
+            instance[3] = static_cast<float>(idx); // Exact up to 2^24 glyphs.
         }
     }
+    GLintptr const offset = m_vboInstanceDataGlyphs.unmap();
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(offset));
+
+    return numberOfVisibleInstances;
+}
+
+void Visualization::opengl_drawGlyphInstances(size_t const numberOfInstances)
+{
+    glBindVertexArray(m_vaoGlyphs);
+
+    if (m_currentGlyphType == Glyph::GlyphType::Hedgehog)
+        glDrawElementsInstanced(GL_LINES,
+                                static_cast<GLsizei>(m_glyphIndicesSize),
+                                GL_UNSIGNED_SHORT,
+                                reinterpret_cast<GLvoid*>(0),
+                                static_cast<GLsizei>(numberOfInstances));
+    else
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP,
+                                static_cast<GLsizei>(m_glyphIndicesSize),
+                                GL_UNSIGNED_SHORT,
+                                reinterpret_cast<GLvoid*>(0),
+                                static_cast<GLsizei>(numberOfInstances));
+
+    if (m_computeGlyphTransformsOnGpu)
+    {
+        m_vboInstanceDataGlyphs.fence();
+    }
+    else
+    {
+        m_vboValuesGlyphs.fence();
+        m_vboModelTransformationMatricesGlyphs.fence();
+    }
 }
 
 void Visualization::opengl_setupHeightplot()
@@ -322,41 +733,48 @@ void Visualization::opengl_setupHeightplot()
 
     glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotPoints);
     glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * 2U * sizeof(float)),
+                 static_cast<GLsizeiptr>(m_DIMX * m_DIMY * 2U * sizeof(float)),
                  static_cast<GLvoid*>(nullptr),
                  GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotHeight);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
+    m_vboHeightplotHeight.allocate(m_DIMX * m_DIMY * sizeof(float));
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotScalarValues);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
+    m_vboHeightplotScalarValues.allocate(m_DIMX * m_DIMY * sizeof(float));
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotNormals);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_DIM * m_DIM * 3U * sizeof(float)),
-                 static_cast<GLvoid*>(nullptr),
-                 GL_DYNAMIC_DRAW);
+    m_vboHeightplotNormals.allocate(m_DIMX * m_DIMY * 3U * sizeof(float));
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(0));
 
+    // The index patterns of the level of detail patches. The full grid indices stay bound to the vertex array.
+    m_heightplotLod.setShape(m_DIMX, m_DIMY, m_primitiveRestartIndex);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboHeightplotLod);
+    opengl_bufferIndices(m_heightplotLod.indices());
+
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboHeightplot);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(m_indices.size() * sizeof(unsigned short)),
-                 m_indices.data(),
-                 GL_STATIC_DRAW);
+    opengl_bufferIndices(m_indices);
+
+    // The height field when the normals are computed on the GPU, one texel per grid point.
+    glBindTexture(GL_TEXTURE_2D, m_heightplotHeightTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R32F,
+                 static_cast<GLsizei>(m_DIMX),
+                 static_cast<GLsizei>(m_DIMY),
+                 0,
+                 GL_RED,
+                 GL_FLOAT,
+                 nullptr);
+    m_heightFieldTextureFrameNumber = std::numeric_limits<size_t>::max();
 }
 
 void Visualization::opengl_setupLic()
@@ -375,6 +793,21 @@ void Visualization::opengl_setupLic()
                  static_cast<GLsizeiptr>(8U * sizeof(QVector2D)),
                  nullptr,
                  GL_STATIC_DRAW);
+
+    // The velocity texture is allocated once per grid size and updated with glTexSubImage2D.
+    // The raw velocities are stored, RG16F would lose the direction of small velocities.
+    glBindTexture(GL_TEXTURE_2D, m_licVelocityField);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RG32F,
+                 static_cast<GLsizei>(m_DIMX),
+                 static_cast<GLsizei>(m_DIMY),
+                 0,
+                 GL_RG,
+                 GL_FLOAT,
+                 nullptr);
+    m_licVelocityFieldFrameNumber = std::numeric_limits<size_t>::max();
 }
 
 // Render a window-sized quad.
@@ -416,21 +849,36 @@ void Visualization::opengl_setupVolumeRendering()
     opengl_updateTextureSyntheticCube();
 
     opengl_updatePreIntegrationLookupTable();
+    opengl_updateVolumeOccupancyTexture();
+    if (m_volumeRenderingShaderProgramsCreated)
+        opengl_bakeVolumeRenderingLightingGradients();
 }
 
-static GLint uniformLocationWithCheck(QOpenGLShaderProgram const &openGLShaderProgram, char const * const filePath)
+Visualization::VolumeBrickingUniformLocations Visualization::volumeBrickingUniformLocationsWithCheck(QOpenGLShaderProgram const &openGLShaderProgram)
 {
-    GLint const loc = openGLShaderProgram.uniformLocation(filePath);
-    if (loc == -1)
-        qDebug() << "Warning: retrieving uniform location for" << filePath << "has failed.";
+    return {uniformLocationWithCheck(openGLShaderProgram, "brickCount"),
+            uniformLocationWithCheck(openGLShaderProgram, "brickScale"),
+            uniformLocationWithCheck(openGLShaderProgram, "atlasCellCount"),
+            uniformLocationWithCheck(openGLShaderProgram, "atlasCellExtent"),
+            uniformLocationWithCheck(openGLShaderProgram, "atlasGhostOffset"),
+            uniformLocationWithCheck(openGLShaderProgram, "atlasCoreExtent"),
+            uniformLocationWithCheck(openGLShaderProgram, "isCompressed"),
+            uniformLocationWithCheck(openGLShaderProgram, "compressedSampler")};
+}
 
-    return loc;
-};
+Visualization::VolumeSamplingUniformLocations Visualization::volumeSamplingUniformLocationsWithCheck(QOpenGLShaderProgram const &openGLShaderProgram)
+{
+    return {uniformLocationWithCheck(openGLShaderProgram, "stepScale"),
+            uniformLocationWithCheck(openGLShaderProgram, "maxAdaptiveStepScale"),
+            uniformLocationWithCheck(openGLShaderProgram, "adaptiveStepThreshold"),
+            uniformLocationWithCheck(openGLShaderProgram, "terminationOpacity"),
+            uniformLocationWithCheck(openGLShaderProgram, "rayOffset")};
+}
 
 void Visualization::opengl_createShaderProgramScalarDataScaleTexture()
 {
-    m_shaderProgramScalarDataScaleTexture.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_scale.vert");
-    m_shaderProgramScalarDataScaleTexture.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
+    m_shaderProgramScalarDataScaleTexture.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_scale.vert");
+    m_shaderProgramScalarDataScaleTexture.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
     m_shaderProgramScalarDataScaleTexture.link();
 
     m_uniformLocationScalarDataScaleTexture_texture = uniformLocationWithCheck(m_shaderProgramScalarDataScaleTexture, "textureSampler");
@@ -444,8 +892,8 @@ void Visualization::opengl_createShaderProgramScalarDataScaleTexture()
 
 void Visualization::opengl_createShaderProgramScalarDataScaleCustomColorMap()
 {
-    m_shaderProgramScalarDataScaleCustomColorMap.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_scale.vert");
-    m_shaderProgramScalarDataScaleCustomColorMap.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_customcolormap.frag");
+    m_shaderProgramScalarDataScaleCustomColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_scale.vert");
+    m_shaderProgramScalarDataScaleCustomColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_customcolormap.frag");
     m_shaderProgramScalarDataScaleCustomColorMap.link();
 
     m_uniformLocationScalarDataScaleCustomColorMap_colorMapColors = uniformLocationWithCheck(m_shaderProgramScalarDataScaleCustomColorMap, "colorMapColors");
@@ -459,8 +907,8 @@ void Visualization::opengl_createShaderProgramScalarDataScaleCustomColorMap()
 
 void Visualization::opengl_createShaderProgramScalarDataClampTexture()
 {
-    m_shaderProgramScalarDataClampTexture.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_clamp.vert");
-    m_shaderProgramScalarDataClampTexture.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
+    m_shaderProgramScalarDataClampTexture.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_clamp.vert");
+    m_shaderProgramScalarDataClampTexture.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_texture.frag");
     m_shaderProgramScalarDataClampTexture.link();
 
     m_uniformLocationScalarDataClampTexture_texture = uniformLocationWithCheck(m_shaderProgramScalarDataClampTexture, "textureSampler");
@@ -474,8 +922,8 @@ void Visualization::opengl_createShaderProgramScalarDataClampTexture()
 
 void Visualization::opengl_createShaderProgramScalarDataClampCustomColorMap()
 {
-    m_shaderProgramScalarDataClampCustomColorMap.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_clamp.vert");
-    m_shaderProgramScalarDataClampCustomColorMap.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_customcolormap.frag");
+    m_shaderProgramScalarDataClampCustomColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_clamp.vert");
+    m_shaderProgramScalarDataClampCustomColorMap.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_customcolormap.frag");
     m_shaderProgramScalarDataClampCustomColorMap.link();
 
     m_uniformLocationScalarDataClampCustomColorMap_colorMapColors = uniformLocationWithCheck(m_shaderProgramScalarDataClampCustomColorMap, "colorMapColors");
@@ -487,10 +935,29 @@ void Visualization::opengl_createShaderProgramScalarDataClampCustomColorMap()
     qDebug() << "m_shaderProgramScalarDataClampCustomColorMap initialized.";
 }
 
+void Visualization::opengl_createShaderProgramScalarDataField()
+{
+    m_shaderProgramScalarDataField.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/scalarData_field.vert");
+    m_shaderProgramScalarDataField.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/scalarData_field.frag");
+    m_shaderProgramScalarDataField.link();
+
+    m_uniformLocationScalarDataField_scalarField = uniformLocationWithCheck(m_shaderProgramScalarDataField, "scalarField");
+    m_uniformLocationScalarDataField_texture = uniformLocationWithCheck(m_shaderProgramScalarDataField, "textureSampler");
+
+    m_uniformLocationScalarDataField_rangeMin = uniformLocationWithCheck(m_shaderProgramScalarDataField, "rangeMin");
+    m_uniformLocationScalarDataField_rangeMax = uniformLocationWithCheck(m_shaderProgramScalarDataField, "rangeMax");
+    m_uniformLocationScalarDataField_transferK = uniformLocationWithCheck(m_shaderProgramScalarDataField, "transferK");
+
+    m_uniformLocationScalarDataField_useCustomColorMap = uniformLocationWithCheck(m_shaderProgramScalarDataField, "useCustomColorMap");
+    m_uniformLocationScalarDataField_colorMapColors = uniformLocationWithCheck(m_shaderProgramScalarDataField, "colorMapColors");
+
+    qDebug() << "m_shaderProgramScalarDataField initialized.";
+}
+
 void Visualization::opengl_createShaderProgramColorMapInstanced()
 {
-    m_shaderProgramVectorData.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/glyph.vert");
-    m_shaderProgramVectorData.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/glyph.frag");
+    m_shaderProgramVectorData.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/glyph.vert");
+    m_shaderProgramVectorData.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/glyph.frag");
     m_shaderProgramVectorData.link();
 
     m_uniformLocationTextureColorMapInstanced = uniformLocationWithCheck(m_shaderProgramVectorData, "textureSampler");
@@ -498,25 +965,72 @@ void Visualization::opengl_createShaderProgramColorMapInstanced()
     qDebug() << "m_shaderProgramVectorData initialized.";
 }
 
+void Visualization::opengl_createShaderProgramColorMapInstancedGpu()
+{
+    m_shaderProgramVectorDataGpu.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/glyph_gpu.vert");
+    m_shaderProgramVectorDataGpu.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/glyph.frag");
+    m_shaderProgramVectorDataGpu.link();
+
+    m_uniformLocationVectorDataGpu_texture = uniformLocationWithCheck(m_shaderProgramVectorDataGpu, "textureSampler");
+    m_uniformLocationVectorDataGpu_numberOfGlyphs = uniformLocationWithCheck(m_shaderProgramVectorDataGpu, "numberOfGlyphs");
+    m_uniformLocationVectorDataGpu_gridOrigin = uniformLocationWithCheck(m_shaderProgramVectorDataGpu, "gridOrigin");
+    m_uniformLocationVectorDataGpu_glyphSpacing = uniformLocationWithCheck(m_shaderProgramVectorDataGpu, "glyphSpacing");
+    m_uniformLocationVectorDataGpu_glyphSize = uniformLocationWithCheck(m_shaderProgramVectorDataGpu, "glyphSize");
+
+    qDebug() << "m_shaderProgramVectorDataGpu initialized.";
+}
+
 void Visualization::opengl_createShaderProgramIsolines()
 {
-    m_shaderProgramIsolines.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/isolines.vert");
-    m_shaderProgramIsolines.addShaderFromSourceFile(QOpenGLShader::Geometry, ":/shaders/isolines.geom");
-    m_shaderProgramIsolines.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/isolines.frag");
+    m_shaderProgramIsolines.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/isolines.vert");
+    m_shaderProgramIsolines.addCacheableShaderFromSourceFile(QOpenGLShader::Geometry, ":/shaders/isolines.geom");
+    m_shaderProgramIsolines.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/isolines.frag");
     m_shaderProgramIsolines.link();
 
     m_uniformLocationIsolines_useInterpolation = uniformLocationWithCheck(m_shaderProgramIsolines, "useInterpolation");
     m_uniformLocationIsolines_ambiguousCaseMidpoint = uniformLocationWithCheck(m_shaderProgramIsolines, "ambiguousCaseMidpoint");
-    m_uniformLocationIsolines_color = uniformLocationWithCheck(m_shaderProgramIsolines, "isolineColor");
-    m_uniformLocationIsolines_rho = uniformLocationWithCheck(m_shaderProgramIsolines, "rho");
+    m_uniformLocationIsolines_values = uniformLocationWithCheck(m_shaderProgramIsolines, "isolineValues");
+    m_uniformLocationIsolines_colors = uniformLocationWithCheck(m_shaderProgramIsolines, "isolineColors");
+    m_uniformLocationIsolines_sampleScalarField = uniformLocationWithCheck(m_shaderProgramIsolines, "sampleScalarField");
+    m_uniformLocationIsolines_scalarField = uniformLocationWithCheck(m_shaderProgramIsolines, "scalarField");
 
     qDebug() << "m_shaderProgramIsolines initialized.";
 }
 
+void Visualization::opengl_createShaderProgramIsolineSegments()
+{
+    m_shaderProgramIsolineSegments.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/isolines_segments.vert");
+    m_shaderProgramIsolineSegments.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/isolines.frag");
+    m_shaderProgramIsolineSegments.link();
+
+    m_uniformLocationIsolineSegments_cellSize = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "cellSize");
+    m_uniformLocationIsolineSegments_colors = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "isolineColors");
+    m_uniformLocationIsolineSegments_onHeightplot = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "onHeightplot");
+    m_uniformLocationIsolineSegments_projection = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "projectionTransform");
+    m_uniformLocationIsolineSegments_view = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "viewTransform");
+    m_uniformLocationIsolineSegments_heightField = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "heightField");
+    m_uniformLocationIsolineSegments_heightScale = uniformLocationWithCheck(m_shaderProgramIsolineSegments, "heightScale");
+
+    qDebug() << "m_shaderProgramIsolineSegments initialized.";
+}
+
+void Visualization::opengl_createShaderProgramStreamlines()
+{
+    m_shaderProgramStreamlines.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/streamlines.vert");
+    m_shaderProgramStreamlines.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/streamlines.frag");
+    m_shaderProgramStreamlines.link();
+
+    m_uniformLocationStreamlines_cellSize = uniformLocationWithCheck(m_shaderProgramStreamlines, "cellSize");
+    m_uniformLocationStreamlines_maxSpeed = uniformLocationWithCheck(m_shaderProgramStreamlines, "maxSpeed");
+    m_uniformLocationStreamlines_texture = uniformLocationWithCheck(m_shaderProgramStreamlines, "textureSampler");
+
+    qDebug() << "m_shaderProgramStreamlines initialized.";
+}
+
 void Visualization::opengl_createShaderProgramHeightplotScale()
 {
-    m_shaderProgramHeightplotScale.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/heightplot_scale.vert");
-    m_shaderProgramHeightplotScale.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/heightplot.frag");
+    m_shaderProgramHeightplotScale.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/heightplot_scale.vert");
+    m_shaderProgramHeightplotScale.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/heightplot.frag");
     m_shaderProgramHeightplotScale.link();
 
     m_uniformLocationHeightplotScale_rangeMin = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "rangeMin");
@@ -531,14 +1045,24 @@ void Visualization::opengl_createShaderProgramHeightplotScale()
     m_uniformLocationHeightplotScale_light = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "lightPosition");
 
     m_uniformLocationHeightplotScale_texture = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "textureSampler");
+    m_uniformLocationHeightplotScale_sampleScalarField = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "sampleScalarField");
+    m_uniformLocationHeightplotScale_scalarField = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "scalarField");
+    m_uniformLocationHeightplotScale_sampleHeightField = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "sampleHeightField");
+    m_uniformLocationHeightplotScale_heightField = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "heightField");
+    m_uniformLocationHeightplotScale_heightScale = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "heightScale");
+    m_uniformLocationHeightplotScale_cellSize = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "cellSize");
+    m_uniformLocationHeightplotScale_useLod = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "useLod");
+    m_uniformLocationHeightplotScale_patchOrigin = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "patchOrigin");
+    m_uniformLocationHeightplotScale_patchSize = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "patchSize");
+    m_uniformLocationHeightplotScale_neighbourSteps = uniformLocationWithCheck(m_shaderProgramHeightplotScale, "neighbourSteps");
 
     qDebug() << "m_shaderProgramHeightplotScale initialized.";
 }
 
 void Visualization::opengl_createShaderProgramHeightplotClamp()
 {
-    m_shaderProgramHeightplotClamp.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/heightplot_clamp.vert");
-    m_shaderProgramHeightplotClamp.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/heightplot.frag");
+    m_shaderProgramHeightplotClamp.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/heightplot_clamp.vert");
+    m_shaderProgramHeightplotClamp.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/heightplot.frag");
     m_shaderProgramHeightplotClamp.link();
 
     m_uniformLocationHeightplotClamp_clampMin = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "clampMin");
@@ -553,14 +1077,24 @@ void Visualization::opengl_createShaderProgramHeightplotClamp()
     m_uniformLocationHeightplotClamp_light = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "lightPosition");
 
     m_uniformLocationHeightplotClamp_texture = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "textureSampler");
+    m_uniformLocationHeightplotClamp_sampleScalarField = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "sampleScalarField");
+    m_uniformLocationHeightplotClamp_scalarField = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "scalarField");
+    m_uniformLocationHeightplotClamp_sampleHeightField = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "sampleHeightField");
+    m_uniformLocationHeightplotClamp_heightField = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "heightField");
+    m_uniformLocationHeightplotClamp_heightScale = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "heightScale");
+    m_uniformLocationHeightplotClamp_cellSize = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "cellSize");
+    m_uniformLocationHeightplotClamp_useLod = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "useLod");
+    m_uniformLocationHeightplotClamp_patchOrigin = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "patchOrigin");
+    m_uniformLocationHeightplotClamp_patchSize = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "patchSize");
+    m_uniformLocationHeightplotClamp_neighbourSteps = uniformLocationWithCheck(m_shaderProgramHeightplotClamp, "neighbourSteps");
 
     qDebug() << "m_shaderProgramHeightplotClamp initialized.";
 }
 
 void Visualization::opengl_createShaderProgramLic()
 {
-    m_shaderProgramLic.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/lic.vert");
-    m_shaderProgramLic.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lic.frag");
+    m_shaderProgramLic.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/lic.vert");
+    m_shaderProgramLic.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lic.frag");
     m_shaderProgramLic.link();
 
     m_uniformLocationLicNoiseTexture = uniformLocationWithCheck(m_shaderProgramLic, "noiseTexture");
@@ -574,10 +1108,64 @@ void Visualization::opengl_createShaderProgramLic()
     qDebug() << "m_shaderProgramLic initialized.";
 }
 
+void Visualization::opengl_createShaderProgramLicAccumulate()
+{
+    m_shaderProgramLicAccumulate.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/lic_accumulate.vert");
+    m_shaderProgramLicAccumulate.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lic_accumulate.frag");
+    m_shaderProgramLicAccumulate.link();
+
+    m_uniformLocationLicAccumulate_noiseTexture = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "noiseTexture");
+    m_uniformLocationLicAccumulate_velocityField = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "velocityField");
+    m_uniformLocationLicAccumulate_previousConvolution = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "previousConvolution");
+    m_uniformLocationLicAccumulate_streamlineLength = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "streamlineLength");
+    m_uniformLocationLicAccumulate_stepSize = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "stepSize");
+    m_uniformLocationLicAccumulate_resetConvolution = uniformLocationWithCheck(m_shaderProgramLicAccumulate, "resetConvolution");
+
+    qDebug() << "m_shaderProgramLicAccumulate initialized.";
+}
+
+void Visualization::opengl_createShaderProgramLicDisplay()
+{
+    m_shaderProgramLicDisplay.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/lic.vert");
+    m_shaderProgramLicDisplay.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lic_display.frag");
+    m_shaderProgramLicDisplay.link();
+
+    m_uniformLocationLicDisplay_convolution = uniformLocationWithCheck(m_shaderProgramLicDisplay, "convolution");
+    m_uniformLocationLicDisplay_streamlineLength = uniformLocationWithCheck(m_shaderProgramLicDisplay, "streamlineLength");
+
+    qDebug() << "m_shaderProgramLicDisplay initialized.";
+}
+
+void Visualization::opengl_createShaderProgramPreprocessing()
+{
+    m_shaderProgramPreprocessing.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/preprocessing.vert");
+    m_shaderProgramPreprocessing.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/preprocessing.frag");
+    m_shaderProgramPreprocessing.link();
+
+    m_uniformLocationPreprocessing_field = uniformLocationWithCheck(m_shaderProgramPreprocessing, "field");
+    m_uniformLocationPreprocessing_range = uniformLocationWithCheck(m_shaderProgramPreprocessing, "range");
+    m_uniformLocationPreprocessing_pass = uniformLocationWithCheck(m_shaderProgramPreprocessing, "pass");
+    m_uniformLocationPreprocessing_quantizationStep = uniformLocationWithCheck(m_shaderProgramPreprocessing, "quantizationStep");
+
+    qDebug() << "m_shaderProgramPreprocessing initialized.";
+}
+
+void Visualization::opengl_createShaderProgramPreprocessingRange()
+{
+    m_shaderProgramPreprocessingRange.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/preprocessing.vert");
+    m_shaderProgramPreprocessingRange.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/preprocessing_range.frag");
+    m_shaderProgramPreprocessingRange.link();
+
+    m_uniformLocationPreprocessingRange_field = uniformLocationWithCheck(m_shaderProgramPreprocessingRange, "field");
+    m_uniformLocationPreprocessingRange_reduceValues = uniformLocationWithCheck(m_shaderProgramPreprocessingRange, "reduceValues");
+
+    qDebug() << "m_shaderProgramPreprocessingRange initialized.";
+}
+
 void Visualization::opengl_createShaderProgramVolumeRendering()
 {
-    m_shaderProgramVolumeRendering.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
-    m_shaderProgramVolumeRendering.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering.frag");
+    m_shaderProgramVolumeRendering.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
+    m_shaderProgramVolumeRendering.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering.frag");
     m_shaderProgramVolumeRendering.link();
 
     m_uniformLocationVolumeRendering_iTime = uniformLocationWithCheck(m_shaderProgramVolumeRendering, "iTime");
@@ -585,6 +1173,12 @@ void Visualization::opengl_createShaderProgramVolumeRendering()
     m_uniformLocationVolumeRendering_iResolution = uniformLocationWithCheck(m_shaderProgramVolumeRendering, "iResolution");
 
     m_uniformLocationVolumeRenderingTexture = uniformLocationWithCheck(m_shaderProgramVolumeRendering, "textureSampler");
+    m_uniformLocationVolumeRendering_bricking = volumeBrickingUniformLocationsWithCheck(m_shaderProgramVolumeRendering);
+
+    m_uniformLocationVolumeRendering_occupancySampler = uniformLocationWithCheck(m_shaderProgramVolumeRendering, "occupancySampler");
+    m_uniformLocationVolumeRendering_occupancyCellExtent = uniformLocationWithCheck(m_shaderProgramVolumeRendering, "occupancyCellExtent");
+
+    m_uniformLocationVolumeRendering_sampling = volumeSamplingUniformLocationsWithCheck(m_shaderProgramVolumeRendering);
 
     m_shaderProgramVolumeRendering.bind();
 
@@ -593,14 +1187,21 @@ void Visualization::opengl_createShaderProgramVolumeRendering()
 
 void Visualization::opengl_createShaderProgramVolumeRenderingLighting()
 {
-    m_shaderProgramVolumeRenderingLighting.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
-    m_shaderProgramVolumeRenderingLighting.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_lighting.frag");
+    m_shaderProgramVolumeRenderingLighting.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
+    m_shaderProgramVolumeRenderingLighting.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_lighting.frag");
     m_shaderProgramVolumeRenderingLighting.link();
 
     m_uniformLocationVolumeRendering_iTimeLighting = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "iTime");
 
     m_uniformLocationVolumeRendering_iResolutionLighting = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "iResolution");
 
+    m_uniformLocationVolumeRenderingLighting_sampling = volumeSamplingUniformLocationsWithCheck(m_shaderProgramVolumeRenderingLighting);
+
+    m_uniformLocationVolumeRenderingLighting_bakeGradients = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "bakeGradients");
+    m_uniformLocationVolumeRenderingLighting_bakeSlice = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "bakeSlice");
+    m_uniformLocationVolumeRenderingLighting_usePrecomputedGradients = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "usePrecomputedGradients");
+    m_uniformLocationVolumeRenderingLighting_gradientSampler = uniformLocationWithCheck(m_shaderProgramVolumeRenderingLighting, "gradientSampler");
+
     m_shaderProgramVolumeRenderingLighting.bind();
 
     qDebug() << "m_shaderProgramVolumeRenderingLighting initialized.";
@@ -608,8 +1209,8 @@ void Visualization::opengl_createShaderProgramVolumeRenderingLighting()
 
 void Visualization::opengl_createShaderProgramVolumeRenderingPreIntegration()
 {
-    m_shaderProgramVolumeRenderingPreIntegration.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
-    m_shaderProgramVolumeRenderingPreIntegration.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_preintegration.frag");
+    m_shaderProgramVolumeRenderingPreIntegration.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
+    m_shaderProgramVolumeRenderingPreIntegration.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_preintegration.frag");
     m_shaderProgramVolumeRenderingPreIntegration.link();
 
     m_uniformLocationVolumeRenderingPreIntegration_iTime = uniformLocationWithCheck(m_shaderProgramVolumeRenderingPreIntegration, "iTime");
@@ -617,9 +1218,12 @@ void Visualization::opengl_createShaderProgramVolumeRenderingPreIntegration()
     m_uniformLocationVolumeRenderingPreIntegration_iResolution = uniformLocationWithCheck(m_shaderProgramVolumeRenderingPreIntegration, "iResolution");
 
     m_uniformLocationVolumeRenderingPreIntegrationTexture = uniformLocationWithCheck(m_shaderProgramVolumeRenderingPreIntegration, "textureSampler");
+    m_uniformLocationVolumeRenderingPreIntegration_bricking = volumeBrickingUniformLocationsWithCheck(m_shaderProgramVolumeRenderingPreIntegration);
 
     m_uniformLocationVolumeRenderingPreIntegrationTextureLookupTable = uniformLocationWithCheck(m_shaderProgramVolumeRenderingPreIntegration, "lookupTable");
 
+    m_uniformLocationVolumeRenderingPreIntegration_sampling = volumeSamplingUniformLocationsWithCheck(m_shaderProgramVolumeRenderingPreIntegration);
+
     m_shaderProgramVolumeRenderingPreIntegration.bind();
 
     qDebug() << "m_shaderProgramVolumeRenderingPreIntegration initialized.";
@@ -627,8 +1231,8 @@ void Visualization::opengl_createShaderProgramVolumeRenderingPreIntegration()
 
 void Visualization::opengl_createShaderProgramVolumeRenderingOverlayRendering()
 {
-    m_shaderProgramVolumeRenderingOverlayRendering.addShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
-    m_shaderProgramVolumeRenderingOverlayRendering.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_overlay_rendering.frag");
+    m_shaderProgramVolumeRenderingOverlayRendering.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
+    m_shaderProgramVolumeRenderingOverlayRendering.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_overlay_rendering.frag");
     m_shaderProgramVolumeRenderingOverlayRendering.link();
 
     m_uniformLocationVolumeRenderingOverlayRendering_iTime = uniformLocationWithCheck(m_shaderProgramVolumeRenderingOverlayRendering, "iTime");
@@ -636,27 +1240,31 @@ void Visualization::opengl_createShaderProgramVolumeRenderingOverlayRendering()
     m_uniformLocationVolumeRenderingOverlayRendering_iResolution = uniformLocationWithCheck(m_shaderProgramVolumeRenderingOverlayRendering, "iResolution");
 
     m_uniformLocationVolumeRenderingOverlayRenderingTexture = uniformLocationWithCheck(m_shaderProgramVolumeRenderingOverlayRendering, "textureSampler");
+    m_uniformLocationVolumeRenderingOverlayRendering_bricking = volumeBrickingUniformLocationsWithCheck(m_shaderProgramVolumeRenderingOverlayRendering);
+
+    m_uniformLocationVolumeRenderingOverlayRendering_sampling = volumeSamplingUniformLocationsWithCheck(m_shaderProgramVolumeRenderingOverlayRendering);
 
     m_shaderProgramVolumeRenderingOverlayRendering.bind();
 
     qDebug() << "m_shaderProgramVolumeRenderingOverlayRendering initialized.";
 }
 
-void Visualization::opengl_loadVectorDataTexture(std::vector<Color> const &colorMap)
+void Visualization::opengl_createShaderProgramVolumeRenderingUpscale()
 {
-    glBindTexture(GL_TEXTURE_1D, m_vectorDataTextureLocation);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    m_shaderProgramVolumeRenderingUpscale.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex,   ":/shaders/volume_rendering.vert");
+    m_shaderProgramVolumeRenderingUpscale.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/volume_rendering_upscale.frag");
+    m_shaderProgramVolumeRenderingUpscale.link();
 
-    glTexImage1D(GL_TEXTURE_1D,
-                 0,
-                 GL_RGB32F,
-                 static_cast<GLint>(colorMap.size()),
-                 0,
-                 GL_RGB,
-                 GL_FLOAT,
-                 colorMap.data());
+    m_uniformLocationVolumeRenderingUpscale_image = uniformLocationWithCheck(m_shaderProgramVolumeRenderingUpscale, "image");
+
+    qDebug() << "m_shaderProgramVolumeRenderingUpscale initialized.";
+}
+
+GLuint Visualization::opengl_loadVectorDataTexture(ColorMap const colorMap, size_t const numberOfColors)
+{
+    m_vectorDataTextureLocation = m_colorMapCache.select(*this, ColorMapCache::Slot::VectorData, colorMap,
+                                                         numberOfColors, m_customColors);
+    return m_vectorDataTextureLocation;
 }
 
 void Visualization::opengl_generateAndLoadLicNoiseTexture()
@@ -686,37 +1294,95 @@ void Visualization::opengl_generateAndLoadLicNoiseTexture()
                  noiseTexture.data());
 }
 
-void Visualization::opengl_loadLicVelocityField(std::vector<float> const &velocityField)
+// (Re)allocates the two convolution textures of the ping-pong LIC to the size of the LIC texture.
+void Visualization::opengl_resizeLicConvolution()
 {
-    glBindTexture(GL_TEXTURE_2D, m_licVelocityField);
+    for (size_t idx = 0U; idx < m_licConvolutionTextures.size(); ++idx)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_licConvolutionTextures[idx]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_R16F,
+                     m_licTextureWidth,
+                     m_licTextureHeight,
+                     0,
+                     GL_RED,
+                     GL_FLOAT,
+                     nullptr);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_licFramebuffers[idx]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_licConvolutionTextures[idx], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            qDebug() << "LIC convolution framebuffer" << idx << "is incomplete.";
+    }
 
-    // These are the defaults and do not need to be set explicitly.
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    m_licConvolutionIsValid = false;
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+// Copies the velocities of the current frame into the velocity texture through a pixel buffer object.
+// The texture keeps its storage, it is only allocated in opengl_setupLic.
+void Visualization::opengl_updateLicVelocityField()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_updateLicVelocityField"};
 
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,
-                 GL_RG32F,
-                 static_cast<GLsizei>(m_DIM),
-                 static_cast<GLsizei>(m_DIM),
-                 0,
-                 GL_RG,
-                 GL_FLOAT,
-                 velocityField.data());
+    SimulationFrame const &frame = m_simulationWorker.frame();
+    if (m_licVelocityFieldFrameNumber == frame.frameNumber())
+        return; // Paused, or this frame was already uploaded.
+
+    std::vector<float> const &velocityX = frame.velocityX();
+    std::vector<float> const &velocityY = frame.velocityY();
+    size_t const numberOfSamples = m_DIMX * m_DIMY;
+    auto const size = static_cast<GLsizeiptr>(2U * numberOfSamples * sizeof(float));
+
+    // Orphan the previous storage, so that mapping does not wait for the previous upload.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pboLicVelocityField);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+    // Interleave the two velocity components. They are normalized in lic.frag.
+    auto * const velocityField = static_cast<float*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (velocityField != nullptr)
+    {
+        for (size_t idx = 0U; idx < numberOfSamples; ++idx)
+        {
+            velocityField[2U * idx] = velocityX[idx];
+            velocityField[2U * idx + 1U] = velocityY[idx];
+        }
+    }
+
+    if (velocityField != nullptr && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+    {
+        // With a bound pixel unpack buffer, the data pointer is an offset into that buffer.
+        glBindTexture(GL_TEXTURE_2D, m_licVelocityField);
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0,
+                        0,
+                        static_cast<GLsizei>(m_DIMX),
+                        static_cast<GLsizei>(m_DIMY),
+                        GL_RG,
+                        GL_FLOAT,
+                        static_cast<GLvoid*>(nullptr));
+        m_licVelocityFieldFrameNumber = frame.frameNumber();
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 void Visualization::opengl_updateScalarPoints()
 {
     // Recompute and upload grid coordinates.
     std::vector<QVector2D> scalarPoints;
-    scalarPoints.reserve(m_DIM * m_DIM);
+    scalarPoints.reserve(m_DIMX * m_DIMY);
 
-    for (size_t j = 0U; j < m_DIM; ++j)
+    for (size_t j = 0U; j < m_DIMY; ++j)
     {
-        for (size_t i = 0U; i < m_DIM; ++i)
+        for (size_t i = 0U; i < m_DIMX; ++i)
         {
             auto const iFloat = static_cast<float>(i);
             auto const jFloat = static_cast<float>(j);
@@ -739,6 +1405,28 @@ void Visualization::opengl_updateScalarPoints()
                     0,
                     static_cast<GLsizeiptr>(scalarPoints.size() * 2U * sizeof(float)),
                     scalarPoints.data());
+
+    // The quad spans the same grid points. Texel centers lie on the grid points, so the texture coordinates of the
+    // corners are half a texel inside of the texture.
+    float const minX = m_cellWidth - 1.0F;
+    float const maxX = static_cast<float>(m_DIMX) * m_cellWidth - 1.0F;
+    float const minY = m_cellHeight - 1.0F;
+    float const maxY = static_cast<float>(m_DIMY) * m_cellHeight - 1.0F;
+    float const texMinX = 0.5F / static_cast<float>(m_DIMX);
+    float const texMaxX = 1.0F - texMinX;
+    float const texMinY = 0.5F / static_cast<float>(m_DIMY);
+    float const texMaxY = 1.0F - texMinY;
+
+    std::array<QVector2D, 8U> const quadCoordsAndTexCoords{QVector2D{minX, maxY}, QVector2D{texMinX, texMaxY},
+                                                           QVector2D{minX, minY}, QVector2D{texMinX, texMinY},
+                                                           QVector2D{maxX, maxY}, QVector2D{texMaxX, texMaxY},
+                                                           QVector2D{maxX, minY}, QVector2D{texMaxX, texMinY}};
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarDataQuad);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    0,
+                    static_cast<GLsizeiptr>(quadCoordsAndTexCoords.size() * sizeof(QVector2D)),
+                    quadCoordsAndTexCoords.data());
 }
 
 void Visualization::opengl_updateLicPoints()
@@ -747,23 +1435,25 @@ void Visualization::opengl_updateLicPoints()
     std::vector<QVector2D> licCoordsAndTexCoords;
     licCoordsAndTexCoords.reserve(8U);
 
-    float const min = m_cellWidth - 1.0F;
-    float const max = static_cast<float>(m_DIM) * m_cellWidth - 1.0F;
+    float const minX = m_cellWidth - 1.0F;
+    float const maxX = static_cast<float>(m_DIMX) * m_cellWidth - 1.0F;
+    float const minY = m_cellHeight - 1.0F;
+    float const maxY = static_cast<float>(m_DIMY) * m_cellHeight - 1.0F;
 
     // Top left OpenGL coordinate.
-    licCoordsAndTexCoords.emplace_back(min, max);
+    licCoordsAndTexCoords.emplace_back(minX, maxY);
     licCoordsAndTexCoords.emplace_back(0.0F, 1.0F);
 
     // Bottom left
-    licCoordsAndTexCoords.emplace_back(min, min);
+    licCoordsAndTexCoords.emplace_back(minX, minY);
     licCoordsAndTexCoords.emplace_back(0.0F, 0.0F);
 
     // Top right
-    licCoordsAndTexCoords.emplace_back(max, max);
+    licCoordsAndTexCoords.emplace_back(maxX, maxY);
     licCoordsAndTexCoords.emplace_back(1.0F, 1.0F);
 
     // Bottom right
-    licCoordsAndTexCoords.emplace_back(max, min);
+    licCoordsAndTexCoords.emplace_back(maxX, minY);
     licCoordsAndTexCoords.emplace_back(1.0F, 0.0F);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_vboLic);
@@ -885,107 +1575,641 @@ void Visualization::opengl_drawScalarData(std::vector<float> const &scalarValues
     glBindVertexArray(m_vaoScalarData);
 
     // Copy scalars to GPU buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboScalarData);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    static_cast<GLsizeiptr>(scalarValues.size() * sizeof(float)),
-                    scalarValues.data());
+    GLintptr const offset = m_vboScalarData.write(scalarValues.data(), scalarValues.size() * sizeof(float));
+    glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(offset));
 
     glDrawElements(GL_TRIANGLE_STRIP,
                    static_cast<GLsizei>(m_indices.size()),
-                   GL_UNSIGNED_SHORT,
+                   m_indexType,
                    static_cast<GLvoid*>(nullptr));
+
+    m_vboScalarData.fence();
 }
 
-void Visualization::opengl_drawIsolines()
+// Draws the scalar data as a single quad. Mapping, transfer function and color lookup happen per fragment.
+void Visualization::opengl_drawScalarDataTexture(std::vector<float> const &scalarValues, bool const isPreprocessed)
 {
-    float const stepsize = [&]()
+    QVector2D range;
+    switch (m_currentMappingType)
     {
-        if (m_numberOfIsolines > 1)
-            return (m_isolineMaxValue - m_isolineMinValue) / (m_numberOfIsolines - 1);
-
-        return 1.0F;
+        case MappingType::Scaling:
+        {
+            auto const currentMinMaxIt = std::minmax_element(scalarValues.cbegin(), scalarValues.cend());
+            QVector2D const currentMinMax{*currentMinMaxIt.first, *currentMinMaxIt.second};
+
+            m_minMaxDensity.update(currentMinMax);
+            range = m_minMaxDensity.range();
+        }
+        break;
+
+        case MappingType::Clamping:
+            range = QVector2D{m_clampMin, m_clampMax};
+        break;
+    }
+
+    // Send values to GUI.
+    if (m_sendMinMaxToUI)
+    {
+        auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
+        Q_ASSERT(mainWindowPtr != nullptr);
+        mainWindowPtr->setScalarDataMin(range.x());
+        mainWindowPtr->setScalarDataMax(range.y());
+    }
+
+    opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarValues, isPreprocessed);
+    opengl_drawScalarFieldQuad(range, m_scalarFieldTexture);
+}
+
+// Draws the scalar data filtered by the GPU preprocessing passes. The values never leave the GPU, only the range is
+// read back in the scaling mapping.
+void Visualization::opengl_drawPreprocessedScalarDataTexture()
+{
+    opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarField(m_currentScalarDataType), false);
+    opengl_preprocessScalarFieldOnGpu();
+
+    QVector2D range;
+    switch (m_currentMappingType)
+    {
+        case MappingType::Scaling:
+            m_minMaxDensity.update(opengl_preprocessedRange());
+            range = m_minMaxDensity.range();
+        break;
+
+        case MappingType::Clamping:
+            range = QVector2D{m_clampMin, m_clampMax};
+        break;
+    }
+
+    if (m_sendMinMaxToUI)
+    {
+        auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
+        Q_ASSERT(mainWindowPtr != nullptr);
+        mainWindowPtr->setScalarDataMin(range.x());
+        mainWindowPtr->setScalarDataMax(range.y());
+    }
+
+    opengl_drawScalarFieldQuad(range, m_preprocessingTextures[m_preprocessedTexture]);
+}
+
+// Draws the density of the GPU simulation straight from its texture. Like the GPU preprocessing, only the range is
+// read back in the scaling mapping.
+void Visualization::opengl_drawGpuSimulationDensity()
+{
+    QVector2D range;
+    switch (m_currentMappingType)
+    {
+        case MappingType::Scaling:
+            m_minMaxDensity.update(opengl_textureRange(m_gpuSimulation.densityTexture()));
+            range = m_minMaxDensity.range();
+        break;
+
+        case MappingType::Clamping:
+            range = QVector2D{m_clampMin, m_clampMax};
+        break;
+    }
+
+    if (m_sendMinMaxToUI)
+    {
+        auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
+        Q_ASSERT(mainWindowPtr != nullptr);
+        mainWindowPtr->setScalarDataMin(range.x());
+        mainWindowPtr->setScalarDataMax(range.y());
+    }
+
+    opengl_drawScalarFieldQuad(range, m_gpuSimulation.densityTexture());
+}
+
+void Visualization::opengl_drawScalarFieldQuad(QVector2D const range, GLuint const scalarFieldTexture)
+{
+    m_shaderProgramScalarDataField.bind();
+    glUniform1f(m_uniformLocationScalarDataField_rangeMin, range.x());
+    glUniform1f(m_uniformLocationScalarDataField_rangeMax, range.y());
+    glUniform1f(m_uniformLocationScalarDataField_transferK, m_transferK);
+
+    glUniform1i(m_uniformLocationScalarDataField_useCustomColorMap, m_useCustomColorMap ? GL_TRUE : GL_FALSE);
+    GLfloat const *ptrToFirstElement = &m_customColors[0].r;
+    glUniform3fv(m_uniformLocationScalarDataField_colorMapColors, 3, ptrToFirstElement);
+
+    glUniform1i(m_uniformLocationScalarDataField_texture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_1D, m_scalarDataTextureLocation);
+
+    glUniform1i(m_uniformLocationScalarDataField_scalarField, 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scalarFieldTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(m_vaoScalarDataQuad);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+// Uploads the scalar field into the R32F texture, unless the texture already holds this field for the current frame.
+// Only unpreprocessed values are shared with the isoline and height plot views.
+// The unpreprocessed density of a FieldPrecision::Float16 frame is uploaded from its halves instead, half the bytes.
+// Their rows stay 4-byte aligned, as DIMX is even.
+void Visualization::opengl_updateScalarFieldTexture(ScalarDataType const type, std::vector<float> const &scalarValues,
+                                                    bool const isPreprocessed)
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_updateScalarFieldTexture"};
+
+    if (!isPreprocessed && scalarFieldTextureHolds(type))
+        return;
+
+    SimulationFrame const &frame = m_simulationWorker.frame();
+    bool const uploadHalves = !isPreprocessed && type == ScalarDataType::Density &&
+                              frame.precision() == FieldPrecision::Float16;
+
+    glBindTexture(GL_TEXTURE_2D, m_scalarFieldTexture);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0,
+                    0,
+                    static_cast<GLsizei>(m_DIMX),
+                    static_cast<GLsizei>(m_DIMY),
+                    GL_RED,
+                    uploadHalves ? GL_HALF_FLOAT : GL_FLOAT,
+                    uploadHalves ? static_cast<GLvoid const*>(frame.densityHalf().data())
+                                 : static_cast<GLvoid const*>(scalarValues.data()));
+
+    m_scalarFieldTextureFrameNumber = frame.frameNumber();
+    m_scalarFieldTextureType = type;
+    m_scalarFieldTextureIsShared = !isPreprocessed;
+}
+
+bool Visualization::scalarFieldTextureHolds(ScalarDataType const type) const
+{
+    return m_scalarFieldTextureIsShared &&
+           m_scalarFieldTextureDIMX == m_DIMX &&
+           m_scalarFieldTextureDIMY == m_DIMY &&
+           m_scalarFieldTextureType == type &&
+           m_scalarFieldTextureFrameNumber == m_simulationWorker.frame().frameNumber();
+}
+
+// Runs the enabled filters as fragment shader passes, in the order quantization, blur, gradients, once per frame.
+// The scalar field texture must hold the unfiltered current scalar field.
+void Visualization::opengl_preprocessScalarFieldOnGpu()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_preprocessScalarFieldOnGpu"};
+
+    if (preprocessedTextureHolds(m_currentScalarDataType))
+        return;
+
+    // Must match the PASS_ defines in preprocessing.frag.
+    GLint constexpr passQuantization = 0;
+    GLint constexpr passBlurHorizontal = 1;
+    GLint constexpr passBlurVertical = 2;
+    GLint constexpr passGradients = 3;
+
+    std::array<GLint, 4U> viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    glBindVertexArray(m_vaoScalarDataQuad);
+
+    // Quantization maps the values relative to the maximum of the unfiltered field.
+    if (m_useQuantization)
+        opengl_reduceRange(m_scalarFieldTexture);
+
+    glViewport(0, 0, static_cast<GLsizei>(m_DIMX), static_cast<GLsizei>(m_DIMY));
+    m_shaderProgramPreprocessing.bind();
+    glUniform1i(m_uniformLocationPreprocessing_field, 1);
+    glUniform1i(m_uniformLocationPreprocessing_range, 2);
+    glUniform1f(m_uniformLocationPreprocessing_quantizationStep, PreprocessingPipeline::quantizationStep(m_quantizationBits));
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, m_preprocessingRangeTextures[m_preprocessingRangeLevels - 1U]);
+
+    // Every pass reads the result of the previous one and writes into the other texture.
+    GLuint input = m_scalarFieldTexture;
+    auto const runPass = [&](GLint const pass)
+    {
+        size_t const output = input == m_scalarFieldTexture ? 0U : 1U - m_preprocessedTexture;
+
+        glUniform1i(m_uniformLocationPreprocessing_pass, pass);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_preprocessingFramebuffers[output]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        m_preprocessedTexture = output;
+        input = m_preprocessingTextures[output];
+    };
+
+    if (m_useQuantization)
+        runPass(passQuantization);
+
+    if (m_useGaussianBlur)
+    {
+        runPass(passBlurHorizontal);
+        runPass(passBlurVertical);
+    }
+
+    if (m_useGradients)
+        runPass(passGradients);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    m_preprocessedTextureType = m_currentScalarDataType;
+    m_preprocessedTextureIsCurrent = true;
+}
+
+// Reduces the red channel of the DIMX x DIMY texture to its (min, max), in the last level of the range textures.
+// Binds the range framebuffers, the caller restores the framebuffer and the viewport.
+void Visualization::opengl_reduceRange(GLuint const texture)
+{
+    m_shaderProgramPreprocessingRange.bind();
+    glUniform1i(m_uniformLocationPreprocessingRange_field, 1);
+    glActiveTexture(GL_TEXTURE1);
+
+    auto levelWidth = static_cast<GLsizei>(m_DIMX);
+    auto levelHeight = static_cast<GLsizei>(m_DIMY);
+    GLuint input = texture;
+    for (size_t level = 0U; level < m_preprocessingRangeLevels; ++level)
+    {
+        levelWidth = (levelWidth + 3) / 4;
+        levelHeight = (levelHeight + 3) / 4;
+        glViewport(0, 0, levelWidth, levelHeight);
+
+        glUniform1i(m_uniformLocationPreprocessingRange_reduceValues, level == 0U ? GL_TRUE : GL_FALSE);
+        glBindTexture(GL_TEXTURE_2D, input);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_preprocessingRangeFramebuffers[level]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        input = m_preprocessingRangeTextures[level];
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// Returns the (min, max) of the GPU preprocessing result.
+QVector2D Visualization::opengl_preprocessedRange()
+{
+    return opengl_textureRange(m_preprocessingTextures[m_preprocessedTexture]);
+}
+
+// Returns the (min, max) of a DIMX x DIMY texture. The range is copied into one of two pixel buffer objects and the copy
+// of the previous call is returned, so the CPU does not wait for the passes of this frame. Only the first call waits.
+// The one frame delay is hidden by the moving range of the scaling mapping.
+QVector2D Visualization::opengl_textureRange(GLuint const texture)
+{
+    std::array<GLint, 4U> viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    glBindVertexArray(m_vaoScalarDataQuad);
+
+    opengl_reduceRange(texture);
+
+    size_t const current = m_preprocessingRangeReadbacks % m_pboPreprocessingRange.size();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pboPreprocessingRange[current]);
+    glReadPixels(0, 0, 1, 1, GL_RG, GL_FLOAT, static_cast<GLvoid*>(nullptr));
+
+    size_t const previous = m_preprocessingRangeReadbacks == 0U ? current : 1U - current;
+    ++m_preprocessingRangeReadbacks;
+
+    QVector2D range;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pboPreprocessingRange[previous]);
+    auto const rangePtr = static_cast<GLfloat const*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                                                                        0,
+                                                                        static_cast<GLsizeiptr>(2U * sizeof(GLfloat)),
+                                                                        GL_MAP_READ_BIT));
+    if (rangePtr != nullptr)
+    {
+        range = QVector2D{rangePtr[0], rangePtr[1]};
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    return range;
+}
+
+bool Visualization::preprocessedTextureHolds(ScalarDataType const type) const
+{
+    return m_preprocessedTextureIsCurrent && m_preprocessedTextureType == type;
+}
+
+// Recomputes the isovalues and their colors and uploads them to both isolines shader programs.
+void Visualization::opengl_updateIsolineLevels()
+{
+    size_t const numberOfIsolines = std::min(m_numberOfIsolines, s_maxNumberOfIsolines);
+    float const stepsize = [&]()
+    {
+        if (numberOfIsolines > 1)
+            return (m_isolineMaxValue - m_isolineMinValue) / (numberOfIsolines - 1);
+
+        return 1.0F;
     }();
 
-    std::vector<float> scalarValues;
+    m_isolineValues.resize(numberOfIsolines);
+    for (size_t n = 0U; n < numberOfIsolines; ++n)
+        m_isolineValues[n] = m_isolineMinValue + (n * stepsize);
+
+    if (numberOfIsolines == 1U)
+        m_isolineColors.assign(1U, {m_isolineColor.x(), m_isolineColor.y(), m_isolineColor.z()});
+    else
+        m_isolineColors = m_colorMapCache.colors(ColorMap::Turbo, numberOfIsolines, m_customColors);
+
+    m_shaderProgramIsolines.bind();
+    glUniform1fv(m_uniformLocationIsolines_values, static_cast<GLsizei>(numberOfIsolines), m_isolineValues.data());
+    glUniform3fv(m_uniformLocationIsolines_colors, static_cast<GLsizei>(numberOfIsolines), &m_isolineColors[0].r);
+
+    m_shaderProgramIsolineSegments.bind();
+    glUniform3fv(m_uniformLocationIsolineSegments_colors, static_cast<GLsizei>(numberOfIsolines), &m_isolineColors[0].r);
+
+    m_isolineLevelsChanged = false;
+}
+
+void Visualization::opengl_drawIsolines()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawIsolines"};
 
-    switch (m_manuallyChooseIsolineDataType ? m_currentIsolineDataType : m_currentScalarDataType)
+    if (m_isolineLevelsChanged)
+        opengl_updateIsolineLevels();
+
+    if (m_extractIsolinesOnCpu)
     {
-    case ScalarDataType::Density: scalarValues = m_simulation.density(); break;
-    case ScalarDataType::ForceFieldMagnitude: scalarValues = m_simulation.forceFieldMagnitude(); break;
-    case ScalarDataType::VelocityMagnitude: scalarValues = m_simulation.velocityMagnitude(); break;
-    case ScalarDataType::VelocityDivergence: scalarValues = velocityDivergence(); break;
-    case ScalarDataType::ForceFieldDivergence: scalarValues = forceFieldDivergence(); break;
+        opengl_drawIsolineSegments(false);
+        return;
     }
 
-    std::vector<Color> const colorMap = Texture::createTurboTexture(m_numberOfIsolines);
-    for (size_t n = 0U; n < m_numberOfIsolines; ++n)
+    ScalarDataType const isolineDataType = m_manuallyChooseIsolineDataType ? m_currentIsolineDataType : m_currentScalarDataType;
+
+    // Reuse the scalar field texture if the scalar data view already uploaded this field, or the result of the GPU
+    // preprocessing if the scalar data view filtered it.
+    bool const samplePreprocessedField = preprocessedTextureHolds(isolineDataType);
+    bool const sampleScalarField = samplePreprocessedField ||
+                                   (m_drawScalarDataAsTexture && scalarFieldTextureHolds(isolineDataType));
+
+    glBindVertexArray(m_vaoIsolines);
+    if (sampleScalarField)
     {
-        float const currentIsolineValue = m_isolineMinValue + (n * stepsize);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, samplePreprocessedField ? m_preprocessingTextures[m_preprocessedTexture]
+                                                             : m_scalarFieldTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    else
+    {
+        std::vector<float> const &scalarValues = scalarField(isolineDataType);
+        GLintptr const offset = m_vboIsolineValues.write(scalarValues.data(), scalarValues.size() * sizeof(float));
+        glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, 0U, reinterpret_cast<GLvoid*>(offset));
+    }
 
-        m_shaderProgramIsolines.bind();
-        switch (m_isolinesInterpolationMethod)
-        {
-        case IsolinesInterpolationMethod::Linear:
-            glUniform1i(m_uniformLocationIsolines_useInterpolation, GL_TRUE);
-            break;
+    m_shaderProgramIsolines.bind();
+    switch (m_isolinesInterpolationMethod)
+    {
+    case IsolinesInterpolationMethod::Linear:
+        glUniform1i(m_uniformLocationIsolines_useInterpolation, GL_TRUE);
+        break;
 
-        case IsolinesInterpolationMethod::None:
-            glUniform1i(m_uniformLocationIsolines_useInterpolation, GL_FALSE);
-            break;
-        }
+    case IsolinesInterpolationMethod::None:
+        glUniform1i(m_uniformLocationIsolines_useInterpolation, GL_FALSE);
+        break;
+    }
 
-        switch (m_isolinesAmbiguousCaseDecider)
-        {
-        case IsolinesAmbiguousCaseDecider::Midpoint:
-            glUniform1i(m_uniformLocationIsolines_ambiguousCaseMidpoint, GL_TRUE);
-            break;
+    switch (m_isolinesAmbiguousCaseDecider)
+    {
+    case IsolinesAmbiguousCaseDecider::Midpoint:
+        glUniform1i(m_uniformLocationIsolines_ambiguousCaseMidpoint, GL_TRUE);
+        break;
 
-        case IsolinesAmbiguousCaseDecider::Asymptotic:
-            glUniform1i(m_uniformLocationIsolines_ambiguousCaseMidpoint, GL_FALSE);
-            break;
-        }
+    case IsolinesAmbiguousCaseDecider::Asymptotic:
+        glUniform1i(m_uniformLocationIsolines_ambiguousCaseMidpoint, GL_FALSE);
+        break;
+    }
+
+    glUniform1i(m_uniformLocationIsolines_sampleScalarField, sampleScalarField ? GL_TRUE : GL_FALSE);
+    glUniform1i(m_uniformLocationIsolines_scalarField, 1);
+
+    // One instance per isoline, so the grid is traversed by a single draw call.
+    glDrawElementsInstanced(GL_LINES_ADJACENCY,
+                            m_numberOfIsolinesIndices,
+                            m_indexType,
+                            static_cast<GLvoid*>(nullptr),
+                            static_cast<GLsizei>(m_isolineValues.size()));
+
+    if (!sampleScalarField)
+        m_vboIsolineValues.fence();
+}
 
-        glUniform1f(m_uniformLocationIsolines_rho, currentIsolineValue);
+// The isolines over the height plot. These are always extracted on the CPU, as the segments are lifted onto the surface
+// by their vertex shader.
+void Visualization::opengl_drawIsolinesOnHeightplot()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawIsolinesOnHeightplot"};
 
-        if (m_numberOfIsolines == 1U)
-            glUniform3fv(m_uniformLocationIsolines_color, 1, &m_isolineColor[0]);
-        else
-            glUniform3f(m_uniformLocationIsolines_color, colorMap[n].r, colorMap[n].g, colorMap[n].b);
+    if (m_isolineLevelsChanged)
+        opengl_updateIsolineLevels();
 
-        glBindVertexArray(m_vaoIsolines);
+    opengl_drawIsolineSegments(true);
+}
 
-        glDrawElements(GL_LINES_ADJACENCY, m_numberOfIsolinesIndices, GL_UNSIGNED_SHORT, static_cast<GLvoid*>(nullptr));
+// Extracts the isolines with marching squares and draws the segments as plain lines, without a geometry shader.
+void Visualization::opengl_drawIsolineSegments(bool const onHeightplot)
+{
+    ScalarDataType const isolineDataType = m_manuallyChooseIsolineDataType ? m_currentIsolineDataType : m_currentScalarDataType;
+
+    m_marchingSquares.extract(scalarField(isolineDataType),
+                              m_DIMX,
+                              m_DIMY,
+                              m_isolineValues,
+                              m_isolinesInterpolationMethod == IsolinesInterpolationMethod::Linear,
+                              m_isolinesAmbiguousCaseDecider == IsolinesAmbiguousCaseDecider::Midpoint,
+                              m_threadPool,
+                              m_isolineSegments);
+    if (m_isolineSegments.empty())
+        return;
+
+    glBindVertexArray(m_vaoIsolineSegments);
+    GLintptr const offset = m_vboIsolineSegments.write(m_isolineSegments.data(),
+                                                       m_isolineSegments.size() * sizeof(MarchingSquares::Vertex));
+    glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, sizeof(MarchingSquares::Vertex), reinterpret_cast<GLvoid*>(offset));
+    glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, sizeof(MarchingSquares::Vertex),
+                          reinterpret_cast<GLvoid*>(offset + offsetof(MarchingSquares::Vertex, level)));
+
+    m_shaderProgramIsolineSegments.bind();
+    glUniform2f(m_uniformLocationIsolineSegments_cellSize, m_cellWidth, m_cellHeight);
+    glUniform1i(m_uniformLocationIsolineSegments_onHeightplot, onHeightplot ? GL_TRUE : GL_FALSE);
+    if (onHeightplot)
+    {
+        glUniformMatrix4fv(m_uniformLocationIsolineSegments_projection, 1, GL_FALSE, m_projectionTransformationMatrix.data());
+        glUniformMatrix4fv(m_uniformLocationIsolineSegments_view, 1, GL_FALSE, m_viewTransformationMatrix.data());
+        glUniform1f(m_uniformLocationIsolineSegments_heightScale, s_heightplotHeightScale);
+        glUniform1i(m_uniformLocationIsolineSegments_heightField, 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, opengl_updateHeightFieldTexture());
+        glActiveTexture(GL_TEXTURE0);
     }
+
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_isolineSegments.size()));
+
+    m_vboIsolineSegments.fence();
 }
 
-void Visualization::opengl_drawHeightplot()
+// The seeds lie on m_streamlineSeedsPerRow rows and columns that leave half a spacing free at the border of the grid.
+void Visualization::updateStreamlineSeeds()
+{
+    size_t const numberOfSeeds = m_streamlineSeedsPerRow * m_streamlineSeedsPerRow;
+    if (m_streamlineSeeds.size() == numberOfSeeds && m_streamlineSeedsDIMX == m_DIMX && m_streamlineSeedsDIMY == m_DIMY)
+        return;
+
+    float const spacingX = static_cast<float>(m_DIMX - 1U) / static_cast<float>(m_streamlineSeedsPerRow);
+    float const spacingY = static_cast<float>(m_DIMY - 1U) / static_cast<float>(m_streamlineSeedsPerRow);
+    m_streamlineSeedsDIMX = m_DIMX;
+    m_streamlineSeedsDIMY = m_DIMY;
+    m_streamlineSeeds.clear();
+    m_streamlineSeeds.reserve(numberOfSeeds);
+    for (size_t j = 0U; j < m_streamlineSeedsPerRow; ++j)
+        for (size_t i = 0U; i < m_streamlineSeedsPerRow; ++i)
+            m_streamlineSeeds.push_back({(static_cast<float>(i) + 0.5F) * spacingX,
+                                         (static_cast<float>(j) + 0.5F) * spacingY});
+}
+
+// Streamlines of the current frame, or pathlines through the last m_streamlineLength frames. Both are traced into the
+// mapped vertex buffer and drawn as one line strip per seed, colored by the vector data color map.
+void Visualization::opengl_drawStreamlines()
 {
-    std::vector<float> scalarValues;
-    std::vector<float> heightValues;
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawStreamlines"};
+
+    // Right after a change of the grid size, the frame may still be of the previous grid.
+    SimulationFrame const &frame = m_simulationWorker.frame();
+    if (frame.DIMX() != m_DIMX || frame.DIMY() != m_DIMY)
+        return;
+
+    updateStreamlineSeeds();
+    size_t const numberOfLines = m_streamlineSeeds.size();
+    size_t const numberOfVertices = std::max<size_t>(m_streamlineLength, 2U);
+    if (numberOfLines == 0U)
+        return;
 
-    switch (m_currentScalarDataType)
+    if (m_drawPathlines)
+        m_streamlineTracer.recordFrame(frame.velocityX(), frame.velocityY(), m_DIMX, m_DIMY, numberOfVertices,
+                                       frame.step());
+
+    glBindVertexArray(m_vaoStreamlines);
+    auto * const vertices = static_cast<StreamlineTracer::Vertex*>(
+                m_vboStreamlines.map(numberOfLines * numberOfVertices * sizeof(StreamlineTracer::Vertex)));
+    if (vertices == nullptr)
+        return;
+
+    float const maxSpeed = m_drawPathlines
+                         ? m_streamlineTracer.tracePathlines(m_streamlineSeeds, m_simulationWorker.stepDt(),
+                                                             m_threadPool, vertices)
+                         : m_streamlineTracer.traceStreamlines(frame.velocityX(), frame.velocityY(), m_DIMX, m_DIMY,
+                                                               m_streamlineSeeds, numberOfVertices,
+                                                               s_streamlineStepSize, m_threadPool, vertices);
+    GLintptr const offset = m_vboStreamlines.unmap();
+    glVertexAttribPointer(0U, 2, GL_FLOAT, GL_FALSE, sizeof(StreamlineTracer::Vertex), reinterpret_cast<GLvoid*>(offset));
+    glVertexAttribPointer(1U, 1, GL_FLOAT, GL_FALSE, sizeof(StreamlineTracer::Vertex),
+                          reinterpret_cast<GLvoid*>(offset + offsetof(StreamlineTracer::Vertex, speed)));
+
+    if (m_streamlineFirsts.size() != numberOfLines || m_streamlineCounts.front() != static_cast<GLsizei>(numberOfVertices))
     {
-        case ScalarDataType::Density: scalarValues = m_simulation.density(); break;
-        case ScalarDataType::ForceFieldMagnitude: scalarValues = m_simulation.forceFieldMagnitude(); break;
-        case ScalarDataType::VelocityMagnitude: scalarValues = m_simulation.velocityMagnitude(); break;
-        case ScalarDataType::VelocityDivergence: scalarValues = velocityDivergence(); break;
-        case ScalarDataType::ForceFieldDivergence: scalarValues = forceFieldDivergence(); break;
+        m_streamlineFirsts.resize(numberOfLines);
+        for (size_t line = 0U; line < numberOfLines; ++line)
+            m_streamlineFirsts[line] = static_cast<GLint>(line * numberOfVertices);
+        m_streamlineCounts.assign(numberOfLines, static_cast<GLsizei>(numberOfVertices));
     }
 
-    switch (m_currentHeightplotDataType)
+    m_shaderProgramStreamlines.bind();
+    glUniform2f(m_uniformLocationStreamlines_cellSize, m_cellWidth, m_cellHeight);
+    glUniform1f(m_uniformLocationStreamlines_maxSpeed, std::max(maxSpeed, std::numeric_limits<float>::min()));
+    glUniform1i(m_uniformLocationStreamlines_texture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_1D, m_vectorDataTextureLocation);
+
+    glMultiDrawArrays(GL_LINE_STRIP, m_streamlineFirsts.data(), m_streamlineCounts.data(),
+                      static_cast<GLsizei>(numberOfLines));
+
+    m_vboStreamlines.fence();
+}
+
+// The particles follow the GPU simulation while it runs, and otherwise the simulation steps of the CPU frames, through
+// the velocity texture of the LIC.
+void Visualization::opengl_drawParticles()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawParticles"};
+
+    if (m_particleSystem.capacity() != m_numberOfParticles)
+        m_particleSystem.setCapacity(m_numberOfParticles);
+
+    float const aspectRatio = static_cast<float>(m_DIMX) / static_cast<float>(m_DIMY);
+    if (simulatesOnGpu())
+        m_particleSystem.advance(m_gpuSimulation.velocityTexture(), m_simulationWorker.dt(), m_isRunning ? 1U : 0U,
+                                 aspectRatio);
+    else
     {
-        case ScalarDataType::Density: heightValues = m_simulation.density(); break;
-        case ScalarDataType::ForceFieldMagnitude: heightValues = m_simulation.forceFieldMagnitude(); break;
-        case ScalarDataType::VelocityMagnitude: heightValues = m_simulation.velocityMagnitude(); break;
-        case ScalarDataType::VelocityDivergence: heightValues = velocityDivergence(); break;
-        case ScalarDataType::ForceFieldDivergence: heightValues = forceFieldDivergence(); break;
+        // A restarted simulation counts from zero again.
+        size_t const step = m_simulationWorker.frame().step();
+        size_t const steps = step > m_particlesStep ? std::min(step - m_particlesStep, s_maxParticleStepsPerFrame) : 0U;
+        m_particlesStep = step;
+        m_particleSystem.advance(m_licVelocityField, m_simulationWorker.stepDt(), steps, aspectRatio);
     }
 
+    m_particleSystem.draw(m_DIMX, m_DIMY, m_cellWidth, m_cellHeight, m_vectorDataTextureLocation);
+    glBindVertexArray(0U);
+}
+
+// Uploads the heights of the height plot, unless this frame's heights are already in a texture, and returns the texture
+// that holds them. The scalar field texture is reused when it already holds the heights.
+GLuint Visualization::opengl_updateHeightFieldTexture()
+{
+    if (m_drawScalarDataAsTexture && scalarFieldTextureHolds(m_currentHeightplotDataType))
+        return m_scalarFieldTexture;
+
+    size_t const frameNumber = m_simulationWorker.frame().frameNumber();
+    if (m_heightFieldTextureFrameNumber == frameNumber && m_heightFieldTextureType == m_currentHeightplotDataType)
+        return m_heightplotHeightTexture;
+
+    std::vector<float> const &heightField = scalarField(m_currentHeightplotDataType);
+    glBindTexture(GL_TEXTURE_2D, m_heightplotHeightTexture);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0,
+                    0,
+                    static_cast<GLsizei>(m_DIMX),
+                    static_cast<GLsizei>(m_DIMY),
+                    GL_RED,
+                    GL_FLOAT,
+                    heightField.data());
+
+    m_heightFieldTextureFrameNumber = frameNumber;
+    m_heightFieldTextureType = m_currentHeightplotDataType;
+    return m_heightplotHeightTexture;
+}
+
+void Visualization::opengl_drawHeightplot()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawHeightplot"};
+
+    std::vector<float> const &scalarValues = scalarField(m_currentScalarDataType);
+
+    // With GPU preprocessing the height plot is colored by the filtered field, which stays on the GPU.
+    bool const colorByPreprocessedField = usesGpuPreprocessing();
+    if (colorByPreprocessedField)
+    {
+        opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarValues, false);
+        opengl_preprocessScalarFieldOnGpu();
+    }
+
+    // The level of detail patches need the neighbouring heights, so they require the height field texture.
+    bool const sampleHeightField = m_computeHeightplotNormalsOnGpu || m_drawHeightplotLod;
+    GLint patchOriginLocation = -1;
+    GLint patchSizeLocation = -1;
+    GLint neighbourStepsLocation = -1;
+
     switch (m_currentMappingType)
     {
         case MappingType::Scaling:
         {
+            QVector2D const currentMinMax = [&]()
+            {
+                if (colorByPreprocessedField)
+                    return opengl_preprocessedRange();
+
+                auto const currentMinMaxIt = std::minmax_element(scalarValues.cbegin(), scalarValues.cend());
+                return QVector2D{*currentMinMaxIt.first, *currentMinMaxIt.second};
+            }();
+
             m_shaderProgramHeightplotScale.bind();
             glUniformMatrix4fv(m_uniformLocationHeightplotScale_projection, 1, GL_FALSE, m_projectionTransformationMatrix.data());
             glUniformMatrix4fv(m_uniformLocationHeightplotScale_view, 1, GL_FALSE, m_viewTransformationMatrix.data());
@@ -994,9 +2218,6 @@ void Visualization::opengl_drawHeightplot()
             glUniform4fv(m_uniformLocationHeightplotScale_material, 1, &m_materialConstants[0]);
             glUniform3fv(m_uniformLocationHeightplotScale_light, 1, &m_lightPosition[0]);
 
-            auto const currentMinMaxIt = std::minmax_element(scalarValues.cbegin(), scalarValues.cend());
-            QVector2D const currentMinMax{*currentMinMaxIt.first, *currentMinMaxIt.second};
-
             m_minMaxDensity.update(currentMinMax);
             QVector2D const minMaxRange{m_minMaxDensity.range()};
 
@@ -1014,6 +2235,16 @@ void Visualization::opengl_drawHeightplot()
             glUniform1f(m_uniformLocationHeightplotScale_transferK, m_transferK);
 
             glUniform1i(m_uniformLocationHeightplotScale_texture, 0);
+            glUniform1i(m_uniformLocationHeightplotScale_sampleScalarField, m_drawScalarDataAsTexture ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotScale_scalarField, 1);
+            glUniform1i(m_uniformLocationHeightplotScale_sampleHeightField, sampleHeightField ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotScale_useLod, m_drawHeightplotLod ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotScale_heightField, 2);
+            glUniform1f(m_uniformLocationHeightplotScale_heightScale, s_heightplotHeightScale);
+            glUniform2f(m_uniformLocationHeightplotScale_cellSize, m_cellWidth, m_cellHeight);
+            patchOriginLocation = m_uniformLocationHeightplotScale_patchOrigin;
+            patchSizeLocation = m_uniformLocationHeightplotScale_patchSize;
+            neighbourStepsLocation = m_uniformLocationHeightplotScale_neighbourSteps;
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_1D, m_scalarDataTextureLocation);
         }
@@ -1040,69 +2271,118 @@ void Visualization::opengl_drawHeightplot()
             glUniform1f(m_uniformLocationHeightplotClamp_transferK, m_transferK);
 
             glUniform1i(m_uniformLocationHeightplotClamp_texture, 0);
+            glUniform1i(m_uniformLocationHeightplotClamp_sampleScalarField, m_drawScalarDataAsTexture ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotClamp_scalarField, 1);
+            glUniform1i(m_uniformLocationHeightplotClamp_sampleHeightField, sampleHeightField ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotClamp_useLod, m_drawHeightplotLod ? GL_TRUE : GL_FALSE);
+            glUniform1i(m_uniformLocationHeightplotClamp_heightField, 2);
+            glUniform1f(m_uniformLocationHeightplotClamp_heightScale, s_heightplotHeightScale);
+            glUniform2f(m_uniformLocationHeightplotClamp_cellSize, m_cellWidth, m_cellHeight);
+            patchOriginLocation = m_uniformLocationHeightplotClamp_patchOrigin;
+            patchSizeLocation = m_uniformLocationHeightplotClamp_patchSize;
+            neighbourStepsLocation = m_uniformLocationHeightplotClamp_neighbourSteps;
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_1D, m_scalarDataTextureLocation);
         }
         break;
     }
 
-    // Add scaling for nicer results
-    std::transform(heightValues.begin(), heightValues.end(), heightValues.begin(),
-                   [](float x){ return x * (1.0F / 9.0F); });
+    glBindVertexArray(m_vaoHeightplot);
 
-    std::vector<QVector3D> normals = computeNormals(heightValues);
+    // Copy scalars to GPU, either into the scalar field texture (shared with the other views) or into the buffer.
+    if (m_drawScalarDataAsTexture)
+    {
+        opengl_updateScalarFieldTexture(m_currentScalarDataType, scalarValues, false);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, colorByPreprocessedField ? m_preprocessingTextures[m_preprocessedTexture]
+                                                              : m_scalarFieldTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    else
+    {
+        GLintptr const scalarValuesOffset = m_vboHeightplotScalarValues.write(scalarValues.data(), scalarValues.size() * sizeof(float));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(scalarValuesOffset));
+    }
 
-    glBindVertexArray(m_vaoHeightplot);
+    std::vector<float> const &heightField = scalarField(m_currentHeightplotDataType);
+    if (sampleHeightField)
+    {
+        // Only the heights are uploaded, the shader scales them and computes the normals.
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, opengl_updateHeightFieldTexture());
+        glActiveTexture(GL_TEXTURE0);
+    }
+    else
+    {
+        // Add scaling for nicer results
+        std::vector<float> heightValues(heightField.size());
+        std::transform(heightField.cbegin(), heightField.cend(), heightValues.begin(),
+                       [](float x){ return x * s_heightplotHeightScale; });
 
-    // Copy scalars to GPU buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotScalarValues);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    static_cast<GLsizeiptr>(scalarValues.size() * sizeof(float)),
-                    scalarValues.data());
+        std::vector<QVector3D> const normals = computeNormals(heightValues);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotHeight);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    static_cast<GLsizeiptr>(heightValues.size() * sizeof(float)),
-                    heightValues.data());
+        GLintptr const heightOffset = m_vboHeightplotHeight.write(heightValues.data(), heightValues.size() * sizeof(float));
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(heightOffset));
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vboHeightplotNormals);
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    0,
-                    static_cast<GLsizeiptr>(normals.size() * 3U * sizeof(float)),
-                    normals.data());
+        GLintptr const normalsOffset = m_vboHeightplotNormals.write(normals.data(), normals.size() * 3U * sizeof(float));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(normalsOffset));
+    }
 
-    glDrawElements(GL_TRIANGLE_STRIP,
-                   static_cast<GLsizei>(m_indices.size()),
-                   GL_UNSIGNED_SHORT,
-                   static_cast<GLvoid*>(nullptr));
+    if (m_drawHeightplotLod)
+    {
+        // A size at distance 1 from the eye, in pixels.
+        float const pixelsPerUnit = 0.5F * static_cast<float>(height()) * m_projectionTransformationMatrix(1, 1);
+        std::vector<HeightplotLod::Patch> const &patches = m_heightplotLod.selectPatches(heightField,
+                                                                                       s_heightplotHeightScale,
+                                                                                       m_viewTransformationMatrix,
+                                                                                       m_cellWidth,
+                                                                                       m_cellHeight,
+                                                                                       pixelsPerUnit);
+
+        size_t const indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboHeightplotLod);
+        for (HeightplotLod::Patch const &patch : patches)
+        {
+            glUniform2i(patchOriginLocation, patch.origin[0], patch.origin[1]);
+            glUniform2i(patchSizeLocation, patch.size[0], patch.size[1]);
+            glUniform4iv(neighbourStepsLocation, 1, patch.neighbourSteps.data());
+
+            glDrawElementsBaseVertex(GL_TRIANGLE_STRIP,
+                                     static_cast<GLsizei>(patch.indexCount),
+                                     m_indexType,
+                                     reinterpret_cast<GLvoid*>(patch.firstIndex * indexSize),
+                                     static_cast<GLint>(patch.baseVertex));
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboHeightplot);
+    }
+    else
+    {
+        glDrawElements(GL_TRIANGLE_STRIP,
+                       static_cast<GLsizei>(m_indices.size()),
+                       m_indexType,
+                       static_cast<GLvoid*>(nullptr));
+    }
+
+    if (!m_drawScalarDataAsTexture)
+        m_vboHeightplotScalarValues.fence();
+    if (!sampleHeightField)
+    {
+        m_vboHeightplotHeight.fence();
+        m_vboHeightplotNormals.fence();
+    }
 }
 
 void Visualization::opengl_drawLic()
 {
-    std::vector<float> const &velocityX = m_simulation.velocityX();
-    std::vector<float> const &velocityY = m_simulation.velocityY();
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawLic"};
 
-    // Combine the two velocity vectors into one interleaved vector
-    auto const velocityField = [&]()
-    {
-        std::vector<float> tmp;
-        tmp.reserve(2U * m_DIM * m_DIM);
+    opengl_updateLicVelocityField();
 
-        for (std::size_t idx = 0U; idx < m_DIM * m_DIM; ++idx)
-        {
-            // Do not use QVector2D's normalize() function, which uses std::hypot to avoid overflow, which makes it slower than this direct implementation.
-            float const magnitude = std::sqrt(std::pow(velocityX[idx], 2.0F) + std::pow(velocityY[idx], 2.0F));
-            float const scale = magnitude == 0.0F ? 0.0F : 1.0F / magnitude;
-
-            tmp.push_back(velocityX[idx] * scale);
-            tmp.push_back(velocityY[idx] * scale);
-        }
-        return tmp;
-    }();
-
-    opengl_loadLicVelocityField(velocityField);
+    if (m_licReuseConvolution)
+    {
+        opengl_drawLicReusingConvolution();
+        return;
+    }
 
     m_shaderProgramLic.bind();
 
@@ -1121,6 +2401,61 @@ void Visualization::opengl_drawLic()
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
+// Temporally coherent LIC: every pass advances the convolution of the previous pass by one step, rendering from one
+// framebuffer into the other. The cost per frame does not depend on the streamline length.
+void Visualization::opengl_drawLicReusingConvolution()
+{
+    std::array<GLint, 4U> viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    glViewport(0, 0, m_licTextureWidth, m_licTextureHeight);
+
+    m_shaderProgramLicAccumulate.bind();
+
+    glUniform1i(m_uniformLocationLicAccumulate_noiseTexture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_licNoiseTexture);
+
+    glUniform1i(m_uniformLocationLicAccumulate_velocityField, 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_licVelocityField);
+
+    glUniform1i(m_uniformLocationLicAccumulate_previousConvolution, 2);
+    glUniform1i(m_uniformLocationLicAccumulate_streamlineLength, m_licStreamlineLength);
+    glUniform1f(m_uniformLocationLicAccumulate_stepSize, m_licStepSize);
+
+    glBindVertexArray(m_vaoLic);
+    for (int pass = 0; pass < s_licPassesPerFrame; ++pass)
+    {
+        size_t const next = 1U - m_licCurrentConvolution;
+
+        // Start from the noise itself after a resize or a mode change.
+        if (!m_licConvolutionIsValid)
+            m_licPassesSinceReset = 0;
+        glUniform1i(m_uniformLocationLicAccumulate_resetConvolution, m_licConvolutionIsValid ? GL_FALSE : GL_TRUE);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, m_licConvolutionTextures[m_licCurrentConvolution]);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_licFramebuffers[next]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        m_licCurrentConvolution = next;
+        m_licConvolutionIsValid = true;
+        ++m_licPassesSinceReset;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    m_shaderProgramLicDisplay.bind();
+    glUniform1i(m_uniformLocationLicDisplay_convolution, 2);
+    glUniform1i(m_uniformLocationLicDisplay_streamlineLength, m_licStreamlineLength);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, m_licConvolutionTextures[m_licCurrentConvolution]);
+    glActiveTexture(GL_TEXTURE0);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
 void Visualization::opengl_updateTexture()
 {
     switch (m_volumeRenderTexture)
@@ -1133,7 +2468,7 @@ void Visualization::opengl_updateTexture()
 
 void Visualization::opengl_updatePreIntegrationLookupTable()
 {
-    int const DIM = 32; //256; //64;
+    int const DIM = 256; // Cheap to build with integral tables, see PreIntegrationTable.
 
     std::vector<QVector4D> const lookupTable = computePreIntegrationLookupTable(DIM);
 
@@ -1156,6 +2491,52 @@ void Visualization::opengl_updatePreIntegrationLookupTable()
                  lookupTable.data());
 }
 
+// Evaluates the gradients of the volumetric lighting shader on a grid over its bounding box, one slice of the 3D
+// texture per pass. The scene does not change over time, so this is done once, and the shader then fetches each
+// gradient instead of sampling the scene for the differences.
+void Visualization::opengl_bakeVolumeRenderingLightingGradients()
+{
+    glBindTexture(GL_TEXTURE_3D, m_volumeRenderingLightingGradientTexture);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_3D,
+                 0,
+                 GL_RGB10_A2,
+                 s_volumeRenderingLightingGradientSize,
+                 s_volumeRenderingLightingGradientSize,
+                 s_volumeRenderingLightingGradientSize,
+                 0,
+                 GL_RGBA,
+                 GL_UNSIGNED_INT_2_10_10_10_REV,
+                 nullptr);
+
+    std::array<GLint, 4U> viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    glViewport(0, 0, s_volumeRenderingLightingGradientSize, s_volumeRenderingLightingGradientSize);
+
+    m_shaderProgramVolumeRenderingLighting.bind();
+    glUniform1i(m_uniformLocationVolumeRenderingLighting_bakeGradients, GL_TRUE);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_volumeRenderingLightingGradientFramebuffer);
+    glBindVertexArray(m_vaoVolumeRendering);
+    for (GLsizei slice = 0; slice < s_volumeRenderingLightingGradientSize; ++slice)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_volumeRenderingLightingGradientTexture, 0, slice);
+        if (slice == 0 && glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            qDebug() << "Volume rendering gradient framebuffer is incomplete.";
+
+        float const bakeSlice = (static_cast<float>(slice) + 0.5F) / static_cast<float>(s_volumeRenderingLightingGradientSize);
+        glUniform1f(m_uniformLocationVolumeRenderingLighting_bakeSlice, bakeSlice);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glUniform1i(m_uniformLocationVolumeRenderingLighting_bakeGradients, GL_FALSE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
 void Visualization::opengl_updateTextureSyntheticCube()
 {
     // Generate synthetic 3D volume data
@@ -1216,6 +2597,10 @@ void Visualization::opengl_updateTextureSyntheticCube()
                  GL_RED,
                  GL_FLOAT,
                  textureData.data());
+
+    m_volumeRenderingIsCompressed = false;
+    m_volumeRenderingBrickLayout = BrickLayout{{size, size, size}, size};
+    opengl_updateVolumeOccupancyTexture();
 }
 
 void Visualization::opengl_updateTextureSyntheticScene()
@@ -1227,8 +2612,7 @@ void Visualization::opengl_loadDataRawFromFile()
 {
     qDebug() << "Reading .dat file:" << m_datFilePath.c_str();
 
-    using reader = datraw::raw_reader<char>;
-    auto r = reader::open(m_datFilePath);
+    auto r = DataRawLoader::Reader::open(m_datFilePath);
 
     m_datRawInfo = r.info();
     qDebug() << "Components:" << m_datRawInfo.components();
@@ -1236,7 +2620,7 @@ void Visualization::opengl_loadDataRawFromFile()
     qDebug() << "Dimensions:" << m_datRawInfo.dimensions();
     qDebug() << "Number of time steps:" << m_datRawInfo.time_steps();
     qDebug() << "Attempt to load the following files:";
-    for (unsigned timeStep = 0U; timeStep < m_datRawInfo.time_steps(); ++timeStep)
+    for (std::uint64_t timeStep = 0U; timeStep < m_datRawInfo.time_steps(); ++timeStep)
         qDebug() << r.info().multi_file_name(timeStep).c_str();
 
     QDebug debugFormat = qDebug();
@@ -1251,69 +2635,83 @@ void Visualization::opengl_loadDataRawFromFile()
         break;
     }
 
-    size_t const totalCubeSize = m_datRawInfo.resolution()[0] * m_datRawInfo.resolution()[1] * m_datRawInfo.resolution()[2] * m_datRawInfo.time_steps();
-    m_volumeRenderTextureData.resize(totalCubeSize);
-    std::fill(m_volumeRenderTextureData.begin(), m_volumeRenderTextureData.end(), 0.0F);
-
-    /*
-    // For generating debugging data
-    for (size_t cubeIdx = 0U; cubeIdx < 8U; ++cubeIdx)
-    {
-        size_t offset;
-        switch (cubeIdx)
-        {
-            case 0U: offset = 0U; break;
-            case 1U: offset = 256U; break;
-            case 2U: offset = 512U * 512U * 256U; break;
-            case 3U: offset = 512U * 512U * 256U + 256U; break;
-            case 4U: offset = 512U * 256U; break;
-            case 5U: offset = 512U * 256U + 256U; break;
-            case 6U: offset = 512U * 512U * 256U + 512U * 256U; break;
-            case 7U: offset = 512U * 512U * 256U + 256U + 512U * 256U; break;
-        }
-        for (size_t zIdx = 0U; zIdx < 256U; ++zIdx)
-            for (size_t yIdx = 0U; yIdx < 256U; ++yIdx)
-                for (size_t xIdx = 0U; xIdx < 256U; ++xIdx)
-                    m_volumeRenderTextureData[offset + zIdx * 512U * 512U + yIdx * 512U + xIdx] = cubeIdx * (255U / 8U);
-    }
-    */
-
-    size_t cubeIdx = 0U;
-    std::vector<std::uint8_t> cubeSmall;
-    while (r)
+    GLenum textureDataType;
+    switch (m_datRawInfo.format())
     {
-        cubeSmall.resize(r.read_current(nullptr, 0));
-        r.read_current(cubeSmall.data(), cubeSmall.size());
-        r.move_next();
-
-        size_t offset;
-        switch (cubeIdx)
-        {
-            case 0U: offset = 0U; break;
-            case 1U: offset = 256U; break;
-            case 2U: offset = 512U * 512U * 256U; break;
-            case 3U: offset = 512U * 512U * 256U + 256U; break;
-            case 4U: offset = 512U * 256U; break;
-            case 5U: offset = 512U * 256U + 256U; break;
-            case 6U: offset = 512U * 512U * 256U + 512U * 256U; break;
-            case 7U: offset = 512U * 512U * 256U + 256U + 512U * 256U; break;
-        }
-
-        size_t cubeSmallIdx = 0U;
-        for (size_t zIdx = 0U; zIdx < 256U; ++zIdx)
-            for (size_t yIdx = 0U; yIdx < 256U; ++yIdx)
-                for (size_t xIdx = 0U; xIdx < 256U; ++xIdx)
-                    m_volumeRenderTextureData[offset + zIdx * 512U * 512U + yIdx * 512U + xIdx] = cubeSmall[cubeSmallIdx++];
-
-        ++cubeIdx;
+    case datraw::scalar_type::uint8:  textureDataType = GL_UNSIGNED_BYTE;  break;
+    case datraw::scalar_type::uint16: textureDataType = GL_UNSIGNED_SHORT; break;
 
-        qDebug() << "Loaded a time step";
+    default:
+        qWarning() << "3D texture data format not recognized";
+        m_volumeStreamer.setTimeSteps({}, {0U, 0U, 0U}, GL_UNSIGNED_BYTE, 1U, VolumeStreamer::Storage::Voxels);
+        m_marchingCubes.clear();
+        m_isosurfaceTimeStep = std::numeric_limits<size_t>::max();
+        m_isosurfaceTimeSteps.clear();
+        m_volumeOccupancies.clear();
+        return;
     }
+
+    std::array<size_t, 3U> const resolution{static_cast<size_t>(m_datRawInfo.resolution()[0]),
+                                            static_cast<size_t>(m_datRawInfo.resolution()[1]),
+                                            static_cast<size_t>(m_datRawInfo.resolution()[2])};
+
+    std::vector<datraw::memory_mapped_file> timeSteps = DataRawLoader::mapTimeSteps(
+        r, s_dataRawLoadThreadCount,
+        [this](std::uint64_t const completedTimeSteps, std::uint64_t const numberOfTimeSteps) {
+            emit dataRawLoadProgress(static_cast<int>(completedTimeSteps), static_cast<int>(numberOfTimeSteps));
+        });
+    m_marchingCubes.clear();
+    m_isosurfaceTimeStep = std::numeric_limits<size_t>::max();
+    m_volumeOccupancies = DataRawLoader::buildOccupancies(timeSteps, resolution, m_datRawInfo.scalar_size(),
+                                                          m_threadPool);
+    // The marching cubes read the voxels themselves, whether the streamer holds them or their compressed slices.
+    m_isosurfaceTimeSteps = DataRawLoader::mapTimeStepsLazily(r);
+
+    std::vector<datraw::memory_mapped_file> compressedTimeSteps;
+    bool const compress = m_volumeRenderingCompressDataRaw && m_volumeStreamer.canStoreBc4Slices(resolution);
+    // The occupancy ranges stay exact, only the rendered voxels lose precision.
+    for (std::uint64_t timeStep = 0U; compress && timeStep < timeSteps.size(); ++timeStep)
+        compressedTimeSteps.push_back(Bc4Volume::mapCompressed(m_datRawInfo.evaluate_path(m_datRawInfo.multi_file_name(timeStep)),
+                                                               timeSteps[timeStep],
+                                                               resolution,
+                                                               m_datRawInfo.scalar_size(),
+                                                               m_threadPool));
+
+    bool const isCompressed = compress && std::all_of(compressedTimeSteps.begin(), compressedTimeSteps.end(),
+                                                      [](datraw::memory_mapped_file const &timeStep) { return timeStep.data() != nullptr; });
+    if (compress && !isCompressed)
+        qWarning() << "Not all time steps could be compressed, the volume is stored uncompressed";
+    if (m_volumeRenderingCompressDataRaw && !compress)
+        qWarning() << "The volume does not fit in a 2D texture array, it is stored uncompressed";
+
+    if (isCompressed)
+        m_volumeStreamer.setTimeSteps(std::move(compressedTimeSteps), resolution, textureDataType, m_datRawInfo.scalar_size(),
+                                      VolumeStreamer::Storage::Bc4Slices);
+    else
+        m_volumeStreamer.setTimeSteps(std::move(timeSteps), resolution, textureDataType, m_datRawInfo.scalar_size(),
+                                      VolumeStreamer::Storage::Voxels);
 }
 
-// Assumes m_volumeRenderTextureData and m_datRawInfo have been initialized
+// Assumes opengl_loadDataRawFromFile has been called.
+// The texture holds one time step at a time. Playback advances it in opengl_drawVolumeRendering.
 void Visualization::opengl_updateTextureLoadDataRawFromFile()
 {
+    m_volumeRenderingIsCompressed = m_volumeStreamer.storage() == VolumeStreamer::Storage::Bc4Slices;
+    if (m_volumeRenderingIsCompressed)
+    {
+        // z is interpolated between the layers by the shaders, which also return 0 outside of the volume.
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_volumeRenderingCompressedTexture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+        m_volumeStreamer.attach(m_volumeRenderingCompressedTexture);
+        m_volumeRenderingBrickLayout = m_volumeStreamer.layout();
+        opengl_updateVolumeOccupancyTexture();
+        return;
+    }
+
     // Set texture parameters and upload 3D texture data
     glBindTexture(GL_TEXTURE_3D, m_volumeRenderingTextureLocation);
 
@@ -1328,53 +2726,126 @@ void Visualization::opengl_updateTextureLoadDataRawFromFile()
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-    GLenum textureDataType;
-    switch (m_datRawInfo.format())
-    {
-    case datraw::scalar_type::uint8:  textureDataType = GL_UNSIGNED_BYTE;  break;
-    case datraw::scalar_type::uint16: textureDataType = GL_UNSIGNED_SHORT; break;
+    m_volumeStreamer.attach(m_volumeRenderingTextureLocation);
+    m_volumeRenderingBrickLayout = m_volumeStreamer.layout();
+    opengl_updateVolumeOccupancyTexture();
+}
 
-    default:
-        qWarning() << "3D texture data format not recognized";
-        return;
+
+// Uploads the cells of the current volume that are visible under the transfer function. Without per-cell ranges
+// (the synthetic cube, or a .dat file that is still loading) the whole volume is one occupied cell.
+void Visualization::opengl_updateVolumeOccupancyTexture()
+{
+    std::vector<std::uint8_t> occupancy{255U};
+    std::array<size_t, 3U> cellCount{1U, 1U, 1U};
+    m_volumeOccupancyCellExtent = {1.0F, 1.0F, 1.0F};
+    m_volumeOccupancyTimeStep = m_volumeStreamer.currentTimeStep();
+    m_volumeRenderingProgressiveFrame = 0U; // The image has to be refined again.
+
+    if (m_volumeRenderTexture == VolumeRenderTexture::DataRaw && m_volumeOccupancyTimeStep < m_volumeOccupancies.size())
+    {
+        VolumeOccupancy const &volumeOccupancy = m_volumeOccupancies[m_volumeOccupancyTimeStep];
+        volumeOccupancy.occupancy(computeVisibleVolumeLevels(), occupancy);
+        cellCount = volumeOccupancy.cellCount();
+        m_volumeOccupancyCellExtent = volumeOccupancy.cellExtent();
     }
 
+    glBindTexture(GL_TEXTURE_3D, m_volumeOccupancyTexture);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage3D(GL_TEXTURE_3D,
                  0,
-                 GL_RED,
-                 512U,
-                 512U,
-                 512U,
-                 /*
-                 m_datRawInfo.resolution()[0],
-                 m_datRawInfo.resolution()[1],
-                 m_datRawInfo.resolution()[2],
-                 */
+                 GL_R8,
+                 static_cast<GLsizei>(cellCount[0]),
+                 static_cast<GLsizei>(cellCount[1]),
+                 static_cast<GLsizei>(cellCount[2]),
                  0,
                  GL_RED,
-                 textureDataType,
-                 m_volumeRenderTextureData.data());
+                 GL_UNSIGNED_BYTE,
+                 occupancy.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
+void Visualization::opengl_setVolumeBrickingUniforms(VolumeBrickingUniformLocations const &locations)
+{
+    QVector3D const brickCount = m_volumeRenderingBrickLayout.brickCount();
+    QVector3D const brickScale = m_volumeRenderingBrickLayout.brickScale();
+    QVector3D const atlasCellCount = m_volumeRenderingBrickLayout.atlasCellCount();
+    QVector3D const atlasCellExtent = m_volumeRenderingBrickLayout.atlasCellExtent();
+    QVector3D const atlasGhostOffset = m_volumeRenderingBrickLayout.atlasGhostOffset();
+    QVector3D const atlasCoreExtent = m_volumeRenderingBrickLayout.atlasCoreExtent();
+
+    glUniform3f(locations.brickCount, brickCount.x(), brickCount.y(), brickCount.z());
+    glUniform3f(locations.brickScale, brickScale.x(), brickScale.y(), brickScale.z());
+    glUniform3f(locations.atlasCellCount, atlasCellCount.x(), atlasCellCount.y(), atlasCellCount.z());
+    glUniform3f(locations.atlasCellExtent, atlasCellExtent.x(), atlasCellExtent.y(), atlasCellExtent.z());
+    glUniform3f(locations.atlasGhostOffset, atlasGhostOffset.x(), atlasGhostOffset.y(), atlasGhostOffset.z());
+    glUniform3f(locations.atlasCoreExtent, atlasCoreExtent.x(), atlasCoreExtent.y(), atlasCoreExtent.z());
+
+    glUniform1i(locations.isCompressed, m_volumeRenderingIsCompressed ? GL_TRUE : GL_FALSE);
+    glUniform1i(locations.compressedSampler, 2);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_volumeRenderingCompressedTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
 
-void Visualization::opengl_drawVolumeRendering()
+void Visualization::opengl_setVolumeSamplingUniforms(VolumeSamplingUniformLocations const &locations, float const rayOffset)
 {
+    glUniform1f(locations.stepScale, m_volumeRenderingStepScale);
+    glUniform1f(locations.maxAdaptiveStepScale, m_volumeRenderingMaxAdaptiveStepScale);
+    glUniform1f(locations.adaptiveStepThreshold, m_volumeRenderingAdaptiveStepThreshold);
+    glUniform1f(locations.terminationOpacity, m_volumeRenderingTerminationOpacity);
+    glUniform1f(locations.rayOffset, rayOffset);
+}
+
+// (Re)allocates a target of the progressive volume rendering if its size changed. Returns whether it did.
+bool Visualization::opengl_resizeVolumeRenderingTarget(size_t const target, GLsizei const width, GLsizei const height)
+{
+    std::array<GLsizei, 2U> const size{width, height};
+    if (m_volumeRenderingTargetSizes[target] == size)
+        return false;
+
+    glBindTexture(GL_TEXTURE_2D, m_volumeRenderingTargetTextures[target]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    // Half floats keep the running average of the progressive frames from banding.
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_volumeRenderingFramebuffers[target]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_volumeRenderingTargetTextures[target], 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        qDebug() << "Volume rendering framebuffer" << target << "is incomplete.";
+
+    m_volumeRenderingTargetSizes[target] = size;
+    return true;
+}
+
+// Casts the rays of the selected fragment shader into the current framebuffer and viewport.
+void Visualization::opengl_castVolumeRenderingRays(float const rayOffset)
+{
+    // The shaders only use the aspect ratio, which is that of the widget for every target.
     std::array<float, 2U> const iResolution{static_cast<float>(width()),
                                             static_cast<float>(height())};
 
-    // If the visualization is *not* paused, then we use the current amount of elapsed time.
-    // Otherwise, this step is skipped and we use the time stamp value that was last set.
-    if (!m_volumeRenderingTimeIsPaused)
-        m_volumeRenderingPauseTimestamp = static_cast<float>(m_elapsedTimer.elapsed()) / 1000.0F;
-
     switch (m_volumeRenderFragShader)
     {
     case VolumeRenderFragShader::VolumeRenderer:
         m_shaderProgramVolumeRendering.bind();
         glUniform2fv(m_uniformLocationVolumeRendering_iResolution, 1, iResolution.data());
         glUniform1f(m_uniformLocationVolumeRendering_iTime, m_volumeRenderingPauseTimestamp);
+        opengl_setVolumeSamplingUniforms(m_uniformLocationVolumeRendering_sampling, rayOffset);
 
         glUniform1i(m_uniformLocationVolumeRenderingTexture, 0);
+        opengl_setVolumeBrickingUniforms(m_uniformLocationVolumeRendering_bricking);
+
+        glUniform1i(m_uniformLocationVolumeRendering_occupancySampler, 1);
+        glUniform3fv(m_uniformLocationVolumeRendering_occupancyCellExtent, 1, m_volumeOccupancyCellExtent.data());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, m_volumeOccupancyTexture);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_3D, m_volumeRenderingTextureLocation);
         break;
@@ -1383,14 +2854,23 @@ void Visualization::opengl_drawVolumeRendering()
         m_shaderProgramVolumeRenderingLighting.bind();
         glUniform2fv(m_uniformLocationVolumeRendering_iResolutionLighting, 1, iResolution.data());
         glUniform1f(m_uniformLocationVolumeRendering_iTimeLighting, m_volumeRenderingPauseTimestamp);
+        opengl_setVolumeSamplingUniforms(m_uniformLocationVolumeRenderingLighting_sampling, rayOffset);
+
+        glUniform1i(m_uniformLocationVolumeRenderingLighting_usePrecomputedGradients, m_volumeRenderingUsePrecomputedGradients ? GL_TRUE : GL_FALSE);
+        glUniform1i(m_uniformLocationVolumeRenderingLighting_gradientSampler, 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, m_volumeRenderingLightingGradientTexture);
+        glActiveTexture(GL_TEXTURE0);
         break;
 
     case VolumeRenderFragShader::VolumeRendererPreIntegration:
         m_shaderProgramVolumeRenderingPreIntegration.bind();
         glUniform2fv(m_uniformLocationVolumeRenderingPreIntegration_iResolution, 1, iResolution.data());
         glUniform1f(m_uniformLocationVolumeRenderingPreIntegration_iTime, m_volumeRenderingPauseTimestamp);
+        opengl_setVolumeSamplingUniforms(m_uniformLocationVolumeRenderingPreIntegration_sampling, rayOffset);
 
         glUniform1i(m_uniformLocationVolumeRenderingPreIntegrationTexture, 0);
+        opengl_setVolumeBrickingUniforms(m_uniformLocationVolumeRenderingPreIntegration_bricking);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_3D, m_volumeRenderingTextureLocation);
 
@@ -1403,8 +2883,10 @@ void Visualization::opengl_drawVolumeRendering()
         m_shaderProgramVolumeRenderingOverlayRendering.bind();
         glUniform2fv(m_uniformLocationVolumeRenderingOverlayRendering_iResolution, 1, iResolution.data());
         glUniform1f(m_uniformLocationVolumeRenderingOverlayRendering_iTime, m_volumeRenderingPauseTimestamp);
+        opengl_setVolumeSamplingUniforms(m_uniformLocationVolumeRenderingOverlayRendering_sampling, rayOffset);
 
         glUniform1i(m_uniformLocationVolumeRenderingOverlayRenderingTexture, 0);
+        opengl_setVolumeBrickingUniforms(m_uniformLocationVolumeRenderingOverlayRendering_bricking);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_3D, m_volumeRenderingTextureLocation);
         break;
@@ -1414,6 +2896,155 @@ void Visualization::opengl_drawVolumeRendering()
     glDrawArrays(GL_TRIANGLES, 0, 3);
 }
 
+void Visualization::opengl_drawVolumeRendering()
+{
+    Profiler::CpuScope const scope{&m_profiler, "opengl_drawVolumeRendering"};
+
+    opengl_createVolumeRenderingShaderPrograms();
+
+    // If the visualization is *not* paused, then we use the current amount of elapsed time.
+    // Otherwise, this step is skipped and we use the time stamp value that was last set.
+    if (!m_volumeRenderingTimeIsPaused)
+        m_volumeRenderingPauseTimestamp = static_cast<float>(m_elapsedTimer.elapsed()) / 1000.0F;
+
+    // Time-varying data follow the same clock, so pausing also pauses playback.
+    if (m_volumeRenderTexture == VolumeRenderTexture::DataRaw)
+    {
+        float const timeStep = m_volumeRenderingPauseTimestamp * s_volumeRenderingTimeStepsPerSecond;
+        m_volumeStreamer.advanceTo(static_cast<size_t>(timeStep));
+        if (m_volumeStreamer.currentTimeStep() != m_volumeOccupancyTimeStep)
+            opengl_updateVolumeOccupancyTexture();
+    }
+
+    if (m_drawVolumeIsosurface && m_volumeRenderTexture == VolumeRenderTexture::DataRaw)
+    {
+        opengl_drawVolumeIsosurface();
+        return;
+    }
+
+    std::array<GLint, 4U> viewport{};
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+    VolumeRenderingImageState const imageState{m_volumeRenderingPauseTimestamp,
+                                               m_volumeRenderFragShader,
+                                               m_volumeRenderTexture,
+                                               m_volumeStreamer.currentTimeStep(),
+                                               m_volumeRenderingStepScale,
+                                               m_volumeRenderingMaxAdaptiveStepScale,
+                                               m_volumeRenderingAdaptiveStepThreshold,
+                                               m_volumeRenderingTerminationOpacity,
+                                               m_volumeRenderingUsePrecomputedGradients};
+    bool const isChanging = imageState != m_volumeRenderingImageState;
+    if (isChanging)
+    {
+        m_volumeRenderingImageState = imageState;
+        m_volumeRenderingProgressiveFrame = 0U;
+    }
+
+    // While the image changes, cast fewer rays and upscale them, sharpness matters less than the frame rate.
+    if (isChanging && m_volumeRenderingInteractiveDownsampling > 1)
+    {
+        GLsizei const downsampling = m_volumeRenderingInteractiveDownsampling;
+        GLsizei const reducedWidth = (viewport[2] + downsampling - 1) / downsampling;
+        GLsizei const reducedHeight = (viewport[3] + downsampling - 1) / downsampling;
+        opengl_resizeVolumeRenderingTarget(s_volumeRenderingReducedTarget, reducedWidth, reducedHeight);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_volumeRenderingFramebuffers[s_volumeRenderingReducedTarget]);
+        glViewport(0, 0, reducedWidth, reducedHeight);
+        opengl_castVolumeRenderingRays(0.0F);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        m_shaderProgramVolumeRenderingUpscale.bind();
+        glUniform1i(m_uniformLocationVolumeRenderingUpscale_image, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_volumeRenderingTargetTextures[s_volumeRenderingReducedTarget]);
+        glBindVertexArray(m_vaoVolumeRendering);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        return;
+    }
+
+    if (opengl_resizeVolumeRenderingTarget(s_volumeRenderingFullTarget, viewport[2], viewport[3]))
+        m_volumeRenderingProgressiveFrame = 0U;
+
+    // Every progressive frame starts its rays at another fraction of a step (the radical inverse of the frame number
+    // in base 2) and is blended into the running average of the previous ones. Once enough frames are averaged, the
+    // image is only shown.
+    if (m_volumeRenderingProgressiveFrame < s_volumeRenderingProgressiveFrames)
+    {
+        float rayOffset = 0.0F;
+        float digitWeight = 0.5F;
+        for (size_t frame = m_volumeRenderingProgressiveFrame; frame > 0U; frame /= 2U, digitWeight *= 0.5F)
+            rayOffset += static_cast<float>(frame % 2U) * digitWeight;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_volumeRenderingFramebuffers[s_volumeRenderingFullTarget]);
+        glViewport(0, 0, viewport[2], viewport[3]);
+        if (m_volumeRenderingProgressiveFrame > 0U)
+        {
+            glEnable(GL_BLEND);
+            glBlendColor(0.0F, 0.0F, 0.0F, 1.0F / static_cast<float>(m_volumeRenderingProgressiveFrame + 1U));
+            glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        }
+        opengl_castVolumeRenderingRays(rayOffset);
+        glDisable(GL_BLEND);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        ++m_volumeRenderingProgressiveFrame;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_volumeRenderingFramebuffers[s_volumeRenderingFullTarget]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, defaultFramebufferObject());
+    glBlitFramebuffer(0, 0, viewport[2], viewport[3],
+                      viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+}
+
+// Extracts the surface when the time step or the isovalue changed, and draws it from the camera of the volume rendering
+// shaders, which circles the volume with the same clock.
+void Visualization::opengl_drawVolumeIsosurface()
+{
+    size_t const timeStep = m_volumeStreamer.currentTimeStep();
+    if (timeStep >= m_isosurfaceTimeSteps.size() || timeStep >= m_volumeOccupancies.size())
+        return;
+
+    if (timeStep != m_isosurfaceTimeStep)
+    {
+        std::array<size_t, 3U> const resolution{static_cast<size_t>(m_datRawInfo.resolution()[0]),
+                                                static_cast<size_t>(m_datRawInfo.resolution()[1]),
+                                                static_cast<size_t>(m_datRawInfo.resolution()[2])};
+        datraw::memory_mapped_file const &voxels = m_isosurfaceTimeSteps[timeStep];
+        m_marchingCubes.setVolume(voxels.data(), voxels.size(), resolution, m_datRawInfo.scalar_size(),
+                                  m_volumeOccupancies[timeStep]);
+        m_isosurfaceTimeStep = timeStep;
+    }
+
+    bool isChanged = false;
+    {
+        Profiler::CpuScope const scope{&m_profiler, "MarchingCubes::extract"};
+        isChanged = m_marchingCubes.extract(m_volumeIsovalue, m_threadPool);
+    }
+    if (isChanged)
+    {
+        m_isosurfaceMesh.update(m_marchingCubes);
+
+        auto const mainWindowPtr = qobject_cast<MainWindow*>(parent()->parent());
+        mainWindowPtr->setIsosurfaceInfo(m_marchingCubes.numberOfTriangles(), m_marchingCubes.changedBricks().size(),
+                                         m_marchingCubes.bricks().size());
+    }
+
+    // See the camera parameters of volume_rendering.frag.
+    float const cameraAngle = 0.5F * m_volumeRenderingPauseTimestamp;
+    QVector3D const eye = 1.5F * QVector3D{std::cos(cameraAngle), 0.5F, std::sin(cameraAngle)};
+    QMatrix4x4 viewProjection;
+    viewProjection.perspective(58.0F, static_cast<float>(width()) / static_cast<float>(height()), 0.1F, 10.0F);
+    viewProjection.lookAt(eye, QVector3D{0.0F, 0.0F, 0.0F}, QVector3D{0.0F, 1.0F, 0.0F});
+
+    glClear(GL_DEPTH_BUFFER_BIT);
+    m_isosurfaceMesh.draw(viewProjection, eye, QVector3D{0.9F, 0.75F, 0.5F});
+}
+
 void Visualization::opengl_rotateView()
 {
     m_viewTransformationMatrix.setToIdentity();
@@ -1425,4 +3056,5 @@ void Visualization::opengl_rotateView()
     m_viewTransformationMatrix.rotate(m_rotation.z(), 0.0F, 0.0F, 1.0F);
 
     m_normalTransformationMatrix = m_viewTransformationMatrix.normalMatrix();
+    requestRender();
 }
@@ -0,0 +1,122 @@
+#include "volumeoccupancy.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // The levels of a voxel as [floor, ceil], so that 16-bit ranges stay conservative.
+    struct LevelRange
+    {
+        std::uint8_t min;
+        std::uint8_t max;
+    };
+
+    LevelRange voxelLevels(void const * const data, size_t const dataSize, size_t const voxelIdx, size_t const scalarSize)
+    {
+        if ((voxelIdx + 1U) * scalarSize > dataSize)
+            return {0U, 0U};
+
+        if (scalarSize == 1U)
+        {
+            std::uint8_t const value = static_cast<std::uint8_t const*>(data)[voxelIdx];
+            return {value, value};
+        }
+
+        // The data offset of a raw file need not keep 16-bit values aligned.
+        std::uint16_t value;
+        std::memcpy(&value, static_cast<std::uint8_t const*>(data) + voxelIdx * scalarSize, sizeof(value));
+        return {static_cast<std::uint8_t>(value >> 8U),
+                static_cast<std::uint8_t>(std::min((static_cast<unsigned int>(value) + 255U) >> 8U, 255U))};
+    }
+}
+
+void VolumeOccupancy::build(void const * const data,
+                            size_t const dataSize,
+                            std::array<size_t, 3U> const &resolution,
+                            size_t const scalarSize,
+                            ThreadPool &threadPool)
+{
+    m_resolution = resolution;
+    for (size_t axis = 0U; axis < 3U; ++axis)
+        m_cellCount[axis] = (resolution[axis] + s_cellSize - 1U) / s_cellSize;
+
+    size_t const numberOfCells = m_cellCount[0] * m_cellCount[1] * m_cellCount[2];
+    m_minima.assign(numberOfCells, 0U);
+    m_maxima.assign(numberOfCells, 0U);
+
+    // Every layer of cells is independent of the others.
+    threadPool.parallelFor(0U, m_cellCount[2], [&](size_t const begin, size_t const end, size_t const) {
+        for (size_t cellZ = begin; cellZ < end; ++cellZ)
+            for (size_t cellY = 0U; cellY < m_cellCount[1]; ++cellY)
+                for (size_t cellX = 0U; cellX < m_cellCount[0]; ++cellX)
+                {
+                    std::array<size_t, 3U> const cell{cellX, cellY, cellZ};
+                    std::array<size_t, 3U> first{};
+                    std::array<size_t, 3U> last{};
+                    bool touchesBorder = false;
+                    for (size_t axis = 0U; axis < 3U; ++axis)
+                    {
+                        // One voxel around the cell, for linear filtering.
+                        size_t const cellBegin = cell[axis] * s_cellSize;
+                        size_t const cellEnd = std::min(cellBegin + s_cellSize, resolution[axis]);
+                        first[axis] = cellBegin > 0U ? cellBegin - 1U : 0U;
+                        last[axis] = std::min(cellEnd, resolution[axis] - 1U);
+                        touchesBorder = touchesBorder || cellBegin == 0U || cellEnd == resolution[axis];
+                    }
+
+                    std::uint8_t minLevel = touchesBorder ? 0U : 255U;
+                    std::uint8_t maxLevel = 0U;
+                    for (size_t z = first[2]; z <= last[2]; ++z)
+                        for (size_t y = first[1]; y <= last[1]; ++y)
+                            for (size_t x = first[0]; x <= last[0]; ++x)
+                            {
+                                size_t const voxelIdx = (z * resolution[1] + y) * resolution[0] + x;
+                                LevelRange const levels = voxelLevels(data, dataSize, voxelIdx, scalarSize);
+                                minLevel = std::min(minLevel, levels.min);
+                                maxLevel = std::max(maxLevel, levels.max);
+                            }
+
+                    size_t const cellIdx = (cellZ * m_cellCount[1] + cellY) * m_cellCount[0] + cellX;
+                    m_minima[cellIdx] = minLevel;
+                    m_maxima[cellIdx] = maxLevel;
+                }
+    });
+}
+
+void VolumeOccupancy::occupancy(std::array<bool, s_numberOfLevels> const &isVisible,
+                                std::vector<std::uint8_t> &result) const
+{
+    // visibleBelow[n] is the number of visible levels below level n, so a range test is one subtraction.
+    std::array<unsigned int, s_numberOfLevels + 1U> visibleBelow{};
+    for (size_t level = 0U; level < s_numberOfLevels; ++level)
+        visibleBelow[level + 1U] = visibleBelow[level] + (isVisible[level] ? 1U : 0U);
+
+    result.resize(m_minima.size());
+    for (size_t cellIdx = 0U; cellIdx < m_minima.size(); ++cellIdx)
+    {
+        bool const isOccupied = visibleBelow[m_maxima[cellIdx] + 1U] > visibleBelow[m_minima[cellIdx]];
+        result[cellIdx] = isOccupied ? 255U : 0U;
+    }
+}
+
+bool VolumeOccupancy::mayContain(size_t const cellIdx, float const level) const
+{
+    return static_cast<float>(m_minima[cellIdx]) <= level && level <= static_cast<float>(m_maxima[cellIdx]);
+}
+
+// Getters
+std::array<size_t, 3U> const &VolumeOccupancy::cellCount() const
+{
+    return m_cellCount;
+}
+
+std::array<float, 3U> VolumeOccupancy::cellExtent() const
+{
+    std::array<float, 3U> extent{1.0F, 1.0F, 1.0F};
+    for (size_t axis = 0U; axis < 3U; ++axis)
+        if (m_resolution[axis] > 0U)
+            extent[axis] = static_cast<float>(s_cellSize) / static_cast<float>(m_resolution[axis]);
+
+    return extent;
+}
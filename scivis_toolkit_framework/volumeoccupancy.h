@@ -0,0 +1,48 @@
+#ifndef VOLUMEOCCUPANCY_H
+#define VOLUMEOCCUPANCY_H
+
+#include "threadpool.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The value range of every cell of s_cellSize^3 voxels of a volume, for empty-space skipping.
+// The range of a cell includes the neighbouring voxels that linear filtering reads, and 0 for cells at the border of
+// the volume (the texture border is empty), so every sample taken inside a cell lies within its range.
+// Values are quantized to the 256 levels of the transfer function. The ranges do not depend on the transfer function;
+// occupancy() turns them into the cells that are visible under a given one.
+class VolumeOccupancy
+{
+public:
+    static constexpr size_t s_cellSize = 16U;
+    static constexpr size_t s_numberOfLevels = 256U;
+
+private:
+    std::array<size_t, 3U> m_resolution{};
+    std::array<size_t, 3U> m_cellCount{};
+    std::vector<std::uint8_t> m_minima;
+    std::vector<std::uint8_t> m_maxima;
+
+public:
+    // data holds dataSize bytes of resolution voxels of scalarSize (1 or 2) bytes each, x fastest.
+    // Missing voxels of a truncated volume count as 0.
+    void build(void const * const data,
+               size_t const dataSize,
+               std::array<size_t, 3U> const &resolution,
+               size_t const scalarSize,
+               ThreadPool &threadPool);
+
+    // Marks every cell that holds a level for which isVisible is true with 255, all others with 0.
+    void occupancy(std::array<bool, s_numberOfLevels> const &isVisible, std::vector<std::uint8_t> &result) const;
+
+    // Whether a value of the (fractional) level may lie in cell cellIdx, numbered x fastest, or between its voxels.
+    [[nodiscard]] bool mayContain(size_t const cellIdx, float const level) const;
+
+    // Getters
+    [[nodiscard]] std::array<size_t, 3U> const &cellCount() const;
+    [[nodiscard]] std::array<float, 3U> cellExtent() const; // Size of a cell in normalized volume coordinates.
+};
+
+#endif // VOLUMEOCCUPANCY_H
@@ -0,0 +1,434 @@
+#include "volumestreamer.h"
+
+#include "bc4volume.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+VolumeStreamer::~VolumeStreamer()
+{
+    stopWorker();
+}
+
+void VolumeStreamer::create(QOpenGLFunctions_3_3_Core * const gl)
+{
+    m_gl = gl;
+    for (Slot &slot : m_slots)
+        m_gl->glGenBuffers(1, &slot.pbo);
+
+    GLint maxTextureSize = 0;
+    m_gl->glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+    m_maxTextureSize = static_cast<size_t>(maxTextureSize);
+
+    m_gl->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    m_maxArrayTextureSize = static_cast<size_t>(maxTextureSize);
+    m_gl->glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxTextureSize);
+    m_maxArrayTextureLayers = static_cast<size_t>(maxTextureSize);
+}
+
+void VolumeStreamer::destroy()
+{
+    if (m_gl == nullptr)
+        return;
+
+    stopWorker();
+    releaseSlots();
+    for (Slot &slot : m_slots)
+    {
+        m_gl->glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0U;
+    }
+    m_texture = 0U;
+}
+
+void VolumeStreamer::setTimeSteps(std::vector<datraw::memory_mapped_file> &&timeSteps,
+                                  std::array<size_t, 3U> const &resolution,
+                                  GLenum const dataType,
+                                  size_t const scalarSize,
+                                  Storage const storage)
+{
+    stopWorker();
+    releaseSlots();
+
+    m_timeSteps = std::move(timeSteps);
+    m_resolution = resolution;
+    m_storage = storage;
+    m_dataType = dataType;
+    m_scalarSize = scalarSize;
+    m_currentTimeStep = s_noTimeStep;
+    if (m_storage == Storage::Bc4Slices)
+    {
+        // The slices are never bricked, a single brick keeps the bricking uniforms an identity.
+        m_layout = BrickLayout{resolution, std::max({resolution[0], resolution[1], resolution[2]})};
+        m_timeStepSize = Bc4Volume::volumeSize(resolution);
+    }
+    else
+    {
+        m_layout = BrickLayout{resolution, m_maxTextureSize};
+        m_timeStepSize = resolution[0] * resolution[1] * resolution[2] * scalarSize;
+    }
+
+    if (m_timeSteps.empty())
+        return;
+
+    if (m_storage == Storage::Bc4Slices && !canStoreBc4Slices(resolution))
+    {
+        qWarning() << "A volume of" << resolution[0] << "x" << resolution[1] << "x" << resolution[2]
+                   << "voxels does not fit in a 2D texture array";
+        m_timeSteps.clear();
+        return;
+    }
+
+    if (!m_layout.isValid())
+    {
+        qWarning() << "A volume of" << resolution[0] << "x" << resolution[1] << "x" << resolution[2]
+                   << "voxels does not fit in a 3D texture of at most" << m_maxTextureSize << "voxels per axis";
+        m_timeSteps.clear();
+        return;
+    }
+
+    if (m_layout.isBricked())
+        qDebug() << "Volume split into" << m_layout.numberOfBricks() << "bricks, atlas of" << m_layout.atlasSize()[0]
+                 << "x" << m_layout.atlasSize()[1] << "x" << m_layout.atlasSize()[2] << "voxels";
+
+    for (size_t timeStep = 0U; timeStep < m_timeSteps.size(); ++timeStep)
+        if (m_timeSteps[timeStep].size() < m_timeStepSize)
+            qWarning() << "Time step" << timeStep << "holds" << m_timeSteps[timeStep].size() << "bytes instead of"
+                       << m_timeStepSize << ", the remainder is left empty";
+}
+
+void VolumeStreamer::attach(GLuint const texture)
+{
+    stopWorker();
+    releaseSlots();
+
+    m_texture = texture;
+    if (m_texture == 0U || m_timeSteps.empty())
+        return;
+
+    if (m_storage == Storage::Bc4Slices)
+    {
+        m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+        m_gl->glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+        m_gl->glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY,
+                                     0,
+                                     GL_COMPRESSED_RED_RGTC1,
+                                     static_cast<GLsizei>(m_resolution[0]),
+                                     static_cast<GLsizei>(m_resolution[1]),
+                                     static_cast<GLsizei>(m_resolution[2]),
+                                     0,
+                                     static_cast<GLsizei>(m_timeStepSize),
+                                     nullptr);
+    }
+    else
+    {
+        // Sized formats, so 16-bit data keep their precision.
+        std::array<size_t, 3U> const &atlasSize = m_layout.atlasSize();
+        GLint const internalFormat = m_dataType == GL_UNSIGNED_SHORT ? GL_R16 : GL_R8;
+
+        // The ghost voxels outside of the volume are never uploaded, so a bricked atlas starts out empty.
+        std::vector<std::uint8_t> emptyAtlas;
+        if (m_layout.isBricked())
+            emptyAtlas.resize(atlasSize[0] * atlasSize[1] * atlasSize[2] * m_scalarSize, 0U);
+
+        m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+        m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        m_gl->glBindTexture(GL_TEXTURE_3D, m_texture);
+        m_gl->glTexImage3D(GL_TEXTURE_3D,
+                           0,
+                           internalFormat,
+                           static_cast<GLsizei>(atlasSize[0]),
+                           static_cast<GLsizei>(atlasSize[1]),
+                           static_cast<GLsizei>(atlasSize[2]),
+                           0,
+                           GL_RED,
+                           m_dataType,
+                           emptyAtlas.empty() ? nullptr : emptyAtlas.data());
+        m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    // Orphans the previous storage, if any.
+    for (Slot const &slot : m_slots)
+    {
+        m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        m_gl->glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(m_timeStepSize), nullptr, GL_STREAM_DRAW);
+    }
+
+    // The first upload cannot be hidden behind playback, so it goes directly from the mapped file.
+    if (m_currentTimeStep == s_noTimeStep)
+        m_currentTimeStep = 0U;
+
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+    if (m_timeSteps[m_currentTimeStep].size() >= m_timeStepSize)
+        uploadTimeStep(m_timeSteps[m_currentTimeStep].data());
+    else
+    {
+        std::vector<std::uint8_t> timeStepData(m_timeStepSize);
+        copyTimeStep(m_currentTimeStep, timeStepData.data());
+        uploadTimeStep(timeStepData.data());
+    }
+
+    startWorker();
+    prefetch(m_currentTimeStep + 1U);
+}
+
+bool VolumeStreamer::canStoreBc4Slices(std::array<size_t, 3U> const &resolution) const
+{
+    return resolution[0] > 0U && resolution[1] > 0U && resolution[2] > 0U &&
+           resolution[0] <= m_maxArrayTextureSize && resolution[1] <= m_maxArrayTextureSize &&
+           resolution[2] <= m_maxArrayTextureLayers;
+}
+
+bool VolumeStreamer::advanceTo(size_t const timeStep)
+{
+    if (m_texture == 0U || m_timeSteps.empty())
+        return false;
+
+    size_t const wrappedTimeStep = timeStep % m_timeSteps.size();
+    if (wrappedTimeStep == m_currentTimeStep)
+    {
+        prefetch(m_currentTimeStep + 1U);
+        return true;
+    }
+
+    auto const slot = std::find_if(m_slots.begin(), m_slots.end(), [wrappedTimeStep](Slot const &candidate) {
+        return candidate.state.load(std::memory_order_acquire) == SlotState::Ready && candidate.timeStep == wrappedTimeStep;
+    });
+
+    if (slot == m_slots.end())
+    {
+        // Not there yet (or skipped to): make sure it is on its way and keep showing the current time step.
+        prefetch(wrappedTimeStep);
+        return false;
+    }
+
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+    bool const isIntact = m_gl->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    slot->mapped = nullptr;
+    slot->state.store(SlotState::Free, std::memory_order_relaxed);
+
+    if (isIntact)
+    {
+        // With a PBO bound, the data pointer is an offset into the buffer.
+        uploadTimeStep(nullptr);
+        m_currentTimeStep = wrappedTimeStep;
+    }
+    else
+        qDebug() << "VolumeStreamer: buffer contents were lost while mapped";
+
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+
+    prefetch(wrappedTimeStep + (isIntact ? 1U : 0U));
+    return isIntact;
+}
+
+void VolumeStreamer::run()
+{
+    while (true)
+    {
+        size_t slotIdx;
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_condition.wait(lock, [this] { return m_stopRequested || !m_requests.empty(); });
+            if (m_stopRequested)
+                return;
+
+            slotIdx = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        Slot &slot = m_slots[slotIdx];
+        copyTimeStep(slot.timeStep, slot.mapped);
+        slot.state.store(SlotState::Ready, std::memory_order_release);
+    }
+}
+
+void VolumeStreamer::startWorker()
+{
+    if (m_thread.joinable())
+        return;
+
+    m_stopRequested = false;
+    m_thread = std::thread{&VolumeStreamer::run, this};
+}
+
+void VolumeStreamer::stopWorker()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stopRequested = true;
+        m_requests.clear();
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+// Reading the mapped file is what loads its pages, which is why this runs on the worker thread.
+void VolumeStreamer::copyTimeStep(size_t const timeStep, void * const destination) const
+{
+    datraw::memory_mapped_file const &file = m_timeSteps[timeStep];
+    size_t const size = std::min(file.size(), m_timeStepSize);
+    std::memcpy(destination, file.data(), size);
+    std::memset(static_cast<std::uint8_t*>(destination) + size, 0, m_timeStepSize - size);
+}
+
+// Uploads the whole volume from data, which is an offset if a PBO is bound to GL_PIXEL_UNPACK_BUFFER.
+// Every brick is picked out of the volume by the unpack parameters, so the data never have to be rearranged.
+void VolumeStreamer::uploadTimeStep(void const * const data)
+{
+    if (m_storage == Storage::Bc4Slices)
+    {
+        m_gl->glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+        m_gl->glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                        0,
+                                        0,
+                                        0,
+                                        0,
+                                        static_cast<GLsizei>(m_resolution[0]),
+                                        static_cast<GLsizei>(m_resolution[1]),
+                                        static_cast<GLsizei>(m_resolution[2]),
+                                        GL_COMPRESSED_RED_RGTC1,
+                                        static_cast<GLsizei>(m_timeStepSize),
+                                        data);
+        return;
+    }
+
+    // The rows are tightly packed, whatever the scalar size.
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(m_resolution[0]));
+    m_gl->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, static_cast<GLint>(m_resolution[1]));
+    m_gl->glBindTexture(GL_TEXTURE_3D, m_texture);
+
+    for (size_t brickIdx = 0U; brickIdx < m_layout.numberOfBricks(); ++brickIdx)
+    {
+        BrickLayout::Brick const brick = m_layout.brick(brickIdx);
+        m_gl->glPixelStorei(GL_UNPACK_SKIP_PIXELS, static_cast<GLint>(brick.sourceOffset[0]));
+        m_gl->glPixelStorei(GL_UNPACK_SKIP_ROWS, static_cast<GLint>(brick.sourceOffset[1]));
+        m_gl->glPixelStorei(GL_UNPACK_SKIP_IMAGES, static_cast<GLint>(brick.sourceOffset[2]));
+        m_gl->glTexSubImage3D(GL_TEXTURE_3D,
+                              0,
+                              static_cast<GLint>(brick.atlasOffset[0]),
+                              static_cast<GLint>(brick.atlasOffset[1]),
+                              static_cast<GLint>(brick.atlasOffset[2]),
+                              static_cast<GLsizei>(brick.size[0]),
+                              static_cast<GLsizei>(brick.size[1]),
+                              static_cast<GLsizei>(brick.size[2]),
+                              GL_RED,
+                              m_dataType,
+                              data);
+    }
+
+    m_gl->glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    m_gl->glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    m_gl->glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+    m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    m_gl->glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// Hands the time steps [firstTimeStep, firstTimeStep + s_numberOfSlots) that are not prefetched yet to the worker.
+// Slots holding a time step outside of that window are reused; slots that are being filled are left alone.
+void VolumeStreamer::prefetch(size_t const firstTimeStep)
+{
+    size_t const numberOfTimeSteps = m_timeSteps.size();
+    for (size_t offset = 0U; offset < s_numberOfSlots; ++offset)
+    {
+        size_t const timeStep = (firstTimeStep + offset) % numberOfTimeSteps;
+        if (timeStep == m_currentTimeStep)
+            continue;
+
+        bool const isPrefetched = std::any_of(m_slots.begin(), m_slots.end(), [timeStep](Slot const &candidate) {
+            return candidate.state.load(std::memory_order_acquire) != SlotState::Free && candidate.timeStep == timeStep;
+        });
+        if (isPrefetched)
+            continue;
+
+        auto slot = std::find_if(m_slots.begin(), m_slots.end(), [](Slot const &candidate) {
+            return candidate.state.load(std::memory_order_acquire) == SlotState::Free;
+        });
+        if (slot == m_slots.end())
+            slot = std::find_if(m_slots.begin(), m_slots.end(), [this, firstTimeStep](Slot const &candidate) {
+                return candidate.state.load(std::memory_order_acquire) == SlotState::Ready &&
+                       !isInWindow(candidate.timeStep, firstTimeStep);
+            });
+        if (slot == m_slots.end())
+            break;
+
+        if (slot->mapped == nullptr)
+        {
+            m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+            slot->mapped = m_gl->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                                  0,
+                                                  static_cast<GLsizeiptr>(m_timeStepSize),
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+            if (slot->mapped == nullptr)
+            {
+                qDebug() << "VolumeStreamer: mapping a pixel buffer failed";
+                break;
+            }
+        }
+
+        slot->timeStep = timeStep;
+        slot->state.store(SlotState::Filling, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_requests.push_back(static_cast<size_t>(slot - m_slots.begin()));
+        }
+        m_condition.notify_one();
+    }
+}
+
+bool VolumeStreamer::isInWindow(size_t const timeStep, size_t const firstTimeStep) const
+{
+    for (size_t offset = 0U; offset < s_numberOfSlots; ++offset)
+        if ((firstTimeStep + offset) % m_timeSteps.size() == timeStep)
+            return true;
+
+    return false;
+}
+
+// Unmaps all PBOs. Only valid while the worker thread is stopped.
+void VolumeStreamer::releaseSlots()
+{
+    for (Slot &slot : m_slots)
+    {
+        if (slot.mapped != nullptr)
+        {
+            m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            m_gl->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot.mapped = nullptr;
+        }
+        slot.state.store(SlotState::Free, std::memory_order_relaxed);
+    }
+
+    if (m_gl != nullptr)
+        m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0U);
+}
+
+// Getters
+size_t VolumeStreamer::numberOfTimeSteps() const
+{
+    return m_timeSteps.size();
+}
+
+size_t VolumeStreamer::currentTimeStep() const
+{
+    return m_currentTimeStep;
+}
+
+BrickLayout const &VolumeStreamer::layout() const
+{
+    return m_layout;
+}
+
+VolumeStreamer::Storage VolumeStreamer::storage() const
+{
+    return m_storage;
+}
@@ -0,0 +1,125 @@
+#ifndef VOLUMESTREAMER_H
+#define VOLUMESTREAMER_H
+
+#include "bricklayout.h"
+#include "datraw.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Plays a time series of volumes through a single 3D texture that holds the current time step.
+// The next s_numberOfSlots time steps are prefetched into pixel buffer objects: the GUI thread maps a free PBO and a
+// worker thread copies the memory-mapped raw file into it, which is where the pages are actually read from disk.
+// When playback reaches a prefetched time step, its PBO is unmapped and uploaded with glTexSubImage3D, so the GUI
+// thread never waits for the disk. If a time step is not ready yet, the texture keeps showing the previous one.
+// Volumes larger than GL_MAX_3D_TEXTURE_SIZE along an axis are bricked into an atlas, see BrickLayout.
+// Time steps compressed by Bc4Volume are played through a GL_TEXTURE_2D_ARRAY of BC4 slices instead.
+//
+// Except for the worker thread itself, every function has to be called from the GUI thread with the context current.
+class VolumeStreamer
+{
+public:
+    enum class Storage
+    {
+        Voxels,     // Uncompressed voxels in a 3D texture, bricked if necessary.
+        Bc4Slices   // One BC4 image per z slice in a 2D texture array, see Bc4Volume.
+    };
+
+private:
+    static constexpr size_t s_numberOfSlots = 2U;
+
+    enum class SlotState
+    {
+        Free,       // The PBO is not mapped.
+        Filling,    // The PBO is mapped and owned by the worker thread.
+        Ready       // The PBO is mapped and holds timeStep.
+    };
+
+    struct Slot
+    {
+        GLuint pbo = 0U;
+        void *mapped = nullptr;
+        size_t timeStep = 0U;
+        std::atomic<SlotState> state{SlotState::Free};
+    };
+
+    static constexpr size_t s_noTimeStep = static_cast<size_t>(-1);
+
+    QOpenGLFunctions_3_3_Core *m_gl = nullptr;
+    GLuint m_texture = 0U;
+
+    std::vector<datraw::memory_mapped_file> m_timeSteps; // Read by the worker thread while it is running.
+    std::array<size_t, 3U> m_resolution{};
+    BrickLayout m_layout;
+    size_t m_maxTextureSize = 0U;
+    size_t m_maxArrayTextureSize = 0U;
+    size_t m_maxArrayTextureLayers = 0U;
+    Storage m_storage = Storage::Voxels;
+    GLenum m_dataType = GL_UNSIGNED_BYTE;
+    size_t m_scalarSize = 1U;
+    size_t m_timeStepSize = 0U; // In bytes.
+    size_t m_currentTimeStep = s_noTimeStep;
+
+    std::array<Slot, s_numberOfSlots> m_slots;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<size_t> m_requests; // Slots to be filled, guarded by m_mutex.
+    bool m_stopRequested = false;  // Guarded by m_mutex.
+
+    void run();
+    void startWorker();
+    void stopWorker();
+
+    void copyTimeStep(size_t const timeStep, void * const destination) const;
+    void uploadTimeStep(void const * const data);
+    void prefetch(size_t const firstTimeStep);
+    [[nodiscard]] bool isInWindow(size_t const timeStep, size_t const firstTimeStep) const;
+    void releaseSlots();
+
+public:
+    VolumeStreamer() = default;
+    VolumeStreamer(VolumeStreamer const&) = delete;
+    VolumeStreamer& operator=(VolumeStreamer const&) = delete;
+    ~VolumeStreamer();
+
+    void create(QOpenGLFunctions_3_3_Core * const gl);
+    void destroy();
+
+    // Takes over the mapped raw files. Every file holds one time step of resolution voxels of scalarSize bytes,
+    // stored as GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT (dataType), or compressed to Bc4Slices. Drops them if they
+    // cannot be packed.
+    void setTimeSteps(std::vector<datraw::memory_mapped_file> &&timeSteps,
+                      std::array<size_t, 3U> const &resolution,
+                      GLenum const dataType,
+                      size_t const scalarSize,
+                      Storage const storage);
+
+    // Whether a volume of resolution fits in a 2D texture array, as Bc4Slices require.
+    [[nodiscard]] bool canStoreBc4Slices(std::array<size_t, 3U> const &resolution) const;
+
+    // (Re)allocates the storage of texture, uploads the current time step into it and starts prefetching. The texture
+    // is a GL_TEXTURE_3D for Voxels and a GL_TEXTURE_2D_ARRAY for Bc4Slices.
+    void attach(GLuint const texture);
+
+    // Shows timeStep (modulo the number of time steps) if it has been prefetched, and prefetches the time steps after
+    // it. Returns whether the texture holds timeStep.
+    bool advanceTo(size_t const timeStep);
+
+    // Getters
+    [[nodiscard]] size_t numberOfTimeSteps() const;
+    [[nodiscard]] size_t currentTimeStep() const;
+    [[nodiscard]] BrickLayout const &layout() const;
+    [[nodiscard]] Storage storage() const;
+};
+
+#endif // VOLUMESTREAMER_H